@@ -115,6 +115,24 @@ class Config : private boost::noncopyable {
    */
   bool hashSource(const std::string& source, const std::string& content);
 
+  /**
+   * @brief Hash a single pack's content within a source.
+   *
+   * Unchanged packs are kept (with their statistics) when a source updates,
+   * so a refresh only pays for the packs whose content actually changed.
+   *
+   * @param source is the place where the config content came from
+   * @param name is the pack name within the source
+   * @param content is the pack's serialized JSON content
+   * @return false if the pack content did not change, otherwise true
+   */
+  bool hashPack(const std::string& source,
+                const std::string& name,
+                const std::string& content);
+
+  /// Check if a pack is currently scheduled from a source.
+  bool packExists(const std::string& name, const std::string& source) const;
+
   /// Whether or not the last loaded config was valid.
   bool isValid() const {
     return valid_;
@@ -138,6 +156,15 @@ class Config : private boost::noncopyable {
    */
   void removePack(const std::string& pack);
 
+  /**
+   * @brief Expire every pack's cached discovery decision.
+   *
+   * Event subscribers or extensions reacting to system changes (for example
+   * a process starting) may call this to force the discovery queries to
+   * re-run before the discovery TTL expires.
+   */
+  void invalidatePackDiscovery();
+
   /**
    * @brief Iterate through all packs
    */
@@ -255,6 +282,14 @@ class Config : private boost::noncopyable {
    */
   Status load();
 
+  /**
+   * @brief Load the cached last-known-good configuration from the database.
+   *
+   * Each successfully parsed source is cached by Config::update; restoring
+   * the cache lets the scheduler start before the config plugin responds.
+   */
+  Status restoreCachedConfig();
+
   /// A step method for Config::update.
   Status updateSource(const std::string& source, const std::string& json);
 
@@ -326,6 +361,9 @@ class Config : private boost::noncopyable {
   /// A set of hashes for each source of the config.
   std::map<std::string, std::string> hash_;
 
+  /// A set of hashes for each pack, keyed by source and pack name.
+  std::map<std::string, std::string> pack_hash_;
+
   /// Check if the config received valid/parsable content from a config plugin.
   bool valid_{false};
 
@@ -11,7 +11,9 @@
 #pragma once
 
 #include <atomic>
+#include <functional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <osquery/plugin.h>
@@ -50,6 +52,9 @@ extern const std::string kEvents;
 /// The "domain" where the results of carve queries are stored.
 extern const std::string kCarves;
 
+/// The "domain" where scheduled query performance counters are checkpointed.
+extern const std::string kPerformance;
+
 /// The running version of our database schema
 extern const std::string kDatabaseResultsVersion;
 
@@ -62,6 +67,10 @@ extern const std::string kDatabaseResultsVersion;
  */
 extern const std::string kLogs;
 
+/// An ordered list of key/value pairs to be written as one atomic batch.
+using DatabaseStringValueList =
+    std::vector<std::pair<std::string, std::string>>;
+
 /**
  * @brief An osquery backing storage (database) type that persists executions.
  *
@@ -117,6 +126,20 @@ class DatabasePlugin : public Plugin {
                      const std::string& key,
                      int value) = 0;
 
+  /**
+   * @brief Store several key/value pairs as one atomic write.
+   *
+   * The default implementation issues one put per pair; plugins backed by
+   * stores with native batching (RocksDB WriteBatch, SQLite transactions)
+   * should override this so a batch commits with a single WAL sync.
+   *
+   * @param domain A string value representing abstract storage indexing.
+   * @param data The list of key/value pairs to store together.
+   * @return Failure if any pair could not be stored.
+   */
+  virtual Status putBatch(const std::string& domain,
+                          const DatabaseStringValueList& data);
+
   virtual void dumpDatabase() const = 0;
 
   /// Data removal method.
@@ -132,6 +155,43 @@ class DatabasePlugin : public Plugin {
                       const std::string& prefix,
                       size_t max) const;
 
+  /**
+   * @brief Scan keys and their values from a domain in one range read.
+   *
+   * The default implementation scans the keys then issues one get per key;
+   * plugins backed by ordered stores (RocksDB iterators, SQLite range
+   * SELECTs) should override this so values are read in the same pass as
+   * the keys, avoiding per-key read amplification.
+   *
+   * @param domain A string value representing abstract storage indexing.
+   * @param results The output list of matching key/value pairs.
+   * @param prefix A key prefix to limit the scan.
+   * @param max An optional max number of pairs, 0 scans all.
+   */
+  virtual Status scanValues(const std::string& domain,
+                            DatabaseStringValueList& results,
+                            const std::string& prefix,
+                            size_t max) const;
+
+  /**
+   * @brief Scan a bounded chunk of keys, resuming after a cursor key.
+   *
+   * The default implementation performs a full key scan and windows the
+   * results; plugins backed by ordered stores should override this to seek
+   * directly to the cursor so each chunk costs one bounded range read.
+   *
+   * @param domain A string value representing abstract storage indexing.
+   * @param results The output list of at most max matching keys.
+   * @param prefix A key prefix to limit the scan.
+   * @param start Resume after this key, empty to start at the prefix.
+   * @param max The chunk size, must be non-zero.
+   */
+  virtual Status scanChunk(const std::string& domain,
+                           std::vector<std::string>& results,
+                           const std::string& prefix,
+                           const std::string& start,
+                           size_t max) const;
+
   /**
    * @brief Shutdown the database and release initialization resources.
    *
@@ -244,6 +304,20 @@ Status setDatabaseValue(const std::string& domain,
                         const std::string& key,
                         int value);
 
+/**
+ * @brief Store several values into the active DatabasePlugin atomically.
+ *
+ * See DatabasePlugin::putBatch. All pairs commit together with one sync when
+ * the backing store supports batching; external (extension) registries fall
+ * back to individual puts.
+ *
+ * @param domain A string value representing abstract storage indexing.
+ * @param data The list of key/value pairs to store together.
+ * @return Storage operation status.
+ */
+Status setDatabaseBatchValues(const std::string& domain,
+                              const DatabaseStringValueList& data);
+
 /// Remove a domain/key identified value from backing-store.
 Status deleteDatabaseValue(const std::string& domain, const std::string& key);
 
@@ -263,6 +337,30 @@ Status scanDatabaseKeys(const std::string& domain,
                         const std::string& prefix,
                         size_t max = 0);
 
+/**
+ * @brief Get a list of key/value pairs for a given domain.
+ *
+ * See DatabasePlugin::scanValues. Batch consumers (such as the buffered log
+ * forwarder) use this instead of a key scan plus one get per key.
+ */
+Status scanDatabaseValues(const std::string& domain,
+                          DatabaseStringValueList& results,
+                          const std::string& prefix,
+                          size_t max = 0);
+
+/**
+ * @brief Stream keys for a domain in bounded chunks.
+ *
+ * The predicate receives consecutive chunks of at most chunk keys; return
+ * false from the predicate to stop the scan early. Peak memory is one chunk
+ * regardless of how many keys the domain holds.
+ */
+Status scanDatabaseKeysChunked(
+    const std::string& domain,
+    std::function<bool(const std::vector<std::string>& keys)> predicate,
+    const std::string& prefix,
+    size_t chunk = 5000);
+
 /// Allow callers to reload or reset the database plugin.
 void resetDatabase();
 
@@ -138,6 +138,17 @@ class Dispatcher : private boost::noncopyable {
   /// See `add`, but services are not limited to a thread poll size.
   static Status addService(InternalRunnableRef service);
 
+  /**
+   * @brief Run a one-shot runnable on the shared worker pool.
+   *
+   * Unlike addService this does not spawn a dedicated thread: the task is
+   * queued for a small pool of workers (sized by --worker_threads) that is
+   * created on first use. Tasks share the service interruption semantics,
+   * so a long-running task observes stopServices through interrupted().
+   * Blocking readers and run-loop services must keep using addService.
+   */
+  static Status addTask(InternalRunnableRef task);
+
   /// See `join`, but applied to osquery services.
   static void joinServices();
 
@@ -161,6 +172,9 @@ class Dispatcher : private boost::noncopyable {
   /// When a service ends, it will remove itself from the dispatcher.
   static void removeService(const InternalRunnable* service);
 
+  /// The entry point for each shared worker pool thread.
+  static void poolWorker();
+
  private:
   /// For testing only, reset the stopping status for unittests.
   void resetStopping() {
@@ -177,6 +191,21 @@ class Dispatcher : private boost::noncopyable {
   // Protection around service access.
   mutable Mutex mutex_;
 
+  /// The shared worker pool threads, created on first addTask use.
+  std::vector<InternalThreadRef> pool_threads_;
+
+  /// Set once the worker pool threads have been created.
+  bool pool_started_{false};
+
+  /// Tasks waiting for a worker pool thread.
+  std::vector<InternalRunnableRef> task_queue_;
+
+  /// Protection around the task queue, also paired with task_condition_.
+  std::mutex task_lock_;
+
+  /// Wakes pool workers when tasks are queued or a stop is requested.
+  std::condition_variable task_condition_;
+
 
   /**
    * @brief Signal to the Dispatcher that no services should be created.
@@ -13,6 +13,7 @@
 #include <string>
 #include <vector>
 
+#include <osquery/mutex.h>
 #include <osquery/plugin.h>
 #include <osquery/query.h>
 #include <osquery/status.h>
@@ -255,6 +256,16 @@ class Distributed {
    */
   DistributedQueryRequest popRequest();
 
+  /**
+   * @brief Execute a single distributed query request and queue its result
+   *
+   * Applies the optional --distributed_query_max_seconds and
+   * --distributed_query_max_bytes limits: execution cannot be interrupted
+   * mid-query, so an over-limit result is discarded and replaced with an
+   * error status. Safe to call from several worker threads at once.
+   */
+  void runRequest(const DistributedQueryRequest& request);
+
   /**
    * @brief Queue a result to be batch sent to the server
    *
@@ -267,16 +278,49 @@ class Distributed {
    */
   Status flushCompleted();
 
+  /**
+   * @brief Flush the collected results in bounded, sequence-numbered batches
+   *
+   * Used when --distributed_write_batch_rows is non-zero. Each write holds at
+   * most that many rows, splitting the rows of a single large result when
+   * needed, so peak memory does not grow with the total result size. Batches
+   * carry a "sequence" number and the last batch of a run sets "final", which
+   * lets the server reassemble results and start processing early. A write
+   * the server does not acknowledge (a failed plugin call) is re-queued.
+   *
+   * @param final true if this run will produce no further results
+   */
+  Status flushBatches(bool final);
+
+  /**
+   * @brief Pop at most limit rows of completed results off of results_
+   *
+   * The rows of a single result may be split across several batches, each
+   * part repeats the request ID and status for server-side reassembly.
+   */
+  std::vector<DistributedQueryResult> popResultBatch(size_t limit);
+
   // Setter for ID of currently executing request
   static void setCurrentRequestId(const std::string& cReqId);
 
   std::vector<DistributedQueryResult> results_;
 
+  /// Sequence number of the next batched result write.
+  size_t write_sequence_{0};
+
+  /// Serialize request popping when a worker pool drains the queue.
+  Mutex requests_mutex_;
+
+  /// Protect results_ against concurrent appends and flushes.
+  Mutex results_mutex_;
+
   // ID of the currently executing query
   static std::string currentRequestId_;
 
  private:
   friend class DistributedTests;
   FRIEND_TEST(DistributedTests, test_workflow);
+  FRIEND_TEST(DistributedTests, test_result_batches);
+  FRIEND_TEST(DistributedTests, test_query_limits);
 };
 }
@@ -32,6 +32,7 @@ class EventPublisher;
 template <class PUB>
 class EventSubscriber;
 class EventFactory;
+class EventJournal;
 
 using EventID = const std::string;
 using EventContextID = uint64_t;
@@ -68,6 +69,18 @@ struct EventContext : private boost::noncopyable {
 
   /// The time the event occurred, as determined by the publisher.
   EventTime time{0};
+
+  /**
+   * @brief The subscription context this event was resolved against.
+   *
+   * Publishers that identify the owning subscription while building an event
+   * (inotify maps the watch descriptor back to its subscription context) may
+   * record it here. The fire loop then dispatches through the publisher's
+   * subscription index with one lookup, instead of probing every
+   * subscription's shouldFire, so per-event cost stays flat as the
+   * subscription count grows. Left unset, every subscription is probed.
+   */
+  std::shared_ptr<SubscriptionContext> target_sub_ctx;
 };
 
 using SubscriptionRef = std::shared_ptr<Subscription>;
@@ -251,6 +264,35 @@ class EventPublisherPlugin : public Plugin,
    */
   void tearDown() override {}
 
+  /**
+   * @brief Serialize warm-restart state for a replacement process.
+   *
+   * When a worker is stopped (commonly by the watchdog) the EventFactory asks
+   * each publisher for a serializable snapshot of its OS-facing state, for
+   * example the set of inotify watches. The snapshot is persisted to the
+   * backing store and offered to the publisher registered by the replacement
+   * process through restoreState, allowing a warm start instead of waiting
+   * for the configuration to re-derive subscriptions.
+   *
+   * @param state Output serialized (JSON) publisher state.
+   */
+  virtual Status serializeState(std::string& state) {
+    return Status(1, "Publisher does not persist state");
+  }
+
+  /**
+   * @brief Restore warm-restart state from a previous process.
+   *
+   * Called in the main thread after a successful setUp, before the run loop
+   * and before configure. Publishers should treat the state as a hint: the
+   * next configure recalculates subscriptions authoritatively.
+   *
+   * @param state Serialized state produced by serializeState.
+   */
+  virtual Status restoreState(const std::string& state) {
+    return Status(1, "Publisher does not persist state");
+  }
+
   /**
    * @brief Implement a "step" of an optional run loop.
    *
@@ -331,6 +373,11 @@ class EventPublisherPlugin : public Plugin,
     started_ = started;
   }
 
+  /// Atomically claim the run loop start, false if it already started.
+  bool markStarted() {
+    return !started_.exchange(true);
+  }
+
   /// Get the number of publisher restarts.
   size_t restartCount() const {
     return restart_count_;
@@ -352,6 +399,18 @@ class EventPublisherPlugin : public Plugin,
    */
   void fire(const EventContextRef& ec, EventTime time = 0);
 
+  /**
+   * @brief Fire a batch of events drained from the OS in one pass.
+   *
+   * Publishers that drain many events per wake (inotify, audit) should prefer
+   * the batched fire: the subscription lock is taken and each subscriber is
+   * resolved once for the whole batch, instead of once per event.
+   *
+   * @param batch The EventContext%s created and fired by the EventPublisher.
+   * @param time The most accurate time associated with the events.
+   */
+  void fire(const std::vector<EventContextRef>& batch, EventTime time = 0);
+
   /// The internal fire method used by the typed EventPublisher.
   virtual void fireCallback(const SubscriptionRef& sub,
                             const EventContextRef& ec) const = 0;
@@ -362,6 +421,16 @@ class EventPublisherPlugin : public Plugin,
   /// The EventPublisher will keep track of Subscription%s that contain callins.
   SubscriptionVector subscriptions_;
 
+  /**
+   * @brief Dispatch index from subscription context to owning subscriptions.
+   *
+   * Maintained alongside subscriptions_ under the subscription lock. Events
+   * carrying a target_sub_ctx are dispatched through this index with one
+   * lookup rather than a shouldFire probe across all subscriptions.
+   */
+  std::map<const SubscriptionContext*, SubscriptionVector>
+      subscription_index_;
+
   /// An Event ID is assigned by the EventPublisher within the EventContext.
   /// This is not used to store event date in the backing store.
   std::atomic<EventContextID> next_ec_id_{0};
@@ -383,6 +452,7 @@ class EventPublisherPlugin : public Plugin,
  private:
   FRIEND_TEST(EventsTests, test_event_publisher);
   FRIEND_TEST(EventsTests, test_fire_event);
+  FRIEND_TEST(EventsTests, test_fire_batch);
 };
 
 class EventSubscriberPlugin : public Plugin, public Eventer {
@@ -422,31 +492,101 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
     return add(r, 0);
   }
 
+  /**
+   * @brief Store a batch of parsed event data in the backing store.
+   *
+   * Equivalent to calling add for each row, but the serialized data and
+   * indexing records for the whole batch commit to the backing store as one
+   * atomic write. Callbacks that emit several rows per fired event should
+   * prefer the batch form.
+   *
+   * @param row_list The osquery Row elements to store.
+   *
+   * @return Were the elements added to the backing store.
+   */
+  Status addBatch(std::vector<Row>& row_list);
+
   /**
    * @brief Return all events added by this EventSubscriber within start, stop.
    *
    * This is used internally (for the most part) by EventSubscriber::genTable.
    *
+   * When metadata_only is set the rows are built from the record index (eid
+   * and time) without reading or deserializing the stored event data. This
+   * answers aggregates like COUNT(*) and MIN/MAX over time from the index.
+   *
    * @param yield The Row yield method.
    * @param start Inclusive lower bound time limit.
    * @param stop Inclusive upper bound time limit.
+   * @param metadata_only Yield only eid/time from the record index.
    * @return Set of event rows matching time limits.
    */
-  virtual void get(RowYield& yield, EventTime start, EventTime stop) final;
+  virtual void get(RowYield& yield,
+                   EventTime start,
+                   EventTime stop,
+                   bool metadata_only = false) final;
 
  private:
   /// Overload add for tests and allow them to override the event time.
   virtual Status add(Row& r, EventTime event_time) final;
 
+  /**
+   * @brief Group-commit all events waiting in the pending batch.
+   *
+   * When events_batch_size is set, add accumulates rows in memory and this
+   * flush performs the batch write. It runs when the size or latency bound
+   * is hit and before any query-time retrieval (see get).
+   */
+  Status flushPendingEvents();
+
+  /**
+   * @brief Flush the pending batch only once its latency bound has passed.
+   *
+   * The publisher run loops call this periodically so a batch that hit the
+   * latency bound does not wait on the next add when the subscriber idles.
+   */
+  Status flushOverdueEvents();
+
+  /**
+   * @brief Restore journaled events that never reached the backing store.
+   *
+   * When the events journal is enabled (see events_journal) rows are
+   * recovered from the append-only journal during subscriber registration
+   * and committed as a normal batch write.
+   */
+  Status replayJournal();
+
+  /**
+   * @brief Serialize a row and append it to the events journal.
+   *
+   * The journal is opened on demand next to the backing store database.
+   * The caller must hold pending_events_mutex_.
+   */
+  Status journalRow(const Row& r);
+
+  /**
+   * @brief Drop an event row identical to one recorded in its dedup window.
+   *
+   * When events_dedup_window is set, repeated rows whose signal columns
+   * (everything but the per-event time/eid stamps) match a row recorded
+   * within the sliding window are counted and dropped, guarding storage
+   * and the forwarding pipeline during event storms. The row that reopens
+   * a window is annotated with the suppressed total.
+   *
+   * @param r The candidate event row; may gain a 'suppressed' column.
+   * @param event_time The time of the event.
+   *
+   * @return True if the row is a suppressed duplicate and must not commit.
+   */
+  bool deduplicateEvent(Row& r, EventTime event_time);
+
  private:
   /*
    * @brief When `get`ing event results, return EventID%s from time indexes.
    *
-   * Used by EventSubscriber::get to retrieve EventID, EventTime indexes. This
-   * applies the lookup-efficiency checks for time list appropriate bins.
-   * If the time range in 24 hours and there is a 24-hour list bin it will
-   * be queried using a single backing store `Get` followed by two `Get`s of
-   * the most-specific boundary lists.
+   * Used by EventSubscriber::get to retrieve EventID, EventTime indexes. Each
+   * index is translated into an ordered backing store prefix scan over the
+   * record keys within the bin, so lookups never deserialize record lists.
    *
    * @param index the set of index to scan.
    * @param optimize if true apply optimization checks.
@@ -474,6 +614,11 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
   /**
    * @brief Plan the best set of indexes for event record access.
    *
+   * The subscriber tracks its populated time bins in an ordered in-memory
+   * set, seeded once from the backing store and kept current by writes.
+   * The bins overlapping [start, stop) are selected with a binary search,
+   * so planning cost follows the window size and not the retention.
+   *
    * @param start an inclusive time to begin searching.
    * @param stop an inclusive time to end searching.
    * @param sort if true the indexes will be sorted.
@@ -484,17 +629,6 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
                                       EventTime stop,
                                       bool sort = true);
 
-  /**
-   * @brief Expire indexes and eventually records.
-   *
-   * @param list_type the string representation of list binning type.
-   * @param indexes complete set of 'index.step' indexes for the list_type.
-   * @param expirations of the indexes, the set to expire.
-   */
-  void expireIndexes(const std::string& list_type,
-                     const std::vector<std::string>& indexes,
-                     const std::vector<std::string>& expirations);
-
   /// Expire all datums within a bin.
   void expireRecords(const std::string& list_type,
                      const std::string& index,
@@ -513,12 +647,12 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
   void expireCheck();
 
   /**
-   * @brief Add an EventID, EventTime pair to all matching list types.
+   * @brief Record an EventID, EventTime pair into the matching time bin.
    *
-   * The list types are defined by time size. Based on the EventTime this pair
-   * is added to the list bin for each list type. If there are two list types:
-   * 60 seconds and 3600 seconds and `time` is 92, this pair will be added to
-   * list type 1 bin 4 and list type 2 bin 1.
+   * The bins are defined by time size. Based on the EventTime this pair is
+   * written as a single record key within its bin: if the bin size is 60
+   * seconds and `time` is 92, the record is keyed under bin 1. Record keys
+   * sort by EID so a bin is retrieved with one ordered prefix scan.
    *
    * @param eid A unique EventID.
    * @param time The time when this EventID%'s event occurred.
@@ -527,6 +661,22 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
    */
   Status recordEvent(const std::string& eid, EventTime time);
 
+  /// Mark the bin containing `time` as populated in the ordered bin cache.
+  void recordBin(EventTime time);
+
+  /**
+   * @brief Split a pre-upgrade comma-joined record list into record keys.
+   *
+   * Older versions stored each bin as one records.<ns>.60.<bin> key holding
+   * a comma-joined eid:time list, indexed by an indexes.<ns>.60 bin list.
+   * These keys share the record prefix but never match the per-record scan,
+   * so their events would be invisible and never expire. The list is
+   * rewritten as individual record keys and then deleted.
+   *
+   * @param key The full legacy record key found during the bin seed scan.
+   */
+  void migrateLegacyRecords(const std::string& key);
+
   /**
    * @brief Get the expiration timeout for this event type
    *
@@ -666,21 +816,91 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
   /// The number of scheduled queries using this subscriber.
   std::atomic<size_t> query_count_{0};
 
+  /**
+   * @brief Config-provided retention overrides for this subscriber.
+   *
+   * The "events" config key may declare per-subscriber retention, so a
+   * noisy subscriber can be trimmed aggressively without shortening the
+   * global --events_expiry/--events_max for every other event type. A
+   * value of 0 defers to the global flag.
+   */
+  std::atomic<size_t> events_expiry_override_{0};
+
+  /// See events_expiry_override_; bounds the buffered event count.
+  std::atomic<size_t> events_max_override_{0};
+
   /// Set of queries that have used this subscriber table.
   std::set<std::string> queries_;
 
+  /// Events accumulated for a group commit (see events_batch_size).
+  std::vector<Row> pending_events_;
+
+  /// Monotonic milliseconds when the oldest pending event was buffered.
+  size_t pending_since_{0};
+
+  /// Lock around the pending event batch.
+  Mutex pending_events_mutex_;
+
+  /// Crash-safety journal for the pending batch (see events_journal).
+  std::shared_ptr<EventJournal> journal_;
+
+  /// One sliding dedup window: its start and the rows suppressed within it.
+  struct EventDedupWindow {
+    EventTime start{0};
+    size_t suppressed{0};
+  };
+
+  /// Suppression windows keyed by event row content hash.
+  std::map<uint64_t, EventDedupWindow> dedup_windows_;
+
+  /// Lock around the suppression windows.
+  Mutex dedup_windows_mutex_;
+
+  /// Ordered set of populated record bins, used to plan index scans.
+  std::set<EventTime> record_bins_;
+
+  /// The bin cache was seeded from the backing store record keys.
+  bool record_bins_seeded_{false};
+
+  /// Lock around the ordered bin cache.
+  Mutex record_bins_mutex_;
+
+  /**
+   * @brief Parsed (EventID, time) records cached per completed bin.
+   *
+   * Every window query re-scanned each record key and re-parsed its stored
+   * time string. Bins older than the current minute no longer receive
+   * events, so their parsed records are cached and reused; a late write or
+   * an expiration for a bin invalidates its entry.
+   */
+  std::map<EventTime, std::vector<EventRecord>> record_cache_;
+
+  /// Lock around the parsed per-bin record cache.
+  Mutex record_cache_mutex_;
+
   /// Lock used when incrementing the EventID database index.
   Mutex event_id_lock_;
 
-  /// Lock used when recording an EventID and time into search bins.
-  Mutex event_record_lock_;
-
   /// Lock used when recording queries executing against this subscriber.
   mutable Mutex event_query_record_;
 
+  /**
+   * @brief Decoded rows cached by EventID for repeated window queries.
+   *
+   * Dashboard-style clients re-issue the same time-window query on every
+   * refresh. Events are immutable once written, so decoded rows are cached
+   * with their event time; an overlapping window reuses the cached rows and
+   * only the new tail is read and deserialized from the backing store.
+   */
+  std::map<std::string, std::pair<EventTime, Row>> row_cache_;
+
+  /// Lock around the decoded-row cache.
+  Mutex row_cache_mutex_;
+
  private:
   friend class EventFactory;
   friend class EventPublisherPlugin;
+  friend class EventsExpiryRunner;
 
  private:
   FRIEND_TEST(EventsDatabaseTests, test_event_module_id);
@@ -691,7 +911,9 @@ class EventSubscriberPlugin : public Plugin, public Eventer {
   FRIEND_TEST(EventsDatabaseTests, test_expire_check);
   FRIEND_TEST(EventsDatabaseTests, test_optimize);
   FRIEND_TEST(EventsDatabaseTests, test_record_corruption);
+  FRIEND_TEST(EventsDatabaseTests, test_record_bin_seeding);
   FRIEND_TEST(EventsTests, test_event_subscriber_configure);
+  FRIEND_TEST(EventsTests, test_event_subscriber_retention);
   friend class DBFakeEventSubscriber;
   friend class BenchmarkEventSubscriber;
 };
@@ -843,6 +1065,16 @@ class EventFactory : private boost::noncopyable {
   /// An initializer's entry-point for spawning all event type run loops.
   static void delay();
 
+  /**
+   * @brief Spawn a single publisher run loop on first subscriber demand.
+   *
+   * With on-demand events enabled, publishers without subscriptions are not
+   * started by the initializer and idle loops quiesce. Adding a subscription
+   * (at attach time or from a later config update) starts the loop, calling
+   * setUp again if a quiesced publisher tore its OS-facing state down.
+   */
+  static void startPublisher(const std::string& type_id);
+
   /// If a static EventPublisher callback wants to fire
   template <typename PUB>
   static void fire(const EventContextRef& ec) {
@@ -850,6 +1082,13 @@ class EventFactory : private boost::noncopyable {
     event_pub->fire(ec);
   }
 
+  /// If a static EventPublisher callback wants to fire a drained batch.
+  template <typename PUB>
+  static void fire(const std::vector<EventContextRef>& batch) {
+    auto event_pub = getEventPublisher(getType<PUB>());
+    event_pub->fire(batch);
+  }
+
   /**
    * @brief Return the publisher registry name given a type.
    *
@@ -894,6 +1133,9 @@ class EventFactory : private boost::noncopyable {
   /// Set of running EventPublisher run loop threads.
   std::vector<std::shared_ptr<std::thread>> threads_;
 
+  /// Set once the initializer has spawned the initial set of run loops.
+  std::atomic<bool> activated_{false};
+
   /// Set of logger plugins to forward events.
   std::vector<std::string> loggers_;
 
@@ -901,6 +1143,53 @@ class EventFactory : private boost::noncopyable {
   Mutex factory_lock_;
 };
 
+/// The configured per-publisher context pool size, 0 when pooling is off.
+size_t eventContextPoolSize();
+
+/**
+ * @brief A recycling pool of event contexts for a publisher's hot loop.
+ *
+ * Publishers at high event rates allocate a context object and a shared_ptr
+ * control block for every fired event. The pool instead retains a small set
+ * of previously fired contexts: once every subscriber reference to a slot
+ * has dropped, the context is destroyed and rebuilt in place, reusing both
+ * the object storage and its control block. A context retained past the
+ * fire lifecycle simply keeps its slot busy until released; a slot is never
+ * reset while any other reference exists.
+ */
+template <typename EC>
+class EventContextPool : private boost::noncopyable {
+ public:
+  std::shared_ptr<EC> acquire() {
+    {
+      WriteLock lock(mutex_);
+      for (auto& slot : pool_) {
+        if (slot.use_count() == 1) {
+          // The previous fire cycle completed; only the pool holds the slot.
+          slot->~EC();
+          new (slot.get()) EC();
+          return slot;
+        }
+      }
+
+      if (pool_.size() < eventContextPoolSize()) {
+        pool_.push_back(std::make_shared<EC>());
+        return pool_.back();
+      }
+    }
+
+    // Every slot is busy; fall back to a transient allocation.
+    return std::make_shared<EC>();
+  }
+
+ private:
+  /// Pooled contexts; a use count of one marks a slot free for reuse.
+  std::vector<std::shared_ptr<EC>> pool_;
+
+  /// Protects the slot vector; publishers may fire from several threads.
+  Mutex mutex_;
+};
+
 /**
  * @brief Generate OS events of a type (FS, Network, Syscall, ioctl).
  *
@@ -957,7 +1246,13 @@ class EventPublisher : public EventPublisherPlugin {
 
   /// Create a EventContext based on the templated type.
   static ECRef createEventContext() {
-    return std::make_shared<EC>();
+    if (eventContextPoolSize() == 0) {
+      return std::make_shared<EC>();
+    }
+
+    // One pool per context type, shared by the publisher's firing threads.
+    static EventContextPool<EC> pool;
+    return pool.acquire();
   }
 
   /// Create a SubscriptionContext based on the templated type.
@@ -1005,6 +1300,7 @@ class EventPublisher : public EventPublisherPlugin {
   FRIEND_TEST(EventsTests, test_event_subscriber_subscribe);
   FRIEND_TEST(EventsTests, test_event_subscriber_context);
   FRIEND_TEST(EventsTests, test_fire_event);
+  FRIEND_TEST(EventsTests, test_fire_batch);
 };
 
 /**
@@ -171,6 +171,19 @@ Status callExtension(const std::string& extension_path,
                      const PluginRequest& request,
                      PluginResponse& response);
 
+/**
+ * @brief Retrieve call statistics for an extension socket path.
+ *
+ * The extension call layer counts the registry calls dispatched to each
+ * extension and their cumulative latency, making slow extensions visible
+ * through the osquery_extensions table.
+ *
+ * @param path The UNIX domain socket path of the extension.
+ * @param calls Output number of registry calls dispatched to the extension.
+ * @param latency Output cumulative call latency in microseconds.
+ */
+void getExtensionStats(const std::string& path, size_t& calls, size_t& latency);
+
 /// The main runloop entered by an Extension, start an ExtensionRunner thread.
 Status startExtension(const std::string& name, const std::string& version);
 
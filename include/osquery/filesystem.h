@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <functional>
 #include <map>
 #include <set>
 #include <string>
@@ -216,6 +217,34 @@ Status resolveFilePattern(const boost::filesystem::path& pattern,
  */
 void replaceGlobWildcards(std::string& pattern, GlobLimits limits = GLOB_ALL);
 
+/**
+ * @brief Begin an advisory asynchronous read of a file's content.
+ *
+ * The kernel is asked to readahead the file into the page cache while the
+ * caller works on other units, so a following readFile or hash pass finds
+ * the content resident instead of waiting on the disk. Targets larger than
+ * --read_max are skipped. The request is best-effort and never blocks on
+ * the content.
+ */
+void prefetchFile(const boost::filesystem::path& path);
+
+/**
+ * @brief Drain a set of file walk work units on a bounded thread pool.
+ *
+ * Large file and hash table scans are dominated by per-entry stat and read
+ * latency, so resolved targets are drained by --file_walk_threads workers
+ * pulling indexes in [0, count). The walker must be safe to run concurrently
+ * and must not assume any completion order; each worker should write into
+ * state it exclusively owns (such as a preallocated row slot). With a single
+ * thread or a single unit this degrades to a serial loop on the calling
+ * thread.
+ */
+void parallelFileWalk(size_t count, const std::function<void(size_t)>& walker);
+
+/// See parallelFileWalk, draining a resolved path list instead of indexes.
+void parallelFileWalk(const std::vector<std::string>& paths,
+                      const std::function<void(const std::string&)>& walker);
+
 /// Attempt to remove a directory path.
 Status removePath(const boost::filesystem::path& path);
 
@@ -333,6 +362,24 @@ Status pathFromPlistAliasData(const std::string& data, std::string& result);
  */
 Status procProcesses(std::set<std::string>& processes);
 
+class QueryContext;
+
+/**
+ * @brief Collect the pids a query must inspect, honoring pid constraints.
+ *
+ * When the query (or a join) supplies pid equality constraints only those
+ * pids are returned, after checking they exist in procfs; otherwise every
+ * live process is enumerated. Per-process tables using this helper cost
+ * time proportional to the constrained set, not the system process count.
+ *
+ * @param context the query context carrying constraint values.
+ * @param processes output list of process pids as strings.
+ *
+ * @return an instance of Status, indicating success or failure.
+ */
+Status procProcesses(const QueryContext& context,
+                     std::set<std::string>& processes);
+
 /**
  * @brief Iterate over a `/proc` process's descriptors, return a list of fds.
  *
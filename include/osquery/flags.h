@@ -10,7 +10,9 @@
 
 #pragma once
 
+#include <atomic>
 #include <map>
+#include <type_traits>
 
 #include <boost/lexical_cast.hpp>
 #include <boost/noncopyable.hpp>
@@ -44,6 +46,20 @@ namespace osquery {
 
 class Status;
 
+/**
+ * @brief Type-erased interface for resolved flag handles.
+ *
+ * See FastFlag. The Flag singleton keeps these by name so that updateValue
+ * can refresh the typed copies after a dynamic (options/TLS config) update.
+ */
+class FastFlagBase {
+ public:
+  virtual ~FastFlagBase() = default;
+
+  /// Re-read the bound Gflags storage into the typed copy.
+  virtual void refresh() = 0;
+};
+
 struct FlagDetail {
   std::string description;
   bool shell;
@@ -81,6 +97,24 @@ class Flag : private boost::noncopyable {
   /// Create a Gflags alias to name, using the Flag::getValue accessor.
   static int createAlias(const std::string& alias, const FlagDetail& flag);
 
+  /**
+   * @brief Bind a FastFlag handle to a flag name.
+   *
+   * Handles are bound during static initialization, before threads spawn,
+   * so the tracking container needs no synchronization.
+   */
+  static void bindFastFlag(const std::string& name, FastFlagBase* handle);
+
+  /**
+   * @brief Reload every bound FastFlag handle from its gflags storage.
+   *
+   * Startup parsing (ParseCommandLineFlags) writes flag storage directly
+   * without passing through Flag::updateValue, so handles bound at static
+   * initialization must be refreshed once after parsing or command-line
+   * and flagfile values would never reach the hot-path readers.
+   */
+  static void refreshFastFlags();
+
   /// Singleton accessor.
   static Flag& instance();
 
@@ -162,6 +196,59 @@ class Flag : private boost::noncopyable {
 
   /// Configurations may set "custom_" flags.
   std::map<std::string, std::string> custom_;
+
+  /// Typed handles refreshed after a dynamic flag update, keyed by name.
+  std::multimap<std::string, FastFlagBase*> fast_flags_;
+};
+
+/**
+ * @brief An opt-in typed flag handle with lock-free reads.
+ *
+ * Flag::getValue resolves names through the Gflags registry, taking its lock
+ * and building a string per read; even the direct `FLAGS_name` globals offer
+ * no defined semantics against a concurrent options update. A FastFlag binds
+ * to a flag's storage once, keeps an atomic typed copy, and is refreshed by
+ * Flag::updateValue, so per-event and per-row code paths read flags with one
+ * relaxed load while the dynamic (TLS options) update flow keeps working.
+ *
+ * Only updates routed through Flag::updateValue (the options parser path)
+ * refresh handles; direct writes to a `FLAGS_name` global bypass them.
+ *
+ * Declare a handle at namespace scope in the translation unit that owns the
+ * hot loop:
+ * @code{.cpp}
+ *   FLAG(uint64, events_expiry, 86000, "...");
+ *   static FastFlag<uint64_t> kEventsExpiryFast("events_expiry",
+ *                                               &FLAGS_events_expiry);
+ * @endcode
+ */
+template <typename T>
+class FastFlag : public FastFlagBase, private boost::noncopyable {
+ public:
+  static_assert(std::is_arithmetic<T>::value,
+                "FastFlag supports arithmetic (bool/integer/double) flags");
+
+  FastFlag(const std::string& name, T* storage)
+      : storage_(storage), value_(*storage) {
+    Flag::bindFastFlag(name, this);
+  }
+
+  /// Read the typed copy of the flag value.
+  T get() const {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+  /// Re-read the bound Gflags storage, called under Flag::updateValue.
+  void refresh() override {
+    value_.store(*storage_, std::memory_order_relaxed);
+  }
+
+ private:
+  /// The Gflags-owned storage, written by SetCommandLineOption.
+  T* storage_;
+
+  /// The lock-free copy consumed by hot loops.
+  std::atomic<T> value_;
 };
 
 /**
@@ -26,6 +26,12 @@ struct PackStats {
   size_t total{0};
   size_t hits{0};
   size_t misses{0};
+
+  /// Cumulative milliseconds spent executing the discovery queries.
+  size_t discovery_wall_time_ms{0};
+
+  /// UNIX time of the most recent discovery query execution.
+  size_t last_discovery_time{0};
 };
 
 /**
@@ -99,6 +105,15 @@ class Pack : private boost::noncopyable {
   /// Verify that a given discovery query returns the appropriate results
   bool checkDiscovery();
 
+  /**
+   * @brief Expire the cached discovery decision.
+   *
+   * The next shouldPackExecute will re-run the discovery queries regardless
+   * of the discovery TTL. This is the invalidation hook for callers reacting
+   * to system events that may have changed a discovery result.
+   */
+  void invalidateDiscovery();
+
   /**
    * @brief Returns whether this pack is executing
    *
@@ -134,6 +149,9 @@ class Pack : private boost::noncopyable {
   /// Cached time and result from previous discovery step.
   std::pair<size_t, bool> discovery_cache_;
 
+  /// Optional per-pack discovery TTL, 0 uses the pack_refresh_interval flag.
+  size_t discovery_interval_{0};
+
   /// Aggregate appropriateness of pack for this host.
   std::atomic<bool> valid_{false};
 
@@ -183,4 +201,34 @@ size_t splayValue(size_t original, size_t splay_percent);
  * @return either the restored previous calculated splay, or a new splay.
  */
 size_t restoreSplayedValue(const std::string& name, size_t interval);
+
+/**
+ * @brief Compute a deterministic firing offset within an interval.
+ *
+ * Splays only adjust the length of an interval; queries sharing a common
+ * interval still phase-align on the same scheduler tick. The phase offsets
+ * each query within its interval window by hashing the host identifier and
+ * the query name, spreading same-interval queries across a host's window
+ * and the same query across a fleet.
+ *
+ * @param name the generated query name.
+ * @param interval the splayed interval in seconds.
+ * @return a stable offset in the range [0, interval).
+ */
+size_t computeQueryPhase(const std::string& name, size_t interval);
+
+/**
+ * @brief Statically analyze every scheduled query and emit a JSON report.
+ *
+ * This backs the --check_packs tool mode. Each scheduled query (packs
+ * included) is compiled to verify it parses and plans, then its EXPLAIN
+ * QUERY PLAN output is inspected for virtual table scans that reach a
+ * generator without constraints. Expensive tables scanned without an indexed
+ * predicate, unsatisfied required columns, and joins nesting several
+ * unconstrained scans become issues, and each query is assigned a cost
+ * class. The machine-readable report is written to stdout.
+ *
+ * @return success when no query raised an issue.
+ */
+Status checkQueryPacks();
 }
@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <array>
 #include <map>
 #include <set>
 #include <string>
@@ -140,6 +141,29 @@ Status deserializeQueryDataJSON(const std::string& json, QueryData& qd);
 /// Inverse of serializeQueryDataJSON, convert a JSON string to QueryDataSet.
 Status deserializeQueryDataJSON(const std::string& json, QueryDataSet& qd);
 
+/**
+ * @brief Serialize a QueryData object into the compact binary storage form.
+ *
+ * The binary form stores the union of column names once, as a schema table,
+ * followed by length-prefixed cells for every row. This is both smaller and
+ * much cheaper to parse than the JSON array-of-objects form, which repeats
+ * every column name per row. It is only used for the "previous results"
+ * stored in the queries database domain; logger output remains JSON.
+ *
+ * @param q the QueryData to serialize.
+ * @param serialized [output] the output binary string.
+ *
+ * @return Status indicating the success or failure of the operation.
+ */
+Status serializeQueryDataBinary(const QueryData& q, std::string& serialized);
+
+/// Inverse of serializeQueryDataBinary, convert binary data to QueryData.
+Status deserializeQueryDataBinary(const std::string& serialized, QueryData& qd);
+
+/// Inverse of serializeQueryDataBinary, convert binary data to QueryDataSet.
+Status deserializeQueryDataBinary(const std::string& serialized,
+                                  QueryDataSet& qd);
+
 /**
  * @brief Data structure representing the difference between the results of
  * two queries
@@ -198,6 +222,29 @@ Status serializeDiffResults(const DiffResults& d,
  */
 Status serializeDiffResultsJSON(const DiffResults& d, std::string& json);
 
+/**
+ * @brief Compute a stable 64-bit hash of a Row's column names and values.
+ *
+ * The hash (FNV-1a) is deterministic across processes, unlike std::hash, so
+ * per-row hashes may be persisted in the results database and compared
+ * against hashes computed by later runs.
+ *
+ * @param r the Row to hash.
+ *
+ * @return a 64-bit hash covering every column name and value.
+ */
+uint64_t computeRowHash(const Row& r);
+
+/**
+ * @brief Drop the in-memory row hash summary for a scheduled query.
+ *
+ * Used when a query's stored results are expired or removed so a later
+ * query of the same name cannot match against stale hashes.
+ *
+ * @param name the scheduled query name.
+ */
+void clearQueryRowHashCache(const std::string& name);
+
 /**
  * @brief Diff QueryDataSet object and QueryData object
  *        and create a DiffResults object
@@ -241,6 +288,34 @@ bool addUniqueRowToQueryData(QueryData& q, const Row& r);
  */
 void escapeQueryData(const QueryData& oldData, QueryData& newData);
 
+/**
+ * @brief A constant-memory log-scale histogram of query measurements.
+ *
+ * Samples are binned by their power-of-two magnitude, so the structure
+ * occupies a fixed size no matter how many executions it records. The
+ * resulting percentile estimates are accurate to within a factor of two,
+ * enough to spot a regressing scheduled query from the agent itself.
+ */
+struct QueryHistogram {
+  /// One bucket per power-of-two magnitude of a 64-bit sample.
+  std::array<size_t, 64> buckets{{}};
+
+  /// Total number of recorded samples.
+  size_t samples{0};
+
+  /// Record a single measurement.
+  void add(uint64_t value);
+
+  /// Estimate the value at integer percentile p (1-100), 0 when empty.
+  uint64_t percentile(size_t p) const;
+
+  /// Pack the bucket counts into a comma-separated database value.
+  std::string serialize() const;
+
+  /// Restore bucket counts from a previously serialized value.
+  void deserialize(const std::string& raw);
+};
+
 /**
  * @brief performance statistics about a query
  */
@@ -265,6 +340,18 @@ struct QueryPerformance {
 
   /// Total characters, bytes, generated by query.
   unsigned long long int output_size{0};
+
+  /// Histogram of per-execution wall times, in seconds.
+  QueryHistogram wall_time_hist;
+
+  /// Histogram of per-execution resident memory growth, in bytes.
+  QueryHistogram memory_hist;
+
+  /// Pack the counters and histograms into a compact database value.
+  std::string serialize() const;
+
+  /// Restore counters and histograms from a serialized record.
+  void deserialize(const std::string& raw);
 };
 
 /**
@@ -284,6 +371,15 @@ struct ScheduledQuery : private only_movable {
   /// A temporary splayed internal.
   size_t splayed_interval{0};
 
+  /**
+   * @brief A deterministic firing offset within the splayed interval.
+   *
+   * Queries sharing common intervals (60, 300, 3600) would otherwise all
+   * fire on the same scheduler tick. The phase levels that load by hashing
+   * the host identifier and query name into [0, splayed_interval).
+   */
+  size_t phase{0};
+
   /**
    * @brief Queries are blacklisted based on logic in the configuration.
    *
@@ -293,6 +389,29 @@ struct ScheduledQuery : private only_movable {
    */
   bool blacklisted{false};
 
+  /**
+   * @brief Maximum number of rows a snapshot execution emits (0 = all).
+   *
+   * Snapshot queries that only feed trend statistics do not need their
+   * full result materialized into the log pipeline. When set, a uniform
+   * reservoir sample of this many rows is logged instead.
+   */
+  size_t sample_rows{0};
+
+  /**
+   * @brief Event publishers whose activity triggers this query.
+   *
+   * A comma-separated list of event publisher names. When set, the query
+   * also executes (debounced) whenever one of the publishers fires an
+   * event, so change-detection queries stop polling at their interval for
+   * changes a publisher already observes. The interval remains a backstop
+   * for events missed while the publisher was not running.
+   */
+  std::string trigger;
+
+  /// Minimum seconds between trigger-driven executions of this query.
+  size_t trigger_debounce{10};
+
   /// Set of query options.
   std::map<std::string, bool> options;
 
@@ -300,6 +419,27 @@ struct ScheduledQuery : private only_movable {
   ScheduledQuery(ScheduledQuery&&) = default;
   ScheduledQuery& operator=(ScheduledQuery&&) = default;
 
+  /**
+   * @brief Copy this schedule entry explicitly.
+   *
+   * The type is move-only so accidental copies of the schedule do not
+   * happen; snapshot and worker paths that need their own entry take one
+   * deliberately through this helper.
+   */
+  ScheduledQuery clone() const {
+    ScheduledQuery copy;
+    copy.query = query;
+    copy.interval = interval;
+    copy.splayed_interval = splayed_interval;
+    copy.phase = phase;
+    copy.blacklisted = blacklisted;
+    copy.sample_rows = sample_rows;
+    copy.trigger = trigger;
+    copy.trigger_debounce = trigger_debounce;
+    copy.options = options;
+    return copy;
+  }
+
   /// equals operator
   bool operator==(const ScheduledQuery& comp) const {
     return (comp.query == query) && (comp.interval == interval);
@@ -341,6 +481,15 @@ struct QueryLogItem {
   /// Query execution counter for current epoch
   uint64_t counter{0};
 
+  /**
+   * @brief This item replaces a snapshot identical to the previous run.
+   *
+   * When --logger_snapshot_dedup is set, a snapshot result whose content
+   * matches the last logged run for the same query is emitted as a compact
+   * marker (no rows, "unchanged": true) instead of the full payload.
+   */
+  bool unchanged{false};
+
   /// The time that the query was executed, an ASCII string.
   std::string calendar_time;
 
@@ -450,17 +599,18 @@ class Query {
   uint64_t getPreviousEpoch() const;
 
   /**
-   * @brief Get the query invocation counter.
+   * @brief Advance the query invocation counter.
    *
-   * This method returns query invocation counter. If the query is a new query,
-   * 0 is returned. Otherwise the counter associated with the query is retrieved
-   * from database and incremented by 1.
+   * The counter is per-run metadata stored under its own small key, apart
+   * from the row baseline, so bumping it never rewrites the stored results.
+   * If the counter is reset (a new or altered query) 0 is returned, otherwise
+   * the previous invocation's counter is incremented by 1.
    *
-   * @param new_query Whether or not the query is new.
+   * @param reset Whether the counter restarts at 0.
    *
-   * @return the query invocation counter.
+   * @return the query invocation counter for this execution.
    */
-  uint64_t getQueryCounter(bool new_query) const;
+  uint64_t incrementCounter(bool reset) const;
 
   /**
    * @brief Check if a given scheduled query exists in the database.
@@ -533,6 +683,20 @@ class Query {
    */
   static std::vector<std::string> getStoredQueryNames();
 
+ private:
+  /**
+   * @brief Retrieve the compact per-row hash set from the previous run.
+   *
+   * The hashes are stored alongside the serialized results and allow the
+   * differential to detect an unchanged row set without deserializing the
+   * full previous result set.
+   *
+   * @param hashes the output set of 64-bit row hashes.
+   *
+   * @return the success or failure of the operation.
+   */
+  Status getPreviousRowHashes(std::multiset<uint64_t>& hashes) const;
+
  private:
   /// The scheduled query's query string.
   std::string query_;
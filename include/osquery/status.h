@@ -39,8 +39,12 @@ class Status {
    *
    * Note that the default constructor initialized an osquery::Status instance
    * to a state such that a successful operation is indicated.
+   *
+   * A successful status carries no message storage; the canonical "OK" is
+   * materialized lazily by getMessage. This keeps the success path free of
+   * string construction, as Status is returned from nearly every API.
    */
-  explicit Status(int c = Status::kSuccessCode) : code_(c), message_("OK") {}
+  explicit Status(int c = Status::kSuccessCode) : code_(c) {}
 
   /**
    * @brief A constructor which can be used to concisely express the status of
@@ -77,6 +81,9 @@ class Status {
    * is for the message to be "OK"
    */
   std::string getMessage() const {
+    if (message_.empty() && code_ == kSuccessCode) {
+      return "OK";
+    }
     return message_;
   }
 
@@ -141,7 +148,9 @@ class Status {
 
   // Enables use of gtest (ASSERT|EXPECT)_EQ
   bool operator==(const Status& rhs) const {
-    return (code_ == rhs.getCode()) && (message_ == rhs.getMessage());
+    // Compare through the getter so a message-free success equals an
+    // explicit Status(0, "OK").
+    return (code_ == rhs.getCode()) && (getMessage() == rhs.getMessage());
   }
 
   // Enables use of gtest (ASSERT|EXPECT)_NE
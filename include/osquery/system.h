@@ -13,6 +13,7 @@
 #include <csignal>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include <osquery/core.h>
 #include <osquery/mutex.h>
@@ -282,6 +283,16 @@ std::string generateHostUUID();
  */
 std::string getHostIdentifier();
 
+/**
+ * @brief Drop the cached host identity snapshot.
+ *
+ * getHostIdentifier serves log and distributed hot paths from an
+ * immutable cached snapshot. Callers reacting to an identity change
+ * (hostname edits, identifier flag updates) may invalidate it explicitly;
+ * the next getHostIdentifier call rebuilds the snapshot.
+ */
+void resetHostIdentity();
+
 /**
  * @brief Converts struct tm to a size_t
  *
@@ -325,6 +336,38 @@ std::string toAsciiTimeUTC(const struct tm* tm_time);
  */
 std::string getAsciiTime();
 
+/**
+ * @brief A timed span recorded during process initialization.
+ *
+ * Spans are recorded by the Initializer for each expensive startup phase
+ * (backing store open, registry setup, config load, etc.) and exposed through
+ * the osquery_startup_trace table.
+ */
+struct StartupPhase {
+  /// Name of the initialization phase.
+  std::string name;
+
+  /// Offset of the phase start in microseconds since process start.
+  uint64_t start{0};
+
+  /// Duration of the phase in microseconds.
+  uint64_t duration{0};
+};
+
+/**
+ * @brief Record a timed initialization phase.
+ *
+ * @param name the name of the initialization phase.
+ * @param start offset of the phase start, microseconds since process start.
+ * @param duration duration of the phase in microseconds.
+ */
+void recordStartupPhase(const std::string& name,
+                        uint64_t start,
+                        uint64_t duration);
+
+/// Retrieve a copy of the recorded initialization phases.
+std::vector<StartupPhase> getStartupPhases();
+
 /**
  * @brief Create a pid file
  *
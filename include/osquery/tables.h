@@ -10,8 +10,10 @@
 
 #pragma once
 
+#include <chrono>
 #include <map>
 #include <set>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -27,6 +29,7 @@
 #include <boost/lexical_cast.hpp>
 
 #include <osquery/core.h>
+#include <osquery/mutex.h>
 #include <osquery/plugin.h>
 #include <osquery/query.h>
 
@@ -60,8 +63,43 @@ class Status;
  * types they are storing, and more importantly how they are treated at query
  * time.
  */
+/**
+ * @brief Select the compile-time formatting path for a field type.
+ *
+ * Numeric-heavy tables format a cell for every value of every row, so the
+ * integral types used by the affinity macros take a direct digit-formatting
+ * path below instead of a lexical cast. Character types are excluded; they
+ * keep their lexical text form.
+ */
 template <typename Type>
-inline std::string __sqliteField(const Type& source) noexcept {
+using __sqliteIntegralField = std::integral_constant<
+    bool,
+    std::is_integral<Type>::value && !std::is_same<Type, char>::value &&
+        !std::is_same<Type, signed char>::value &&
+        !std::is_same<Type, unsigned char>::value &&
+        !std::is_same<Type, wchar_t>::value>;
+
+/// Format a base-10 magnitude with an optional sign, avoiding any locale.
+inline std::string __sqliteFieldDigits(unsigned long long value,
+                                       bool negative) noexcept {
+  // 20 digits cover ULLONG_MAX, plus one byte for the sign.
+  char buffer[21];
+  char* end = buffer + sizeof(buffer);
+  char* cursor = end;
+  do {
+    *--cursor = static_cast<char>('0' + (value % 10));
+    value /= 10;
+  } while (value > 0);
+  if (negative) {
+    *--cursor = '-';
+  }
+  return std::string(cursor, end);
+}
+
+template <typename Type>
+inline typename std::enable_if<!__sqliteIntegralField<Type>::value,
+                               std::string>::type
+__sqliteField(const Type& source) noexcept {
   std::string dest;
   if (!boost::conversion::try_lexical_convert(source, dest)) {
     return SQL_NULL_RESULT;
@@ -69,6 +107,29 @@ inline std::string __sqliteField(const Type& source) noexcept {
   return dest;
 }
 
+template <typename Type>
+inline typename std::enable_if<__sqliteIntegralField<Type>::value &&
+                                   std::is_signed<Type>::value,
+                               std::string>::type
+__sqliteField(Type source) noexcept {
+  bool negative = (source < 0);
+  auto value = static_cast<unsigned long long>(source);
+  if (negative) {
+    // Two's complement negation is defined for the unsigned magnitude,
+    // including the minimum value.
+    value = 0ULL - value;
+  }
+  return __sqliteFieldDigits(value, negative);
+}
+
+template <typename Type>
+inline typename std::enable_if<__sqliteIntegralField<Type>::value &&
+                                   !std::is_signed<Type>::value,
+                               std::string>::type
+__sqliteField(Type source) noexcept {
+  return __sqliteFieldDigits(static_cast<unsigned long long>(source), false);
+}
+
 #ifdef WIN32
 // TEXT is also defined in windows.h, we should not re-define it
 #define SQL_TEXT(x) __sqliteField(x)
@@ -165,6 +226,25 @@ struct Constraint {
       : op(_op), expr(std::move(_expr)) {}
 };
 
+/**
+ * @brief A LIKE constraint compiled into its literal anchor components.
+ *
+ * LIKE patterns are mostly-literal: '/var/log/%.log' anchors on a literal
+ * prefix and suffix around the wildcards. Compiling the anchors once per
+ * query lets per-row matching and path generators prune candidates without
+ * re-parsing the pattern.
+ */
+struct LikePattern {
+  /// Literal characters before the first wildcard ('%' or '_').
+  std::string prefix;
+
+  /// Literal characters after the last wildcard.
+  std::string suffix;
+
+  /// True if the pattern contains at least one wildcard.
+  bool wild{false};
+};
+
 /*
  * @brief Column options allow for more-complicated modeling of concepts.
  *
@@ -254,6 +334,10 @@ enum class TableAttributes {
 
   /// This table's data requires an osquery kernel extension/module.
   KERNEL_REQUIRED = 16,
+
+  /// Generation is expensive when unconstrained (filesystem walks, content
+  /// hashing); used to steer query plans toward constrained access.
+  EXPENSIVE = 32,
 };
 
 /// Treat table attributes as a set of flags.
@@ -371,6 +455,16 @@ struct ConstraintList : private boost::noncopyable {
   template <typename T>
   bool literal_matches(const T& base_expr) const;
 
+  /**
+   * @brief Get the LIKE constraints compiled into literal anchors.
+   *
+   * Compilation happens once per constraint list; the result is cached for
+   * reuse by per-row matching and by generators pruning their search space.
+   *
+   * @return the compiled pattern for each LIKE constraint in the list.
+   */
+  const std::vector<LikePattern>& getLikePatterns() const;
+
   /**
    * @brief Get all expressions for a given ConstraintOperator.
    *
@@ -405,6 +499,7 @@ struct ConstraintList : private boost::noncopyable {
    */
   void add(const struct Constraint& constraint) {
     constraints_.push_back(constraint);
+    like_compiled_ = false;
   }
 
   /**
@@ -423,10 +518,20 @@ struct ConstraintList : private boost::noncopyable {
   /// See ConstraintList::unserialize.
   void deserialize(const rapidjson::Value& obj);
 
+ private:
+  /// Test an expression against the compiled LIKE pattern anchors.
+  bool matchLike(const std::string& expr) const;
+
  private:
   /// List of constraint operator/expressions.
   std::vector<struct Constraint> constraints_;
 
+  /// Compiled anchors for each LIKE constraint, built on first request.
+  mutable std::vector<LikePattern> like_patterns_;
+
+  /// Set when like_patterns_ reflects the current constraint list.
+  mutable bool like_compiled_{false};
+
  private:
   friend struct QueryContext;
 
@@ -443,6 +548,12 @@ using ConstraintSet = std::vector<std::pair<std::string, struct Constraint>>;
 /// Keep track of which columns are used
 using UsedColumns = std::unordered_set<std::string>;
 
+/// One requested ORDER BY term: the column name, and true when descending.
+using OrderTerm = std::pair<std::string, bool>;
+
+/// The ordered set of ORDER BY terms applied to a table scan.
+using OrderTerms = std::vector<OrderTerm>;
+
 /**
  * @brief osquery table content descriptor.
  *
@@ -477,12 +588,24 @@ struct VirtualTableContent {
    */
   std::map<std::string, size_t> aliases;
 
+  /**
+   * @brief Alias-resolved column name and type for each column index.
+   *
+   * xColumn runs once per accessed cell, so alias resolution and column
+   * metadata lookups are computed once at table create time and consulted
+   * here by SQLite column index.
+   */
+  std::vector<std::pair<std::string, ColumnType>> resolved_columns;
+
   /// Transient set of virtual table access constraints.
   std::unordered_map<size_t, ConstraintSet> constraints;
 
   /// Transient set of virtual table used columns
   std::unordered_map<size_t, UsedColumns> colsUsed;
 
+  /// Transient set of requested result orderings.
+  std::unordered_map<size_t, OrderTerms> orderTerms;
+
   /*
    * @brief A table implementation specific query result cache.
    *
@@ -668,6 +791,22 @@ struct QueryContext : private only_movable {
   /// Check if the query requested use of the warm query cache.
   bool useCache() const;
 
+  /**
+   * @brief Set an absolute deadline for row generation.
+   *
+   * The virtual table layer sets a deadline when --table_timeout is nonzero.
+   * Long-running tables should call isCancelled between units of work and
+   * stop generating rows once it returns true; the scan then fails with a
+   * timeout error instead of stalling the worker.
+   */
+  void setDeadline(std::chrono::steady_clock::time_point deadline);
+
+  /// Retrieve the generation deadline (time_point::max() when unset).
+  std::chrono::steady_clock::time_point getDeadline() const;
+
+  /// Check whether the deadline has passed and generation should stop.
+  bool isCancelled() const;
+
   /// Set the entire cache for an index.
   void setCache(const std::string& index, Row _cache);
 
@@ -681,6 +820,16 @@ struct QueryContext : private only_movable {
 
   boost::optional<UsedColumns> colsUsed;
 
+  /**
+   * @brief ORDER BY terms requested of this scan, most significant first.
+   *
+   * These are advisory: the sort is never claimed from SQLite, so a table
+   * may safely produce rows in any order. Expensive tables whose source is
+   * naturally ordered may use the hints to walk it in the requested
+   * direction.
+   */
+  OrderTerms orderTerms;
+
  private:
   /// If false then the context is maintaining an ephemeral cache.
   bool enable_cache_{false};
@@ -691,6 +840,10 @@ struct QueryContext : private only_movable {
   /// Persistent table content for table caching.
   VirtualTableContent* table_{nullptr};
 
+  /// Deadline for cooperative cancellation of row generation.
+  std::chrono::steady_clock::time_point deadline_{
+      std::chrono::steady_clock::time_point::max()};
+
  private:
   friend class TablePlugin;
 };
@@ -796,6 +949,22 @@ class TablePlugin : public Plugin {
   /// Return the name and column pairs for attaching virtual tables.
   PluginResponse routeInfo() const override;
 
+ private:
+  /**
+   * @brief Memoized table metadata derived from the column definitions.
+   *
+   * The column set of a table plugin never changes after registration, but
+   * the definition string and route info are requested for every attach and
+   * external "columns" action. Both are computed once and cached.
+   */
+  mutable std::string column_definition_;
+
+  /// Memoized column/alias/attribute route info, see column_definition_.
+  mutable PluginResponse route_info_;
+
+  /// Protect the lazy computation of the memoized table metadata.
+  mutable Mutex metadata_mutex_;
+
   /**
    * @brief Check if there are fresh cache results for this table.
    *
@@ -811,9 +980,8 @@ class TablePlugin : public Plugin {
    * Currently, the query scheduler cannot communicate to table implementations.
    * An interval is set globally by the scheduler and passed to the table
    * implementation as a future-proof API. There is no "shortcut" for caching
-   * when used in external tables. A cache lookup within an extension means
-   * a database call API and re-serialization to the virtual table APIs. In
-   * practice this does not perform well and is explicitly disabled.
+   * when used in external tables. The result cache lives in process memory
+   * and cannot be shared with an extension, so it is explicitly disabled.
    *
    * @param interval The interval this query expects the tables results.
    * @param ctx The query context.
@@ -822,20 +990,20 @@ class TablePlugin : public Plugin {
   bool isCached(size_t interval, const QueryContext& ctx) const;
 
   /**
-   * @brief Perform a database lookup of cached results and deserialize.
+   * @brief Retrieve the cached results for this table and constraint set.
    *
-   * If a query determined the table's cached results are fresh, it may ask the
-   * table to retrieve results from the database and deserialized them into
-   * table row data.
+   * If a query determined the table's cached results are fresh, it may ask
+   * the table to copy the rows out of the process-wide result cache.
    *
-   * @return The deserialized row data of cached results.
+   * @return The row data of cached results.
    */
-  QueryData getCache() const;
+  QueryData getCache(const QueryContext& ctx) const;
 
   /**
    * @brief Similar to getCache, stores the results from generate.
    *
-   * Set will serialize and save the results as JSON to be retrieved later.
+   * Set will store the results in the process-wide result cache, keyed by
+   * the table name and constraint set, to be retrieved later.
    * It will inspect the query context, if any required/indexed/optimized or
    * additional columns are used then the cache will not be saved.
    */
@@ -844,25 +1012,34 @@ class TablePlugin : public Plugin {
                 const QueryContext& ctx,
                 const QueryData& results);
 
- private:
-  /// The last time in seconds the table data results were saved to cache.
-  size_t last_cached_{0};
+  /**
+   * @brief Number of seconds this table's cached results stay fresh.
+   *
+   * Tables may declare a cache_ttl attribute within their spec file. When 0
+   * (the default) the scheduled query interval determines freshness instead.
+   */
+  virtual size_t cacheTTL() const {
+    return 0;
+  }
 
-  /// The last interval in seconds when the table data was cached.
-  size_t last_interval_{0};
+ private:
+  /// Build the result cache key from the table name and constraint set.
+  std::string cacheKey(const QueryContext& ctx) const;
 
  public:
   /**
    * @brief The scheduled interval for the executing query.
    *
-   * Scheduled queries execute within a pseudo-mutex, and each may communicate
-   * their scheduled interval to internal TablePlugin implementations. If the
-   * table is cachable then the interval can be used to calculate freshness.
+   * Each scheduler thread sets the interval of the query it is about to run
+   * and table generation happens on that same thread, so the value is
+   * thread-local: concurrent scheduled queries cannot clobber each other's
+   * cache freshness inputs. If the table is cachable then the interval can
+   * be used to calculate freshness.
    */
-  static size_t kCacheInterval;
+  static thread_local size_t kCacheInterval;
 
   /// The schedule step, this is the current position of the schedule.
-  static size_t kCacheStep;
+  static thread_local size_t kCacheStep;
 
  public:
   /**
@@ -905,6 +1082,21 @@ class TablePlugin : public Plugin {
   /// Remove an extension's table from the SQL virtual database.
   static void removeExternal(const std::string& name);
 
+  /**
+   * @brief Retrieve the cached route (column) info of an external table.
+   *
+   * The column details of an extension table arrive with its registry
+   * broadcast and are cached when the table attaches. The SQL layer uses
+   * this copy to declare the virtual table instead of issuing a per-table
+   * columns round trip back to the extension.
+   *
+   * @param name The table name.
+   * @param response Output route info, valid only when true is returned.
+   * @return True when the name is a known external table.
+   */
+  static bool getExternalRouteInfo(const std::string& name,
+                                   PluginResponse& response);
+
  private:
   friend class RegistryFactory;
   FRIEND_TEST(VirtualTableTests, test_tableplugin_columndefinition);
@@ -928,4 +1120,49 @@ inline const std::string& columnTypeName(ColumnType type) {
 
 /// Get the column type from the string representation.
 ColumnType columnTypeName(const std::string& type);
+
+/**
+ * @brief Cumulative generate() statistics for a single table.
+ *
+ * The osquery_schedule table only reports aggregate per-query cost; when a
+ * multi-table query is slow these counters identify which table generation
+ * burned the time. Statistics cover the life of the process.
+ */
+struct TableGenerateStats {
+  /// Number of completed generate calls.
+  size_t calls{0};
+
+  /// Cumulative wall time spent generating, in microseconds.
+  uint64_t wall_time{0};
+
+  /// Cumulative CPU clock time spent generating, in microseconds.
+  uint64_t cpu_time{0};
+
+  /// Cumulative number of rows produced.
+  uint64_t rows{0};
+
+  /// Largest single result set produced, in bytes.
+  size_t peak_bytes{0};
+};
+
+/**
+ * @brief Record one completed table generation into the process-wide stats.
+ *
+ * Called by the SQL implementation after each table scan; the cost is one
+ * short lock and a few counter additions per generate.
+ */
+void recordTableGenerateStats(const std::string& name,
+                              uint64_t wall_time,
+                              uint64_t cpu_time,
+                              size_t rows,
+                              size_t bytes);
+
+/// Snapshot the per-table statistics, see the osquery_table_stats table.
+std::map<std::string, TableGenerateStats> getTableGenerateStats();
+
+/// Approximate memory held by a single row (column names and values).
+size_t rowBytes(const Row& row);
+
+/// Approximate memory held by a result set (column names and values).
+size_t queryDataBytes(const QueryData& results);
 } // namespace osquery
@@ -51,6 +51,19 @@ struct ExtensionResponse {
   2:ExtensionPluginResponse response,
 }
 
+/// One batch of rows from a chunked plugin call.
+struct ExtensionBatch {
+  1:ExtensionStatus status,
+  /// Zstd-compressed binary-serialized rows for this batch.
+  2:binary rows,
+  /// Continuation token for fetching the next batch, valid until done.
+  3:i64 token,
+  /// Set on the final batch of a call.
+  4:bool done,
+  /// When set, rows were placed in this shared-memory object instead.
+  5:string shm_path,
+}
+
 exception ExtensionException {
   1:i32 code,
   2:string message,
@@ -68,6 +81,19 @@ service Extension {
     2:string item,
     /// The thrift-equivilent of an osquery::PluginRequest.
     3:ExtensionPluginRequest request),
+  /// Call a registry plugin, transferring rows in compressed batches.
+  ExtensionBatch callChunked(
+    1:string registry,
+    2:string item,
+    3:ExtensionPluginRequest request,
+    /// Maximum rows per batch, 0 selects the server default.
+    4:i64 max_rows,
+    /// True if the caller can map shared memory from the peer's host.
+    5:bool shm),
+  /// Fetch the next batch of a chunked call.
+  ExtensionBatch callChunkedNext(
+    1:i64 token,
+    2:bool shm),
   /// Request that an extension shutdown (does not apply to managers).
   void shutdown(),
 }
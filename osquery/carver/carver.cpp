@@ -14,6 +14,11 @@
 #include <Windows.h>
 #endif
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include <boost/algorithm/string.hpp>
 
 #include <osquery/database.h>
@@ -27,6 +32,7 @@
 #include "osquery/core/hashing.h"
 #include "osquery/core/json.h"
 #include "osquery/filesystem/fileops.h"
+#include "osquery/remote/bandwidth.h"
 #include "osquery/remote/serializers/json.h"
 #include "osquery/remote/utility.h"
 
@@ -71,8 +77,17 @@ CLI_FLAG(bool,
          false,
          "Compress archives using zstd prior to upload (default false)");
 
+/// Number of carve blocks POSTed concurrently during exfiltration
+CLI_FLAG(uint32,
+         carver_parallel_uploads,
+         4,
+         "Number of carve blocks uploaded concurrently (default 4)");
+
 DECLARE_uint64(read_max);
 
+/// Number of passes made over unacknowledged blocks before giving up
+const size_t kCarverBlockMaxAttempts = 3;
+
 /// Helper function to update values related to a carve
 void updateCarveValue(const std::string& guid,
                       const std::string& key,
@@ -105,6 +120,37 @@ void updateCarveValue(const std::string& guid,
   }
 }
 
+/// Build, or restore from the database, the per-block SHA256 manifest
+static Status getBlockManifest(PlatformFile& pFile,
+                               size_t blkCount,
+                               const std::string& guid,
+                               std::vector<std::string>& hashes) {
+  std::string manifest;
+  auto s =
+      getDatabaseValue(kCarveDbDomain, kCarverManifestPrefix + guid, manifest);
+  if (s.ok()) {
+    hashes = osquery::split(manifest, ",");
+    if (hashes.size() == blkCount) {
+      return Status(0, "Ok");
+    }
+    hashes.clear();
+  }
+
+  pFile.seek(0, PF_SEEK_BEGIN);
+  std::vector<char> block(FLAGS_carver_block_size, 0);
+  for (size_t i = 0; i < blkCount; i++) {
+    auto r = pFile.read(block.data(), FLAGS_carver_block_size);
+    if (r <= 0) {
+      return Status(1, "Failed to read carve block " + std::to_string(i));
+    }
+    hashes.push_back(hashFromBuffer(
+        HashType::HASH_TYPE_SHA256, block.data(), static_cast<size_t>(r)));
+  }
+
+  return setDatabaseValue(
+      kCarveDbDomain, kCarverManifestPrefix + guid, osquery::join(hashes, ","));
+}
+
 Carver::Carver(const std::set<std::string>& paths,
                const std::string& guid,
                const std::string& requestId)
@@ -203,7 +249,7 @@ void Carver::start() {
   }
   updateCarveValue(carveGuid_, "sha256", uploadHash);
 
-  s = postCarve(uploadPath);
+  s = postCarve(uploadPath, uploadHash);
   if (!s.ok()) {
     VLOG(1) << "Failed to post carve: " << s.getMessage();
     updateCarveValue(carveGuid_, "status", "DATA POST FAILED");
@@ -219,6 +265,25 @@ Status Carver::carve(const boost::filesystem::path& path) {
     return Status(1, "Destination tmp FS is not valid.");
   }
 
+  // Prefer writing straight from a memory mapping of the source, so large
+  // files are carved without intermediate heap buffers.
+  PlatformFileMapping srcMap(src);
+  if (srcMap.isValid()) {
+    size_t offset = 0;
+    while (offset < srcMap.size()) {
+      auto len = srcMap.size() - offset;
+      if (len > FLAGS_carver_block_size) {
+        len = FLAGS_carver_block_size;
+      }
+      auto bytesWritten = dst.write(srcMap.data() + offset, len);
+      if (bytesWritten <= 0) {
+        return Status(1, "Error writing bytes to tmp fs");
+      }
+      offset += static_cast<size_t>(bytesWritten);
+    }
+    return Status(0, "Ok");
+  }
+
   auto blkCount = ceil(static_cast<double>(src.size()) /
                        static_cast<double>(FLAGS_carver_block_size));
 
@@ -237,7 +302,8 @@ Status Carver::carve(const boost::filesystem::path& path) {
   return Status(0, "Ok");
 };
 
-Status Carver::postCarve(const boost::filesystem::path& path) {
+Status Carver::postCarve(const boost::filesystem::path& path,
+                         const std::string& sha256) {
   Request<TLSTransport, JSONSerializer> startRequest(startUri_);
   startRequest.setOption("hostname", FLAGS_tls_hostname);
 
@@ -246,6 +312,14 @@ Status Carver::postCarve(const boost::filesystem::path& path) {
   auto blkCount =
       static_cast<size_t>(ceil(static_cast<double>(pFile.size()) /
                                static_cast<double>(FLAGS_carver_block_size)));
+  // The manifest lets the endpoint verify blocks individually, and survives
+  // process restarts so an interrupted carve can negotiate a resume.
+  std::vector<std::string> blockHashes;
+  auto manifest = getBlockManifest(pFile, blkCount, carveGuid_, blockHashes);
+  if (!manifest.ok()) {
+    return manifest;
+  }
+
   JSON startParams;
 
   startParams.add("block_count", blkCount);
@@ -254,6 +328,11 @@ Status Carver::postCarve(const boost::filesystem::path& path) {
   startParams.add("carve_id", carveGuid_);
   startParams.add("request_id", requestId_);
   startParams.add("node_key", getNodeKey("tls"));
+  // The archive hash ("-1" if it exceeded read_max) and block hashes let a
+  // content-addressed endpoint identify data it already holds, from this or
+  // any other host, before a single block is sent.
+  startParams.add("sha256", sha256);
+  startParams.add("block_hashes", osquery::join(blockHashes, ","));
 
   auto status = startRequest.call(startParams);
   if (!status.ok()) {
@@ -280,32 +359,162 @@ Status Carver::postCarve(const boost::filesystem::path& path) {
     return Status(1, "Empty session_id received from remote endpoint");
   }
 
-  Request<TLSTransport, JSONSerializer> contRequest(contUri_);
-  contRequest.setOption("hostname", FLAGS_tls_hostname);
+  // An endpoint with a content-addressed store may already hold an
+  // identical archive, carved from any host. Nothing needs to be sent.
+  it = startRecv.doc().FindMember("carve_exists");
+  if (it != startRecv.doc().MemberEnd() && it->value.IsBool() &&
+      it->value.GetBool()) {
+    VLOG(1) << "Carve " << carveGuid_
+            << " content already held by endpoint, skipping upload";
+    deleteDatabaseValue(kCarveDbDomain, kCarverManifestPrefix + carveGuid_);
+    updateCarveValue(carveGuid_, "status", "SUCCESS");
+    return Status(0, "Ok");
+  }
+
+  // A resuming or deduplicating endpoint may report the blocks it already
+  // holds, so the transfer only sends the missing blocks.
+  std::set<size_t> acknowledged;
+  it = startRecv.doc().FindMember("received_blocks");
+  if (it != startRecv.doc().MemberEnd() && it->value.IsString()) {
+    for (const auto& id : osquery::split(it->value.GetString(), ",")) {
+      long block_id{0};
+      if (safeStrtol(id, 10, block_id).ok() && block_id >= 0 &&
+          static_cast<size_t>(block_id) < blkCount) {
+        acknowledged.insert(static_cast<size_t>(block_id));
+      }
+    }
+  }
+
+  std::vector<size_t> remaining;
   for (size_t i = 0; i < blkCount; i++) {
-    std::vector<char> block(FLAGS_carver_block_size, 0);
-    auto r = pFile.read(block.data(), FLAGS_carver_block_size);
+    if (acknowledged.count(i) == 0) {
+      remaining.push_back(i);
+    }
+  }
 
-    if (r != FLAGS_carver_block_size && r > 0) {
-      // resize the buffer to size we read as last block is likely smaller
-      block.resize(r);
+  if (!acknowledged.empty()) {
+    VLOG(1) << "Carve " << carveGuid_ << ": endpoint already holds "
+            << acknowledged.size() << " of " << blkCount << " blocks";
+  }
+
+  /*
+   * Blocks are read and encoded on this thread into a bounded queue and
+   * POSTed by a small pool of upload workers, overlapping disk reads with
+   * the network round trips. Each block carries its block_id and SHA256,
+   * so the uploads are order-independent and individually verifiable.
+   * Blocks that fail to POST are retried on additional passes.
+   */
+  size_t attempt = 0;
+  while (!remaining.empty() && attempt++ < kCarverBlockMaxAttempts) {
+    auto uploads = static_cast<size_t>(FLAGS_carver_parallel_uploads);
+    if (uploads < 1) {
+      uploads = 1;
+    }
+    if (uploads > remaining.size()) {
+      uploads = remaining.size();
     }
 
-    JSON params;
-    params.add("block_id", i);
-    params.add("session_id", session_id);
-    params.add("request_id", requestId_);
-    params.add("data", base64Encode(std::string(block.begin(), block.end())));
-
-    // TODO: Error sending files.
-    status = contRequest.call(params);
-    if (!status.ok()) {
-      VLOG(1) << "Post of carved block " << i
-              << " failed: " << status.getMessage();
-      continue;
+    // Bound the encoded blocks held in memory while uploads are in flight.
+    const auto max_pending = uploads * 2;
+    std::vector<std::pair<size_t, std::string>> pending;
+    std::set<size_t> confirmed;
+    std::mutex pending_mutex;
+    std::condition_variable pending_cv;
+    bool reads_done = false;
+
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < uploads; t++) {
+      pool.push_back(std::thread([&]() {
+        Request<TLSTransport, JSONSerializer> contRequest(contUri_);
+        contRequest.setOption("hostname", FLAGS_tls_hostname);
+        while (true) {
+          std::pair<size_t, std::string> block;
+          {
+            std::unique_lock<std::mutex> lock(pending_mutex);
+            pending_cv.wait(lock,
+                            [&]() { return !pending.empty() || reads_done; });
+            if (pending.empty()) {
+              return;
+            }
+            block = std::move(pending.back());
+            pending.pop_back();
+          }
+          pending_cv.notify_all();
+
+          auto payload_size = block.second.size();
+
+          JSON params;
+          params.add("block_id", block.first);
+          params.add("session_id", session_id);
+          params.add("request_id", requestId_);
+          params.add("sha256", blockHashes[block.first]);
+          params.add("data", std::move(block.second));
+
+          // Pace the POST within the shared upload bandwidth ceiling.
+          UploadShaper::instance().acquire(payload_size);
+
+          auto s = contRequest.call(params);
+          if (!s.ok()) {
+            UploadShaper::instance().reportFailure();
+            VLOG(1) << "Post of carved block " << block.first
+                    << " failed: " << s.getMessage();
+            continue;
+          }
+          UploadShaper::instance().reportSuccess();
+
+          std::unique_lock<std::mutex> lock(pending_mutex);
+          confirmed.insert(block.first);
+        }
+      }));
     }
+
+    for (const auto& i : remaining) {
+      pFile.seek(static_cast<off_t>(i * FLAGS_carver_block_size),
+                 PF_SEEK_BEGIN);
+      std::vector<char> block(FLAGS_carver_block_size, 0);
+      auto r = pFile.read(block.data(), FLAGS_carver_block_size);
+
+      if (r != FLAGS_carver_block_size && r > 0) {
+        // resize the buffer to size we read as last block is likely smaller
+        block.resize(r);
+      }
+
+      auto encoded = base64Encode(std::string(block.begin(), block.end()));
+
+      std::unique_lock<std::mutex> lock(pending_mutex);
+      pending_cv.wait(lock, [&]() { return pending.size() < max_pending; });
+      pending.push_back(std::make_pair(i, std::move(encoded)));
+      lock.unlock();
+      pending_cv.notify_all();
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(pending_mutex);
+      reads_done = true;
+    }
+    pending_cv.notify_all();
+
+    for (auto& worker : pool) {
+      worker.join();
+    }
+
+    std::vector<size_t> missing;
+    for (const auto& i : remaining) {
+      if (confirmed.count(i) == 0) {
+        missing.push_back(i);
+      }
+    }
+    remaining = std::move(missing);
+  }
+
+  if (!remaining.empty()) {
+    // The manifest is kept so a later attempt can negotiate a resume.
+    return Status(1,
+                  "Failed to upload " + std::to_string(remaining.size()) +
+                      " carve blocks");
   }
 
+  deleteDatabaseValue(kCarveDbDomain, kCarverManifestPrefix + carveGuid_);
   updateCarveValue(carveGuid_, "status", "SUCCESS");
   return Status(0, "Ok");
 };
@@ -339,7 +548,9 @@ Status carvePaths(const std::set<std::string>& paths) {
     return s;
   } else {
     auto requestId = Distributed::getCurrentRequestId();
-    Dispatcher::addService(std::make_shared<Carver>(paths, guid, requestId));
+    // Carves are one-shot: run them on the shared worker pool instead of a
+    // dedicated thread per request.
+    Dispatcher::addTask(std::make_shared<Carver>(paths, guid, requestId));
   }
   return s;
 }
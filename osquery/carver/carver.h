@@ -31,6 +31,15 @@ const std::string kCarveNamePrefix = "carve_";
 /// Database prefix used to directly access and manipulate our carver entries
 const std::string kCarverDBPrefix = "carves.";
 
+/**
+ * @brief Database prefix for the per-block SHA256 manifest of a carve
+ *
+ * The manifest is stored outside of kCarverDBPrefix so the carves table
+ * enumeration does not mistake it for a carve entry. It is removed once
+ * every block of the carve has been acknowledged.
+ */
+const std::string kCarverManifestPrefix = "carves_manifest.";
+
 class Carver : public InternalRunnable {
  public:
   Carver(const std::set<std::string>& paths,
@@ -62,9 +71,13 @@ class Carver : public InternalRunnable {
    *
    * Once all of the files have been carved and the tgz has been
    * created, we POST the carved file to an endpoint specified by the
-   * carver_start_endpoint and carver_continue_endpoint
+   * carver_start_endpoint and carver_continue_endpoint. The archive
+   * SHA256 and per-block hashes are offered first, so an endpoint with
+   * a content-addressed store may skip blocks (or the whole carve) it
+   * already holds.
    */
-  Status postCarve(const boost::filesystem::path& path);
+  Status postCarve(const boost::filesystem::path& path,
+                   const std::string& sha256);
 
   // Getter for the carver status
   Status getStatus() {
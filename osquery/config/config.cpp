@@ -11,7 +11,9 @@
 #include <algorithm>
 #include <functional>
 #include <map>
+#include <set>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <boost/algorithm/string/replace.hpp>
@@ -39,8 +41,11 @@ namespace osquery {
  * This creates an osquery registry for "config" which may implement
  * ConfigPlugin. A ConfigPlugin's call API should make use of a genConfig
  * after reading JSON data in the plugin implementation.
+ *
+ * The registry is lazy: only the 'active' plugin, selected with
+ * --config_plugin, runs setUp, and only when it is activated.
  */
-CREATE_REGISTRY(ConfigPlugin, "config");
+CREATE_LAZY_REGISTRY(ConfigPlugin, "config");
 
 /**
  * @brief ConfigParser plugin registry.
@@ -61,6 +66,11 @@ CLI_FLAG(bool,
 
 CLI_FLAG(bool, config_dump, false, "Dump the contents of the configuration");
 
+CLI_FLAG(bool,
+         check_packs,
+         false,
+         "Check scheduled queries for validity and estimated cost then exit");
+
 CLI_FLAG(uint64,
          config_refresh,
          0,
@@ -76,6 +86,12 @@ FLAG_ALIAS(google::uint64,
            config_tls_accelerated_refresh,
            config_accelerated_refresh);
 
+/// Begin scheduling with a cached configuration while refreshing.
+CLI_FLAG(bool,
+         config_fast_start,
+         true,
+         "Begin with the cached configuration and refresh in the background");
+
 DECLARE_string(config_plugin);
 DECLARE_string(pack_delimiter);
 
@@ -89,6 +105,20 @@ DECLARE_string(pack_delimiter);
 const std::string kExecutingQuery{"executing_query"};
 const std::string kFailedQueries{"failed_queries"};
 
+/// Database prefix caching each source of the last-known-good configuration.
+const std::string kConfigPersistencePrefix{"config_persistence."};
+const std::string kFailedQueryCounts{"failed_query_counts"};
+const std::string kFailedQueryTimes{"failed_query_times"};
+
+/// Base number of seconds a failed query is blacklisted for.
+const size_t kBlacklistBaseDuration{86400};
+
+/// Limit for doubling the blacklist duration of a repeat offender.
+const size_t kBlacklistMaxEscalations{4};
+
+/// Seconds of failure-free time that forgives one recorded failure.
+const size_t kBlacklistDecayInterval{604800};
+
 /// The time osquery was started.
 std::atomic<size_t> kStartTime;
 
@@ -98,8 +128,15 @@ Mutex config_refresh_mutex_;
 
 /// Several config methods require enumeration via predicate lambdas.
 RecursiveMutex config_schedule_mutex_;
-RecursiveMutex config_files_mutex_;
-RecursiveMutex config_performance_mutex_;
+
+/// The file and performance maps are read often and written rarely; shared
+/// locks let concurrent readers proceed without queueing behind each other.
+Mutex config_files_mutex_;
+Mutex config_performance_mutex_;
+
+/// Number of queries on post-blacklist probation. Probation is rare; the
+/// counter lets every query completion skip the schedule lock when zero.
+std::atomic<size_t> kProbationCount{0};
 
 using PackRef = std::unique_ptr<Pack>;
 
@@ -175,6 +212,16 @@ class Schedule : private boost::noncopyable {
    */
   std::map<std::string, size_t> blacklist_;
 
+  /**
+   * @brief Queries running on probation after a blacklist expired.
+   *
+   * An expired blacklist entry does not clear the query's failure profile;
+   * the first execution after expiry is a probation run. Completing it
+   * cleanly forgives half of the recorded failures so the next blacklist
+   * duration shrinks instead of escalating.
+   */
+  std::set<std::string> probation_;
+
  private:
   friend class Config;
 };
@@ -255,6 +302,16 @@ class ConfigRefreshRunner : public InternalRunnable {
   friend class Config;
 };
 
+/// A one-shot task revalidating a cached configuration in the background.
+class ConfigRefreshTask : public InternalRunnable {
+ public:
+  ConfigRefreshTask() : InternalRunnable("ConfigRefreshTask") {}
+
+  void start() override {
+    Config::get().refresh();
+  }
+};
+
 void restoreScheduleBlacklist(std::map<std::string, size_t>& blacklist) {
   std::string content;
   getDatabaseValue(kPersistentSettings, kFailedQueries, content);
@@ -286,6 +343,94 @@ void saveScheduleBlacklist(const std::map<std::string, size_t>& blacklist) {
   setDatabaseValue(kPersistentSettings, kFailedQueries, content);
 }
 
+/// Restore a query-name/counter map persisted under the given key.
+static void restoreQueryNameCounters(const std::string& key,
+                                     std::map<std::string, size_t>& values) {
+  std::string content;
+  getDatabaseValue(kPersistentSettings, key, content);
+  auto count_pairs = osquery::split(content, ":");
+  if (count_pairs.size() == 0 || count_pairs.size() % 2 != 0) {
+    // No persisted content, or malformed data.
+    return;
+  }
+
+  for (size_t i = 0; i < count_pairs.size() / 2; i++) {
+    // Fill in a mapping of query name to the persisted counter.
+    long long count = 0;
+    safeStrtoll(count_pairs[(i * 2) + 1], 10, count);
+    if (count > 0) {
+      values[count_pairs[(i * 2)]] = (size_t)count;
+    }
+  }
+}
+
+/// Persist a query-name/counter map under the given key.
+static void saveQueryNameCounters(const std::string& key,
+                                  const std::map<std::string, size_t>& values) {
+  std::string content;
+  for (const auto& query : values) {
+    if (!content.empty()) {
+      content += ":";
+    }
+    content += query.first + ":" + std::to_string(query.second);
+  }
+  setDatabaseValue(kPersistentSettings, key, content);
+}
+
+void restoreFailedQueryCounts(std::map<std::string, size_t>& counts) {
+  restoreQueryNameCounters(kFailedQueryCounts, counts);
+}
+
+void saveFailedQueryCounts(const std::map<std::string, size_t>& counts) {
+  saveQueryNameCounters(kFailedQueryCounts, counts);
+}
+
+void restoreFailedQueryTimes(std::map<std::string, size_t>& times) {
+  restoreQueryNameCounters(kFailedQueryTimes, times);
+}
+
+void saveFailedQueryTimes(const std::map<std::string, size_t>& times) {
+  saveQueryNameCounters(kFailedQueryTimes, times);
+}
+
+void decayFailedQueryCounts(std::map<std::string, size_t>& counts,
+                            std::map<std::string, size_t>& times) {
+  // Forgive one recorded failure for each full decay interval a query has
+  // stayed clean, so a transient problem does not escalate bans forever.
+  auto now = getUnixTime();
+  for (auto it = counts.begin(); it != counts.end();) {
+    size_t since = 0;
+    auto last = times.find(it->first);
+    if (last != times.end() && last->second < now) {
+      since = now - last->second;
+    }
+    auto forgiven = since / kBlacklistDecayInterval;
+    if (forgiven >= it->second) {
+      if (last != times.end()) {
+        times.erase(last);
+      }
+      it = counts.erase(it);
+    } else {
+      if (forgiven > 0) {
+        // Advance the failure time so the same interval is not forgiven
+        // again by a later decay pass.
+        it->second -= forgiven;
+        last->second += forgiven * kBlacklistDecayInterval;
+      }
+      ++it;
+    }
+  }
+}
+
+size_t getBlacklistDuration(size_t failure_count) {
+  // Each repeated failure doubles the blacklist duration, up to a limit.
+  if (failure_count == 0) {
+    return kBlacklistBaseDuration;
+  }
+  auto escalations = std::min(failure_count - 1, kBlacklistMaxEscalations);
+  return kBlacklistBaseDuration << escalations;
+}
+
 Schedule::Schedule() {
   if (RegistryFactory::get().external()) {
     // Extensions should not restore or save schedule details.
@@ -299,8 +444,25 @@ Schedule::Schedule() {
   if (!failed_query_.empty()) {
     LOG(WARNING) << "Scheduled query may have failed: " << failed_query_;
     setDatabaseValue(kPersistentSettings, kExecutingQuery, "");
+
+    // Update the persisted failure profile for the offending query. Repeat
+    // offenders are blacklisted for progressively longer durations so only
+    // this query is denied, rather than churning the whole worker. Old
+    // failures decay away first, so a query that has been clean for weeks
+    // restarts near the base duration instead of the escalation ceiling.
+    std::map<std::string, size_t> counts;
+    std::map<std::string, size_t> times;
+    restoreFailedQueryCounts(counts);
+    restoreFailedQueryTimes(times);
+    decayFailedQueryCounts(counts, times);
+    counts[failed_query_] += 1;
+    times[failed_query_] = getUnixTime();
+    saveFailedQueryCounts(counts);
+    saveFailedQueryTimes(times);
+
     // Add this query name to the blacklist and save the blacklist.
-    blacklist_[failed_query_] = getUnixTime() + 86400;
+    blacklist_[failed_query_] =
+        getUnixTime() + getBlacklistDuration(counts[failed_query_]);
     saveScheduleBlacklist(blacklist_);
   }
 }
@@ -324,6 +486,16 @@ void Config::addPack(const std::string& name,
                                         const rj::Value& pack_obj) {
     RecursiveLock wlock(config_schedule_mutex_);
     try {
+      std::string content;
+      auto doc = JSON::newFromValue(pack_obj);
+      doc.toString(content);
+      if (!hashPack(source, pack_name, content) &&
+          packExists(pack_name, source)) {
+        // The pack content did not change, keep the scheduled Pack (and its
+        // statistics) instead of rebuilding it.
+        return;
+      }
+
       schedule_->add(std::make_unique<Pack>(pack_name, source, pack_obj));
       if (schedule_->last()->shouldPackExecute()) {
         applyParsers(source + FLAGS_pack_delimiter + pack_name, pack_obj, true);
@@ -358,15 +530,22 @@ void Config::removePack(const std::string& pack) {
   return schedule_->remove(pack);
 }
 
+void Config::invalidatePackDiscovery() {
+  RecursiveLock wlock(config_schedule_mutex_);
+  for (const auto& pack : schedule_->packs_) {
+    pack->invalidateDiscovery();
+  }
+}
+
 void Config::addFile(const std::string& source,
                      const std::string& category,
                      const std::string& path) {
-  RecursiveLock wlock(config_files_mutex_);
+  WriteLock wlock(config_files_mutex_);
   files_[source][category].push_back(path);
 }
 
 void Config::removeFiles(const std::string& source) {
-  RecursiveLock wlock(config_files_mutex_);
+  WriteLock wlock(config_files_mutex_);
   if (files_.count(source)) {
     FileCategories().swap(files_[source]);
   }
@@ -400,38 +579,54 @@ void Config::scheduledQueries(
     std::function<void(std::string name, const ScheduledQuery& query)>
         predicate,
     bool blacklisted) const {
-  RecursiveLock lock(config_schedule_mutex_);
-  for (PackRef& pack : *schedule_) {
-    for (auto& it : pack->getSchedule()) {
-      std::string name = it.first;
-      // The query name may be synthetic.
-      if (pack->getName() != "main" && pack->getName() != "legacy_main") {
-        name = "pack" + FLAGS_pack_delimiter + pack->getName() +
-               FLAGS_pack_delimiter + it.first;
-      }
+  // Snapshot the schedule under the lock, then invoke the predicate on the
+  // copies. The scheduler executes queries from within its predicate, and
+  // holding the schedule lock for the duration of a query would block a
+  // config refresh and every other config reader behind it.
+  std::vector<std::pair<std::string, ScheduledQuery>> snapshot;
+  {
+    RecursiveLock lock(config_schedule_mutex_);
+    for (PackRef& pack : *schedule_) {
+      for (auto& it : pack->getSchedule()) {
+        std::string name = it.first;
+        // The query name may be synthetic.
+        if (pack->getName() != "main" && pack->getName() != "legacy_main") {
+          name = "pack" + FLAGS_pack_delimiter + pack->getName() +
+                 FLAGS_pack_delimiter + it.first;
+        }
 
-      // They query may have failed and been added to the schedule's blacklist.
-      auto blacklisted_query = schedule_->blacklist_.find(name);
-      if (blacklisted_query != schedule_->blacklist_.end()) {
-        if (blacklistExpired(blacklisted_query->second, it.second)) {
-          // The blacklisted query passed the expiration time (remove).
-          schedule_->blacklist_.erase(blacklisted_query);
-          saveScheduleBlacklist(schedule_->blacklist_);
-          it.second.blacklisted = false;
-        } else {
-          // The query is still blacklisted.
-          it.second.blacklisted = true;
-          if (!blacklisted) {
-            // The caller does not want blacklisted queries.
-            continue;
+        // They query may have failed and been added to the schedule's
+        // blacklist.
+        auto blacklisted_query = schedule_->blacklist_.find(name);
+        if (blacklisted_query != schedule_->blacklist_.end()) {
+          if (blacklistExpired(blacklisted_query->second, it.second)) {
+            // The blacklisted query passed the expiration time (remove).
+            // The next clean execution decays its failure profile.
+            schedule_->blacklist_.erase(blacklisted_query);
+            saveScheduleBlacklist(schedule_->blacklist_);
+            if (schedule_->probation_.insert(name).second) {
+              kProbationCount++;
+            }
+            it.second.blacklisted = false;
+          } else {
+            // The query is still blacklisted.
+            it.second.blacklisted = true;
+            if (!blacklisted) {
+              // The caller does not want blacklisted queries.
+              continue;
+            }
           }
         }
-      }
 
-      // Call the predicate.
-      predicate(std::move(name), it.second);
+        snapshot.emplace_back(std::move(name), it.second.clone());
+      }
     }
   }
+
+  // Call the predicate for each snapshotted entry, lock-free.
+  for (auto& entry : snapshot) {
+    predicate(std::move(entry.first), entry.second);
+  }
 }
 
 void Config::packs(std::function<void(const Pack& pack)> predicate) const {
@@ -512,9 +707,47 @@ Status Config::load() {
     started_thread_ = true;
   }
 
+  if (FLAGS_config_fast_start && !FLAGS_config_check && !FLAGS_config_dump &&
+      getRefresh() > 0) {
+    // Stale-while-revalidate: schedule the last-known-good configuration now
+    // and let the plugin fetch (including a possible enrollment) happen in
+    // the background, so a slow endpoint does not delay the first query.
+    if (restoreCachedConfig().ok()) {
+      VLOG(1) << "Starting with the cached configuration, refreshing in the "
+                 "background";
+      Dispatcher::addTask(std::make_shared<ConfigRefreshTask>());
+      return Status(0, "OK");
+    }
+  }
+
   return refresh();
 }
 
+Status Config::restoreCachedConfig() {
+  std::vector<std::string> keys;
+  scanDatabaseKeys(kPersistentSettings, keys, kConfigPersistencePrefix, 0);
+
+  std::map<std::string, std::string> cached;
+  for (const auto& key : keys) {
+    std::string value;
+    if (getDatabaseValue(kPersistentSettings, key, value).ok() &&
+        !value.empty()) {
+      cached[key.substr(kConfigPersistencePrefix.size())] = value;
+    }
+  }
+
+  if (cached.empty()) {
+    return Status(1, "No cached configuration");
+  }
+
+  auto status = update(cached);
+  if (status.ok()) {
+    valid_ = true;
+    loaded_ = true;
+  }
+  return status;
+}
+
 void stripConfigComments(std::string& json) {
   std::string sink;
 
@@ -541,23 +774,31 @@ Status Config::updateSource(const std::string& source,
     return Status(2);
   }
 
-  {
-    RecursiveLock lock(config_schedule_mutex_);
-    // Remove all packs from this source.
-    schedule_->removeAll(source);
-    // Remove all files from this source.
-    removeFiles(source);
-  }
-
-  // load the config (source.second) into a JSON object.
+  // Stage the content into an isolated candidate document before touching
+  // state derived from this source. A malformed source is rejected here and
+  // whatever content this source last applied keeps running.
   auto doc = JSON::newObject();
   auto clone = json;
   stripConfigComments(clone);
 
-  if (!doc.fromString(clone) || !doc.doc().IsObject()) {
+  if (!doc.fromMutableString(std::move(clone)) || !doc.doc().IsObject()) {
+    // Forget the content hash so the next refresh re-parses this source.
+    WriteLock wlock(config_hash_mutex_);
+    hash_.erase(source);
     return Status(1, "Error parsing the config JSON");
   }
 
+  {
+    RecursiveLock lock(config_schedule_mutex_);
+    // Remove all files from this source, parsers will re-add them.
+    removeFiles(source);
+  }
+
+  // Track the pack names this content provides; packs previously created by
+  // this source but no longer named are removed after the differential pass.
+  std::set<std::string> retain;
+  bool wildcard = false;
+
   // extract the "schedule" key and store it as the main pack
   auto& rf = RegistryFactory::get();
   if (doc.doc().HasMember("schedule") && !rf.external()) {
@@ -567,6 +808,7 @@ Status Config::updateSource(const std::string& source,
       auto queries_obj = main_doc.getObject();
       main_doc.copyFrom(schedule, queries_obj);
       main_doc.add("queries", queries_obj);
+      retain.insert("main");
       addPack("main", source, main_doc.doc());
     }
   }
@@ -588,12 +830,15 @@ Status Config::updateSource(const std::string& source,
           query_name = query["name"].GetString();
         }
         if (query_name.empty()) {
-          return Status(1, "Error getting name from legacy scheduled query");
+          // An unnamed entry only invalidates itself, not the source.
+          LOG(WARNING) << "Error getting name from legacy scheduled query";
+          continue;
         }
         queries_doc.add(query_name, query, queries_obj);
       }
 
       queries_doc.add("queries", queries_obj);
+      retain.insert("legacy_main");
       addPack("legacy_main", source, queries_doc.doc());
     }
   }
@@ -604,6 +849,11 @@ Status Config::updateSource(const std::string& source,
     if (packs.IsObject()) {
       for (const auto& pack : packs.GetObject()) {
         std::string pack_name = pack.name.GetString();
+        if (pack_name == "*") {
+          // A multi-pack expands to names unknown to this source pass.
+          wildcard = true;
+        }
+        retain.insert(pack_name);
         if (pack.value.IsObject()) {
           // The pack is a JSON object, treat the content as pack data.
           addPack(pack_name, source, pack.value);
@@ -614,6 +864,21 @@ Status Config::updateSource(const std::string& source,
     }
   }
 
+  // Remove this source's packs that the new content no longer names. The
+  // multi-pack hides its expanded names, skip the sweep in that case.
+  if (!wildcard) {
+    RecursiveLock lock(config_schedule_mutex_);
+    std::vector<std::string> stale;
+    for (const auto& pack : schedule_->packs_) {
+      if (pack->getSource() == source && retain.count(pack->getName()) == 0) {
+        stale.push_back(pack->getName());
+      }
+    }
+    for (const auto& pack_name : stale) {
+      schedule_->remove(pack_name, source);
+    }
+  }
+
   applyParsers(source, doc.doc(), false);
   return Status();
 }
@@ -640,7 +905,7 @@ Status Config::genPack(const std::string& name,
 
   stripConfigComments(clone);
   auto doc = JSON::newObject();
-  if (!doc.fromString(clone) || !doc.doc().IsObject()) {
+  if (!doc.fromMutableString(std::move(clone)) || !doc.doc().IsObject()) {
     LOG(WARNING) << "Error parsing the \"" << name << "\" pack JSON";
   } else {
     addPack(name, source, doc.doc());
@@ -654,8 +919,12 @@ void Config::applyParsers(const std::string& source,
                           bool pack) {
   assert(obj.IsObject());
 
-  // Iterate each parser.
-  RecursiveLock lock(config_schedule_mutex_);
+  // Collect each parser and copy out its requested keys. The deep JSON
+  // copies and parser updates do not touch the schedule, so they run
+  // without the schedule lock; parsers guard their own state and use the
+  // finer-grained config mutexes (such as the files mutex) for shared state.
+  std::vector<std::shared_ptr<ConfigParserPlugin>> parsers;
+  std::vector<std::map<std::string, JSON>> parser_configs;
   for (const auto& plugin : RegistryFactory::get().plugins("config_parser")) {
     std::shared_ptr<ConfigParserPlugin> parser = nullptr;
     try {
@@ -681,10 +950,23 @@ void Config::applyParsers(const std::string& source,
         parser_config.emplace(std::make_pair(key, std::move(doc)));
       }
     }
-    // The config parser plugin will receive a copy of each property tree for
-    // each top-level-config key. The parser may choose to update the config's
-    // internal state
-    parser->update(source, parser_config);
+
+    parsers.push_back(parser);
+    parser_configs.push_back(std::move(parser_config));
+  }
+
+  // The config parser plugins each receive a copy of each property tree for
+  // their top-level-config keys and may update the config's internal state.
+  // The parsers are independent of one another, so the updates dispatch
+  // concurrently and one slow parser does not serialize the refresh.
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < parsers.size(); i++) {
+    threads.emplace_back([&parsers, &parser_configs, &source, i]() {
+      parsers[i]->update(source, parser_configs[i]);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
   }
 }
 
@@ -717,6 +999,7 @@ Status Config::update(const std::map<std::string, std::string>& config) {
   purge();
 
   bool needs_reconfigure = false;
+  Status failure;
   for (const auto& source : config) {
     auto status = updateSource(source.first, source.second);
     if (status.getCode() == 2) {
@@ -725,12 +1008,25 @@ Status Config::update(const std::map<std::string, std::string>& config) {
     }
 
     if (!status.ok()) {
-      // The content was not parsed correctly.
-      return status;
+      // The content was not parsed correctly. The source keeps its previous
+      // state and is retried at the next refresh; the remaining sources
+      // still apply so one broken pack does not stall the whole schedule.
+      LOG(WARNING) << "Error applying config source " << source.first << ": "
+                   << status.getMessage();
+      failure = status;
+      continue;
     }
     // If a source was updated and the content has changed, then the registry
     // should be reconfigured. File watches may have changed, etc.
     needs_reconfigure = true;
+
+    // Cache the last-known-good content so a later startup can begin
+    // scheduling before the config plugin responds.
+    if (!RegistryFactory::get().external()) {
+      setDatabaseValue(kPersistentSettings,
+                       kConfigPersistencePrefix + source.first,
+                       source.second);
+    }
   }
 
   if (loaded_ && needs_reconfigure) {
@@ -762,7 +1058,8 @@ Status Config::update(const std::map<std::string, std::string>& config) {
     }
   }
 
-  return Status(0, "OK");
+  // Report the first per-source failure after the valid sources applied.
+  return failure;
 }
 
 void Config::purge() {
@@ -813,8 +1110,12 @@ void Config::purge() {
       // Query has not run in the last week, expire results and interval.
       deleteDatabaseValue(kQueries, saved_query);
       deleteDatabaseValue(kQueries, saved_query + "epoch");
+      deleteDatabaseValue(kQueries, saved_query + "hashes");
+      clearQueryRowHashCache(saved_query);
       deleteDatabaseValue(kPersistentSettings, "interval." + saved_query);
       deleteDatabaseValue(kPersistentSettings, "timestamp." + saved_query);
+      deleteDatabaseValue(kPersistentSettings, "histogram." + saved_query);
+      deleteDatabaseValue(kPerformance, saved_query);
       VLOG(1) << "Expiring results for scheduled query: " << saved_query;
     }
   }
@@ -824,9 +1125,11 @@ void Config::reset() {
   setStartTime(getUnixTime());
 
   schedule_ = std::make_unique<Schedule>();
+  kProbationCount = 0;
   std::map<std::string, QueryPerformance>().swap(performance_);
   std::map<std::string, FileCategories>().swap(files_);
   std::map<std::string, std::string>().swap(hash_);
+  std::map<std::string, std::string>().swap(pack_hash_);
   valid_ = false;
   loaded_ = false;
 
@@ -861,44 +1164,117 @@ void Config::recordQueryPerformance(const std::string& name,
                                     size_t size,
                                     const Row& r0,
                                     const Row& r1) {
-  RecursiveLock lock(config_performance_mutex_);
-  if (performance_.count(name) == 0) {
-    performance_[name] = QueryPerformance();
+  // A clean completion ends any post-blacklist probation and forgives half
+  // of the recorded failures, shrinking the next blacklist duration instead
+  // of escalating it. Probation is rare, so the counter check lets every
+  // completion skip the schedule lock (and any in-flight config refresh
+  // holding it) unless a probation run could actually be ending.
+  if (kProbationCount.load() > 0) {
+    RecursiveLock lock(config_schedule_mutex_);
+    auto probation = schedule_->probation_.find(name);
+    if (probation != schedule_->probation_.end()) {
+      schedule_->probation_.erase(probation);
+      kProbationCount--;
+      std::map<std::string, size_t> counts;
+      restoreFailedQueryCounts(counts);
+      auto count = counts.find(name);
+      if (count != counts.end()) {
+        count->second /= 2;
+        if (count->second == 0) {
+          counts.erase(count);
+        }
+        saveFailedQueryCounts(counts);
+      }
+    }
   }
 
-  // Grab access to the non-const schedule item.
-  auto& query = performance_.at(name);
-  BIGINT_LITERAL diff = 0;
-  if (!r1.at("user_time").empty() && !r0.at("user_time").empty()) {
-    diff = AS_LITERAL(BIGINT_LITERAL, r1.at("user_time")) -
-           AS_LITERAL(BIGINT_LITERAL, r0.at("user_time"));
-    if (diff > 0) {
-      query.user_time += diff;
+  // Restore the counters checkpointed by previous agent runs before taking
+  // the performance lock; performance history survives config refreshes and
+  // restarts, but the database reads must not extend a critical section
+  // shared by every scheduler thread.
+  bool restore = false;
+  {
+    ReadLock rlock(config_performance_mutex_);
+    restore = (performance_.count(name) == 0);
+  }
+
+  QueryPerformance initial;
+  if (restore) {
+    std::string encoded;
+    getDatabaseValue(kPerformance, name, encoded);
+    if (!encoded.empty()) {
+      initial.deserialize(encoded);
+    } else {
+      // Fall back to the legacy histogram-only record.
+      getDatabaseValue(kPersistentSettings, "histogram." + name, encoded);
+      auto split = encoded.find(';');
+      if (split != std::string::npos) {
+        initial.wall_time_hist.deserialize(encoded.substr(0, split));
+        initial.memory_hist.deserialize(encoded.substr(split + 1));
+      }
     }
   }
 
+  // Parse the process snapshot deltas before locking too; the critical
+  // section below is pure counter arithmetic.
+  BIGINT_LITERAL user_diff = 0, system_diff = 0, memory_diff = 0;
+  bool has_memory = false;
+  if (!r1.at("user_time").empty() && !r0.at("user_time").empty()) {
+    user_diff = AS_LITERAL(BIGINT_LITERAL, r1.at("user_time")) -
+                AS_LITERAL(BIGINT_LITERAL, r0.at("user_time"));
+  }
+
   if (!r1.at("system_time").empty() && !r0.at("system_time").empty()) {
-    diff = AS_LITERAL(BIGINT_LITERAL, r1.at("system_time")) -
-           AS_LITERAL(BIGINT_LITERAL, r0.at("system_time"));
-    if (diff > 0) {
-      query.system_time += diff;
-    }
+    system_diff = AS_LITERAL(BIGINT_LITERAL, r1.at("system_time")) -
+                  AS_LITERAL(BIGINT_LITERAL, r0.at("system_time"));
   }
 
   if (!r1.at("resident_size").empty() && !r0.at("resident_size").empty()) {
-    diff = AS_LITERAL(BIGINT_LITERAL, r1.at("resident_size")) -
-           AS_LITERAL(BIGINT_LITERAL, r0.at("resident_size"));
-    if (diff > 0) {
-      // Memory is stored as an average of RSS changes between query executions.
-      query.average_memory = (query.average_memory * query.executions) + diff;
-      query.average_memory = (query.average_memory / (query.executions + 1));
+    memory_diff = AS_LITERAL(BIGINT_LITERAL, r1.at("resident_size")) -
+                  AS_LITERAL(BIGINT_LITERAL, r0.at("resident_size"));
+    has_memory = true;
+  }
+
+  QueryPerformance snapshot;
+  {
+    WriteLock lock(config_performance_mutex_);
+    if (restore && performance_.count(name) == 0) {
+      // Another thread may have raced the restore; first insert wins.
+      performance_[name] = initial;
+    }
+
+    // Grab access to the non-const schedule item.
+    auto& query = performance_[name];
+    if (user_diff > 0) {
+      query.user_time += user_diff;
+    }
+
+    if (system_diff > 0) {
+      query.system_time += system_diff;
     }
+
+    if (has_memory) {
+      if (memory_diff > 0) {
+        // Memory is stored as an average of RSS changes between executions.
+        query.average_memory =
+            (query.average_memory * query.executions) + memory_diff;
+        query.average_memory = (query.average_memory / (query.executions + 1));
+      }
+      query.memory_hist.add((memory_diff > 0) ? memory_diff : 0);
+    }
+
+    query.wall_time += delay;
+    query.wall_time_hist.add(delay);
+    query.output_size += size;
+    query.executions += 1;
+    query.last_executed = getUnixTime();
+    snapshot = query;
   }
 
-  query.wall_time += delay;
-  query.output_size += size;
-  query.executions += 1;
-  query.last_executed = getUnixTime();
+  // Checkpoint this query's updated counters: one delta write per completed
+  // run, never a serialization of the whole schedule. The serialization and
+  // database write happen on a copy, outside the lock.
+  setDatabaseValue(kPerformance, name, snapshot.serialize());
 
   // Clear the executing query (remove the dirty bit).
   setDatabaseValue(kPersistentSettings, kExecutingQuery, "");
@@ -918,8 +1294,8 @@ void Config::recordQueryStart(const std::string& name) {
 void Config::getPerformanceStats(
     const std::string& name,
     std::function<void(const QueryPerformance& query)> predicate) const {
+  ReadLock lock(config_performance_mutex_);
   if (performance_.count(name) > 0) {
-    RecursiveLock lock(config_performance_mutex_);
     predicate(performance_.at(name));
   }
 }
@@ -935,6 +1311,31 @@ bool Config::hashSource(const std::string& source, const std::string& content) {
   return true;
 }
 
+bool Config::hashPack(const std::string& source,
+                      const std::string& name,
+                      const std::string& content) {
+  auto new_hash = getBufferSHA1(content.c_str(), content.size());
+
+  WriteLock wlock(config_hash_mutex_);
+  auto& pack_hash = pack_hash_[source + FLAGS_pack_delimiter + name];
+  if (pack_hash == new_hash) {
+    return false;
+  }
+  pack_hash = new_hash;
+  return true;
+}
+
+bool Config::packExists(const std::string& name,
+                        const std::string& source) const {
+  RecursiveLock lock(config_schedule_mutex_);
+  for (const auto& pack : schedule_->packs_) {
+    if (pack->getName() == name && pack->getSource() == source) {
+      return true;
+    }
+  }
+  return false;
+}
+
 Status Config::genHash(std::string& hash) const {
   WriteLock lock(config_hash_mutex_);
   if (!valid_) {
@@ -978,7 +1379,7 @@ const std::shared_ptr<ConfigParserPlugin> Config::getParser(
 void Config::files(std::function<void(const std::string& category,
                                       const std::vector<std::string>& files)>
                        predicate) const {
-  RecursiveLock lock(config_files_mutex_);
+  ReadLock lock(config_files_mutex_);
   for (const auto& it : files_) {
     for (const auto& category : it.second) {
       predicate(category.first, category.second);
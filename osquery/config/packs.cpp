@@ -9,14 +9,18 @@
  */
 
 #include <algorithm>
+#include <chrono>
 #include <random>
 
+#include <osquery/config.h>
 #include <osquery/core.h>
 #include <osquery/database.h>
 #include <osquery/logger.h>
 #include <osquery/packs.h>
+#include <osquery/registry.h>
 #include <osquery/sql.h>
 #include <osquery/system.h>
+#include <osquery/tables.h>
 
 #include "osquery/core/conversions.h"
 #include "osquery/core/json.h"
@@ -34,6 +38,11 @@ FLAG(string, pack_delimiter, "_", "Delimiter for pack and query names");
 
 FLAG(uint64, schedule_splay_percent, 10, "Percent to splay config times");
 
+FLAG(bool,
+     schedule_splay_phase,
+     true,
+     "Offset each query within its interval to level scheduler load");
+
 FLAG(uint64,
      schedule_default_interval,
      3600,
@@ -108,6 +117,24 @@ size_t restoreSplayedValue(const std::string& name, size_t interval) {
   return splay;
 }
 
+size_t computeQueryPhase(const std::string& name, size_t interval) {
+  if (!FLAGS_schedule_splay_phase || interval <= 1) {
+    return 0;
+  }
+
+  // Seed from the host identity so the same query lands on different ticks
+  // across a fleet, and from the query name so same-interval queries spread
+  // within a host.
+  auto seed = getHostIdentifier() + FLAGS_pack_delimiter + name;
+  auto seed_hash = getBufferSHA1(seed.c_str(), seed.size());
+
+  long phase = 0;
+  if (seed_hash.size() < 7 || !safeStrtol(seed_hash.substr(0, 7), 16, phase)) {
+    return 0;
+  }
+  return static_cast<size_t>(phase) % interval;
+}
+
 void Pack::initialize(const std::string& name,
                       const std::string& source,
                       const rj::Value& obj) {
@@ -145,6 +172,13 @@ void Pack::initialize(const std::string& name,
     }
   }
 
+  // A pack may override the global discovery TTL, for example when its
+  // discovery queries are expensive or its target state is short-lived.
+  discovery_interval_ = 0;
+  if (obj.HasMember("discovery_interval")) {
+    discovery_interval_ = JSON::valueToSize(obj["discovery_interval"]);
+  }
+
   // Initialize a discovery cache at time 0.
   discovery_cache_ = std::make_pair<size_t, bool>(0, false);
   valid_ = true;
@@ -209,6 +243,7 @@ void Pack::initialize(const std::string& name,
 
     query.splayed_interval =
         restoreSplayedValue(q.name.GetString(), query.interval);
+    query.phase = computeQueryPhase(q.name.GetString(), query.splayed_interval);
 
     if (!q.value.HasMember("snapshot")) {
       query.options["snapshot"] = false;
@@ -227,6 +262,28 @@ void Pack::initialize(const std::string& name,
       query.options["blacklist"] = JSON::valueToBool(q.value["blacklist"]);
     }
 
+    // Background queries execute on a low-priority scheduler lane so heavy
+    // collection jobs stay below the watchdog limits instead of respawning.
+    query.options["background"] = false;
+    if (q.value.HasMember("background")) {
+      query.options["background"] = JSON::valueToBool(q.value["background"]);
+    }
+
+    // Snapshot queries may request a uniform row sample instead of the
+    // complete result, see ScheduledQuery::sample_rows.
+    if (q.value.HasMember("sample_rows")) {
+      query.sample_rows = JSON::valueToSize(q.value["sample_rows"]);
+    }
+
+    // Change-detection queries may bind to event publishers and execute
+    // when a relevant event fires, see ScheduledQuery::trigger.
+    if (q.value.HasMember("trigger") && q.value["trigger"].IsString()) {
+      query.trigger = q.value["trigger"].GetString();
+    }
+    if (q.value.HasMember("trigger_debounce")) {
+      query.trigger_debounce = JSON::valueToSize(q.value["trigger_debounce"]);
+    }
+
     schedule_.emplace(std::make_pair(q.name.GetString(), std::move(query)));
   }
 }
@@ -295,7 +352,9 @@ bool Pack::checkVersion(const std::string& version) const {
 bool Pack::checkDiscovery() {
   stats_.total++;
   size_t current = osquery::getUnixTime();
-  if ((current - discovery_cache_.first) < FLAGS_pack_refresh_interval) {
+  auto ttl = (discovery_interval_ > 0) ? discovery_interval_
+                                       : FLAGS_pack_refresh_interval;
+  if ((current - discovery_cache_.first) < ttl) {
     stats_.hits++;
     return discovery_cache_.second;
   }
@@ -303,6 +362,7 @@ bool Pack::checkDiscovery() {
   stats_.misses++;
   discovery_cache_.first = current;
   discovery_cache_.second = true;
+  auto started = std::chrono::steady_clock::now();
   for (const auto& q : discovery_queries_) {
     SQL results(q);
     if (!results.ok()) {
@@ -316,10 +376,161 @@ bool Pack::checkDiscovery() {
       break;
     }
   }
+
+  // Surface the discovery execution cost through the pack statistics.
+  stats_.discovery_wall_time_ms +=
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - started)
+          .count();
+  stats_.last_discovery_time = current;
   return discovery_cache_.second;
 }
 
+void Pack::invalidateDiscovery() {
+  // Age the cache so the next check re-runs the discovery queries.
+  discovery_cache_.first = 0;
+}
+
 bool Pack::isActive() const {
   return active_;
 }
+
+/// Collect a table's declared attributes and required-column state.
+static void tableMetadata(const std::string& table,
+                          size_t& attributes,
+                          bool& has_required) {
+  attributes = 0;
+  has_required = false;
+
+  PluginResponse response;
+  auto status =
+      Registry::call("table", table, {{"action", "columns"}}, response);
+  if (!status.ok()) {
+    return;
+  }
+
+  for (const auto& row : response) {
+    if (row.count("id") == 0) {
+      continue;
+    }
+    unsigned long value = 0;
+    if (row.at("id") == "attributes" && row.count("attributes") > 0) {
+      safeStrtoul(row.at("attributes"), 10, value);
+      attributes = value;
+    } else if (row.at("id") == "column" && row.count("op") > 0) {
+      safeStrtoul(row.at("op"), 10, value);
+      if ((value & static_cast<unsigned long>(ColumnOptions::REQUIRED)) > 0) {
+        has_required = true;
+      }
+    }
+  }
+}
+
+Status checkQueryPacks() {
+  auto doc = JSON::newObject();
+  auto queries = doc.getObject();
+  size_t issue_count = 0;
+
+  Config::get().scheduledQueries(
+      ([&doc, &queries, &issue_count](std::string name,
+                                      const ScheduledQuery& query) {
+        auto report = doc.getObject();
+        doc.addCopy("query", query.query, report);
+        doc.add("interval", query.interval, report);
+
+        auto issues = doc.getArray();
+        auto tables = doc.getArray();
+        std::string cost = "low";
+
+        TableColumns columns;
+        auto status = getQueryColumns(query.query, columns);
+        doc.add("valid", status.ok(), report);
+        if (!status.ok()) {
+          doc.pushCopy("query failed to compile: " + status.getMessage(),
+                       issues);
+          cost = "invalid";
+          issue_count++;
+        } else {
+          // Ask SQLite for the chosen plan. The xBestIndex implementation
+          // labels each virtual table scan with its constraint class, so the
+          // plan text tells a pushed-down predicate from a full generation.
+          size_t unconstrained = 0;
+          SQL plan("EXPLAIN QUERY PLAN " + query.query);
+          for (const auto& row : plan.rows()) {
+            if (row.count("detail") == 0) {
+              continue;
+            }
+
+            const auto& detail = row.at("detail");
+            auto start = detail.find("SCAN TABLE ");
+            if (start == std::string::npos ||
+                detail.find("VIRTUAL TABLE INDEX") == std::string::npos) {
+              continue;
+            }
+
+            auto table = detail.substr(start + sizeof("SCAN TABLE ") - 1);
+            table = table.substr(0, table.find(' '));
+            doc.pushCopy(table, tables);
+
+            size_t attributes = 0;
+            bool has_required = false;
+            tableMetadata(table, attributes, has_required);
+
+            auto indexed = detail.find(":index(") != std::string::npos;
+            auto full = detail.find(":full(") != std::string::npos;
+            if (!indexed) {
+              unconstrained++;
+            }
+
+            if (full && has_required) {
+              doc.pushCopy("table " + table +
+                               " has a required column but the plan pushes "
+                               "no constraint",
+                           issues);
+              cost = "invalid";
+              issue_count++;
+            }
+            if ((attributes &
+                 static_cast<size_t>(TableAttributes::EXPENSIVE)) > 0 &&
+                !indexed) {
+              doc.pushCopy("unconstrained scan of expensive table " + table,
+                           issues);
+              if (cost != "invalid") {
+                cost = "high";
+              }
+              issue_count++;
+            }
+          }
+
+          if (unconstrained > 1) {
+            doc.pushCopy("join nests " + std::to_string(unconstrained) +
+                             " unconstrained table scans",
+                         issues);
+            if (cost == "low" || cost == "medium") {
+              cost = "high";
+            }
+            issue_count++;
+          } else if (cost == "low" && unconstrained == 1) {
+            cost = "medium";
+          }
+        }
+
+        doc.addCopy("cost", cost, report);
+        doc.add("tables", tables, report);
+        doc.add("issues", issues, report);
+        doc.add(name, report, queries);
+      }),
+      true);
+
+  doc.add("queries", queries);
+  doc.add("issues", issue_count);
+
+  std::string out;
+  doc.toString(out);
+  fprintf(stdout, "%s\n", out.c_str());
+  if (issue_count > 0) {
+    return Status(1, std::to_string(issue_count) + " pack query issues");
+  }
+  return Status();
+}
 }
@@ -8,11 +8,14 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <atomic>
+
 #include <osquery/config.h>
 #include <osquery/flags.h>
 #include <osquery/logger.h>
 #include <osquery/registry_factory.h>
 #include <osquery/sql.h>
+#include <osquery/system.h>
 
 #include "osquery/config/parsers/decorators.h"
 
@@ -27,6 +30,12 @@ FLAG(bool,
      false,
      "Add decorators as top level JSON objects");
 
+FLAG(uint64,
+     decorations_always_refresh,
+     60,
+     "Seconds cached 'always' decorator results are reused before their "
+     "queries re-execute (0 re-executes them for every scheduled query)");
+
 /// Statically define the parser name to avoid mistakes.
 const std::string kDecorationsName{"decorators"};
 
@@ -97,6 +106,9 @@ class DecoratorsConfigParserPlugin : public ConfigParserPlugin {
   /// The result set of decorations, column names and their values.
   static DecorationStore kDecorations;
 
+  /// Unix time the 'always' decorator queries last executed.
+  static std::atomic<size_t> kAlwaysLastRefresh;
+
   /// Protect additions to the decorator set.
   static Mutex kDecorationsMutex;
 
@@ -106,6 +118,7 @@ class DecoratorsConfigParserPlugin : public ConfigParserPlugin {
 }
 
 DecorationStore DecoratorsConfigParserPlugin::kDecorations;
+std::atomic<size_t> DecoratorsConfigParserPlugin::kAlwaysLastRefresh{0};
 Mutex DecoratorsConfigParserPlugin::kDecorationsMutex;
 Mutex DecoratorsConfigParserPlugin::kDecorationsConfigMutex;
 
@@ -119,6 +132,8 @@ Status DecoratorsConfigParserPlugin::update(const std::string& source,
                                             const ParserConfig& config) {
   clearSources(source);
   clearDecorations(source);
+  // The decorator set changed: force the next 'always' run to re-execute.
+  kAlwaysLastRefresh = 0;
   auto decorations = config.find(kDecorationsName);
   if (decorations != config.end()) {
     // Each of these methods acquires the decorator lock separately.
@@ -153,6 +168,7 @@ void DecoratorsConfigParserPlugin::reset() {
     clearSources(source.first);
     clearDecorations(source.first);
   }
+  kAlwaysLastRefresh = 0;
 }
 
 void DecoratorsConfigParserPlugin::updateDecorations(const std::string& source,
@@ -268,6 +284,17 @@ void runDecorators(DecorationPoint point,
       }
     }
   } else if (point == DECORATE_ALWAYS) {
+    // The 'always' values (hostname, hardware UUID, etc.) change rarely but
+    // this point fires for every scheduled query. Reuse the applied values
+    // until the refresh interval lapses or a config update invalidates them.
+    auto now = getUnixTime();
+    auto last = DecoratorsConfigParserPlugin::kAlwaysLastRefresh.load();
+    if (source.empty() && FLAGS_decorations_always_refresh > 0 && last != 0 &&
+        now - last < FLAGS_decorations_always_refresh) {
+      return;
+    }
+    DecoratorsConfigParserPlugin::kAlwaysLastRefresh = now;
+
     for (const auto& target_source : dp->always_) {
       if (source.empty() || target_source.first == source) {
         runDecorators(target_source.first, target_source.second);
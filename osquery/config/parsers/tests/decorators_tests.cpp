@@ -107,6 +107,39 @@ TEST_F(DecoratorsConfigParserPluginTests, test_decorators_run_interval) {
   ASSERT_EQ(second_item.decorations.size(), 2U);
 }
 
+TEST_F(DecoratorsConfigParserPluginTests, test_decorators_always_cache) {
+  // Prevent loads from executing.
+  FLAGS_disable_decorators = true;
+  Config::get().update(config_data_);
+
+  // Mimic the schedule's execution.
+  FLAGS_disable_decorators = false;
+  runDecorators(DECORATE_ALWAYS);
+
+  QueryLogItem item;
+  getDecorations(item.decorations);
+  EXPECT_EQ(item.decorations.at("always_test"), "test");
+
+  // Clearing only drops the applied values; within the refresh interval the
+  // cached run is reused and the 'always' queries do not re-execute.
+  clearDecorations("awesome");
+  runDecorators(DECORATE_ALWAYS);
+
+  QueryLogItem second_item;
+  getDecorations(second_item.decorations);
+  EXPECT_EQ(second_item.decorations.size(), 0U);
+
+  // A config update invalidates the cached run.
+  FLAGS_disable_decorators = true;
+  Config::get().update(config_data_);
+  FLAGS_disable_decorators = false;
+  runDecorators(DECORATE_ALWAYS);
+
+  QueryLogItem third_item;
+  getDecorations(third_item.decorations);
+  EXPECT_EQ(third_item.decorations.at("always_test"), "test");
+}
+
 TEST_F(DecoratorsConfigParserPluginTests, test_decorators_run_load_top_level) {
   // Re-enable the decorators, then update the config.
   // The 'load' decorator set should run every time the config is updated.
@@ -70,9 +70,29 @@ Status TLSConfigPlugin::genConfig(std::map<std::string, std::string>& config) {
     params.add("_get", true);
   }
 
+  // If the server supplied a validator previously, make the request
+  // conditional: an unchanged config is answered with a bodyless 304.
+  if (!last_etag_.empty()) {
+    params.add("_if_none_match", last_etag_);
+  }
+
   auto s = TLSRequestHelper::go<JSONSerializer>(
       uri_, params, json, FLAGS_config_tls_max_attempts);
   if (s.ok()) {
+    auto not_modified = params.doc().FindMember("_not_modified");
+    if (not_modified != params.doc().MemberEnd() &&
+        not_modified->value.IsBool() && not_modified->value.GetBool()) {
+      // The server confirmed the cached content is current; replaying it
+      // lets the config source hash check skip the reconfigure work.
+      config["tls_plugin"] = last_config_;
+      return s;
+    }
+
+    auto etag = params.doc().FindMember("_etag");
+    last_etag_ = (etag != params.doc().MemberEnd() && etag->value.IsString())
+                     ? etag->value.GetString()
+                     : "";
+
     if (FLAGS_tls_node_api) {
       // The node API embeds configuration data (JSON escaped).
 
@@ -91,6 +111,7 @@ Status TLSConfigPlugin::genConfig(std::map<std::string, std::string>& config) {
     } else {
       config["tls_plugin"] = json;
     }
+    last_config_ = config["tls_plugin"];
   }
 
   return s;
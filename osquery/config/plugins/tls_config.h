@@ -27,6 +27,12 @@ class TLSConfigPlugin : public ConfigPlugin,
   /// Calculate the URL once and cache the result.
   std::string uri_;
 
+  /// The entity validator from the last config response, if provided.
+  std::string last_etag_;
+
+  /// The last retrieved config content, replayed on a 304 response.
+  std::string last_config_;
+
  private:
   friend class TLSConfigTests;
 };
@@ -15,6 +15,7 @@
 
 #include <osquery/config.h>
 #include <osquery/core.h>
+#include <osquery/database.h>
 #include <osquery/filesystem.h>
 #include <osquery/flags.h>
 #include <osquery/packs.h>
@@ -39,6 +40,13 @@ const std::string kConfigTestNonBlacklistQuery{
 extern void restoreScheduleBlacklist(std::map<std::string, size_t>& blacklist);
 extern void saveScheduleBlacklist(
     const std::map<std::string, size_t>& blacklist);
+extern void restoreFailedQueryCounts(std::map<std::string, size_t>& counts);
+extern void saveFailedQueryCounts(const std::map<std::string, size_t>& counts);
+extern void restoreFailedQueryTimes(std::map<std::string, size_t>& times);
+extern void saveFailedQueryTimes(const std::map<std::string, size_t>& times);
+extern void decayFailedQueryCounts(std::map<std::string, size_t>& counts,
+                                   std::map<std::string, size_t>& times);
+extern size_t getBlacklistDuration(size_t failure_count);
 
 class ConfigTests : public testing::Test {
  public:
@@ -133,6 +141,26 @@ TEST_F(ConfigTests, test_invalid_content) {
   ASSERT_NO_THROW(get().update({{"bad_source", bad_json}}));
 }
 
+TEST_F(ConfigTests, test_invalid_source_isolation) {
+  // A malformed source fails the update, but the valid sources still apply.
+  auto status = get().update(
+      {{"bad_source", "{\"options\": {},}"},
+       {"good_source",
+        "{\"schedule\": {\"works\": {\"query\": \"select * from time\", "
+        "\"interval\": 10}}}"}});
+  EXPECT_FALSE(status.ok());
+
+  size_t count = 0;
+  get().scheduledQueries(
+      ([&count](std::string name, const ScheduledQuery& query) { count++; }));
+  EXPECT_EQ(count, 1U);
+
+  // The malformed source is re-parsed (and fails again) on the next update,
+  // while unchanged valid sources are skipped by their content hash.
+  status = get().update({{"bad_source", "{\"options\": {},}"}});
+  EXPECT_FALSE(status.ok());
+}
+
 TEST_F(ConfigTests, test_strip_comments) {
   std::string json_comments =
       "// Comment\n // Comment //\n  # Comment\n# Comment\n{\"options\":{}}";
@@ -175,6 +203,64 @@ TEST_F(ConfigTests, test_schedule_blacklist) {
   EXPECT_EQ(blacklist.size(), 1U);
 }
 
+TEST_F(ConfigTests, test_failed_query_counts) {
+  std::map<std::string, size_t> counts;
+  saveFailedQueryCounts(counts);
+  restoreFailedQueryCounts(counts);
+  EXPECT_EQ(counts.size(), 0U);
+
+  // The failure profile round-trips through the backing store.
+  counts["test_1"] = 1;
+  counts["test_2"] = 3;
+  saveFailedQueryCounts(counts);
+  counts.clear();
+  restoreFailedQueryCounts(counts);
+  ASSERT_EQ(counts.count("test_1"), 1U);
+  EXPECT_EQ(counts.at("test_1"), 1U);
+  EXPECT_EQ(counts.at("test_2"), 3U);
+
+  // Repeat offenders double the blacklist duration, up to a limit.
+  EXPECT_EQ(getBlacklistDuration(1), 86400U);
+  EXPECT_EQ(getBlacklistDuration(2), 86400U * 2);
+  EXPECT_EQ(getBlacklistDuration(3), 86400U * 4);
+  EXPECT_EQ(getBlacklistDuration(100), 86400U * 16);
+
+  // Clear the persisted profile for other tests.
+  saveFailedQueryCounts(std::map<std::string, size_t>());
+}
+
+TEST_F(ConfigTests, test_failed_query_decay) {
+  auto now = getUnixTime();
+  std::map<std::string, size_t> counts = {{"test_1", 3}, {"test_2", 1}};
+  std::map<std::string, size_t> times = {
+      // Clean for two decay intervals: two failures are forgiven.
+      {"test_1", now - (604800 * 2 + 100)},
+      // Clean for one interval: the single failure decays away entirely.
+      {"test_2", now - 604800},
+  };
+
+  decayFailedQueryCounts(counts, times);
+  ASSERT_EQ(counts.count("test_1"), 1U);
+  EXPECT_EQ(counts.at("test_1"), 1U);
+  EXPECT_EQ(counts.count("test_2"), 0U);
+  EXPECT_EQ(times.count("test_2"), 0U);
+
+  // The forgiven intervals advance the failure time so a later decay pass
+  // does not forgive the same clean period twice.
+  ASSERT_EQ(times.count("test_1"), 1U);
+  EXPECT_EQ(times.at("test_1"), now - 100);
+
+  // The failure times round-trip through the backing store.
+  saveFailedQueryTimes(times);
+  times.clear();
+  restoreFailedQueryTimes(times);
+  ASSERT_EQ(times.count("test_1"), 1U);
+  EXPECT_EQ(times.at("test_1"), now - 100);
+
+  // Clear the persisted times for other tests.
+  saveFailedQueryTimes(std::map<std::string, size_t>());
+}
+
 TEST_F(ConfigTests, test_pack_noninline) {
   auto& rf = RegistryFactory::get();
   rf.registry("config")->add("test", std::make_shared<TestConfigPlugin>());
@@ -265,6 +351,59 @@ TEST_F(ConfigTests, test_content_update) {
   EXPECT_EQ(count, 0U);
 }
 
+TEST_F(ConfigTests, test_config_persistence) {
+  // A successful update caches each source as last-known-good content.
+  get().update({{"awesome", "{\"options\":{}}"}});
+
+  std::string cached;
+  getDatabaseValue(kPersistentSettings, "config_persistence.awesome", cached);
+  EXPECT_EQ(cached, "{\"options\":{}}");
+}
+
+TEST_F(ConfigTests, test_pack_differential_update) {
+  const std::string pack_1 =
+      "\"pack_1\": {\"queries\": {\"q1\": {\"query\": \"select 1\", "
+      "\"interval\": 10}}}";
+  const std::string pack_2 =
+      "\"pack_2\": {\"queries\": {\"q2\": {\"query\": \"select 2\", "
+      "\"interval\": 10}}}";
+
+  std::map<std::string, std::string> config_data;
+  config_data["awesome"] = "{\"packs\": {" + pack_1 + "}}";
+  get().update(config_data);
+
+  const Pack* original = nullptr;
+  get().packs([&original](const Pack& pack) {
+    if (pack.getName() == "pack_1") {
+      original = &pack;
+    }
+  });
+  ASSERT_NE(original, nullptr);
+
+  // Adding a second pack must not rebuild the unchanged first pack.
+  config_data["awesome"] = "{\"packs\": {" + pack_1 + ", " + pack_2 + "}}";
+  get().update(config_data);
+
+  size_t total_packs = 0;
+  const Pack* retained = nullptr;
+  get().packs([&total_packs, &retained](const Pack& pack) {
+    total_packs++;
+    if (pack.getName() == "pack_1") {
+      retained = &pack;
+    }
+  });
+  EXPECT_EQ(total_packs, 2U);
+  EXPECT_EQ(retained, original);
+
+  // A pack removed from the source content leaves the schedule.
+  config_data["awesome"] = "{\"packs\": {" + pack_2 + "}}";
+  get().update(config_data);
+
+  total_packs = 0;
+  get().packs([&total_packs](const Pack& pack) { total_packs++; });
+  EXPECT_EQ(total_packs, 1U);
+}
+
 TEST_F(ConfigTests, test_get_scheduled_queries) {
   std::vector<std::string> query_names;
   get().addPack("unrestricted_pack", "", getUnrestrictedPack().doc());
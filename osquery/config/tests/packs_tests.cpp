@@ -135,6 +135,43 @@ TEST_F(PacksTests, test_schedule) {
   EXPECT_EQ(fpack.getSchedule().size(), 1U);
 }
 
+TEST_F(PacksTests, test_sample_rows) {
+  auto doc = JSON::newObject();
+  doc.fromString(
+      "{\"queries\": {\"sampled\": {\"query\": \"select * from processes\", "
+      "\"interval\": 600, \"snapshot\": true, \"sample_rows\": 100}}}");
+  Pack pack("sample_pack", doc.doc());
+  ASSERT_EQ(pack.getSchedule().size(), 1U);
+  EXPECT_EQ(pack.getSchedule().at("sampled").sample_rows, 100U);
+}
+
+TEST_F(PacksTests, test_background_option) {
+  auto doc = JSON::newObject();
+  doc.fromString(
+      "{\"queries\": {\"slow\": {\"query\": \"select * from processes\", "
+      "\"interval\": 600, \"background\": true}, \"fast\": {\"query\": "
+      "\"select * from osquery_info\", \"interval\": 600}}}");
+  Pack pack("background_pack", doc.doc());
+  ASSERT_EQ(pack.getSchedule().size(), 2U);
+  EXPECT_TRUE(pack.getSchedule().at("slow").options.at("background"));
+  EXPECT_FALSE(pack.getSchedule().at("fast").options.at("background"));
+}
+
+TEST_F(PacksTests, test_trigger_option) {
+  auto doc = JSON::newObject();
+  doc.fromString(
+      "{\"queries\": {\"mounts\": {\"query\": \"select * from mounts\", "
+      "\"interval\": 3600, \"trigger\": \"fsevents,inotify\", "
+      "\"trigger_debounce\": 30}, \"plain\": {\"query\": "
+      "\"select * from osquery_info\", \"interval\": 600}}}");
+  Pack pack("trigger_pack", doc.doc());
+  ASSERT_EQ(pack.getSchedule().size(), 2U);
+  EXPECT_EQ(pack.getSchedule().at("mounts").trigger, "fsevents,inotify");
+  EXPECT_EQ(pack.getSchedule().at("mounts").trigger_debounce, 30U);
+  EXPECT_TRUE(pack.getSchedule().at("plain").trigger.empty());
+  EXPECT_EQ(pack.getSchedule().at("plain").trigger_debounce, 10U);
+}
+
 TEST_F(PacksTests, test_discovery_cache) {
   Config c;
   // This pack and discovery query are valid, expect the SQL to execute.
@@ -159,6 +196,18 @@ TEST_F(PacksTests, test_discovery_cache) {
   }));
 
   EXPECT_EQ(pack_count, 1U);
+
+  // Invalidation forces the next pass to re-run the discovery queries.
+  c.invalidatePackDiscovery();
+  c.scheduledQueries(
+      ([&query_count](std::string name, const ScheduledQuery& query) {
+        query_count++;
+      }));
+  c.packs(([query_attemts](const Pack& p) {
+    EXPECT_EQ(p.getStats().misses, 2U);
+    EXPECT_EQ(p.getStats().hits, query_attemts);
+    EXPECT_GT(p.getStats().last_discovery_time, 0U);
+  }));
   c.reset();
 }
 
@@ -224,4 +273,17 @@ TEST_F(PacksTests, test_restore_splay) {
   EXPECT_LE(splay3, 3600U * 10 + (360 * 10));
   EXPECT_NE(splay, splay3);
 }
+
+TEST_F(PacksTests, test_query_phase) {
+  // A phase is a stable offset bounded by the interval window.
+  auto phase = computeQueryPhase("pack_test_query_name", 3600);
+  EXPECT_LT(phase, 3600U);
+  for (size_t i = 0; i < 10; i++) {
+    EXPECT_EQ(phase, computeQueryPhase("pack_test_query_name", 3600));
+  }
+
+  // Trivial intervals have no window to offset within.
+  EXPECT_EQ(0U, computeQueryPhase("pack_test_query_name", 1));
+  EXPECT_EQ(0U, computeQueryPhase("pack_test_query_name", 0));
+}
 }
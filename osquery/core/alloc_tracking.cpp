@@ -0,0 +1,64 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <boost/noncopyable.hpp>
+
+#include <osquery/mutex.h>
+
+#include "osquery/core/alloc_tracking.h"
+
+namespace osquery {
+
+/**
+ * @brief Process-wide accumulator behind the TRACK_ALLOCATION sites.
+ *
+ * Mirrors the table statistics tracker: a mutex-guarded map keyed by site
+ * name, copied out whole for the diagnostic table. Sites are few and the
+ * payload sizes dwarf the tracking cost, so a shared lock suffices.
+ */
+class AllocationTracker : private boost::noncopyable {
+ public:
+  static AllocationTracker& get() {
+    static AllocationTracker instance;
+    return instance;
+  }
+
+  void record(const std::string& site, size_t bytes) {
+    WriteLock lock(mutex_);
+    auto& stats = stats_[site];
+    stats.allocations += 1;
+    stats.bytes += bytes;
+    stats.sizes.add(bytes);
+  }
+
+  std::map<std::string, AllocationSiteStats> snapshot() {
+    WriteLock lock(mutex_);
+    return stats_;
+  }
+
+ private:
+  AllocationTracker() = default;
+
+ private:
+  /// Protect concurrent updates from scheduler and event threads.
+  Mutex mutex_;
+
+  /// Cumulative statistics, keyed by instrumented site name.
+  std::map<std::string, AllocationSiteStats> stats_;
+};
+
+void recordAllocation(const std::string& site, size_t bytes) {
+  AllocationTracker::get().record(site, bytes);
+}
+
+std::map<std::string, AllocationSiteStats> getAllocationStats() {
+  return AllocationTracker::get().snapshot();
+}
+} // namespace osquery
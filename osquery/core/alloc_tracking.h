@@ -0,0 +1,54 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include <osquery/query.h>
+
+namespace osquery {
+
+/**
+ * @brief Cumulative allocation statistics for one instrumented site.
+ *
+ * Sites are hot paths that build or serialize rows; each records how many
+ * payloads it produced, the total bytes, and a log-scale size histogram so
+ * allocation-reduction work can be compared on production workloads.
+ */
+struct AllocationSiteStats {
+  /// Number of payloads produced by the site.
+  size_t allocations{0};
+
+  /// Total bytes across all payloads.
+  uint64_t bytes{0};
+
+  /// Log-scale histogram of payload sizes.
+  QueryHistogram sizes;
+};
+
+/// Record one payload from an instrumented site.
+void recordAllocation(const std::string& site, size_t bytes);
+
+/// Copy out statistics for every observed site, empty when not tracking.
+std::map<std::string, AllocationSiteStats> getAllocationStats();
+} // namespace osquery
+
+/**
+ * Instrumentation call sites compile away unless the build enables
+ * allocation tracking (OSQUERY_ALLOC_TRACKING=1 in the environment at
+ * configure time), so release binaries pay nothing for them.
+ */
+#ifdef OSQUERY_ALLOC_TRACKING
+#define TRACK_ALLOCATION(site, bytes) osquery::recordAllocation(site, bytes)
+#else
+#define TRACK_ALLOCATION(site, bytes)
+#endif
@@ -0,0 +1,97 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <osquery/tables.h>
+
+#include "osquery/core/conversions.h"
+
+namespace osquery {
+
+static std::string benchmarkBlob(size_t size) {
+  std::string blob(size, '\0');
+  for (size_t i = 0; i < size; i++) {
+    blob[i] = static_cast<char>(i * 131U);
+  }
+  return blob;
+}
+
+static void CONVERSIONS_base64_encode(benchmark::State& state) {
+  auto blob = benchmarkBlob(static_cast<size_t>(state.range(0)));
+  while (state.KeepRunning()) {
+    auto encoded = base64Encode(blob);
+    benchmark::DoNotOptimize(encoded);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(CONVERSIONS_base64_encode)->Range(1 << 10, 1 << 20);
+
+static void CONVERSIONS_base64_decode(benchmark::State& state) {
+  auto encoded = base64Encode(benchmarkBlob(static_cast<size_t>(state.range(0))));
+  while (state.KeepRunning()) {
+    auto decoded = base64Decode(encoded);
+    benchmark::DoNotOptimize(decoded);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(CONVERSIONS_base64_decode)->Range(1 << 10, 1 << 20);
+
+static void CONVERSIONS_int64_to_field(benchmark::State& state) {
+  long long value = -1234567890123456789LL;
+  while (state.KeepRunning()) {
+    auto cell = __sqliteField(value);
+    benchmark::DoNotOptimize(cell);
+  }
+}
+
+BENCHMARK(CONVERSIONS_int64_to_field);
+
+static void CONVERSIONS_int64_to_field_lexical(benchmark::State& state) {
+  // The previous per-cell path, kept for comparison against the direct
+  // digit formatting used by the affinity macros.
+  long long value = -1234567890123456789LL;
+  while (state.KeepRunning()) {
+    std::string cell;
+    boost::conversion::try_lexical_convert(value, cell);
+    benchmark::DoNotOptimize(cell);
+  }
+}
+
+BENCHMARK(CONVERSIONS_int64_to_field_lexical);
+
+static void CONVERSIONS_field_to_int64(benchmark::State& state) {
+  std::string cell{"-1234567890123456789"};
+  while (state.KeepRunning()) {
+    long long value{0};
+    auto status = safeStrto<long long>(cell, value);
+    benchmark::DoNotOptimize(status);
+    benchmark::DoNotOptimize(value);
+  }
+}
+
+BENCHMARK(CONVERSIONS_field_to_int64);
+
+static void CONVERSIONS_field_to_int64_strtoll(benchmark::State& state) {
+  std::string cell{"-1234567890123456789"};
+  while (state.KeepRunning()) {
+    long long value{0};
+    auto status = safeStrtoll(cell, 10, value);
+    benchmark::DoNotOptimize(status);
+    benchmark::DoNotOptimize(value);
+  }
+}
+
+BENCHMARK(CONVERSIONS_field_to_int64_strtoll);
+} // namespace osquery
@@ -8,13 +8,11 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <array>
 #include <iomanip>
 #include <locale>
 
 #include <boost/algorithm/string.hpp>
-#include <boost/archive/iterators/base64_from_binary.hpp>
-#include <boost/archive/iterators/binary_from_base64.hpp>
-#include <boost/archive/iterators/transform_width.hpp>
 #include <boost/uuid/sha1.hpp>
 
 #include <osquery/logger.h>
@@ -22,15 +20,13 @@
 #include "osquery/core/conversions.h"
 #include "osquery/core/json.h"
 
-namespace bai = boost::archive::iterators;
 namespace rj = rapidjson;
 
 namespace osquery {
 
-typedef bai::binary_from_base64<const char*> base64_str;
-typedef bai::transform_width<base64_str, 8, 6> base64_dec;
-typedef bai::transform_width<std::string::const_iterator, 6, 8> base64_enc;
-typedef bai::base64_from_binary<base64_enc> it_base64;
+/// The base64 output alphabet, indexed by 6-bit group value.
+static const char kBase64Alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
 JSON::JSON(decltype(rj::kObjectType) type) : type_(type) {
   if (type_ == rj::kObjectType) {
@@ -241,6 +237,25 @@ Status JSON::fromString(const std::string& str) {
   return Status();
 }
 
+Status JSON::fromMutableString(std::string str) {
+  // Tiny documents may live in the string's inline storage, whose address
+  // changes if this JSON object moves; parse those with a copy instead.
+  if (str.size() < sizeof(std::string)) {
+    return fromString(str);
+  }
+
+  buffer_ = std::move(str);
+  rj::ParseResult pr = doc_.ParseInsitu(&buffer_[0]);
+  if (!pr) {
+    std::string message{"Cannot parse JSON: "};
+    message += GetParseError_En(pr.Code());
+    message += " Offset: ";
+    message += std::to_string(pr.Offset());
+    return Status(1, message);
+  }
+  return Status();
+}
+
 void JSON::mergeObject(rj::Value& target_obj, rj::Value& source_obj) {
   assert(target_obj.IsObject());
   assert(source_obj.IsObject());
@@ -272,8 +287,44 @@ JSON JSON::newFromValue(const rj::Value& value) {
   return doc;
 }
 
+/**
+ * @brief Recursively copy a value, forcing strings into the allocator.
+ *
+ * rapidjson's CopyFrom keeps const-string values as references into their
+ * source buffer. Documents parsed in place (fromMutableString) consist
+ * entirely of such references, so copies must own their strings or they
+ * dangle once the source document is destroyed.
+ */
+static void deepCopyValue(const rj::Value& value,
+                          rj::Value& target,
+                          rj::Document::AllocatorType& allocator) {
+  if (value.IsObject()) {
+    target.SetObject();
+    for (const auto& member : value.GetObject()) {
+      rj::Value name(
+          member.name.GetString(), member.name.GetStringLength(), allocator);
+      rj::Value copy;
+      deepCopyValue(member.value, copy, allocator);
+      target.AddMember(name.Move(), copy.Move(), allocator);
+    }
+  } else if (value.IsArray()) {
+    target.SetArray();
+    target.Reserve(value.Size(), allocator);
+    for (const auto& item : value.GetArray()) {
+      rj::Value copy;
+      deepCopyValue(item, copy, allocator);
+      target.PushBack(copy.Move(), allocator);
+    }
+  } else if (value.IsString()) {
+    target.SetString(value.GetString(), value.GetStringLength(), allocator);
+  } else {
+    // Numbers, booleans, and null carry no allocated state.
+    target.CopyFrom(value, allocator);
+  }
+}
+
 void JSON::copyFrom(const rapidjson::Value& value, rj::Value& target) {
-  target.CopyFrom(value, doc().GetAllocator());
+  deepCopyValue(value, target, doc().GetAllocator());
 }
 
 void JSON::copyFrom(const rj::Value& value) {
@@ -316,21 +367,61 @@ bool JSON::valueToBool(const rj::Value& value) {
 }
 
 std::string base64Decode(std::string encoded) {
-  boost::erase_all(encoded, "\r\n");
-  boost::erase_all(encoded, "\n");
-  boost::trim_right_if(encoded, boost::is_any_of("="));
+  // The inverse alphabet: 0-63 for input symbols, -1 for invalid bytes, and
+  // -2 for ignorable line breaks within the encoded stream.
+  static const auto kBase64Indexes = ([]() {
+    std::array<int8_t, 256> indexes;
+    indexes.fill(-1);
+    for (uint8_t i = 0U; i < 64U; i++) {
+      indexes[static_cast<uint8_t>(kBase64Alphabet[i])] = i;
+    }
+    indexes[static_cast<uint8_t>('\r')] = -2;
+    indexes[static_cast<uint8_t>('\n')] = -2;
+    return indexes;
+  })();
+
+  std::string decoded;
+  decoded.reserve((encoded.size() / 4U) * 3U + 3U);
+
+  // Accumulate 6-bit groups and emit bytes every 24 bits, one pass, no
+  // per-character iterator machinery.
+  uint32_t group = 0;
+  size_t count = 0;
+  bool padded = false;
+  for (const char c : encoded) {
+    auto index = kBase64Indexes[static_cast<uint8_t>(c)];
+    if (index == -2) {
+      continue;
+    }
+    if (c == '=') {
+      padded = true;
+      continue;
+    }
+    if (index < 0 || padded) {
+      LOG(INFO) << "Could not base64 decode string: invalid input";
+      return "";
+    }
 
-  if (encoded.empty()) {
-    return encoded;
+    group = (group << 6) | index;
+    if (++count == 4U) {
+      decoded.push_back(static_cast<char>((group >> 16) & 0xFF));
+      decoded.push_back(static_cast<char>((group >> 8) & 0xFF));
+      decoded.push_back(static_cast<char>(group & 0xFF));
+      group = 0;
+      count = 0;
+    }
   }
 
-  try {
-    return std::string(base64_dec(encoded.data()),
-                       base64_dec(encoded.data() + encoded.size()));
-  } catch (const boost::archive::iterators::dataflow_exception& e) {
-    LOG(INFO) << "Could not base64 decode string: " << e.what();
+  if (count == 2U) {
+    decoded.push_back(static_cast<char>((group >> 4) & 0xFF));
+  } else if (count == 3U) {
+    decoded.push_back(static_cast<char>((group >> 10) & 0xFF));
+    decoded.push_back(static_cast<char>((group >> 2) & 0xFF));
+  } else if (count == 1U) {
+    LOG(INFO) << "Could not base64 decode string: truncated input";
     return "";
   }
+  return decoded;
 }
 
 std::string base64Encode(const std::string& unencoded) {
@@ -338,16 +429,33 @@ std::string base64Encode(const std::string& unencoded) {
     return unencoded;
   }
 
-  size_t writePaddChars = (3U - unencoded.length() % 3U) % 3U;
-  try {
-    auto encoded =
-        std::string(it_base64(unencoded.begin()), it_base64(unencoded.end()));
-    encoded.append(std::string(writePaddChars, '='));
-    return encoded;
-  } catch (const boost::archive::iterators::dataflow_exception& e) {
-    LOG(INFO) << "Could not base64 decode string: " << e.what();
-    return "";
+  const auto* in = reinterpret_cast<const uint8_t*>(unencoded.data());
+  auto size = unencoded.size();
+
+  // The output size is known, write symbols into preallocated storage.
+  std::string encoded(((size + 2U) / 3U) * 4U, '=');
+  auto* out = &encoded[0];
+
+  size_t i = 0;
+  for (; i + 3U <= size; i += 3U) {
+    uint32_t group = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+    *out++ = kBase64Alphabet[(group >> 18) & 0x3F];
+    *out++ = kBase64Alphabet[(group >> 12) & 0x3F];
+    *out++ = kBase64Alphabet[(group >> 6) & 0x3F];
+    *out++ = kBase64Alphabet[group & 0x3F];
+  }
+
+  if (i + 1U == size) {
+    uint32_t group = in[i] << 16;
+    *out++ = kBase64Alphabet[(group >> 18) & 0x3F];
+    *out++ = kBase64Alphabet[(group >> 12) & 0x3F];
+  } else if (i + 2U == size) {
+    uint32_t group = (in[i] << 16) | (in[i + 1] << 8);
+    *out++ = kBase64Alphabet[(group >> 18) & 0x3F];
+    *out++ = kBase64Alphabet[(group >> 12) & 0x3F];
+    *out++ = kBase64Alphabet[(group >> 6) & 0x3F];
   }
+  return encoded;
 }
 
 bool isPrintable(const std::string& check) {
@@ -211,6 +211,101 @@ inline Status safeStrtoull(const std::string& rep,
   return Status(0);
 }
 
+/// Parse a base-10 magnitude; the entire range must be digits.
+inline bool safeStrtoDigits(const char* cursor,
+                            const char* end,
+                            unsigned long long& value) {
+  if (cursor == end) {
+    return false;
+  }
+
+  value = 0;
+  for (; cursor != end; cursor++) {
+    if (*cursor < '0' || *cursor > '9') {
+      return false;
+    }
+    auto digit = static_cast<unsigned long long>(*cursor - '0');
+    if (value > (ULLONG_MAX - digit) / 10) {
+      return false;
+    }
+    value = value * 10 + digit;
+  }
+  return true;
+}
+
+/**
+ * @brief Convert a cell representation to a native value.
+ *
+ * The conversion pairs used when building and consuming rows (64-bit
+ * integers, doubles, booleans) are selected at compile time, without the
+ * locale, errno, and exception plumbing of a lexical cast per cell. The
+ * integer forms are strict: base-10, an optional leading sign, and no
+ * surrounding whitespace. On failure the output is zeroed.
+ */
+template <typename Type>
+Status safeStrto(const std::string& rep, Type& out);
+
+template <>
+inline Status safeStrto<unsigned long long>(const std::string& rep,
+                                            unsigned long long& out) {
+  const auto* cursor = rep.data();
+  const auto* end = cursor + rep.size();
+  if (cursor != end && *cursor == '+') {
+    cursor++;
+  }
+  if (!safeStrtoDigits(cursor, end, out)) {
+    out = 0;
+    return Status(1);
+  }
+  return Status(0);
+}
+
+template <>
+inline Status safeStrto<long long>(const std::string& rep, long long& out) {
+  const auto* cursor = rep.data();
+  const auto* end = cursor + rep.size();
+  bool negative = false;
+  if (cursor != end && (*cursor == '-' || *cursor == '+')) {
+    negative = (*cursor == '-');
+    cursor++;
+  }
+
+  unsigned long long value{0};
+  auto limit = static_cast<unsigned long long>(LLONG_MAX) + (negative ? 1 : 0);
+  if (!safeStrtoDigits(cursor, end, value) || value > limit) {
+    out = 0;
+    return Status(1);
+  }
+  out = negative ? static_cast<long long>(0ULL - value)
+                 : static_cast<long long>(value);
+  return Status(0);
+}
+
+template <>
+inline Status safeStrto<double>(const std::string& rep, double& out) {
+  char* end{nullptr};
+  out = strtod(rep.c_str(), &end);
+  if (end == nullptr || end == rep.c_str() || *end != '\0' || errno == ERANGE) {
+    out = 0;
+    return Status(1);
+  }
+  return Status(0);
+}
+
+template <>
+inline Status safeStrto<bool>(const std::string& rep, bool& out) {
+  if (rep == "1" || rep == "true") {
+    out = true;
+    return Status(0);
+  }
+  if (rep == "0" || rep == "false") {
+    out = false;
+    return Status(0);
+  }
+  out = false;
+  return Status(1);
+}
+
 /// Safely convert unicode escaped ASCII.
 inline std::string unescapeUnicode(const std::string& escaped) {
   if (escaped.size() < 6) {
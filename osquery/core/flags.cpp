@@ -49,6 +49,26 @@ int Flag::createAlias(const std::string& alias, const FlagDetail& flag) {
   return 0;
 }
 
+void Flag::bindFastFlag(const std::string& name, FastFlagBase* handle) {
+  instance().fast_flags_.insert(std::make_pair(name, handle));
+}
+
+/// Refresh every typed handle bound to a flag after its storage changed.
+static void refreshBoundFastFlags(
+    const std::multimap<std::string, FastFlagBase*>& handles,
+    const std::string& name) {
+  auto range = handles.equal_range(name);
+  for (auto it = range.first; it != range.second; ++it) {
+    it->second->refresh();
+  }
+}
+
+void Flag::refreshFastFlags() {
+  for (const auto& handle : instance().fast_flags_) {
+    handle.second->refresh();
+  }
+}
+
 Status Flag::getDefaultValue(const std::string& name, std::string& value) {
   flags::CommandLineFlagInfo info;
   if (!flags::GetCommandLineFlagInfo(name.c_str(), &info)) {
@@ -121,11 +141,13 @@ std::string Flag::getDescription(const std::string& name) {
 Status Flag::updateValue(const std::string& name, const std::string& value) {
   if (instance().flags_.count(name) > 0) {
     flags::SetCommandLineOption(name.c_str(), value.c_str());
+    refreshBoundFastFlags(instance().fast_flags_, name);
     return Status(0, "OK");
   } else if (instance().aliases_.count(name) > 0) {
     // Updating a flag by an alias name.
     auto& real_name = instance().aliases_.at(name).description;
     flags::SetCommandLineOption(real_name.c_str(), value.c_str());
+    refreshBoundFastFlags(instance().fast_flags_, real_name);
     return Status(0, "OK");
   } else if (name.find("custom_") == 0) {
     instance().custom_[name] = value;
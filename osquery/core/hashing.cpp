@@ -8,9 +8,18 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+// clang-format off
+#include <sys/types.h>
+#include <sys/stat.h>
+// clang-format on
+
 #include <algorithm>
+#include <condition_variable>
 #include <iomanip>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -19,14 +28,120 @@
 
 #include <osquery/core.h>
 #include <osquery/filesystem.h>
+#include <osquery/flags.h>
 #include <osquery/status.h>
 
 #include "osquery/core/hashing.h"
+#include "osquery/filesystem/fileops.h"
 
 namespace osquery {
 
+DECLARE_uint64(read_max);
+DECLARE_bool(disable_forensic);
+
+FLAG(bool,
+     disable_hash_cache,
+     false,
+     "Cache calculated file hashes, re-calculate only if inode times change");
+
+FLAG(uint32, hash_cache_max, 500, "Size of LRU file hash cache");
+
 /// The buffer read size from file IO to hashing structures.
-const size_t kHashChunkSize{4096};
+const size_t kHashChunkSize{64 * 1024};
+
+/// Clear this amount of rows every time cache eviction is triggered.
+const size_t kHashCacheEvictSize{5};
+
+namespace {
+/**
+ * @brief Chunk hand-off between a file reader and digest worker threads.
+ *
+ * The reading thread publishes each chunk by bumping the generation counter,
+ * every worker updates its digest from the shared buffer, then the reader
+ * waits for all workers before reusing the buffer for the next read.
+ */
+struct HashPipeline {
+  std::mutex mutex;
+
+  /// Wakes the workers when a new chunk generation is published.
+  std::condition_variable chunk_notify;
+
+  /// Wakes the reader when every worker has consumed the current chunk.
+  std::condition_variable done_notify;
+
+  /// The published chunk, owned by the file read callback.
+  const char* buffer{nullptr};
+  size_t size{0};
+
+  /// Sequence number of the published chunk.
+  size_t generation{0};
+
+  /// Number of workers finished with the published chunk.
+  size_t consumed{0};
+
+  /// Set once the file content is exhausted.
+  bool finished{false};
+};
+
+/// Digests cached for one observed file state.
+struct HashCacheEntry {
+  /// The algorithms computed for this state, possibly merged across requests.
+  int mask{0};
+
+  /// The cached digests.
+  MultiHashes hashes;
+
+  /// For eviction, the last time this cache entry was used.
+  size_t access_time{0};
+};
+
+/// A digest pass some consumer is currently running for a file state.
+struct InFlightHash {
+  /// Wakes coalesced waiters once the pass completes.
+  std::condition_variable done_notify;
+
+  /// Set when the digest pass has finished (successfully or not).
+  bool done{false};
+
+  /// The algorithms the pass computed.
+  int mask{0};
+
+  /// The completed digests, copied to waiters.
+  MultiHashes hashes;
+};
+} // namespace
+
+#if defined(WIN32)
+#define stat _stat
+#endif
+
+static void hashPipelineWorker(HashPipeline& pipeline,
+                               Hash& hash,
+                               size_t workers) {
+  size_t seen = 0;
+  std::unique_lock<std::mutex> lock(pipeline.mutex);
+  while (true) {
+    pipeline.chunk_notify.wait(lock, [&pipeline, &seen]() {
+      return pipeline.finished || pipeline.generation != seen;
+    });
+    if (pipeline.generation == seen) {
+      // Finished, and no unconsumed chunk remains.
+      return;
+    }
+
+    seen = pipeline.generation;
+    auto* buffer = pipeline.buffer;
+    auto size = pipeline.size;
+
+    lock.unlock();
+    hash.update(buffer, size);
+    lock.lock();
+
+    if (++pipeline.consumed == workers) {
+      pipeline.done_notify.notify_one();
+    }
+  }
+}
 
 Hash::~Hash() {
   if (ctx_ != nullptr) {
@@ -91,27 +206,132 @@ std::string hashFromBuffer(HashType hash_type,
   return hash.digest();
 }
 
+/**
+ * @brief Attempt to hash a file through a read-only memory mapping.
+ *
+ * A mapped file feeds every requested digest straight from the page cache,
+ * without intermediate read buffers, and the digests can walk the shared
+ * mapping concurrently. Returns false when the file cannot be mapped (an
+ * empty or special file, or one exceeding the read limits), in which case the
+ * caller falls back to the buffered read path.
+ */
+static bool hashMappedFile(const std::string& path,
+                           std::map<HashType, std::shared_ptr<Hash>>& hashes) {
+  if (hashes.empty()) {
+    return false;
+  }
+
+  PlatformFile source(path, PF_OPEN_EXISTING | PF_READ);
+  if (!source.isValid() || source.isSpecialFile() ||
+      source.size() > FLAGS_read_max) {
+    return false;
+  }
+
+  PlatformTime times;
+  source.getFileTimes(times);
+
+  {
+    PlatformFileMapping map(source);
+    if (!map.isValid()) {
+      return false;
+    }
+
+    // Each additional digest walks the shared mapping on its own thread.
+    std::vector<std::thread> threads;
+    for (auto hash = std::next(hashes.begin()); hash != hashes.end(); ++hash) {
+      auto& worker_hash = *hash->second;
+      threads.push_back(std::thread([&worker_hash, &map]() {
+        worker_hash.update(map.data(), map.size());
+      }));
+    }
+
+    hashes.begin()->second->update(map.data(), map.size());
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  // Attempt to restore the atime and mtime from before the content faults.
+  if (!FLAGS_disable_forensic) {
+    source.setFileTimes(times);
+  }
+  return true;
+}
+
 MultiHashes hashMultiFromFile(int mask, const std::string& path) {
-  std::map<HashType, std::shared_ptr<Hash>> hashes = {
-      {HASH_TYPE_MD5, std::make_shared<Hash>(HASH_TYPE_MD5)},
-      {HASH_TYPE_SHA1, std::make_shared<Hash>(HASH_TYPE_SHA1)},
-      {HASH_TYPE_SHA256, std::make_shared<Hash>(HASH_TYPE_SHA256)},
-  };
+  std::map<HashType, std::shared_ptr<Hash>> hashes;
+  for (const auto& hash_type :
+       {HASH_TYPE_MD5, HASH_TYPE_SHA1, HASH_TYPE_SHA256}) {
+    if (mask & hash_type) {
+      hashes[hash_type] = std::make_shared<Hash>(hash_type);
+    }
+  }
 
   auto blocking = isPlatform(PlatformType::TYPE_WINDOWS);
-  auto s = readFile(path,
-                    0,
-                    kHashChunkSize,
-                    false,
-                    true,
-                    ([&hashes, &mask](std::string& buffer, size_t size) {
-                      for (auto& hash : hashes) {
-                        if (mask & hash.first) {
-                          hash.second->update(&buffer[0], size);
-                        }
-                      }
-                    }),
-                    blocking);
+  Status s;
+  if (hashMappedFile(path, hashes)) {
+    s = Status(0, "OK");
+  } else if (hashes.size() <= 1) {
+    s = readFile(path,
+                 0,
+                 kHashChunkSize,
+                 false,
+                 true,
+                 ([&hashes](std::string& buffer, size_t size) {
+                   for (auto& hash : hashes) {
+                     hash.second->update(&buffer[0], size);
+                   }
+                 }),
+                 blocking);
+  } else {
+    // Multiple digests were requested: update the first on the reading thread
+    // and each remaining digest on its own worker, so triple-hashing costs
+    // about as much wall time as the slowest single digest.
+    HashPipeline pipeline;
+    size_t workers = hashes.size() - 1;
+
+    std::vector<std::thread> threads;
+    for (auto hash = std::next(hashes.begin()); hash != hashes.end(); ++hash) {
+      auto& worker_hash = *hash->second;
+      threads.push_back(std::thread([&pipeline, &worker_hash, workers]() {
+        hashPipelineWorker(pipeline, worker_hash, workers);
+      }));
+    }
+
+    auto& reader_hash = *hashes.begin()->second;
+    s = readFile(
+        path,
+        0,
+        kHashChunkSize,
+        false,
+        true,
+        ([&pipeline, &reader_hash, workers](std::string& buffer, size_t size) {
+          std::unique_lock<std::mutex> lock(pipeline.mutex);
+          pipeline.buffer = &buffer[0];
+          pipeline.size = size;
+          pipeline.consumed = 0;
+          pipeline.generation++;
+          pipeline.chunk_notify.notify_all();
+
+          lock.unlock();
+          reader_hash.update(&buffer[0], size);
+          lock.lock();
+
+          pipeline.done_notify.wait(lock, [&pipeline, workers]() {
+            return pipeline.consumed == workers;
+          });
+        }),
+        blocking);
+
+    {
+      std::lock_guard<std::mutex> lock(pipeline.mutex);
+      pipeline.finished = true;
+      pipeline.chunk_notify.notify_all();
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
 
   MultiHashes mh = {};
   if (!s.ok()) {
@@ -131,6 +351,92 @@ MultiHashes hashMultiFromFile(int mask, const std::string& path) {
   return mh;
 }
 
+MultiHashes hashMultiFromFileCached(int mask, const std::string& path) {
+  if (FLAGS_disable_hash_cache || FLAGS_hash_cache_max == 0) {
+    return hashMultiFromFile(mask, path);
+  }
+
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    // The target cannot be keyed; the direct path reports the read failure.
+    return hashMultiFromFile(mask, path);
+  }
+
+  // The key captures one observed file state: any content change moves the
+  // modification time or size, and a replaced file moves the inode. Hard
+  // links and renames of unchanged content share a single entry.
+  auto key = std::to_string(static_cast<uint64_t>(st.st_dev)) + ':' +
+             std::to_string(static_cast<uint64_t>(st.st_ino)) + ':' +
+             std::to_string(static_cast<uint64_t>(st.st_mtime)) + ':' +
+             std::to_string(static_cast<uint64_t>(st.st_size));
+
+  static std::mutex cache_mutex;
+  static std::unordered_map<std::string, HashCacheEntry> cache;
+  static std::unordered_map<std::string, std::shared_ptr<InFlightHash>>
+      in_flight;
+
+  std::unique_lock<std::mutex> lock(cache_mutex);
+  while (true) {
+    auto entry = cache.find(key);
+    if (entry != cache.end() && (entry->second.mask & mask) == mask) {
+      entry->second.access_time = getUnixTime();
+      return entry->second.hashes;
+    }
+
+    auto running = in_flight.find(key);
+    if (running == in_flight.end()) {
+      break;
+    }
+
+    // Another consumer is digesting this file state: wait for its result
+    // rather than starting a second read pass over the same content.
+    auto pass = running->second;
+    pass->done_notify.wait(lock, [&pass]() { return pass->done; });
+    if ((pass->mask & mask) == mask) {
+      return pass->hashes;
+    }
+    // The completed pass missed a requested algorithm; check the cache again.
+  }
+
+  auto pass = std::make_shared<InFlightHash>();
+  in_flight[key] = pass;
+
+  // Fold in any algorithms already cached so the merged entry supersedes.
+  auto full_mask = mask;
+  auto entry = cache.find(key);
+  if (entry != cache.end()) {
+    full_mask |= entry->second.mask;
+  }
+
+  lock.unlock();
+  auto hashes = hashMultiFromFile(full_mask, path);
+  lock.lock();
+
+  pass->mask = full_mask;
+  pass->hashes = hashes;
+  pass->done = true;
+  pass->done_notify.notify_all();
+  in_flight.erase(key);
+
+  if (!hashes.md5.empty() || !hashes.sha1.empty() || !hashes.sha256.empty()) {
+    if (cache.size() >= FLAGS_hash_cache_max) {
+      // Too large: evict the least-recently used entries.
+      for (size_t i = 0; i < kHashCacheEvictSize && !cache.empty(); i++) {
+        auto victim = cache.begin();
+        for (auto it = cache.begin(); it != cache.end(); ++it) {
+          if (it->second.access_time < victim->second.access_time) {
+            victim = it;
+          }
+        }
+        cache.erase(victim);
+      }
+    }
+    cache[key] = {full_mask, std::move(hashes), getUnixTime()};
+    return cache[key].hashes;
+  }
+  return hashes;
+}
+
 std::string hashFromFile(HashType hash_type, const std::string& path) {
   auto hashes = hashMultiFromFile(hash_type, path);
   if (hash_type == HASH_TYPE_MD5) {
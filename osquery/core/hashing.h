@@ -120,6 +120,22 @@ std::string hashFromFile(HashType hash_type, const std::string& path);
  */
 MultiHashes hashMultiFromFile(int mask, const std::string& path);
 
+/**
+ * @brief Hash a file through the process-wide file-state cache.
+ *
+ * Digests are cached against the file's device, inode, modification time,
+ * and size, so repeated requests for an unchanged file from any subsystem
+ * (the hash table, event enrichment) share one read+digest pass. Concurrent
+ * requests for the same file state coalesce: late arrivals wait for the
+ * in-flight digest instead of reading the content a second time.
+ *
+ * @param mask Bitmask specifying target osquery-supported algorithms.
+ * @param path Filesystem path (the hash target).
+ * @return A struct containing string (hex) representations
+ *         of the hash digests.
+ */
+MultiHashes hashMultiFromFileCached(int mask, const std::string& path);
+
 /**
  * @brief Compute a hash digest from the contents of a buffer.
  *
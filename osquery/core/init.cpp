@@ -44,6 +44,7 @@
 #include <osquery/filesystem.h>
 #include <osquery/flags.h>
 #include <osquery/logger.h>
+#include <osquery/packs.h>
 #include <osquery/registry.h>
 #include <osquery/system.h>
 
@@ -179,6 +180,7 @@ DECLARE_string(logger_plugin);
 DECLARE_string(distributed_plugin);
 DECLARE_bool(config_check);
 DECLARE_bool(config_dump);
+DECLARE_bool(check_packs);
 DECLARE_bool(database_dump);
 DECLARE_string(database_path);
 DECLARE_bool(disable_distributed);
@@ -211,6 +213,57 @@ const size_t kDatabaseRetryDelay{200};
 std::function<void()> Initializer::shutdown_{nullptr};
 RecursiveMutex Initializer::shutdown_mutex_;
 
+/// An approximation of the process start, anchored at static initialization.
+const chrono_clock::time_point kStartupTimePoint{chrono_clock::now()};
+
+/// Protects additions to the startup phase trace.
+Mutex kStartupPhasesMutex;
+
+/// Phase spans recorded during Initializer::start.
+std::vector<StartupPhase> kStartupPhases;
+
+void recordStartupPhase(const std::string& name,
+                        uint64_t start,
+                        uint64_t duration) {
+  WriteLock lock(kStartupPhasesMutex);
+  kStartupPhases.push_back({name, start, duration});
+}
+
+std::vector<StartupPhase> getStartupPhases() {
+  WriteLock lock(kStartupPhasesMutex);
+  return kStartupPhases;
+}
+
+/**
+ * @brief Record the span of an initialization phase for osquery_startup_trace.
+ *
+ * Scope an expensive portion of Initializer::start with this class to have
+ * the elapsed time recorded when the scope ends.
+ */
+class StartupPhaseScope : private boost::noncopyable {
+ public:
+  explicit StartupPhaseScope(std::string name)
+      : name_(std::move(name)), begin_(chrono_clock::now()) {}
+
+  ~StartupPhaseScope() {
+    auto us = [](const chrono_clock::time_point& from,
+                 const chrono_clock::time_point& to) {
+      return static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::microseconds>(to - from)
+              .count());
+    };
+    recordStartupPhase(
+        name_, us(kStartupTimePoint, begin_), us(begin_, chrono_clock::now()));
+  }
+
+ private:
+  /// Phase name reported in the trace.
+  std::string name_;
+
+  /// Time point captured when the scope was entered.
+  chrono_clock::time_point begin_;
+};
+
 static inline void printUsage(const std::string& binary, ToolType tool) {
   // Parse help options before gflags. Only display osquery-related options.
   fprintf(stdout, DESCRIPTION, kVersion.c_str());
@@ -345,6 +398,10 @@ Initializer::Initializer(int& argc, char**& argv, ToolType tool)
   // Let gflags parse the non-help options/flags.
   GFLAGS_NAMESPACE::ParseCommandLineFlags(argc_, argv_, isShell());
 
+  // Parsing wrote the gflags storage directly; reload the FastFlag handles
+  // so command-line and flagfile values reach their bound readers.
+  Flag::refreshFastFlags();
+
   bool init_glog = true;
 #ifdef FBTHRIFT
   init_glog = false;
@@ -382,7 +439,7 @@ Initializer::Initializer(int& argc, char**& argv, ToolType tool)
   }
 
   // If the caller is checking configuration, disable the watchdog/worker.
-  if (FLAGS_config_check) {
+  if (FLAGS_config_check || FLAGS_check_packs) {
     FLAGS_disable_watchdog = true;
   }
 
@@ -413,7 +470,7 @@ void Initializer::initDaemon() const {
     return;
   }
 
-  if (FLAGS_config_check) {
+  if (FLAGS_config_check || FLAGS_check_packs) {
     // No need to daemonize, emit log lines, or create process mutexes.
     return;
   }
@@ -586,7 +643,7 @@ void Initializer::start() const {
   // Pre-extension manager initialization options checking.
   // If the shell or daemon does not need extensions and it will exit quickly,
   // prefer to disable the extension manager.
-  if ((FLAGS_config_check || FLAGS_config_dump) &&
+  if ((FLAGS_config_check || FLAGS_config_dump || FLAGS_check_packs) &&
       !Watcher::get().hasManagedExtensions()) {
     FLAGS_disable_extensions = true;
   }
@@ -595,6 +652,7 @@ void Initializer::start() const {
   // If there are spurious access then warning logs will be emitted since the
   // set-allow-open will never be called.
   if (!isWatcher()) {
+    StartupPhaseScope phase("database_open");
     DatabasePlugin::setAllowOpen(true);
     // A daemon must always have R/W access to the database.
     DatabasePlugin::setRequireWrite(isDaemon());
@@ -625,7 +683,11 @@ void Initializer::start() const {
   // Bind to an extensions socket and wait for registry additions.
   // After starting the extension manager, osquery MUST shutdown using the
   // internal 'shutdown' method.
-  auto s = osquery::startExtensionManager();
+  Status s;
+  {
+    StartupPhaseScope phase("extensions_start");
+    s = osquery::startExtensionManager();
+  }
   if (!s.ok()) {
     auto severity = (Watcher::get().hasManagedExtensions()) ? google::GLOG_ERROR
                                                             : google::GLOG_INFO;
@@ -637,11 +699,14 @@ void Initializer::start() const {
     }
   }
 
-  // Then set the config plugin, which uses a single/active plugin.
-  initActivePlugin("config", FLAGS_config_plugin);
+  {
+    StartupPhaseScope phase("registry_setup");
+    // Then set the config plugin, which uses a single/active plugin.
+    initActivePlugin("config", FLAGS_config_plugin);
 
-  // Run the setup for all lazy registries (tables, SQL).
-  Registry::setUp();
+    // Run the setup for any remaining non-lazy registries.
+    Registry::setUp();
+  }
 
   if (FLAGS_config_check) {
     // The initiator requested an initialization and config check.
@@ -660,7 +725,10 @@ void Initializer::start() const {
   }
 
   // Load the osquery config using the default/active config plugin.
-  s = Config::get().load();
+  {
+    StartupPhaseScope phase("config_load");
+    s = Config::get().load();
+  }
   if (!s.ok()) {
     auto message = "Error reading config: " + s.toString();
     if (isDaemon()) {
@@ -670,11 +738,20 @@ void Initializer::start() const {
     }
   }
 
+  if (FLAGS_check_packs) {
+    // The initiator requested a static analysis of the loaded schedule.
+    // Like a configuration check, the report exits the application.
+    requestShutdown(checkQueryPacks().getCode());
+  }
+
   // Initialize the status and result plugin logger.
-  if (!FLAGS_disable_logging) {
-    initActivePlugin("logger", FLAGS_logger_plugin);
+  {
+    StartupPhaseScope phase("logger_init");
+    if (!FLAGS_disable_logging) {
+      initActivePlugin("logger", FLAGS_logger_plugin);
+    }
+    initLogger(binary_);
   }
-  initLogger(binary_);
 
   // Initialize the distributed plugin, if necessary
   if (!FLAGS_disable_distributed) {
@@ -682,7 +759,10 @@ void Initializer::start() const {
   }
 
   // Start event threads.
-  osquery::attachEvents();
+  {
+    StartupPhaseScope phase("events_attach");
+    osquery::attachEvents();
+  }
   EventFactory::delay();
 }
 
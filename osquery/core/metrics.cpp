@@ -0,0 +1,83 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <atomic>
+
+#include <boost/noncopyable.hpp>
+
+#include <osquery/mutex.h>
+
+#include "osquery/core/metrics.h"
+
+namespace osquery {
+
+/**
+ * @brief Process-wide registry behind metricAdd/metricSet.
+ *
+ * Metric names are few and created once; node-based map storage keeps the
+ * atomic cells address-stable, so the shared lock is only held to find or
+ * create a cell and never across the update itself.
+ */
+class MetricsRegistry : private boost::noncopyable {
+ public:
+  static MetricsRegistry& get() {
+    static MetricsRegistry instance;
+    return instance;
+  }
+
+  std::atomic<size_t>& cell(const std::string& name) {
+    {
+      ReadLock lock(mutex_);
+      auto it = metrics_.find(name);
+      if (it != metrics_.end()) {
+        return it->second;
+      }
+    }
+
+    WriteLock lock(mutex_);
+    return metrics_[name];
+  }
+
+  std::map<std::string, size_t> snapshot() {
+    std::map<std::string, size_t> values;
+    ReadLock lock(mutex_);
+    for (const auto& metric : metrics_) {
+      values[metric.first] = metric.second.load();
+    }
+    return values;
+  }
+
+ private:
+  MetricsRegistry() = default;
+
+ private:
+  /// Protect cell creation and snapshot iteration.
+  Mutex mutex_;
+
+  /// Metric cells, keyed by name; addresses are stable once created.
+  std::map<std::string, std::atomic<size_t>> metrics_;
+};
+
+std::atomic<size_t>& metricCell(const std::string& name) {
+  return MetricsRegistry::get().cell(name);
+}
+
+void metricAdd(const std::string& name, size_t value) {
+  MetricsRegistry::get().cell(name).fetch_add(value);
+}
+
+void metricSet(const std::string& name, size_t value) {
+  MetricsRegistry::get().cell(name).store(value);
+}
+
+std::map<std::string, size_t> getMetricsSnapshot() {
+  return MetricsRegistry::get().snapshot();
+}
+} // namespace osquery
@@ -0,0 +1,47 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <string>
+
+namespace osquery {
+
+/**
+ * @brief Add a value to a named operational counter.
+ *
+ * Counters accumulate monotonically (event drops, retries). The first use
+ * of a name creates the counter under a lock; every later update is a
+ * single atomic add, so instrumented hot paths pay no lock cost.
+ */
+void metricAdd(const std::string& name, size_t value = 1);
+
+/**
+ * @brief Set a named operational gauge to its current value.
+ *
+ * Gauges report levels (queue depths, memory footprints) and overwrite the
+ * previous value. Creation and update costs match metricAdd.
+ */
+void metricSet(const std::string& name, size_t value);
+
+/**
+ * @brief Resolve a metric cell once for repeated lock-free updates.
+ *
+ * The hottest call sites (per-event paths) should resolve their cell into
+ * a function-local static and update it directly, skipping the name lookup
+ * entirely. The returned reference remains valid for the process lifetime.
+ */
+std::atomic<size_t>& metricCell(const std::string& name);
+
+/// Copy out the current value of every counter and gauge.
+std::map<std::string, size_t> getMetricsSnapshot();
+} // namespace osquery
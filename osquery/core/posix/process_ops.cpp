@@ -79,6 +79,34 @@ void setToBackgroundPriority() {
   setpriority(PRIO_PGRP, 0, 10);
 }
 
+void setThreadToBackgroundPriority() {
+#if defined(__APPLE__)
+  setpriority(PRIO_DARWIN_THREAD, 0, PRIO_DARWIN_BG);
+#else
+  // On Linux a 'who' of 0 with PRIO_PROCESS targets the calling thread.
+  setpriority(PRIO_PROCESS, 0, 19);
+#if defined(__linux__)
+  // IOPRIO_WHO_PROCESS with a 0 'who' also targets the calling thread.
+  // (IOPRIO_CLASS_IDLE << 13) is an idle-class per-thread I/O priority.
+  syscall(SYS_ioprio_set, 1, 0, (3 << 13));
+#endif
+#endif
+}
+
+void setThreadToNormalPriority() {
+#if defined(__APPLE__)
+  setpriority(PRIO_DARWIN_THREAD, 0, 0);
+#else
+  // Restore the process-wide nice value (10 when running under a watchdog).
+  setpriority(PRIO_PROCESS, 0, getpriority(PRIO_PROCESS, getpid()));
+#if defined(__linux__)
+  // Mirror the main thread's I/O priority, which reflects any watchdog or
+  // tool-requested process-wide class (idle when under a watchdog).
+  syscall(SYS_ioprio_set, 1, 0, syscall(SYS_ioprio_get, 1, getpid()));
+#endif
+#endif
+}
+
 // Helper function to determine if thread is running with admin privilege.
 bool isUserAdmin() {
   return getuid() == 0;
@@ -277,6 +277,19 @@ bool isLauncherProcessDead(PlatformProcess& launcher);
 /// Sets the current process to run with background scheduling priority.
 void setToBackgroundPriority();
 
+/**
+ * @brief Moves the calling thread onto a background execution lane.
+ *
+ * The thread is given the lowest CPU scheduling priority, and on platforms
+ * that support per-thread I/O classes, idle I/O priority. Use
+ * setThreadToNormalPriority to restore the thread, since pooled threads are
+ * reused for foreground work.
+ */
+void setThreadToBackgroundPriority();
+
+/// Restores a thread previously placed on the background lane.
+void setThreadToNormalPriority();
+
 /**
  * @brief Returns the current processes pid
  *
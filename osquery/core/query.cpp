@@ -9,14 +9,21 @@
  */
 
 #include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <set>
 #include <string>
 #include <vector>
 
+#include <zlib.h>
+
 #include <osquery/database.h>
 #include <osquery/flags.h>
 #include <osquery/logger.h>
+#include <osquery/mutex.h>
 #include <osquery/query.h>
 
+#include "osquery/core/alloc_tracking.h"
 #include "osquery/core/json.h"
 
 namespace rj = rapidjson;
@@ -25,7 +32,55 @@ namespace osquery {
 
 DECLARE_bool(decorations_top_level);
 
+/// Leading byte of binary-encoded results; never the start of a JSON array.
+const char kQueryDataBinaryMagic{'\0'};
+
+/// Version byte of the binary results encoding.
+const char kQueryDataBinaryVersion{'\x01'};
+
+/// Cell length sentinel marking a column absent from a row.
+const uint32_t kQueryDataCellAbsent{0xffffffffU};
+
+/**
+ * @brief In-memory per-run metadata of previously stored scheduled queries.
+ *
+ * The epoch, invocation counter, and stored query string are consulted at
+ * the start of every scheduled run. Keeping them hot between runs avoids
+ * three point reads and a full key scan per run; the per-key database
+ * copies remain the source of truth across restarts and seed the cache on
+ * first use.
+ */
+struct QueryMetadata {
+  /// Epoch stored alongside the current result baseline.
+  uint64_t epoch{0};
+
+  /// Invocation counter of the previous run.
+  uint64_t counter{0};
+
+  /// Stored query string, compared to detect altered schedule entries.
+  std::string query;
+};
+
+static Mutex kQueryMetadataMutex;
+static std::map<std::string, QueryMetadata> kQueryMetadataCache;
+
+/// Copy out a query's cached metadata, false if the query is not cached.
+static bool getQueryMetadata(const std::string& name, QueryMetadata& meta) {
+  WriteLock lock(kQueryMetadataMutex);
+  auto it = kQueryMetadataCache.find(name);
+  if (it == kQueryMetadataCache.end()) {
+    return false;
+  }
+  meta = it->second;
+  return true;
+}
+
 uint64_t Query::getPreviousEpoch() const {
+  QueryMetadata meta;
+  if (getQueryMetadata(name_, meta)) {
+    return meta.epoch;
+  }
+
   uint64_t epoch = 0;
   std::string raw;
   auto status = getDatabaseValue(kQueries, name_ + "epoch", raw);
@@ -35,12 +90,17 @@ uint64_t Query::getPreviousEpoch() const {
   return epoch;
 }
 
-uint64_t Query::getQueryCounter(bool new_query) const {
-  uint64_t counter = 0;
-  if (new_query) {
-    return counter;
+uint64_t Query::incrementCounter(bool reset) const {
+  if (reset) {
+    return 0;
+  }
+
+  QueryMetadata meta;
+  if (getQueryMetadata(name_, meta)) {
+    return meta.counter + 1;
   }
 
+  uint64_t counter = 0;
   std::string raw;
   auto status = getDatabaseValue(kQueries, name_ + "counter", raw);
   if (status.ok()) {
@@ -49,14 +109,356 @@ uint64_t Query::getQueryCounter(bool new_query) const {
   return counter;
 }
 
-Status Query::getPreviousQueryResults(QueryDataSet& results) const {
+uint64_t computeRowHash(const Row& r) {
+  // FNV-1a; the constants are fixed so hashes are comparable across runs.
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  auto mix = [&hash](const std::string& content) {
+    for (const auto& c : content) {
+      hash ^= static_cast<uint64_t>(static_cast<unsigned char>(c));
+      hash *= 0x100000001b3ULL;
+    }
+    // Mix a field separator so adjacent fields cannot be concatenated into
+    // a colliding pair.
+    hash ^= 0x1fULL;
+    hash *= 0x100000001b3ULL;
+  };
+
+  for (const auto& cell : r) {
+    mix(cell.first);
+    mix(cell.second);
+  }
+  return hash;
+}
+
+void QueryHistogram::add(uint64_t value) {
+  // Bucket by bit width: bucket 0 holds only 0, bucket i holds values in
+  // [2^(i-1), 2^i - 1].
+  size_t bucket = 0;
+  while (value > 0) {
+    value >>= 1;
+    bucket++;
+  }
+  if (bucket >= buckets.size()) {
+    bucket = buckets.size() - 1;
+  }
+  buckets[bucket] += 1;
+  samples += 1;
+}
+
+uint64_t QueryHistogram::percentile(size_t p) const {
+  if (samples == 0) {
+    return 0;
+  }
+
+  // Rank of the requested percentile, rounded up, at least the first sample.
+  auto rank = (p * samples + 99) / 100;
+  if (rank == 0) {
+    rank = 1;
+  }
+
+  size_t seen = 0;
+  for (size_t i = 0; i < buckets.size(); i++) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      // Report the inclusive upper bound of the matched bucket.
+      return (i == 0) ? 0 : (1ULL << i) - 1;
+    }
+  }
+  return std::numeric_limits<uint64_t>::max();
+}
+
+std::string QueryHistogram::serialize() const {
   std::string raw;
-  auto status = getDatabaseValue(kQueries, name_, raw);
+  for (const auto& count : buckets) {
+    if (!raw.empty()) {
+      raw += ',';
+    }
+    raw += std::to_string(count);
+  }
+  return raw;
+}
+
+void QueryHistogram::deserialize(const std::string& raw) {
+  buckets.fill(0);
+  samples = 0;
+
+  size_t bucket = 0;
+  size_t offset = 0;
+  while (offset < raw.size() && bucket < buckets.size()) {
+    auto next = raw.find(',', offset);
+    if (next == std::string::npos) {
+      next = raw.size();
+    }
+    // Malformed counts parse as 0 rather than throwing on a corrupt value.
+    size_t count = std::strtoull(raw.c_str() + offset, nullptr, 10);
+    buckets[bucket] = count;
+    samples += count;
+    bucket++;
+    offset = next + 1;
+  }
+}
+
+std::string QueryPerformance::serialize() const {
+  std::string raw;
+  raw += std::to_string(executions) + ',';
+  raw += std::to_string(last_executed) + ',';
+  raw += std::to_string(wall_time) + ',';
+  raw += std::to_string(user_time) + ',';
+  raw += std::to_string(system_time) + ',';
+  raw += std::to_string(average_memory) + ',';
+  raw += std::to_string(output_size);
+  raw += ';';
+  raw += wall_time_hist.serialize();
+  raw += ';';
+  raw += memory_hist.serialize();
+  return raw;
+}
+
+void QueryPerformance::deserialize(const std::string& raw) {
+  auto first = raw.find(';');
+  auto second = (first == std::string::npos) ? first : raw.find(';', first + 1);
+  if (second == std::string::npos) {
+    return;
+  }
+
+  // The counters are fixed-order; malformed values parse as 0.
+  std::array<unsigned long long, 7> counters{{}};
+  size_t offset = 0;
+  for (auto& counter : counters) {
+    if (offset >= first) {
+      break;
+    }
+    counter = std::strtoull(raw.c_str() + offset, nullptr, 10);
+    auto next = raw.find(',', offset);
+    offset = (next == std::string::npos) ? first : next + 1;
+  }
+
+  executions = static_cast<size_t>(counters[0]);
+  last_executed = static_cast<size_t>(counters[1]);
+  wall_time = counters[2];
+  user_time = counters[3];
+  system_time = counters[4];
+  average_memory = counters[5];
+  output_size = counters[6];
+
+  wall_time_hist.deserialize(raw.substr(first + 1, second - first - 1));
+  memory_hist.deserialize(raw.substr(second + 1));
+}
+
+/// Hash every row of a result set into the compact differential form.
+static std::multiset<uint64_t> computeRowHashes(const QueryData& qd) {
+  std::multiset<uint64_t> hashes;
+  for (const auto& r : qd) {
+    hashes.insert(computeRowHash(r));
+  }
+  return hashes;
+}
+
+/// Pack an ordered hash set into a comma-separated database value.
+static std::string serializeRowHashes(const std::multiset<uint64_t>& hashes) {
+  std::string raw;
+  for (const auto& hash : hashes) {
+    if (!raw.empty()) {
+      raw += ',';
+    }
+    raw += std::to_string(hash);
+  }
+  return raw;
+}
+
+/**
+ * @brief In-memory row hash summaries of the previous scheduled query runs.
+ *
+ * The summary for each query name is kept hot between runs so the common
+ * all-rows-unchanged differential is confirmed with a pass over the current
+ * rows only, without any backing store read. The database copy remains the
+ * source of truth across restarts and seeds the cache on first use.
+ */
+static Mutex kRowHashCacheMutex;
+static std::map<std::string, std::multiset<uint64_t>> kRowHashCache;
+
+FLAG(uint64,
+     query_baseline_cache_size,
+     0,
+     "Bytes of compressed previous query results to cache in memory, "
+     "0 to disable");
+
+/**
+ * @brief Compressed in-memory baselines of previous scheduled query results.
+ *
+ * A differential run that does observe changed rows must read back the
+ * entire previous result set. This cache keeps the serialized previous
+ * results deflate-compressed in memory, bounded by a byte budget with
+ * least-recently-used eviction, so back-to-back differentials of large
+ * results skip the backing store read. The database copy remains the
+ * source of truth and serves queries evicted or lost across restarts.
+ */
+struct QueryBaseline {
+  /// Deflate-compressed serialized result set.
+  std::string compressed;
+
+  /// Size of the serialized form, needed to size the inflate output.
+  size_t raw_size{0};
+
+  /// Increasing use counter for least-recently-used eviction.
+  size_t last_use{0};
+};
+
+static Mutex kBaselineCacheMutex;
+static std::map<std::string, QueryBaseline> kBaselineCache;
+static size_t kBaselineCacheBytes{0};
+static size_t kBaselineCacheUse{0};
+
+/// Remove a query's baseline and release its share of the byte budget.
+static void evictQueryBaseline(
+    std::map<std::string, QueryBaseline>::iterator it) {
+  kBaselineCacheBytes -= it->second.compressed.size();
+  kBaselineCache.erase(it);
+}
+
+/// Compress and store a serialized result set, evicting into the budget.
+static void cacheQueryBaseline(const std::string& name,
+                               const std::string& serialized) {
+  auto budget = static_cast<size_t>(FLAGS_query_baseline_cache_size);
+  if (budget == 0 || serialized.empty()) {
+    return;
+  }
+
+  uLongf compressed_size = compressBound(serialized.size());
+  std::string compressed(compressed_size, '\0');
+  if (compress2(reinterpret_cast<Bytef*>(&compressed[0]),
+                &compressed_size,
+                reinterpret_cast<const Bytef*>(serialized.data()),
+                serialized.size(),
+                Z_BEST_SPEED) != Z_OK ||
+      compressed_size > budget) {
+    return;
+  }
+  compressed.resize(compressed_size);
+
+  WriteLock lock(kBaselineCacheMutex);
+  auto previous = kBaselineCache.find(name);
+  if (previous != kBaselineCache.end()) {
+    evictQueryBaseline(previous);
+  }
+
+  while (kBaselineCacheBytes + compressed.size() > budget &&
+         !kBaselineCache.empty()) {
+    auto victim = kBaselineCache.begin();
+    for (auto it = kBaselineCache.begin(); it != kBaselineCache.end(); ++it) {
+      if (it->second.last_use < victim->second.last_use) {
+        victim = it;
+      }
+    }
+    evictQueryBaseline(victim);
+  }
+
+  kBaselineCacheBytes += compressed.size();
+  auto& entry = kBaselineCache[name];
+  entry.compressed = std::move(compressed);
+  entry.raw_size = serialized.size();
+  entry.last_use = ++kBaselineCacheUse;
+}
+
+/// Restore a cached serialized result set, true only on a usable hit.
+static bool getQueryBaseline(const std::string& name,
+                             std::string& serialized) {
+  if (FLAGS_query_baseline_cache_size == 0) {
+    return false;
+  }
+
+  WriteLock lock(kBaselineCacheMutex);
+  auto it = kBaselineCache.find(name);
+  if (it == kBaselineCache.end()) {
+    return false;
+  }
+  it->second.last_use = ++kBaselineCacheUse;
+
+  serialized.resize(it->second.raw_size);
+  uLongf raw_size = it->second.raw_size;
+  if (uncompress(reinterpret_cast<Bytef*>(&serialized[0]),
+                 &raw_size,
+                 reinterpret_cast<const Bytef*>(it->second.compressed.data()),
+                 it->second.compressed.size()) != Z_OK ||
+      raw_size != it->second.raw_size) {
+    // An unusable entry falls back to the backing store copy.
+    evictQueryBaseline(it);
+    return false;
+  }
+  return true;
+}
+
+void clearQueryRowHashCache(const std::string& name) {
+  {
+    WriteLock lock(kRowHashCacheMutex);
+    kRowHashCache.erase(name);
+  }
+
+  {
+    WriteLock lock(kQueryMetadataMutex);
+    kQueryMetadataCache.erase(name);
+  }
+
+  WriteLock lock(kBaselineCacheMutex);
+  auto it = kBaselineCache.find(name);
+  if (it != kBaselineCache.end()) {
+    evictQueryBaseline(it);
+  }
+}
+
+Status Query::getPreviousRowHashes(std::multiset<uint64_t>& hashes) const {
+  {
+    WriteLock lock(kRowHashCacheMutex);
+    auto cached = kRowHashCache.find(name_);
+    if (cached != kRowHashCache.end()) {
+      hashes = cached->second;
+      return Status(0, "OK");
+    }
+  }
+
+  std::string raw;
+  auto status = getDatabaseValue(kQueries, name_ + "hashes", raw);
   if (!status.ok()) {
     return status;
   }
 
-  status = deserializeQueryDataJSON(raw, results);
+  size_t offset = 0;
+  while (offset < raw.size()) {
+    auto end = raw.find(',', offset);
+    if (end == std::string::npos) {
+      end = raw.size();
+    }
+    hashes.insert(std::stoull(raw.substr(offset, end - offset)));
+    offset = end + 1;
+  }
+
+  {
+    // Seed the cache so later runs skip the backing store read.
+    WriteLock lock(kRowHashCacheMutex);
+    kRowHashCache[name_] = hashes;
+  }
+  return Status(0, "OK");
+}
+
+Status Query::getPreviousQueryResults(QueryDataSet& results) const {
+  // A hot baseline avoids the backing store read entirely.
+  std::string raw;
+  Status status;
+  if (!getQueryBaseline(name_, raw)) {
+    status = getDatabaseValue(kQueries, name_, raw);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  // Results written before the binary encoding existed remain JSON arrays;
+  // the leading magic byte distinguishes the two. Each query's stored value
+  // migrates to the binary form the next time its results are replaced.
+  if (!raw.empty() && raw[0] == kQueryDataBinaryMagic) {
+    status = deserializeQueryDataBinary(raw, results);
+  } else {
+    status = deserializeQueryDataJSON(raw, results);
+  }
   if (!status.ok()) {
     return status;
   }
@@ -70,6 +472,12 @@ std::vector<std::string> Query::getStoredQueryNames() {
 }
 
 bool Query::isQueryNameInDatabase() const {
+  // A cached metadata entry exists only for queries already stored.
+  QueryMetadata meta;
+  if (getQueryMetadata(name_, meta)) {
+    return true;
+  }
+
   auto names = Query::getStoredQueryNames();
   return std::find(names.begin(), names.end(), name_) != names.end();
 }
@@ -80,6 +488,11 @@ static inline void saveQuery(const std::string& name,
 }
 
 bool Query::isNewQuery() const {
+  QueryMetadata meta;
+  if (getQueryMetadata(name_, meta)) {
+    return (meta.query != query_);
+  }
+
   std::string query;
   getDatabaseValue(kQueries, "query." + name_, query);
   return (query != query_);
@@ -121,50 +534,89 @@ Status Query::addNewResults(QueryData current_qd,
   // query data, otherwise the content is moved to the differential's added set.
   const auto* target_gd = &current_qd;
   bool update_db = true;
+  bool update_hashes = false;
+  std::multiset<uint64_t> current_hashes;
   if (!fresh_results && calculate_diff) {
-    // Get the rows from the last run of this query name.
-    QueryDataSet previous_qd;
-    auto status = getPreviousQueryResults(previous_qd);
-    if (!status.ok()) {
-      return status;
-    }
+    // Compare the compact per-row hash sets first. When the row set has not
+    // changed (the common steady state) this skips deserializing the entire
+    // previous result set, comparing 8 bytes per row instead of full rows.
+    current_hashes = computeRowHashes(current_qd);
+    std::multiset<uint64_t> previous_hashes;
+    auto hashes_status = getPreviousRowHashes(previous_hashes);
+    if (hashes_status.ok() && previous_hashes == current_hashes) {
+      update_db = false;
+    } else {
+      // Get the rows from the last run of this query name.
+      QueryDataSet previous_qd;
+      auto status = getPreviousQueryResults(previous_qd);
+      if (!status.ok()) {
+        return status;
+      }
 
-    // Calculate the differential between previous and current query results.
-    dr = diff(previous_qd, current_qd);
+      // Calculate the differential between previous and current query results.
+      dr = diff(previous_qd, current_qd);
 
-    update_db = (!dr.added.empty() || !dr.removed.empty());
+      update_db = (!dr.added.empty() || !dr.removed.empty());
+      // A stable result set with a missing (upgrade) or stale summary would
+      // otherwise never store one: persist the hashes alone so the next run
+      // takes the fast path.
+      update_hashes = !update_db;
+    }
   } else {
     dr.added = std::move(current_qd);
     target_gd = &dr.added;
   }
 
-  counter = getQueryCounter(fresh_results || new_query);
-  auto status =
-      setDatabaseValue(kQueries, name_ + "counter", std::to_string(counter));
-  if (!status.ok()) {
-    return status;
-  }
+  counter = incrementCounter(fresh_results || new_query);
+  // Collect every update for this execution and commit one atomic batch
+  // instead of a point write (and WAL sync) per key.
+  DatabaseStringValueList batch = {
+      {name_ + "counter", std::to_string(counter)}};
 
   if (update_db) {
-    // Replace the "previous" query data with the current.
-    std::string json;
-    status = serializeQueryDataJSON(*target_gd, json);
+    // Replace the "previous" query data with the current, in the compact
+    // binary form. Values stored as JSON by older versions are migrated here.
+    std::string serialized;
+    auto status = serializeQueryDataBinary(*target_gd, serialized);
     if (!status.ok()) {
       return status;
     }
-
-    status = setDatabaseValue(kQueries, name_, json);
-    if (!status.ok()) {
-      return status;
+    // Keep a compressed copy hot for the next differential read-back.
+    cacheQueryBaseline(name_, serialized);
+    batch.push_back({name_, std::move(serialized)});
+
+    // Store the per-row hashes so the next run may detect an unchanged row
+    // set without reading the serialized results back.
+    if (current_hashes.empty() && !target_gd->empty()) {
+      current_hashes = computeRowHashes(*target_gd);
     }
+    batch.push_back({name_ + "hashes", serializeRowHashes(current_hashes)});
+    batch.push_back({name_ + "epoch", std::to_string(current_epoch)});
 
-    status = setDatabaseValue(
-        kQueries, name_ + "epoch", std::to_string(current_epoch));
-    if (!status.ok()) {
-      return status;
+    {
+      // Keep the in-memory summary current for the next run.
+      WriteLock lock(kRowHashCacheMutex);
+      kRowHashCache[name_] = std::move(current_hashes);
     }
+  } else if (update_hashes) {
+    // The rows are unchanged so the stored results stand; only the hash
+    // summary needs to be written (and cached) for the fast path.
+    batch.push_back({name_ + "hashes", serializeRowHashes(current_hashes)});
+
+    WriteLock lock(kRowHashCacheMutex);
+    kRowHashCache[name_] = std::move(current_hashes);
   }
-  return Status(0, "OK");
+
+  auto status = setDatabaseBatchValues(kQueries, batch);
+  if (status.ok()) {
+    // Keep the metadata hot so the next run starts without any point reads.
+    WriteLock lock(kQueryMetadataMutex);
+    auto& meta = kQueryMetadataCache[name_];
+    meta.epoch = current_epoch;
+    meta.counter = counter;
+    meta.query = query_;
+  }
+  return status;
 }
 
 Status serializeRow(const Row& r,
@@ -196,7 +648,9 @@ Status serializeRowJSON(const Row& r, std::string& json) {
   if (!status.ok()) {
     return status;
   }
-  return doc.toString(json);
+  status = doc.toString(json);
+  TRACK_ALLOCATION("row_serialize", json.size());
+  return status;
 }
 
 Status deserializeRow(const rj::Value& doc, Row& r) {
@@ -205,9 +659,11 @@ Status deserializeRow(const rj::Value& doc, Row& r) {
   }
 
   for (const auto& i : doc.GetObject()) {
-    std::string name(i.name.GetString());
-    if (!name.empty() && i.value.IsString()) {
-      r[name] = i.value.GetString();
+    if (i.name.GetStringLength() > 0 && i.value.IsString()) {
+      // Construct each cell string once, directly into the row, using the
+      // parsed lengths instead of re-scanning for terminators.
+      r.emplace(std::string(i.name.GetString(), i.name.GetStringLength()),
+                std::string(i.value.GetString(), i.value.GetStringLength()));
     }
   }
   return Status();
@@ -222,14 +678,27 @@ Status deserializeRowJSON(const std::string& json, Row& r) {
 }
 
 Status serializeQueryDataJSON(const QueryData& q, std::string& json) {
-  auto doc = JSON::newArray();
-
-  ColumnNames cols;
-  auto status = serializeQueryData(q, cols, doc, doc.doc());
-  if (!status.ok()) {
-    return status;
+  // Stream each row straight into an output buffer through the SAX writer.
+  // No DOM is built and every cell is written exactly once from the Row
+  // storage. The buffer is thread-local so its allocation is amortized
+  // across the repeated serializations of a long-running schedule.
+  thread_local rj::StringBuffer buffer;
+  buffer.Clear();
+
+  rj::Writer<rj::StringBuffer> writer(buffer);
+  writer.StartArray();
+  for (const auto& r : q) {
+    writer.StartObject();
+    for (const auto& i : r) {
+      writer.Key(i.first.c_str(), i.first.size());
+      writer.String(i.second.c_str(), i.second.size());
+    }
+    writer.EndObject();
   }
-  return doc.toString(json);
+  writer.EndArray();
+
+  json.assign(buffer.GetString(), buffer.GetSize());
+  return Status();
 }
 
 Status deserializeQueryData(const rj::Value& arr, QueryData& qd) {
@@ -265,8 +734,11 @@ Status deserializeQueryData(const rj::Value& v, QueryDataSet& qd) {
 }
 
 Status deserializeQueryDataJSON(const std::string& json, QueryData& qd) {
+  // Parse a copy in place: string values reference one backing buffer
+  // instead of being copied into the document allocator first, so each
+  // cell is allocated once, when it is moved into its row.
   auto doc = JSON::newArray();
-  if (!doc.fromString(json) || !doc.doc().IsArray()) {
+  if (!doc.fromMutableString(json) || !doc.doc().IsArray()) {
     return Status(1, "Cannot deserializing JSON");
   }
 
@@ -274,11 +746,140 @@ Status deserializeQueryDataJSON(const std::string& json, QueryData& qd) {
 }
 
 Status deserializeQueryDataJSON(const std::string& json, QueryDataSet& qd) {
-  rj::Document doc;
-  if (doc.Parse(json.c_str()).HasParseError()) {
-    return Status(1, "Error serializing JSON");
+  auto doc = JSON::newArray();
+  if (!doc.fromMutableString(json) || !doc.doc().IsArray()) {
+    return Status(1, "Cannot deserializing JSON");
+  }
+  return deserializeQueryData(doc.doc(), qd);
+}
+
+/// Append a 32-bit length prefix in little-endian byte order.
+static inline void packLength(uint32_t value, std::string& out) {
+  char bytes[4] = {static_cast<char>(value),
+                   static_cast<char>(value >> 8),
+                   static_cast<char>(value >> 16),
+                   static_cast<char>(value >> 24)};
+  out.append(bytes, sizeof(bytes));
+}
+
+/// Read a 32-bit length prefix, returning false if the input is truncated.
+static inline bool unpackLength(const std::string& in,
+                                size_t& offset,
+                                uint32_t& value) {
+  if (offset + sizeof(uint32_t) > in.size()) {
+    return false;
+  }
+  value = static_cast<uint32_t>(static_cast<unsigned char>(in[offset])) |
+          static_cast<uint32_t>(static_cast<unsigned char>(in[offset + 1]))
+              << 8 |
+          static_cast<uint32_t>(static_cast<unsigned char>(in[offset + 2]))
+              << 16 |
+          static_cast<uint32_t>(static_cast<unsigned char>(in[offset + 3]))
+              << 24;
+  offset += sizeof(uint32_t);
+  return true;
+}
+
+Status serializeQueryDataBinary(const QueryData& q, std::string& serialized) {
+  // The schema table is the ordered union of column names across all rows.
+  std::set<std::string> columns;
+  size_t cells_size = 0;
+  for (const auto& r : q) {
+    for (const auto& cell : r) {
+      columns.insert(cell.first);
+      cells_size += cell.second.size();
+    }
+  }
+
+  serialized.clear();
+  serialized.reserve(2 + cells_size + (columns.size() + 1) * q.size() * 4);
+  serialized.push_back(kQueryDataBinaryMagic);
+  serialized.push_back(kQueryDataBinaryVersion);
+
+  packLength(static_cast<uint32_t>(columns.size()), serialized);
+  for (const auto& column : columns) {
+    packLength(static_cast<uint32_t>(column.size()), serialized);
+    serialized.append(column);
+  }
+
+  packLength(static_cast<uint32_t>(q.size()), serialized);
+  for (const auto& r : q) {
+    for (const auto& column : columns) {
+      auto cell = r.find(column);
+      if (cell == r.end()) {
+        packLength(kQueryDataCellAbsent, serialized);
+      } else {
+        packLength(static_cast<uint32_t>(cell->second.size()), serialized);
+        serialized.append(cell->second);
+      }
+    }
+  }
+  return Status();
+}
+
+/// Decode binary results into any row container exposing a hinted insert.
+template <typename Container>
+static Status deserializeBinaryRows(const std::string& serialized,
+                                    Container& qd) {
+  if (serialized.size() < 2 || serialized[0] != kQueryDataBinaryMagic) {
+    return Status(1, "Not a binary result set");
+  }
+  if (serialized[1] != kQueryDataBinaryVersion) {
+    return Status(1, "Unknown binary result version");
+  }
+
+  size_t offset = 2;
+  uint32_t column_count = 0;
+  if (!unpackLength(serialized, offset, column_count)) {
+    return Status(1, "Truncated binary result set");
+  }
+
+  std::vector<std::string> columns;
+  columns.reserve(column_count);
+  for (uint32_t i = 0; i < column_count; i++) {
+    uint32_t length = 0;
+    if (!unpackLength(serialized, offset, length) ||
+        offset + length > serialized.size()) {
+      return Status(1, "Truncated binary result set");
+    }
+    columns.push_back(serialized.substr(offset, length));
+    offset += length;
+  }
+
+  uint32_t row_count = 0;
+  if (!unpackLength(serialized, offset, row_count)) {
+    return Status(1, "Truncated binary result set");
+  }
+
+  for (uint32_t i = 0; i < row_count; i++) {
+    Row r;
+    for (const auto& column : columns) {
+      uint32_t length = 0;
+      if (!unpackLength(serialized, offset, length)) {
+        return Status(1, "Truncated binary result set");
+      }
+      if (length == kQueryDataCellAbsent) {
+        continue;
+      }
+      if (offset + length > serialized.size()) {
+        return Status(1, "Truncated binary result set");
+      }
+      r[column] = serialized.substr(offset, length);
+      offset += length;
+    }
+    qd.insert(qd.end(), std::move(r));
   }
-  return deserializeQueryData(doc, qd);
+  return Status();
+}
+
+Status deserializeQueryDataBinary(const std::string& serialized,
+                                  QueryData& qd) {
+  return deserializeBinaryRows(serialized, qd);
+}
+
+Status deserializeQueryDataBinary(const std::string& serialized,
+                                  QueryDataSet& qd) {
+  return deserializeBinaryRows(serialized, qd);
 }
 
 Status serializeDiffResults(const DiffResults& d,
@@ -407,6 +1008,11 @@ Status serializeQueryLogItem(const QueryLogItem& item, JSON& doc) {
     }
 
     doc.add("diffResults", obj);
+  } else if (item.unchanged) {
+    // A compact marker replacing a snapshot identical to the previous run,
+    // see QueryLogItem::unchanged.
+    doc.add("unchanged", true);
+    doc.addRef("action", "snapshot");
   } else {
     auto arr = doc.getArray();
     auto status =
@@ -447,6 +1053,14 @@ Status serializeQueryLogItemAsEvents(const QueryLogItem& item, JSON& doc) {
     if (!status.ok()) {
       return status;
     }
+  } else if (item.unchanged) {
+    // Event-format marker for a snapshot identical to the previous run.
+    auto obj = doc.getObject();
+    addLegacyFieldsAndDecorations(item, doc, obj);
+    doc.add("unchanged", true, obj);
+    doc.addCopy("action", "snapshot", obj);
+    doc.push(obj);
+    return Status();
   } else if (!item.snapshot_results.empty()) {
     auto arr = doc.getArray();
     auto status = serializeQueryData(item.snapshot_results, {}, temp_doc, arr);
@@ -499,6 +1113,10 @@ Status deserializeQueryLogItem(const JSON& doc, QueryLogItem& item) {
     }
   }
 
+  if (doc.doc().HasMember("unchanged") && doc.doc()["unchanged"].IsBool()) {
+    item.unchanged = doc.doc()["unchanged"].GetBool();
+  }
+
   getLegacyFieldsAndDecorations(doc, item);
   return Status();
 }
@@ -514,18 +1132,59 @@ Status deserializeQueryLogItemJSON(const std::string& json,
 
 Status serializeQueryLogItemAsEventsJSON(const QueryLogItem& item,
                                          std::vector<std::string>& items) {
-  auto doc = JSON::newArray();
-  auto status = serializeQueryLogItemAsEvents(item, doc);
+  /*
+   * Every event emitted from one item shares a byte-identical envelope:
+   * the legacy fields and decorations. Render that envelope once and
+   * splice the per-event columns and action into it in place of its
+   * closing brace, instead of rebuilding and rewriting the same fields
+   * through the DOM for every row of the result.
+   */
+  auto envelope_doc = JSON::newObject();
+  addLegacyFieldsAndDecorations(item, envelope_doc, envelope_doc.doc());
+  std::string envelope;
+  auto status = envelope_doc.toString(envelope);
   if (!status.ok()) {
     return status;
   }
+  envelope.pop_back();
 
-  // return doc.toString()
-  for (auto& event : doc.doc().GetArray()) {
-    rj::StringBuffer sb;
-    rj::Writer<rj::StringBuffer> writer(sb);
-    event.Accept(writer);
-    items.push_back(sb.GetString());
+  auto temp_doc = JSON::newObject();
+  if (!item.results.added.empty() || !item.results.removed.empty()) {
+    status = serializeDiffResults(
+        item.results, item.columns, temp_doc, temp_doc.doc());
+    if (!status.ok()) {
+      return status;
+    }
+  } else if (item.unchanged) {
+    // Event-format marker for a snapshot identical to the previous run.
+    items.push_back(envelope + ",\"unchanged\":true,\"action\":\"snapshot\"}");
+    return Status();
+  } else if (!item.snapshot_results.empty()) {
+    auto arr = temp_doc.getArray();
+    status = serializeQueryData(item.snapshot_results, {}, temp_doc, arr);
+    if (!status.ok()) {
+      return status;
+    }
+    temp_doc.add("snapshot", arr);
+  } else {
+    // This error case may also be represented in serializeQueryLogItem.
+    return Status(1, "No differential or snapshot results");
+  }
+
+  for (auto& action : temp_doc.doc().GetObject()) {
+    for (auto& row : action.value.GetArray()) {
+      rj::StringBuffer sb;
+      rj::Writer<rj::StringBuffer> writer(sb);
+      row.Accept(writer);
+
+      std::string event = envelope;
+      event += ",\"columns\":";
+      event += sb.GetString();
+      event += ",\"action\":\"";
+      event += action.name.GetString();
+      event += "\"}";
+      items.push_back(std::move(event));
+    }
   }
   return Status();
 }
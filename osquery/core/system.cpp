@@ -30,6 +30,7 @@
 #endif
 
 #include <ctime>
+#include <memory>
 #include <sstream>
 
 #include <boost/algorithm/string/case_conv.hpp>
@@ -255,33 +256,84 @@ Status getSpecifiedUUID(std::string& ident) {
   return Status(0, "OK");
 }
 
-std::string getHostIdentifier() {
-  static std::string ident;
+namespace {
 
-  Status result(2);
-  if (ident.size() == 0) {
-    // The identifier has not been set yet.
-    if (FLAGS_host_identifier == "uuid") {
-      result = getHostUUID(ident);
-    } else if (FLAGS_host_identifier == "instance") {
-      result = getInstanceUUID(ident);
-    } else if (FLAGS_host_identifier == "ephemeral") {
-      result = getEphemeralUUID(ident);
-    } else if (FLAGS_host_identifier == "specified") {
-      result = getSpecifiedUUID(ident);
-    }
+/// Seconds a cached hostname identity is served before re-reading it.
+const size_t kHostIdentityRefresh{60};
 
-    if (!result.ok()) {
-      // assuming the default of "hostname" as the machine identifier
-      // intentionally not set to `ident` because the hostname may change
-      // throughout the life of the process and we always want to be using the
-      // most current hostname
-      return osquery::getHostname();
-    } else {
-      VLOG(1) << "Using host identifier: " << ident;
-    }
+/// Immutable host identity snapshot shared by the logging hot paths.
+struct HostIdentity {
+  /// The identifier resolved per --host_identifier, empty for "hostname".
+  std::string uuid;
+
+  /// The hostname at the time the snapshot was built.
+  std::string hostname;
+
+  /// Unix time the hostname was read.
+  size_t hostname_time{0};
+
+  /// True when the "hostname" mode (or a failed lookup) is in effect.
+  bool use_hostname{false};
+};
+
+/// The current snapshot; replaced atomically, never mutated in place.
+std::shared_ptr<HostIdentity> kHostIdentity;
+
+std::shared_ptr<HostIdentity> buildHostIdentity() {
+  auto identity = std::make_shared<HostIdentity>();
+  identity->hostname = getHostname();
+  identity->hostname_time = getUnixTime();
+
+  Status result(2);
+  if (FLAGS_host_identifier == "uuid") {
+    result = getHostUUID(identity->uuid);
+  } else if (FLAGS_host_identifier == "instance") {
+    result = getInstanceUUID(identity->uuid);
+  } else if (FLAGS_host_identifier == "ephemeral") {
+    result = getEphemeralUUID(identity->uuid);
+  } else if (FLAGS_host_identifier == "specified") {
+    result = getSpecifiedUUID(identity->uuid);
+  }
+
+  if (!result.ok()) {
+    // Assume the default of "hostname" as the machine identifier.
+    identity->use_hostname = true;
+  } else {
+    VLOG(1) << "Using host identifier: " << identity->uuid;
   }
-  return ident;
+  return identity;
+}
+} // namespace
+
+std::string getHostIdentifier() {
+  // Every log item and distributed response includes the host identity, so
+  // serve it from an immutable snapshot instead of re-resolving (database
+  // reads, UUID generation) per call.
+  auto identity = std::atomic_load(&kHostIdentity);
+  if (identity == nullptr) {
+    identity = buildHostIdentity();
+    std::atomic_store(&kHostIdentity, identity);
+  }
+
+  if (!identity->use_hostname) {
+    return identity->uuid;
+  }
+
+  // The hostname may change throughout the life of the process; rebuild the
+  // snapshot at most once per interval instead of for every log item.
+  auto now = getUnixTime();
+  if (now - identity->hostname_time >= kHostIdentityRefresh) {
+    auto refreshed = std::make_shared<HostIdentity>(*identity);
+    refreshed->hostname = getHostname();
+    refreshed->hostname_time = now;
+    std::atomic_store(&kHostIdentity, refreshed);
+    return refreshed->hostname;
+  }
+  return identity->hostname;
+}
+
+void resetHostIdentity() {
+  std::atomic_store(&kHostIdentity, std::shared_ptr<HostIdentity>());
 }
 
 std::string toAsciiTime(const struct tm* tm_time) {
@@ -8,22 +8,33 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <algorithm>
+#include <list>
+
+#include <boost/algorithm/string/predicate.hpp>
+
 #include <osquery/database.h>
 #include <osquery/flags.h>
 #include <osquery/logger.h>
 #include <osquery/registry_factory.h>
 #include <osquery/tables.h>
 
+#include "osquery/core/alloc_tracking.h"
 #include "osquery/core/json.h"
 
 namespace osquery {
 
 FLAG(bool, disable_caching, false, "Disable scheduled query caching");
 
+FLAG(uint64,
+     table_cache_budget,
+     16,
+     "Maximum in-memory table result cache size (in MB)");
+
 CREATE_LAZY_REGISTRY(TablePlugin, "table");
 
-size_t TablePlugin::kCacheInterval = 0;
-size_t TablePlugin::kCacheStep = 0;
+thread_local size_t TablePlugin::kCacheInterval = 0;
+thread_local size_t TablePlugin::kCacheStep = 0;
 
 const std::map<ColumnType, std::string> kColumnTypeNames = {
     {UNKNOWN_TYPE, "UNKNOWN"},
@@ -35,6 +46,21 @@ const std::map<ColumnType, std::string> kColumnTypeNames = {
     {BLOB_TYPE, "BLOB"},
 };
 
+/// Route info of attached external tables, fed by registry broadcasts.
+static Mutex kExternalRouteInfoMutex;
+static std::map<std::string, PluginResponse> kExternalRouteInfo;
+
+bool TablePlugin::getExternalRouteInfo(const std::string& name,
+                                       PluginResponse& response) {
+  ReadLock lock(kExternalRouteInfoMutex);
+  auto it = kExternalRouteInfo.find(name);
+  if (it == kExternalRouteInfo.end()) {
+    return false;
+  }
+  response = it->second;
+  return true;
+}
+
 Status TablePlugin::addExternal(const std::string& name,
                                 const PluginResponse& response) {
   // Attach the table.
@@ -45,11 +71,23 @@ Status TablePlugin::addExternal(const std::string& name,
     return Status(1, "Invalid route info");
   }
 
+  {
+    // Cache the broadcasted column info so the attach below, and any later
+    // connection, declares the table without calling into the extension.
+    WriteLock lock(kExternalRouteInfoMutex);
+    kExternalRouteInfo[name] = response;
+  }
+
   // Use the SQL registry to attach the name/definition.
   return Registry::call("sql", "sql", {{"action", "attach"}, {"table", name}});
 }
 
 void TablePlugin::removeExternal(const std::string& name) {
+  {
+    WriteLock lock(kExternalRouteInfoMutex);
+    kExternalRouteInfo.erase(name);
+  }
+
   // Detach the table name.
   Registry::call("sql", "sql", {{"action", "detach"}, {"table", name}});
 }
@@ -79,6 +117,17 @@ void TablePlugin::setRequestFromContext(const QueryContext& context,
     doc.add("colsUsed", colsUsed);
   }
 
+  if (!context.orderTerms.empty()) {
+    auto orderTerms = doc.getArray();
+    for (const auto& term : context.orderTerms) {
+      auto child = doc.getObject();
+      doc.addCopy("column", term.first, child);
+      doc.add("desc", term.second, child);
+      doc.push(child, orderTerms);
+    }
+    doc.add("orderTerms", orderTerms);
+  }
+
   doc.toString(request["context"]);
 }
 
@@ -95,6 +144,13 @@ void TablePlugin::setContextFromRequest(const PluginRequest& request,
     context.colsUsed = colsUsed;
   }
 
+  if (doc.doc().HasMember("orderTerms") && doc.doc()["orderTerms"].IsArray()) {
+    for (const auto& term : doc.doc()["orderTerms"].GetArray()) {
+      context.orderTerms.push_back(
+          std::make_pair(term["column"].GetString(), term["desc"].GetBool()));
+    }
+  }
+
   if (!doc.doc().HasMember("constraints") ||
       !doc.doc()["constraints"].IsArray()) {
     return;
@@ -126,6 +182,7 @@ Status TablePlugin::call(const PluginRequest& request,
       setContextFromRequest(request, context);
     }
     response = generate(context);
+    TRACK_ALLOCATION("table_rows", queryDataBytes(response));
   } else if (request.at("action") == "columns") {
     // The "columns" action returns a PluginRequest filled with column
     // information such as name and type.
@@ -134,15 +191,26 @@ Status TablePlugin::call(const PluginRequest& request,
     return Status(1, "Unknown table plugin action: " + request.at("action"));
   }
 
-  return Status(0, "OK");
+  return Status::success();
 }
 
 std::string TablePlugin::columnDefinition() const {
-  return osquery::columnDefinition(columns());
+  // The column set is fixed at registration, build the definition SQL once.
+  WriteLock lock(metadata_mutex_);
+  if (column_definition_.empty()) {
+    column_definition_ = osquery::columnDefinition(columns());
+  }
+  return column_definition_;
 }
 
 PluginResponse TablePlugin::routeInfo() const {
   // Route info consists of the serialized column information.
+  // Like the column definition it is immutable and computed once.
+  WriteLock lock(metadata_mutex_);
+  if (!route_info_.empty()) {
+    return route_info_;
+  }
+
   PluginResponse response;
   for (const auto& column : columns()) {
     response.push_back(
@@ -169,6 +237,7 @@ PluginResponse TablePlugin::routeInfo() const {
   response.push_back(
       {{"id", "attributes"},
        {"attributes", INTEGER(static_cast<size_t>(attributes()))}});
+  route_info_ = response;
   return response;
 }
 
@@ -189,23 +258,193 @@ static bool cacheAllowed(const TableColumns& cols, const QueryContext& ctx) {
   return true;
 }
 
+/// A single cached result set and its freshness metadata.
+struct TableCacheEntry {
+  /// Cached rows, copied out to the table implementation on a hit.
+  QueryData results;
+
+  /// Approximate memory held by the cached rows.
+  size_t bytes{0};
+
+  /// The schedule step at which the rows were generated.
+  size_t cached_at{0};
+
+  /// Steps the entry stays fresh: the table TTL or the query interval.
+  size_t duration{0};
+};
+
+size_t rowBytes(const Row& row) {
+  size_t bytes = 0;
+  for (const auto& column : row) {
+    bytes += column.first.size() + column.second.size();
+  }
+  return bytes;
+}
+
+size_t queryDataBytes(const QueryData& results) {
+  size_t bytes = 0;
+  for (const auto& row : results) {
+    bytes += rowBytes(row);
+  }
+  return bytes;
+}
+
+/**
+ * @brief A process-wide LRU cache of table results.
+ *
+ * Several scheduled queries may select from the same expensive table within
+ * one interval. Entries are keyed by the table name and constraint set, so
+ * each distinct generation is paid for once. Least-recently-used entries are
+ * evicted once the cache grows beyond the table_cache_budget flag.
+ */
+class TableResultCache : private boost::noncopyable {
+ public:
+  static TableResultCache& get() {
+    static TableResultCache instance;
+    return instance;
+  }
+
+  /// Check if a fresh entry exists for the given key and schedule step.
+  bool isFresh(const std::string& key, size_t step) {
+    WriteLock lock(mutex_);
+    auto entry = entries_.find(key);
+    return (entry != entries_.end() &&
+            step < entry->second.cached_at + entry->second.duration);
+  }
+
+  /// Copy out an entry's rows and mark the entry most recently used.
+  QueryData getResults(const std::string& key) {
+    WriteLock lock(mutex_);
+    auto entry = entries_.find(key);
+    if (entry == entries_.end()) {
+      return {};
+    }
+
+    lru_.remove(key);
+    lru_.push_front(key);
+    return entry->second.results;
+  }
+
+  /// Insert or replace an entry, evicting the LRU beyond the byte budget.
+  void set(const std::string& key, TableCacheEntry entry) {
+    auto budget = FLAGS_table_cache_budget * 1024 * 1024;
+
+    WriteLock lock(mutex_);
+    evict(key);
+    if (entry.bytes > budget) {
+      // A result set larger than the entire budget is never cached.
+      return;
+    }
+
+    bytes_ += entry.bytes;
+    entries_.emplace(key, std::move(entry));
+    lru_.push_front(key);
+    while (bytes_ > budget && !lru_.empty()) {
+      evict(lru_.back());
+    }
+  }
+
+ private:
+  /// Remove an entry and its accounting, must be called while locked.
+  void evict(const std::string& key) {
+    auto entry = entries_.find(key);
+    if (entry == entries_.end()) {
+      return;
+    }
+
+    bytes_ -= entry->second.bytes;
+    entries_.erase(entry);
+    lru_.remove(key);
+  }
+
+ private:
+  /// Protect concurrent access from scheduler and distributed workers.
+  Mutex mutex_;
+
+  /// Cached entries, keyed by table name and constraint set.
+  std::map<std::string, TableCacheEntry> entries_;
+
+  /// Cache keys ordered from most to least recently used.
+  std::list<std::string> lru_;
+
+  /// Total bytes held by all cached entries.
+  size_t bytes_{0};
+};
+
+/**
+ * @brief A process-wide registry of per-table generation statistics.
+ *
+ * The tracker holds one TableGenerateStats per table name, updated after
+ * every completed generate. A mutex-guarded map keeps the overhead to a few
+ * additions per table scan, cheap next to the scan itself.
+ */
+class TableStatsTracker : private boost::noncopyable {
+ public:
+  static TableStatsTracker& get() {
+    static TableStatsTracker instance;
+    return instance;
+  }
+
+  /// Fold one completed generation into a table's counters.
+  void record(const std::string& name,
+              uint64_t wall_time,
+              uint64_t cpu_time,
+              size_t rows,
+              size_t bytes) {
+    WriteLock lock(mutex_);
+    auto& stats = stats_[name];
+    stats.calls++;
+    stats.wall_time += wall_time;
+    stats.cpu_time += cpu_time;
+    stats.rows += rows;
+    stats.peak_bytes = std::max(stats.peak_bytes, bytes);
+  }
+
+  /// Copy out the current statistics for every observed table.
+  std::map<std::string, TableGenerateStats> snapshot() {
+    WriteLock lock(mutex_);
+    return stats_;
+  }
+
+ private:
+  /// Protect concurrent updates from scheduler and distributed workers.
+  Mutex mutex_;
+
+  /// Cumulative statistics, keyed by table name.
+  std::map<std::string, TableGenerateStats> stats_;
+};
+
+void recordTableGenerateStats(const std::string& name,
+                              uint64_t wall_time,
+                              uint64_t cpu_time,
+                              size_t rows,
+                              size_t bytes) {
+  TableStatsTracker::get().record(name, wall_time, cpu_time, rows, bytes);
+}
+
+std::map<std::string, TableGenerateStats> getTableGenerateStats() {
+  return TableStatsTracker::get().snapshot();
+}
+
+std::string TablePlugin::cacheKey(const QueryContext& ctx) const {
+  // The serialized context covers the constraint set and columns used.
+  PluginRequest request;
+  setRequestFromContext(ctx, request);
+  return getName() + ':' + request.at("context");
+}
+
 bool TablePlugin::isCached(size_t step, const QueryContext& ctx) const {
   if (FLAGS_disable_caching) {
     return false;
   }
 
-  // Perform the step comparison first, because it's easy.
-  return (step < last_cached_ + last_interval_ && cacheAllowed(columns(), ctx));
+  return (cacheAllowed(columns(), ctx) &&
+          TableResultCache::get().isFresh(cacheKey(ctx), step));
 }
 
-QueryData TablePlugin::getCache() const {
+QueryData TablePlugin::getCache(const QueryContext& ctx) const {
   VLOG(1) << "Retrieving results from cache for table: " << getName();
-  // Lookup results from database and deserialize.
-  std::string content;
-  getDatabaseValue(kQueries, "cache." + getName(), content);
-  QueryData results;
-  deserializeQueryDataJSON(content, results);
-  return results;
+  return TableResultCache::get().getResults(cacheKey(ctx));
 }
 
 void TablePlugin::setCache(size_t step,
@@ -216,13 +455,14 @@ void TablePlugin::setCache(size_t step,
     return;
   }
 
-  // Serialize QueryData and save to database.
-  std::string content;
-  if (serializeQueryDataJSON(results, content)) {
-    last_cached_ = step;
-    last_interval_ = interval;
-    setDatabaseValue(kQueries, "cache." + getName(), content);
-  }
+  TableCacheEntry entry;
+  entry.results = results;
+  entry.bytes = queryDataBytes(results);
+  entry.cached_at = step;
+  // A table may declare its own TTL, otherwise freshness follows the
+  // scheduled interval.
+  entry.duration = (cacheTTL() > 0) ? cacheTTL() : interval;
+  TableResultCache::get().set(cacheKey(ctx), std::move(entry));
 }
 
 std::string columnDefinition(const TableColumns& columns) {
@@ -359,7 +599,22 @@ bool ConstraintList::matches(const std::string& expr) const {
 template <typename T>
 bool ConstraintList::literal_matches(const T& base_expr) const {
   bool aggregate = true;
+  bool checked_like = false;
   for (size_t i = 0; i < constraints_.size(); ++i) {
+    if (constraints_[i].op == LIKE) {
+      // LIKE is approximated by the compiled literal anchors: a matching
+      // value must carry the pattern's prefix and suffix. The check never
+      // rejects a value the SQL layer would accept, and SQLite re-applies
+      // the full pattern to the emitted rows.
+      if (!checked_like) {
+        aggregate = aggregate && matchLike(SQL_TEXT(base_expr));
+        checked_like = true;
+      }
+      if (!aggregate) {
+        return false;
+      }
+      continue;
+    }
     T constraint_expr = AS_LITERAL(T, constraints_[i].expr);
     if (constraints_[i].op == EQUALS) {
       aggregate = aggregate && (base_expr == constraint_expr);
@@ -383,6 +638,57 @@ bool ConstraintList::literal_matches(const T& base_expr) const {
   return true;
 }
 
+const std::vector<LikePattern>& ConstraintList::getLikePatterns() const {
+  if (like_compiled_) {
+    return like_patterns_;
+  }
+
+  like_patterns_.clear();
+  for (const auto& constraint : constraints_) {
+    if (constraint.op != LIKE) {
+      continue;
+    }
+
+    LikePattern pattern;
+    auto first = constraint.expr.find_first_of("%_");
+    if (first == std::string::npos) {
+      // A wildcard-free LIKE is a (case-insensitive) literal comparison.
+      pattern.prefix = constraint.expr;
+    } else {
+      pattern.wild = true;
+      pattern.prefix = constraint.expr.substr(0, first);
+      pattern.suffix =
+          constraint.expr.substr(constraint.expr.find_last_of("%_") + 1);
+    }
+    like_patterns_.push_back(std::move(pattern));
+  }
+
+  like_compiled_ = true;
+  return like_patterns_;
+}
+
+bool ConstraintList::matchLike(const std::string& expr) const {
+  const auto& patterns = getLikePatterns();
+  if (patterns.empty()) {
+    return true;
+  }
+
+  // The anchors are a necessary condition only: any anchor match keeps the
+  // expression, since multiple LIKE constraints may describe alternatives.
+  for (const auto& pattern : patterns) {
+    if (!pattern.wild) {
+      if (boost::iequals(expr, pattern.prefix)) {
+        return true;
+      }
+    } else if (expr.size() >= pattern.prefix.size() + pattern.suffix.size() &&
+               boost::istarts_with(expr, pattern.prefix) &&
+               boost::iends_with(expr, pattern.suffix)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 std::set<std::string> ConstraintList::getAll(ConstraintOperator op) const {
   std::set<std::string> set;
   for (size_t i = 0; i < constraints_.size(); ++i) {
@@ -419,6 +725,7 @@ void ConstraintList::deserialize(const rapidjson::Value& obj) {
     constraint.expr = list["expr"].GetString();
     constraints_.push_back(constraint);
   }
+  like_compiled_ = false;
 
   auto affinity_name = (obj.HasMember("affinity") && obj["affinity"].IsString())
                            ? obj["affinity"].GetString()
@@ -448,6 +755,18 @@ bool QueryContext::useCache() const {
   return use_cache_;
 }
 
+void QueryContext::setDeadline(std::chrono::steady_clock::time_point deadline) {
+  deadline_ = deadline;
+}
+
+std::chrono::steady_clock::time_point QueryContext::getDeadline() const {
+  return deadline_;
+}
+
+bool QueryContext::isCancelled() const {
+  return std::chrono::steady_clock::now() >= deadline_;
+}
+
 void QueryContext::setCache(const std::string& index, Row _cache) {
   table_->cache[index] = std::move(_cache);
 }
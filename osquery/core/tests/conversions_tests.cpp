@@ -46,6 +46,57 @@ TEST_F(ConversionsTests, test_base64) {
 
   auto unencoded2 = base64Decode(encoded);
   EXPECT_EQ(unencoded, unencoded2);
+
+  // Padding applies for each remainder length, round-trip both.
+  EXPECT_EQ("TQ==", base64Encode("M"));
+  EXPECT_EQ("TWE=", base64Encode("Ma"));
+  EXPECT_EQ("M", base64Decode("TQ=="));
+  EXPECT_EQ("Ma", base64Decode("TWE="));
+
+  // Line breaks within the encoded content are ignored.
+  EXPECT_EQ("HELLO", base64Decode("SEVM\r\nTE8="));
+
+  // Invalid input symbols fail the decode.
+  EXPECT_EQ("", base64Decode("SEV%TE8="));
+}
+
+TEST_F(ConversionsTests, test_safe_strto) {
+  long long signed_out{0};
+  EXPECT_TRUE(safeStrto<long long>("-1234567890123456789", signed_out).ok());
+  EXPECT_EQ(signed_out, -1234567890123456789LL);
+  EXPECT_TRUE(safeStrto<long long>("+42", signed_out).ok());
+  EXPECT_EQ(signed_out, 42LL);
+  EXPECT_TRUE(safeStrto<long long>("-9223372036854775808", signed_out).ok());
+  EXPECT_EQ(signed_out, LLONG_MIN);
+
+  // The integer forms are strict: the entire cell must be base-10 digits.
+  EXPECT_FALSE(safeStrto<long long>("", signed_out).ok());
+  EXPECT_FALSE(safeStrto<long long>(" 1", signed_out).ok());
+  EXPECT_FALSE(safeStrto<long long>("1x", signed_out).ok());
+  EXPECT_FALSE(safeStrto<long long>("9223372036854775808", signed_out).ok());
+  EXPECT_EQ(signed_out, 0LL);
+
+  unsigned long long unsigned_out{0};
+  EXPECT_TRUE(
+      safeStrto<unsigned long long>("18446744073709551615", unsigned_out)
+          .ok());
+  EXPECT_EQ(unsigned_out, ULLONG_MAX);
+  EXPECT_FALSE(
+      safeStrto<unsigned long long>("18446744073709551616", unsigned_out)
+          .ok());
+  EXPECT_FALSE(safeStrto<unsigned long long>("-1", unsigned_out).ok());
+
+  double double_out{0};
+  EXPECT_TRUE(safeStrto<double>("0.5", double_out).ok());
+  EXPECT_EQ(double_out, 0.5);
+  EXPECT_FALSE(safeStrto<double>("0.5x", double_out).ok());
+
+  bool bool_out{false};
+  EXPECT_TRUE(safeStrto<bool>("1", bool_out).ok());
+  EXPECT_TRUE(bool_out);
+  EXPECT_TRUE(safeStrto<bool>("false", bool_out).ok());
+  EXPECT_FALSE(bool_out);
+  EXPECT_FALSE(safeStrto<bool>("yes", bool_out).ok());
 }
 
 TEST_F(ConversionsTests, test_ascii_true) {
@@ -156,6 +207,26 @@ TEST_F(ConversionsTests, test_json_from_string) {
   EXPECT_FALSE(doc.fromString(json).ok());
 }
 
+TEST_F(ConversionsTests, test_json_from_mutable_string) {
+  std::string json =
+      "{\"key\":\"a value long enough to live on the heap\",\"key2\":[1,2]}";
+  auto doc = JSON::newObject();
+  EXPECT_TRUE(doc.fromMutableString(json).ok());
+
+  std::string result;
+  EXPECT_TRUE(doc.toString(result));
+  EXPECT_EQ(json, result);
+
+  // Copies must own their strings; the source document strings reference
+  // the parse buffer, which dies with the source document.
+  auto copy = JSON::newFromValue(doc.doc());
+  doc = JSON::newObject();
+  EXPECT_EQ(std::string(copy.doc()["key"].GetString()),
+            "a value long enough to live on the heap");
+
+  EXPECT_FALSE(JSON::newObject().fromMutableString("{invalid").ok());
+}
+
 TEST_F(ConversionsTests, test_json_from_string_error) {
   std::string json = "{\"key\":\"value\",\"key2\":{\"key3\":'error'}}";
   auto doc = JSON::newObject();
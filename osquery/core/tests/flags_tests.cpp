@@ -38,6 +38,12 @@ class FlagsTests : public testing::Test {
 
 FLAG(string, test_string_flag, "TEST STRING", "TEST DESCRIPTION");
 
+FLAG(uint64, test_uint64_flag, 100, "TEST DESCRIPTION");
+
+/// A typed handle bound to the flag above, as a hot loop would declare one.
+static FastFlag<decltype(FLAGS_test_uint64_flag)> kTestFastFlag(
+    "test_uint64_flag", &FLAGS_test_uint64_flag);
+
 TEST_F(FlagsTests, test_set_get) {
   // Test the core gflags functionality.
   EXPECT_EQ(FLAGS_test_string_flag, "TEST STRING");
@@ -80,6 +86,29 @@ TEST_F(FlagsTests, test_details) {
   EXPECT_EQ(flag_info.detail.external, false);
 }
 
+TEST_F(FlagsTests, test_fast_flag) {
+  // The handle bound at static initialization holds the default value.
+  EXPECT_EQ(kTestFastFlag.get(), 100U);
+
+  // Dynamic updates through the osquery wrapper refresh the typed copy.
+  EXPECT_TRUE(Flag::updateValue("test_uint64_flag", "42").ok());
+  EXPECT_EQ(FLAGS_test_uint64_flag, 42U);
+  EXPECT_EQ(kTestFastFlag.get(), 42U);
+
+  // Direct writes to the Gflags global bypass the handle by design; only
+  // the Flag::updateValue (config options) flow refreshes it.
+  FLAGS_test_uint64_flag = 7;
+  EXPECT_EQ(kTestFastFlag.get(), 42U);
+
+  // Startup parsing also writes the storage directly; the bulk refresh run
+  // after ParseCommandLineFlags reloads every bound handle.
+  Flag::refreshFastFlags();
+  EXPECT_EQ(kTestFastFlag.get(), 7U);
+
+  EXPECT_TRUE(Flag::updateValue("test_uint64_flag", "100").ok());
+  EXPECT_EQ(kTestFastFlag.get(), 100U);
+}
+
 SHELL_FLAG(bool, shell_only, true, "TEST SHELL DESCRIPTION");
 EXTENSION_FLAG(bool, extension_only, true, "TEST EXTENSION DESCRIPTION");
 
@@ -0,0 +1,53 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <gtest/gtest.h>
+
+#include <osquery/core.h>
+#include <osquery/filesystem.h>
+
+#include "osquery/core/hashing.h"
+#include "osquery/tests/test_util.h"
+
+namespace osquery {
+
+class HashingTests : public testing::Test {};
+
+TEST_F(HashingTests, test_hash_from_buffer) {
+  std::string content = "osquery";
+  EXPECT_EQ("6f03171b2dc830e8a8a1337212417c74",
+            hashFromBuffer(HASH_TYPE_MD5, content.c_str(), content.size()));
+  EXPECT_EQ("3847aba4f0050db8d10d9385a928317fc3253b7bf152611074b2f8ffa677c56f",
+            hashFromBuffer(HASH_TYPE_SHA256, content.c_str(), content.size()));
+}
+
+TEST_F(HashingTests, test_hash_multi_from_file_cached) {
+  auto path = kTestWorkingDirectory + "hashing_tests_cached";
+  ASSERT_TRUE(writeTextFile(path, "osquery", 0600).ok());
+
+  auto direct =
+      hashMultiFromFile(HASH_TYPE_MD5 | HASH_TYPE_SHA256, path);
+  auto cached =
+      hashMultiFromFileCached(HASH_TYPE_MD5 | HASH_TYPE_SHA256, path);
+  EXPECT_EQ(direct.md5, cached.md5);
+  EXPECT_EQ(direct.sha256, cached.sha256);
+
+  // A repeated request for an unchanged file state is served from the cache.
+  auto repeated =
+      hashMultiFromFileCached(HASH_TYPE_MD5 | HASH_TYPE_SHA256, path);
+  EXPECT_EQ(cached.sha256, repeated.sha256);
+
+  // A request for an algorithm outside the cached mask is still satisfied.
+  auto widened = hashMultiFromFileCached(HASH_TYPE_SHA1, path);
+  EXPECT_FALSE(widened.sha1.empty());
+
+  removePath(path);
+}
+}
@@ -16,12 +16,15 @@
 
 #include <gtest/gtest.h>
 
+#include <osquery/flags.h>
 #include <osquery/query.h>
 
 #include "osquery/tests/test_util.h"
 
 namespace osquery {
 
+DECLARE_uint64(query_baseline_cache_size);
+
 class QueryTests : public testing::Test {};
 
 TEST_F(QueryTests, test_private_members) {
@@ -145,4 +148,215 @@ TEST_F(QueryTests, test_get_stored_query_names) {
   auto in_vector = std::find(names.begin(), names.end(), "foobar");
   EXPECT_NE(in_vector, names.end());
 }
+
+TEST_F(QueryTests, test_row_hash_stability) {
+  Row r1{{"a", "1"}, {"b", "2"}};
+  Row r2{{"a", "1"}, {"b", "3"}};
+  EXPECT_EQ(computeRowHash(r1), computeRowHash(r1));
+  EXPECT_NE(computeRowHash(r1), computeRowHash(r2));
+
+  // Field boundaries are mixed in, concatenations must not collide.
+  Row r3{{"a", "12"}};
+  Row r4{{"a1", "2"}};
+  EXPECT_NE(computeRowHash(r3), computeRowHash(r4));
+}
+
+TEST_F(QueryTests, test_unchanged_results_hash_fast_path) {
+  auto query = getOsqueryScheduledQuery();
+  auto cf = Query("hash_fast_path", query);
+  auto results = getTestDBExpectedResults();
+
+  DiffResults dr;
+  uint64_t counter = 0;
+  auto status = cf.addNewResults(results, 0, counter, dr, true);
+  EXPECT_TRUE(status.ok());
+
+  // The initial run stores the compact per-row hash set.
+  std::string raw;
+  status = getDatabaseValue(kQueries, "hash_fast_pathhashes", raw);
+  EXPECT_TRUE(status.ok());
+  EXPECT_FALSE(raw.empty());
+
+  // An identical result set produces an empty differential via hashes alone.
+  DiffResults unchanged;
+  status = cf.addNewResults(results, 0, counter, unchanged, true);
+  EXPECT_TRUE(status.ok());
+  EXPECT_TRUE(unchanged.added.empty());
+  EXPECT_TRUE(unchanged.removed.empty());
+
+  // The summary is kept hot in memory: even with the stored hashes removed,
+  // an identical run is confirmed without a backing store read.
+  deleteDatabaseValue(kQueries, "hash_fast_pathhashes");
+  DiffResults cached;
+  status = cf.addNewResults(results, 0, counter, cached, true);
+  EXPECT_TRUE(status.ok());
+  EXPECT_TRUE(cached.added.empty());
+  EXPECT_TRUE(cached.removed.empty());
+}
+
+TEST_F(QueryTests, test_missing_hash_summary_persisted) {
+  // Simulate a pre-upgrade store: query text, epoch, and JSON results exist
+  // but a per-row hash summary was never written.
+  auto query = getOsqueryScheduledQuery();
+  auto results = getTestDBExpectedResults();
+  std::string serialized;
+  EXPECT_TRUE(serializeQueryDataJSON(results, serialized).ok());
+  setDatabaseValue(kQueries, "query.hash_upgrade", query.query);
+  setDatabaseValue(kQueries, "hash_upgrade", serialized);
+  setDatabaseValue(kQueries, "hash_upgradeepoch", "0");
+
+  // An unchanged run must still persist the summary it found missing, or
+  // the stable steady state would never reach the fast path.
+  auto cf = Query("hash_upgrade", query);
+  DiffResults dr;
+  uint64_t counter = 0;
+  auto status = cf.addNewResults(results, 0, counter, dr, true);
+  EXPECT_TRUE(status.ok());
+  EXPECT_TRUE(dr.added.empty());
+  EXPECT_TRUE(dr.removed.empty());
+
+  std::string raw;
+  status = getDatabaseValue(kQueries, "hash_upgradehashes", raw);
+  EXPECT_TRUE(status.ok());
+  EXPECT_FALSE(raw.empty());
+}
+
+TEST_F(QueryTests, test_baseline_cache) {
+  auto restore = FLAGS_query_baseline_cache_size;
+  FLAGS_query_baseline_cache_size = 1024 * 1024;
+
+  auto query = getOsqueryScheduledQuery();
+  auto cf = Query("baseline_cache", query);
+  auto results = getTestDBExpectedResults();
+
+  uint64_t counter = 0;
+  auto status = cf.addNewResults(results, 0, counter);
+  EXPECT_TRUE(status.ok());
+
+  // The baseline is kept compressed in memory: even with the stored results
+  // removed, the previous rows are recovered without a backing store read.
+  deleteDatabaseValue(kQueries, "baseline_cache");
+  QueryDataSet previous;
+  status = cf.getPreviousQueryResults(previous);
+  EXPECT_TRUE(status.ok());
+  EXPECT_EQ(previous.size(), results.size());
+
+  // Clearing the per-query caches falls back to the (deleted) store copy.
+  clearQueryRowHashCache("baseline_cache");
+  QueryDataSet evicted;
+  status = cf.getPreviousQueryResults(evicted);
+  EXPECT_TRUE(evicted.empty());
+
+  FLAGS_query_baseline_cache_size = restore;
+}
+
+TEST_F(QueryTests, test_metadata_cache) {
+  auto query = getOsqueryScheduledQuery();
+  auto cf = Query("metadata_cache", query);
+  auto results = getTestDBExpectedResults();
+
+  uint64_t counter = 128;
+  auto status = cf.addNewResults(results, 0, counter);
+  EXPECT_TRUE(status.ok());
+  EXPECT_EQ(counter, 0UL);
+
+  // The counter, epoch, and stored query string are kept hot: even with the
+  // stored keys removed, the next run resumes from the cached metadata.
+  deleteDatabaseValue(kQueries, "metadata_cachecounter");
+  deleteDatabaseValue(kQueries, "query.metadata_cache");
+  status = cf.addNewResults(results, 0, counter);
+  EXPECT_TRUE(status.ok());
+  EXPECT_EQ(counter, 1UL);
+  EXPECT_FALSE(cf.isNewQuery());
+
+  // Clearing the per-query caches falls back to the (deleted) store copies.
+  clearQueryRowHashCache("metadata_cache");
+  EXPECT_TRUE(cf.isNewQuery());
+}
+
+TEST_F(QueryTests, test_query_histogram_percentiles) {
+  QueryHistogram hist;
+  EXPECT_EQ(hist.percentile(99), 0UL);
+
+  // 90 fast executions and 10 slow outliers.
+  for (size_t i = 0; i < 90; i++) {
+    hist.add(1);
+  }
+  for (size_t i = 0; i < 10; i++) {
+    hist.add(1000);
+  }
+  EXPECT_EQ(hist.samples, 100UL);
+
+  // Buckets are power-of-two ranges; estimates bound the true value.
+  EXPECT_EQ(hist.percentile(50), 1UL);
+  auto p99 = hist.percentile(99);
+  EXPECT_GE(p99, 1000UL);
+  EXPECT_LT(p99, 2048UL);
+
+  // The compact encoding must round trip exactly.
+  QueryHistogram restored;
+  restored.deserialize(hist.serialize());
+  EXPECT_EQ(restored.buckets, hist.buckets);
+  EXPECT_EQ(restored.samples, hist.samples);
+  EXPECT_EQ(restored.percentile(99), p99);
+}
+
+TEST_F(QueryTests, test_query_performance_round_trip) {
+  QueryPerformance stats;
+  stats.executions = 12;
+  stats.last_executed = 1500000000;
+  stats.wall_time = 34;
+  stats.user_time = 56;
+  stats.system_time = 78;
+  stats.average_memory = 4096;
+  stats.output_size = 8192;
+  stats.wall_time_hist.add(3);
+  stats.memory_hist.add(4096);
+
+  QueryPerformance restored;
+  restored.deserialize(stats.serialize());
+  EXPECT_EQ(restored.executions, stats.executions);
+  EXPECT_EQ(restored.last_executed, stats.last_executed);
+  EXPECT_EQ(restored.wall_time, stats.wall_time);
+  EXPECT_EQ(restored.user_time, stats.user_time);
+  EXPECT_EQ(restored.system_time, stats.system_time);
+  EXPECT_EQ(restored.average_memory, stats.average_memory);
+  EXPECT_EQ(restored.output_size, stats.output_size);
+  EXPECT_EQ(restored.wall_time_hist.samples, 1U);
+  EXPECT_EQ(restored.memory_hist.samples, 1U);
+
+  // Corrupt records must not throw; the counters simply remain zero.
+  QueryPerformance corrupt;
+  corrupt.deserialize("not-a-record");
+  EXPECT_EQ(corrupt.executions, 0U);
+}
+
+TEST_F(QueryTests, test_binary_results_round_trip) {
+  auto rows = getTestDBExpectedResults();
+  // Include a row with absent columns and an empty value; both must survive.
+  rows.push_back(Row{{"username", ""}});
+
+  std::string serialized;
+  auto status = serializeQueryDataBinary(rows, serialized);
+  EXPECT_TRUE(status.ok());
+  ASSERT_FALSE(serialized.empty());
+  // The encoding must never be mistaken for a stored JSON array.
+  EXPECT_NE(serialized[0], '[');
+
+  QueryData decoded;
+  status = deserializeQueryDataBinary(serialized, decoded);
+  EXPECT_TRUE(status.ok());
+  EXPECT_EQ(decoded, rows);
+
+  QueryDataSet decoded_set;
+  status = deserializeQueryDataBinary(serialized, decoded_set);
+  EXPECT_TRUE(status.ok());
+  EXPECT_EQ(decoded_set.size(), rows.size());
+
+  // A truncated value must fail cleanly instead of yielding partial rows.
+  QueryData partial;
+  status = deserializeQueryDataBinary(serialized.substr(0, serialized.size() / 2),
+                                      partial);
+  EXPECT_FALSE(status.ok());
+}
 }
@@ -28,4 +28,32 @@ TEST_F(UUIDTests, test_valid_uuid) {
   EXPECT_FALSE(isPlaceholderHardwareUUID(uuid));
 }
 
+class HostIdentityTests : public testing::Test {};
+
+TEST_F(HostIdentityTests, test_cached_identity) {
+  resetHostIdentity();
+
+  // The identifier is resolved once and then served from the snapshot.
+  auto ident = getHostIdentifier();
+  EXPECT_FALSE(ident.empty());
+  EXPECT_EQ(ident, getHostIdentifier());
+
+  // An explicit invalidation rebuilds the snapshot to the same value.
+  resetHostIdentity();
+  EXPECT_EQ(ident, getHostIdentifier());
+}
+
+class StartupPhaseTests : public testing::Test {};
+
+TEST_F(StartupPhaseTests, test_record_startup_phase) {
+  auto before = getStartupPhases().size();
+  recordStartupPhase("test_phase", 100U, 5U);
+
+  auto phases = getStartupPhases();
+  ASSERT_EQ(before + 1, phases.size());
+  EXPECT_EQ("test_phase", phases.back().name);
+  EXPECT_EQ(100U, phases.back().start);
+  EXPECT_EQ(5U, phases.back().duration);
+}
+
 } // namespace osquery
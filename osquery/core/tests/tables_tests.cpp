@@ -12,10 +12,26 @@
 
 #include <osquery/tables.h>
 
+#include "osquery/core/alloc_tracking.h"
+
 namespace osquery {
 
 class TablesTests : public testing::Test {};
 
+TEST_F(TablesTests, test_field_formatting) {
+  // The integral fast path must match the lexical form exactly.
+  EXPECT_EQ(INTEGER(0), "0");
+  EXPECT_EQ(INTEGER(-1), "-1");
+  EXPECT_EQ(BIGINT(INT64_MIN), "-9223372036854775808");
+  EXPECT_EQ(BIGINT(INT64_MAX), "9223372036854775807");
+  EXPECT_EQ(UNSIGNED_BIGINT(UINT64_MAX), "18446744073709551615");
+  EXPECT_EQ(INTEGER(true), "1");
+
+  // Non-integral types keep the lexical conversion.
+  EXPECT_EQ(DOUBLE(0.5), "0.5");
+  EXPECT_EQ(SQL_TEXT("value"), "value");
+}
+
 TEST_F(TablesTests, test_constraint) {
   auto constraint = Constraint(EQUALS);
   constraint.expr = "none";
@@ -106,6 +122,35 @@ TEST_F(TablesTests, test_constraint_matching) {
   EXPECT_TRUE(cl3.matches(1));
 }
 
+TEST_F(TablesTests, test_constraint_like) {
+  struct ConstraintList cl;
+  cl.add(Constraint(LIKE, "/var/log/%.log"));
+
+  // The pattern compiles into its literal prefix and suffix anchors.
+  const auto& patterns = cl.getLikePatterns();
+  ASSERT_EQ(patterns.size(), 1U);
+  EXPECT_TRUE(patterns[0].wild);
+  EXPECT_EQ(patterns[0].prefix, "/var/log/");
+  EXPECT_EQ(patterns[0].suffix, ".log");
+
+  // The anchors filter expressions that cannot match the pattern.
+  EXPECT_TRUE(cl.matches("/var/log/syslog.log"));
+  EXPECT_FALSE(cl.matches("/var/log/syslog"));
+  EXPECT_FALSE(cl.matches("/etc/hosts"));
+
+  // Multiple LIKE constraints act as alternatives.
+  cl.add(Constraint(LIKE, "/etc/%"));
+  EXPECT_EQ(cl.getLikePatterns().size(), 2U);
+  EXPECT_TRUE(cl.matches("/etc/hosts"));
+
+  // A wildcard-free pattern is a case-insensitive literal comparison.
+  struct ConstraintList cl2;
+  cl2.add(Constraint(LIKE, "/Library/Preferences"));
+  EXPECT_FALSE(cl2.getLikePatterns()[0].wild);
+  EXPECT_TRUE(cl2.matches("/library/preferences"));
+  EXPECT_FALSE(cl2.matches("/library/preferences/extra"));
+}
+
 TEST_F(TablesTests, test_constraint_map) {
   ConstraintMap cm;
 
@@ -179,4 +224,49 @@ TEST_F(TablesTests, test_caching) {
   EXPECT_TRUE(test.testIsCached(6));
   EXPECT_FALSE(test.testIsCached(7));
 }
+
+TEST_F(TablesTests, test_deadline) {
+  QueryContext context;
+  // Without a deadline the context is never cancelled.
+  EXPECT_FALSE(context.isCancelled());
+
+  context.setDeadline(std::chrono::steady_clock::now() +
+                      std::chrono::minutes(1));
+  EXPECT_FALSE(context.isCancelled());
+
+  context.setDeadline(std::chrono::steady_clock::now() -
+                      std::chrono::milliseconds(1));
+  EXPECT_TRUE(context.isCancelled());
+}
+
+TEST_F(TablesTests, test_generate_stats) {
+  recordTableGenerateStats("stats_test", 100, 50, 10, 1024);
+  recordTableGenerateStats("stats_test", 200, 50, 5, 2048);
+
+  auto stats = getTableGenerateStats();
+  ASSERT_EQ(stats.count("stats_test"), 1U);
+
+  // Counters accumulate across calls, peak_bytes tracks the maximum.
+  const auto& table = stats.at("stats_test");
+  EXPECT_EQ(table.calls, 2U);
+  EXPECT_EQ(table.wall_time, 300U);
+  EXPECT_EQ(table.cpu_time, 100U);
+  EXPECT_EQ(table.rows, 15U);
+  EXPECT_EQ(table.peak_bytes, 2048U);
+}
+
+TEST_F(TablesTests, test_allocation_tracking) {
+  // The recorder is always available; only the call sites are conditional.
+  recordAllocation("tracking_test", 100);
+  recordAllocation("tracking_test", 2000);
+
+  auto stats = getAllocationStats();
+  ASSERT_EQ(stats.count("tracking_test"), 1U);
+
+  const auto& site = stats.at("tracking_test");
+  EXPECT_EQ(site.allocations, 2U);
+  EXPECT_EQ(site.bytes, 2100U);
+  EXPECT_EQ(site.sizes.samples, 2U);
+  EXPECT_GE(site.sizes.percentile(99), 2000U);
+}
 }
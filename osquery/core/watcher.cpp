@@ -25,6 +25,7 @@
 #include <osquery/sql.h>
 #include <osquery/system.h>
 
+#include "osquery/core/metrics.h"
 #include "osquery/core/process.h"
 #include "osquery/core/watcher.h"
 #include "osquery/filesystem/fileops.h"
@@ -95,6 +96,12 @@ CLI_FLAG(bool,
 
 CLI_FLAG(bool, disable_watchdog, false, "Disable userland watchdog process");
 
+/// Smoothing factor for the fast utilization window (reacts in ~2 intervals).
+const double kUtilizationFastAlpha{0.5};
+
+/// Smoothing factor for the slow utilization window (reacts in ~8 intervals).
+const double kUtilizationSlowAlpha{0.125};
+
 void Watcher::resetWorkerCounters(size_t respawn_time) {
   // Reset the monitoring counters for the watcher.
   state_.sustained_latency = 0;
@@ -372,12 +379,28 @@ PerformanceChange getChange(const Row& r, PerformanceState& state) {
     state.sustained_latency = 0;
   }
 
-  // Check the difference of CPU time used since last check.
+  // Check the difference of CPU time used since last check. A process (or
+  // counter) restart may make the deltas negative, treat those as idle.
+  auto user_delta =
+      (user_time >= state.user_time) ? user_time - state.user_time : 0;
+  auto system_delta =
+      (system_time >= state.system_time) ? system_time - state.system_time : 0;
+  auto utilization =
+      static_cast<double>(std::max(user_delta, system_delta));
+
+  // Smooth the utilization over a fast and a slow window. The fast average
+  // absorbs single-interval spikes (config refresh, large diffs) while still
+  // reacting to genuine overload within a couple of intervals; the slow
+  // average holds the latency counter until the load has truly subsided.
+  state.fast_utilization = kUtilizationFastAlpha * utilization +
+                           (1 - kUtilizationFastAlpha) * state.fast_utilization;
+  state.slow_utilization = kUtilizationSlowAlpha * utilization +
+                           (1 - kUtilizationSlowAlpha) * state.slow_utilization;
+
   auto ul = getWorkerLimit(WatchdogLimitType::UTILIZATION_LIMIT);
-  if (user_time - state.user_time > ul ||
-      system_time - state.system_time > ul) {
+  if (state.fast_utilization > ul) {
     state.sustained_latency++;
-  } else {
+  } else if (state.slow_utilization <= ul) {
     state.sustained_latency = 0;
   }
   // Update the current CPU time.
@@ -464,12 +487,23 @@ Status WatcherRunner::isChildSane(const PlatformProcess& child) const {
   }
 
   PerformanceChange change;
-  {
+  if (use_worker_ && child.pid() == Watcher::get().getWorker().pid()) {
+    // The worker's performance state is only read and written by this
+    // thread; sampling it must not queue behind signal-driven extension
+    // teardown holding the extensions lock.
+    change = getChange(rows[0], Watcher::get().state_);
+  } else {
     WatcherExtensionsLocker locker;
     auto& state = Watcher::get().getState(child);
     change = getChange(rows[0], state);
   }
 
+  // Export the watchdog samples for the worker process.
+  if (use_worker_ && child.pid() == Watcher::get().getWorker().pid()) {
+    metricSet("watchdog_worker_footprint_bytes", change.footprint);
+    metricSet("watchdog_worker_sustained_latency", change.sustained_latency);
+  }
+
   // Only make a decision about the child sanity if it is still the watcher's
   // child. It's possible for the child to die, and its pid reused.
   if (change.parent != PlatformProcess::getCurrentPid()) {
@@ -503,21 +537,19 @@ Status WatcherRunner::isChildSane(const PlatformProcess& child) const {
 void WatcherRunner::createWorker() {
   auto& watcher = Watcher::get();
 
-  {
-    WatcherExtensionsLocker locker;
-    if (watcher.getState(watcher.getWorker()).last_respawn_time >
-        getUnixTime() - getWorkerLimit(WatchdogLimitType::RESPAWN_LIMIT)) {
-      watcher.workerRestarted();
-      LOG(WARNING) << "osqueryd worker respawning too quickly: "
-                   << watcher.workerRestartCount() << " times";
-
-      // The configured automatic delay.
-      size_t delay = getWorkerLimit(WatchdogLimitType::RESPAWN_DELAY);
-      // Exponential back off for quickly-respawning clients.
-      delay += static_cast<size_t>(pow(2, watcher.workerRestartCount()));
-      delay = std::min(static_cast<size_t>(FLAGS_watchdog_max_delay), delay);
-      pauseMilli(delay * 1000);
-    }
+  // The worker's state is owned by this thread, no extensions lock needed.
+  if (watcher.state_.last_respawn_time >
+      getUnixTime() - getWorkerLimit(WatchdogLimitType::RESPAWN_LIMIT)) {
+    watcher.workerRestarted();
+    LOG(WARNING) << "osqueryd worker respawning too quickly: "
+                 << watcher.workerRestartCount() << " times";
+
+    // The configured automatic delay.
+    size_t delay = getWorkerLimit(WatchdogLimitType::RESPAWN_DELAY);
+    // Exponential back off for quickly-respawning clients.
+    delay += static_cast<size_t>(pow(2, watcher.workerRestartCount()));
+    delay = std::min(static_cast<size_t>(FLAGS_watchdog_max_delay), delay);
+    pauseMilli(delay * 1000);
   }
 
   // Get the path of the current process.
@@ -70,12 +70,25 @@ struct PerformanceState {
   /// The initial (or as close as possible) process image footprint.
   size_t initial_footprint;
 
+  /**
+   * @brief Smoothed CPU utilization over a fast and a slow window.
+   *
+   * Both are exponentially-weighted moving averages of the per-second CPU
+   * time used during each check interval. The fast average drives the
+   * latency counter and absorbs single-interval spikes, the slow average
+   * gates recovery so an oscillating process cannot reset the counter.
+   */
+  double fast_utilization;
+  double slow_utilization;
+
   PerformanceState() {
     sustained_latency = 0;
     user_time = 0;
     system_time = 0;
     last_respawn_time = 0;
     initial_footprint = 0;
+    fast_utilization = 0;
+    slow_utilization = 0;
   }
 };
 
@@ -207,7 +220,7 @@ class Watcher : private boost::noncopyable {
   }
 
  private:
-  /// Performance state for the worker process.
+  /// Performance state for the worker, only the runner thread touches it.
   PerformanceState state_;
 
   /// Performance states for each autoloadable extension binary.
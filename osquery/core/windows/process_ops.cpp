@@ -268,6 +268,15 @@ bool platformModuleClose(ModuleHandle module) {
 
 void setToBackgroundPriority() {}
 
+void setThreadToBackgroundPriority() {
+  // Background mode lowers both the CPU and I/O priority of the thread.
+  SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+}
+
+void setThreadToNormalPriority() {
+  SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+}
+
 // Helper function to determine if thread is running with admin privilege.
 bool isUserAdmin() {
   HANDLE hToken = nullptr;
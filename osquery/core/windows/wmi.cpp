@@ -9,6 +9,7 @@
  */
 
 #include <locale>
+#include <map>
 #include <string>
 
 #include <osquery/logger.h>
@@ -254,6 +255,81 @@ Status WmiResultItem::GetVectorOfStrings(const std::string& name,
   return Status(0);
 }
 
+namespace {
+/**
+ * @brief A cached WMI provider connection for one namespace.
+ *
+ * COM interface pointers are apartment-affine, so connections are cached
+ * per-thread and never shared. Reusing the locator and services connection
+ * avoids paying CoCreateInstance and ConnectServer for every query when a
+ * pack runs several WMI-backed tables.
+ */
+struct WmiConnection {
+  IWbemLocator* locator{nullptr};
+  IWbemServices* services{nullptr};
+
+  WmiConnection() = default;
+  WmiConnection(WmiConnection&& src) {
+    std::swap(locator, src.locator);
+    std::swap(services, src.services);
+  }
+
+  ~WmiConnection() {
+    if (services != nullptr) {
+      services->Release();
+    }
+    if (locator != nullptr) {
+      locator->Release();
+    }
+  }
+};
+
+/// The per-thread connection cache, keyed by namespace.
+std::map<std::wstring, WmiConnection>& wmiConnections() {
+  thread_local std::map<std::wstring, WmiConnection> connections;
+  return connections;
+}
+
+/// Get (or establish and cache) a services connection for a namespace.
+IWbemServices* getWmiConnection(BSTR nspace) {
+  auto& connections = wmiConnections();
+
+  std::wstring key(static_cast<wchar_t*>(nspace));
+  auto it = connections.find(key);
+  if (it != connections.end()) {
+    return it->second.services;
+  }
+
+  WmiConnection conn;
+  auto hr = ::CoCreateInstance(CLSID_WbemLocator,
+                               0,
+                               CLSCTX_INPROC_SERVER,
+                               IID_IWbemLocator,
+                               (LPVOID*)&conn.locator);
+  if (hr != S_OK) {
+    conn.locator = nullptr;
+    return nullptr;
+  }
+
+  hr = conn.locator->ConnectServer(
+      nspace, nullptr, nullptr, nullptr, 0, nullptr, nullptr, &conn.services);
+  if (hr != S_OK) {
+    conn.services = nullptr;
+    return nullptr;
+  }
+
+  // Only healthy connections are cached; failures are retried next query.
+  auto* services = conn.services;
+  connections.emplace(std::move(key), std::move(conn));
+  return services;
+}
+
+/// Drop a cached connection, applied when a query fails on it.
+void dropWmiConnection(BSTR nspace) {
+  wmiConnections().erase(std::wstring(static_cast<wchar_t*>(nspace)));
+}
+} // namespace
+
 WmiRequest::WmiRequest(const std::string& query, BSTR nspace) {
   std::wstring wql = stringToWstring(query);
 
@@ -268,26 +344,17 @@ WmiRequest::WmiRequest(const std::string& query, BSTR nspace) {
                               nullptr,
                               EOAC_NONE,
                               nullptr);
-  hr = ::CoCreateInstance(CLSID_WbemLocator,
-                          0,
-                          CLSCTX_INPROC_SERVER,
-                          IID_IWbemLocator,
-                          (LPVOID*)&locator_);
-  if (hr != S_OK) {
-    locator_ = nullptr;
-    return;
-  }
 
-  hr = locator_->ConnectServer(
-      nspace, nullptr, nullptr, nullptr, 0, nullptr, nullptr, &services_);
-  if (hr != S_OK) {
-    services_ = nullptr;
+  auto* services = getWmiConnection(nspace);
+  if (services == nullptr) {
     return;
   }
 
-  hr = services_->ExecQuery(
+  hr = services->ExecQuery(
       (BSTR)L"WQL", (BSTR)wql.c_str(), WBEM_FLAG_FORWARD_ONLY, nullptr, &enum_);
   if (hr != S_OK) {
+    // The provider connection may be stale; re-establish it next query.
+    dropWmiConnection(nspace);
     enum_ = nullptr;
     return;
   }
@@ -307,12 +374,6 @@ WmiRequest::WmiRequest(const std::string& query, BSTR nspace) {
 }
 
 WmiRequest::WmiRequest(WmiRequest&& src) {
-  locator_ = nullptr;
-  std::swap(locator_, src.locator_);
-
-  services_ = nullptr;
-  std::swap(services_, src.services_);
-
   enum_ = nullptr;
   std::swap(enum_, src.enum_);
 }
@@ -324,15 +385,5 @@ WmiRequest::~WmiRequest() {
     enum_->Release();
     enum_ = nullptr;
   }
-
-  if (services_ != nullptr) {
-    services_->Release();
-    services_ = nullptr;
-  }
-
-  if (locator_ != nullptr) {
-    locator_->Release();
-    locator_ = nullptr;
-  }
 }
 }
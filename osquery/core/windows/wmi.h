@@ -201,8 +201,6 @@ class WmiRequest {
  private:
   Status status_;
   std::vector<WmiResultItem> results_;
-  IWbemLocator* locator_{nullptr};
-  IWbemServices* services_{nullptr};
   IEnumWbemClassObject* enum_{nullptr};
 };
 }
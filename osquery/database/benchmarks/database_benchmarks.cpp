@@ -95,6 +95,44 @@ BENCHMARK(DATABASE_serialize_json)
     ->ArgPair(10, 10)
     ->ArgPair(10, 100);
 
+static void DATABASE_deserialize_json(benchmark::State& state) {
+  std::string content;
+  auto qd = getExampleQueryData(state.range(0), state.range(1));
+  serializeQueryDataJSON(qd, content);
+
+  while (state.KeepRunning()) {
+    QueryDataSet decoded;
+    deserializeQueryDataJSON(content, decoded);
+  }
+  state.SetBytesProcessed(state.iterations() * content.size());
+}
+
+BENCHMARK(DATABASE_deserialize_json)
+    ->ArgPair(1, 1)
+    ->ArgPair(10, 10)
+    ->ArgPair(10, 100)
+    ->ArgPair(100, 1000);
+
+static void DATABASE_restore_and_diff(benchmark::State& state) {
+  // The stored-results half of the differential pipeline: decode the
+  // previous result set and diff the identical current rows against it.
+  std::string content;
+  auto qd = getExampleQueryData(state.range(0), state.range(1));
+  serializeQueryDataJSON(qd, content);
+
+  while (state.KeepRunning()) {
+    QueryDataSet previous;
+    deserializeQueryDataJSON(content, previous);
+    auto d = diff(previous, qd);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+
+BENCHMARK(DATABASE_restore_and_diff)
+    ->ArgPair(10, 100)
+    ->ArgPair(10, 1000)
+    ->ArgPair(100, 1000);
+
 static void DATABASE_diff(benchmark::State& state) {
   QueryData qd = getExampleQueryData(state.range(0), state.range(1));
   QueryDataSet qds = getExampleQueryDataSet(state.range(0), state.range(1));
@@ -8,6 +8,8 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <algorithm>
+
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
@@ -24,7 +26,8 @@ namespace rj = rapidjson;
 namespace osquery {
 
 /// Generate a specific-use registry for database access abstraction.
-CREATE_REGISTRY(DatabasePlugin, "database");
+/// Lazy: setUp runs when initPlugin activates the selected backing store.
+CREATE_LAZY_REGISTRY(DatabasePlugin, "database");
 
 CLI_FLAG(bool, database_dump, false, "Dump the contents of the backing store");
 
@@ -42,6 +45,7 @@ const std::string kQueries = "queries";
 const std::string kEvents = "events";
 const std::string kCarves = "carves";
 const std::string kLogs = "logs";
+const std::string kPerformance = "performance";
 
 const std::string kDbEpochSuffix = "epoch";
 const std::string kDbCounterSuffix = "counter";
@@ -49,7 +53,7 @@ const std::string kDbCounterSuffix = "counter";
 const std::string kDatabaseResultsVersion = "1";
 
 const std::vector<std::string> kDomains = {
-    kPersistentSettings, kQueries, kEvents, kLogs, kCarves};
+    kPersistentSettings, kQueries, kEvents, kLogs, kCarves, kPerformance};
 
 std::atomic<bool> DatabasePlugin::kDBAllowOpen(false);
 std::atomic<bool> DatabasePlugin::kDBRequireWrite(false);
@@ -115,6 +119,68 @@ Status DatabasePlugin::scan(const std::string& domain,
   return Status(0, "Not used");
 }
 
+Status DatabasePlugin::scanValues(const std::string& domain,
+                                  DatabaseStringValueList& results,
+                                  const std::string& prefix,
+                                  size_t max) const {
+  // Plugins with ordered iterators override this with a single range read.
+  std::vector<std::string> keys;
+  auto status = this->scan(domain, keys, prefix, max);
+  if (!status.ok()) {
+    return status;
+  }
+
+  for (const auto& key : keys) {
+    std::string value;
+    if (this->get(domain, key, value).ok()) {
+      results.push_back(std::make_pair(key, std::move(value)));
+    }
+  }
+  return Status(0, "OK");
+}
+
+Status DatabasePlugin::scanChunk(const std::string& domain,
+                                 std::vector<std::string>& results,
+                                 const std::string& prefix,
+                                 const std::string& start,
+                                 size_t max) const {
+  if (max == 0) {
+    return Status(1, "A chunked scan requires a max");
+  }
+
+  // Plugins with ordered iterators override this with a bounded seek; the
+  // fallback scans all keys and windows the sorted result.
+  std::vector<std::string> keys;
+  auto status = this->scan(domain, keys, prefix, 0);
+  if (!status.ok()) {
+    return status;
+  }
+
+  std::sort(keys.begin(), keys.end());
+  for (auto& key : keys) {
+    if (!start.empty() && key <= start) {
+      continue;
+    }
+    results.push_back(std::move(key));
+    if (results.size() >= max) {
+      break;
+    }
+  }
+  return Status(0, "OK");
+}
+
+Status DatabasePlugin::putBatch(const std::string& domain,
+                                const DatabaseStringValueList& data) {
+  // Plugins with native batching override this with one atomic write.
+  for (const auto& pair : data) {
+    auto status = this->put(domain, pair.first, pair.second);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  return Status(0, "OK");
+}
+
 Status DatabasePlugin::call(const PluginRequest& request,
                             PluginResponse& response) {
   if (request.count("action") == 0) {
@@ -173,6 +239,32 @@ Status DatabasePlugin::call(const PluginRequest& request,
       response.push_back({{"k", k}});
     }
     return status;
+  } else if (request.at("action") == "scan_chunk") {
+    // Accumulate one bounded chunk of keys, resuming after a cursor.
+    std::vector<std::string> keys;
+    size_t max = 0;
+    if (request.count("max") > 0) {
+      max = std::stoul(request.at("max"));
+    }
+    auto start = (request.count("start") > 0) ? request.at("start") : "";
+    auto status =
+        this->scanChunk(domain, keys, request.at("prefix"), start, max);
+    for (const auto& k : keys) {
+      response.push_back({{"k", k}});
+    }
+    return status;
+  } else if (request.at("action") == "scan_values") {
+    // Accumulate scanned key/value pairs into the response.
+    DatabaseStringValueList results;
+    size_t max = 0;
+    if (request.count("max") > 0) {
+      max = std::stoul(request.at("max"));
+    }
+    auto status = this->scanValues(domain, results, request.at("prefix"), max);
+    for (const auto& pair : results) {
+      response.push_back({{"k", pair.first}, {"v", pair.second}});
+    }
+    return status;
   }
 
   return Status(1, "Unknown database plugin action");
@@ -261,6 +353,32 @@ Status setDatabaseValue(const std::string& domain,
   return setDatabaseValue(domain, key, std::to_string(value));
 }
 
+Status setDatabaseBatchValues(const std::string& domain,
+                              const DatabaseStringValueList& data) {
+  if (domain.empty()) {
+    return Status(1, "Missing domain");
+  }
+
+  if (RegistryFactory::get().external()) {
+    // The extension API has no batch action, fall back to individual puts.
+    for (const auto& pair : data) {
+      auto status = setDatabaseValue(domain, pair.first, pair.second);
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    return Status(0, "OK");
+  }
+
+  ReadLock lock(kDatabaseReset);
+  if (!DatabasePlugin::kDBInitialized) {
+    throw std::runtime_error("Cannot set database values for: " + domain);
+  } else {
+    auto plugin = getDatabasePlugin();
+    return plugin->putBatch(domain, data);
+  }
+}
+
 Status deleteDatabaseValue(const std::string& domain, const std::string& key) {
   if (domain.empty()) {
     return Status(1, "Missing domain");
@@ -352,6 +470,101 @@ Status scanDatabaseKeys(const std::string& domain,
   }
 }
 
+Status scanDatabaseValues(const std::string& domain,
+                          DatabaseStringValueList& results,
+                          const std::string& prefix,
+                          size_t max) {
+  if (domain.empty()) {
+    return Status(1, "Missing domain");
+  }
+
+  if (RegistryFactory::get().external()) {
+    // External registries (extensions) do not have databases active.
+    // It is not possible to use an extension-based database.
+    PluginRequest request = {{"action", "scan_values"},
+                             {"domain", domain},
+                             {"prefix", prefix},
+                             {"max", std::to_string(max)}};
+    PluginResponse response;
+    auto status = Registry::call("database", request, response);
+
+    for (const auto& item : response) {
+      if (item.count("k") > 0 && item.count("v") > 0) {
+        results.push_back(std::make_pair(item.at("k"), item.at("v")));
+      }
+    }
+    return status;
+  }
+
+  ReadLock lock(kDatabaseReset);
+  if (!DatabasePlugin::kDBInitialized) {
+    throw std::runtime_error("Cannot scan database values: " + prefix);
+  } else {
+    auto plugin = getDatabasePlugin();
+    return plugin->scanValues(domain, results, prefix, max);
+  }
+}
+
+Status scanDatabaseKeysChunked(
+    const std::string& domain,
+    std::function<bool(const std::vector<std::string>& keys)> predicate,
+    const std::string& prefix,
+    size_t chunk) {
+  if (domain.empty()) {
+    return Status(1, "Missing domain");
+  }
+
+  if (chunk == 0) {
+    return Status(1, "A chunked scan requires a chunk size");
+  }
+
+  std::string start;
+  while (true) {
+    std::vector<std::string> keys;
+    Status status;
+    if (RegistryFactory::get().external()) {
+      // External registries (extensions) do not have databases active.
+      // It is not possible to use an extension-based database.
+      PluginRequest request = {{"action", "scan_chunk"},
+                               {"domain", domain},
+                               {"prefix", prefix},
+                               {"start", start},
+                               {"max", std::to_string(chunk)}};
+      PluginResponse response;
+      status = Registry::call("database", request, response);
+
+      for (const auto& item : response) {
+        if (item.count("k") > 0) {
+          keys.push_back(item.at("k"));
+        }
+      }
+    } else {
+      ReadLock lock(kDatabaseReset);
+      if (!DatabasePlugin::kDBInitialized) {
+        throw std::runtime_error("Cannot scan database values: " + prefix);
+      }
+      status =
+          getDatabasePlugin()->scanChunk(domain, keys, prefix, start, chunk);
+    }
+
+    if (!status.ok()) {
+      return status;
+    }
+
+    if (keys.empty()) {
+      return Status(0, "OK");
+    }
+
+    // The cursor is the last key of this chunk; the next chunk resumes
+    // strictly after it.
+    start = keys.back();
+    auto partial = (keys.size() < chunk);
+    if (!predicate(keys) || partial) {
+      return Status(0, "OK");
+    }
+  }
+}
+
 void resetDatabase() {
   PluginRequest request = {{"action", "reset"}};
   Registry::call("database", request);
@@ -10,10 +10,21 @@
 
 #include <iostream>
 
+#include <osquery/filesystem.h>
+#include <osquery/flags.h>
+#include <osquery/system.h>
+
+#include "osquery/core/json.h"
 #include "osquery/database/plugins/ephemeral.h"
 
 namespace osquery {
 
+/// Seconds of writes at risk between ephemeral snapshot checkpoints.
+CLI_FLAG(uint64,
+         database_checkpoint_interval,
+         60,
+         "Seconds between ephemeral snapshot database checkpoints");
+
 template <typename T>
 Status EphemeralDatabasePlugin::getAny(const std::string& domain,
                                        const std::string& key,
@@ -117,4 +128,151 @@ Status EphemeralDatabasePlugin::scan(const std::string& domain,
   }
   return Status(0);
 }
+
+std::string SnapshotDatabasePlugin::snapshotPath() const {
+  return FLAGS_database_path + ".snapshot";
+}
+
+Status SnapshotDatabasePlugin::setUp() {
+  auto s = EphemeralDatabasePlugin::setUp();
+  if (!s.ok()) {
+    return s;
+  }
+
+  s = restore();
+  if (!s.ok()) {
+    // A missing or damaged snapshot degrades to a fresh ephemeral store.
+    VLOG(1) << "Could not restore database snapshot: " << s.getMessage();
+  }
+
+  dirty_ = 0;
+  last_checkpoint_ = getUnixTime();
+  return Status(0);
+}
+
+void SnapshotDatabasePlugin::tearDown() {
+  if (dirty_ > 0) {
+    auto s = checkpoint();
+    if (!s.ok()) {
+      VLOG(1) << "Could not write database snapshot: " << s.getMessage();
+    }
+  }
+}
+
+Status SnapshotDatabasePlugin::put(const std::string& domain,
+                                   const std::string& key,
+                                   const std::string& value) {
+  auto s = EphemeralDatabasePlugin::put(domain, key, value);
+  maybeCheckpoint();
+  return s;
+}
+
+Status SnapshotDatabasePlugin::put(const std::string& domain,
+                                   const std::string& key,
+                                   int value) {
+  auto s = EphemeralDatabasePlugin::put(domain, key, value);
+  maybeCheckpoint();
+  return s;
+}
+
+Status SnapshotDatabasePlugin::remove(const std::string& domain,
+                                      const std::string& k) {
+  auto s = EphemeralDatabasePlugin::remove(domain, k);
+  maybeCheckpoint();
+  return s;
+}
+
+Status SnapshotDatabasePlugin::removeRange(const std::string& domain,
+                                           const std::string& low,
+                                           const std::string& high) {
+  auto s = EphemeralDatabasePlugin::removeRange(domain, low, high);
+  maybeCheckpoint();
+  return s;
+}
+
+void SnapshotDatabasePlugin::maybeCheckpoint() {
+  dirty_++;
+  if (getUnixTime() - last_checkpoint_ <
+      static_cast<size_t>(FLAGS_database_checkpoint_interval)) {
+    return;
+  }
+
+  auto s = checkpoint();
+  if (!s.ok()) {
+    VLOG(1) << "Could not write database snapshot: " << s.getMessage();
+  }
+}
+
+Status SnapshotDatabasePlugin::checkpoint() {
+  auto doc = JSON::newObject();
+  for (const auto& domain : db_) {
+    auto obj = doc.getObject();
+    for (const auto& item : domain.second) {
+      if (item.second.which() == 0) {
+        doc.add(item.first, boost::get<int>(item.second), obj);
+      } else {
+        doc.addCopy(item.first, boost::get<std::string>(item.second), obj);
+      }
+    }
+    doc.add(domain.first, obj);
+  }
+
+  std::string content;
+  auto s = doc.toString(content);
+  if (!s.ok()) {
+    return s;
+  }
+
+  // Write-then-rename so a crash mid-checkpoint keeps the last snapshot.
+  auto path = snapshotPath();
+  s = writeTextFile(path + ".tmp", content, 0600);
+  if (!s.ok()) {
+    return s;
+  }
+  s = movePath(path + ".tmp", path);
+  if (!s.ok()) {
+    return s;
+  }
+
+  dirty_ = 0;
+  last_checkpoint_ = getUnixTime();
+  return Status(0);
+}
+
+Status SnapshotDatabasePlugin::restore() {
+  auto path = snapshotPath();
+  if (!pathExists(path).ok()) {
+    return Status(0, "No snapshot to restore");
+  }
+
+  std::string content;
+  auto s = readFile(path, content);
+  if (!s.ok()) {
+    return s;
+  }
+
+  JSON doc;
+  s = doc.fromString(content);
+  if (!s.ok()) {
+    return s;
+  }
+  if (!doc.doc().IsObject()) {
+    return Status(1, "Invalid snapshot content");
+  }
+
+  for (const auto& domain : doc.doc().GetObject()) {
+    if (!domain.value.IsObject()) {
+      continue;
+    }
+    auto name = std::string(domain.name.GetString());
+    for (const auto& item : domain.value.GetObject()) {
+      if (item.value.IsInt()) {
+        db_[name][item.name.GetString()] = item.value.GetInt();
+      } else if (item.value.IsString()) {
+        db_[name][item.name.GetString()] = std::string(item.value.GetString());
+      }
+    }
+  }
+  return Status(0);
+}
 }
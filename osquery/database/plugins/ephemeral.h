@@ -66,11 +66,69 @@ class EphemeralDatabasePlugin : public DatabasePlugin {
     return Status(0);
   }
 
- private:
+ protected:
   DBType db_;
 };
 
 /// Backing-storage provider for osquery internal/core.
 REGISTER_INTERNAL(EphemeralDatabasePlugin, "database", "ephemeral");
 
+/**
+ * @brief An in-memory database with periodic snapshot checkpoints.
+ *
+ * Diskless and container deployments either lose all state on restart
+ * (ephemeral, or RocksDB on tmpfs) or pay full database I/O on overlay
+ * storage. This plugin keeps the hot maps in memory and periodically
+ * writes a compact snapshot file next to --database_path, restoring it
+ * on setup, so a restart loses at most one checkpoint interval of
+ * writes.
+ */
+class SnapshotDatabasePlugin : public EphemeralDatabasePlugin {
+ public:
+  /// Data storage method, marks the database dirty.
+  Status put(const std::string& domain,
+             const std::string& key,
+             const std::string& value) override;
+  Status put(const std::string& domain,
+             const std::string& key,
+             int value) override;
+
+  /// Data removal method, marks the database dirty.
+  Status remove(const std::string& domain, const std::string& k) override;
+
+  Status removeRange(const std::string& domain,
+                     const std::string& low,
+                     const std::string& high) override;
+
+ public:
+  /// Database workflow: restore the last snapshot into memory.
+  Status setUp() override;
+
+  /// Database workflow: write a final snapshot of dirty state.
+  void tearDown() override;
+
+ private:
+  /// The snapshot file written beside the configured database path.
+  std::string snapshotPath() const;
+
+  /// Serialize the in-memory maps into the snapshot file, atomically.
+  Status checkpoint();
+
+  /// Restore the in-memory maps from the snapshot file, if one exists.
+  Status restore();
+
+  /// Checkpoint when dirty and the checkpoint interval has elapsed.
+  void maybeCheckpoint();
+
+ private:
+  /// Number of writes since the last checkpoint.
+  size_t dirty_{0};
+
+  /// Unix time of the last checkpoint.
+  size_t last_checkpoint_{0};
+};
+
+/// Backing-storage provider trading bounded data loss for memory speed.
+REGISTER_INTERNAL(SnapshotDatabasePlugin, "database", "ephemeral_snapshot");
+
 } // namespace osquery
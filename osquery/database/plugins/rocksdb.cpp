@@ -10,13 +10,19 @@
 
 #include <sys/stat.h>
 
+#include <zstd.h>
+
 #include <rocksdb/db.h>
 #include <rocksdb/env.h>
+#include <rocksdb/filter_policy.h>
 #include <rocksdb/options.h>
+#include <rocksdb/table.h>
+#include <rocksdb/write_batch.h>
 
 #include <osquery/filesystem.h>
 #include <osquery/logger.h>
 #include <osquery/registry_factory.h>
+#include <osquery/tables.h>
 
 #include "osquery/core/conversions.h"
 #include "osquery/database/plugins/rocksdb.h"
@@ -32,6 +38,12 @@ HIDDEN_FLAG(int32, rocksdb_merge_number, 4, "Min write buffer number to merge");
 HIDDEN_FLAG(int32, rocksdb_background_flushes, 4, "Max background flushes");
 HIDDEN_FLAG(uint64, rocksdb_buffer_blocks, 256, "Write buffer blocks (4k)");
 
+/// Large serialized results compress well and dominate the database size.
+CLI_FLAG(bool,
+         rocksdb_value_compression,
+         true,
+         "Compress large values stored in the queries and events domains");
+
 DECLARE_string(database_path);
 
 /**
@@ -45,6 +57,70 @@ std::atomic<bool> kRocksDBCorruptionIndicator{false};
 /// Backing-storage provider for osquery internal/core.
 REGISTER_INTERNAL(RocksDBDatabasePlugin, "database", "rocksdb");
 
+/// Minimum value size where per-value zstd compression is expected to pay off.
+const size_t kCompressValueMin = 256;
+
+/// Only domains dominated by large serialized rows are compressed.
+static inline bool isCompressedDomain(const std::string& domain) {
+  return (domain == kQueries || domain == kEvents);
+}
+
+/// Compressed values are stored as raw zstd frames, detected by their magic.
+static inline bool isCompressedValue(const std::string& value) {
+  return (value.size() > 4 && static_cast<uint8_t>(value[0]) == 0x28 &&
+          static_cast<uint8_t>(value[1]) == 0xB5 &&
+          static_cast<uint8_t>(value[2]) == 0x2F &&
+          static_cast<uint8_t>(value[3]) == 0xFD);
+}
+
+/// Replace a stored zstd frame with its raw content.
+static Status decompressValue(std::string& value) {
+  auto expected = ZSTD_getFrameContentSize(value.data(), value.size());
+  if (expected == ZSTD_CONTENTSIZE_ERROR ||
+      expected == ZSTD_CONTENTSIZE_UNKNOWN) {
+    return Status(1, "Invalid compressed value content size");
+  }
+
+  std::string raw;
+  raw.resize(static_cast<size_t>(expected));
+  auto rc =
+      ZSTD_decompress(&raw[0], raw.size(), value.data(), value.size());
+  if (ZSTD_isError(rc)) {
+    return Status(
+        1, "Value decompression failed: " + std::string(ZSTD_getErrorName(rc)));
+  }
+  raw.resize(rc);
+  value = std::move(raw);
+  return Status(0);
+}
+
+/**
+ * @brief Return the stored representation of a value for a domain.
+ *
+ * Values in the queries and events domains above the size threshold are
+ * written as zstd frames. Values that fail to compress, or do not shrink,
+ * are stored raw; readers tell the two apart by the zstd frame magic, so
+ * databases written before compression was enabled remain readable.
+ */
+static std::string maybeCompressValue(const std::string& domain,
+                                      const std::string& value) {
+  if (!FLAGS_rocksdb_value_compression || !isCompressedDomain(domain) ||
+      value.size() < kCompressValueMin) {
+    return value;
+  }
+
+  std::string compressed;
+  compressed.resize(ZSTD_compressBound(value.size()));
+  auto rc = ZSTD_compress(
+      &compressed[0], compressed.size(), value.data(), value.size(), 1);
+  if (ZSTD_isError(rc) || rc >= value.size()) {
+    // Store incompressible values raw.
+    return value;
+  }
+  compressed.resize(rc);
+  return compressed;
+}
+
 void GlogRocksDBLogger::Logv(const char* format, va_list ap) {
   // Convert RocksDB log to string and check if header or level-ed log.
   std::string log_line;
@@ -74,6 +150,33 @@ void GlogRocksDBLogger::Logv(const char* format, va_list ap) {
   }
 }
 
+rocksdb::ColumnFamilyOptions RocksDBDatabasePlugin::getDomainOptions(
+    const std::string& domain) const {
+  rocksdb::ColumnFamilyOptions cf_options(options_);
+  rocksdb::BlockBasedTableOptions table_options;
+
+  if (domain == kEvents) {
+    // Events are written continuously and read back as index-order scans.
+    // A larger memtable batches the write load, and an aggressive level0
+    // trigger merges expiration deletes into the scans sooner.
+    cf_options.write_buffer_size = 4 * options_.write_buffer_size;
+    cf_options.min_write_buffer_number_to_merge = 2;
+    cf_options.level0_file_num_compaction_trigger = 2;
+  } else {
+    // The remaining domains are point lookups by well-known keys; bloom
+    // filters skip the SST files that cannot contain the key.
+    table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10));
+    if (domain != kQueries) {
+      // Settings, logs, and carve metadata are tiny and read-mostly.
+      cf_options.write_buffer_size = 64 * 1024;
+    }
+  }
+
+  cf_options.table_factory.reset(
+      rocksdb::NewBlockBasedTableFactory(table_options));
+  return cf_options;
+}
+
 Status RocksDBDatabasePlugin::setUp() {
   if (!DatabasePlugin::kDBAllowOpen) {
     LOG(WARNING) << RLOG(1629) << "Not allowed to set up database plugin";
@@ -118,7 +221,7 @@ Status RocksDBDatabasePlugin::setUp() {
 
     for (const auto& cf_name : kDomains) {
       column_families_.push_back(
-          rocksdb::ColumnFamilyDescriptor(cf_name, options_));
+          rocksdb::ColumnFamilyDescriptor(cf_name, getDomainOptions(cf_name)));
     }
   }
 
@@ -237,6 +340,19 @@ rocksdb::ColumnFamilyHandle* RocksDBDatabasePlugin::getHandleForColumnFamily(
   }
 }
 
+bool RocksDBDatabasePlugin::getDomainProperty(const std::string& domain,
+                                              const std::string& property,
+                                              uint64_t& value) const {
+  if (getDB() == nullptr) {
+    return false;
+  }
+  auto cfh = getHandleForColumnFamily(domain);
+  if (cfh == nullptr) {
+    return false;
+  }
+  return getDB()->GetIntProperty(cfh, property, &value);
+}
+
 Status RocksDBDatabasePlugin::get(const std::string& domain,
                                   const std::string& key,
                                   std::string& value) const {
@@ -248,6 +364,12 @@ Status RocksDBDatabasePlugin::get(const std::string& domain,
     return Status(1, "Could not get column family for " + domain);
   }
   auto s = getDB()->Get(rocksdb::ReadOptions(), cfh, key, &value);
+  if (s.ok() && isCompressedDomain(domain) && isCompressedValue(value)) {
+    auto decompress = decompressValue(value);
+    if (!decompress.ok()) {
+      return decompress;
+    }
+  }
   return Status(s.code(), s.ToString());
 }
 
@@ -280,7 +402,7 @@ Status RocksDBDatabasePlugin::put(const std::string& domain,
   if (kEvents != domain) {
     options.sync = true;
   }
-  auto s = getDB()->Put(options, cfh, key, value);
+  auto s = getDB()->Put(options, cfh, key, maybeCompressValue(domain, value));
   if (s.code() != 0 && s.IsIOError()) {
     // An error occurred, check if it is an IO error and remove the offending
     // specific filename or log name.
@@ -299,6 +421,40 @@ Status RocksDBDatabasePlugin::put(const std::string& domain,
   return this->put(domain, key, std::to_string(value));
 }
 
+Status RocksDBDatabasePlugin::putBatch(const std::string& domain,
+                                       const DatabaseStringValueList& data) {
+  if (read_only_) {
+    return Status(0, "Database in readonly mode");
+  }
+
+  auto cfh = getHandleForColumnFamily(domain);
+  if (cfh == nullptr) {
+    return Status(1, "Could not get column family for " + domain);
+  }
+
+  rocksdb::WriteBatch batch;
+  for (const auto& pair : data) {
+    batch.Put(cfh, pair.first, maybeCompressValue(domain, pair.second));
+  }
+
+  auto options = rocksdb::WriteOptions();
+  // Events should be fast, and do not need to force syncs.
+  if (kEvents != domain) {
+    options.sync = true;
+  }
+  auto s = getDB()->Write(options, &batch);
+  if (s.code() != 0 && s.IsIOError()) {
+    // An error occurred, check if it is an IO error and remove the offending
+    // specific filename or log name.
+    std::string error_string = s.ToString();
+    size_t error_pos = error_string.find_last_of(":");
+    if (error_pos != std::string::npos) {
+      return Status(s.code(), "IOError: " + error_string.substr(error_pos + 2));
+    }
+  }
+  return Status(s.code(), s.ToString());
+}
+
 void RocksDBDatabasePlugin::dumpDatabase() const {}
 
 Status RocksDBDatabasePlugin::remove(const std::string& domain,
@@ -380,4 +536,134 @@ Status RocksDBDatabasePlugin::scan(const std::string& domain,
   delete it;
   return Status(0, "OK");
 }
+
+Status RocksDBDatabasePlugin::scanChunk(const std::string& domain,
+                                        std::vector<std::string>& results,
+                                        const std::string& prefix,
+                                        const std::string& start,
+                                        size_t max) const {
+  if (max == 0) {
+    return Status(1, "A chunked scan requires a max");
+  }
+
+  if (getDB() == nullptr) {
+    return Status(1, "Database not opened");
+  }
+
+  auto cfh = getHandleForColumnFamily(domain);
+  if (cfh == nullptr) {
+    return Status(1, "Could not get column family for " + domain);
+  }
+  auto options = rocksdb::ReadOptions();
+  options.verify_checksums = false;
+  options.fill_cache = false;
+  auto it = getDB()->NewIterator(options, cfh);
+  if (it == nullptr) {
+    return Status(1, "Could not get iterator for " + domain);
+  }
+
+  // Keys sharing a prefix are a contiguous range in the ordered store;
+  // seek directly to the resume cursor instead of walking from the front.
+  it->Seek((start.empty()) ? prefix : start);
+  if (!start.empty() && it->Valid() && it->key().ToString() == start) {
+    // The cursor key itself was returned by the previous chunk.
+    it->Next();
+  }
+
+  for (; it->Valid(); it->Next()) {
+    auto key = it->key().ToString();
+    if (key.find(prefix) != 0) {
+      break;
+    }
+    results.push_back(std::move(key));
+    if (results.size() >= max) {
+      break;
+    }
+  }
+  delete it;
+  return Status(0, "OK");
+}
+
+Status RocksDBDatabasePlugin::scanValues(const std::string& domain,
+                                         DatabaseStringValueList& results,
+                                         const std::string& prefix,
+                                         size_t max) const {
+  if (getDB() == nullptr) {
+    return Status(1, "Database not opened");
+  }
+
+  auto cfh = getHandleForColumnFamily(domain);
+  if (cfh == nullptr) {
+    return Status(1, "Could not get column family for " + domain);
+  }
+  auto options = rocksdb::ReadOptions();
+  options.verify_checksums = false;
+  options.fill_cache = false;
+  auto it = getDB()->NewIterator(options, cfh);
+  if (it == nullptr) {
+    return Status(1, "Could not get iterator for " + domain);
+  }
+
+  // Values are read in the same iterator pass as the keys, without a
+  // point-lookup (and its read amplification) per key.
+  size_t count = 0;
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    auto key = it->key().ToString();
+    if (key.find(prefix) == 0) {
+      auto value = it->value().ToString();
+      if (isCompressedDomain(domain) && isCompressedValue(value)) {
+        auto decompress = decompressValue(value);
+        if (!decompress.ok()) {
+          VLOG(1) << "Skipping undecompressable value for key " << key;
+          continue;
+        }
+      }
+      results.push_back(std::make_pair(std::move(key), std::move(value)));
+      if (max > 0 && ++count >= max) {
+        break;
+      }
+    }
+  }
+  delete it;
+  return Status(0, "OK");
+}
+
+namespace tables {
+
+QueryData genOsqueryRocksDBStats(QueryContext& context) {
+  QueryData results;
+
+  auto plugin = RegistryFactory::get().plugin("database", "rocksdb");
+  auto rocksdb = std::dynamic_pointer_cast<RocksDBDatabasePlugin>(plugin);
+  if (rocksdb == nullptr) {
+    return results;
+  }
+
+  for (const auto& domain : kDomains) {
+    Row r;
+    r["domain"] = domain;
+
+    auto property = [&rocksdb, &domain, &r](const std::string& name,
+                                            const std::string& column) {
+      uint64_t value = 0;
+      rocksdb->getDomainProperty(domain, name, value);
+      r[column] = BIGINT(value);
+    };
+
+    property("rocksdb.estimate-num-keys", "keys");
+    property("rocksdb.cur-size-all-mem-tables", "memtable_bytes");
+    property("rocksdb.total-sst-files-size", "sst_bytes");
+    property("rocksdb.num-files-at-level0", "level0_files");
+    property("rocksdb.estimate-pending-compaction-bytes",
+             "pending_compaction_bytes");
+    property("rocksdb.num-running-compactions", "running_compactions");
+    property("rocksdb.num-running-flushes", "running_flushes");
+    property("rocksdb.actual-delayed-write-rate", "delayed_write_rate");
+    property("rocksdb.is-write-stopped", "write_stopped");
+    results.push_back(r);
+  }
+
+  return results;
+}
+} // namespace tables
 }
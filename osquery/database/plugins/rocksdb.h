@@ -52,6 +52,10 @@ class RocksDBDatabasePlugin : public DatabasePlugin {
              const std::string& key,
              int value) override;
 
+  /// Atomic multi-put method, backed by a RocksDB WriteBatch.
+  Status putBatch(const std::string& domain,
+                  const DatabaseStringValueList& data) override;
+
   void dumpDatabase() const override;
 
   /// Data removal method.
@@ -68,6 +72,31 @@ class RocksDBDatabasePlugin : public DatabasePlugin {
               const std::string& prefix,
               size_t max) const override;
 
+  /// Key and value range read, a single iterator pass.
+  Status scanValues(const std::string& domain,
+                    DatabaseStringValueList& results,
+                    const std::string& prefix,
+                    size_t max) const override;
+
+  /// Bounded key chunk read, seeking directly to the resume cursor.
+  Status scanChunk(const std::string& domain,
+                   std::vector<std::string>& results,
+                   const std::string& prefix,
+                   const std::string& start,
+                   size_t max) const override;
+
+ public:
+  /**
+   * @brief Read a per-domain integer property from the storage engine.
+   *
+   * Exposes RocksDB's integer properties (compaction, stall, and size
+   * counters) for a single column family, used by the osquery_rocksdb_stats
+   * table.
+   */
+  bool getDomainProperty(const std::string& domain,
+                         const std::string& property,
+                         uint64_t& value) const;
+
  public:
   /// Database workflow: open and setup.
   Status setUp() override;
@@ -91,6 +120,17 @@ class RocksDBDatabasePlugin : public DatabasePlugin {
   rocksdb::ColumnFamilyHandle* getHandleForColumnFamily(
       const std::string& cf) const;
 
+  /**
+   * @brief Build the column family options for a single domain.
+   *
+   * Domains have very different access patterns: events are write-heavy
+   * and scanned in index order, query baselines are point lookups, and the
+   * remaining domains are tiny and read-mostly. Each derives its options
+   * from the shared database options.
+   */
+  rocksdb::ColumnFamilyOptions getDomainOptions(
+      const std::string& domain) const;
+
   /**
    * @brief Helper method which can be used to get a raw pointer to the
    * underlying RocksDB database handle
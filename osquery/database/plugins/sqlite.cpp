@@ -199,6 +199,39 @@ Status SQLiteDatabasePlugin::put(const std::string& domain,
   return this->put(domain, key, std::to_string(value));
 }
 
+Status SQLiteDatabasePlugin::putBatch(const std::string& domain,
+                                      const DatabaseStringValueList& data) {
+  if (read_only_) {
+    return Status(0, "Database in readonly mode");
+  }
+
+  // All inserts commit together, a single fsync instead of one per pair.
+  sqlite3_exec(db_, "begin transaction;", nullptr, nullptr, nullptr);
+
+  sqlite3_stmt* stmt = nullptr;
+  std::string q = "insert or replace into " + domain + " values (?1, ?2);";
+  sqlite3_prepare_v2(db_, q.c_str(), -1, &stmt, nullptr);
+
+  for (const auto& pair : data) {
+    sqlite3_bind_text(stmt, 1, pair.first.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, pair.second.c_str(), -1, SQLITE_STATIC);
+    auto rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+      sqlite3_finalize(stmt);
+      sqlite3_exec(db_, "rollback transaction;", nullptr, nullptr, nullptr);
+      return Status(1);
+    }
+    sqlite3_reset(stmt);
+  }
+
+  sqlite3_finalize(stmt);
+  sqlite3_exec(db_, "commit transaction;", nullptr, nullptr, nullptr);
+  if (rand() % 10 == 0) {
+    tryVacuum(db_);
+  }
+  return Status(0);
+}
+
 Status SQLiteDatabasePlugin::remove(const std::string& domain,
                                     const std::string& key) {
   if (read_only_) {
@@ -273,4 +306,29 @@ Status SQLiteDatabasePlugin::scan(const std::string& domain,
 
   return Status(0, "OK");
 }
+
+Status SQLiteDatabasePlugin::scanValues(const std::string& domain,
+                                        DatabaseStringValueList& results,
+                                        const std::string& prefix,
+                                        size_t max) const {
+  QueryData _results;
+  char* err = nullptr;
+
+  std::string q =
+      "select key, value from " + domain + " where key LIKE '" + prefix + "%'";
+  if (max > 0) {
+    q += " limit " + std::to_string(max);
+  }
+  sqlite3_exec(db_, q.c_str(), getData, &_results, &err);
+  if (err != nullptr) {
+    sqlite3_free(err);
+  }
+
+  for (auto& r : _results) {
+    results.push_back(
+        std::make_pair(std::move(r["key"]), std::move(r["value"])));
+  }
+
+  return Status(0, "OK");
+}
 }
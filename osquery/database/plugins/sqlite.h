@@ -39,6 +39,10 @@ class SQLiteDatabasePlugin : public DatabasePlugin {
              const std::string& key,
              int value) override;
 
+  /// Atomic multi-put method, wrapped in a single transaction.
+  Status putBatch(const std::string& domain,
+                  const DatabaseStringValueList& data) override;
+
   void dumpDatabase() const override;
 
   /// Data removal method.
@@ -55,6 +59,12 @@ class SQLiteDatabasePlugin : public DatabasePlugin {
               const std::string& prefix,
               size_t max) const override;
 
+  /// Key and value range read, a single SELECT.
+  Status scanValues(const std::string& domain,
+                    DatabaseStringValueList& results,
+                    const std::string& prefix,
+                    size_t max) const override;
+
  public:
   /// Database workflow: open and setup.
   Status setUp() override;
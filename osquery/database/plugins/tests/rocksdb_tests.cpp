@@ -55,4 +55,20 @@ TEST_F(RocksDBDatabasePluginTests, test_corruption) {
   resetDatabase();
   EXPECT_FALSE(pathExists(path_ + ".backup"));
 }
+
+TEST_F(RocksDBDatabasePluginTests, test_value_compression) {
+  // Large values in the queries domain are stored as zstd frames and must
+  // round-trip transparently through the database API.
+  std::string large(4096, 'x');
+  EXPECT_TRUE(setDatabaseValue(kQueries, "compress_large", large));
+
+  std::string value;
+  EXPECT_TRUE(getDatabaseValue(kQueries, "compress_large", value));
+  EXPECT_EQ(value, large);
+
+  // Small values are stored raw and remain readable.
+  EXPECT_TRUE(setDatabaseValue(kQueries, "compress_small", "bar"));
+  EXPECT_TRUE(getDatabaseValue(kQueries, "compress_small", value));
+  EXPECT_EQ(value, "bar");
+}
 }
@@ -129,6 +129,41 @@ TEST_F(DatabaseTests, test_scan_values) {
   EXPECT_EQ(keys.size(), 3U);
 }
 
+TEST_F(DatabaseTests, test_scan_chunked) {
+  setDatabaseValue(kLogs, "chunk.1", "0");
+  setDatabaseValue(kLogs, "chunk.2", "0");
+  setDatabaseValue(kLogs, "chunk.3", "0");
+
+  // A chunk size smaller than the key count streams multiple chunks.
+  std::vector<std::string> collected;
+  size_t chunks = 0;
+  auto s = scanDatabaseKeysChunked(
+      kLogs,
+      ([&collected, &chunks](const std::vector<std::string>& keys) {
+        collected.insert(collected.end(), keys.begin(), keys.end());
+        chunks++;
+        return true;
+      }),
+      "chunk.",
+      2);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(collected.size(), 3U);
+  EXPECT_GT(chunks, 1U);
+
+  // Returning false from the predicate stops the scan early.
+  collected.clear();
+  s = scanDatabaseKeysChunked(
+      kLogs,
+      ([&collected](const std::vector<std::string>& keys) {
+        collected.insert(collected.end(), keys.begin(), keys.end());
+        return false;
+      }),
+      "chunk.",
+      2);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(collected.size(), 2U);
+}
+
 TEST_F(DatabaseTests, test_delete_values_str) {
   setDatabaseValue(kLogs, "k", "0");
 
@@ -19,6 +19,7 @@
 namespace osquery {
 
 DECLARE_string(database_path);
+DECLARE_uint64(database_checkpoint_interval);
 
 class EphemeralDatabasePluginTests : public DatabasePluginTests {
  protected:
@@ -30,6 +31,30 @@ class EphemeralDatabasePluginTests : public DatabasePluginTests {
 // Define the default set of database plugin operation tests.
 CREATE_DATABASE_TESTS(EphemeralDatabasePluginTests);
 
+class SnapshotDatabasePluginTests : public DatabasePluginTests {
+ protected:
+  std::string name() override {
+    return "ephemeral_snapshot";
+  }
+};
+
+// Define the default set of database plugin operation tests.
+CREATE_DATABASE_TESTS(SnapshotDatabasePluginTests);
+
+TEST_F(SnapshotDatabasePluginTests, test_snapshot_restore) {
+  // Checkpoint on every write, then verify a reset restores the snapshot.
+  auto interval = FLAGS_database_checkpoint_interval;
+  FLAGS_database_checkpoint_interval = 0;
+  setDatabaseValue(kQueries, "snapshot_key", "snapshot_value");
+
+  resetDatabase();
+
+  std::string value;
+  EXPECT_TRUE(getDatabaseValue(kQueries, "snapshot_key", value));
+  EXPECT_EQ(value, "snapshot_value");
+  FLAGS_database_checkpoint_interval = interval;
+}
+
 void DatabasePluginTests::SetUp() {
   auto& rf = RegistryFactory::get();
   existing_plugin_ = rf.getActive("database");
@@ -102,6 +127,28 @@ void DatabasePluginTests::testPut() {
   reset.get();
 }
 
+void DatabasePluginTests::testPutBatch() {
+  DatabaseStringValueList data = {
+      {"test_batch_one", "1"}, {"test_batch_two", "2"}};
+  auto s = getPlugin()->putBatch(kQueries, data);
+  EXPECT_TRUE(s.ok());
+
+  // Every pair within the batch was committed.
+  std::string value;
+  EXPECT_TRUE(getPlugin()->get(kQueries, "test_batch_one", value).ok());
+  EXPECT_EQ(value, "1");
+  EXPECT_TRUE(getPlugin()->get(kQueries, "test_batch_two", value).ok());
+  EXPECT_EQ(value, "2");
+
+  s = setDatabaseBatchValues(kQueries, {{"test_batch_one", "3"}});
+  EXPECT_TRUE(s.ok());
+  EXPECT_TRUE(getPlugin()->get(kQueries, "test_batch_one", value).ok());
+  EXPECT_EQ(value, "3");
+
+  auto reset = std::async(std::launch::async, kTestReseter);
+  reset.get();
+}
+
 void DatabasePluginTests::testGet() {
   getPlugin()->put(kQueries, "test_get", "bar");
 
@@ -191,4 +238,25 @@ void DatabasePluginTests::testScanLimit() {
   EXPECT_EQ(s.getMessage(), "OK");
   EXPECT_EQ(keys.size(), 2U);
 }
+
+void DatabasePluginTests::testScanValues() {
+  getPlugin()->put(kQueries, "test_scan_foo1", "baz1");
+  getPlugin()->put(kQueries, "test_scan_foo2", "baz2");
+  getPlugin()->put(kQueries, "test_scan_foo3", "baz3");
+
+  // Each key is returned with its value, in a single range read.
+  DatabaseStringValueList items;
+  auto s = getPlugin()->scanValues(kQueries, items, "test_scan_", 0);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(items.size(), 3U);
+  for (const auto& item : items) {
+    EXPECT_EQ(item.second, "baz" + item.first.substr(item.first.size() - 1));
+  }
+
+  // The max argument bounds the number of returned pairs.
+  items.clear();
+  s = getPlugin()->scanValues(kQueries, items, "test_scan_", 2);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(items.size(), 2U);
+}
 }
@@ -27,6 +27,9 @@
   TEST_F(n, test_put) {                                                        \
     testPut();                                                                 \
   }                                                                            \
+  TEST_F(n, test_put_batch) {                                                  \
+    testPutBatch();                                                            \
+  }                                                                            \
   TEST_F(n, test_get) {                                                        \
     testGet();                                                                 \
   }                                                                            \
@@ -41,6 +44,9 @@
   }                                                                            \
   TEST_F(n, test_scan_limit) {                                                 \
     testScanLimit();                                                           \
+  }                                                                            \
+  TEST_F(n, test_scan_values) {                                                \
+    testScanValues();                                                          \
   }
 
 namespace osquery {
@@ -86,10 +92,12 @@ class DatabasePluginTests : public testing::Test {
   void testPluginCheck();
   void testReset();
   void testPut();
+  void testPutBatch();
   void testGet();
   void testDelete();
   void testDeleteRange();
   void testScan();
   void testScanLimit();
+  void testScanValues();
 };
 }
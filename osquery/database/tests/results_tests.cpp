@@ -137,6 +137,79 @@ TEST_F(ResultsTests, test_serialize_query_log_item_json) {
   EXPECT_EQ(results.first, json);
 }
 
+TEST_F(ResultsTests, test_serialize_query_log_item_unchanged) {
+  QueryLogItem item;
+  item.name = "inventory";
+  item.identifier = "zspam";
+  item.time = 10;
+  item.calendar_time = "now now";
+  item.epoch = 0;
+  item.unchanged = true;
+
+  auto doc = JSON::newObject();
+  auto s = serializeQueryLogItem(item, doc);
+  EXPECT_TRUE(s.ok());
+
+  // The marker replaces the snapshot rows entirely.
+  EXPECT_FALSE(doc.doc().HasMember("snapshot"));
+  ASSERT_TRUE(doc.doc().HasMember("unchanged"));
+  EXPECT_TRUE(doc.doc()["unchanged"].GetBool());
+  ASSERT_TRUE(doc.doc().HasMember("action"));
+  EXPECT_STREQ(doc.doc()["action"].GetString(), "snapshot");
+
+  std::string json;
+  EXPECT_TRUE(doc.toString(json).ok());
+  QueryLogItem output;
+  s = deserializeQueryLogItemJSON(json, output);
+  EXPECT_TRUE(s.ok());
+  EXPECT_TRUE(output.unchanged);
+  EXPECT_TRUE(output.snapshot_results.empty());
+}
+
+TEST_F(ResultsTests, test_serialize_query_log_item_as_events_json) {
+  QueryLogItem item;
+  item.name = "events";
+  item.identifier = "zspam";
+  item.time = 10;
+  item.calendar_time = "now now";
+  item.epoch = 1;
+  item.counter = 2;
+  item.decorations["purple"] = "rain";
+  item.results.added.push_back({{"test_column", "test_value"}});
+  item.results.removed.push_back({{"test_column", "old_value"}});
+
+  std::vector<std::string> items;
+  auto s = serializeQueryLogItemAsEventsJSON(item, items);
+  EXPECT_TRUE(s.ok());
+  ASSERT_EQ(items.size(), 2U);
+
+  // Each framed line carries the shared envelope alongside the per-event
+  // columns and action ("removed" is serialized first by contract).
+  for (const auto& json : items) {
+    auto doc = JSON::newObject();
+    ASSERT_TRUE(doc.fromString(json).ok());
+    EXPECT_STREQ(doc.doc()["name"].GetString(), "events");
+    EXPECT_STREQ(doc.doc()["hostIdentifier"].GetString(), "zspam");
+    EXPECT_STREQ(doc.doc()["calendarTime"].GetString(), "now now");
+    EXPECT_EQ(doc.doc()["unixTime"].GetUint64(), 10U);
+    EXPECT_STREQ(doc.doc()["decorations"]["purple"].GetString(), "rain");
+    ASSERT_TRUE(doc.doc().HasMember("columns"));
+    ASSERT_TRUE(doc.doc().HasMember("action"));
+  }
+
+  auto removed = JSON::newObject();
+  ASSERT_TRUE(removed.fromString(items[0]).ok());
+  EXPECT_STREQ(removed.doc()["action"].GetString(), "removed");
+  EXPECT_STREQ(removed.doc()["columns"]["test_column"].GetString(),
+               "old_value");
+
+  auto added = JSON::newObject();
+  ASSERT_TRUE(added.fromString(items[1]).ok());
+  EXPECT_STREQ(added.doc()["action"].GetString(), "added");
+  EXPECT_STREQ(added.doc()["columns"]["test_column"].GetString(),
+               "test_value");
+}
+
 TEST_F(ResultsTests, test_deserialize_query_log_item_json) {
   auto results = getSerializedQueryLogItemJSON();
 
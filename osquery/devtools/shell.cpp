@@ -13,8 +13,14 @@
 ** utility for accessing SQLite databases.
 */
 
+#include <atomic>
+#include <chrono>
 #include <csignal>
 #include <cstdio>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <thread>
 
 #ifdef WIN32
 
@@ -36,8 +42,13 @@
 #include <osquery/filesystem.h>
 #include <osquery/flags.h>
 #include <osquery/packs.h>
+#include <osquery/query.h>
 #include <osquery/registry_factory.h>
+#include <osquery/sql.h>
+#include <osquery/tables.h>
 
+#include "osquery/core/conversions.h"
+#include "osquery/core/json.h"
 #include "osquery/core/process.h"
 #include "osquery/devtools/devtools.h"
 #include "osquery/filesystem/fileops.h"
@@ -61,6 +72,12 @@ SHELL_FLAG(bool, list, false, "Set output mode to 'list'");
 SHELL_FLAG(string, separator, "|", "Set output field separator, default '|'");
 SHELL_FLAG(bool, header, true, "Toggle column headers true/false");
 SHELL_FLAG(string, pack, "", "Run all queries in a pack");
+SHELL_FLAG(string,
+           batch,
+           "",
+           "Execute a file of queries (one per line, '-' reads stdin) "
+           "concurrently and emit one JSON result frame per line");
+SHELL_FLAG(uint64, batch_workers, 4, "Concurrent queries executed by --batch");
 
 /// Define short-hand shell switches.
 SHELL_FLAG(bool, L, false, "List all table names");
@@ -98,6 +115,7 @@ static char zHelp[] =
     "                   pretty   Pretty printed SQL results (default)\n"
     ".nullvalue STR   Use STRING in place of NULL values\n"
     ".print STR...    Print literal STRING\n"
+    ".profile ON|OFF  Print a per-stage (generate/sqlite/render) breakdown\n"
     ".quit            Exit this program\n"
     ".schema [TABLE]  Show the CREATE statements\n"
     ".separator STR   Change separator used by output mode\n"
@@ -105,6 +123,7 @@ static char zHelp[] =
     ".show            Show the current values for various settings\n"
     ".summary         Alias for the show meta command\n"
     ".tables [TABLE]  List names of tables\n"
+    ".watch [N] SQL   Re-run SQL every N seconds, printing differentials\n"
     ".width [NUM1]+   Set column widths for \"column\" mode\n";
 
 static char zTimerHelp[] =
@@ -223,6 +242,74 @@ static void endTimer() {
 #define END_TIMER endTimer()
 #define HAS_TIMER 1
 
+// True if the per-stage profile breakdown is enabled
+static int enableProfile = 0;
+
+// Wall-clock time spent rendering result rows, in milliseconds.
+static sqlite3_int64 iRenderTime = 0;
+
+// Wall-clock time at the start of the profiled statement.
+static sqlite3_int64 iProfileBegin = 0;
+
+// Per-table generation counters at the start of the profiled statement.
+static std::map<std::string, osquery::TableGenerateStats> profileBaseline;
+
+static void beginProfile() {
+  if (enableProfile != 0) {
+    profileBaseline = osquery::getTableGenerateStats();
+    iRenderTime = 0;
+    iProfileBegin = timeOfDay();
+  }
+}
+
+/*
+** End the profile and print the per-stage breakdown. Table generation is
+** read from the process-wide generate statistics (the counters backing the
+** osquery_table_stats table) as a delta over the statement; render time is
+** accumulated around the row callback; the remainder of the wall clock is
+** attributed to SQLite itself (parse, plan, step, and sort).
+*/
+static void endProfile() {
+  if (enableProfile == 0) {
+    return;
+  }
+  double total = (timeOfDay() - iProfileBegin) * 0.001;
+
+  double generate = 0.0;
+  for (const auto& table : osquery::getTableGenerateStats()) {
+    auto stats = table.second;
+    auto baseline = profileBaseline.find(table.first);
+    if (baseline != profileBaseline.end()) {
+      stats.calls -= baseline->second.calls;
+      stats.wall_time -= baseline->second.wall_time;
+      stats.cpu_time -= baseline->second.cpu_time;
+      stats.rows -= baseline->second.rows;
+    }
+    if (stats.calls == 0) {
+      /* The table was not generated by this statement. */
+      continue;
+    }
+    printf("Profile: generate %s: %zu call(s) %llu row(s) real %.3f cpu %f\n",
+           table.first.c_str(),
+           stats.calls,
+           (unsigned long long)stats.rows,
+           stats.wall_time * 0.000001,
+           stats.cpu_time * 0.000001);
+    generate += stats.wall_time * 0.000001;
+  }
+
+  double render = iRenderTime * 0.001;
+  double sql = total - generate - render;
+  if (sql < 0.0) {
+    /* Clock skew between the sources; clamp rather than print nonsense. */
+    sql = 0.0;
+  }
+  printf("Profile: sqlite %.3f render %.3f total %.3f\n", sql, render, total);
+}
+
+#define BEGIN_PROFILE beginProfile()
+#define END_PROFILE endProfile()
+
 // If the following flag is set, then command execution stops
 // at an error if we are not interactive.
 static int bail_on_error = 0;
@@ -348,8 +435,14 @@ struct prettyprint_data {
   osquery::QueryData results;
   std::vector<std::string> columns;
   std::map<std::string, size_t> lengths;
+
+  /// Set once the sampled column widths are locked and the header streamed.
+  bool streaming{false};
 };
 
+/* Rows sampled to size columns before streaming the remainder of a result. */
+static const size_t kPrettySampleRows = 256;
+
 /*
 ** An pointer to an instance of this structure is passed from
 ** the main program to the callback.  This is used to communicate
@@ -514,6 +607,11 @@ static int shell_callback(
   int i;
   auto* p = reinterpret_cast<struct callback_data*>(pArg);
 
+  if (seenInterrupt != 0) {
+    /* A nonzero return aborts the statement, cancelling the table scan. */
+    return 1;
+  }
+
   switch (p->mode) {
   case MODE_Pretty: {
     if (p->prettyPrint->columns.empty()) {
@@ -530,8 +628,44 @@ static int shell_callback(
                                        : std::string(azArg[i]);
       }
     }
+
+    if (p->prettyPrint->streaming) {
+      /* The widths were locked at the sample, print the row immediately. */
+      printf("%s",
+             osquery::generateRow(
+                 r, p->prettyPrint->lengths, p->prettyPrint->columns)
+                 .c_str());
+      break;
+    }
+
     osquery::computeRowLengths(r, p->prettyPrint->lengths);
     p->prettyPrint->results.push_back(r);
+
+    if (!osquery::FLAGS_json &&
+        p->prettyPrint->results.size() >= kPrettySampleRows) {
+      /* Enough rows were sampled to size the columns. Print the header and
+      ** the sample, then stream the remaining rows as they arrive instead
+      ** of buffering the complete result set. */
+      osquery::computeRowLengths(
+          p->prettyPrint->results.front(), p->prettyPrint->lengths, true);
+      auto separator = osquery::generateToken(p->prettyPrint->lengths,
+                                              p->prettyPrint->columns);
+      printf("%s",
+             (separator +
+              osquery::generateHeader(p->prettyPrint->lengths,
+                                      p->prettyPrint->columns) +
+              separator)
+                 .c_str());
+      for (const auto& row : p->prettyPrint->results) {
+        printf("%s",
+               osquery::generateRow(
+                   row, p->prettyPrint->lengths, p->prettyPrint->columns)
+                   .c_str());
+      }
+      fflush(stdout);
+      p->prettyPrint->results.clear();
+      p->prettyPrint->streaming = true;
+    }
     break;
   }
   case MODE_Line: {
@@ -867,7 +1001,13 @@ static int shell_exec(
               /* if data and types extracted successfully... */
               if (SQLITE_ROW == rc) {
                 /* call the supplied callback with the result row data */
-                if (xCallback(pArg, nCol, azVals, azCols, aiTypes) != 0) {
+                sqlite3_int64 iRenderBegin =
+                    (enableProfile != 0) ? timeOfDay() : 0;
+                int cbrc = xCallback(pArg, nCol, azVals, azCols, aiTypes);
+                if (enableProfile != 0) {
+                  iRenderTime += timeOfDay() - iRenderBegin;
+                }
+                if (cbrc != 0) {
                   rc = SQLITE_ABORT;
                 } else {
                   rc = sqlite3_step(pStmt);
@@ -908,8 +1048,15 @@ static int shell_exec(
   dbc->clearAffectedTables();
 
   if ((pArg != nullptr) && pArg->mode == MODE_Pretty) {
+    sqlite3_int64 iRenderBegin = (enableProfile != 0) ? timeOfDay() : 0;
     if (osquery::FLAGS_json) {
       osquery::jsonPrint(pArg->prettyPrint->results);
+    } else if (pArg->prettyPrint->streaming) {
+      /* Close the streamed table with a trailing separator. */
+      printf("%s",
+             osquery::generateToken(pArg->prettyPrint->lengths,
+                                    pArg->prettyPrint->columns)
+                 .c_str());
     } else {
       osquery::prettyPrint(pArg->prettyPrint->results,
                            pArg->prettyPrint->columns,
@@ -918,6 +1065,10 @@ static int shell_exec(
     pArg->prettyPrint->results.clear();
     pArg->prettyPrint->columns.clear();
     pArg->prettyPrint->lengths.clear();
+    pArg->prettyPrint->streaming = false;
+    if (enableProfile != 0) {
+      iRenderTime += timeOfDay() - iRenderBegin;
+    }
   }
 
   return rc;
@@ -1088,6 +1239,77 @@ inline void meta_schema(int nArg, char** azArg) {
   }
 }
 
+/* Collect rows for the watch meta command differential. */
+static int watch_collect_callback(void* pArg,
+                                  int nArg,
+                                  char** azArg,
+                                  char** azCol) {
+  if (seenInterrupt != 0) {
+    return 1;
+  }
+
+  auto* results = reinterpret_cast<osquery::QueryData*>(pArg);
+  osquery::Row r;
+  for (int i = 0; i < nArg; i++) {
+    if (azCol[i] != nullptr) {
+      r[std::string(azCol[i])] = (azArg[i] == nullptr)
+                                     ? osquery::FLAGS_nullvalue
+                                     : std::string(azArg[i]);
+    }
+  }
+  results->push_back(std::move(r));
+  return 0;
+}
+
+/*
+** Re-run a query on an interval until interrupted, printing only the
+** differential: rows added since the previous run with a '+' prefix and
+** rows removed with a '-' prefix. The first run prints the full result.
+*/
+inline int meta_watch(sqlite3* db, int interval, const std::string& query) {
+  osquery::QueryDataSet previous;
+  while (seenInterrupt == 0) {
+    osquery::QueryData current;
+    char* zErrMsg = nullptr;
+    auto rc = sqlite3_exec(
+        db, query.c_str(), watch_collect_callback, &current, &zErrMsg);
+    if (rc == SQLITE_ABORT) {
+      /* Interrupted mid-scan, drop the partial run. */
+      break;
+    } else if (rc != SQLITE_OK) {
+      if (zErrMsg != nullptr) {
+        fprintf(stderr, "Error: %s\n", zErrMsg);
+        sqlite3_free(zErrMsg);
+      }
+      return rc;
+    }
+
+    auto diff_results = osquery::diff(previous, current);
+    for (const auto& row : diff_results.removed) {
+      std::string row_string;
+      if (osquery::serializeRowJSON(row, row_string).ok()) {
+        printf("- %s\n", row_string.c_str());
+      }
+    }
+    for (const auto& row : diff_results.added) {
+      std::string row_string;
+      if (osquery::serializeRowJSON(row, row_string).ok()) {
+        printf("+ %s\n", row_string.c_str());
+      }
+    }
+    fflush(stdout);
+
+    previous = osquery::QueryDataSet(current.begin(), current.end());
+
+    /* Sleep in small slices so an interrupt ends the watch promptly. */
+    for (int slept = 0; slept < interval * 10 && seenInterrupt == 0; slept++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+  }
+  seenInterrupt = 0;
+  return 0;
+}
+
 inline void meta_features(struct callback_data* p) {
   auto results = osquery::SQL(
       "select * from osquery_flags where (name like 'disable_%' or name like "
@@ -1332,6 +1554,9 @@ static int do_meta_command(char* zLine, struct callback_data* p) {
                      "%.*s",
                      ArraySize(p->nullvalue) - 1,
                      azArg[1]);
+  } else if (c == 'p' && n >= 4 && strncmp(azArg[0], "profile", n) == 0 &&
+             nArg == 2) {
+    enableProfile = booleanValue(azArg[1]);
   } else if (c == 'p' && n >= 3 && strncmp(azArg[0], "print", n) == 0) {
     int j;
     for (j = 1; j < nArg; j++) {
@@ -1369,6 +1594,30 @@ static int do_meta_command(char* zLine, struct callback_data* p) {
     enableTimer = booleanValue(azArg[1]);
   } else if (c == 'v' && strncmp(azArg[0], "version", n) == 0) {
     meta_version(p);
+  } else if (c == 'w' && n > 2 && strncmp(azArg[0], "watch", n) == 0 &&
+             nArg >= 2) {
+    int idx = 1;
+    int interval = 2;
+    if (IsDigit(azArg[1][0])) {
+      interval = static_cast<int>(integerValue(azArg[1]));
+      interval = (interval > 0) ? interval : 1;
+      idx = 2;
+    }
+
+    std::string query;
+    for (int j = idx; j < nArg; j++) {
+      if (!query.empty()) {
+        query += ' ';
+      }
+      query += azArg[j];
+    }
+
+    if (query.empty()) {
+      fprintf(stderr, "Usage: .watch [SECONDS] QUERY\n");
+      rc = 1;
+    } else {
+      rc = meta_watch(db, interval, query);
+    }
   } else if (c == 'w' && strncmp(azArg[0], "width", n) == 0 && nArg > 1) {
     int j;
     assert(nArg <= ArraySize(azArg));
@@ -1541,7 +1790,9 @@ static int process_input(struct callback_data* p, FILE* in) {
         (sqlite3_complete(zSql) != 0)) {
       p->cnt = 0;
       BEGIN_TIMER;
+      BEGIN_PROFILE;
       rc = shell_exec(zSql, shell_callback, p, &zErrMsg);
+      END_PROFILE;
       END_TIMER;
       if ((rc != 0) || zErrMsg != nullptr) {
         char zPrefix[100] = {0};
@@ -1636,6 +1887,93 @@ int runQuery(struct callback_data* data, const char* query) {
   return rc;
 }
 
+int runBatch(const std::string& source) {
+  // Read the query list: one query per line, blanks and #-comments skipped.
+  std::string content;
+  if (source == "-") {
+    std::string line;
+    while (std::getline(std::cin, line)) {
+      content += line;
+      content += '\n';
+    }
+  } else {
+    auto status = readFile(source, content);
+    if (!status.ok()) {
+      fprintf(stderr,
+              "Error reading batch query list %s: %s\n",
+              source.c_str(),
+              status.what().c_str());
+      return 1;
+    }
+  }
+
+  std::vector<std::string> queries;
+  for (const auto& line : osquery::split(content, "\n")) {
+    if (!line.empty() && line[0] != '#') {
+      queries.push_back(line);
+    }
+  }
+  if (queries.empty()) {
+    return 0;
+  }
+
+  // Workers claim the next query and run it over their own pooled SQLite
+  // instance; independent queries execute concurrently in this process.
+  std::vector<std::string> frames(queries.size());
+  std::unique_ptr<std::atomic<bool>[]> finished(
+      new std::atomic<bool>[queries.size()]);
+  for (size_t i = 0; i < queries.size(); i++) {
+    finished[i] = false;
+  }
+
+  std::atomic<size_t> next(0);
+  int rc = 0;
+  auto worker = [&queries, &frames, &finished, &next, &rc]() {
+    while (true) {
+      auto i = next.fetch_add(1);
+      if (i >= queries.size()) {
+        break;
+      }
+
+      SQL sql(queries[i]);
+      auto doc = JSON::newObject();
+      doc.add("index", i);
+      doc.addCopy("query", queries[i]);
+      doc.add("status", sql.getStatus().getCode());
+      doc.addCopy("message", sql.getStatus().getMessage());
+      auto rows = doc.getArray();
+      serializeQueryData(sql.rows(), ColumnNames(), doc, rows);
+      doc.add("rows", rows);
+      doc.toString(frames[i]);
+      if (!sql.getStatus().ok()) {
+        rc = 1;
+      }
+      finished[i] = true;
+    }
+  };
+
+  std::vector<std::thread> pool;
+  auto workers = std::max<size_t>(FLAGS_batch_workers, 1);
+  for (size_t i = 0; i < std::min(workers, queries.size()); i++) {
+    pool.push_back(std::thread(worker));
+  }
+
+  // Stream each frame in input order as soon as its query completes.
+  for (size_t i = 0; i < queries.size(); i++) {
+    while (!finished[i]) {
+      sleepFor(10);
+    }
+    fprintf(stdout, "%s\n", frames[i].c_str());
+    fflush(stdout);
+    std::string().swap(frames[i]);
+  }
+
+  for (auto& thread : pool) {
+    thread.join();
+  }
+  return rc;
+}
+
 int runPack(struct callback_data* data) {
   int rc = 0;
 
@@ -1696,7 +2034,10 @@ int launchIntoShell(int argc, char** argv) {
       sizeof(data.nullvalue), data.nullvalue, "%s", FLAGS_nullvalue.c_str());
 
   int rc = 0;
-  if (FLAGS_L || !FLAGS_A.empty()) {
+  if (!FLAGS_batch.empty()) {
+    // Batch runbook mode: concurrent queries, framed JSON on stdout.
+    rc = runBatch(FLAGS_batch);
+  } else if (FLAGS_L || !FLAGS_A.empty()) {
     // Helper meta commands from shell switches.
     std::string query = (FLAGS_L) ? ".tables" : ".all " + FLAGS_A;
     auto* cmd = new char[query.size() + 1];
@@ -0,0 +1,174 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <osquery/config.h>
+#include <osquery/database.h>
+#include <osquery/query.h>
+#include <osquery/registry.h>
+#include <osquery/tables.h>
+
+#include "osquery/dispatcher/scheduler.h"
+#include "osquery/sql/sqlite_util.h"
+
+namespace osquery {
+
+/// Synthetic result shape, set by each benchmark before querying.
+static size_t kBenchmarkRows{0};
+static size_t kBenchmarkColumns{0};
+
+/**
+ * @brief A table plugin producing a parameterized synthetic result set.
+ *
+ * The scheduled-query benchmarks vary the row count and width through the
+ * statics above so a single registered table can model small frequent
+ * queries and wide inventory-style queries alike.
+ */
+class BenchmarkScheduledTablePlugin : public TablePlugin {
+ protected:
+  TableColumns columns() const override {
+    TableColumns cols;
+    for (size_t i = 0; i < 16; i++) {
+      cols.push_back(std::make_tuple(
+          "col" + std::to_string(i), TEXT_TYPE, ColumnOptions::DEFAULT));
+    }
+    return cols;
+  }
+
+  QueryData generate(QueryContext& ctx) override {
+    Row r;
+    for (size_t c = 0; c < kBenchmarkColumns; c++) {
+      r["col" + std::to_string(c)] = std::to_string(c) + "content";
+    }
+
+    QueryData results;
+    for (size_t i = 0; i < kBenchmarkRows; i++) {
+      results.push_back(r);
+    }
+    return results;
+  }
+};
+
+/// Register the synthetic table once; benchmarks share the registry.
+static void registerBenchmarkTable() {
+  static bool registered = false;
+  if (!registered) {
+    auto tables = RegistryFactory::get().registry("table");
+    tables->add("benchmark_schedule",
+                std::make_shared<BenchmarkScheduledTablePlugin>());
+    registered = true;
+  }
+}
+
+static ScheduledQuery getBenchmarkQuery() {
+  ScheduledQuery query;
+  query.interval = 10;
+  query.splayed_interval = 10;
+  query.query = "SELECT * FROM benchmark_schedule";
+  return query;
+}
+
+static void SCHEDULER_monitor(benchmark::State& state) {
+  registerBenchmarkTable();
+  kBenchmarkRows = state.range(0);
+  kBenchmarkColumns = state.range(1);
+  auto query = getBenchmarkQuery();
+
+  size_t rows = 0;
+  while (state.KeepRunning()) {
+    // The monitor wrapper snapshots process state around the execution and
+    // records performance statistics, as the scheduler does for every query.
+    auto sql = monitor("benchmark_monitor", query);
+    rows += sql.rows().size();
+  }
+  state.counters["rows"] = rows;
+}
+
+BENCHMARK(SCHEDULER_monitor)->ArgPair(10, 2)->ArgPair(100, 8);
+
+static void SCHEDULER_query_pipeline(benchmark::State& state) {
+  registerBenchmarkTable();
+  kBenchmarkRows = state.range(0);
+  kBenchmarkColumns = state.range(1);
+  auto query = getBenchmarkQuery();
+
+  size_t rows = 0;
+  size_t bytes = 0;
+  while (state.KeepRunning()) {
+    // Mirror launchQuery: execute, differentiate against the stored results,
+    // and serialize the log item, skipping only the logger transport.
+    SQLInternal sql(query.query, true);
+    rows += sql.rows().size();
+    sql.escapeResults();
+
+    QueryLogItem item;
+    item.name = "benchmark_pipeline";
+    auto dbQuery = Query(item.name, query);
+    dbQuery.addNewResults(
+        std::move(sql.rows()), item.epoch, item.counter, item.results);
+
+    std::string serialized;
+    serializeQueryLogItemJSON(item, serialized);
+    bytes += serialized.size();
+  }
+  state.counters["rows"] = rows;
+  state.SetBytesProcessed(bytes);
+
+  // Drop the stored differential state so runs do not affect each other.
+  deleteDatabaseValue(kQueries, "benchmark_pipeline");
+  deleteDatabaseValue(kQueries, "benchmark_pipelineepoch");
+  deleteDatabaseValue(kQueries, "benchmark_pipelinecounter");
+  deleteDatabaseValue(kQueries, "benchmark_pipelinehashes");
+  clearQueryRowHashCache("benchmark_pipeline");
+}
+
+BENCHMARK(SCHEDULER_query_pipeline)
+    ->ArgPair(10, 2)
+    ->ArgPair(100, 8)
+    ->ArgPair(1000, 16);
+
+static void SCHEDULER_query_pipeline_unchanged(benchmark::State& state) {
+  registerBenchmarkTable();
+  kBenchmarkRows = state.range(0);
+  kBenchmarkColumns = state.range(1);
+  auto query = getBenchmarkQuery();
+
+  // Seed the stored results so every iteration takes the no-change path,
+  // the common case for a converged schedule.
+  {
+    SQLInternal sql(query.query, true);
+    sql.escapeResults();
+    DiffResults dr;
+    uint64_t counter = 0;
+    Query("benchmark_unchanged", query)
+        .addNewResults(std::move(sql.rows()), 0, counter, dr);
+  }
+
+  while (state.KeepRunning()) {
+    SQLInternal sql(query.query, true);
+    sql.escapeResults();
+    DiffResults dr;
+    uint64_t counter = 0;
+    Query("benchmark_unchanged", query)
+        .addNewResults(std::move(sql.rows()), 0, counter, dr);
+  }
+
+  deleteDatabaseValue(kQueries, "benchmark_unchanged");
+  deleteDatabaseValue(kQueries, "benchmark_unchangedepoch");
+  deleteDatabaseValue(kQueries, "benchmark_unchangedcounter");
+  deleteDatabaseValue(kQueries, "benchmark_unchangedhashes");
+  clearQueryRowHashCache("benchmark_unchanged");
+}
+
+BENCHMARK(SCHEDULER_query_pipeline_unchanged)
+    ->ArgPair(100, 8)
+    ->ArgPair(1000, 16);
+}
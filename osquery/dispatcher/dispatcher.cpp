@@ -90,6 +90,69 @@ Status Dispatcher::addService(InternalRunnableRef service) {
   return Status(0, "OK");
 }
 
+Status Dispatcher::addTask(InternalRunnableRef task) {
+  if (task->hasRun()) {
+    return Status(1, "Cannot schedule a task twice");
+  }
+
+  auto& self = instance();
+  if (self.stopping_) {
+    // Cannot add a task while the dispatcher is stopping and no joins
+    // have been requested.
+    return Status(1, "Cannot add task, dispatcher is stopping");
+  }
+
+  DLOG(INFO) << "Adding new task: " << task->name() << " (" << task.get()
+             << ") to the worker pool in process " << platformGetPid();
+  {
+    WriteLock lock(self.mutex_);
+    if (!self.pool_started_) {
+      // The pool is created on first use and joined during a stop-join.
+      auto pool_size = (FLAGS_worker_threads > 0) ? FLAGS_worker_threads : 1;
+      for (int32_t i = 0; i < pool_size; i++) {
+        self.pool_threads_.push_back(
+            std::make_shared<std::thread>(&Dispatcher::poolWorker));
+      }
+      self.pool_started_ = true;
+    }
+
+    // Tasks join the service list so stopServices interrupts them too.
+    self.services_.push_back(task);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(self.task_lock_);
+    self.task_queue_.push_back(std::move(task));
+  }
+  self.task_condition_.notify_one();
+
+  return Status(0, "OK");
+}
+
+void Dispatcher::poolWorker() {
+  auto& self = instance();
+  while (true) {
+    InternalRunnableRef task = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(self.task_lock_);
+      self.task_condition_.wait(lock, [&self]() {
+        return self.stopping_ || !self.task_queue_.empty();
+      });
+
+      if (self.stopping_) {
+        return;
+      }
+
+      task = std::move(self.task_queue_.front());
+      self.task_queue_.erase(self.task_queue_.begin());
+    }
+
+    // Runs the task's start() and removes it from the service list when it
+    // completes, exactly as a dedicated service thread would.
+    task->run();
+  }
+}
+
 void Dispatcher::removeService(const InternalRunnable* service) {
   auto& self = Dispatcher::instance();
   WriteLock lock(self.mutex_);
@@ -142,6 +205,22 @@ void Dispatcher::joinServices() {
     }
   }
 
+  // Join the worker pool when a stop was requested; an unsignaled join (as
+  // used by the tests) leaves the idle pool running.
+  if (self.stopping_) {
+    std::vector<InternalThreadRef> pool_threads;
+    {
+      WriteLock lock(self.mutex_);
+      pool_threads.swap(self.pool_threads_);
+      self.pool_started_ = false;
+    }
+
+    for (const auto& thread : pool_threads) {
+      thread->join();
+      DLOG(INFO) << "Pool thread: " << thread.get() << " has joined";
+    }
+  }
+
   self.stopping_ = false;
   DLOG(INFO) << "Services and threads have been cleared";
 }
@@ -150,9 +229,25 @@ void Dispatcher::stopServices() {
   auto& self = instance();
   self.stopping_ = true;
 
+  // Tasks that never reached a pool worker cannot observe an interruption;
+  // drop them before interrupting the running services below.
+  std::vector<InternalRunnableRef> dropped_tasks;
+  {
+    std::unique_lock<std::mutex> lock(self.task_lock_);
+    dropped_tasks.swap(self.task_queue_);
+  }
+  self.task_condition_.notify_all();
+
   WriteLock lock(self.mutex_);
   DLOG(INFO) << "Thread: " << std::this_thread::get_id()
              << " requesting a stop";
+  for (const auto& task : dropped_tasks) {
+    self.services_.erase(
+        std::remove(self.services_.begin(), self.services_.end(), task),
+        self.services_.end());
+    DLOG(INFO) << "Task: " << task.get() << " was dropped before running";
+  }
+
   for (const auto& service : self.services_) {
     assureRun(service);
     service->interrupt();
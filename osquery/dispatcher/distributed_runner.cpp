@@ -28,31 +28,44 @@ DECLARE_string(distributed_plugin);
 
 const size_t kDistributedAccelerationInterval = 5;
 
-void DistributedRunner::start() {
-  auto dist = Distributed();
-  while (!interrupted()) {
-    dist.pullUpdates();
-    if (dist.getPendingQueryCount() > 0) {
-      dist.runQueries();
-    }
-
-    std::string str_acu = "0";
-    Status database = getDatabaseValue(
-        kPersistentSettings, "distributed_accelerate_checkins_expire", str_acu);
-    unsigned long accelerate_checkins_expire;
-    Status conversion = safeStrtoul(str_acu, 10, accelerate_checkins_expire);
-    if (!database.ok() || !conversion.ok() ||
-        getUnixTime() > accelerate_checkins_expire) {
-      pauseMilli(FLAGS_distributed_interval * 1000);
-    } else {
-      pauseMilli(kDistributedAccelerationInterval * 1000);
-    }
+DistributedPoller::DistributedPoller() : timer_(IOService::get()) {}
+
+void DistributedPoller::schedule(size_t interval) {
+  timer_.expires_from_now(
+      boost::posix_time::seconds(static_cast<long>(interval)));
+  timer_.async_wait(std::bind(
+      &DistributedPoller::poll, shared_from_this(), std::placeholders::_1));
+}
+
+void DistributedPoller::poll(const boost::system::error_code& ec) {
+  if (ec) {
+    // The timer was cancelled; the io_service is shutting down.
+    return;
+  }
+
+  distributed_.pullUpdates();
+  if (distributed_.getPendingQueryCount() > 0) {
+    distributed_.runQueries();
+  }
+
+  std::string str_acu = "0";
+  Status database = getDatabaseValue(
+      kPersistentSettings, "distributed_accelerate_checkins_expire", str_acu);
+  unsigned long accelerate_checkins_expire;
+  Status conversion = safeStrtoul(str_acu, 10, accelerate_checkins_expire);
+  if (!database.ok() || !conversion.ok() ||
+      getUnixTime() > accelerate_checkins_expire) {
+    schedule(FLAGS_distributed_interval);
+  } else {
+    schedule(kDistributedAccelerationInterval);
   }
 }
 
 Status startDistributed() {
   if (!FLAGS_disable_distributed) {
-    Dispatcher::addService(std::make_shared<DistributedRunner>());
+    // The first poll fires as soon as the io_service threads run.
+    auto poller = std::make_shared<DistributedPoller>();
+    poller->schedule(0);
     return Status(0, "OK");
   } else {
     return Status(1, "Distributed query service not enabled.");
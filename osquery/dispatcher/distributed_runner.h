@@ -10,19 +10,41 @@
 
 #pragma once
 
+#include <memory>
+
 #include <osquery/dispatcher.h>
+#include <osquery/distributed.h>
+
+#include "osquery/dispatcher/io_service.h"
 
 namespace osquery {
 
-/// A Dispatcher service thread that implements the distributed query service
-class DistributedRunner : public InternalRunnable {
+/**
+ * @brief The distributed query service as a shared io_service task.
+ *
+ * Instead of a dedicated service thread that sleeps between polls, the poll
+ * is a deadline timer on the shared io_service that re-arms itself after
+ * each pull. The distributed service then occupies an I/O thread only while
+ * it is actually working, and shuts down with the io_service.
+ */
+class DistributedPoller
+    : public std::enable_shared_from_this<DistributedPoller> {
  public:
-  virtual ~DistributedRunner() {}
-  DistributedRunner() : InternalRunnable("DistributedRunner") {}
+  DistributedPoller();
 
- public:
-  /// The Dispatcher thread entry point.
-  void start() override;
+  /// Arms the poll timer for the given number of seconds.
+  void schedule(size_t interval);
+
+ private:
+  /// Timer callback: pull and run pending queries, then re-arm.
+  void poll(const boost::system::error_code& ec);
+
+ private:
+  /// The distributed query state machine.
+  Distributed distributed_;
+
+  /// The poll timer on the shared io_service.
+  boost::asio::deadline_timer timer_;
 };
 
 Status startDistributed();
@@ -8,12 +8,18 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <osquery/flags.h>
 #include <osquery/logger.h>
 
 #include "osquery/dispatcher/io_service.h"
 
 namespace osquery {
 
+FLAG(uint64,
+     io_service_threads,
+     2,
+     "Number of shared io_service threads (default 2)");
+
 void IOServiceRunner::start() {
   boost::asio::io_service::work work(IOService::get());
   for (;;) {
@@ -38,6 +44,13 @@ void startIOService() {
   boost::asio::detail::win_thread::set_terminate_threads(true);
 #endif
 
-  Dispatcher::addService(std::make_shared<IOServiceRunner>());
+  // Several threads run the shared io_service so one slow handler cannot
+  // stall unrelated asynchronous work.
+  auto thread_count = (FLAGS_io_service_threads > 0)
+                          ? static_cast<size_t>(FLAGS_io_service_threads)
+                          : 1U;
+  for (size_t i = 0U; i < thread_count; i++) {
+    Dispatcher::addService(std::make_shared<IOServiceRunner>());
+  }
 }
 } // namespace osquery
@@ -8,17 +8,27 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <algorithm>
+#include <condition_variable>
 #include <ctime>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <set>
+
+#include <boost/noncopyable.hpp>
 
 #include <osquery/config.h>
 #include <osquery/core.h>
 #include <osquery/database.h>
+#include <osquery/events.h>
 #include <osquery/flags.h>
 #include <osquery/logger.h>
 #include <osquery/query.h>
 #include <osquery/system.h>
 
 #include "osquery/config/parsers/decorators.h"
+#include "osquery/core/conversions.h"
 #include "osquery/core/process.h"
 #include "osquery/dispatcher/scheduler.h"
 #include "osquery/sql/sqlite_util.h"
@@ -44,6 +54,12 @@ FLAG(uint64,
 
 FLAG(uint64, schedule_epoch, 0, "Epoch for scheduled queries");
 
+FLAG(uint64,
+     schedule_concurrent,
+     0,
+     "Number of worker threads executing due scheduled queries, 0 runs the "
+     "schedule serially within the scheduler loop");
+
 HIDDEN_FLAG(bool, enable_monitor, true, "Enable the schedule monitor");
 
 HIDDEN_FLAG(bool,
@@ -91,32 +107,73 @@ SQLInternal monitor(const std::string& name, const ScheduledQuery& query) {
 inline void launchQuery(const std::string& name, const ScheduledQuery& query) {
   // Execute the scheduled query and create a named query object.
   LOG(INFO) << "Executing scheduled query " << name << ": " << query.query;
-  runDecorators(DECORATE_ALWAYS);
 
+  /*
+   * Background queries run with the lowest CPU (and where supported, I/O)
+   * priority for the duration of the execution. The watchdog accounts CPU
+   * utilization against the whole worker, so a demoted query simply yields
+   * to foreground work and completes slowly instead of tripping the limit.
+   * The thread is restored afterward since worker threads are reused.
+   */
+  bool background =
+      (query.options.count("background") && query.options.at("background"));
+  if (background) {
+    setThreadToBackgroundPriority();
+  }
   auto sql = monitor(name, query);
+  if (background) {
+    setThreadToNormalPriority();
+  }
+
   if (!sql.ok()) {
     LOG(ERROR) << "Error executing scheduled query " << name << ": "
                << sql.getMessageString();
     return;
   }
 
-  // Fill in a host identifier fields based on configuration or availability.
-  std::string ident = getHostIdentifier();
-
   // A query log item contains an optional set of differential results or
   // a copy of the most-recent execution alongside some query metadata.
   QueryLogItem item;
   item.name = name;
-  item.identifier = ident;
-  item.columns = sql.columns();
-  item.time = osquery::getUnixTime();
   item.epoch = FLAGS_schedule_epoch;
-  item.calendar_time = osquery::getAsciiTime();
-  getDecorations(item.decorations);
+
+  /*
+   * Most differential runs produce no change, so the host identifier,
+   * times, and decorations are only assembled once there is something to
+   * emit. Decorator queries also only run when their output will be logged.
+   */
+  auto fillItemMetadata = [&item, &sql]() {
+    runDecorators(DECORATE_ALWAYS);
+    item.identifier = getHostIdentifier();
+    item.columns = sql.columns();
+    item.time = osquery::getUnixTime();
+    item.calendar_time = osquery::getAsciiTime();
+    getDecorations(item.decorations);
+  };
 
   if (query.options.count("snapshot") && query.options.at("snapshot")) {
     // This is a snapshot query, emit results with a differential or state.
+    fillItemMetadata();
     item.snapshot_results = std::move(sql.rows());
+
+    /*
+     * Trend-statistic snapshots may request a row sample instead of the
+     * complete result. A partial Fisher-Yates selection is equivalent to a
+     * reservoir sample over the materialized rows: every row is retained
+     * with probability sample_rows / N.
+     */
+    auto& rows = item.snapshot_results;
+    if (query.sample_rows > 0 && rows.size() > query.sample_rows) {
+      std::mt19937 generator(std::random_device{}());
+      for (size_t i = 0; i < query.sample_rows; i++) {
+        std::uniform_int_distribution<size_t> pick(i, rows.size() - 1);
+        std::swap(rows[i], rows[pick(generator)]);
+      }
+      rows.erase(rows.begin() + query.sample_rows, rows.end());
+      VLOG(1) << "Snapshot query " << name << " sampled "
+              << query.sample_rows << " rows";
+    }
+
     logSnapshotQuery(item);
     return;
   }
@@ -157,6 +214,7 @@ inline void launchQuery(const std::string& name, const ScheduledQuery& query) {
 
   VLOG(1) << "Found results for query: " << name;
 
+  fillItemMetadata();
   status = logQueryLogItem(item);
   if (!status.ok()) {
     // If log directory is not available, then the daemon shouldn't continue.
@@ -167,14 +225,171 @@ inline void launchQuery(const std::string& name, const ScheduledQuery& query) {
   }
 }
 
+/// A due query captured by value for execution on a scheduler worker.
+struct ScheduledQueryTask {
+  /// The scheduled query name.
+  std::string name;
+
+  /// A copy of the schedule entry, the config may refresh concurrently.
+  ScheduledQuery query;
+
+  /// The schedule step when the query became due.
+  size_t step{0};
+};
+
+/**
+ * @brief The queue shared by the scheduler loop and its worker pool.
+ *
+ * When --schedule_concurrent is non-zero the SchedulerRunner enqueues due
+ * queries here instead of executing them inline and a pool of workers drains
+ * the queue. A query name is never queued twice and never runs concurrently
+ * with itself: the name stays reserved from enqueue until the worker marks
+ * it complete, so a query overrunning its interval drops the new execution,
+ * the same behavior a serial schedule exhibits when a step overruns.
+ */
+class SchedulerTaskQueue : private boost::noncopyable {
+ public:
+  /// Add a task unless its query name is waiting or still executing.
+  bool enqueue(ScheduledQueryTask task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (pending_.count(task.name) > 0) {
+        return false;
+      }
+      pending_.insert(task.name);
+      tasks_.push_back(std::move(task));
+    }
+    condition_.notify_one();
+    return true;
+  }
+
+  /// Wait up to timeout for a task, returning false if none arrived.
+  bool dequeue(ScheduledQueryTask& task, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!condition_.wait_for(
+            lock, timeout, [this]() { return !tasks_.empty(); })) {
+      return false;
+    }
+    task = std::move(tasks_.front());
+    tasks_.pop_front();
+    return true;
+  }
+
+  /// Release a query name once its execution finished.
+  void complete(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.erase(name);
+  }
+
+ private:
+  /// Protection around task and pending-name access.
+  std::mutex mutex_;
+
+  /// Signaled for each enqueued task.
+  std::condition_variable condition_;
+
+  /// The FIFO of due queries.
+  std::deque<ScheduledQueryTask> tasks_;
+
+  /// Names of queries waiting in the FIFO or executing on a worker.
+  std::set<std::string> pending_;
+};
+
+/// The process-wide queue of due queries for the worker pool.
+static SchedulerTaskQueue kSchedulerQueue;
+
+/// Trigger bookkeeping for one event-bound scheduled query.
+struct QueryTriggerState {
+  /// Total publisher event count at the last trigger-driven execution.
+  size_t events{0};
+
+  /// The schedule step of the last trigger-driven execution.
+  size_t last_fire{0};
+};
+
+/// Trigger state per query name, touched only by the scheduler loop.
+static std::map<std::string, QueryTriggerState> kTriggerStates;
+
+/**
+ * @brief Decide whether an event-bound query is due on this step.
+ *
+ * The bound publishers' in-process event counters are compared against the
+ * total recorded at the last trigger-driven run: any growth marks the query
+ * due once the debounce window has passed. An idle publisher costs only the
+ * counter comparison per step, and a burst of events costs at most one
+ * execution per debounce window (the counter keeps differing, so the run
+ * happens on the first step after the window).
+ */
+static bool queryTriggerFired(const std::string& name,
+                              const ScheduledQuery& query,
+                              size_t step) {
+  // Resolve against the registered types to avoid the error log that
+  // getEventPublisher emits for unknown (or not yet started) publishers.
+  auto types = EventFactory::publisherTypes();
+  size_t total = 0;
+  for (const auto& pub : osquery::split(query.trigger, ",")) {
+    if (std::find(types.begin(), types.end(), pub) == types.end()) {
+      continue;
+    }
+    auto publisher = EventFactory::getEventPublisher(pub);
+    if (publisher != nullptr) {
+      total += publisher->numEvents();
+    }
+  }
+
+  auto& state = kTriggerStates[name];
+  if (total == state.events) {
+    return false;
+  }
+  if (state.last_fire > 0 && step < state.last_fire + query.trigger_debounce) {
+    return false;
+  }
+  state.events = total;
+  state.last_fire = step;
+  return true;
+}
+
+void SchedulerWorkerRunner::start() {
+  while (!interrupted()) {
+    ScheduledQueryTask task;
+    if (!kSchedulerQueue.dequeue(task, std::chrono::seconds(1))) {
+      continue;
+    }
+    TablePlugin::kCacheInterval = task.query.splayed_interval;
+    TablePlugin::kCacheStep = task.step;
+    launchQuery(task.name, task.query);
+    // The name stays reserved through the execution so an overrunning
+    // query is dropped on its next due step instead of run concurrently.
+    kSchedulerQueue.complete(task.name);
+  }
+}
+
 void SchedulerRunner::start() {
+  const bool concurrent = (FLAGS_schedule_concurrent > 0);
   // Start the counter at the second.
   auto i = osquery::getUnixTime();
   for (; (timeout_ == 0) || (i <= timeout_); ++i) {
     auto start_time_point = std::chrono::steady_clock::now();
     Config::get().scheduledQueries(
-        ([&i](std::string name, const ScheduledQuery& query) {
-          if (query.splayed_interval > 0 && i % query.splayed_interval == 0) {
+        ([&i, &concurrent](std::string name, const ScheduledQuery& query) {
+          auto due = (query.splayed_interval > 0 &&
+                      i % query.splayed_interval == query.phase);
+          if (!due && !query.trigger.empty()) {
+            // Event-bound queries also fire when a bound publisher saw
+            // activity; the interval above remains a backstop.
+            due = queryTriggerFired(name, query, i);
+          }
+          if (due) {
+            if (concurrent) {
+              // Hand the query to the worker pool; the schedule entry is
+              // copied since the config may refresh while workers run.
+              ScheduledQueryTask task;
+              task.name = std::move(name);
+              task.query = query.clone();
+              task.step = i;
+              kSchedulerQueue.enqueue(std::move(task));
+              return;
+            }
             TablePlugin::kCacheInterval = query.splayed_interval;
             TablePlugin::kCacheStep = i;
             launchQuery(name, query);
@@ -224,6 +439,10 @@ void startScheduler() {
 }
 
 void startScheduler(unsigned long int timeout, size_t interval) {
+  // Start the optional worker pool before the scheduler begins enqueuing.
+  for (size_t worker = 0; worker < FLAGS_schedule_concurrent; worker++) {
+    Dispatcher::addService(std::make_shared<SchedulerWorkerRunner>());
+  }
   Dispatcher::addService(std::make_shared<SchedulerRunner>(
       timeout, interval, std::chrono::seconds{FLAGS_schedule_max_drift}));
 }
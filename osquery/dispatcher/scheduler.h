@@ -57,6 +57,22 @@ class SchedulerRunner : public InternalRunnable {
   const std::chrono::milliseconds max_time_drift_;
 };
 
+/**
+ * @brief A worker draining the scheduler's concurrent query queue.
+ *
+ * Workers exist only when --schedule_concurrent is non-zero. Each waits on
+ * the shared queue of due queries so a slow query on one worker does not
+ * delay queries due within the same schedule step.
+ */
+class SchedulerWorkerRunner : public InternalRunnable {
+ public:
+  SchedulerWorkerRunner() : InternalRunnable("SchedulerWorkerRunner") {}
+
+ public:
+  /// The Dispatcher thread entry point.
+  void start() override;
+};
+
 SQLInternal monitor(const std::string& name, const ScheduledQuery& query);
 
 /// Start querying according to the config's schedule
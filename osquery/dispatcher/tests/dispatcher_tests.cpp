@@ -13,6 +13,8 @@
 #include <osquery/dispatcher.h>
 #include <osquery/status.h>
 
+#include "osquery/core/process.h"
+
 namespace osquery {
 
 class DispatcherTests : public testing::Test {
@@ -143,4 +145,28 @@ TEST_F(DispatcherTests, test_stop_dispatcher) {
   auto s = Dispatcher::addService(r1);
   EXPECT_FALSE(s);
 }
+
+TEST_F(DispatcherTests, test_task_pool) {
+  auto runnable = std::make_shared<TestRunnable>();
+  runnable->reset();
+
+  // The task runs on a shared pool worker instead of a dedicated thread.
+  auto s = Dispatcher::addTask(runnable);
+  EXPECT_TRUE(s);
+
+  // Wait for a pool worker to pick up and complete the task.
+  while (runnable->count() == 0) {
+    sleepFor(20);
+  }
+  EXPECT_EQ(1U, runnable->count());
+  EXPECT_TRUE(runnable->hasRun());
+
+  // This task cannot be queued again.
+  s = Dispatcher::addTask(runnable);
+  EXPECT_FALSE(s);
+
+  // A stop-join tears the pool down with the services.
+  Dispatcher::stopServices();
+  Dispatcher::joinServices();
+}
 }
@@ -8,7 +8,13 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <map>
 #include <sstream>
+#include <thread>
 #include <utility>
 
 #include <osquery/database.h>
@@ -17,6 +23,7 @@
 #include <osquery/registry_factory.h>
 #include <osquery/sql.h>
 #include <osquery/system.h>
+#include <osquery/tables.h>
 
 #include "osquery/core/conversions.h"
 #include "osquery/core/json.h"
@@ -25,7 +32,9 @@ namespace rj = rapidjson;
 
 namespace osquery {
 
-CREATE_REGISTRY(DistributedPlugin, "distributed");
+// Lazy: only the plugin selected with --distributed_plugin runs setUp, and
+// only when it is activated.
+CREATE_LAZY_REGISTRY(DistributedPlugin, "distributed");
 
 FLAG(string, distributed_plugin, "tls", "Distributed plugin name");
 
@@ -34,8 +43,80 @@ FLAG(bool,
      true,
      "Disable distributed queries (default true)");
 
+FLAG(uint64,
+     distributed_write_batch_rows,
+     0,
+     "Maximum number of result rows per distributed write, 0 writes all "
+     "results in a single request");
+
+FLAG(uint64,
+     distributed_concurrent_queries,
+     1,
+     "Number of distributed queries to execute concurrently (default 1)");
+
+FLAG(uint64,
+     distributed_query_max_seconds,
+     0,
+     "Discard the results of distributed queries running longer than this "
+     "many seconds and report an error, 0 disables the limit");
+
+FLAG(uint64,
+     distributed_query_max_bytes,
+     0,
+     "Discard distributed query results larger than this many bytes and "
+     "report an error, 0 disables the limit");
+
+FLAG(uint64,
+     distributed_discovery_cache,
+     300,
+     "Seconds a distributed discovery query result is reused before "
+     "re-evaluation, 0 evaluates every discovery query per work request");
+
 const std::string kDistributedQueryPrefix{"distributed."};
 
+/**
+ * @brief Discovery results cached by query string.
+ *
+ * Fleet hunts commonly open with the same host-scoping discovery queries
+ * (hostname patterns, os_version checks) whose answers change rarely, if
+ * ever, on a given host. Each entry records whether the query matched and
+ * when that answer expires, so an out-of-scope host declines repeated work
+ * without executing SQL. Bounded by clearing; distinct predicates are few.
+ */
+static std::map<std::string, std::pair<size_t, bool>> kDiscoveryCache;
+
+/// Lock around the discovery result cache.
+static Mutex kDiscoveryCacheMutex;
+
+/// Evaluate a discovery query, reusing an unexpired cached answer.
+static Status runDiscoveryQuery(const std::string& query, bool& matched) {
+  if (FLAGS_distributed_discovery_cache > 0) {
+    ReadLock lock(kDiscoveryCacheMutex);
+    auto cached = kDiscoveryCache.find(query);
+    if (cached != kDiscoveryCache.end() &&
+        cached->second.first > getUnixTime()) {
+      matched = cached->second.second;
+      return Status(0, "OK");
+    }
+  }
+
+  SQL sql(query);
+  if (!sql.getStatus().ok()) {
+    return Status(1, "Distributed discovery query has an SQL error");
+  }
+  matched = (sql.rows().size() > 0);
+
+  if (FLAGS_distributed_discovery_cache > 0) {
+    WriteLock lock(kDiscoveryCacheMutex);
+    if (kDiscoveryCache.size() >= 512) {
+      kDiscoveryCache.clear();
+    }
+    kDiscoveryCache[query] = std::make_pair(
+        getUnixTime() + FLAGS_distributed_discovery_cache, matched);
+  }
+  return Status(0, "OK");
+}
+
 std::string Distributed::currentRequestId_{""};
 
 Status DistributedPlugin::call(const PluginRequest& request,
@@ -90,11 +171,11 @@ size_t Distributed::getCompletedCount() {
   return results_.size();
 }
 
-Status Distributed::serializeResults(std::string& json) {
-  auto doc = JSON::newObject();
+static Status serializeResultSet(
+    const std::vector<DistributedQueryResult>& results, JSON& doc) {
   auto queries_obj = doc.getObject();
   auto statuses_obj = doc.getObject();
-  for (const auto& result : results_) {
+  for (const auto& result : results) {
     auto arr = doc.getArray();
     auto s = serializeQueryData(result.results, result.columns, doc, arr);
     if (!s.ok()) {
@@ -106,6 +187,15 @@ Status Distributed::serializeResults(std::string& json) {
 
   doc.add("queries", queries_obj);
   doc.add("statuses", statuses_obj);
+  return Status();
+}
+
+Status Distributed::serializeResults(std::string& json) {
+  auto doc = JSON::newObject();
+  auto s = serializeResultSet(results_, doc);
+  if (!s.ok()) {
+    return s;
+  }
   return doc.toString(json);
 }
 
@@ -113,24 +203,107 @@ void Distributed::addResult(const DistributedQueryResult& result) {
   results_.push_back(result);
 }
 
+void Distributed::runRequest(const DistributedQueryRequest& request) {
+  LOG(INFO) << "Executing distributed query: " << request.id << ": "
+            << request.query;
+
+  // Keep track of the currently executing request
+  Distributed::setCurrentRequestId(request.id);
+
+  auto started = getUnixTime();
+  SQL sql(request.query);
+  if (!sql.getStatus().ok()) {
+    LOG(ERROR) << "Error executing distributed query: " << request.id << ": "
+               << sql.getMessageString();
+  }
+
+  DistributedQueryResult result(
+      request, sql.rows(), sql.columns(), sql.getStatus());
+  auto elapsed = getUnixTime() - started;
+  if (result.status.ok() && FLAGS_distributed_query_max_seconds > 0 &&
+      elapsed > FLAGS_distributed_query_max_seconds) {
+    // Queries cannot be interrupted mid-execution, drop the late result.
+    LOG(WARNING) << "Distributed query " << request.id << " ran for " << elapsed
+                 << " seconds, discarding results";
+    result.results.clear();
+    result.status = Status(1, "Distributed query exceeded the time limit");
+  } else if (result.status.ok() && FLAGS_distributed_query_max_bytes > 0 &&
+             queryDataBytes(result.results) >
+                 FLAGS_distributed_query_max_bytes) {
+    LOG(WARNING) << "Distributed query " << request.id
+                 << " results exceed the byte limit, discarding results";
+    result.results.clear();
+    result.status = Status(1, "Distributed query exceeded the memory limit");
+  }
+
+  WriteLock lock(results_mutex_);
+  addResult(result);
+}
+
 Status Distributed::runQueries() {
-  while (getPendingQueryCount() > 0) {
-    auto request = popRequest();
-    LOG(INFO) << "Executing distributed query: " << request.id << ": "
-              << request.query;
-
-    // Keep track of the currently executing request
-    Distributed::setCurrentRequestId(request.id);
-
-    SQL sql(request.query);
-    if (!sql.getStatus().ok()) {
-      LOG(ERROR) << "Error executing distributed query: " << request.id << ": "
-                 << sql.getMessageString();
+  write_sequence_ = 0;
+  auto workers = static_cast<size_t>(FLAGS_distributed_concurrent_queries);
+  if (workers <= 1) {
+    while (getPendingQueryCount() > 0) {
+      runRequest(popRequest());
+
+      // When batching, flush as soon as enough rows accumulate so peak
+      // memory does not grow with the total result size of the run.
+      if (FLAGS_distributed_write_batch_rows > 0) {
+        size_t pending_rows = 0;
+        for (const auto& result : results_) {
+          pending_rows += result.results.size();
+        }
+        if (pending_rows >= FLAGS_distributed_write_batch_rows) {
+          auto s = flushBatches(false);
+          if (!s.ok()) {
+            // The batch was re-queued, it is retried with the final flush.
+            VLOG(1) << "Distributed batch write failed: " << s.getMessage();
+          }
+        }
+      }
+    }
+    return flushCompleted();
+  }
+
+  // Fan the queue out across a bounded pool, each worker pops and executes
+  // requests until the queue drains.
+  std::atomic<size_t> active(workers);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < workers; i++) {
+    threads.push_back(std::thread([this, &active]() {
+      while (true) {
+        DistributedQueryRequest request;
+        {
+          WriteLock lock(requests_mutex_);
+          if (getPendingQueryCount() == 0) {
+            break;
+          }
+          request = popRequest();
+        }
+        runRequest(request);
+      }
+      active--;
+    }));
+  }
+
+  // While the pool drains, flush each completed result to the server instead
+  // of waiting for the whole batch.
+  while (active > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    if (FLAGS_distributed_write_batch_rows > 0) {
+      WriteLock lock(results_mutex_);
+      if (!results_.empty()) {
+        auto s = flushBatches(false);
+        if (!s.ok()) {
+          VLOG(1) << "Distributed batch write failed: " << s.getMessage();
+        }
+      }
     }
+  }
 
-    DistributedQueryResult result(
-        request, sql.rows(), sql.columns(), sql.getStatus());
-    addResult(result);
+  for (auto& thread : threads) {
+    thread.join();
   }
   return flushCompleted();
 }
@@ -145,6 +318,10 @@ Status Distributed::flushCompleted() {
     return Status(1, "Missing distributed plugin " + distributed_plugin);
   }
 
+  if (FLAGS_distributed_write_batch_rows > 0) {
+    return flushBatches(true);
+  }
+
   std::string results;
   auto s = serializeResults(results);
   if (!s.ok()) {
@@ -161,9 +338,68 @@ Status Distributed::flushCompleted() {
   return s;
 }
 
+std::vector<DistributedQueryResult> Distributed::popResultBatch(size_t limit) {
+  std::vector<DistributedQueryResult> batch;
+  size_t batch_rows = 0;
+  while (!results_.empty() && batch_rows < limit) {
+    auto& next = results_.front();
+    auto take = std::min(limit - batch_rows, next.results.size());
+    if (take == next.results.size()) {
+      batch.push_back(std::move(next));
+      results_.erase(results_.begin());
+    } else {
+      // Split the rows of a large result, the remainder stays queued.
+      DistributedQueryResult part(
+          next.request,
+          QueryData(next.results.begin(), next.results.begin() + take),
+          next.columns,
+          next.status);
+      next.results.erase(next.results.begin(), next.results.begin() + take);
+      batch.push_back(std::move(part));
+    }
+    batch_rows += take;
+  }
+  return batch;
+}
+
+Status Distributed::flushBatches(bool final) {
+  auto limit = static_cast<size_t>(FLAGS_distributed_write_batch_rows);
+  while (!results_.empty()) {
+    auto batch = popResultBatch(limit);
+
+    auto doc = JSON::newObject();
+    auto s = serializeResultSet(batch, doc);
+    if (s.ok()) {
+      doc.add("sequence", write_sequence_);
+      doc.add("final", final && results_.empty());
+
+      std::string json;
+      s = doc.toString(json);
+      if (s.ok()) {
+        PluginResponse response;
+        s = Registry::call("distributed",
+                           {{"action", "writeResults"}, {"results", json}},
+                           response);
+      }
+    }
+
+    if (!s.ok()) {
+      // The server did not acknowledge this batch, re-queue it for a retry
+      // with the same sequence number.
+      results_.insert(results_.begin(),
+                      std::make_move_iterator(batch.begin()),
+                      std::make_move_iterator(batch.end()));
+      return s;
+    }
+    write_sequence_++;
+  }
+  return Status(0, "OK");
+}
+
 Status Distributed::acceptWork(const std::string& work) {
   auto doc = JSON::newObject();
-  if (!doc.fromString(work) || !doc.doc().IsObject()) {
+  // Parse in place; the work payload may carry many large query strings.
+  if (!doc.fromMutableString(work) || !doc.doc().IsObject()) {
     return Status(1, "Error Parsing JSON");
   }
 
@@ -185,11 +421,12 @@ Status Distributed::acceptWork(const std::string& work) {
           return Status(1, "Distributed discovery query is not a string");
         }
 
-        SQL sql(query);
-        if (!sql.getStatus().ok()) {
-          return Status(1, "Distributed discovery query has an SQL error");
+        bool matched = false;
+        auto status = runDiscoveryQuery(query, matched);
+        if (!status.ok()) {
+          return status;
         }
-        if (sql.rows().size() > 0) {
+        if (matched) {
           queries_to_run.insert(name);
         }
       }
@@ -291,7 +528,7 @@ Status deserializeDistributedQueryRequest(const rj::Value& obj,
 Status deserializeDistributedQueryRequestJSON(const std::string& json,
                                               DistributedQueryRequest& r) {
   auto doc = JSON::newObject();
-  if (!doc.fromString(json) || !doc.doc().IsObject()) {
+  if (!doc.fromMutableString(json) || !doc.doc().IsObject()) {
     return Status(1, "Error Parsing JSON");
   }
   return deserializeDistributedQueryRequest(doc.doc(), r);
@@ -351,7 +588,7 @@ Status deserializeDistributedQueryResult(const rj::Value& obj,
 Status deserializeDistributedQueryResultJSON(const std::string& json,
                                              DistributedQueryResult& r) {
   auto doc = JSON::newObject();
-  if (!doc.fromString(json) || !doc.doc().IsObject()) {
+  if (!doc.fromMutableString(json) || !doc.doc().IsObject()) {
     return Status(1, "Error Parsing JSON");
   }
   return deserializeDistributedQueryResult(doc.doc(), r);
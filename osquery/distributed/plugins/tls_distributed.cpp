@@ -22,6 +22,7 @@
 #include <osquery/registry.h>
 
 #include "osquery/core/json.h"
+#include "osquery/remote/bandwidth.h"
 #include "osquery/remote/serializers/json.h"
 #include "osquery/remote/utility.h"
 
@@ -82,9 +83,18 @@ Status TLSDistributedPlugin::writeResults(const std::string& json) {
     return s;
   }
 
+  // Large result sets share the upload bandwidth ceiling with the carver.
+  UploadShaper::instance().acquire(json.size());
+
   // The response is ignored.
   std::string response;
-  return TLSRequestHelper::go<JSONSerializer>(
+  s = TLSRequestHelper::go<JSONSerializer>(
       write_uri_, params, response, FLAGS_distributed_tls_max_attempts);
+  if (s.ok()) {
+    UploadShaper::instance().reportSuccess();
+  } else {
+    UploadShaper::instance().reportFailure();
+  }
+  return s;
 }
 }
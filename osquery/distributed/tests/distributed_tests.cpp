@@ -182,6 +182,57 @@ TEST_F(DistributedTests, test_deserialize_distributed_query_result_json) {
   EXPECT_EQ(r.results[0]["foo"], "bar");
 }
 
+TEST_F(DistributedTests, test_result_batches) {
+  auto dist = Distributed();
+
+  DistributedQueryResult large;
+  large.request.id = "foo";
+  large.columns = {"foo"};
+  for (size_t i = 0; i < 5; i++) {
+    Row r;
+    r["foo"] = std::to_string(i);
+    large.results.push_back(r);
+  }
+  dist.results_.push_back(large);
+
+  DistributedQueryResult empty;
+  empty.request.id = "bar";
+  dist.results_.push_back(empty);
+
+  // A large result is split, the remainder stays queued.
+  auto batch = dist.popResultBatch(2);
+  ASSERT_EQ(batch.size(), 1U);
+  EXPECT_EQ(batch[0].request.id, "foo");
+  EXPECT_EQ(batch[0].results.size(), 2U);
+  ASSERT_EQ(dist.results_.size(), 2U);
+  EXPECT_EQ(dist.results_[0].results.size(), 3U);
+
+  // A batch may span several results, row-less results are passed through.
+  batch = dist.popResultBatch(10);
+  ASSERT_EQ(batch.size(), 2U);
+  EXPECT_EQ(batch[0].results.size(), 3U);
+  EXPECT_EQ(batch[1].request.id, "bar");
+  EXPECT_TRUE(dist.results_.empty());
+}
+
+TEST_F(DistributedTests, test_query_limits) {
+  auto dist = Distributed();
+
+  DistributedQueryRequest request;
+  request.id = "limited";
+  request.query = "select 1 as n";
+
+  // Any produced row exceeds a one byte result limit, the result is
+  // discarded and replaced with an error status.
+  Flag::updateValue("distributed_query_max_bytes", "1");
+  dist.runRequest(request);
+  Flag::updateValue("distributed_query_max_bytes", "0");
+
+  ASSERT_EQ(dist.results_.size(), 1U);
+  EXPECT_TRUE(dist.results_[0].results.empty());
+  EXPECT_FALSE(dist.results_[0].status.ok());
+}
+
 TEST_F(DistributedTests, test_workflow) {
   startServer();
 
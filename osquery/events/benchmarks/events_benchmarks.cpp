@@ -190,4 +190,136 @@ BENCHMARK(EVENTS_add_and_gentable)
     ->ArgPair(0, 100)
     ->ArgPair(0, 1000)
     ->ArgPair(0, 10000);
+
+/// An event carrying a fully-populated row, as OS publishers produce.
+struct StormEventContext : public EventContext {
+  Row row;
+};
+
+using StormEventContextRef = std::shared_ptr<StormEventContext>;
+
+/// Shape a payload like a process event from an auditd-style publisher.
+static Row getStormProcessEvent(size_t seq) {
+  Row r;
+  r["pid"] = std::to_string(10000 + (seq % 30000));
+  r["parent"] = "1";
+  r["path"] = "/usr/bin/process" + std::to_string(seq % 100);
+  r["cmdline"] = "process --flag --config /etc/process/configuration.conf";
+  r["cwd"] = "/home/user";
+  r["uid"] = "1000";
+  r["gid"] = "1000";
+  r["euid"] = "1000";
+  r["egid"] = "1000";
+  r["auid"] = "1000";
+  r["uptime"] = std::to_string(seq);
+  r["status"] = "0";
+  return r;
+}
+
+/**
+ * @brief A publisher simulating an OS event storm.
+ *
+ * Unlike BenchmarkEventPublisher this fires contexts carrying realistic
+ * process_event payloads, so the fire -> subscriber -> add path is
+ * exercised with production-shaped rows.
+ */
+class BenchmarkStormPublisher
+    : public EventPublisher<SubscriptionContext, StormEventContext> {
+  DECLARE_PUBLISHER("benchmark_storm");
+
+ public:
+  void stormFire(size_t seq, EventTime t) {
+    auto ec = createEventContext();
+    ec->row = getStormProcessEvent(seq);
+    fire(ec, t);
+  }
+};
+
+class BenchmarkStormSubscriber
+    : public EventSubscriber<BenchmarkStormPublisher> {
+ public:
+  BenchmarkStormSubscriber() {
+    setName("benchmark_storm");
+  }
+
+  Status Callback(const ECRef& ec, const SCRef& sc) {
+    // Copy and store the payload as OS event subscribers do.
+    auto r = ec->row;
+    return add(r, ec->time);
+  }
+
+  void benchmarkInit() {
+    auto sub_ctx = createSubscriptionContext();
+    subscribe(&BenchmarkStormSubscriber::Callback, sub_ctx);
+  }
+
+  void stormAdd(size_t seq, EventTime t) {
+    auto r = getStormProcessEvent(seq);
+    add(r, t);
+  }
+
+  void expireRows(EventTime t) {
+    auto ee = expire_events_;
+    auto et = expire_time_;
+    expire_events_ = true;
+    expire_time_ = t;
+    getIndexes(0, 0);
+    expire_events_ = ee;
+    expire_time_ = et;
+  }
+
+  void clearRows() {
+    expireRows(-1);
+  }
+};
+
+static void EVENTS_storm_ingest(benchmark::State& state) {
+  // Setup the event config parser plugin.
+  auto plugin = Config::get().getParser("events");
+  plugin->setUp();
+
+  auto pub = std::make_shared<BenchmarkStormPublisher>();
+  EventFactory::registerEventPublisher(pub);
+
+  auto sub = std::make_shared<BenchmarkStormSubscriber>();
+  EventFactory::registerEventSubscriber(sub);
+  sub->benchmarkInit();
+
+  // Each iteration delivers a burst; the items/sec rate reported by the
+  // benchmark is the sustainable ingest capacity for this host.
+  size_t burst = state.range(0);
+  size_t seq = 0;
+  while (state.KeepRunning()) {
+    for (size_t i = 0; i < burst; i++) {
+      seq++;
+      pub->stormFire(seq, seq);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * burst);
+  sub->clearRows();
+}
+
+BENCHMARK(EVENTS_storm_ingest)->Arg(100)->Arg(1000)->Arg(10000);
+
+static void EVENTS_storm_expire(benchmark::State& state) {
+  auto sub = std::make_shared<BenchmarkStormSubscriber>();
+
+  size_t count = state.range(0);
+  size_t seq = 0;
+  while (state.KeepRunning()) {
+    // Populate outside the timed region; only measure the expiry sweep.
+    state.PauseTiming();
+    for (size_t i = 0; i < count; i++) {
+      seq++;
+      sub->stormAdd(seq, seq);
+    }
+    state.ResumeTiming();
+
+    sub->expireRows(seq + 1);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+  sub->clearRows();
+}
+
+BENCHMARK(EVENTS_storm_expire)->Arg(100)->Arg(1000)->Arg(10000);
 }
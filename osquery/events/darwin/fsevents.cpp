@@ -14,6 +14,7 @@
 
 #include <osquery/config.h>
 #include <osquery/filesystem.h>
+#include <osquery/flags.h>
 #include <osquery/logger.h>
 #include <osquery/registry_factory.h>
 #include <osquery/tables.h>
@@ -33,6 +34,11 @@ namespace fs = boost::filesystem;
 
 namespace osquery {
 
+FLAG(uint64,
+     fsevents_latency,
+     1000,
+     "Milliseconds FSEvents may buffer and coalesce events before delivery");
+
 std::map<FSEventStreamEventFlags, std::string> kMaskActions = {
     {kFSEventStreamEventFlagItemChangeOwner, "ATTRIBUTES_MODIFIED"},
     {kFSEventStreamEventFlagItemXattrMod, "ATTRIBUTES_MODIFIED"},
@@ -95,13 +101,14 @@ void FSEventsEventPublisher::restart() {
     flags |= kFSEventStreamCreateFlagIgnoreSelf;
   }
 
-  // Create the FSEvent stream.
+  // Create the FSEvent stream, resuming from the last-delivered event so a
+  // recreation does not drop the events buffered within the latency window.
   stream_ = FSEventStreamCreate(nullptr,
                                 &FSEventsEventPublisher::Callback,
                                 nullptr,
                                 watch_list,
-                                kFSEventStreamEventIdSinceNow,
-                                1,
+                                since_,
+                                FLAGS_fsevents_latency / 1000.0,
                                 flags);
   if (stream_ != nullptr) {
     // Schedule the stream on the run loop.
@@ -131,6 +138,8 @@ void FSEventsEventPublisher::stop() {
   }
 
   if (stream_ != nullptr) {
+    // Remember the newest event seen, a recreated stream resumes from here.
+    since_ = FSEventStreamGetLatestEventId(stream_);
     FSEventStreamStop(stream_);
     stream_started_ = false;
     FSEventStreamUnscheduleFromRunLoop(
@@ -212,21 +221,29 @@ void FSEventsEventPublisher::buildExcludePathsSet() {
 
 void FSEventsEventPublisher::configure() {
   // Rebuild the watch paths.
-  stop();
-
   buildExcludePathsSet();
 
   {
     WriteLock lock(mutex_);
-    paths_.clear();
+    std::set<std::string> paths;
     for (auto& sub : subscriptions_) {
       auto sc = getSubscriptionContext(sub->context);
-      if (sc->discovered_.size() > 0) {
+      if (!sc->discovered_.empty() &&
+          sc->discovered_.find('*') == std::string::npos) {
+        // Transformed during a previous configure, reuse the result.
+        paths.insert(sc->discovered_);
         continue;
       }
-      auto paths = transformSubscription(sc);
-      paths_.insert(paths.begin(), paths.end());
+      auto sub_paths = transformSubscription(sc);
+      paths.insert(sub_paths.begin(), sub_paths.end());
+    }
+
+    if (paths == paths_ && stream_started_) {
+      // The watched set is unchanged, keep the running stream (and the
+      // events buffered within its latency window) instead of restarting.
+      return;
     }
+    paths_ = std::move(paths);
   }
 
   restart();
@@ -260,52 +277,72 @@ void FSEventsEventPublisher::Callback(
     void* event_paths,
     const FSEventStreamEventFlags fsevent_flags[],
     const FSEventStreamEventId fsevent_ids[]) {
+  // Collect this delivery into one batch, coalescing repeated (action, path)
+  // pairs: bursts of writes within the latency window collapse to one event.
+  std::vector<EventContextRef> batch;
+  std::set<std::string> coalesced;
   for (size_t i = 0; i < num_events; ++i) {
-    auto ec = createEventContext();
-    ec->fsevent_stream = stream;
-    ec->fsevent_flags = fsevent_flags[i];
-    ec->transaction_id = fsevent_ids[i];
-    ec->path = std::string(((char**)event_paths)[i]);
+    auto flags = fsevent_flags[i];
+    auto path = std::string(((char**)event_paths)[i]);
 
-    if (ec->fsevent_flags & kFSEventStreamEventFlagMustScanSubDirs) {
+    if (flags & kFSEventStreamEventFlagMustScanSubDirs) {
       // The FSEvents thread coalesced events within and will report a root.
-      TLOG << "FSEvents collision, root: " << ec->path;
+      TLOG << "FSEvents collision, root: " << path;
     }
 
-    if (ec->fsevent_flags & kFSEventStreamEventFlagRootChanged) {
+    if (flags & kFSEventStreamEventFlagRootChanged) {
       // Must rescan for the changed root.
     }
 
-    if (ec->fsevent_flags & kFSEventStreamEventFlagUnmount) {
+    if (flags & kFSEventStreamEventFlagUnmount) {
       // Should remove the watch on this path.
     }
 
-    if (ec->fsevent_flags & kFSEventStreamEventFlagMount) {
+    if (flags & kFSEventStreamEventFlagMount) {
       auto mc = std::make_shared<FSEventsSubscriptionContext>();
-      mc->path = ec->path + "/*";
+      mc->path = path + "/*";
       auto subscription = Subscription::create("file_events", mc);
       auto status = EventFactory::addSubscription("fsevents", subscription);
       auto pub = EventFactory::getEventPublisher("fsevents");
       pub->configure();
     }
 
-    // Record the string-version of the first matched mask bit.
+    // Record the string-version of each matched mask bit.
     bool has_action = false;
     for (const auto& action : kMaskActions) {
-      if (ec->fsevent_flags & action.first) {
-        // Actions may be multiplexed. Fire and event for each.
-        ec->action = action.second;
-        EventFactory::fire<FSEventsEventPublisher>(ec);
-        has_action = true;
+      if (!(flags & action.first)) {
+        continue;
+      }
+      // Actions may be multiplexed. Deliver an event for each.
+      auto ec = createEventContext();
+      ec->fsevent_stream = stream;
+      ec->fsevent_flags = flags;
+      ec->transaction_id = fsevent_ids[i];
+      ec->path = path;
+      ec->action = action.second;
+      has_action = true;
+      if (coalesced.insert(ec->action + '|' + ec->path).second) {
+        batch.push_back(std::move(ec));
       }
     }
 
     if (!has_action) {
-      // If no action was matched for this path event, fire and unknown.
+      // If no action was matched for this path event, fire an unknown.
+      auto ec = createEventContext();
+      ec->fsevent_stream = stream;
+      ec->fsevent_flags = flags;
+      ec->transaction_id = fsevent_ids[i];
+      ec->path = std::move(path);
       ec->action = "UNKNOWN";
-      EventFactory::fire<FSEventsEventPublisher>(ec);
+      if (coalesced.insert(ec->action + '|' + ec->path).second) {
+        batch.push_back(std::move(ec));
+      }
     }
   }
+
+  if (!batch.empty()) {
+    EventFactory::fire<FSEventsEventPublisher>(batch);
+  }
 }
 
 bool FSEventsEventPublisher::shouldFire(
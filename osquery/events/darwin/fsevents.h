@@ -156,6 +156,9 @@ class FSEventsEventPublisher
   /// Has the FSEvents run loop and stream been started.
   std::atomic<bool> stream_started_{false};
 
+  /// The newest delivered event ID, a recreated stream resumes from here.
+  FSEventStreamEventId since_{kFSEventStreamEventIdSinceNow};
+
   /// Set of paths to monitor, determined by a configure step.
   std::set<std::string> paths_;
 
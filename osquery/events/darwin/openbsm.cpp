@@ -10,6 +10,7 @@
 
 #include <bsm/libbsm.h>
 
+#include <osquery/dispatcher.h>
 #include <osquery/flags.h>
 #include <osquery/logger.h>
 #include <osquery/registry_factory.h>
@@ -26,6 +27,70 @@ FLAG(bool,
 
 REGISTER(OpenBSMEventPublisher, "event_publisher", "openbsm");
 
+/// Raw records buffered ahead of the parser before the reader backpressures.
+const size_t kOpenBSMMaxQueuedRecords{4096};
+
+void OpenBSMConsumerRunner::start() {
+  std::vector<OpenBSMRawRecord> queue;
+  while (!interrupted() && !context_->stopping) {
+    {
+      std::unique_lock<std::mutex> lock(context_->raw_records_mutex);
+      if (context_->raw_records.empty()) {
+        context_->raw_records_cv.wait_for(lock, std::chrono::seconds(1));
+      }
+      queue = std::move(context_->raw_records);
+      context_->raw_records.clear();
+    }
+
+    if (!queue.empty()) {
+      // Wake the reader if it was blocked on a full queue.
+      context_->raw_records_cv.notify_all();
+      for (const auto& record : queue) {
+        fireRecord(record);
+      }
+      queue.clear();
+    }
+  }
+}
+
+void OpenBSMConsumerRunner::fireRecord(const OpenBSMRawRecord& record) const {
+  tokenstr_t tok;
+  auto bytesread = 0;
+  auto event_id = 0;
+  std::vector<tokenstr_t> tokens;
+
+  // Tokens reference the shared record buffer, no field copies are made.
+  while (bytesread < record.length) {
+    if (au_fetch_tok(&tok,
+                     record.buffer.get() + bytesread,
+                     record.length - bytesread) == -1) {
+      break;
+    }
+    switch (tok.id) {
+    case AUT_HEADER32:
+      event_id = tok.tt.hdr32_ex.e_type;
+      break;
+    case AUT_HEADER32_EX:
+      event_id = tok.tt.hdr32_ex.e_type;
+      break;
+    case AUT_HEADER64:
+      event_id = tok.tt.hdr64.e_type;
+      break;
+    case AUT_HEADER64_EX:
+      event_id = tok.tt.hdr64_ex.e_type;
+      break;
+    }
+    tokens.push_back(tok);
+    bytesread += tok.len;
+  }
+
+  auto ec = OpenBSMEventPublisher::createEventContext();
+  ec->event_id = event_id;
+  ec->tokens = std::move(tokens);
+  ec->buffer = record.buffer;
+  EventFactory::fire<OpenBSMEventPublisher>(ec);
+}
+
 Status OpenBSMEventPublisher::setUp() {
   if (FLAGS_disable_audit) {
     return Status(1, "Publisher disabled via configuration");
@@ -35,6 +100,11 @@ Status OpenBSMEventPublisher::setUp() {
     LOG(WARNING) << "The auditpipe couldn't be opened.";
     return Status(1, "Could not open OpenBSM pipe");
   }
+
+  // Spawn the second pipeline stage: raw records drained here are tokenized
+  // and fired by the consumer service.
+  context_ = std::make_shared<OpenBSMPipeContext>();
+  Dispatcher::addService(std::make_shared<OpenBSMConsumerRunner>(context_));
   return Status(0);
 }
 
@@ -45,54 +115,37 @@ void OpenBSMEventPublisher::tearDown() {
     fclose(audit_pipe_);
     audit_pipe_ = nullptr;
   }
+
+  if (context_ != nullptr) {
+    context_->stopping = true;
+    context_->raw_records_cv.notify_all();
+    context_ = nullptr;
+  }
 }
 
 Status OpenBSMEventPublisher::run() {
   if (audit_pipe_ == nullptr) {
     return Status(1, "No open audit_pipe");
   }
-  tokenstr_t tok;
+
   auto reclen = 0;
-  auto bytesread = 0;
-  auto event_id = 0;
   auto buffer = static_cast<unsigned char*>(nullptr);
-  std::vector<tokenstr_t> tokens{};
-
   while (!isEnding() && (reclen = au_read_rec(audit_pipe_, &buffer)) != -1) {
-    bytesread = 0;
-
-    while (bytesread < reclen) {
-      if (au_fetch_tok(&tok, buffer + bytesread, reclen - bytesread) == -1) {
-        break;
-      }
-      switch (tok.id) {
-      case AUT_HEADER32:
-        event_id = tok.tt.hdr32_ex.e_type;
-        break;
-      case AUT_HEADER32_EX:
-        event_id = tok.tt.hdr32_ex.e_type;
-        break;
-      case AUT_HEADER64:
-        event_id = tok.tt.hdr64.e_type;
-        break;
-      case AUT_HEADER64_EX:
-        event_id = tok.tt.hdr64_ex.e_type;
-        break;
-      }
-      tokens.push_back(tok);
-      bytesread += tok.len;
-    }
+    OpenBSMRawRecord record;
+    record.length = reclen;
     // We probably don't need a lambda here but it's useful to put debug
     // lines in to validate destruction.
-    std::shared_ptr<unsigned char> sp_buffer(
+    record.buffer = std::shared_ptr<unsigned char>(
         buffer, [](unsigned char* p) { delete p; });
-    auto ec = createEventContext();
-    ec->event_id = event_id;
-    ec->tokens = tokens;
-    ec->buffer = sp_buffer;
-    fire(ec);
-    tokens.clear();
-    event_id = 0;
+
+    std::unique_lock<std::mutex> lock(context_->raw_records_mutex);
+    while (context_->raw_records.size() >= kOpenBSMMaxQueuedRecords &&
+           !isEnding()) {
+      // Apply backpressure to the kernel pipe instead of dropping records.
+      context_->raw_records_cv.wait_for(lock, std::chrono::seconds(1));
+    }
+    context_->raw_records.push_back(std::move(record));
+    context_->raw_records_cv.notify_all();
   }
   return Status(0);
 }
@@ -10,6 +10,13 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <osquery/dispatcher.h>
 #include <osquery/events.h>
 
 namespace osquery {
@@ -32,8 +39,55 @@ using OpenBSMEventContextRef = std::shared_ptr<OpenBSMEventContext>;
 using OpenBSMSubscriptionContextRef =
     std::shared_ptr<OpenBSMSubscriptionContext>;
 
+/// A raw BSM record drained from the audit pipe, not yet tokenized.
+struct OpenBSMRawRecord {
+  /// Length of the raw record in bytes.
+  int length{0};
+
+  /// Owned record bytes returned by au_read_rec.
+  std::shared_ptr<unsigned char> buffer;
+};
+
+/**
+ * @brief State shared between the audit pipe reader and the token parser.
+ *
+ * The publisher run loop only drains /dev/auditpipe and hands raw records
+ * over; tokenization and subscriber fires happen on the dispatched consumer
+ * service, so the pipe never backs up behind slow parsing.
+ */
+struct OpenBSMPipeContext {
+  /// Raw records awaiting tokenization, bounded by the reader.
+  std::vector<OpenBSMRawRecord> raw_records;
+
+  /// Lock around the raw record handoff.
+  std::mutex raw_records_mutex;
+
+  /// Wakes the parser on new records and the reader on drained space.
+  std::condition_variable raw_records_cv;
+
+  /// Set when the publisher tears down, stops the parser service.
+  std::atomic<bool> stopping{false};
+};
+
+using OpenBSMPipeContextRef = std::shared_ptr<OpenBSMPipeContext>;
+
 /// This is a dispatched service that handles published audit replies.
-class OpenBSMConsumerRunner;
+class OpenBSMConsumerRunner : public InternalRunnable {
+ public:
+  explicit OpenBSMConsumerRunner(OpenBSMPipeContextRef context)
+      : InternalRunnable("OpenBSMConsumerRunner"),
+        context_(std::move(context)) {}
+
+  /// Drain raw records, tokenize them, and fire subscriber events.
+  void start() override;
+
+ private:
+  /// Tokenize one raw record and fire the matching event context.
+  void fireRecord(const OpenBSMRawRecord& record) const;
+
+  /// State shared with the publisher's pipe reader.
+  OpenBSMPipeContextRef context_;
+};
 
 class OpenBSMEventPublisher
     : public EventPublisher<OpenBSMSubscriptionContext, OpenBSMEventContext> {
@@ -56,6 +110,10 @@ class OpenBSMEventPublisher
 
  private:
   FILE* audit_pipe_ = nullptr;
+
+  /// Raw record handoff to the dispatched consumer service.
+  OpenBSMPipeContextRef context_;
+
   /// Apply normal subscription to event matching logic.
   bool shouldFire(const OpenBSMSubscriptionContextRef& mc,
                   const OpenBSMEventContextRef& ec) const override;
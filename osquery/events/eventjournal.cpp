@@ -0,0 +1,128 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <chrono>
+
+#include <osquery/flags.h>
+#include <osquery/logger.h>
+
+#include "osquery/events/eventjournal.h"
+
+namespace osquery {
+
+DECLARE_uint64(events_journal_sync);
+
+/// A monotonic millisecond clock for bounding journal sync intervals.
+static inline size_t journalMilliseconds() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+Status EventJournal::open(const std::string& path) {
+  WriteLock lock(mutex_);
+  path_ = path;
+  file_ = std::make_unique<PlatformFile>(
+      path, PF_OPEN_ALWAYS | PF_WRITE | PF_APPEND);
+  if (!file_->isValid()) {
+    file_.reset();
+    return Status(1, "Cannot open events journal: " + path);
+  }
+  return Status(0, "OK");
+}
+
+Status EventJournal::append(const std::string& data) {
+  WriteLock lock(mutex_);
+  if (file_ == nullptr) {
+    return Status(1, "Events journal is not open");
+  }
+
+  auto record = data + '\n';
+  if (file_->write(record.c_str(), record.size()) < 0) {
+    return Status(1, "Cannot append to events journal: " + path_);
+  }
+
+  // Group-sync: pay the durability cost at most once per interval instead
+  // of on every appended event.
+  auto now = journalMilliseconds();
+  if (now - last_sync_ >= FLAGS_events_journal_sync) {
+    last_sync_ = now;
+    syncLocked();
+  }
+  return Status(0, "OK");
+}
+
+Status EventJournal::replay(std::vector<std::string>& records) {
+  WriteLock lock(mutex_);
+
+  PlatformFile reader(path_, PF_OPEN_EXISTING | PF_READ);
+  if (!reader.isValid()) {
+    // A missing journal is a normal first start.
+    return Status(0, "OK");
+  }
+
+  auto size = reader.size();
+  if (size == 0) {
+    return Status(0, "OK");
+  }
+
+  std::string content(size, 0);
+  auto read_size = reader.read(&content[0], size);
+  if (read_size < 0) {
+    return Status(1, "Cannot read events journal: " + path_);
+  }
+  content.resize(static_cast<size_t>(read_size));
+
+  // Only complete, newline-terminated records are replayed; a partial
+  // trailing record means the previous process stopped mid-append.
+  size_t offset = 0;
+  while (true) {
+    auto end = content.find('\n', offset);
+    if (end == std::string::npos) {
+      break;
+    }
+    if (end > offset) {
+      records.push_back(content.substr(offset, end - offset));
+    }
+    offset = end + 1;
+  }
+  return Status(0, "OK");
+}
+
+Status EventJournal::reset() {
+  WriteLock lock(mutex_);
+  if (path_.empty()) {
+    return Status(1, "Events journal is not open");
+  }
+
+  // Reopen with truncation; the journaled rows are now in the backing store.
+  file_.reset();
+  file_ = std::make_unique<PlatformFile>(
+      path_, PF_TRUNCATE | PF_WRITE | PF_APPEND);
+  if (!file_->isValid()) {
+    file_.reset();
+    return Status(1, "Cannot truncate events journal: " + path_);
+  }
+  syncLocked();
+  return Status(0, "OK");
+}
+
+void EventJournal::syncLocked() {
+  if (file_ == nullptr) {
+    return;
+  }
+
+#ifdef WIN32
+  ::FlushFileBuffers(file_->nativeHandle());
+#else
+  ::fsync(file_->nativeHandle());
+#endif
+}
+} // namespace osquery
@@ -0,0 +1,71 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <osquery/mutex.h>
+#include <osquery/status.h>
+
+#include "osquery/filesystem/fileops.h"
+
+namespace osquery {
+
+/**
+ * @brief Append-only journal backing the pending event batch.
+ *
+ * When group-commit batching is enabled (see events_batch_size) rows wait in
+ * memory until the batch write, so a crash loses the pending rows. The
+ * journal writes each serialized row to an append-only file first and syncs
+ * the file at a bounded interval (events_journal_sync), limiting crash-loss
+ * exposure to that window while keeping the sequential-append throughput.
+ *
+ * Records are newline-delimited serialized rows. A partial trailing record
+ * indicates the process stopped mid-append and is discarded on replay. The
+ * journal is replayed when the subscriber registers and truncated after
+ * every successful drain into the backing store.
+ */
+class EventJournal : private boost::noncopyable {
+ public:
+  /// Open (or create) the journal file at the given path.
+  Status open(const std::string& path);
+
+  /// Append one serialized event row, syncing on the configured interval.
+  Status append(const std::string& data);
+
+  /// Read back every complete record written before the last shutdown.
+  Status replay(std::vector<std::string>& records);
+
+  /// Truncate the journal once the pending batch reached the backing store.
+  Status reset();
+
+ private:
+  /// Sync the append handle to disk, must be called with the lock held.
+  void syncLocked();
+
+ private:
+  /// Journal file location.
+  std::string path_;
+
+  /// Append handle, invalid until open succeeds.
+  std::unique_ptr<PlatformFile> file_{nullptr};
+
+  /// Monotonic milliseconds of the last explicit sync.
+  size_t last_sync_{0};
+
+  /// Serialize appends, replays, and truncation.
+  Mutex mutex_;
+};
+} // namespace osquery
@@ -10,14 +10,14 @@
 
 #include <chrono>
 #include <exception>
+#include <mutex>
 #include <thread>
 
-#include <boost/algorithm/string.hpp>
-#include <boost/algorithm/string/classification.hpp>
 #include <boost/lexical_cast.hpp>
 
 #include <osquery/config.h>
 #include <osquery/database.h>
+#include <osquery/dispatcher.h>
 #include <osquery/events.h>
 #include <osquery/flags.h>
 #include <osquery/logger.h>
@@ -25,12 +25,17 @@
 #include <osquery/sql.h>
 #include <osquery/system.h>
 
+#include "osquery/core/alloc_tracking.h"
 #include "osquery/core/conversions.h"
+#include "osquery/core/metrics.h"
+#include "osquery/events/eventjournal.h"
 
 namespace osquery {
 
-CREATE_REGISTRY(EventPublisherPlugin, "event_publisher");
-CREATE_REGISTRY(EventSubscriberPlugin, "event_subscriber");
+// The EventFactory sets up publishers and subscribers explicitly when event
+// loops are attached, so the registries should not setUp items eagerly.
+CREATE_LAZY_REGISTRY(EventPublisherPlugin, "event_publisher");
+CREATE_LAZY_REGISTRY(EventSubscriberPlugin, "event_subscriber");
 
 /// Checkpoint interval to inspect max event buffering.
 #define EVENTS_CHECKPOINT 256
@@ -50,6 +55,90 @@ FLAG(uint64, events_expiry, 3600, "Timeout to expire event subscriber results");
 // overriding in subclasses
 FLAG(uint64, events_max, 50000, "Maximum number of events per type to buffer");
 
+// Both retention flags are read on every expiry check and remain updatable
+// through the config options flow, so hot paths use lock-free typed handles.
+static FastFlag<decltype(FLAGS_events_expiry)> kEventsExpiryFlag(
+    "events_expiry", &FLAGS_events_expiry);
+
+static FastFlag<decltype(FLAGS_events_max)> kEventsMaxFlag("events_max",
+                                                           &FLAGS_events_max);
+
+FLAG(uint64,
+     events_expiry_interval,
+     0,
+     "Interval in seconds between background sweeps applying the subscriber "
+     "retention limits (0 = expire only at write checkpoints and queries)");
+
+FLAG(uint64,
+     events_batch_size,
+     0,
+     "Accumulate this many subscriber events and group-commit them as one "
+     "batch write (0 = write each event immediately)");
+
+FLAG(uint64,
+     events_batch_latency,
+     500,
+     "Maximum milliseconds an event may wait in a pending batch before the "
+     "group commit; bounds the events lost to a crash mid-batch");
+
+FLAG(uint64,
+     events_query_cache_max,
+     10000,
+     "Maximum decoded event rows cached per subscriber for repeated window "
+     "queries (0 = disable the query-time row cache)");
+
+FLAG(bool,
+     events_journal,
+     false,
+     "Write pending subscriber events to an append-only journal before the "
+     "group commit and replay the journal on startup");
+
+FLAG(uint64,
+     events_journal_sync,
+     200,
+     "Maximum milliseconds between events journal file syncs; bounds the "
+     "events lost to a host crash");
+
+FLAG(uint64,
+     events_context_pool,
+     32,
+     "Event contexts recycled per publisher to avoid per-event allocation "
+     "(0 = allocate a fresh context for every fired event)");
+
+FLAG(bool,
+     events_on_demand,
+     false,
+     "Start event publisher run loops on first subscription instead of at "
+     "startup, and quiesce loops left without subscribers");
+
+FLAG(uint64,
+     events_on_demand_idle,
+     300,
+     "Seconds an on-demand publisher may run without subscribers before its "
+     "loop quiesces (0 = never quiesce)");
+
+FLAG(uint64,
+     events_dedup_window,
+     0,
+     "Seconds during which repeated identical event rows for a subscriber "
+     "are suppressed and counted (0 = disable storm deduplication)");
+
+DECLARE_string(database_path);
+
+/// Backing store key prefix for warm-restart publisher state.
+const std::string kPublisherStatePrefix{"publisher_state."};
+
+size_t eventContextPoolSize() {
+  return FLAGS_events_context_pool;
+}
+
+/// A monotonic millisecond clock for bounding pending event batches.
+static inline size_t monotonicMilliseconds() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
 static inline EventTime timeFromRecord(const std::string& record) {
   // Convert a stored index "as string bytes" to a time value.
   long long afinite;
@@ -144,7 +233,21 @@ void EventSubscriberPlugin::genTable(RowYield& yield, QueryContext& context) {
       queries_.insert(query_name);
     }
   }
-  get(yield, start, stop);
+  // Aggregates like COUNT(*) and MIN/MAX(time) use no stored columns. When
+  // every used column is covered by the record index, answer from the index
+  // metadata without deserializing any event data.
+  bool metadata_only = false;
+  if (context.colsUsed) {
+    metadata_only = true;
+    for (const auto& column : *context.colsUsed) {
+      if (column != "time" && column != "eid") {
+        metadata_only = false;
+        break;
+      }
+    }
+  }
+
+  get(yield, start, stop, metadata_only);
 }
 
 EventContextID EventPublisherPlugin::numEvents() const {
@@ -162,6 +265,10 @@ void EventPublisherPlugin::fire(const EventContextRef& ec, EventTime time) {
     return;
   }
 
+  // The cell is resolved once; per-event accounting is a single atomic add.
+  static auto& fired = metricCell("events_fired");
+  fired.fetch_add(1);
+
   EventContextID ec_id = 0;
   ec_id = next_ec_id_.fetch_add(1);
 
@@ -177,6 +284,24 @@ void EventPublisherPlugin::fire(const EventContextRef& ec, EventTime time) {
   }
 
   ReadLock lock(subscription_lock_);
+  if (ec != nullptr && ec->target_sub_ctx != nullptr) {
+    // The publisher resolved the owning subscription while building the
+    // event: dispatch is a single index lookup instead of a shouldFire probe
+    // per subscription. The matched subscriptions still run shouldFire for
+    // event masks, exclusions, and their side effects.
+    auto target = subscription_index_.find(ec->target_sub_ctx.get());
+    if (target != subscription_index_.end()) {
+      for (const auto& subscription : target->second) {
+        auto es =
+            EventFactory::getEventSubscriber(subscription->subscriber_name);
+        if (es != nullptr && es->state() == EventState::EVENT_RUNNING) {
+          fireCallback(subscription, ec);
+        }
+      }
+    }
+    return;
+  }
+
   for (const auto& subscription : subscriptions_) {
     auto es = EventFactory::getEventSubscriber(subscription->subscriber_name);
     if (es != nullptr && es->state() == EventState::EVENT_RUNNING) {
@@ -185,55 +310,106 @@ void EventPublisherPlugin::fire(const EventContextRef& ec, EventTime time) {
   }
 }
 
+void EventPublisherPlugin::fire(const std::vector<EventContextRef>& batch,
+                                EventTime time) {
+  if (isEnding() || batch.empty()) {
+    // Cannot emit/fire while ending
+    return;
+  }
+
+  // Fill in the EventContext IDs and times if needed.
+  if (time == 0) {
+    time = getUnixTime();
+  }
+  for (const auto& ec : batch) {
+    if (ec != nullptr) {
+      ec->id = next_ec_id_.fetch_add(1);
+      if (ec->time == 0) {
+        ec->time = time;
+      }
+    }
+  }
+
+  // The subscription lock is held and each subscriber resolved once for the
+  // whole batch, instead of once per event.
+  ReadLock lock(subscription_lock_);
+  for (const auto& subscription : subscriptions_) {
+    auto es = EventFactory::getEventSubscriber(subscription->subscriber_name);
+    if (es == nullptr || es->state() != EventState::EVENT_RUNNING) {
+      continue;
+    }
+    for (const auto& ec : batch) {
+      if (ec == nullptr) {
+        continue;
+      }
+      if (ec->target_sub_ctx != nullptr &&
+          ec->target_sub_ctx.get() != subscription->context.get()) {
+        // The event belongs to a specific subscription; skip the others.
+        continue;
+      }
+      fireCallback(subscription, ec);
+    }
+  }
+}
+
 std::vector<std::string> EventSubscriberPlugin::getIndexes(EventTime start,
                                                            EventTime stop,
                                                            bool sort) {
-  auto index_key = "indexes." + dbNamespace();
   std::vector<std::string> indexes;
 
   EventTime l_start = (start > 0) ? start / 60 : 0;
   EventTime r_stop = (stop > 0) ? stop / 60 + 1 : 0;
 
-  std::string content;
-  getDatabaseValue(kEvents, index_key + ".60", content);
-  if (content.empty()) {
-    return indexes;
-  }
-
-  std::vector<std::string> bins, expirations;
-  boost::split(bins, content, boost::is_any_of(","));
-  for (const auto& bin : bins) {
-    auto step = timeFromRecord(bin);
-    auto step_start = step * 60;
-    auto step_stop = (step + 1) * 60;
-    if (step_stop <= expire_time_) {
-      expirations.push_back(bin);
-    } else if (step_start < expire_time_ && sort) {
-      expireRecords("60", bin, false);
+  WriteLock lock(record_bins_mutex_);
+  if (!record_bins_seeded_) {
+    // Seed the ordered bin cache once, writes keep it current afterward.
+    auto record_prefix = "records." + dbNamespace() + ".60.";
+    std::vector<std::string> keys;
+    scanDatabaseKeys(kEvents, keys, record_prefix);
+    for (const auto& key : keys) {
+      auto bin = key.substr(record_prefix.size());
+      if (bin.find('.') == std::string::npos) {
+        // A pre-upgrade comma-joined list shares this prefix but holds no
+        // per-record keys; split it in place so its events stay visible.
+        migrateLegacyRecords(key);
+      }
+      record_bins_.insert(timeFromRecord(bin.substr(0, bin.find('.'))));
     }
-
-    if (step >= l_start && (r_stop == 0 || step < r_stop) && sort) {
-      indexes.push_back("60." + bin);
+    // The legacy bin list is superseded by this prefix scan.
+    deleteDatabaseValue(kEvents, "indexes." + dbNamespace() + ".60");
+    record_bins_seeded_ = true;
+  }
+
+  // Expire the bins trailing the expiration, the set iteration is numeric.
+  auto executed_all = executedAllQueries();
+  auto step = record_bins_.begin();
+  while (step != record_bins_.end() && *step * 60 < expire_time_) {
+    auto bin = std::to_string(*step);
+    if ((*step + 1) * 60 <= expire_time_) {
+      // The bin is below the expiration, range-delete its records.
+      expireRecords("60", bin, true);
+      if (executed_all) {
+        step = record_bins_.erase(step);
+        continue;
+      }
+    } else if (sort) {
+      expireRecords("60", bin, false);
     }
+    ++step;
   }
 
-  // Rewrite the index lists and delete each expired item.
-  if (!expirations.empty()) {
-    expireIndexes("60", bins, expirations);
+  if (!sort) {
+    return indexes;
   }
 
-  // Return indexes in binning order.
-  if (sort) {
-    std::sort(indexes.begin(),
-              indexes.end(),
-              [](const std::string& left, const std::string& right) {
-                auto n1 = timeFromRecord(left.substr(left.find('.') + 1));
-                auto n2 = timeFromRecord(right.substr(right.find('.') + 1));
-                return n1 < n2;
-              });
+  // Binary-search the first bin overlapping the window, then walk in order.
+  for (auto it = record_bins_.lower_bound(l_start);
+       it != record_bins_.end() && (r_stop == 0 || *it < r_stop);
+       ++it) {
+    indexes.push_back("60." + std::to_string(*it));
   }
 
-  // Update the new time that events expire to now - expiry.
+  // Return indexes in binning order, the set iteration was numeric.
   return indexes;
 }
 
@@ -244,61 +420,34 @@ void EventSubscriberPlugin::expireRecords(const std::string& list_type,
     return;
   }
 
-  auto record_key = "records." + dbNamespace();
   auto data_key = "data." + dbNamespace();
+  auto record_prefix =
+      "records." + dbNamespace() + "." + list_type + "." + index + ".";
 
-  // If the expirations is not removing all records, rewrite the persisting.
-  std::vector<std::string> persisting_records;
   // Request all records within this list-size + bin offset.
   auto expired_records = getRecords({list_type + '.' + index}, false);
   if (all && expired_records.size() > 1) {
+    // Both the record keys and data keys are ordered by EID.
     deleteDatabaseRange(kEvents,
                         data_key + '.' + expired_records.begin()->first,
                         data_key + '.' + expired_records.rbegin()->first);
+    deleteDatabaseRange(kEvents,
+                        record_prefix + expired_records.begin()->first,
+                        record_prefix + expired_records.rbegin()->first);
   } else {
     for (const auto& record : expired_records) {
-      if (record.second <= expire_time_) {
+      if (all || record.second <= expire_time_) {
         deleteDatabaseValue(kEvents, data_key + '.' + record.first);
-      } else {
-        persisting_records.push_back(record.first + ':' +
-                                     std::to_string(record.second));
+        deleteDatabaseValue(kEvents, record_prefix + record.first);
       }
     }
   }
 
-  // Either drop or overwrite the record list.
-  if (all) {
-    deleteDatabaseValue(kEvents, record_key + "." + list_type + "." + index);
-  } else if (persisting_records.size() < expired_records.size()) {
-    auto new_records = boost::algorithm::join(persisting_records, ",");
-    setDatabaseValue(
-        kEvents, record_key + "." + list_type + "." + index, new_records);
-  }
-}
-
-void EventSubscriberPlugin::expireIndexes(
-    const std::string& list_type,
-    const std::vector<std::string>& indexes,
-    const std::vector<std::string>& expirations) {
-  if (!executedAllQueries()) {
-    return;
-  }
-
-  auto index_key = "indexes." + dbNamespace();
-
-  // Construct a mutable list of persisting indexes to rewrite as records.
-  std::vector<std::string> persisting_indexes = indexes;
-  // Remove the records using the list of expired indexes.
-  for (const auto& bin : expirations) {
-    expireRecords(list_type, bin, true);
-    persisting_indexes.erase(
-        std::remove(persisting_indexes.begin(), persisting_indexes.end(), bin),
-        persisting_indexes.end());
+  // The parsed records cached for this bin are no longer valid.
+  {
+    WriteLock lock(record_cache_mutex_);
+    record_cache_.erase(timeFromRecord(index));
   }
-
-  // Update the list of indexes with the non-expired indexes.
-  auto new_indexes = boost::algorithm::join(persisting_indexes, ",");
-  setDatabaseValue(kEvents, index_key + "." + list_type, new_indexes);
 }
 
 void EventSubscriberPlugin::expireCheck() {
@@ -309,9 +458,16 @@ void EventSubscriberPlugin::expireCheck() {
 
   {
     auto limit = getEventsMax();
-    std::vector<std::string> keys;
-    scanDatabaseKeys(kEvents, keys, data_key);
-    if (keys.size() <= limit) {
+    // Count the buffered events in bounded chunks; an overflowed subscriber
+    // may hold far more keys than should be materialized at once.
+    size_t count = 0;
+    scanDatabaseKeysChunked(kEvents,
+                            ([&count](const std::vector<std::string>& keys) {
+                              count += keys.size();
+                              return true;
+                            }),
+                            data_key);
+    if (count <= limit) {
       return;
     }
 
@@ -319,7 +475,7 @@ void EventSubscriberPlugin::expireCheck() {
     LOG(WARNING) << "Expiring events for subscriber: " << getName()
                  << " (overflowed limit " << limit << ")";
     VLOG(1) << "Subscriber events " << getName() << " exceeded limit " << limit
-            << " by: " << keys.size() - limit;
+            << " by: " << count - limit;
     // Inspect the N-FLAGS_events_max -th event's value and expire before the
     // time within the content.
     std::string last_key;
@@ -328,30 +484,38 @@ void EventSubscriberPlugin::expireCheck() {
     // EID - events_max is the most last-recent event to keep.
     threshold_key = boost::lexical_cast<size_t>(last_key) - getEventsMax();
 
-    // Scan each of the keys in keys, if their ID portion is < threshold.
+    // Scan each of the keys again, if their ID portion is < threshold.
     // Nix them, this requires lots of conversions, use with care.
     std::string max_key;
     std::string min_key;
     unsigned long min_key_value = 0;
     unsigned long max_key_value = 0;
-    for (const auto& key : keys) {
-      unsigned long key_value = 0;
-      safeStrtoul(key.substr(key.rfind('.') + 1), 10, key_value);
-
-      if (key_value < static_cast<unsigned long>(threshold_key)) {
-        min_key_value = (min_key_value == 0 || key_value < min_key_value)
-                            ? key_value
-                            : min_key_value;
-        if (min_key_value == key_value) {
-          min_key = key;
-        }
-
-        max_key_value = (key_value > max_key_value) ? key_value : max_key_value;
-        if (max_key_value == key_value) {
-          max_key = key;
-        }
-      }
-    }
+    scanDatabaseKeysChunked(
+        kEvents,
+        ([&min_key, &max_key, &min_key_value, &max_key_value, threshold_key](
+            const std::vector<std::string>& keys) {
+          for (const auto& key : keys) {
+            unsigned long key_value = 0;
+            safeStrtoul(key.substr(key.rfind('.') + 1), 10, key_value);
+
+            if (key_value < static_cast<unsigned long>(threshold_key)) {
+              min_key_value = (min_key_value == 0 || key_value < min_key_value)
+                                  ? key_value
+                                  : min_key_value;
+              if (min_key_value == key_value) {
+                min_key = key;
+              }
+
+              max_key_value =
+                  (key_value > max_key_value) ? key_value : max_key_value;
+              if (max_key_value == key_value) {
+                max_key = key;
+              }
+            }
+          }
+          return true;
+        }),
+        data_key);
 
     if (!min_key.empty()) {
       if (max_key_value == min_key_value) {
@@ -394,38 +558,64 @@ std::vector<EventRecord> EventSubscriberPlugin::getRecords(
     const std::vector<std::string>& indexes, bool optimize) {
   auto record_key = "records." + dbNamespace();
 
+  // Bins strictly older than the current minute normally receive no more
+  // events; their parsed records are cached and reused across queries.
+  auto current_bin = getUnixTime() / 60;
+
   std::vector<EventRecord> records;
   for (const auto& index : indexes) {
-    std::vector<std::string> bin_records;
-    {
-      std::string record_value;
-      getDatabaseValue(kEvents, record_key + "." + index, record_value);
-      if (record_value.empty()) {
-        // There are actually no events in this bin, interesting error case.
-        continue;
+    EventTime bin = timeFromRecord(index.substr(index.find('.') + 1));
+    bool cacheable = (bin > 0 && bin + 1 < current_bin);
+
+    std::vector<EventRecord> bin_records;
+    bool from_cache = false;
+    if (cacheable) {
+      ReadLock lock(record_cache_mutex_);
+      auto hit = record_cache_.find(bin);
+      if (hit != record_cache_.end()) {
+        bin_records = hit->second;
+        from_cache = true;
       }
-
-      // Each list is tokenized into a record=event_id:time.
-      bin_records = split(record_value, ",");
     }
 
-    // Iterate over every 2 items: EID:TIME.
-    for (const auto& record : bin_records) {
-      const auto vals = split(record, ":");
-      if (vals.size() != 2) {
-        LOG(WARNING) << "Event records mismatch: " << record
-                     << " does not have a matching eid/event_time";
-        continue;
+    if (!from_cache) {
+      auto bin_prefix = record_key + "." + index + ".";
+      // One ranged scan returns the key/value pairs together; a key scan
+      // plus one point get per record is what scanDatabaseValues replaces.
+      DatabaseStringValueList bin_values;
+      scanDatabaseValues(kEvents, bin_values, bin_prefix);
+      // The EID suffix is zero-padded, lexicographic order is event order.
+      std::sort(bin_values.begin(), bin_values.end());
+
+      // Each record key is suffixed with an EID and stores the event time.
+      for (const auto& record : bin_values) {
+        auto eid = record.first.substr(bin_prefix.size());
+        const EventTime et = timeFromRecord(record.second);
+        if (et == 0) {
+          LOG(WARNING) << "Event records mismatch: " << record.first
+                       << " does not have a matching event_time";
+          continue;
+        }
+        bin_records.push_back(std::make_pair(std::move(eid), et));
       }
-      const auto eid = vals[0];
-      const EventTime et = timeFromRecord(vals[1]);
-      if (FLAGS_events_optimize && optimize && et <= optimize_time_ + 1) {
-        auto eidr = timeFromRecord(eid);
+
+      if (cacheable) {
+        WriteLock lock(record_cache_mutex_);
+        record_cache_[bin] = bin_records;
+      }
+    }
+
+    // The optimization filter depends on per-call state, so it is applied
+    // after the cache and not baked into the cached records.
+    for (auto& record : bin_records) {
+      if (FLAGS_events_optimize && optimize &&
+          record.second <= optimize_time_ + 1) {
+        auto eidr = timeFromRecord(record.first);
         if (eidr <= optimize_eid_) {
           continue;
         }
       }
-      records.push_back(std::make_pair(eid, et));
+      records.push_back(std::move(record));
     }
   }
 
@@ -434,54 +624,65 @@ std::vector<EventRecord> EventSubscriberPlugin::getRecords(
 
 Status EventSubscriberPlugin::recordEvent(const std::string& eid,
                                           EventTime et) {
-  std::string time_value = boost::lexical_cast<std::string>(et);
-
   // The record is identified by the event type then module name.
-  std::string index_key = "indexes." + dbNamespace();
-  std::string record_key = "records." + dbNamespace();
-  // The list key includes the list type (bin size) and the list ID (bin).
-  std::string list_id;
-
   // The list_id is the MOST-Specific key ID, the bin for this list.
   // If the event time was 13 and the time_list is 5 seconds, lid = 2.
-  list_id = boost::lexical_cast<std::string>(et / 60);
+  auto list_id = boost::lexical_cast<std::string>(et / 60);
 
-  WriteLock lock(event_record_lock_);
-  // Append the record (eid, unix_time) to the list bin.
-  std::string record_value;
-  getDatabaseValue(kEvents, record_key + ".60." + list_id, record_value);
-
-  if (record_value.length() == 0) {
-    // This is a new list_id for list_key, append the ID to the indirect
-    // lookup for this list_key.
-    std::string index_value;
-    getDatabaseValue(kEvents, index_key + ".60", index_value);
-    if (index_value.length() == 0) {
-      // A new index.
-      index_value = list_id;
-    } else {
-      index_value += "," + list_id;
-    }
-    setDatabaseValue(kEvents, index_key + ".60", index_value);
-    record_value = eid + ":" + time_value;
-  } else {
-    // Tokenize a record using ',' and the EID/time using ':'.
-    record_value += "," + eid + ":" + time_value;
-  }
-  auto status =
-      setDatabaseValue(kEvents, record_key + ".60." + list_id, record_value);
+  // Each record is keyed with the list type (bin size), bin, and EID, so
+  // an insert is a single write and never rewrites a neighboring record.
+  auto record_key = "records." + dbNamespace() + ".60." + list_id + "." + eid;
+  auto status = setDatabaseValue(
+      kEvents, record_key, boost::lexical_cast<std::string>(et));
   if (!status.ok()) {
     LOG(ERROR) << "Could not put Event Record key: " << record_key;
+  } else {
+    recordBin(et);
+
+    // A late event landing in an already-cached bin invalidates its cache.
+    WriteLock lock(record_cache_mutex_);
+    record_cache_.erase(et / 60);
   }
   return Status();
 }
 
+void EventSubscriberPlugin::recordBin(EventTime time) {
+  WriteLock lock(record_bins_mutex_);
+  record_bins_.insert(time / 60);
+}
+
+void EventSubscriberPlugin::migrateLegacyRecords(const std::string& key) {
+  std::string record_value;
+  getDatabaseValue(kEvents, key, record_value);
+
+  // Each legacy record is tokenized as eid:time within the joined list.
+  DatabaseStringValueList migrated;
+  for (const auto& record : split(record_value, ",")) {
+    const auto vals = split(record, ":");
+    if (vals.size() != 2) {
+      LOG(WARNING) << "Event records mismatch: " << record
+                   << " does not have a matching eid/event_time";
+      continue;
+    }
+    migrated.push_back(std::make_pair(key + '.' + vals[0], vals[1]));
+  }
+
+  // Commit the per-record keys before the list they replace is removed, so
+  // a crash between the two re-runs the migration instead of losing events.
+  if (!migrated.empty()) {
+    setDatabaseBatchValues(kEvents, migrated);
+  }
+  deleteDatabaseValue(kEvents, key);
+}
+
 size_t EventSubscriberPlugin::getEventsExpiry() {
-  return FLAGS_events_expiry;
+  size_t configured = events_expiry_override_;
+  return (configured > 0) ? configured : kEventsExpiryFlag.get();
 }
 
 size_t EventSubscriberPlugin::getEventsMax() {
-  return FLAGS_events_max;
+  size_t configured = events_max_override_;
+  return (configured > 0) ? configured : kEventsMaxFlag.get();
 }
 
 const std::string EventSubscriberPlugin::getEventID() {
@@ -511,16 +712,21 @@ const std::string EventSubscriberPlugin::getEventID() {
 
 void EventSubscriberPlugin::get(RowYield& yield,
                                 EventTime start,
-                                EventTime stop) {
+                                EventTime stop,
+                                bool metadata_only) {
+  // Commit any events still waiting in a pending batch so a query always
+  // observes every event delivered to this subscriber.
+  flushPendingEvents();
+
   // Get the records for this time range.
   auto indexes = getIndexes(start, stop);
   auto records = getRecords(indexes);
 
   std::string events_key = "data." + dbNamespace();
-  std::vector<std::string> mapped_records;
+  std::vector<EventRecord> mapped_records;
   for (const auto& record : records) {
     if (record.second >= start && (record.second <= stop || stop == 0)) {
-      mapped_records.push_back(events_key + "." + record.first);
+      mapped_records.push_back(record);
     }
   }
 
@@ -532,20 +738,52 @@ void EventSubscriberPlugin::get(RowYield& yield,
     }
   }
 
-  // Select mapped_records using event_ids as keys.
-  std::string data_value;
-  for (const auto& record : mapped_records) {
-    Row r;
-    auto status = getDatabaseValue(kEvents, record, data_value);
-    if (data_value.length() == 0) {
-      // There is no record here, interesting error case.
-      continue;
-    }
-    status = deserializeRowJSON(data_value, r);
-    data_value.clear();
-    if (status.ok()) {
+  if (metadata_only) {
+    // The query uses only index-covered columns, yield without touching the
+    // stored event data.
+    for (const auto& record : mapped_records) {
+      Row r;
+      r["eid"] = record.first;
+      r["time"] = INTEGER(record.second);
       yield(r);
     }
+  } else {
+    // Select mapped_records using event_ids as keys. Repeated overlapping
+    // window queries (dashboard refreshes) reuse rows decoded by a previous
+    // query; only the new tail is read and deserialized.
+    std::string data_value;
+    for (const auto& record : mapped_records) {
+      if (FLAGS_events_query_cache_max > 0) {
+        ReadLock lock(row_cache_mutex_);
+        auto cached = row_cache_.find(record.first);
+        if (cached != row_cache_.end()) {
+          Row r = cached->second.second;
+          yield(r);
+          continue;
+        }
+      }
+
+      Row r;
+      auto status = getDatabaseValue(
+          kEvents, events_key + "." + record.first, data_value);
+      if (data_value.length() == 0) {
+        // There is no record here, interesting error case.
+        continue;
+      }
+      status = deserializeRowJSON(data_value, r);
+      data_value.clear();
+      if (status.ok()) {
+        if (FLAGS_events_query_cache_max > 0) {
+          WriteLock lock(row_cache_mutex_);
+          row_cache_[record.first] = std::make_pair(record.second, r);
+          // EventIDs are zero-padded, so the map front is the oldest event.
+          while (row_cache_.size() > FLAGS_events_query_cache_max) {
+            row_cache_.erase(row_cache_.begin());
+          }
+        }
+        yield(r);
+      }
+    }
   }
 
   auto expiry = getEventsExpiry();
@@ -560,6 +798,15 @@ void EventSubscriberPlugin::get(RowYield& yield,
     // Index retrieval will apply the constraints checking and auto-expire.
     expire_time_ = getUnixTime() - expiry;
     expire_time_ = expire_time_ - (expire_time_ % 60);
+
+    // Drop cached rows that have aged out of the retention window.
+    if (FLAGS_events_query_cache_max > 0) {
+      WriteLock lock(row_cache_mutex_);
+      auto it = row_cache_.begin();
+      while (it != row_cache_.end() && it->second.first < expire_time_) {
+        it = row_cache_.erase(it);
+      }
+    }
   }
 
   if (FLAGS_events_optimize) {
@@ -567,14 +814,218 @@ void EventSubscriberPlugin::get(RowYield& yield,
   }
 }
 
+Status EventSubscriberPlugin::flushPendingEvents() {
+  std::vector<Row> ready;
+  {
+    WriteLock lock(pending_events_mutex_);
+    ready = std::move(pending_events_);
+    pending_events_.clear();
+  }
+
+  if (ready.empty()) {
+    return Status(0, "OK");
+  }
+
+  auto status = addBatch(ready);
+  if (status.ok() && journal_ != nullptr) {
+    // The drained rows are durable in the backing store; rows buffered while
+    // the batch was committing are re-journaled so the truncate cannot drop
+    // them.
+    WriteLock lock(pending_events_mutex_);
+    journal_->reset();
+    for (const auto& r : pending_events_) {
+      journalRow(r);
+    }
+  }
+  return status;
+}
+
+Status EventSubscriberPlugin::flushOverdueEvents() {
+  {
+    WriteLock lock(pending_events_mutex_);
+    if (pending_events_.empty() ||
+        monotonicMilliseconds() - pending_since_ < FLAGS_events_batch_latency) {
+      return Status(0, "OK");
+    }
+  }
+  return flushPendingEvents();
+}
+
+Status EventSubscriberPlugin::journalRow(const Row& r) {
+  if (journal_ == nullptr) {
+    auto journal = std::make_shared<EventJournal>();
+    auto status =
+        journal->open(FLAGS_database_path + "." + dbNamespace() + ".journal");
+    if (!status.ok()) {
+      VLOG(1) << "Cannot open events journal for " << dbNamespace() << ": "
+              << status.getMessage();
+      return status;
+    }
+    journal_ = journal;
+  }
+
+  std::string data;
+  auto status = serializeRowJSON(r, data);
+  if (!status.ok()) {
+    return status;
+  }
+  if (data.size() > 0 && data.back() == '\n') {
+    data.pop_back();
+  }
+  return journal_->append(data);
+}
+
+Status EventSubscriberPlugin::replayJournal() {
+  if (!FLAGS_events_journal) {
+    return Status(0, "OK");
+  }
+
+  {
+    WriteLock lock(pending_events_mutex_);
+    if (journal_ == nullptr) {
+      auto journal = std::make_shared<EventJournal>();
+      auto status =
+          journal->open(FLAGS_database_path + "." + dbNamespace() + ".journal");
+      if (!status.ok()) {
+        return status;
+      }
+      journal_ = journal;
+    }
+  }
+
+  std::vector<std::string> records;
+  auto status = journal_->replay(records);
+  if (!status.ok() || records.empty()) {
+    return status;
+  }
+
+  std::vector<Row> recovered;
+  recovered.reserve(records.size());
+  for (const auto& data : records) {
+    Row r;
+    if (deserializeRowJSON(data, r).ok()) {
+      recovered.push_back(std::move(r));
+    }
+  }
+
+  VLOG(1) << "Replaying " << recovered.size() << " journaled events into "
+          << dbNamespace();
+  status = addBatch(recovered);
+  if (status.ok()) {
+    WriteLock lock(pending_events_mutex_);
+    journal_->reset();
+  }
+  return status;
+}
+
+/**
+ * @brief Hash the signal columns of an event row.
+ *
+ * Per-event stamps (time, eid, uptime) differ on every otherwise-identical
+ * row and are excluded, so a storm of repeated events collapses to one hash.
+ */
+static uint64_t eventRowHash(const Row& r) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (const auto& column : r) {
+    if (column.first == "time" || column.first == "eid" ||
+        column.first == "uptime") {
+      continue;
+    }
+    for (const char byte : column.first) {
+      hash ^= static_cast<uint64_t>(static_cast<unsigned char>(byte));
+      hash *= 0x100000001b3ULL;
+    }
+    hash ^= 0x1fULL;
+    hash *= 0x100000001b3ULL;
+    for (const char byte : column.second) {
+      hash ^= static_cast<uint64_t>(static_cast<unsigned char>(byte));
+      hash *= 0x100000001b3ULL;
+    }
+    hash ^= 0x1fULL;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+bool EventSubscriberPlugin::deduplicateEvent(Row& r, EventTime event_time) {
+  if (FLAGS_events_dedup_window == 0) {
+    return false;
+  }
+
+  // The hash is computed before any annotation so that rows arriving during
+  // the reopened window still match the stored entry.
+  auto hash = eventRowHash(r);
+
+  WriteLock lock(dedup_windows_mutex_);
+  auto& entry = dedup_windows_[hash];
+  if (entry.start > 0 &&
+      event_time < entry.start + FLAGS_events_dedup_window) {
+    // An identical row was recorded within the window: count and drop.
+    entry.suppressed++;
+    return true;
+  }
+
+  if (entry.suppressed > 0) {
+    // The storm magnitude survives into storage and the logger pipeline on
+    // the row that reopens the window.
+    r["suppressed"] = std::to_string(entry.suppressed);
+  }
+  entry.start = event_time;
+  entry.suppressed = 0;
+
+  if (dedup_windows_.size() > 4096) {
+    // Bound the tracking state by dropping windows that have since closed.
+    // The entry just refreshed cannot qualify: event_time is inside it.
+    for (auto it = dedup_windows_.begin(); it != dedup_windows_.end();) {
+      if (event_time >= it->second.start + FLAGS_events_dedup_window) {
+        it = dedup_windows_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  return false;
+}
+
 Status EventSubscriberPlugin::add(Row& r, EventTime event_time) {
-  // Get and increment the EID for this module.
-  const std::string eid = getEventID();
   // Without encouraging a missing event time, do not support a 0-time.
   if (event_time == 0) {
     event_time = getUnixTime();
   }
 
+  if (deduplicateEvent(r, event_time)) {
+    return Status(0, "OK");
+  }
+
+  if (FLAGS_events_batch_size > 1) {
+    // Group-commit mode: accumulate the row in memory, stamped with its own
+    // event time, and write the whole batch when either the size or latency
+    // bound is reached. The latency bound limits crash-loss exposure.
+    r["time"] = std::to_string(event_time);
+    bool flush = false;
+    {
+      WriteLock lock(pending_events_mutex_);
+      // Journal-first: the row is recoverable before it waits in memory.
+      if (FLAGS_events_journal) {
+        journalRow(r);
+      }
+      if (pending_events_.empty()) {
+        pending_since_ = monotonicMilliseconds();
+      }
+      pending_events_.push_back(std::move(r));
+      flush = (pending_events_.size() >= FLAGS_events_batch_size ||
+               monotonicMilliseconds() - pending_since_ >=
+                   FLAGS_events_batch_latency);
+    }
+    if (flush) {
+      return flushPendingEvents();
+    }
+    return Status(0, "OK");
+  }
+
+  // Get and increment the EID for this module.
+  const std::string eid = getEventID();
+
   r["time"] = std::to_string(event_time);
   r["eid"] = eid;
   // Serialize and store the row data, for query-time retrieval.
@@ -587,6 +1038,7 @@ Status EventSubscriberPlugin::add(Row& r, EventTime event_time) {
   if (data.size() > 0 && data.back() == '\n') {
     data.pop_back();
   }
+  TRACK_ALLOCATION("event_row", data.size());
 
   // Use the last EventID and a checkpoint bucket size to periodically apply
   // buffer eviction. Eviction occurs if the total count exceeds events_max.
@@ -607,6 +1059,87 @@ Status EventSubscriberPlugin::add(Row& r, EventTime event_time) {
   return status;
 }
 
+Status EventSubscriberPlugin::addBatch(std::vector<Row>& row_list) {
+  if (row_list.empty()) {
+    return Status(0, "OK");
+  }
+
+  auto event_time = getUnixTime();
+
+  DatabaseStringValueList batch;
+  batch.reserve(row_list.size() * 2);
+
+  std::set<EventTime> bins;
+  size_t written = 0;
+
+  for (auto& r : row_list) {
+    // Rows buffered by the group-commit path arrive with their own event
+    // time, others are stamped with the commit time.
+    EventTime row_time = event_time;
+    if (r.count("time") > 0) {
+      unsigned long int requested_time = 0;
+      safeStrtoul(r.at("time"), 10, requested_time);
+      if (requested_time > 0) {
+        row_time = requested_time;
+      }
+    }
+
+    // Drop storm duplicates before an EID is consumed for the row.
+    if (deduplicateEvent(r, row_time)) {
+      continue;
+    }
+
+    const auto eid = getEventID();
+    auto list_id = boost::lexical_cast<std::string>(row_time / 60);
+    auto time_value = boost::lexical_cast<std::string>(row_time);
+    bins.insert(row_time / 60);
+    r["time"] = time_value;
+    r["eid"] = eid;
+
+    // Serialize and store the row data, for query-time retrieval.
+    std::string data;
+    auto status = serializeRowJSON(r, data);
+    if (!status.ok()) {
+      return status;
+    }
+    // Then remove the newline.
+    if (data.size() > 0 && data.back() == '\n') {
+      data.pop_back();
+    }
+    TRACK_ALLOCATION("event_row", data.size());
+
+    // Logger plugins may request events to be forwarded directly.
+    // If no active logger is marked 'usesLogEvent' then this is a no-op.
+    EventFactory::forwardEvent(data);
+
+    // The event data and its indexing record commit in one batch below.
+    batch.push_back(std::make_pair("data." + dbNamespace() + "." + eid, data));
+    batch.push_back(std::make_pair(
+        "records." + dbNamespace() + ".60." + list_id + "." + eid,
+        time_value));
+    written++;
+  }
+
+  if (batch.empty()) {
+    // Every row in the batch was suppressed as a duplicate.
+    return Status(0, "OK");
+  }
+
+  // Use the last EventID and a checkpoint bucket size to periodically apply
+  // buffer eviction. Eviction occurs if the total count exceeds events_max.
+  if (last_eid_ % EVENTS_CHECKPOINT < written) {
+    expireCheck();
+  }
+
+  auto status = setDatabaseBatchValues(kEvents, batch);
+  if (status.ok()) {
+    WriteLock lock(record_bins_mutex_);
+    record_bins_.insert(bins.begin(), bins.end());
+  }
+  event_count_ += written;
+  return status;
+}
+
 EventPublisherRef EventSubscriberPlugin::getPublisher() const {
   return EventFactory::getEventPublisher(getType());
 }
@@ -622,6 +1155,27 @@ void EventSubscriberPlugin::removeSubscriptions() {
   getPublisher()->removeSubscriptions(getName());
 }
 
+/// Check the events configuration for publishers exempt from on-demand.
+static bool publisherAlwaysOn(const std::string& type_id) {
+  auto plugin = Config::get().getParser("events");
+  if (plugin == nullptr || plugin.get() == nullptr) {
+    return false;
+  }
+
+  const auto& data = plugin->getData().doc();
+  if (!data.HasMember("events") ||
+      !data["events"].HasMember("always_on_publishers")) {
+    return false;
+  }
+
+  for (const auto& item : data["events"]["always_on_publishers"].GetArray()) {
+    if (item.GetString() == type_id) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void EventFactory::delay() {
   // Caller may disable event publisher threads.
   if (FLAGS_disable_events) {
@@ -632,12 +1186,54 @@ void EventFactory::delay() {
   auto& ef = EventFactory::getInstance();
   for (const auto& publisher : EventFactory::getInstance().event_pubs_) {
     // Publishers that did not set up correctly are put into an ending state.
-    if (!publisher.second->isEnding()) {
-      auto thread_ = std::make_shared<std::thread>(
-          std::bind(&EventFactory::run, publisher.first));
-      ef.threads_.push_back(thread_);
+    if (publisher.second->isEnding()) {
+      continue;
+    }
+
+    if (FLAGS_events_on_demand && publisher.second->numSubscriptions() == 0 &&
+        !publisherAlwaysOn(publisher.first)) {
+      // No attached subscriber demands this publisher; defer the run loop
+      // (and its kernel subscriptions) until a subscription arrives.
+      VLOG(1) << "Deferring event publisher until first subscription: "
+              << publisher.first;
+      continue;
+    }
+
+    auto thread_ = std::make_shared<std::thread>(
+        std::bind(&EventFactory::run, publisher.first));
+    ef.threads_.push_back(thread_);
+  }
+  ef.activated_ = true;
+}
+
+void EventFactory::startPublisher(const std::string& type_id) {
+  auto& ef = EventFactory::getInstance();
+  WriteLock lock(ef.factory_lock_);
+  if (!ef.activated_ || ef.event_pubs_.count(type_id) == 0) {
+    // The initializer spawns the initial run loops; nothing to do early.
+    return;
+  }
+
+  auto& publisher = ef.event_pubs_.at(type_id);
+  if (publisher->isEnding() || publisher->hasStarted()) {
+    return;
+  }
+
+  if (publisher->state() == EventState::EVENT_NONE) {
+    // A quiesced publisher tore down its OS-facing state, set up again.
+    auto status = publisher->setUp();
+    if (!status.ok()) {
+      LOG(INFO) << "Event publisher not enabled: " << type_id << ": "
+                << status.what();
+      publisher->isEnding(true);
+      return;
     }
+    publisher->state(EventState::EVENT_SETUP);
   }
+
+  auto thread_ =
+      std::make_shared<std::thread>(std::bind(&EventFactory::run, type_id));
+  ef.threads_.push_back(thread_);
 }
 
 Status EventPublisherPlugin::addSubscription(
@@ -646,19 +1242,29 @@ Status EventPublisherPlugin::addSubscription(
   // subscriptions will be walked.
   WriteLock lock(subscription_lock_);
   subscriptions_.push_back(subscription);
+  if (subscription->context != nullptr) {
+    // Index by subscription context for targeted event dispatch.
+    subscription_index_[subscription->context.get()].push_back(subscription);
+  }
   return Status(0);
 }
 
 void EventPublisherPlugin::removeSubscriptions(const std::string& subscriber) {
   // See addSubscription for details on the critical section.
   WriteLock lock(subscription_lock_);
-  auto end =
-      std::remove_if(subscriptions_.begin(),
-                     subscriptions_.end(),
-                     [&subscriber](const SubscriptionRef& subscription) {
-                       return (subscription->subscriber_name == subscriber);
-                     });
+  auto pred = [&subscriber](const SubscriptionRef& subscription) {
+    return (subscription->subscriber_name == subscriber);
+  };
+  auto end = std::remove_if(subscriptions_.begin(), subscriptions_.end(), pred);
   subscriptions_.erase(end, subscriptions_.end());
+
+  for (auto it = subscription_index_.begin();
+       it != subscription_index_.end();) {
+    auto& indexed = it->second;
+    indexed.erase(std::remove_if(indexed.begin(), indexed.end(), pred),
+                  indexed.end());
+    it = indexed.empty() ? subscription_index_.erase(it) : std::next(it);
+  }
 }
 
 void EventFactory::addForwarder(const std::string& logger) {
@@ -667,10 +1273,48 @@ void EventFactory::addForwarder(const std::string& logger) {
 
 void EventFactory::forwardEvent(const std::string& event) {
   for (const auto& logger : getInstance().loggers_) {
-    Registry::call("logger", logger, {{"event", event}});
+    if (Registry::get().exists("logger", logger, true)) {
+      // In-process loggers are called directly, the per-event string map is
+      // only marshalled for loggers within extensions.
+      auto plugin = Registry::get().plugin("logger", logger);
+      auto logger_plugin = std::dynamic_pointer_cast<LoggerPlugin>(plugin);
+      logger_plugin->logEvent(event);
+    } else {
+      Registry::call("logger", logger, {{"event", event}});
+    }
   }
 }
 
+/**
+ * @brief Background sweep applying subscriber retention limits.
+ *
+ * Retention is normally enforced at write checkpoints and query time, so a
+ * subscriber that stops receiving events and is not queried holds its
+ * buffered events indefinitely. When --events_expiry_interval is set this
+ * service periodically runs each subscriber's expireCheck, which performs
+ * ordered range deletes over only the bins that fall out of retention.
+ */
+class EventsExpiryRunner : public InternalRunnable {
+ public:
+  EventsExpiryRunner() : InternalRunnable("EventsExpiryRunner") {}
+
+  void start() override {
+    while (!interrupted()) {
+      pauseMilli(FLAGS_events_expiry_interval * 1000);
+      if (interrupted()) {
+        break;
+      }
+
+      for (const auto& name : EventFactory::subscriberNames()) {
+        auto subscriber = EventFactory::getEventSubscriber(name);
+        if (subscriber != nullptr) {
+          subscriber->expireCheck();
+        }
+      }
+    }
+  }
+};
+
 void EventFactory::configUpdate() {
   // Scan the schedule for queries that touch "_events" tables.
   // We will count the queries
@@ -724,6 +1368,46 @@ void EventFactory::configUpdate() {
     subscriber->queries_.clear();
   }
 
+  /*
+   * The "events" config key may declare a "retention" dictionary keyed by
+   * subscriber name, each entry overriding events_expiry or events_max for
+   * that subscriber only. Overrides are reapplied in full on every update so
+   * removing an entry restores the global flags.
+   */
+  auto parser = Config::getParser("events");
+  if (parser != nullptr && parser.get() != nullptr) {
+    const auto& data = parser->getData().doc();
+    WriteLock lock(ef.factory_lock_);
+    for (auto& subscriber : ef.event_subs_) {
+      size_t expiry = 0;
+      size_t max = 0;
+      if (data["events"].HasMember("retention") &&
+          data["events"]["retention"].IsObject()) {
+        const auto& retention = data["events"]["retention"];
+        auto entry = retention.FindMember(subscriber.first.c_str());
+        if (entry != retention.MemberEnd() && entry->value.IsObject()) {
+          if (entry->value.HasMember("events_expiry") &&
+              entry->value["events_expiry"].IsUint64()) {
+            expiry = entry->value["events_expiry"].GetUint64();
+          }
+          if (entry->value.HasMember("events_max") &&
+              entry->value["events_max"].IsUint64()) {
+            max = entry->value["events_max"].GetUint64();
+          }
+        }
+      }
+      subscriber.second->events_expiry_override_ = expiry;
+      subscriber.second->events_max_override_ = max;
+    }
+  }
+
+  if (!FLAGS_disable_events && FLAGS_events_expiry_interval > 0) {
+    static std::once_flag expiry_service;
+    std::call_once(expiry_service, []() {
+      Dispatcher::addService(std::make_shared<EventsExpiryRunner>());
+    });
+  }
+
   // If events are enabled configure the subscribers before publishers.
   if (!FLAGS_disable_events) {
     RegistryFactory::get().registry("event_subscriber")->configure();
@@ -750,20 +1434,49 @@ Status EventFactory::run(const std::string& type_id) {
 
   if (publisher == nullptr) {
     return Status(1, "Event publisher is missing");
-  } else if (publisher->hasStarted()) {
+  } else if (!publisher->markStarted()) {
     return Status(1, "Cannot restart an event publisher");
   }
   VLOG(1) << "Starting event publisher run loop: " + type_id;
-  publisher->hasStarted(true);
+
+  // On-demand publishers quiesce if they run without subscribers.
+  bool quiesce = FLAGS_events_on_demand && FLAGS_events_on_demand_idle > 0 &&
+                 !publisherAlwaysOn(type_id);
+  size_t idle_since = 0;
+  bool quiesced = false;
 
   auto status = Status(0, "OK");
   while (!publisher->isEnding()) {
+    if (quiesce) {
+      if (publisher->numSubscriptions() == 0) {
+        if (idle_since == 0) {
+          idle_since = getUnixTime();
+        } else if (getUnixTime() - idle_since >= FLAGS_events_on_demand_idle) {
+          VLOG(1) << "Quiescing idle event publisher: " << type_id;
+          quiesced = true;
+          break;
+        }
+      } else {
+        idle_since = 0;
+      }
+    }
     // Can optionally implement a global cooloff latency here.
     status = publisher->run();
     if (!status.ok()) {
       break;
     }
     publisher->restart_count_++;
+    if (FLAGS_events_batch_size > 1) {
+      // Drain subscriber batches that hit their latency bound while this
+      // publisher idled, so no event waits on the next add.
+      auto& ef = EventFactory::getInstance();
+      WriteLock lock(ef.factory_lock_);
+      for (const auto& subscriber : ef.event_subs_) {
+        if (subscriber.second->getType() == type_id) {
+          subscriber.second->flushOverdueEvents();
+        }
+      }
+    }
     // This is a 'default' cool-off implemented in InterruptableRunnable.
     // If a publisher fails to perform some sort of interruption point, this
     // prevents the thread from thrashing through exiting checks.
@@ -778,6 +1491,15 @@ Status EventFactory::run(const std::string& type_id) {
   publisher->tearDown();
   publisher->state(EventState::EVENT_NONE);
 
+  if (quiesced && !publisher->isEnding()) {
+    // A quiesced (not ending) publisher may restart on a new subscription.
+    publisher->hasStarted(false);
+    if (publisher->numSubscriptions() > 0) {
+      // A subscription raced the quiesce decision; restart on its behalf.
+      startPublisher(type_id);
+    }
+  }
+
   // Do not remove the publisher from the event factory.
   // If the event factory's `end` method was called these publishers will be
   // cleaned up after their thread context is removed; otherwise, a removed
@@ -837,6 +1559,20 @@ Status EventFactory::registerEventPublisher(const PluginRef& pub) {
       specialized_pub->isEnding(true);
       return status;
     }
+
+    // A previous process may have persisted warm-restart state. The state is
+    // a one-shot hint: remove it before restoring so a failed restore cannot
+    // repeat on the next registration.
+    std::string state;
+    getDatabaseValue(kEvents, kPublisherStatePrefix + type_id, state);
+    if (!state.empty()) {
+      deleteDatabaseValue(kEvents, kPublisherStatePrefix + type_id);
+      auto restore = specialized_pub->restoreState(state);
+      if (!restore.ok()) {
+        VLOG(1) << "Event publisher " << type_id
+                << " could not restore state: " << restore.getMessage();
+      }
+    }
   }
 
   return Status(0, "OK");
@@ -902,6 +1638,8 @@ Status EventFactory::registerEventSubscriber(const PluginRef& sub) {
   // Let the subscriber initialize any Subscriptions.
   if (!FLAGS_disable_events && !specialized_sub->disabled) {
     specialized_sub->expireCheck();
+    // Recover journaled events from a previous process before new arrivals.
+    specialized_sub->replayJournal();
     status = specialized_sub->init();
     specialized_sub->state(EventState::EVENT_RUNNING);
   } else {
@@ -939,7 +1677,12 @@ Status EventFactory::addSubscription(const std::string& type_id,
   }
 
   // The event factory is responsible for configuring the event types.
-  return publisher->addSubscription(subscription);
+  auto status = publisher->addSubscription(subscription);
+  if (status.ok() && FLAGS_events_on_demand && !FLAGS_disable_events) {
+    // The first subscription starts a deferred or quiesced publisher.
+    startPublisher(type_id);
+  }
+  return status;
 }
 
 size_t EventFactory::numSubscriptions(const std::string& type_id) {
@@ -990,6 +1733,13 @@ Status EventFactory::deregisterEventPublisher(const std::string& type_id) {
   }
 
   if (!FLAGS_disable_events) {
+    // Offer warm-restart state to the publisher started by a replacement
+    // process, while the OS-facing handles and maps are still intact.
+    std::string state;
+    if (publisher->serializeState(state).ok() && !state.empty()) {
+      setDatabaseValue(kEvents, kPublisherStatePrefix + type_id, state);
+    }
+
     publisher->isEnding(true);
     if (!publisher->hasStarted()) {
       // If a publisher's run loop was not started, call tearDown since
@@ -14,6 +14,8 @@
 #include <unistd.h>
 
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 #include <boost/utility/string_ref.hpp>
@@ -27,6 +29,14 @@
 #include "osquery/tables/events/linux/process_file_events.h"
 #include "osquery/tables/events/linux/socket_events.h"
 
+namespace osquery {
+// External flags; they are used to determine which rules need to be installed
+DECLARE_bool(audit_allow_fim_events);
+DECLARE_bool(audit_allow_process_events);
+DECLARE_bool(audit_allow_sockets);
+DECLARE_bool(audit_allow_user_events);
+} // namespace osquery
+
 namespace {
 bool ShouldHandle(const audit_reply& reply) noexcept {
   switch (reply.type) {
@@ -46,6 +56,40 @@ bool ShouldHandle(const audit_reply& reply) noexcept {
     return true;
   }
 }
+
+/**
+ * @brief Early-drop policy applied before the field tokenizer runs.
+ *
+ * Only record types consumed by an enabled subscriber are worth parsing;
+ * everything else (PROCTITLE being the most frequent) would be tokenized
+ * and attached to the event trace just to be ignored downstream.
+ */
+bool IsInterestingRecord(const audit_reply& reply) noexcept {
+  switch (reply.type) {
+  case AUDIT_SYSCALL:
+  case AUDIT_EOE:
+    return true;
+
+  case AUDIT_CWD:
+  case AUDIT_PATH:
+  case AUDIT_EXECVE:
+    return osquery::FLAGS_audit_allow_process_events ||
+           osquery::FLAGS_audit_allow_fim_events;
+
+  case AUDIT_MMAP:
+    return osquery::FLAGS_audit_allow_fim_events;
+
+  case AUDIT_SOCKADDR:
+    return osquery::FLAGS_audit_allow_sockets;
+
+  case AUDIT_FIRST_USER_MSG ... AUDIT_LAST_USER_MSG:
+  case AUDIT_FIRST_USER_MSG2 ... AUDIT_LAST_USER_MSG2:
+    return osquery::FLAGS_audit_allow_user_events;
+
+  default:
+    return false;
+  }
+}
 } // namespace
 
 namespace osquery {
@@ -74,11 +118,7 @@ FLAG(bool,
      false,
      "Configure the audit subsystem from scratch");
 
-// External flags; they are used to determine which rules need to be installed
-DECLARE_bool(audit_allow_fim_events);
-DECLARE_bool(audit_allow_process_events);
-DECLARE_bool(audit_allow_sockets);
-DECLARE_bool(audit_allow_user_events);
+constexpr std::size_t AuditdRecordRing::kCapacity;
 
 enum AuditStatus {
   AUDIT_DISABLED = 0,
@@ -270,16 +310,24 @@ bool AuditdNetlinkReader::acquireMessages() noexcept {
   }
 
   if (events_received != 0) {
-    std::unique_lock<std::mutex> lock(
-        auditd_context_->unprocessed_records_mutex);
+    // Hand the records to the parser through the lock-free ring; never block
+    // on the parser, drop and account instead so the netlink keeps draining.
+    size_t dropped_records = 0U;
+    for (size_t i = 0U; i < events_received; i++) {
+      if (!auditd_context_->unprocessed_records.push(read_buffer_[i])) {
+        dropped_records++;
+      }
+    }
 
-    auditd_context_->unprocessed_records.reserve(
-        auditd_context_->unprocessed_records.size() + events_received);
+    auditd_context_->enqueued_record_count +=
+        events_received - dropped_records;
 
-    auditd_context_->unprocessed_records.insert(
-        auditd_context_->unprocessed_records.end(),
-        read_buffer_.begin(),
-        std::next(read_buffer_.begin(), events_received));
+    if (dropped_records != 0U) {
+      auditd_context_->dropped_record_count += dropped_records;
+      VLOG(1) << "The audit record ring is full; " << dropped_records
+              << " records dropped ("
+              << auditd_context_->dropped_record_count.load() << " total)";
+    }
 
     auditd_context_->unprocessed_records_cv.notify_all();
   }
@@ -338,11 +386,40 @@ bool AuditdNetlinkReader::configureAuditService() noexcept {
 
   // Attempt to add each one of the rules we collected
   for (int syscall_number : monitored_syscall_list_) {
-    audit_rule_data rule = {};
-    audit_rule_syscall_data(&rule, syscall_number);
+    auto rule =
+        static_cast<audit_rule_data*>(std::calloc(1, sizeof(audit_rule_data)));
+    if (rule == nullptr) {
+      return false;
+    }
+
+    audit_rule_syscall_data(rule, syscall_number);
+
+    // Compile the unconditional userspace drops into the kernel rule: the
+    // publisher discards records from osquery itself and failed syscalls,
+    // so filter them before the kernel emits the records at all. Fieldpair
+    // errors leave the plain per-syscall rule in place.
+    auto self_filter = "pid!=" + std::to_string(getpid());
+    if (audit_rule_fieldpair_data(
+            &rule, self_filter.c_str(), AUDIT_FILTER_EXIT) < 0 &&
+        FLAGS_audit_debug) {
+      std::cout << "Could not add the pid exclusion to the audit rule for "
+                << "syscall " << syscall_number << std::endl;
+    }
+
+    if (audit_rule_fieldpair_data(&rule, "success=1", AUDIT_FILTER_EXIT) < 0 &&
+        FLAGS_audit_debug) {
+      std::cout << "Could not add the success filter to the audit rule for "
+                << "syscall " << syscall_number << std::endl;
+    }
+
+    // Keep a serialized copy so the variable-length rule can be removed on
+    // exit through the raw AUDIT_DEL_RULE path.
+    auto rule_size = sizeof(audit_rule_data) + rule->buflen;
+    AuditRuleDataObject rule_object(rule_size);
+    std::memcpy(rule_object.data(), rule, rule_size);
 
     // clang-format off
-    int rule_add_error = audit_add_rule_data(audit_netlink_handle_, &rule,
+    int rule_add_error = audit_add_rule_data(audit_netlink_handle_, rule,
       // We want to be notified when we exit from the syscall
       AUDIT_FILTER_EXIT,
 
@@ -351,6 +428,8 @@ bool AuditdNetlinkReader::configureAuditService() noexcept {
     );
     // clang-format on
 
+    std::free(rule);
+
     // When exiting, don't remove the rules that were already installed, unless
     // we have been asked to
     if (rule_add_error >= 0) {
@@ -359,7 +438,7 @@ bool AuditdNetlinkReader::configureAuditService() noexcept {
                   << std::endl;
       }
 
-      installed_rule_list_.push_back(rule);
+      installed_rule_list_.push_back(rule_object);
       continue;
     }
 
@@ -369,7 +448,7 @@ bool AuditdNetlinkReader::configureAuditService() noexcept {
     }
 
     if (FLAGS_audit_force_unconfigure) {
-      installed_rule_list_.push_back(rule);
+      installed_rule_list_.push_back(rule_object);
     }
 
     rule_add_error = -rule_add_error;
@@ -544,9 +623,8 @@ void AuditdNetlinkReader::restoreAuditServiceConfiguration() noexcept {
   // Remove the rules we have added
   VLOG(1) << "Uninstalling the audit rules we have installed";
 
-  for (auto& rule : installed_rule_list_) {
-    audit_delete_rule_data(
-        audit_netlink_handle_, &rule, AUDIT_FILTER_EXIT, AUDIT_ALWAYS);
+  for (const auto& rule_object : installed_rule_list_) {
+    deleteAuditRule(rule_object);
   }
 
   installed_rule_list_.clear();
@@ -664,17 +742,20 @@ void AuditdNetlinkParser::start() {
     std::vector<audit_reply> queue;
 
     {
+      // The mutex only serializes the wakeup; records move through the ring
+      // without locking. Poll with a timeout so a missed notification can
+      // never stall the parser.
       std::unique_lock<std::mutex> lock(
           auditd_context_->unprocessed_records_mutex);
 
       while (auditd_context_->unprocessed_records.empty() && !interrupted()) {
-        auditd_context_->unprocessed_records_cv.wait(lock);
+        auditd_context_->unprocessed_records_cv.wait_for(
+            lock, std::chrono::seconds(1));
       }
-
-      queue = std::move(auditd_context_->unprocessed_records);
-      auditd_context_->unprocessed_records.clear();
     }
 
+    auditd_context_->unprocessed_records.pop(queue);
+
     std::vector<AuditEventRecord> audit_event_record_queue;
 
     for (auto& reply : queue) {
@@ -709,6 +790,12 @@ void AuditdNetlinkParser::start() {
         continue;
       }
 
+      // Drop record types that no enabled subscriber consumes before paying
+      // for the full field tokenization.
+      if (!IsInterestingRecord(reply)) {
+        continue;
+      }
+
       // Parse the audit record body and store it into our queue
       AuditEventRecord audit_event_record = {};
       if (!ParseAuditReply(reply, audit_event_record)) {
@@ -14,6 +14,7 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <future>
 #include <map>
 #include <memory>
@@ -48,21 +49,78 @@ struct AuditEventRecord final {
   std::map<std::string, std::string> fields;
 };
 
+/// A bounded, lock-free, single-producer/single-consumer record queue used
+/// between the netlink reader and the record parser. The reader never blocks
+/// on the parser; when the ring is full the record is dropped and counted.
+class AuditdRecordRing final : private boost::noncopyable {
+ public:
+  /// Ring capacity; must be a power of two.
+  static constexpr std::size_t kCapacity{4096U};
+
+  AuditdRecordRing() : slots_(kCapacity) {}
+
+  /// Producer only: enqueues one record, returning false if the ring is full.
+  bool push(const audit_reply& reply) noexcept {
+    auto head = head_.load(std::memory_order_relaxed);
+    auto tail = tail_.load(std::memory_order_acquire);
+    if (head - tail >= kCapacity) {
+      return false;
+    }
+
+    slots_[head & (kCapacity - 1)] = reply;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Consumer only: drains every pending record into the given queue.
+  std::size_t pop(std::vector<audit_reply>& queue) noexcept {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    auto head = head_.load(std::memory_order_acquire);
+
+    std::size_t count = 0U;
+    for (; tail != head; tail++, count++) {
+      queue.push_back(slots_[tail & (kCapacity - 1)]);
+    }
+
+    tail_.store(tail, std::memory_order_release);
+    return count;
+  }
+
+  /// Returns true if no records are pending.
+  bool empty() const noexcept {
+    return head_.load(std::memory_order_acquire) ==
+           tail_.load(std::memory_order_acquire);
+  }
+
+ private:
+  /// Preallocated record storage.
+  std::vector<audit_reply> slots_;
+
+  /// Next write slot, only advanced by the producer.
+  std::atomic<std::size_t> head_{0U};
+
+  /// Next read slot, only advanced by the consumer.
+  std::atomic<std::size_t> tail_{0U};
+};
+
 // This structure is used to share data between the reading and processing
 // services
 struct AuditdContext final {
-  /// Unprocessed audit records
-  std::vector<audit_reply> unprocessed_records;
-  static_assert(
-      std::is_move_constructible<decltype(unprocessed_records)>::value,
-      "not move constructible");
+  /// Unprocessed audit records, shared without locking
+  AuditdRecordRing unprocessed_records;
 
-  /// Mutex for the list of unprocessed records
+  /// Mutex for the unprocessed records wakeup; the ring itself is lock-free
   std::mutex unprocessed_records_mutex;
 
   /// Processed events condition variable
   std::condition_variable unprocessed_records_cv;
 
+  /// Records dropped because the parser could not keep up (ring was full)
+  std::atomic<std::uint64_t> dropped_record_count{0U};
+
+  /// Records handed to the parser through the ring
+  std::atomic<std::uint64_t> enqueued_record_count{0U};
+
   /// This queue contains processed events
   std::vector<AuditEventRecord> processed_events;
 
@@ -113,8 +171,10 @@ class AuditdNetlinkReader final : public InternalRunnable {
   /// Read buffer used when receiving events from the netlink
   std::vector<audit_reply> read_buffer_;
 
-  /// The set of rules we applied (and that we'll uninstall when exiting)
-  std::vector<audit_rule_data> installed_rule_list_;
+  /// The set of rules we applied (and that we'll uninstall when exiting).
+  /// Rules carry fieldpair filters, so they are stored as serialized,
+  /// variable-length rule objects.
+  std::vector<AuditRuleDataObject> installed_rule_list_;
 
   /// The syscalls we are listening for
   std::set<int> monitored_syscall_list_;
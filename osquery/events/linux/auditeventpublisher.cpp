@@ -45,6 +45,8 @@ bool IsPublisherEnabled() noexcept {
 
 std::string AuditEventPublisher::executable_path_;
 
+std::atomic<std::uint64_t> AuditEventPublisher::orphaned_event_count_{0U};
+
 Status AuditEventPublisher::setUp() {
   if (!IsPublisherEnabled()) {
     return Status(1, "Publisher disabled via configuration");
@@ -120,6 +122,7 @@ void AuditEventPublisher::ProcessEvents(
     } else if (audit_event_record.type == AUDIT_SYSCALL) {
       if (audit_event_it != trace_context.end()) {
         VLOG(1) << "Received a duplicated event.";
+        orphaned_event_count_++;
         trace_context.erase(audit_event_it);
       }
 
@@ -231,11 +234,9 @@ void AuditEventPublisher::ProcessEvents(
         continue;
       }
 
-      auto completed_audit_event = audit_event_it->second;
+      event_context->audit_events.push_back(std::move(audit_event_it->second));
       trace_context.erase(audit_event_it);
 
-      event_context->audit_events.push_back(completed_audit_event);
-
     } else {
       if (audit_event_it == trace_context.end()) {
         continue;
@@ -246,41 +247,40 @@ void AuditEventPublisher::ProcessEvents(
   }
 
   // Drop events that are older than 5 minutes; it means that we have failed to
-  // receive the end of record and will never complete them correctly
+  // receive the end of record and will never complete them correctly.
+  //
+  // The first part of the audit id is a fixed-width timestamp
+  // (1501323932.710:7670542), so the correlation map iterates in chronological
+  // order and the sweep can stop at the first entry that is still within the
+  // timeout instead of walking every traced event on each invocation.
 
   std::time_t current_time;
   std::time(&current_time);
 
-  std::unordered_map<std::string, std::time_t> timestamp_cache;
+  std::uint64_t orphaned_count = 0U;
 
-  // The first part of the audit id is a timestamp: 1501323932.710:7670542
   for (auto event_it = trace_context.begin();
        event_it != trace_context.end();) {
-    const auto& audit_event_id = event_it->first;
-    std::time_t event_timestamp;
-
-    auto timestamp_it = timestamp_cache.find(audit_event_id);
-    if (timestamp_it == timestamp_cache.end()) {
-      std::string string_timestamp = audit_event_id.substr(0, 10);
-
-      long long int converted_value;
-      if (!safeStrtoll(string_timestamp, 10, converted_value)) {
-        event_timestamp = 0;
-      } else {
-        event_timestamp = static_cast<std::time_t>(converted_value);
-      }
+    std::string string_timestamp = event_it->first.substr(0, 10);
 
-      timestamp_cache[audit_event_id] = event_timestamp;
-
-    } else {
-      event_timestamp = timestamp_it->second;
+    std::time_t event_timestamp = 0;
+    long long int converted_value;
+    if (safeStrtoll(string_timestamp, 10, converted_value)) {
+      event_timestamp = static_cast<std::time_t>(converted_value);
     }
 
-    if (current_time - event_timestamp >= 300) {
-      event_it = trace_context.erase(event_it);
-    } else {
-      event_it++;
+    if (current_time - event_timestamp < 300) {
+      break;
     }
+
+    orphaned_count++;
+    event_it = trace_context.erase(event_it);
+  }
+
+  if (orphaned_count != 0U) {
+    orphaned_event_count_ += orphaned_count;
+    VLOG(1) << "Dropped " << orphaned_count << " incomplete audit events; "
+            << orphaned_event_count_.load() << " dropped since startup";
   }
 }
 
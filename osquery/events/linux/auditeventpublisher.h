@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <limits>
 #include <memory>
@@ -86,6 +87,9 @@ class AuditEventPublisher final
   /// Executable path
   static std::string executable_path_;
 
+  /// Incomplete audit events dropped before a terminator record arrived
+  static std::atomic<std::uint64_t> orphaned_event_count_;
+
   /// Aggregates raw event records into audit events
   static void ProcessEvents(AuditEventContextRef event_context,
                             const std::vector<AuditEventRecord>& record_list,
@@ -0,0 +1,686 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <arpa/inet.h>
+#include <linux/bpf.h>
+#include <linux/perf_event.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <boost/algorithm/string/trim.hpp>
+
+#include <osquery/filesystem.h>
+#include <osquery/flags.h>
+#include <osquery/logger.h>
+#include <osquery/registry_factory.h>
+
+#include "osquery/core/conversions.h"
+#include "osquery/events/linux/ebpf.h"
+
+namespace {
+/// The license attached to the generated programs.
+const char kProgramLicense[] = "GPL";
+
+/// Root of the tracefs event descriptions.
+const std::string kTracingEventPath = "/sys/kernel/debug/tracing/events/";
+
+/// Data pages per perf output ring; must be a power of two.
+const size_t kPerfDataPages = 8U;
+
+/// TCP_SYN_SENT; a socket enters this state when connect() is issued.
+const int kTcpSynSent = 2;
+
+/// The generated programs submit exactly one record per tracepoint hit.
+static_assert(sizeof(osquery::EBPFEventRecord) == 48U,
+              "Unexpected record size; the program builders assume 48 bytes");
+
+/// Field offsets within the inet_sock_set_state tracepoint record.
+struct InetSockSetStateFormat final {
+  int newstate{-1};
+  int family{-1};
+  int protocol{-1};
+  int sport{-1};
+  int dport{-1};
+  int daddr{-1};
+};
+
+int bpfSyscall(int command, union bpf_attr* attributes) {
+  return static_cast<int>(
+      syscall(__NR_bpf, command, attributes, sizeof(union bpf_attr)));
+}
+
+int perfEventOpen(struct perf_event_attr& attributes, pid_t pid, int cpu) {
+  return static_cast<int>(syscall(__NR_perf_event_open,
+                                  &attributes,
+                                  pid,
+                                  cpu,
+                                  -1,
+                                  PERF_FLAG_FD_CLOEXEC));
+}
+
+__u64 PointerToU64(const void* pointer) {
+  return static_cast<__u64>(reinterpret_cast<std::uintptr_t>(pointer));
+}
+
+/// Single instruction constructor; the emitters below use the same
+/// encodings as the kernel BPF samples.
+bpf_insn BPFInstruction(std::uint8_t code,
+                        std::uint8_t dst,
+                        std::uint8_t src,
+                        std::int16_t off,
+                        std::int32_t imm) {
+  bpf_insn instruction = {};
+  instruction.code = code;
+  instruction.dst_reg = dst;
+  instruction.src_reg = src;
+  instruction.off = off;
+  instruction.imm = imm;
+  return instruction;
+}
+
+bpf_insn BPFMov64Reg(std::uint8_t dst, std::uint8_t src) {
+  return BPFInstruction(BPF_ALU64 | BPF_MOV | BPF_X, dst, src, 0, 0);
+}
+
+bpf_insn BPFMov64Imm(std::uint8_t dst, std::int32_t imm) {
+  return BPFInstruction(BPF_ALU64 | BPF_MOV | BPF_K, dst, 0, 0, imm);
+}
+
+bpf_insn BPFMov32Imm(std::uint8_t dst, std::int32_t imm) {
+  return BPFInstruction(BPF_ALU | BPF_MOV | BPF_K, dst, 0, 0, imm);
+}
+
+bpf_insn BPFAdd64Imm(std::uint8_t dst, std::int32_t imm) {
+  return BPFInstruction(BPF_ALU64 | BPF_ADD | BPF_K, dst, 0, 0, imm);
+}
+
+bpf_insn BPFRsh64Imm(std::uint8_t dst, std::int32_t imm) {
+  return BPFInstruction(BPF_ALU64 | BPF_RSH | BPF_K, dst, 0, 0, imm);
+}
+
+bpf_insn BPFLoadMem(std::uint8_t size,
+                    std::uint8_t dst,
+                    std::uint8_t src,
+                    std::int16_t off) {
+  return BPFInstruction(BPF_LDX | size | BPF_MEM, dst, src, off, 0);
+}
+
+bpf_insn BPFStoreReg(std::uint8_t size,
+                     std::uint8_t dst,
+                     std::int16_t off,
+                     std::uint8_t src) {
+  return BPFInstruction(BPF_STX | size | BPF_MEM, dst, src, off, 0);
+}
+
+bpf_insn BPFStoreImm(std::uint8_t size,
+                     std::uint8_t dst,
+                     std::int16_t off,
+                     std::int32_t imm) {
+  return BPFInstruction(BPF_ST | size | BPF_MEM, dst, 0, off, imm);
+}
+
+bpf_insn BPFJumpEqImm(std::uint8_t dst, std::int32_t imm, std::int16_t off) {
+  return BPFInstruction(BPF_JMP | BPF_JEQ | BPF_K, dst, 0, off, imm);
+}
+
+bpf_insn BPFCall(std::int32_t function) {
+  return BPFInstruction(BPF_JMP | BPF_CALL, 0, 0, 0, function);
+}
+
+bpf_insn BPFExit() {
+  return BPFInstruction(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+}
+
+/// Map references are 64-bit immediate loads and take two slots.
+void BPFLoadMapFd(std::vector<bpf_insn>& program, std::uint8_t dst, int fd) {
+  program.push_back(
+      BPFInstruction(BPF_LD | BPF_DW | BPF_IMM, dst, BPF_PSEUDO_MAP_FD, 0, fd));
+  program.push_back(BPFInstruction(0, 0, 0, 0, 0));
+}
+
+/// Emits the record construction shared by every program: zero the 48 byte
+/// record at r10-48, then fill the type and process identity fields.
+void EmitRecordFields(std::vector<bpf_insn>& program, std::uint32_t type) {
+  auto record_size =
+      static_cast<std::int16_t>(sizeof(osquery::EBPFEventRecord));
+
+  for (std::int16_t off = -record_size; off < 0; off += 8) {
+    program.push_back(BPFStoreImm(BPF_DW, BPF_REG_10, off, 0));
+  }
+
+  program.push_back(BPFStoreImm(
+      BPF_W, BPF_REG_10, -record_size, static_cast<std::int32_t>(type)));
+
+  // The helper returns (tgid << 32) | tid.
+  program.push_back(BPFCall(BPF_FUNC_get_current_pid_tgid));
+  program.push_back(BPFStoreReg(BPF_W, BPF_REG_10, -40, BPF_REG_0));
+  program.push_back(BPFRsh64Imm(BPF_REG_0, 32));
+  program.push_back(BPFStoreReg(BPF_W, BPF_REG_10, -44, BPF_REG_0));
+
+  // The helper returns (gid << 32) | uid.
+  program.push_back(BPFCall(BPF_FUNC_get_current_uid_gid));
+  program.push_back(BPFStoreReg(BPF_W, BPF_REG_10, -36, BPF_REG_0));
+  program.push_back(BPFRsh64Imm(BPF_REG_0, 32));
+  program.push_back(BPFStoreReg(BPF_W, BPF_REG_10, -32, BPF_REG_0));
+
+  program.push_back(BPFMov64Reg(BPF_REG_1, BPF_REG_10));
+  program.push_back(BPFAdd64Imm(BPF_REG_1, -24));
+  program.push_back(BPFMov64Imm(BPF_REG_2, 16));
+  program.push_back(BPFCall(BPF_FUNC_get_current_comm));
+}
+
+/// Emits the program epilogue submitting the record to the per-CPU ring.
+void EmitRecordSubmit(std::vector<bpf_insn>& program, int map_fd) {
+  auto record_size =
+      static_cast<std::int32_t>(sizeof(osquery::EBPFEventRecord));
+
+  program.push_back(BPFMov64Reg(BPF_REG_1, BPF_REG_6));
+  BPFLoadMapFd(program, BPF_REG_2, map_fd);
+
+  // A 32-bit move zero-extends, yielding BPF_F_CURRENT_CPU (0xffffffff).
+  program.push_back(BPFMov32Imm(BPF_REG_3, -1));
+  program.push_back(BPFMov64Reg(BPF_REG_4, BPF_REG_10));
+  program.push_back(BPFAdd64Imm(BPF_REG_4, -record_size));
+  program.push_back(BPFMov64Imm(BPF_REG_5, record_size));
+  program.push_back(BPFCall(BPF_FUNC_perf_event_output));
+
+  program.push_back(BPFMov64Imm(BPF_REG_0, 0));
+  program.push_back(BPFExit());
+}
+
+/// Builds the program attached to the sched_process_exec/exit tracepoints.
+std::vector<bpf_insn> BuildProcessEventProgram(std::uint32_t type,
+                                               int map_fd) {
+  std::vector<bpf_insn> program;
+  program.push_back(BPFMov64Reg(BPF_REG_6, BPF_REG_1));
+
+  EmitRecordFields(program, type);
+  EmitRecordSubmit(program, map_fd);
+  return program;
+}
+
+/// Builds the program attached to the inet_sock_set_state tracepoint.
+std::vector<bpf_insn> BuildConnectEventProgram(
+    const InetSockSetStateFormat& format, int map_fd) {
+  std::vector<bpf_insn> program;
+  program.push_back(BPFMov64Reg(BPF_REG_6, BPF_REG_1));
+
+  // Only TCP/IPv4 connection attempts are interesting; a passing check
+  // jumps over the early return.
+  auto emit_filter = [&program](
+                         std::uint8_t size, int offset, std::int32_t value) {
+    program.push_back(BPFLoadMem(
+        size, BPF_REG_2, BPF_REG_6, static_cast<std::int16_t>(offset)));
+    program.push_back(BPFJumpEqImm(BPF_REG_2, value, 2));
+    program.push_back(BPFMov64Imm(BPF_REG_0, 0));
+    program.push_back(BPFExit());
+  };
+
+  emit_filter(BPF_W, format.newstate, kTcpSynSent);
+  emit_filter(BPF_H, format.family, AF_INET);
+  if (format.protocol >= 0) {
+    emit_filter(BPF_H, format.protocol, IPPROTO_TCP);
+  }
+
+  EmitRecordFields(program, osquery::EBPF_EVENT_CONNECT);
+
+  // The tracepoint carries the ports in host byte order and the remote
+  // address as a byte array in network byte order.
+  program.push_back(BPFLoadMem(BPF_W,
+                               BPF_REG_2,
+                               BPF_REG_6,
+                               static_cast<std::int16_t>(format.daddr)));
+  program.push_back(BPFStoreReg(BPF_W, BPF_REG_10, -8, BPF_REG_2));
+  program.push_back(BPFLoadMem(BPF_H,
+                               BPF_REG_2,
+                               BPF_REG_6,
+                               static_cast<std::int16_t>(format.dport)));
+  program.push_back(BPFStoreReg(BPF_H, BPF_REG_10, -4, BPF_REG_2));
+  program.push_back(BPFLoadMem(BPF_H,
+                               BPF_REG_2,
+                               BPF_REG_6,
+                               static_cast<std::int16_t>(format.sport)));
+  program.push_back(BPFStoreReg(BPF_H, BPF_REG_10, -2, BPF_REG_2));
+
+  EmitRecordSubmit(program, map_fd);
+  return program;
+}
+
+/// Reads the tracepoint identifier used for the perf event attachment.
+osquery::Status GetTracepointID(const std::string& category,
+                                const std::string& name,
+                                long int& tracepoint_id) {
+  std::string content;
+  auto status = osquery::readFile(
+      kTracingEventPath + category + "/" + name + "/id", content);
+  if (!status.ok()) {
+    return osquery::Status(1, "Missing tracepoint " + category + "/" + name);
+  }
+
+  boost::algorithm::trim(content);
+  return osquery::safeStrtol(content, 10, tracepoint_id);
+}
+
+/// Resolves a field offset from the tracepoint format description.
+osquery::Status GetTracepointFieldOffset(const std::string& content,
+                                         const std::string& field,
+                                         int& offset) {
+  for (const auto& line : osquery::split(content, "\n")) {
+    if (line.find("field:") == std::string::npos ||
+        (line.find(" " + field + ";") == std::string::npos &&
+         line.find(" " + field + "[") == std::string::npos)) {
+      continue;
+    }
+
+    auto position = line.find("offset:");
+    if (position == std::string::npos) {
+      continue;
+    }
+
+    auto terminator = line.find(';', position);
+    long int value = 0;
+    auto status = osquery::safeStrtol(
+        line.substr(position + 7, terminator - position - 7), 10, value);
+    if (!status.ok()) {
+      continue;
+    }
+
+    offset = static_cast<int>(value);
+    return osquery::Status(0, "OK");
+  }
+
+  return osquery::Status(1, "Missing tracepoint field " + field);
+}
+
+/// Resolves the inet_sock_set_state field offsets for this kernel.
+osquery::Status GetInetSockSetStateFormat(InetSockSetStateFormat& format) {
+  std::string content;
+  auto status = osquery::readFile(
+      kTracingEventPath + "sock/inet_sock_set_state/format", content);
+  if (!status.ok()) {
+    return osquery::Status(1, "Missing the inet_sock_set_state tracepoint");
+  }
+
+  const std::vector<std::pair<std::string, int*>> required_fields = {
+      {"newstate", &format.newstate},
+      {"family", &format.family},
+      {"sport", &format.sport},
+      {"dport", &format.dport},
+      {"daddr", &format.daddr}};
+
+  for (const auto& field : required_fields) {
+    status = GetTracepointFieldOffset(content, field.first, *field.second);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  // The protocol field is optional; without it the filter only uses the
+  // address family and socket state.
+  GetTracepointFieldOffset(content, "protocol", format.protocol);
+  return osquery::Status(0, "OK");
+}
+} // namespace
+
+namespace osquery {
+
+FLAG(bool,
+     enable_ebpf_events,
+     false,
+     "Enable the eBPF process and socket event publisher");
+
+REGISTER(EBPFEventPublisher, "event_publisher", "ebpf");
+
+Status EBPFEventPublisher::setUp() {
+  if (!FLAGS_enable_ebpf_events) {
+    return Status(1, "Publisher disabled via configuration");
+  }
+
+  WriteLock lock(mutex_);
+
+  auto cpu_count = sysconf(_SC_NPROCESSORS_CONF);
+  if (cpu_count <= 0) {
+    return Status(1, "Failed to determine the CPU count");
+  }
+
+  union bpf_attr attributes;
+  std::memset(&attributes, 0, sizeof(attributes));
+  attributes.map_type = BPF_MAP_TYPE_PERF_EVENT_ARRAY;
+  attributes.key_size = 4U;
+  attributes.value_size = 4U;
+  attributes.max_entries = static_cast<__u32>(cpu_count);
+
+  output_map_ = bpfSyscall(BPF_MAP_CREATE, &attributes);
+  if (output_map_ < 0) {
+    return Status(
+        1, "Failed to create the eBPF output map. Errno: " + std::to_string(errno));
+  }
+
+  auto status = createPerfOutput();
+  if (!status.ok()) {
+    tearDown();
+    return status;
+  }
+
+  status = attachTracepoint(
+      "sched",
+      "sched_process_exec",
+      BuildProcessEventProgram(EBPF_EVENT_EXEC, output_map_));
+  if (!status.ok()) {
+    tearDown();
+    return status;
+  }
+
+  status = attachTracepoint(
+      "sched",
+      "sched_process_exit",
+      BuildProcessEventProgram(EBPF_EVENT_EXIT, output_map_));
+  if (!status.ok()) {
+    tearDown();
+    return status;
+  }
+
+  // The inet_sock_set_state tracepoint appeared in kernel 4.16; without it
+  // the publisher still serves process events.
+  InetSockSetStateFormat format;
+  status = GetInetSockSetStateFormat(format);
+  if (status.ok()) {
+    status = attachTracepoint("sock",
+                              "inet_sock_set_state",
+                              BuildConnectEventProgram(format, output_map_));
+  }
+
+  if (!status.ok()) {
+    VLOG(1) << "eBPF socket events are not available: " << status.getMessage();
+  }
+
+  return Status(0, "OK");
+}
+
+void EBPFEventPublisher::tearDown() {
+  WriteLock lock(mutex_);
+
+  for (auto& buffer : buffer_list_) {
+    ioctl(buffer.fd, PERF_EVENT_IOC_DISABLE, 0);
+    munmap(buffer.data, buffer.mapping_size);
+    close(buffer.fd);
+  }
+  buffer_list_.clear();
+
+  for (auto& fd : tracepoint_list_) {
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    close(fd);
+  }
+  tracepoint_list_.clear();
+
+  for (auto& fd : program_list_) {
+    close(fd);
+  }
+  program_list_.clear();
+
+  if (output_map_ >= 0) {
+    close(output_map_);
+    output_map_ = -1;
+  }
+}
+
+Status EBPFEventPublisher::attachTracepoint(
+    const std::string& category,
+    const std::string& name,
+    const std::vector<struct bpf_insn>& program) {
+  long int tracepoint_id = 0;
+  auto status = GetTracepointID(category, name, tracepoint_id);
+  if (!status.ok()) {
+    return status;
+  }
+
+  union bpf_attr attributes;
+  std::memset(&attributes, 0, sizeof(attributes));
+  attributes.prog_type = BPF_PROG_TYPE_TRACEPOINT;
+  attributes.insns = PointerToU64(program.data());
+  attributes.insn_cnt = static_cast<__u32>(program.size());
+  attributes.license = PointerToU64(kProgramLicense);
+
+  auto program_fd = bpfSyscall(BPF_PROG_LOAD, &attributes);
+  if (program_fd < 0) {
+    // Reload with the verifier log enabled so rejections can be debugged.
+    std::vector<char> verifier_log(4096U, 0);
+    attributes.log_buf = PointerToU64(verifier_log.data());
+    attributes.log_size = static_cast<__u32>(verifier_log.size());
+    attributes.log_level = 1U;
+
+    program_fd = bpfSyscall(BPF_PROG_LOAD, &attributes);
+    if (program_fd < 0) {
+      VLOG(1) << "eBPF verifier output for " << name << ": "
+              << verifier_log.data();
+      return Status(1, "Failed to load the eBPF program for " + name);
+    }
+  }
+
+  program_list_.push_back(program_fd);
+
+  struct perf_event_attr perf_attributes;
+  std::memset(&perf_attributes, 0, sizeof(perf_attributes));
+  perf_attributes.type = PERF_TYPE_TRACEPOINT;
+  perf_attributes.size = sizeof(perf_attributes);
+  perf_attributes.config = static_cast<__u64>(tracepoint_id);
+  perf_attributes.sample_period = 1U;
+  perf_attributes.wakeup_events = 1U;
+
+  auto event_fd = perfEventOpen(perf_attributes, -1, 0);
+  if (event_fd < 0) {
+    return Status(1, "Failed to open the tracepoint event for " + name);
+  }
+
+  tracepoint_list_.push_back(event_fd);
+
+  if (ioctl(event_fd, PERF_EVENT_IOC_SET_BPF, program_fd) < 0) {
+    return Status(1, "Failed to attach the eBPF program to " + name);
+  }
+
+  if (ioctl(event_fd, PERF_EVENT_IOC_ENABLE, 0) < 0) {
+    return Status(1, "Failed to enable the tracepoint event for " + name);
+  }
+
+  return Status(0, "OK");
+}
+
+Status EBPFEventPublisher::createPerfOutput() {
+  auto page_size = static_cast<size_t>(getpagesize());
+  auto cpu_count = sysconf(_SC_NPROCESSORS_CONF);
+
+  for (long int cpu = 0; cpu < cpu_count; cpu++) {
+    struct perf_event_attr attributes;
+    std::memset(&attributes, 0, sizeof(attributes));
+    attributes.type = PERF_TYPE_SOFTWARE;
+    attributes.size = sizeof(attributes);
+    attributes.config = PERF_COUNT_SW_BPF_OUTPUT;
+    attributes.sample_type = PERF_SAMPLE_RAW;
+    attributes.sample_period = 1U;
+    attributes.wakeup_events = 1U;
+
+    PerfEventBuffer buffer;
+    buffer.fd = perfEventOpen(attributes, -1, static_cast<int>(cpu));
+    if (buffer.fd < 0) {
+      // Offline CPUs are skipped; their map slots are never written to.
+      if (errno == ENODEV) {
+        continue;
+      }
+
+      return Status(1, "Failed to create a perf output event");
+    }
+
+    buffer.mapping_size = page_size * (kPerfDataPages + 1U);
+    buffer.data = mmap(nullptr,
+                       buffer.mapping_size,
+                       PROT_READ | PROT_WRITE,
+                       MAP_SHARED,
+                       buffer.fd,
+                       0);
+    if (buffer.data == MAP_FAILED) {
+      close(buffer.fd);
+      return Status(1, "Failed to map a perf output buffer");
+    }
+
+    auto key = static_cast<std::uint32_t>(cpu);
+    auto value = static_cast<std::uint32_t>(buffer.fd);
+
+    union bpf_attr update;
+    std::memset(&update, 0, sizeof(update));
+    update.map_fd = static_cast<__u32>(output_map_);
+    update.key = PointerToU64(&key);
+    update.value = PointerToU64(&value);
+
+    if (bpfSyscall(BPF_MAP_UPDATE_ELEM, &update) < 0 ||
+        ioctl(buffer.fd, PERF_EVENT_IOC_ENABLE, 0) < 0) {
+      munmap(buffer.data, buffer.mapping_size);
+      close(buffer.fd);
+      return Status(1, "Failed to select a perf output event into the map");
+    }
+
+    buffer_list_.push_back(buffer);
+  }
+
+  if (buffer_list_.empty()) {
+    return Status(1, "No perf output buffers could be created");
+  }
+
+  return Status(0, "OK");
+}
+
+Status EBPFEventPublisher::run() {
+  WriteLock lock(mutex_);
+  if (buffer_list_.empty()) {
+    return Status(1);
+  }
+
+  std::vector<struct pollfd> poll_list;
+  for (const auto& buffer : buffer_list_) {
+    struct pollfd poll_descriptor = {};
+    poll_descriptor.fd = buffer.fd;
+    poll_descriptor.events = POLLIN;
+    poll_list.push_back(poll_descriptor);
+  }
+
+  int selector = ::poll(poll_list.data(), poll_list.size(), 1000);
+  if (selector == -1 && errno != EINTR && errno != EAGAIN) {
+    LOG(ERROR) << "Could not poll the eBPF perf output buffers";
+    return Status(1, "eBPF perf poll failed");
+  }
+
+  for (auto& buffer : buffer_list_) {
+    drainPerfBuffer(buffer);
+  }
+
+  return Status(0, "OK");
+}
+
+void EBPFEventPublisher::drainPerfBuffer(PerfEventBuffer& buffer) {
+  auto page_size = static_cast<size_t>(getpagesize());
+  auto control = static_cast<struct perf_event_mmap_page*>(buffer.data);
+  auto data = static_cast<std::uint8_t*>(buffer.data) + page_size;
+  auto data_size = buffer.mapping_size - page_size;
+
+  auto head = control->data_head;
+
+  // Pairs with the barrier in the kernel ring writer.
+  __sync_synchronize();
+
+  auto tail = control->data_tail;
+
+  while (tail < head) {
+    auto offset = static_cast<size_t>(tail % data_size);
+
+    // Records are 8-byte aligned, so the header itself never wraps; the
+    // payload can, in which case it is reassembled into scratch storage.
+    auto record = data + offset;
+    auto header = reinterpret_cast<const struct perf_event_header*>(record);
+
+    std::vector<std::uint8_t> scratch;
+    if (offset + header->size > data_size) {
+      scratch.resize(header->size);
+
+      auto chunk_size = data_size - offset;
+      std::memcpy(scratch.data(), data + offset, chunk_size);
+      std::memcpy(
+          scratch.data() + chunk_size, data, header->size - chunk_size);
+
+      record = scratch.data();
+      header = reinterpret_cast<const struct perf_event_header*>(record);
+    }
+
+    if (header->type == PERF_RECORD_SAMPLE) {
+      // Sample layout: header, 32-bit raw size, raw data.
+      auto raw_size = *reinterpret_cast<const std::uint32_t*>(
+          record + sizeof(struct perf_event_header));
+      if (raw_size >= sizeof(EBPFEventRecord)) {
+        const auto& event = *reinterpret_cast<const EBPFEventRecord*>(
+            record + sizeof(struct perf_event_header) + sizeof(std::uint32_t));
+        fire(createEventContextFrom(event));
+      }
+    } else if (header->type == PERF_RECORD_LOST) {
+      // Lost record layout: header, 64-bit id, 64-bit lost count.
+      auto lost = *reinterpret_cast<const std::uint64_t*>(
+          record + sizeof(struct perf_event_header) + sizeof(std::uint64_t));
+      lost_record_count_ += static_cast<size_t>(lost);
+
+      VLOG(1) << "The eBPF publisher has lost " << lost_record_count_
+              << " records since starting";
+    }
+
+    tail += header->size;
+  }
+
+  __sync_synchronize();
+  control->data_tail = tail;
+}
+
+EBPFEventContextRef EBPFEventPublisher::createEventContextFrom(
+    const EBPFEventRecord& record) {
+  auto ec = createEventContext();
+  ec->type = static_cast<EBPFEventType>(record.type);
+  ec->pid = record.pid;
+  ec->tid = record.tid;
+  ec->uid = record.uid;
+  ec->gid = record.gid;
+  ec->comm =
+      std::string(record.comm, strnlen(record.comm, sizeof(record.comm)));
+
+  if (ec->type == EBPF_EVENT_CONNECT) {
+    struct in_addr address = {};
+    address.s_addr = record.remote_address;
+
+    char buffer[INET_ADDRSTRLEN] = {};
+    if (inet_ntop(AF_INET, &address, buffer, sizeof(buffer)) != nullptr) {
+      ec->remote_address = buffer;
+    }
+
+    ec->remote_port = record.remote_port;
+    ec->local_port = record.local_port;
+  }
+
+  return ec;
+}
+
+bool EBPFEventPublisher::shouldFire(const EBPFSubscriptionContextRef& sc,
+                                    const EBPFEventContextRef& ec) const {
+  if (sc->type != EBPF_EVENT_ALL && sc->type != ec->type) {
+    return false;
+  }
+
+  return true;
+}
+} // namespace osquery
@@ -0,0 +1,191 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <osquery/events.h>
+#include <osquery/status.h>
+
+namespace osquery {
+
+enum EBPFEventType {
+  EBPF_EVENT_EXEC = 1,
+  EBPF_EVENT_EXIT = 2,
+  EBPF_EVENT_CONNECT = 3,
+
+  // Custom subscriber-only catch-all for event types.
+  EBPF_EVENT_ALL = 10,
+};
+
+/**
+ * @brief The fixed binary record emitted by the in-kernel programs.
+ *
+ * Every tracepoint program writes exactly this structure into the per-CPU
+ * perf output buffer; the reader consumes it without any string parsing.
+ * The connect-only fields are zero for process events.
+ */
+struct EBPFEventRecord final {
+  /// One of the EBPFEventType values.
+  std::uint32_t type;
+
+  /// Process (thread group) identifier.
+  std::uint32_t pid;
+
+  /// Thread identifier.
+  std::uint32_t tid;
+
+  /// Real user identifier.
+  std::uint32_t uid;
+
+  /// Real group identifier.
+  std::uint32_t gid;
+
+  /// Unused; keeps the comm buffer 8-byte aligned.
+  std::uint32_t padding;
+
+  /// Kernel task name, not necessarily null terminated.
+  char comm[16];
+
+  /// Remote IPv4 address in network byte order (connect events only).
+  std::uint32_t remote_address;
+
+  /// Remote port in host byte order (connect events only).
+  std::uint16_t remote_port;
+
+  /// Local port in host byte order (connect events only).
+  std::uint16_t local_port;
+};
+
+/**
+ * @brief Subscriptioning details for EBPFEventPublisher events.
+ */
+struct EBPFSubscriptionContext : public SubscriptionContext {
+  /// The event type of interest, or EBPF_EVENT_ALL.
+  EBPFEventType type{EBPF_EVENT_ALL};
+};
+
+/**
+ * @brief Event details for EBPFEventPublisher events.
+ */
+struct EBPFEventContext : public EventContext {
+  /// The EBPFEventType identifier.
+  EBPFEventType type;
+
+  /// Process (thread group) identifier.
+  std::uint32_t pid{0};
+
+  /// Thread identifier.
+  std::uint32_t tid{0};
+
+  /// Real user identifier.
+  std::uint32_t uid{0};
+
+  /// Real group identifier.
+  std::uint32_t gid{0};
+
+  /// Kernel task name.
+  std::string comm;
+
+  /// Remote IPv4 address in dotted notation (connect events only).
+  std::string remote_address;
+
+  /// Remote port (connect events only).
+  std::uint16_t remote_port{0};
+
+  /// Local port (connect events only).
+  std::uint16_t local_port{0};
+};
+
+using EBPFEventContextRef = std::shared_ptr<EBPFEventContext>;
+using EBPFSubscriptionContextRef = std::shared_ptr<EBPFSubscriptionContext>;
+
+/**
+ * @brief A Linux eBPF process and socket EventPublisher.
+ *
+ * This publisher attaches small, hand-assembled eBPF programs to the
+ * sched_process_exec, sched_process_exit and inet_sock_set_state
+ * tracepoints. Each program copies a fixed EBPFEventRecord into a per-CPU
+ * perf output buffer; the run loop drains the buffers and fires one event
+ * context per record. Compared to the audit netlink publisher this avoids
+ * the per-event field tokenization entirely and does not take ownership of
+ * the audit subsystem away from auditd.
+ */
+class EBPFEventPublisher
+    : public EventPublisher<EBPFSubscriptionContext, EBPFEventContext> {
+  DECLARE_PUBLISHER("ebpf");
+
+ public:
+  virtual ~EBPFEventPublisher() {
+    tearDown();
+  }
+
+  Status setUp() override;
+
+  void tearDown() override;
+
+  Status run() override;
+
+ private:
+  /// A single per-CPU perf output ring.
+  struct PerfEventBuffer final {
+    /// The perf event descriptor selected into the output map.
+    int fd{-1};
+
+    /// The memory mapped control page followed by the data pages.
+    void* data{nullptr};
+
+    /// Total size of the mapping, in bytes.
+    size_t mapping_size{0};
+  };
+
+ private:
+  /// Loads a program and attaches it to the given tracepoint.
+  Status attachTracepoint(const std::string& category,
+                          const std::string& name,
+                          const std::vector<struct bpf_insn>& program);
+
+  /// Creates and maps the per-CPU perf output buffers.
+  Status createPerfOutput();
+
+  /// Drains one perf ring, firing an event for each complete record.
+  void drainPerfBuffer(PerfEventBuffer& buffer);
+
+  /// Helper function to create an EventContext from a binary record.
+  EBPFEventContextRef createEventContextFrom(const EBPFEventRecord& record);
+
+ private:
+  /// The BPF_MAP_TYPE_PERF_EVENT_ARRAY descriptor shared by all programs.
+  int output_map_{-1};
+
+  /// Loaded program descriptors.
+  std::vector<int> program_list_;
+
+  /// Tracepoint perf event descriptors keeping the programs attached.
+  std::vector<int> tracepoint_list_;
+
+  /// Per-CPU perf output buffers.
+  std::vector<PerfEventBuffer> buffer_list_;
+
+  /// Records dropped because a perf ring was full.
+  size_t lost_record_count_{0};
+
+  /// Protection around the eBPF resources.
+  Mutex mutex_;
+
+ private:
+  /// Check subscription details.
+  bool shouldFire(const EBPFSubscriptionContextRef& sc,
+                  const EBPFEventContextRef& ec) const override;
+};
+} // namespace osquery
@@ -8,7 +8,9 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <set>
 #include <sstream>
+#include <vector>
 
 #include <fnmatch.h>
 #include <linux/limits.h>
@@ -22,6 +24,7 @@
 #include <osquery/registry_factory.h>
 #include <osquery/system.h>
 
+#include "osquery/core/json.h"
 #include "osquery/events/linux/inotify.h"
 
 namespace fs = boost::filesystem;
@@ -109,11 +112,26 @@ bool INotifyEventPublisher::monitorSubscription(
 
     if (discovered.find('*') != std::string::npos) {
       // If a wildcard exists within the tree (stem), resolve at configure
-      // time and monitor each path.
-      std::vector<std::string> paths;
-      resolveFilePattern(discovered, paths);
+      // time and monitor each path. The expansion is cached: the directory
+      // walk is repeated only when a directory event or a change to the stem
+      // directory invalidated the previous resolution.
+      struct stat stem_stat;
+      auto stem = fs::path(discovered.substr(0, discovered.find('*')))
+                      .parent_path()
+                      .string();
+      if (stat(stem.c_str(), &stem_stat) == -1) {
+        stem_stat.st_ctime = 0;
+      }
+
+      if (sc->rescan_ || stem_stat.st_ctime != sc->stem_sc_time_) {
+        sc->discovered_paths_.clear();
+        resolveFilePattern(discovered, sc->discovered_paths_);
+        sc->stem_sc_time_ = stem_stat.st_ctime;
+        sc->rescan_ = false;
+      }
+
       sc->recursive_match = sc->recursive;
-      for (const auto& _path : paths) {
+      for (const auto& _path : sc->discovered_paths_) {
         needMonitoring(_path, sc, sc->mask, sc->recursive, add_watch);
       }
       return true;
@@ -206,6 +224,57 @@ void INotifyEventPublisher::tearDown() {
   }
 }
 
+Status INotifyEventPublisher::serializeState(std::string& state) {
+  auto doc = JSON::newObject();
+  auto watches = doc.newArray();
+  {
+    WriteLock lock(path_mutex_);
+    for (const auto& descriptor : descriptor_inosubctx_) {
+      const auto& isc = descriptor.second;
+      auto path = isc->descriptor_paths_.find(descriptor.first);
+      if (path == isc->descriptor_paths_.end()) {
+        continue;
+      }
+
+      auto watch = doc.newObject();
+      doc.addRef("path", path->second, watch.doc());
+      doc.add("mask", static_cast<size_t>(isc->mask), watch.doc());
+      doc.push(watch.doc(), watches.doc());
+    }
+  }
+  doc.add("watches", watches.doc());
+  return doc.toString(state);
+}
+
+Status INotifyEventPublisher::restoreState(const std::string& state) {
+  JSON doc;
+  auto status = doc.fromString(state);
+  if (!status.ok() || !doc.doc().HasMember("watches") ||
+      !doc.doc()["watches"].IsArray()) {
+    return Status(1, "Invalid publisher state");
+  }
+
+  // The restored watches are held by a placeholder subscription context. The
+  // kernel watch set becomes live immediately, and the first configure will
+  // rebind each path to its real subscription: inotify returns the same
+  // descriptor for an existing path, replacing the placeholder in addMonitor.
+  // Events firing before that rebind match no subscriber and are dropped.
+  auto holder = createSubscriptionContext();
+  for (const auto& watch : doc.doc()["watches"].GetArray()) {
+    if (!watch.IsObject() || !watch.HasMember("path") ||
+        !watch["path"].IsString()) {
+      continue;
+    }
+
+    uint32_t mask = 0;
+    if (watch.HasMember("mask") && watch["mask"].IsUint()) {
+      mask = watch["mask"].GetUint();
+    }
+    addMonitor(watch["path"].GetString(), holder, mask, false);
+  }
+  return Status(0, "OK");
+}
+
 void INotifyEventPublisher::handleOverflow() {
   if (inotify_events_ < kINotifyMaxEvents) {
     VLOG(1) << "inotify was overflown: increasing scratch buffer";
@@ -248,6 +317,9 @@ Status INotifyEventPublisher::run() {
     return Status(1, "INotify read failed");
   }
 
+  // Collect the drained events and deliver them to subscribers as one batch.
+  std::vector<EventContextRef> batch;
+  std::set<std::string> coalesced;
   for (char* p = scratch_; p < scratch_ + record_num;) {
     // Cast the inotify struct, make shared pointer, and append to contexts.
     auto event = reinterpret_cast<struct inotify_event*>(p);
@@ -265,14 +337,21 @@ Status INotifyEventPublisher::run() {
       removeMonitor(event->wd, false);
     } else {
       auto ec = createEventContextFrom(event);
-      if (!ec->action.empty()) {
-        fire(ec);
+      // Coalesce repeated (action, path) pairs within this drain: bursts of
+      // writes to the same path collapse into one delivered event.
+      if (!ec->action.empty() &&
+          coalesced.insert(ec->action + '|' + ec->path).second) {
+        batch.push_back(std::move(ec));
       }
     }
     // Continue to iterate
     p += (sizeof(struct inotify_event)) + event->len;
   }
 
+  if (!batch.empty()) {
+    fire(batch);
+  }
+
   return Status(0, "OK");
 }
 
@@ -291,6 +370,9 @@ INotifyEventContextRef INotifyEventPublisher::createEventContextFrom(
       auto isc = descriptor_inosubctx_.at(event->wd);
       ec->path = isc->descriptor_paths_.at(event->wd);
       ec->isub_ctx = isc;
+      // The owning subscription is known: let fire dispatch by index lookup
+      // instead of probing every subscription's shouldFire.
+      ec->target_sub_ctx = isc;
     }
   }
 
@@ -328,6 +410,14 @@ bool INotifyEventPublisher::shouldFire(const INotifySubscriptionContextRef& sc,
         true);
   }
 
+  // Directory changes invalidate a cached wildcard expansion, so the next
+  // configure re-resolves the pattern instead of trusting stale results.
+  if (sc->recursive_match &&
+      (ec->action == "CREATED" || ec->action == "DELETED" ||
+       ec->action == "MOVED_FROM" || ec->action == "MOVED_TO")) {
+    sc->rescan_ = true;
+  }
+
   // exclude paths should be applied at last
   auto path = ec->path.substr(0, ec->path.rfind('/'));
   // Need to have two finds,
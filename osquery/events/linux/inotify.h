@@ -81,6 +81,15 @@ struct INotifySubscriptionContext : public SubscriptionContext {
   /// A configure-time pattern was expanded to match absolute paths.
   bool recursive_match{false};
 
+  /// Cached configure-time expansion of an embedded (stem) wildcard.
+  std::vector<std::string> discovered_paths_;
+
+  /// Status change time of the pattern's static stem directory.
+  time_t stem_sc_time_{0};
+
+  /// The cached pattern expansion is stale and must be re-resolved.
+  bool rescan_{true};
+
   /// Map of inotify watch file descriptor to watched path string.
   DescriptorPathMap descriptor_paths_;
 
@@ -161,6 +170,12 @@ class INotifyEventPublisher
   /// Release the `inotify` handle descriptor.
   void tearDown() override;
 
+  /// Serialize the active watch list for a warm restart.
+  Status serializeState(std::string& state) override;
+
+  /// Re-add persisted watches before the first configure.
+  Status restoreState(const std::string& state) override;
+
   /// The calling for beginning the thread's run loop.
   Status run() override;
 
@@ -292,5 +307,6 @@ class INotifyEventPublisher
   FRIEND_TEST(INotifyTests, test_inotify_recursion);
   FRIEND_TEST(INotifyTests, test_inotify_match_subscription);
   FRIEND_TEST(INotifyTests, test_inotify_embedded_wildcards);
+  FRIEND_TEST(INotifyTests, test_inotify_warm_restart);
 };
 }
@@ -45,7 +45,7 @@ FLAG(string,
 
 FLAG(uint64,
      syslog_rate_limit,
-     100,
+     10000,
      "Maximum number of logs to ingest per run (~200ms between runs)");
 
 REGISTER(SyslogEventPublisher, "event_publisher", "syslog");
@@ -58,6 +58,12 @@ const std::vector<std::string> kCsvFields = {
     "time", "host", "severity", "facility", "tag", "message"};
 const size_t kErrorThreshold = 10;
 
+// Size of each pipe read; large reads let a burst drain in a few syscalls.
+const size_t kReadChunkSize = 64 * 1024;
+
+// Upper bound on buffered pipe data before parsing must catch up.
+const size_t kMaxReadBufferSize = 4 * 1024 * 1024;
+
 Status SyslogEventPublisher::setUp() {
   if (!FLAGS_enable_syslog) {
     return Status(1, "Publisher disabled via configuration");
@@ -85,16 +91,17 @@ Status SyslogEventPublisher::setUp() {
     return s;
   }
 
-  // Opening with both flags appears to be the only way to open the pipe
-  // without blocking for a writer. We won't ever write to the pipe, but we
-  // don't want to block here and will instead block waiting for a read in the
-  // run() method
-  readStream_.open(FLAGS_syslog_pipe_path,
-                   std::ifstream::in | std::ifstream::out);
-  if (!readStream_.good()) {
+  // Opening read/write appears to be the only way to open the pipe without
+  // blocking for a writer, and it also prevents reads from seeing EOF when
+  // the last writer disconnects. We won't ever write to the pipe. The
+  // descriptor is non-blocking so run() can drain the pipe and return.
+  readFd_ = open(FLAGS_syslog_pipe_path.c_str(), O_RDWR | O_NONBLOCK);
+  if (readFd_ == -1) {
     return Status(1,
                   "Error opening pipe for reading: " + FLAGS_syslog_pipe_path);
   }
+
+  readChunk_.resize(kReadChunkSize);
   VLOG(1) << "Successfully opened pipe for syslog ingestion: "
           << FLAGS_syslog_pipe_path;
 
@@ -151,22 +158,46 @@ void SyslogEventPublisher::unlockPipe() {
 
 Status SyslogEventPublisher::run() {
   // This run function will be called by the event factory with ~100ms pause
-  // (see InterruptableRunnable::pause()) between runs. In case something goes
-  // weird and there is a huge amount of input, we limit how many logs we
-  // take in per run to avoid pegging the CPU.
-  for (size_t i = 0; i < FLAGS_syslog_rate_limit; ++i) {
-    if (readStream_.rdbuf()->in_avail() == 0) {
-      // If there is no pending data, we have flushed everything and can wait
-      // until the next time EventFactory calls run(). This also allows the
-      // thread to join when it is stopped by EventFactory.
-      return Status(0, "OK");
+  // (see InterruptableRunnable::pause()) between runs. Drain the pipe
+  // completely with large reads first: a burst (a kernel OOM storm, for
+  // example) must move out of the fixed-size pipe buffer before rsyslog
+  // starts dropping lines, so no parsing or subscriber work happens between
+  // reads.
+  while (readBuffer_.size() < kMaxReadBufferSize) {
+    auto bytes_read = ::read(readFd_, readChunk_.data(), readChunk_.size());
+    if (bytes_read > 0) {
+      readBuffer_.append(readChunk_.data(), static_cast<size_t>(bytes_read));
+      continue;
+    }
+
+    if (bytes_read == -1 && errno == EINTR) {
+      continue;
     }
-    std::string line;
-    std::getline(readStream_, line);
+
+    // The pipe is empty (EAGAIN) or in error; parse what we have.
+    break;
+  }
+
+  // Parse the complete lines into event contexts. The rate limit bounds the
+  // work done per run; any excess stays buffered for the next run.
+  std::vector<SyslogEventContextRef> batch;
+  size_t offset = 0;
+  while (batch.size() < FLAGS_syslog_rate_limit) {
+    auto line_end = readBuffer_.find('\n', offset);
+    if (line_end == std::string::npos) {
+      break;
+    }
+
+    auto line = readBuffer_.substr(offset, line_end - offset);
+    offset = line_end + 1;
+    if (line.empty()) {
+      continue;
+    }
+
     auto ec = createEventContext();
     Status status = populateEventContext(line, ec);
     if (status.ok()) {
-      fire(ec);
+      batch.push_back(std::move(ec));
       if (errorCount_ > 0) {
         --errorCount_;
       }
@@ -174,14 +205,25 @@ Status SyslogEventPublisher::run() {
       LOG(ERROR) << status.getMessage() << " in line: " << line;
       ++errorCount_;
       if (errorCount_ >= kErrorThreshold) {
+        readBuffer_.erase(0, offset);
         return Status(1, "Too many errors in syslog parsing.");
       }
     }
   }
+  readBuffer_.erase(0, offset);
+
+  // Deliver after parsing so subscriber work never stalls the pipe reads.
+  for (auto& ec : batch) {
+    fire(ec);
+  }
   return Status(0, "OK");
 }
 
 void SyslogEventPublisher::tearDown() {
+  if (readFd_ != -1) {
+    close(readFd_);
+    readFd_ = -1;
+  }
   unlockPipe();
 }
 
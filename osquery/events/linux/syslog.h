@@ -12,8 +12,9 @@
 
 #include <stdio.h>
 
-#include <fstream>
 #include <map>
+#include <string>
+#include <vector>
 
 #include <boost/property_tree/ptree.hpp>
 
@@ -115,9 +116,25 @@ class SyslogEventPublisher
                                      SyslogEventContextRef& ec);
 
   /**
-   * @brief Input stream for reading from the pipe.
+   * @brief Non-blocking descriptor for reading from the pipe.
+   *
+   * The pipe is opened read/write so that the open never waits for a writer
+   * and reads never observe EOF when the last writer disconnects.
+   */
+  int readFd_{-1};
+
+  /**
+   * @brief Scratch buffer reused by every pipe read.
+   */
+  std::vector<char> readChunk_;
+
+  /**
+   * @brief Bytes drained from the pipe but not yet terminated by a newline.
+   *
+   * A burst can be split across reads (and runs); the trailing partial line
+   * is kept here until the rest of it arrives.
    */
-  std::fstream readStream_;
+  std::string readBuffer_;
 
   /**
    * @brief Counter used to shut down thread when too many errors occur.
@@ -133,7 +150,7 @@ class SyslogEventPublisher
    * @brief File descriptor used to lock the pipe for reading.
    *
    * This fd should not be used for reading from the pipe, instead use
-   * readStream_.
+   * readFd_.
    */
   int lockFd_;
 
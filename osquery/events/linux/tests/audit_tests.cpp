@@ -22,6 +22,7 @@
 #include <osquery/tables.h>
 
 #include "osquery/events/linux/auditdnetlink.h"
+#include "osquery/events/linux/auditeventpublisher.h"
 #include "osquery/tests/test_util.h"
 
 namespace osquery {
@@ -95,6 +96,28 @@ TEST_F(AuditTests, test_audit_value_decode) {
   EXPECT_EQ(decoded_fail, "7");
 }
 
+TEST_F(AuditTests, test_audit_event_expiry) {
+  auto current_time = std::time(nullptr);
+
+  // Only the entry past the 5 minute timeout should be swept.
+  auto expired_id = std::to_string(current_time - 600) + ".000:100";
+  auto fresh_id = std::to_string(current_time) + ".000:101";
+
+  AuditTraceContext trace_context;
+  trace_context[expired_id] = AuditEvent();
+  trace_context[fresh_id] = AuditEvent();
+
+  auto orphaned_before = AuditEventPublisher::orphaned_event_count_.load();
+
+  auto event_context = std::make_shared<AuditEventContext>();
+  AuditEventPublisher::ProcessEvents(event_context, {}, trace_context);
+
+  EXPECT_EQ(trace_context.size(), 1U);
+  EXPECT_EQ(trace_context.count(fresh_id), 1U);
+  EXPECT_EQ(AuditEventPublisher::orphaned_event_count_.load(),
+            orphaned_before + 1U);
+}
+
 size_t kAuditCounter{0};
 
 bool SimpleUpdate(size_t t, const StringMap& f, StringMap& m) {
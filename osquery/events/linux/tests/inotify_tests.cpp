@@ -200,6 +200,27 @@ TEST_F(INotifyTests, test_inotify_add_subscription_success) {
   EventFactory::deregisterEventPublisher("inotify");
 }
 
+TEST_F(INotifyTests, test_inotify_warm_restart) {
+  event_pub_ = std::make_shared<INotifyEventPublisher>(true);
+  auto status = EventFactory::registerEventPublisher(event_pub_);
+  EXPECT_TRUE(status.ok());
+  addMonitor("/etc/", IN_ALL_EVENTS, false, true);
+
+  // The serialized state captures the active watch list.
+  std::string state;
+  EXPECT_TRUE(event_pub_->serializeState(state).ok());
+  EXPECT_NE(state.find("/etc/"), std::string::npos);
+
+  // Simulate a replacement process: drop the watches then restore the state.
+  RemoveAll(event_pub_);
+  event_pub_->path_descriptors_.clear();
+  EXPECT_FALSE(event_pub_->isPathMonitored("/etc/passwd"));
+
+  EXPECT_TRUE(event_pub_->restoreState(state).ok());
+  EXPECT_TRUE(event_pub_->isPathMonitored("/etc/passwd"));
+  EventFactory::deregisterEventPublisher("inotify");
+}
+
 TEST_F(INotifyTests, test_inotify_match_subscription) {
   event_pub_ = std::make_shared<INotifyEventPublisher>(true);
   addMonitor("/etc", IN_ALL_EVENTS, false, false);
@@ -96,7 +96,9 @@ TEST_F(AuditdFimTests, row_emission) {
 
   // Configure what we want to log and what we want to ignore
   AuditdFimContext fim_context;
-  fim_context.included_path_list = included_file_paths;
+  for (const auto& path : included_file_paths) {
+    fim_context.included_paths.insert(path);
+  }
 
   // Emit the rows, showing only writes
   std::vector<Row> emitted_row_list;
@@ -10,6 +10,9 @@
 
 #include <poll.h>
 
+#include <map>
+#include <string>
+
 #include <osquery/events.h>
 #include <osquery/filesystem.h>
 #include <osquery/logger.h>
@@ -21,8 +24,35 @@ namespace osquery {
 
 static const int kUdevMLatency = 200;
 
+/// Upper bound on cached devices before the cache is dropped entirely.
+static const size_t kUdevAttrCacheLimit = 1024;
+
+/// Protects the device attribute cache.
+Mutex kUdevAttrCacheMutex;
+
+/**
+ * @brief Cached sysfs attribute values, keyed by device syspath.
+ *
+ * Subscribers look up the same attributes for every event of an
+ * add/change/remove sequence; each udev_device object caches reads only for
+ * its own lifetime, so without this cache every event re-walks sysfs. Remove
+ * and change events invalidate the device's entries.
+ */
+std::map<std::string, std::map<std::string, std::string>> kUdevAttrCache;
+
 REGISTER(UdevEventPublisher, "event_publisher", "udev");
 
+/// Drops the cached attributes for a removed or changed device.
+static void invalidateAttrCache(struct udev_device* device) {
+  auto syspath = udev_device_get_syspath(device);
+  if (syspath == nullptr) {
+    return;
+  }
+
+  WriteLock lock(kUdevAttrCacheMutex);
+  kUdevAttrCache.erase(syspath);
+}
+
 Status UdevEventPublisher::setUp() {
   // The Setup and Teardown workflows should be protected against races.
   // Just in case let's protect the publisher's resources.
@@ -90,10 +120,19 @@ Status UdevEventPublisher::run() {
       return Status(1, "udev monitor failed.");
     }
 
-    auto ec = createEventContextFrom(device);
-    fire(ec);
-
-    udev_device_unref(device);
+    // The monitor socket is non-blocking: drain every queued device before
+    // pausing so enumeration storms do not back up the socket buffer.
+    while (device != nullptr) {
+      auto ec = createEventContextFrom(device);
+      if (ec->action == UDEV_EVENT_ACTION_REMOVE ||
+          ec->action == UDEV_EVENT_ACTION_CHANGE) {
+        invalidateAttrCache(device);
+      }
+      fire(ec);
+
+      udev_device_unref(device);
+      device = udev_monitor_receive_device(monitor_);
+    }
   }
 
   pauseMilli(kUdevMLatency);
@@ -111,11 +150,35 @@ std::string UdevEventPublisher::getValue(struct udev_device* device,
 
 std::string UdevEventPublisher::getAttr(struct udev_device* device,
                                         const std::string& attr) {
+  auto syspath = udev_device_get_syspath(device);
+  if (syspath != nullptr) {
+    WriteLock lock(kUdevAttrCacheMutex);
+    auto device_cache = kUdevAttrCache.find(syspath);
+    if (device_cache != kUdevAttrCache.end()) {
+      auto cached = device_cache->second.find(attr);
+      if (cached != device_cache->second.end()) {
+        return cached->second;
+      }
+    }
+  }
+
+  std::string result;
   auto value = udev_device_get_sysattr_value(device, attr.c_str());
   if (value != nullptr) {
-    return std::string(value);
+    result = std::string(value);
   }
-  return "";
+
+  // Missing attributes are cached too; they are the common case during
+  // partially-enumerated add sequences.
+  if (syspath != nullptr) {
+    WriteLock lock(kUdevAttrCacheMutex);
+    if (kUdevAttrCache.size() >= kUdevAttrCacheLimit) {
+      kUdevAttrCache.clear();
+    }
+    kUdevAttrCache[syspath][attr] = result;
+  }
+
+  return result;
 }
 
 UdevEventContextRef UdevEventPublisher::createEventContextFrom(
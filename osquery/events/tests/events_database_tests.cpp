@@ -30,6 +30,10 @@ namespace osquery {
 DECLARE_uint64(events_expiry);
 DECLARE_uint64(events_max);
 DECLARE_bool(events_optimize);
+DECLARE_uint64(events_batch_size);
+DECLARE_uint64(events_batch_latency);
+DECLARE_bool(events_journal);
+DECLARE_uint64(events_dedup_window);
 
 class EventsDatabaseTests : public ::testing::Test {
   void SetUp() override {
@@ -74,6 +78,16 @@ class DBFakeEventSubscriber : public EventSubscriber<DBFakeEventPublisher> {
     return add(r, t);
   }
 
+  /// Simulate a crash by dropping the in-memory pending batch.
+  void dropPending() {
+    pending_events_.clear();
+  }
+
+  /// Expose the journal replay, normally run at registration.
+  Status testReplay() {
+    return replayJournal();
+  }
+
   size_t getEventsMax() override {
     return max_;
   }
@@ -113,6 +127,111 @@ TEST_F(EventsDatabaseTests, test_event_add) {
   EXPECT_TRUE(status.ok());
 }
 
+TEST_F(EventsDatabaseTests, test_event_batch_commit) {
+  auto sub = std::make_shared<DBFakeEventSubscriber>();
+  sub->doNotExpire();
+
+  auto batch_size = FLAGS_events_batch_size;
+  auto batch_latency = FLAGS_events_batch_latency;
+  FLAGS_events_batch_size = 3;
+  FLAGS_events_batch_latency = 60 * 1000;
+
+  // The first events wait in the pending batch, nothing is written yet.
+  EXPECT_TRUE(sub->testAdd(1).ok());
+  EXPECT_TRUE(sub->testAdd(2).ok());
+  std::vector<std::string> keys;
+  scanDatabaseKeys(kEvents, keys, "data.DBFakePublisher.DBFakeSubscriber");
+  EXPECT_EQ(keys.size(), 0U);
+
+  // The third event reaches the batch size and group-commits all three.
+  EXPECT_TRUE(sub->testAdd(3).ok());
+  keys.clear();
+  scanDatabaseKeys(kEvents, keys, "data.DBFakePublisher.DBFakeSubscriber");
+  EXPECT_EQ(keys.size(), 3U);
+
+  FLAGS_events_batch_size = batch_size;
+  FLAGS_events_batch_latency = batch_latency;
+}
+
+TEST_F(EventsDatabaseTests, test_event_journal_replay) {
+  auto sub = std::make_shared<DBFakeEventSubscriber>();
+  sub->doNotExpire();
+
+  auto batch_size = FLAGS_events_batch_size;
+  auto batch_latency = FLAGS_events_batch_latency;
+  auto journal = FLAGS_events_journal;
+  FLAGS_events_batch_size = 10;
+  FLAGS_events_batch_latency = 60 * 1000;
+  FLAGS_events_journal = true;
+
+  // Both events wait in the pending batch but are journaled immediately.
+  EXPECT_TRUE(sub->testAdd(1).ok());
+  EXPECT_TRUE(sub->testAdd(2).ok());
+  std::vector<std::string> keys;
+  scanDatabaseKeys(kEvents, keys, "data.DBFakePublisher.DBFakeSubscriber");
+  EXPECT_EQ(keys.size(), 0U);
+
+  // A crash loses the in-memory batch; the replay recovers the journal.
+  sub->dropPending();
+  EXPECT_TRUE(sub->testReplay().ok());
+  keys.clear();
+  scanDatabaseKeys(kEvents, keys, "data.DBFakePublisher.DBFakeSubscriber");
+  EXPECT_EQ(keys.size(), 2U);
+
+  // The replay truncated the journal, so a second replay recovers nothing.
+  EXPECT_TRUE(sub->testReplay().ok());
+  keys.clear();
+  scanDatabaseKeys(kEvents, keys, "data.DBFakePublisher.DBFakeSubscriber");
+  EXPECT_EQ(keys.size(), 2U);
+
+  FLAGS_events_batch_size = batch_size;
+  FLAGS_events_batch_latency = batch_latency;
+  FLAGS_events_journal = journal;
+}
+
+TEST_F(EventsDatabaseTests, test_event_deduplication) {
+  auto sub = std::make_shared<DBFakeEventSubscriber>();
+  sub->doNotExpire();
+
+  auto dedup_window = FLAGS_events_dedup_window;
+  FLAGS_events_dedup_window = 10;
+
+  // The first event opens a suppression window for its row content.
+  EXPECT_TRUE(sub->testAdd(100).ok());
+  std::vector<std::string> keys;
+  scanDatabaseKeys(kEvents, keys, "data.DBFakePublisher.DBFakeSubscriber");
+  EXPECT_EQ(keys.size(), 1U);
+
+  // Identical rows within the window are counted and dropped.
+  EXPECT_TRUE(sub->testAdd(100).ok());
+  EXPECT_TRUE(sub->testAdd(105).ok());
+  keys.clear();
+  scanDatabaseKeys(kEvents, keys, "data.DBFakePublisher.DBFakeSubscriber");
+  EXPECT_EQ(keys.size(), 1U);
+
+  // An identical row beyond the window reopens it, carrying the suppressed
+  // total from the previous window.
+  EXPECT_TRUE(sub->testAdd(150).ok());
+  keys.clear();
+  scanDatabaseKeys(kEvents, keys, "data.DBFakePublisher.DBFakeSubscriber");
+  EXPECT_EQ(keys.size(), 2U);
+
+  size_t annotated = 0;
+  for (const auto& key : keys) {
+    std::string data;
+    EXPECT_TRUE(getDatabaseValue(kEvents, key, data).ok());
+    Row r;
+    EXPECT_TRUE(deserializeRowJSON(data, r).ok());
+    if (r.count("suppressed") > 0) {
+      EXPECT_EQ(r.at("suppressed"), "2");
+      annotated++;
+    }
+  }
+  EXPECT_EQ(annotated, 1U);
+
+  FLAGS_events_dedup_window = dedup_window;
+}
+
 TEST_F(EventsDatabaseTests, test_record_indexing) {
   auto sub = std::make_shared<DBFakeEventSubscriber>();
   auto status = sub->testAdd(2);
@@ -145,6 +264,48 @@ TEST_F(EventsDatabaseTests, test_record_indexing) {
   EXPECT_EQ("60.0, 60.1, 60.60, 60.120, 60.121", output);
 }
 
+TEST_F(EventsDatabaseTests, test_record_bin_seeding) {
+  {
+    auto writer = std::make_shared<DBFakeEventSubscriber>();
+    EXPECT_TRUE(writer->testAdd(61).ok());
+    EXPECT_TRUE(writer->testAdd((2 * 3600) + 1).ok());
+  }
+
+  // A fresh subscriber seeds its bin cache from the stored record keys.
+  auto sub = std::make_shared<DBFakeEventSubscriber>();
+  auto indexes = sub->getIndexes(0, 0);
+  auto output = boost::algorithm::join(indexes, ", ");
+  EXPECT_EQ("60.1, 60.120", output);
+}
+
+TEST_F(EventsDatabaseTests, test_legacy_record_migration) {
+  // Pre-upgrade versions stored one comma-joined record list per bin and an
+  // indexes.<ns>.60 list of populated bins.
+  std::string ns = "DBFakePublisher.DBFakeSubscriber";
+  auto legacy_key = "records." + ns + ".60.2";
+  setDatabaseValue(
+      kEvents, legacy_key, "0000000001:121,0000000002:122,corrupted");
+  setDatabaseValue(kEvents, "indexes." + ns + ".60", "2");
+
+  // A fresh subscriber migrates the list while seeding its bin cache.
+  auto sub = std::make_shared<DBFakeEventSubscriber>();
+  auto indexes = sub->getIndexes(0, 0);
+  auto output = boost::algorithm::join(indexes, ", ");
+  EXPECT_EQ("60.2", output);
+
+  auto records = sub->getRecords(indexes);
+  ASSERT_EQ(2U, records.size());
+  EXPECT_EQ("0000000001", records[0].first);
+  EXPECT_EQ(121U, records[0].second);
+  EXPECT_EQ(122U, records[1].second);
+
+  // Both legacy key forms are removed once migrated.
+  std::string value;
+  EXPECT_FALSE(getDatabaseValue(kEvents, legacy_key, value).ok());
+  EXPECT_FALSE(
+      getDatabaseValue(kEvents, "indexes." + ns + ".60", value).ok());
+}
+
 TEST_F(EventsDatabaseTests, test_record_range) {
   auto sub = std::make_shared<DBFakeEventSubscriber>();
   auto status = sub->testAdd(1);
@@ -193,19 +354,18 @@ TEST_F(EventsDatabaseTests, test_record_corruption) {
   auto sub = std::make_shared<DBFakeEventSubscriber>();
 
   std::string corrupted_index = "60.25440186";
-  std::string key =
-      "records.DBFakePublisher.DBFakeSubscriber." + corrupted_index;
-  std::string value =
-      "0002985852:1526411162,0002985853:1526411162,00??E/"
-      "?:1526411170,0002985912:1526411170,0002??E/"
-      "?526411178,0002985921:1526411178,0002985922:1526411178";
-
-  // Set some corrupted values in the DB
-  auto s = setDatabaseValue(kEvents, key, value);
+  std::string key_prefix =
+      "records.DBFakePublisher.DBFakeSubscriber." + corrupted_index + ".";
+
+  // Set some corrupted time values in the DB
+  setDatabaseValue(kEvents, key_prefix + "0002985852", "1526411162");
+  setDatabaseValue(kEvents, key_prefix + "0002985853", "1526411162");
+  setDatabaseValue(kEvents, key_prefix + "0002985912", "??E/?");
+  setDatabaseValue(kEvents, key_prefix + "0002985921", "1526411178");
   auto records = sub->getRecords({corrupted_index});
 
   // We should gracefully skip over corrupted record entries
-  EXPECT_EQ(6U, records.size());
+  EXPECT_EQ(3U, records.size());
 }
 
 TEST_F(EventsDatabaseTests, test_record_expiration) {
@@ -271,8 +431,8 @@ TEST_F(EventsDatabaseTests, test_gentable) {
 
   std::vector<std::string> keys;
   scanDatabaseKeys("events", keys);
-  // 9 data records, 1 eid counter, 3 indexes, 15 index records.
-  // Depending on the moment, an additional 3 indexes may be introduced.
+  // 9 data records, 1 eid counter, 9 record keys.
+  // Depending on the moment, additional records may be introduced.
   EXPECT_LE(16U, keys.size());
 
   // Perform a "select" equivalent.
@@ -297,6 +457,52 @@ TEST_F(EventsDatabaseTests, test_gentable) {
   EXPECT_LE(6U, keys.size());
 }
 
+TEST_F(EventsDatabaseTests, test_metadata_only_get) {
+  auto sub = std::make_shared<DBFakeEventSubscriber>();
+  sub->testAdd(1);
+  sub->testAdd(2);
+  sub->testAdd(11);
+
+  // A scan using only index-covered columns, like COUNT(*) or MIN/MAX(time).
+  auto vtc = new VirtualTableContent();
+  QueryContext context(vtc);
+  context.colsUsed = UsedColumns({"time"});
+  RowGenerator::pull_type generator(std::bind(&EventSubscriberPlugin::genTable,
+                                              sub.get(),
+                                              std::placeholders::_1,
+                                              std::move(context)));
+
+  QueryData results;
+  while (generator) {
+    results.push_back(generator.get());
+    generator();
+  }
+  delete vtc;
+
+  // Rows are built from the record index without the stored event data.
+  ASSERT_EQ(3U, results.size());
+  EXPECT_EQ("1", results[0]["time"]);
+  EXPECT_EQ(0U, results[0].count("testing"));
+}
+
+TEST_F(EventsDatabaseTests, test_query_row_cache) {
+  auto sub = std::make_shared<DBFakeEventSubscriber>();
+  sub->testAdd(1);
+  sub->testAdd(2);
+
+  // The first scan decodes rows from the backing store and caches them.
+  auto results = genRows(sub.get());
+  ASSERT_EQ(2U, results.size());
+
+  // Remove a stored data record. The record index still lists the event and
+  // the cached decoded row serves it without the backing-store read.
+  auto key = "data.DBFakePublisher.DBFakeSubscriber." + results[0]["eid"];
+  deleteDatabaseValue(kEvents, key);
+
+  auto cached = genRows(sub.get());
+  EXPECT_EQ(results.size(), cached.size());
+}
+
 TEST_F(EventsDatabaseTests, test_optimize) {
   auto sub = std::make_shared<DBFakeEventSubscriber>();
   for (size_t i = 800; i < 800 + 10; ++i) {
@@ -380,7 +586,8 @@ TEST_F(EventsDatabaseTests, test_expire_check) {
       scanDatabaseKeys(kEvents, records, record_key);
       scanDatabaseKeys(kEvents, datas, data_key);
 
-      EXPECT_LT(records.size(), 20U);
+      // There is now one record key per buffered event.
+      EXPECT_LT(records.size(), 60U);
       EXPECT_LT(datas.size(), 60U);
     }
   }
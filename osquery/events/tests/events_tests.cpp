@@ -17,8 +17,14 @@
 #include <osquery/registry_factory.h>
 #include <osquery/tables.h>
 
+#include "osquery/core/process.h"
+
 namespace osquery {
 
+DECLARE_uint64(events_expiry);
+DECLARE_uint64(events_max);
+DECLARE_bool(events_on_demand);
+
 class EventsTests : public ::testing::Test {
  public:
   void SetUp() override {
@@ -209,6 +215,34 @@ TEST_F(EventsTests, test_multiple_subscriptions) {
   EXPECT_TRUE(status.ok());
 }
 
+TEST_F(EventsTests, test_on_demand_publisher) {
+  auto active = FLAGS_events_on_demand;
+  FLAGS_events_on_demand = true;
+
+  auto pub = std::make_shared<BasicEventPublisher>();
+  pub->setName("OnDemandPublisher");
+  EventFactory::registerEventPublisher(pub);
+
+  // With no subscriptions the initializer defers the run loop.
+  EventFactory::delay();
+  EXPECT_FALSE(pub->hasStarted());
+
+  // The first subscription starts the deferred publisher.
+  auto subscription = Subscription::create("subscriber");
+  auto status = EventFactory::addSubscription("OnDemandPublisher", subscription);
+  EXPECT_TRUE(status.ok());
+
+  // The run loop thread claims the started state asynchronously.
+  size_t delay = 0;
+  while (!pub->hasStarted() && delay < 2000) {
+    sleepFor(20);
+    delay += 20;
+  }
+  EXPECT_TRUE(pub->hasStarted());
+
+  FLAGS_events_on_demand = active;
+}
+
 struct TestSubscriptionContext : public SubscriptionContext {
   int smallest;
 };
@@ -476,6 +510,31 @@ TEST_F(EventsTests, test_event_subscriber_configure) {
   EXPECT_EQ(sub->timesConfigured, 2U);
 }
 
+TEST_F(EventsTests, test_event_subscriber_retention) {
+  auto sub = std::make_shared<FakeEventSubscriber>();
+  EventFactory::registerEventSubscriber(sub);
+
+  // Without a retention entry the global flags apply.
+  EXPECT_EQ(sub->getEventsExpiry(), FLAGS_events_expiry);
+  EXPECT_EQ(sub->getEventsMax(), FLAGS_events_max);
+
+  // A retention entry overrides both limits for this subscriber only.
+  Config::get().loaded_ = true;
+  Config::get().update(
+      {{"data",
+        "{\"events\": {\"retention\": {\"fake_events\": "
+        "{\"events_expiry\": 7200, \"events_max\": 100}}}}"}});
+  EXPECT_EQ(sub->getEventsExpiry(), 7200U);
+  EXPECT_EQ(sub->getEventsMax(), 100U);
+
+  // Publishing an events dictionary without the entry restores the flags.
+  Config::get().update({{"data", "{\"events\": {}}"}});
+  EXPECT_EQ(sub->getEventsExpiry(), FLAGS_events_expiry);
+  EXPECT_EQ(sub->getEventsMax(), FLAGS_events_max);
+
+  EventFactory::deregisterEventSubscriber(sub->getName());
+}
+
 TEST_F(EventsTests, test_fire_event) {
   auto pub = std::make_shared<BasicEventPublisher>();
   pub->setName("BasicPublisher");
@@ -520,6 +579,47 @@ TEST_F(EventsTests, test_fire_event) {
   EXPECT_TRUE(status.ok());
 }
 
+TEST_F(EventsTests, test_fire_batch) {
+  auto pub = std::make_shared<BasicEventPublisher>();
+  pub->setName("BatchPublisher");
+  auto status = EventFactory::registerEventPublisher(pub);
+  ASSERT_TRUE(status.ok());
+
+  auto sub = std::make_shared<FakeEventSubscriber>();
+  status = EventFactory::registerEventSubscriber(sub);
+  ASSERT_TRUE(status.ok());
+
+  auto subscription = Subscription::create("fake_events");
+  subscription->callback = TestTheeCallback;
+  status = EventFactory::addSubscription("BatchPublisher", subscription);
+  ASSERT_TRUE(status.ok());
+
+  pub->configure();
+
+  // A batch delivers every context to each subscription in one pass.
+  kBellHathTolled = 0;
+  std::vector<EventContextRef> batch = {
+      pub->createEventContext(), pub->createEventContext(),
+  };
+  pub->fire(batch);
+  EXPECT_EQ(kBellHathTolled, 2);
+
+  // Each fired context received a distinct ID and a time.
+  EXPECT_NE(batch[0]->id, batch[1]->id);
+  EXPECT_GT(batch[0]->time, 0U);
+
+  // An empty batch is a no-op.
+  std::vector<EventContextRef> empty_batch;
+  pub->fire(empty_batch);
+  EXPECT_EQ(kBellHathTolled, 2);
+
+  status = EventFactory::deregisterEventSubscriber(sub->getName());
+  EXPECT_TRUE(status.ok());
+
+  status = EventFactory::deregisterEventPublisher(pub->type());
+  EXPECT_TRUE(status.ok());
+}
+
 class SubFakeEventSubscriber : public FakeEventSubscriber {
  public:
   SubFakeEventSubscriber() : FakeEventSubscriber(true) {
@@ -564,4 +664,22 @@ TEST_F(EventsTests, test_event_toggle_subscribers) {
   auto status = EventFactory::deregisterEventSubscriber(sub->getName());
   EXPECT_TRUE(status.ok());
 }
+
+TEST_F(EventsTests, test_event_context_pool) {
+  EventContextPool<FakeEventContext> pool;
+
+  auto first = pool.acquire();
+  auto* storage = first.get();
+  first->required_value = 42;
+  first.reset();
+
+  // The released slot is reset in place and handed back.
+  auto second = pool.acquire();
+  EXPECT_EQ(storage, second.get());
+  EXPECT_EQ(0, second->required_value);
+
+  // A retained context keeps its slot busy; a new slot is allocated.
+  auto third = pool.acquire();
+  EXPECT_NE(second.get(), third.get());
+}
 }
@@ -32,4 +32,27 @@ TEST_F(WindowsEventLogTests, test_register_event_pub) {
   status = EventFactory::deregisterEventPublisher("windows_events");
   EXPECT_TRUE(status.ok());
 }
+
+TEST_F(WindowsEventLogTests, test_build_event_query) {
+  auto sc = std::make_shared<WindowsEventLogSubscriptionContext>();
+  sc->providers = {L"Microsoft-Windows-Sysmon"};
+  sc->event_ids = {1, 5};
+  auto query = WindowsEventLogEventPublisher::buildEventQuery({sc});
+  EXPECT_EQ(query,
+            L"*[System[(Provider[@Name='Microsoft-Windows-Sysmon'] and "
+            L"(EventID=1 or EventID=5))]]");
+
+  // Subscriptions union into one select per channel.
+  auto ids_only = std::make_shared<WindowsEventLogSubscriptionContext>();
+  ids_only->event_ids = {4624};
+  query = WindowsEventLogEventPublisher::buildEventQuery({sc, ids_only});
+  EXPECT_EQ(query,
+            L"*[System[(Provider[@Name='Microsoft-Windows-Sysmon'] and "
+            L"(EventID=1 or EventID=5)) or ((EventID=4624))]]");
+
+  // A subscription without allowlists disables channel pre-filtering.
+  auto all = std::make_shared<WindowsEventLogSubscriptionContext>();
+  query = WindowsEventLogEventPublisher::buildEventQuery({sc, all});
+  EXPECT_EQ(query, L"*");
+}
 }
@@ -13,6 +13,7 @@
 #include <Windows.h>
 
 #include <algorithm>
+#include <map>
 
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/xml_parser.hpp>
@@ -35,31 +36,87 @@ const std::chrono::milliseconds kWinEventLogPause(200);
 
 void WindowsEventLogEventPublisher::configure() {
   stop();
+
+  // Group the subscriptions by channel so allowlists can be unioned into
+  // one service-side query per channel.
+  std::map<std::wstring, std::vector<WindowsEventLogSubscriptionContextRef>>
+      channels;
   for (auto& sub : subscriptions_) {
     auto sc = getSubscriptionContext(sub->context);
     for (const auto& chan : sc->sources) {
-      /*
-       * We don't apply any filtering to the Windows event logs. It's assumed
-       * that if filtering is required, this will be handled via SQL queries
-       * or in the subscriber logic.
-       */
-      auto hSubscription =
-          EvtSubscribe(nullptr,
-                       nullptr,
-                       chan.c_str(),
-                       L"*",
-                       nullptr,
-                       nullptr,
-                       EVT_SUBSCRIBE_CALLBACK(winEventCallback),
-                       EvtSubscribeToFutureEvents);
-      if (hSubscription == nullptr) {
-        LOG(WARNING) << "Failed to subscribe to "
-                     << wstringToString(chan.c_str()) << ": " << GetLastError();
-      } else {
-        win_event_handles_.push_back(hSubscription);
+      channels[chan].push_back(sc);
+    }
+  }
+
+  for (const auto& chan : channels) {
+    /*
+     * Subscriptions without allowlists receive every event, filtered via
+     * SQL queries or subscriber logic. Declared EventID and provider
+     * allowlists compile into the XPath query, so the service drops
+     * unwanted events before they are rendered.
+     */
+    auto query = buildEventQuery(chan.second);
+    auto hSubscription =
+        EvtSubscribe(nullptr,
+                     nullptr,
+                     chan.first.c_str(),
+                     query.c_str(),
+                     nullptr,
+                     nullptr,
+                     EVT_SUBSCRIBE_CALLBACK(winEventCallback),
+                     EvtSubscribeToFutureEvents);
+    if (hSubscription == nullptr) {
+      LOG(WARNING) << "Failed to subscribe to "
+                   << wstringToString(chan.first.c_str()) << ": "
+                   << GetLastError();
+    } else {
+      win_event_handles_.push_back(hSubscription);
+    }
+  }
+}
+
+std::wstring WindowsEventLogEventPublisher::buildEventQuery(
+    const std::vector<WindowsEventLogSubscriptionContextRef>& subscriptions) {
+  std::wstring selects;
+  for (const auto& sc : subscriptions) {
+    if (sc->event_ids.empty() && sc->providers.empty()) {
+      // One subscription wants every event, no pre-filter may be applied.
+      return L"*";
+    }
+
+    std::wstring clause;
+    if (!sc->providers.empty()) {
+      std::wstring providers;
+      for (const auto& provider : sc->providers) {
+        if (!providers.empty()) {
+          providers += L" or ";
+        }
+        providers += L"@Name='" + provider + L"'";
+      }
+      clause = L"Provider[" + providers + L"]";
+    }
+
+    if (!sc->event_ids.empty()) {
+      std::wstring ids;
+      for (const auto& event_id : sc->event_ids) {
+        if (!ids.empty()) {
+          ids += L" or ";
+        }
+        ids += L"EventID=" + std::to_wstring(event_id);
+      }
+      if (!clause.empty()) {
+        clause += L" and ";
       }
+      clause += L"(" + ids + L")";
+    }
+
+    if (!selects.empty()) {
+      selects += L" or ";
     }
+    selects += L"(" + clause + L")";
   }
+
+  return L"*[System[" + selects + L"]]";
 }
 
 Status WindowsEventLogEventPublisher::run() {
@@ -111,49 +168,40 @@ unsigned long __stdcall WindowsEventLogEventPublisher::winEventCallback(
 
 Status WindowsEventLogEventPublisher::parseEvent(EVT_HANDLE evt,
                                                  pt::ptree& propTree) {
-  DWORD buffSize = 0;
+  // Render buffers are pooled per callback thread and reused across events,
+  // instead of a malloc/free round trip for every delivery.
+  thread_local std::vector<WCHAR> xml(4096 / sizeof(WCHAR));
+
   DWORD buffUsed = 0;
   DWORD propCount = 0;
-  LPWSTR xml = nullptr;
-  Status status;
-
   if (!EvtRender(nullptr,
                  evt,
                  EvtRenderEventXml,
-                 buffSize,
-                 xml,
+                 static_cast<DWORD>(xml.size() * sizeof(WCHAR)),
+                 xml.data(),
                  &buffUsed,
                  &propCount)) {
-    if (ERROR_INSUFFICIENT_BUFFER == GetLastError()) {
-      buffSize = buffUsed;
-      xml = static_cast<LPWSTR>(malloc(buffSize));
-      if (xml != nullptr) {
-        EvtRender(nullptr,
-                  evt,
-                  EvtRenderEventXml,
-                  buffSize,
-                  xml,
-                  &buffUsed,
-                  &propCount);
-      } else {
-        status = Status(1, "Unable to reserve memory for event log buffer");
-      }
+    if (ERROR_INSUFFICIENT_BUFFER != GetLastError()) {
+      return Status(GetLastError(), "Event rendering failed");
     }
-  }
-
-  if (ERROR_SUCCESS == GetLastError()) {
-    std::stringstream ss;
-    ss << wstringToString(xml);
-    read_xml(ss, propTree);
-  } else {
-    status = Status(GetLastError(), "Event rendering failed");
-  }
 
-  if (xml != nullptr) {
-    free(xml);
+    // Grow the pooled buffer, it is retained for subsequent events.
+    xml.resize((buffUsed + sizeof(WCHAR) - 1) / sizeof(WCHAR));
+    if (!EvtRender(nullptr,
+                   evt,
+                   EvtRenderEventXml,
+                   static_cast<DWORD>(xml.size() * sizeof(WCHAR)),
+                   xml.data(),
+                   &buffUsed,
+                   &propCount)) {
+      return Status(GetLastError(), "Event rendering failed");
+    }
   }
 
-  return status;
+  std::stringstream ss;
+  ss << wstringToString(xml.data());
+  read_xml(ss, propTree);
+  return Status(0, "OK");
 }
 
 bool WindowsEventLogEventPublisher::shouldFire(
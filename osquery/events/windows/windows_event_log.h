@@ -30,6 +30,18 @@ struct WindowsEventLogSubscriptionContext : public SubscriptionContext {
   /// Channel or Path of the Windows Event Log to subscribe to
   std::set<std::wstring> sources;
 
+  /**
+   * @brief Restrict the subscription to these EventID values.
+   *
+   * Allowlists are compiled into the EvtSubscribe XPath query, so events
+   * outside the list are dropped by the service before they are rendered.
+   * An empty set places no EventID restriction.
+   */
+  std::set<unsigned long> event_ids;
+
+  /// Restrict the subscription to these provider names (empty = all).
+  std::set<std::wstring> providers;
+
  private:
   friend class WindowsEventLogEventPublisher;
 };
@@ -64,9 +76,10 @@ using WindowsEventLogSubscriptionContextRef =
  *
  * This EventPublisher allows EventSubscriber's to subscribe to Windows
  * Event Logs. By default we subscribe to all of the Windows system Event
- * Log channels, and make _no_ filter queries on the events returned by
- * the system, as any desired filtering should be handled at through SQL
- * queries.
+ * Log channels with no filter query, leaving filtering to SQL queries.
+ * Subscriptions may declare EventID and provider allowlists, which are
+ * compiled into the EvtSubscribe XPath query so unwanted events never
+ * pay the render and parse cost.
  */
 class WindowsEventLogEventPublisher
     : public EventPublisher<WindowsEventLogSubscriptionContext,
@@ -94,6 +107,10 @@ class WindowsEventLogEventPublisher
                            boost::property_tree::ptree& propTree);
 
  private:
+  /// Compile per-channel subscription allowlists into an XPath query.
+  static std::wstring buildEventQuery(
+      const std::vector<WindowsEventLogSubscriptionContextRef>& subscriptions);
+
   /// Ensures that all Windows event log subscriptions are removed
   void stop() override;
 
@@ -107,5 +124,6 @@ class WindowsEventLogEventPublisher
  public:
   friend class WindowsEventLogTests;
   FRIEND_TEST(WindowsEventLogTests, test_register_event_pub);
+  FRIEND_TEST(WindowsEventLogTests, test_build_event_query);
 };
 }
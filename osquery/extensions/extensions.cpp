@@ -8,6 +8,7 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <chrono>
 #include <map>
 #include <set>
 #include <string>
@@ -19,6 +20,7 @@
 #include <osquery/core.h>
 #include <osquery/filesystem.h>
 #include <osquery/logger.h>
+#include <osquery/mutex.h>
 #include <osquery/registry.h>
 #include <osquery/system.h>
 
@@ -72,11 +74,71 @@ CLI_FLAG(string,
 
 SHELL_FLAG(string, extension, "", "Path to a single extension to autoload");
 
+namespace {
+/// Liveness and latency bookkeeping for one extension socket path.
+struct ExtensionPathState {
+  /// UNIX time of the last successful liveness check or registry call.
+  size_t verified{0};
+
+  /// Total registry calls dispatched over this socket.
+  size_t calls{0};
+
+  /// Cumulative registry call latency in microseconds.
+  size_t latency{0};
+};
+
+/// Protects access to the extension path state map.
+Mutex kExtensionStateMutex;
+
+/// State for each known extension socket path.
+std::map<std::string, ExtensionPathState> kExtensionState;
+
+/// Seconds a successful liveness check remains valid.
+size_t extensionFreshness() {
+  size_t interval = atoi(FLAGS_extensions_interval.c_str());
+  return (interval == 0) ? 3 : interval;
+}
+
+/// Check if a path passed a liveness check within the freshness window.
+bool extensionPathFresh(const std::string& path) {
+  ReadLock lock(kExtensionStateMutex);
+  auto it = kExtensionState.find(path);
+  return (it != kExtensionState.end() &&
+          getUnixTime() < it->second.verified + extensionFreshness());
+}
+
+/// Record a successful liveness check for a path.
+void markExtensionPathVerified(const std::string& path) {
+  WriteLock lock(kExtensionStateMutex);
+  kExtensionState[path].verified = getUnixTime();
+}
+
+/// Account a completed registry call, which also proves liveness.
+void recordExtensionCall(const std::string& path, size_t latency) {
+  WriteLock lock(kExtensionStateMutex);
+  auto& state = kExtensionState[path];
+  state.verified = getUnixTime();
+  state.calls++;
+  state.latency += latency;
+}
+
+/// Forget a path, applied when an extension fails or is deregistered.
+void clearExtensionPathState(const std::string& path) {
+  WriteLock lock(kExtensionStateMutex);
+  kExtensionState.erase(path);
+}
+} // namespace
+
 CLI_FLAG(string,
          extensions_require,
          "",
          "Comma-separated list of required extensions");
 
+CLI_FLAG(bool,
+         extensions_shm_transfer,
+         false,
+         "Transfer bulk extension results through shared memory (POSIX only)");
+
 /**
  * @brief Alias the extensions_socket (used by core) to a simple 'socket'.
  *
@@ -165,7 +227,7 @@ Status extensionPathActive(const std::string& path, bool use_timeout = false) {
         // Create a client with a 10-second receive timeout.
         ExtensionManagerClient client(path, 10 * 1000);
         auto status = client.ping();
-        return Status(0, "OK");
+        return Status::success();
       } catch (const std::exception& /* e */) {
         // Path might exist without a connected extension or extension manager.
       }
@@ -277,6 +339,11 @@ void ExtensionManagerWatcher::watch() {
     // If failures get to 2 then the extension will be removed.
     failures_[uuid] = 1;
     if (exists.ok()) {
+      if (extensionPathFresh(path)) {
+        // A recent registry call or check already proved liveness; coalesce
+        // this health check with that traffic instead of pinging again.
+        continue;
+      }
       try {
         ExtensionClient client(path);
         // Ping the extension until it goes down.
@@ -295,6 +362,7 @@ void ExtensionManagerWatcher::watch() {
       LOG(INFO) << "Extension UUID " << uuid << " ping failed";
       failures_[uuid] += 1;
     } else {
+      markExtensionPathVerified(path);
       failures_[uuid] = 1;
     }
   }
@@ -302,6 +370,7 @@ void ExtensionManagerWatcher::watch() {
   for (const auto& uuid : failures_) {
     if (uuid.second > 1) {
       LOG(INFO) << "Extension UUID " << uuid.first << " has gone away";
+      clearExtensionPathState(getExtensionSocket(uuid.first));
       RegistryFactory::get().removeBroadcast(uuid.first);
       failures_[uuid.first] = 1;
     }
@@ -427,7 +496,7 @@ Status loadExtensions(const std::string& loadfile) {
     // forking and executing the extension binary.
     Watcher::get().addExtensionPath(binary);
   }
-  return Status(0, "OK");
+  return Status::success();
 }
 
 Status startExtension(const std::string& name, const std::string& version) {
@@ -512,7 +581,8 @@ Status startExtension(const std::string& manager_path,
   rf.setActive("config", options["config_plugin"].value);
   rf.setActive("logger", options["logger_plugin"].value);
   rf.setActive("distributed", options["distributed_plugin"].value);
-  // Set up all lazy registry plugins and the active config/logger plugin.
+  // Run setUp for any remaining non-lazy registries. The active plugins were
+  // set up when they were activated above.
   rf.setUp();
 
   // Start the extension's Thrift server
@@ -633,7 +703,7 @@ Status getExtensions(const std::string& manager_path,
                              ext.second.sdk_version};
   }
 
-  return Status(0, "OK");
+  return Status::success();
 }
 
 Status callExtension(const RouteUUID uuid,
@@ -653,22 +723,52 @@ Status callExtension(const std::string& extension_path,
                      const std::string& item,
                      const PluginRequest& request,
                      PluginResponse& response) {
-  // Make sure the extension manager path exists, and is writable.
-  auto status = extensionPathActive(extension_path);
-  if (!status.ok()) {
-    return status;
+  // A liveness check verified within the watcher interval is reused, so a
+  // burst of registry calls costs one pre-call ping instead of one each.
+  Status status;
+  if (!extensionPathFresh(extension_path)) {
+    // Make sure the extension manager path exists, and is writable.
+    status = extensionPathActive(extension_path);
+    if (!status.ok()) {
+      return status;
+    }
+    markExtensionPathVerified(extension_path);
   }
 
+  // Table generate requests may return many rows, use the chunked transfer.
+  auto generate = (request.count("action") > 0 &&
+                   request.at("action") == "generate");
+
+  auto started = std::chrono::steady_clock::now();
   try {
     ExtensionClient client(extension_path);
-    status = client.call(registry, item, request, response);
+    if (generate) {
+      status = client.callChunked(registry, item, request, response);
+    } else {
+      status = client.call(registry, item, request, response);
+    }
   } catch (const std::exception& e) {
+    // The next call must re-verify the socket before it is trusted again.
+    clearExtensionPathState(extension_path);
     return Status(1, "Extension call failed: " + std::string(e.what()));
   }
 
+  auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::steady_clock::now() - started)
+                     .count();
+  recordExtensionCall(extension_path, static_cast<size_t>(latency));
   return status;
 }
 
+void getExtensionStats(const std::string& path,
+                       size_t& calls,
+                       size_t& latency) {
+  ReadLock lock(kExtensionStateMutex);
+  auto it = kExtensionState.find(path);
+  calls = (it != kExtensionState.end()) ? it->second.calls : 0;
+  latency = (it != kExtensionState.end()) ? it->second.latency : 0;
+}
+
 Status startExtensionWatcher(const std::string& manager_path,
                              size_t interval,
                              bool fatal) {
@@ -681,7 +781,7 @@ Status startExtensionWatcher(const std::string& manager_path,
   // Start a extension watcher, if the manager dies, so should we.
   Dispatcher::addService(
       std::make_shared<ExtensionWatcher>(manager_path, interval, fatal));
-  return Status(0, "OK");
+  return Status::success();
 }
 
 Status startExtensionManager() {
@@ -740,6 +840,6 @@ Status startExtensionManager(const std::string& manager_path) {
     }
   }
 
-  return Status(0, "OK");
+  return Status::success();
 }
 } // namespace osquery
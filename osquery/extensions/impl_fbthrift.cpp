@@ -10,8 +10,10 @@
 
 #include <osquery/core.h>
 #include <osquery/filesystem.h>
+#include <osquery/flags.h>
 #include <osquery/system.h>
 
+#include <thrift/lib/cpp/TApplicationException.h>
 #include <thrift/lib/cpp/async/TAsyncSocket.h>
 #include <thrift/lib/cpp2/async/HeaderClientChannel.h>
 #include <thrift/lib/cpp2/server/ThriftServer.h>
@@ -24,6 +26,8 @@
 
 namespace osquery {
 
+DECLARE_bool(extensions_shm_transfer);
+
 using namespace extensions;
 
 class ExtensionHandler : virtual public extensions::ExtensionSvIf,
@@ -42,6 +46,19 @@ class ExtensionHandler : virtual public extensions::ExtensionSvIf,
             const std::string& item,
             const ExtensionPluginRequest& request) override;
 
+  using ExtensionInterface::callChunked;
+  void callChunked(ExtensionBatch& _return,
+                   const std::string& registry,
+                   const std::string& item,
+                   const ExtensionPluginRequest& request,
+                   const int64_t max_rows,
+                   const bool shm) override;
+
+  using ExtensionInterface::callChunkedNext;
+  void callChunkedNext(ExtensionBatch& _return,
+                       const int64_t token,
+                       const bool shm) override;
+
   using ExtensionInterface::shutdown;
   void shutdown() override;
 
@@ -129,6 +146,54 @@ void ExtensionHandler::call(ExtensionResponse& _return,
   }
 }
 
+void ExtensionHandler::callChunked(ExtensionBatch& _return,
+                                   const std::string& registry,
+                                   const std::string& item,
+                                   const ExtensionPluginRequest& request,
+                                   const int64_t max_rows,
+                                   const bool shm) {
+  PluginRequest plugin_request;
+  for (const auto& request_item : request) {
+    // Create a PluginRequest from an ExtensionPluginRequest.
+    plugin_request[request_item.first] = request_item.second;
+  }
+
+  int64_t token = 0;
+  bool done = true;
+  auto s = ExtensionInterface::callChunked(registry,
+                                           item,
+                                           plugin_request,
+                                           static_cast<size_t>(max_rows),
+                                           _return.rows,
+                                           token,
+                                           done);
+  _return.status.code = s.getCode();
+  _return.status.message = s.getMessage();
+  _return.status.uuid = getUUID();
+  _return.token = token;
+  _return.done = done;
+  if (s.ok() && shm) {
+    // Best effort, on failure the batch remains inline.
+    externalizeRowBatch(_return.rows, _return.shm_path);
+  }
+}
+
+void ExtensionHandler::callChunkedNext(ExtensionBatch& _return,
+                                       const int64_t token,
+                                       const bool shm) {
+  bool done = true;
+  auto s = ExtensionInterface::callChunkedNext(token, _return.rows, done);
+  _return.status.code = s.getCode();
+  _return.status.message = s.getMessage();
+  _return.status.uuid = getUUID();
+  _return.token = token;
+  _return.done = done;
+  if (s.ok() && shm) {
+    // Best effort, on failure the batch remains inline.
+    externalizeRowBatch(_return.rows, _return.shm_path);
+  }
+}
+
 void ExtensionHandler::shutdown() {}
 
 RouteUUID ExtensionHandler::getUUID() const {
@@ -344,13 +409,63 @@ Status ExtensionClient::call(const std::string& registry,
   ExtensionResponse er;
   auto client = manager() ? client_->em.get() : client_->e.get();
   client->sync_call(er, registry, item, request);
-  for (const auto& r : er.response) {
-    response.push_back(r);
+  response.reserve(response.size() + er.response.size());
+  for (auto& r : er.response) {
+    response.push_back(std::move(r));
   }
 
   return Status(er.status.code, er.status.message);
 }
 
+Status ExtensionClient::callChunked(const std::string& registry,
+                                    const std::string& item,
+                                    const PluginRequest& request,
+                                    PluginResponse& response) {
+  auto client = manager() ? client_->em.get() : client_->e.get();
+  auto shm = FLAGS_extensions_shm_transfer;
+
+  ExtensionBatch batch;
+  try {
+    client->sync_callChunked(batch, registry, item, request, 0, shm);
+  } catch (const apache::thrift::TApplicationException& /* e */) {
+    // The peer predates the chunked API, fall back to a whole-result call.
+    return call(registry, item, request, response);
+  }
+
+  while (true) {
+    if (batch.status.code != 0) {
+      return Status(batch.status.code, batch.status.message);
+    }
+
+    Status s;
+    if (!batch.shm_path.empty()) {
+      // The peer parked this batch in shared memory, the socket message
+      // carried only its name.
+      s = internalizeRowBatch(batch.shm_path, batch.rows);
+    }
+
+    std::string serialized;
+    if (s.ok()) {
+      s = decompressRowBatch(batch.rows, serialized);
+    }
+    if (s.ok()) {
+      // The binary codec appends each batch's rows to the response.
+      s = deserializeQueryDataBinary(serialized, response);
+    }
+    if (!s.ok()) {
+      return s;
+    }
+
+    if (batch.done) {
+      return Status(0);
+    }
+
+    auto token = batch.token;
+    batch = ExtensionBatch();
+    client->sync_callChunkedNext(batch, token, shm);
+  }
+}
+
 void ExtensionClient::shutdown() {
   auto client = manager() ? client_->em.get() : client_->e.get();
   client->sync_shutdown();
@@ -399,8 +514,9 @@ Status ExtensionManagerClient::registerExtension(
 Status ExtensionManagerClient::query(const std::string& sql, QueryData& qd) {
   ExtensionResponse er;
   client_->em->sync_query(er, sql);
-  for (const auto& row : er.response) {
-    qd.push_back(row);
+  qd.reserve(qd.size() + er.response.size());
+  for (auto& row : er.response) {
+    qd.push_back(std::move(row));
   }
 
   return Status();
@@ -410,8 +526,9 @@ Status ExtensionManagerClient::getQueryColumns(const std::string& sql,
                                                QueryData& qd) {
   ExtensionResponse er;
   client_->em->sync_getQueryColumns(er, sql);
-  for (const auto& row : er.response) {
-    qd.push_back(row);
+  qd.reserve(qd.size() + er.response.size());
+  for (auto& row : er.response) {
+    qd.push_back(std::move(row));
   }
 
   return Status(er.status.code, er.status.message);
@@ -10,8 +10,10 @@
 
 #include <osquery/core.h>
 #include <osquery/filesystem.h>
+#include <osquery/flags.h>
 #include <osquery/system.h>
 
+#include <thrift/TApplicationException.h>
 #include <thrift/concurrency/ThreadManager.h>
 #include <thrift/protocol/TBinaryProtocol.h>
 #include <thrift/server/TThreadedServer.h>
@@ -32,6 +34,8 @@
 
 namespace osquery {
 
+DECLARE_bool(extensions_shm_transfer);
+
 using namespace apache::thrift::protocol;
 using namespace apache::thrift::transport;
 using namespace apache::thrift::server;
@@ -61,6 +65,19 @@ class ExtensionHandler : virtual public extensions::ExtensionIf,
             const std::string& item,
             const extensions::ExtensionPluginRequest& request) override;
 
+  using ExtensionInterface::callChunked;
+  void callChunked(extensions::ExtensionBatch& _return,
+                   const std::string& registry,
+                   const std::string& item,
+                   const extensions::ExtensionPluginRequest& request,
+                   const int64_t max_rows,
+                   const bool shm) override;
+
+  using ExtensionInterface::callChunkedNext;
+  void callChunkedNext(extensions::ExtensionBatch& _return,
+                       const int64_t token,
+                       const bool shm) override;
+
   using ExtensionInterface::shutdown;
   void shutdown() override;
 
@@ -107,6 +124,8 @@ class ExtensionManagerHandler : virtual public extensions::ExtensionManagerIf,
 
  public:
   using ExtensionHandler::call;
+  using ExtensionHandler::callChunked;
+  using ExtensionHandler::callChunkedNext;
   using ExtensionHandler::ping;
   using ExtensionHandler::shutdown;
 };
@@ -160,6 +179,55 @@ void ExtensionHandler::call(extensions::ExtensionResponse& _return,
   }
 }
 
+void ExtensionHandler::callChunked(
+    extensions::ExtensionBatch& _return,
+    const std::string& registry,
+    const std::string& item,
+    const extensions::ExtensionPluginRequest& request,
+    const int64_t max_rows,
+    const bool shm) {
+  PluginRequest plugin_request;
+  for (const auto& request_item : request) {
+    // Create a PluginRequest from an ExtensionPluginRequest.
+    plugin_request[request_item.first] = request_item.second;
+  }
+
+  int64_t token = 0;
+  bool done = true;
+  auto s = ExtensionInterface::callChunked(registry,
+                                           item,
+                                           plugin_request,
+                                           static_cast<size_t>(max_rows),
+                                           _return.rows,
+                                           token,
+                                           done);
+  _return.status.code = s.getCode();
+  _return.status.message = s.getMessage();
+  _return.status.uuid = getUUID();
+  _return.token = token;
+  _return.done = done;
+  if (s.ok() && shm) {
+    // Best effort, on failure the batch remains inline.
+    externalizeRowBatch(_return.rows, _return.shm_path);
+  }
+}
+
+void ExtensionHandler::callChunkedNext(extensions::ExtensionBatch& _return,
+                                       const int64_t token,
+                                       const bool shm) {
+  bool done = true;
+  auto s = ExtensionInterface::callChunkedNext(token, _return.rows, done);
+  _return.status.code = s.getCode();
+  _return.status.message = s.getMessage();
+  _return.status.uuid = getUUID();
+  _return.token = token;
+  _return.done = done;
+  if (s.ok() && shm) {
+    // Best effort, on failure the batch remains inline.
+    externalizeRowBatch(_return.rows, _return.shm_path);
+  }
+}
+
 void ExtensionHandler::shutdown() {}
 
 RouteUUID ExtensionHandler::getUUID() const {
@@ -374,13 +442,63 @@ Status ExtensionClient::call(const std::string& registry,
   extensions::ExtensionResponse er;
   auto client = manager() ? client_->em : client_->e;
   client->call(er, registry, item, request);
-  for (const auto& r : er.response) {
-    response.push_back(r);
+  response.reserve(response.size() + er.response.size());
+  for (auto& r : er.response) {
+    response.push_back(std::move(r));
   }
 
   return Status(er.status.code, er.status.message);
 }
 
+Status ExtensionClient::callChunked(const std::string& registry,
+                                    const std::string& item,
+                                    const PluginRequest& request,
+                                    PluginResponse& response) {
+  auto client = manager() ? client_->em : client_->e;
+  auto shm = FLAGS_extensions_shm_transfer;
+
+  extensions::ExtensionBatch batch;
+  try {
+    client->callChunked(batch, registry, item, request, 0, shm);
+  } catch (const apache::thrift::TApplicationException& /* e */) {
+    // The peer predates the chunked API, fall back to a whole-result call.
+    return call(registry, item, request, response);
+  }
+
+  while (true) {
+    if (batch.status.code != 0) {
+      return Status(batch.status.code, batch.status.message);
+    }
+
+    Status s;
+    if (!batch.shm_path.empty()) {
+      // The peer parked this batch in shared memory, the socket message
+      // carried only its name.
+      s = internalizeRowBatch(batch.shm_path, batch.rows);
+    }
+
+    std::string serialized;
+    if (s.ok()) {
+      s = decompressRowBatch(batch.rows, serialized);
+    }
+    if (s.ok()) {
+      // The binary codec appends each batch's rows to the response.
+      s = deserializeQueryDataBinary(serialized, response);
+    }
+    if (!s.ok()) {
+      return s;
+    }
+
+    if (batch.done) {
+      return Status(0);
+    }
+
+    auto token = batch.token;
+    batch = extensions::ExtensionBatch();
+    client->callChunkedNext(batch, token, shm);
+  }
+}
+
 void ExtensionClient::shutdown() {
   auto client = manager() ? client_->em : client_->e;
   client->shutdown();
@@ -429,8 +547,9 @@ Status ExtensionManagerClient::registerExtension(
 Status ExtensionManagerClient::query(const std::string& sql, QueryData& qd) {
   extensions::ExtensionResponse er;
   client_->em->query(er, sql);
-  for (const auto& row : er.response) {
-    qd.push_back(row);
+  qd.reserve(qd.size() + er.response.size());
+  for (auto& row : er.response) {
+    qd.push_back(std::move(row));
   }
 
   return Status();
@@ -440,8 +559,9 @@ Status ExtensionManagerClient::getQueryColumns(const std::string& sql,
                                                QueryData& qd) {
   extensions::ExtensionResponse er;
   client_->em->getQueryColumns(er, sql);
-  for (const auto& row : er.response) {
-    qd.push_back(row);
+  qd.reserve(qd.size() + er.response.size());
+  for (auto& row : er.response) {
+    qd.push_back(std::move(row));
   }
 
   return Status(er.status.code, er.status.message);
@@ -8,11 +8,24 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdlib>
+#include <cstring>
+#include <iterator>
 #include <string>
 #include <vector>
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <zstd.h>
+
 #include <osquery/core.h>
 #include <osquery/filesystem.h>
 #include <osquery/logger.h>
@@ -29,6 +42,18 @@ const std::vector<std::string> kSDKVersionChanges = {
     {"1.7.7"},
 };
 
+/// Default maximum number of rows transferred per chunked call batch.
+const size_t kExtensionBatchRows{5000};
+
+/// Maximum number of concurrently parked chunked calls.
+const size_t kExtensionMaxChunkedCalls{16};
+
+/// Batches smaller than this stay inline, shared memory would not pay off.
+const size_t kExtensionShmMinBytes{4096};
+
+/// Monotonic sequence making shared-memory object names unique per process.
+static std::atomic<size_t> kShmSequence{0};
+
 Status ExtensionInterface::ping() {
   // Need to translate return code into 0 and extract the UUID.
   assert(uuid_ < INT_MAX);
@@ -51,6 +76,77 @@ Status ExtensionInterface::call(const std::string& registry,
   return RegistryFactory::call(registry, local_item, request, response);
 }
 
+Status ExtensionInterface::callChunked(const std::string& registry,
+                                       const std::string& item,
+                                       const PluginRequest& request,
+                                       size_t max_rows,
+                                       std::string& rows,
+                                       int64_t& token,
+                                       bool& done) {
+  PluginResponse response;
+  auto status = call(registry, item, request, response);
+  if (!status.ok()) {
+    return status;
+  }
+
+  if (max_rows == 0) {
+    max_rows = kExtensionBatchRows;
+  }
+
+  // Slice the response into serialized, compressed batches.
+  std::deque<std::string> batches;
+  size_t offset = 0;
+  do {
+    auto end = std::min(offset + max_rows, response.size());
+    QueryData slice(std::make_move_iterator(response.begin() + offset),
+                    std::make_move_iterator(response.begin() + end));
+    std::string serialized;
+    status = serializeQueryDataBinary(slice, serialized);
+    if (!status.ok()) {
+      return status;
+    }
+
+    batches.emplace_back();
+    status = compressRowBatch(serialized, batches.back());
+    if (!status.ok()) {
+      return status;
+    }
+    offset = end;
+  } while (offset < response.size());
+
+  rows = std::move(batches.front());
+  batches.pop_front();
+  done = batches.empty();
+  if (!done) {
+    WriteLock lock(chunked_mutex_);
+    if (chunked_calls_.size() >= kExtensionMaxChunkedCalls) {
+      // Drop the oldest abandoned call rather than grow without bound.
+      chunked_calls_.erase(chunked_calls_.begin());
+    }
+    token = ++chunked_token_;
+    chunked_calls_[token] = std::move(batches);
+  }
+  return Status(0);
+}
+
+Status ExtensionInterface::callChunkedNext(int64_t token,
+                                           std::string& rows,
+                                           bool& done) {
+  WriteLock lock(chunked_mutex_);
+  auto pending = chunked_calls_.find(token);
+  if (pending == chunked_calls_.end()) {
+    return Status(1, "Unknown chunked call token");
+  }
+
+  rows = std::move(pending->second.front());
+  pending->second.pop_front();
+  done = pending->second.empty();
+  if (done) {
+    chunked_calls_.erase(pending);
+  }
+  return Status(0);
+}
+
 void ExtensionInterface::shutdown() {
   // Request a graceful shutdown of the Thrift listener.
   VLOG(1) << "Extension " << uuid_ << " requested shutdown";
@@ -182,6 +278,109 @@ bool ExtensionManagerInterface::exists(const std::string& name) {
   return false;
 }
 
+Status compressRowBatch(const std::string& rows, std::string& compressed) {
+  compressed.resize(ZSTD_compressBound(rows.size()));
+  auto rc = ZSTD_compress(
+      &compressed[0], compressed.size(), rows.data(), rows.size(), 1);
+  if (ZSTD_isError(rc)) {
+    return Status(
+        1, "Batch compression failed: " + std::string(ZSTD_getErrorName(rc)));
+  }
+  compressed.resize(rc);
+  return Status(0);
+}
+
+Status decompressRowBatch(const std::string& compressed, std::string& rows) {
+  auto expected =
+      ZSTD_getFrameContentSize(compressed.data(), compressed.size());
+  if (expected == ZSTD_CONTENTSIZE_ERROR ||
+      expected == ZSTD_CONTENTSIZE_UNKNOWN) {
+    return Status(1, "Invalid batch content size");
+  }
+
+  rows.resize(static_cast<size_t>(expected));
+  auto rc = ZSTD_decompress(
+      &rows[0], rows.size(), compressed.data(), compressed.size());
+  if (ZSTD_isError(rc)) {
+    return Status(
+        1,
+        "Batch decompression failed: " + std::string(ZSTD_getErrorName(rc)));
+  }
+  rows.resize(rc);
+  return Status(0);
+}
+
+Status externalizeRowBatch(std::string& rows, std::string& shm_path) {
+#ifdef WIN32
+  return Status(1, "Shared-memory transfer is not supported");
+#else
+  if (rows.size() < kExtensionShmMinBytes) {
+    return Status(1, "Batch too small to externalize");
+  }
+
+  auto name = "/osquery." + std::to_string(getpid()) + "." +
+              std::to_string(++kShmSequence);
+  auto fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    return Status(1, "Cannot create shared-memory object");
+  }
+
+  Status status;
+  if (ftruncate(fd, rows.size()) != 0) {
+    status = Status(1, "Cannot size shared-memory object");
+  } else {
+    auto map = mmap(nullptr, rows.size(), PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+      status = Status(1, "Cannot map shared-memory object");
+    } else {
+      memcpy(map, rows.data(), rows.size());
+      munmap(map, rows.size());
+    }
+  }
+
+  close(fd);
+  if (!status.ok()) {
+    shm_unlink(name.c_str());
+    return status;
+  }
+
+  rows.clear();
+  shm_path = name;
+  return Status(0);
+#endif
+}
+
+Status internalizeRowBatch(const std::string& shm_path, std::string& rows) {
+#ifdef WIN32
+  return Status(1, "Shared-memory transfer is not supported");
+#else
+  auto fd = shm_open(shm_path.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return Status(1, "Cannot open shared-memory object");
+  }
+
+  Status status;
+  struct stat sb;
+  if (fstat(fd, &sb) != 0 || sb.st_size < 0) {
+    status = Status(1, "Cannot stat shared-memory object");
+  } else {
+    auto size = static_cast<size_t>(sb.st_size);
+    auto map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+      status = Status(1, "Cannot map shared-memory object");
+    } else {
+      rows.assign(static_cast<const char*>(map), size);
+      munmap(map, size);
+    }
+  }
+
+  close(fd);
+  // The object is single-use, remove it once consumed.
+  shm_unlink(shm_path.c_str());
+  return status;
+#endif
+}
+
 void removeStalePaths(const std::string& manager) {
   std::vector<std::string> paths;
   // Attempt to remove all stale extension sockets.
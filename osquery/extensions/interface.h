@@ -10,6 +10,10 @@
 
 #pragma once
 
+#include <deque>
+#include <map>
+#include <string>
+
 #include <osquery/dispatcher.h>
 #include <osquery/extensions.h>
 #include <osquery/query.h>
@@ -99,9 +103,47 @@ class ExtensionInterface : public ExtensionAPI {
                       PluginResponse& response) override;
   virtual void shutdown() override;
 
+  /**
+   * @brief Call a registry plugin, transferring rows in compressed batches.
+   *
+   * The plugin call itself remains whole-result, but the response is sliced
+   * into batches of at most max_rows rows, serialized with the binary results
+   * codec, and compressed. The first batch is returned immediately and the
+   * remainder are parked under a continuation token, drained by
+   * callChunkedNext. This bounds the per-message Thrift marshaling cost for
+   * very large tables.
+   *
+   * @param registry The name of the target registry.
+   * @param item The registry item (plugin) name.
+   * @param request The PluginRequest to forward to the plugin.
+   * @param max_rows Maximum rows per batch, 0 selects the default.
+   * @param rows [output] The first compressed batch of rows.
+   * @param token [output] Continuation token, only valid when done is false.
+   * @param done [output] True if this was the only (or last) batch.
+   */
+  Status callChunked(const std::string& registry,
+                     const std::string& item,
+                     const PluginRequest& request,
+                     size_t max_rows,
+                     std::string& rows,
+                     int64_t& token,
+                     bool& done);
+
+  /// Fetch the next parked batch of a chunked call.
+  Status callChunkedNext(int64_t token, std::string& rows, bool& done);
+
  protected:
   /// Transient UUID assigned to the extension after registering.
   std::atomic<RouteUUID> uuid_;
+
+  /// Parked batches for in-progress chunked calls, keyed by token.
+  std::map<int64_t, std::deque<std::string>> chunked_calls_;
+
+  /// The most recently issued chunked call continuation token.
+  int64_t chunked_token_{0};
+
+  /// Mutex protecting the chunked call state.
+  Mutex chunked_mutex_;
 };
 
 /**
@@ -367,6 +409,18 @@ class ExtensionClient : public ExtensionClientCore, public ExtensionAPI {
               const PluginRequest& request,
               PluginResponse& response) override;
 
+  /**
+   * @brief Call an extension's plugin, transferring rows in batches.
+   *
+   * Prefer this for table generate requests whose results may be large. If
+   * the peer predates the chunked API this transparently falls back to a
+   * whole-result call.
+   */
+  Status callChunked(const std::string& registry,
+                     const std::string& item,
+                     const PluginRequest& request,
+                     PluginResponse& response);
+
   /// Request that the extension stop.
   void shutdown() override;
 };
@@ -407,6 +461,25 @@ class ExtensionManagerClient : public ExtensionClient,
   Status getQueryColumns(const std::string& sql, QueryData& qd) override;
 };
 
+/// Compress a serialized batch of rows with zstd.
+Status compressRowBatch(const std::string& rows, std::string& compressed);
+
+/// Inverse of compressRowBatch.
+Status decompressRowBatch(const std::string& compressed, std::string& rows);
+
+/**
+ * @brief Move a bulk batch payload into a new shared-memory object.
+ *
+ * For co-located peers this avoids pushing bulk rows through the socket,
+ * which is kept for control messages. On success the payload is cleared and
+ * shm_path names the single-use object; on failure (including POSIX-only
+ * support and batches too small to benefit) the payload is left inline.
+ */
+Status externalizeRowBatch(std::string& rows, std::string& shm_path);
+
+/// Inverse of externalizeRowBatch, consuming (unlinking) the object.
+Status internalizeRowBatch(const std::string& shm_path, std::string& rows);
+
 /// Attempt to remove all stale extension sockets.
 void removeStalePaths(const std::string& manager);
 } // namespace osquery
@@ -236,6 +236,16 @@ class PlatformFile : private boost::noncopyable {
   /// Inspect the file size.
   size_t size() const;
 
+  /**
+   * @brief Hint that the file's content will be read sequentially soon.
+   *
+   * The platform is asked to begin readahead of the first size bytes into
+   * the page cache, overlapping the disk wait with the caller's other work.
+   * The hint is advisory and never blocks on the content; platforms without
+   * an equivalent ignore it.
+   */
+  void readAheadHint(size_t size) const;
+
  private:
   boost::filesystem::path fname_;
 
@@ -257,6 +267,49 @@ class PlatformFile : private boost::noncopyable {
 #endif
 };
 
+/**
+ * @brief A read-only memory mapping of an open file's content.
+ *
+ * Mapping lets large flat files be hashed or copied without intermediate heap
+ * buffers, with the page cache backing the reads. The mapping is best-effort:
+ * if the platform cannot map the file (an empty or special file, or exhausted
+ * address space) the object remains invalid and callers are expected to fall
+ * back to a buffered read path.
+ */
+class PlatformFileMapping : private boost::noncopyable {
+ public:
+  explicit PlatformFileMapping(const PlatformFile& file);
+
+  ~PlatformFileMapping();
+
+  /// Checks whether the file content was successfully mapped.
+  bool isValid() const {
+    return (base_ != nullptr);
+  }
+
+  /// The first byte of the mapped file content.
+  const char* data() const {
+    return base_;
+  }
+
+  /// The number of mapped bytes.
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  /// The base address of the mapped region.
+  const char* base_{nullptr};
+
+  /// The size of the mapped region in bytes.
+  size_t size_{0};
+
+#ifdef WIN32
+  /// The Windows file-mapping object backing the view.
+  HANDLE mapping_{nullptr};
+#endif
+};
+
 /**
  * @brief Returns the current user's home directory.
  *
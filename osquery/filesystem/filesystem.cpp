@@ -8,7 +8,9 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <atomic>
 #include <sstream>
+#include <thread>
 
 #include <fcntl.h>
 #include <sys/stat.h>
@@ -47,6 +49,11 @@ HIDDEN_FLAG(bool, allow_unsafe, false, "Allow unsafe executable permissions");
 /// Disable forensics (atime/mtime preserving) file reads.
 HIDDEN_FLAG(bool, disable_forensic, true, "Disable atime/mtime preservation");
 
+FLAG(uint32,
+     file_walk_threads,
+     4,
+     "Number of threads used to walk file and hash table targets");
+
 static const size_t kMaxRecursiveGlobs = 64;
 
 Status writeTextFile(const fs::path& path,
@@ -302,6 +309,18 @@ static void genGlobs(std::string path,
                      GlobLimits limits) {
   // Use our helped escape/replace for wildcards.
   replaceGlobWildcards(path, limits);
+
+  // A glob can only match beneath the deepest literal directory preceding
+  // the first wildcard. If that anchor does not exist, no amount of walking
+  // can produce results, so the (possibly recursive) glob is skipped.
+  auto wild_pos = path.find('*');
+  if (wild_pos != std::string::npos) {
+    auto anchor = fs::path(path.substr(0, wild_pos)).parent_path();
+    if (!anchor.empty() && !pathExists(anchor).ok()) {
+      return;
+    }
+  }
+
   // inodes of directory symlinks for loop detection
   std::set<int> dsym_inos;
 
@@ -396,6 +415,60 @@ inline void replaceGlobWildcards(std::string& pattern, GlobLimits limits) {
   }
 }
 
+void prefetchFile(const fs::path& path) {
+  PlatformFile fd(path, PF_OPEN_EXISTING | PF_READ | PF_NONBLOCK);
+  if (!fd.isValid()) {
+    return;
+  }
+
+  auto size = fd.size();
+  if (size == 0 || size > FLAGS_read_max) {
+    // Oversized targets fail the eventual read; do not fault them in.
+    return;
+  }
+
+  // The readahead outlives the descriptor: the pages stay cached for the
+  // inode, so the eventual read finds the content resident.
+  fd.readAheadHint(size);
+}
+
+void parallelFileWalk(size_t count,
+                      const std::function<void(size_t)>& walker) {
+  size_t threads = FLAGS_file_walk_threads;
+  if (threads > count) {
+    threads = count;
+  }
+
+  if (threads <= 1) {
+    for (size_t i = 0; i < count; i++) {
+      walker(i);
+    }
+    return;
+  }
+
+  // Workers claim indexes from a shared cursor, so one slow unit (a cold NFS
+  // directory, a large file) does not idle the rest of the pool.
+  std::atomic<size_t> cursor(0);
+  std::vector<std::thread> pool;
+  for (size_t i = 0; i < threads; i++) {
+    pool.push_back(std::thread([&count, &cursor, &walker]() {
+      for (auto index = cursor++; index < count; index = cursor++) {
+        walker(index);
+      }
+    }));
+  }
+
+  for (auto& thread : pool) {
+    thread.join();
+  }
+}
+
+void parallelFileWalk(const std::vector<std::string>& paths,
+                      const std::function<void(const std::string&)>& walker) {
+  parallelFileWalk(paths.size(),
+                   [&paths, &walker](size_t index) { walker(paths[index]); });
+}
+
 inline Status listInAbsoluteDirectory(const fs::path& path,
                                       std::vector<std::string>& results,
                                       GlobLimits limits) {
@@ -9,17 +9,37 @@
  */
 
 #include <linux/limits.h>
+#include <linux/netlink.h>
+#include <linux/sock_diag.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
 #include <boost/filesystem.hpp>
 
 #include <osquery/filesystem.h>
+#include <osquery/flags.h>
 #include <osquery/logger.h>
+#include <osquery/tables.h>
 
 #include "osquery/core/conversions.h"
 #include "osquery/filesystem/linux/proc.h"
+#include "osquery/tables/networking/linux/inet_diag.h"
+
+#ifndef NETLINK_SOCK_DIAG
+#define NETLINK_SOCK_DIAG 4
+#endif
+
+#ifndef SOCK_DIAG_BY_FAMILY
+#define SOCK_DIAG_BY_FAMILY 20
+#endif
 
 namespace osquery {
+
+FLAG(bool,
+     socket_diag,
+     true,
+     "Use batched sock_diag netlink dumps for Linux socket tables, with "
+     "procfs text parsing as the fallback");
 const std::vector<std::string> kUserNamespaceList = {
     "cgroup", "ipc", "mnt", "net", "pid", "user", "uts"};
 
@@ -218,11 +238,140 @@ static Status procGetSocketListUnix(ino_t net_ns,
   return Status(0);
 }
 
+/// The network namespace inode of the calling process, resolved once.
+static ino_t procSelfNetNamespace() {
+  static ino_t inode = ([]() {
+    ino_t value = 0;
+    procGetNamespaceInode(value, "net", kLinuxProcPath + "/self/ns");
+    return value;
+  })();
+  return inode;
+}
+
+Status procGetSocketListInetDiag(int family,
+                                 int protocol,
+                                 ino_t net_ns,
+                                 SocketInfoList& result) {
+  auto fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+  if (fd < 0) {
+    return Status(1, "Cannot open a sock_diag netlink socket");
+  }
+
+  struct {
+    struct nlmsghdr nlh;
+    struct inet_diag_req_v2 req;
+  } request = {};
+
+  request.nlh.nlmsg_len = sizeof(request);
+  request.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+  request.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+  request.req.sdiag_family = static_cast<__u8>(family);
+  request.req.sdiag_protocol = static_cast<__u8>(protocol);
+  request.req.idiag_states = ~0U;
+
+  struct sockaddr_nl nl_addr = {};
+  nl_addr.nl_family = AF_NETLINK;
+
+  struct iovec iov = {&request, sizeof(request)};
+  struct msghdr msg = {};
+  msg.msg_name = &nl_addr;
+  msg.msg_namelen = sizeof(nl_addr);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  if (sendmsg(fd, &msg, 0) < 0) {
+    close(fd);
+    return Status(1, "Cannot send the sock_diag dump request");
+  }
+
+  // Collect into a scratch list so a failed dump cannot leave partial
+  // results behind before the caller falls back to the procfs parser.
+  SocketInfoList dumped;
+
+  // Each recv returns a batch of messages; 32KB keeps the call count low.
+  std::vector<char> buffer(32 * 1024);
+  bool done = false;
+  while (!done) {
+    auto size = recv(fd, buffer.data(), buffer.size(), 0);
+    if (size < 0) {
+      close(fd);
+      return Status(1, "Cannot receive the sock_diag dump response");
+    }
+    if (size == 0) {
+      break;
+    }
+
+    auto remaining = static_cast<int>(size);
+    for (auto nlh = reinterpret_cast<struct nlmsghdr*>(buffer.data());
+         NLMSG_OK(nlh, remaining);
+         nlh = NLMSG_NEXT(nlh, remaining)) {
+      if (nlh->nlmsg_type == NLMSG_DONE) {
+        done = true;
+        break;
+      }
+      if (nlh->nlmsg_type == NLMSG_ERROR) {
+        // Old kernels reject per-protocol dumps with an error message.
+        close(fd);
+        return Status(1, "The sock_diag dump request failed");
+      }
+      if (nlh->nlmsg_type != SOCK_DIAG_BY_FAMILY) {
+        continue;
+      }
+
+      auto diag = reinterpret_cast<struct inet_diag_msg*>(NLMSG_DATA(nlh));
+
+      SocketInfo socket_info = {};
+      socket_info.socket = std::to_string(diag->idiag_inode);
+      socket_info.net_ns = net_ns;
+      socket_info.family = family;
+      socket_info.protocol = protocol;
+
+      char address[INET6_ADDRSTRLEN] = {0};
+      inet_ntop(family, diag->id.idiag_src, address, sizeof(address));
+      socket_info.local_address = address;
+      socket_info.local_port = ntohs(diag->id.idiag_sport);
+
+      inet_ntop(family, diag->id.idiag_dst, address, sizeof(address));
+      socket_info.remote_address = address;
+      socket_info.remote_port = ntohs(diag->id.idiag_dport);
+
+      if (protocol == IPPROTO_TCP) {
+        if (diag->idiag_state == 0 || diag->idiag_state >= tcp_states.size()) {
+          socket_info.state = "UNKNOWN";
+        } else {
+          socket_info.state = tcp_states[diag->idiag_state];
+        }
+      }
+
+      dumped.push_back(std::move(socket_info));
+    }
+  }
+  close(fd);
+
+  result.insert(result.end(),
+                std::make_move_iterator(dumped.begin()),
+                std::make_move_iterator(dumped.end()));
+  return Status(0);
+}
+
 Status procGetSocketList(int family,
                          int protocol,
                          ino_t net_ns,
                          const std::string& pid,
                          SocketInfoList& result) {
+  // Prefer one batched sock_diag dump over parsing a /proc/net text table.
+  // The dump only reflects the local network namespace, so foreign
+  // namespaces keep using the per-pid procfs files.
+  if (FLAGS_socket_diag && (family == AF_INET || family == AF_INET6) &&
+      (net_ns == 0 || net_ns == procSelfNetNamespace())) {
+    auto status = procGetSocketListInetDiag(family, protocol, net_ns, result);
+    if (status.ok()) {
+      return status;
+    }
+    VLOG(1) << "sock_diag dump failed, falling back to procfs: "
+            << status.getMessage();
+  }
+
   std::string path = kLinuxProcPath + "/" + pid + "/net/";
 
   switch (family) {
@@ -312,6 +461,25 @@ Status procProcesses(std::set<std::string>& processes) {
   return procEnumerateProcesses<decltype(processes)>(processes, callback);
 }
 
+Status procProcesses(const QueryContext& context,
+                     std::set<std::string>& processes) {
+  if (context.constraints.count("pid") > 0 &&
+      context.constraints.at("pid").exists(EQUALS)) {
+    // Touch only the procfs entries the query names, dropping pids that
+    // are not numeric or no longer exist.
+    for (const auto& pid : context.constraints.at("pid").getAll(EQUALS)) {
+      if (!pid.empty() &&
+          pid.find_first_not_of("0123456789") == std::string::npos &&
+          isDirectory(kLinuxProcPath + "/" + pid)) {
+        processes.insert(pid);
+      }
+    }
+    return Status(0);
+  }
+
+  return procProcesses(processes);
+}
+
 Status procDescriptors(const std::string& process,
                        std::map<std::string, std::string>& descriptors) {
   auto callback = [](const std::string& pid,
@@ -326,6 +494,66 @@ Status procDescriptors(const std::string& process,
       process, descriptors, callback);
 }
 
+ProcView procNextLine(ProcView& buffer) {
+  auto end = buffer.find('\n');
+  if (end == ProcView::npos) {
+    auto line = buffer;
+    buffer = ProcView();
+    return line;
+  }
+
+  auto line = buffer.substr(0, end);
+  buffer.remove_prefix(end + 1);
+  return line;
+}
+
+ProcView procNextToken(ProcView& line) {
+  // Skip any leading delimiters so repeated separators compress.
+  auto start = line.find_first_not_of("\t ");
+  if (start == ProcView::npos) {
+    line = ProcView();
+    return line;
+  }
+  line.remove_prefix(start);
+
+  auto end = line.find_first_of("\t ");
+  if (end == ProcView::npos) {
+    auto token = line;
+    line = ProcView();
+    return token;
+  }
+
+  auto token = line.substr(0, end);
+  line.remove_prefix(end + 1);
+  return token;
+}
+
+bool procParseNumber(const ProcView& token, long long& value) {
+  if (token.empty()) {
+    return false;
+  }
+
+  size_t i = 0;
+  bool negative = (token[0] == '-');
+  if (negative || token[0] == '+') {
+    i++;
+  }
+  if (i == token.size()) {
+    return false;
+  }
+
+  long long parsed = 0;
+  for (; i < token.size(); i++) {
+    if (token[i] < '0' || token[i] > '9') {
+      return false;
+    }
+    parsed = (parsed * 10) + (token[i] - '0');
+  }
+
+  value = (negative) ? -parsed : parsed;
+  return true;
+}
+
 Status procReadDescriptor(const std::string& process,
                           const std::string& descriptor,
                           std::string& result) {
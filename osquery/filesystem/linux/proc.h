@@ -17,6 +17,7 @@
 #include <unistd.h>
 
 #include <boost/filesystem.hpp>
+#include <boost/utility/string_view.hpp>
 
 #include <osquery/filesystem.h>
 #include <osquery/logger.h>
@@ -84,6 +85,25 @@ Status procReadDescriptor(const std::string& process,
                           const std::string& descriptor,
                           std::string& result);
 
+/**
+ * @brief Non-owning view into a procfs read buffer.
+ *
+ * The high-frequency tables (processes, memory_info) parse small procfs
+ * text files for every row. Tokenizing with views over the single read
+ * buffer avoids the per-field string allocations of split()-based parsing;
+ * only the fields a table actually reports are materialized.
+ */
+using ProcView = boost::string_view;
+
+/// Split off the next line, leaving the remainder in the buffer view.
+ProcView procNextLine(ProcView& buffer);
+
+/// Split off the next tab/space-delimited token from a line view.
+ProcView procNextToken(ProcView& line);
+
+/// Parse a decimal integer from a token view without allocating.
+bool procParseNumber(const ProcView& token, long long& value);
+
 /// This function parses the inode value in the destination of a user namespace
 /// symlink; fail if the namespace name is now what we expect
 Status procGetNamespaceInode(ino_t& inode,
@@ -114,6 +134,20 @@ Status procGetSocketList(int family,
                          const std::string& pid,
                          SocketInfoList& result);
 
+/**
+ * @brief Collect AF_INET/AF_INET6 socket information with a sock_diag dump.
+ *
+ * One batched NETLINK_SOCK_DIAG dump replaces parsing a /proc/net text
+ * table, decoding inet_diag_msg structs directly from the kernel. The dump
+ * only covers the network namespace of the calling process; callers fall
+ * back to the procfs parser for foreign namespaces or kernels without
+ * sock_diag support for the requested protocol.
+ */
+Status procGetSocketListInetDiag(int family,
+                                 int protocol,
+                                 ino_t net_ns,
+                                 SocketInfoList& result);
+
 /**
  * @brief Construct a map of socket inode number to process information for the
  * process that owns the socket by reading entries under /proc/<pid>/fd.
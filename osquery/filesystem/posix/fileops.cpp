@@ -8,16 +8,21 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <fcntl.h>
 #include <glob.h>
 #include <pwd.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <limits>
+
 #include <boost/optional.hpp>
 
 #include <osquery/filesystem.h>
@@ -263,6 +268,51 @@ size_t PlatformFile::size() const {
   return file.st_size;
 }
 
+void PlatformFile::readAheadHint(size_t size) const {
+  if (!isValid() || size == 0) {
+    return;
+  }
+
+#if defined(__APPLE__)
+  struct radvisory advice;
+  advice.ra_offset = 0;
+  advice.ra_count = static_cast<int>(
+      std::min(size, static_cast<size_t>(std::numeric_limits<int>::max())));
+  ::fcntl(handle_, F_RDADVISE, &advice);
+#else
+  ::posix_fadvise(handle_, 0, static_cast<off_t>(size), POSIX_FADV_WILLNEED);
+#endif
+}
+
+PlatformFileMapping::PlatformFileMapping(const PlatformFile& file) {
+  if (!file.isValid() || file.isSpecialFile()) {
+    return;
+  }
+
+  auto size = file.size();
+  if (size == 0) {
+    // Empty files cannot be mapped.
+    return;
+  }
+
+  auto* base =
+      ::mmap(nullptr, size, PROT_READ, MAP_SHARED, file.nativeHandle(), 0);
+  if (base == MAP_FAILED) {
+    return;
+  }
+
+  // The mapped content is consumed front to back (hashing, copies).
+  ::madvise(base, size, MADV_SEQUENTIAL);
+  base_ = static_cast<const char*>(base);
+  size_ = size;
+}
+
+PlatformFileMapping::~PlatformFileMapping() {
+  if (base_ != nullptr) {
+    ::munmap(const_cast<char*>(base_), size_);
+  }
+}
+
 boost::optional<std::string> getHomeDirectory() {
   // Try to get the caller's home directory using HOME and getpwuid.
   auto user = ::getpwuid(getuid());
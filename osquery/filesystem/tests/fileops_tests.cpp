@@ -225,6 +225,42 @@ TEST_F(FileOpsTests, test_fileIo) {
   }
 }
 
+TEST_F(FileOpsTests, test_fileMapping) {
+  TempFile tmp_file;
+  std::string path = tmp_file.path();
+
+  const std::string expected_content = "AAAABBBBCCCCDDDD";
+
+  {
+    PlatformFile fd(path, PF_CREATE_NEW | PF_WRITE);
+    ASSERT_TRUE(fd.isValid());
+    EXPECT_EQ(static_cast<ssize_t>(expected_content.size()),
+              fd.write(expected_content.c_str(), expected_content.size()));
+  }
+
+  {
+    PlatformFile fd(path, PF_OPEN_EXISTING | PF_READ);
+    ASSERT_TRUE(fd.isValid());
+
+    PlatformFileMapping mapping(fd);
+    ASSERT_TRUE(mapping.isValid());
+    ASSERT_EQ(expected_content.size(), mapping.size());
+    EXPECT_EQ(expected_content,
+              std::string(mapping.data(), mapping.size()));
+  }
+
+  // An empty file cannot be mapped.
+  fs::remove(path);
+  {
+    PlatformFile fd(path, PF_CREATE_NEW | PF_WRITE | PF_READ);
+    ASSERT_TRUE(fd.isValid());
+
+    PlatformFileMapping mapping(fd);
+    EXPECT_FALSE(mapping.isValid());
+    EXPECT_EQ(0U, mapping.size());
+  }
+}
+
 TEST_F(FileOpsTests, test_append) {
   TempFile tmp_file;
   std::string path = tmp_file.path();
@@ -9,6 +9,7 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <fstream>
 
 #include <stdio.h>
@@ -414,6 +415,37 @@ TEST_F(FilesystemTests, test_no_wild) {
       fs::path(kFakeDirectory + "/roto.txt").make_preferred().string()));
 }
 
+TEST_F(FilesystemTests, test_parallel_file_walk) {
+  std::vector<std::string> paths;
+  auto status = resolveFilePattern(kFakeDirectory + "/%", paths, GLOB_FILES);
+  EXPECT_TRUE(status.ok());
+  ASSERT_GT(paths.size(), 1U);
+
+  // Every unit runs exactly once and writes into its exclusive slot.
+  std::vector<std::string> walked(paths.size());
+  parallelFileWalk(paths.size(),
+                   [&](size_t index) { walked[index] = paths[index]; });
+  EXPECT_EQ(walked, paths);
+
+  std::atomic<size_t> count(0);
+  parallelFileWalk(paths, [&count](const std::string& path) {
+    EXPECT_FALSE(path.empty());
+    count++;
+  });
+  EXPECT_EQ(count.load(), paths.size());
+}
+
+TEST_F(FilesystemTests, test_prefetch_file) {
+  // The hint is advisory: the content must read back unchanged after it.
+  prefetchFile(kFakeDirectory + "/root.txt");
+  std::string content;
+  EXPECT_TRUE(readFile(kFakeDirectory + "/root.txt", content).ok());
+  EXPECT_EQ(content, "root");
+
+  // Missing targets are ignored without an error surface.
+  prefetchFile(kFakeDirectory + "/does_not_exist");
+}
+
 TEST_F(FilesystemTests, test_safe_permissions) {
   fs::path path_1(kFakeDirectory + "/door.txt");
   fs::path path_2(kFakeDirectory + "/deep11");
@@ -15,13 +15,19 @@
 #endif
 
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <future>
+#include <map>
+#include <mutex>
 #include <queue>
 #include <thread>
 
 #include <boost/noncopyable.hpp>
 
 #include <osquery/database.h>
+#include <osquery/dispatcher.h>
 #include <osquery/events.h>
 #include <osquery/extensions.h>
 #include <osquery/filesystem.h>
@@ -32,6 +38,7 @@
 
 #include "osquery/core/conversions.h"
 #include "osquery/core/json.h"
+#include "osquery/core/metrics.h"
 
 namespace pt = boost::property_tree;
 namespace rj = rapidjson;
@@ -47,6 +54,14 @@ FLAG(bool, disable_logging, false, "Disable ERROR/INFO logging");
 
 FLAG(string, logger_plugin, "filesystem", "Logger plugin name");
 
+FLAG(uint64,
+     logger_sink_queue_max,
+     0,
+     "Queue this many log items per logger plugin and deliver them from a "
+     "dedicated worker so one slow destination only degrades itself; the "
+     "oldest items are dropped when a sink falls behind (0 = synchronous "
+     "fan-out)");
+
 /// Log each added or removed line individually, as an "event".
 FLAG(bool, logger_event_type, true, "Log scheduled results as events");
 FLAG_ALIAS(bool, log_result_events, logger_event_type);
@@ -57,6 +72,19 @@ FLAG(bool,
      false,
      "Log scheduled snapshot results as events");
 
+/// Bound the serialized size of each emitted snapshot log item.
+FLAG(uint64,
+     logger_snapshot_batch,
+     0,
+     "Maximum rows per emitted snapshot log item; large snapshots are "
+     "logged as multiple items (0 emits one item per snapshot)");
+
+FLAG(bool,
+     logger_snapshot_dedup,
+     false,
+     "Replace a snapshot result identical to the query's previous run with "
+     "a compact 'unchanged' marker item (requires endpoint support)");
+
 /// Alias for the minloglevel used internally by GLOG.
 FLAG(int32, logger_min_status, 0, "Minimum level for status log recording");
 
@@ -94,8 +122,11 @@ HIDDEN_FLAG(bool,
  * This creates an osquery registry for "logger" which may implement
  * LoggerPlugin. Only strings are logged in practice, and LoggerPlugin provides
  * a helper member for transforming PluginRequest%s to strings.
+ *
+ * The registry is lazy: only the 'active' logger, selected with
+ * --logger_plugin, runs setUp, and only when it is activated.
  */
-CREATE_REGISTRY(LoggerPlugin, "logger");
+CREATE_LAZY_REGISTRY(LoggerPlugin, "logger");
 
 class LoggerDisabler;
 
@@ -235,6 +266,9 @@ class BufferedLogSink : public google::LogSink, private boost::noncopyable {
 /// Mutex protecting accesses to buffered status logs.
 Mutex kBufferedLogSinkLogs;
 
+/// Number of status log lines preallocated in the sink's buffer.
+const size_t kStatusLogBufferReserve = 128;
+
 /// Mutex protecting queued status log futures.
 Mutex kBufferedLogSinkSenders;
 
@@ -380,6 +414,106 @@ void initStatusLogger(const std::string& name, bool init_glog) {
   BufferedLogSink::get().setUp();
 }
 
+/**
+ * @brief A bounded queue and drain worker for a single logger sink.
+ *
+ * With --logger_sink_queue_max set, each active logger plugin receives its
+ * log items from a dedicated worker instead of inline from the logging call
+ * site. A stalled destination then backs up only its own queue rather than
+ * delaying every other sink; when the bound is reached the oldest items are
+ * dropped and counted.
+ */
+class LoggerSinkQueue : public InternalRunnable {
+ public:
+  explicit LoggerSinkQueue(const std::string& name)
+      : InternalRunnable("LoggerSinkQueue"), name_(name) {}
+
+  /// Queue one plugin request, dropping the oldest item when full.
+  void enqueue(PluginRequest request) {
+    size_t dropped = 0;
+    size_t dropped_total = 0;
+    size_t depth = 0;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      while (queue_.size() >= FLAGS_logger_sink_queue_max) {
+        queue_.pop_front();
+        dropped++;
+        dropped_total = ++dropped_;
+      }
+      queue_.push_back(std::move(request));
+      depth = queue_.size();
+    }
+    queue_signal_.notify_one();
+
+    metricSet("logger_sink_queue_depth", depth);
+    if (dropped > 0) {
+      metricAdd("logger_sink_queue_drops", dropped);
+      if (dropped_total % 1000 == 1) {
+        VLOG(1) << "Logger " << name_ << " has dropped " << dropped_total
+                << " queued log items";
+      }
+    }
+  }
+
+  /// Drain the queue, delivering each item to this worker's single sink.
+  void start() override {
+    while (!interrupted()) {
+      PluginRequest request;
+      {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        if (queue_.empty()) {
+          queue_signal_.wait_for(lock, std::chrono::milliseconds(200));
+        }
+        if (queue_.empty()) {
+          continue;
+        }
+        request = std::move(queue_.front());
+        queue_.pop_front();
+      }
+
+      // Deliver outside the lock; a stalled sink blocks only this worker.
+      Registry::call("logger", name_, request);
+    }
+  }
+
+ private:
+  /// The single logger plugin drained by this worker.
+  std::string name_;
+
+  /// Pending log items for this sink.
+  std::deque<PluginRequest> queue_;
+
+  /// Items dropped because the sink could not keep up.
+  size_t dropped_{0};
+
+  /// Guard the pending items and drop counter.
+  std::mutex queue_mutex_;
+
+  /// Wake the drain worker when an item arrives.
+  std::condition_variable queue_signal_;
+};
+
+/// Per-sink queues, keyed by logger plugin name (created in initLogger).
+std::map<std::string, std::shared_ptr<LoggerSinkQueue>> kSinkQueues;
+
+/// Guard the per-sink queue map.
+Mutex kSinkQueuesMutex;
+
+/// Queue a log item for a sink worker, if per-sink queuing is enabled.
+static bool enqueueLogItem(const std::string& logger, PluginRequest request) {
+  if (FLAGS_logger_sink_queue_max == 0) {
+    return false;
+  }
+
+  ReadLock lock(kSinkQueuesMutex);
+  auto queue = kSinkQueues.find(logger);
+  if (queue == kSinkQueues.end()) {
+    return false;
+  }
+  queue->second->enqueue(std::move(request));
+  return true;
+}
+
 void initLogger(const std::string& name) {
   // Check if logging is disabled, if so then no need to shuttle intermediates.
   if (FLAGS_disable_logging) {
@@ -402,6 +536,17 @@ void initLogger(const std::string& name) {
     }
 
     Registry::call("logger", logger, init_request);
+
+    if (FLAGS_logger_sink_queue_max > 0) {
+      // Give this sink its own bounded queue and drain worker.
+      WriteLock lock(kSinkQueuesMutex);
+      if (kSinkQueues.count(logger) == 0) {
+        auto queue = std::make_shared<LoggerSinkQueue>(logger);
+        kSinkQueues[logger] = queue;
+        Dispatcher::addService(queue);
+      }
+    }
+
     auto status = Registry::call("logger", logger, features_request);
     if ((status.getCode() & LOGGER_FEATURE_LOGSTATUS) > 0) {
       // Glog status logs are forwarded to logStatus.
@@ -433,6 +578,12 @@ void BufferedLogSink::setUp() {
 
   if (!active_) {
     active_ = true;
+    {
+      // Preallocate the intermediate buffer so steady-state status logging
+      // does not reallocate while holding the logs mutex.
+      WriteLock logs_lock(kBufferedLogSinkLogs);
+      logs_.reserve(kStatusLogBufferReserve);
+    }
     google::AddLogSink(&get());
   }
 }
@@ -590,6 +741,11 @@ Status logString(const std::string& message,
       continue;
     }
 
+    if (enqueueLogItem(logger, {{"string", message}, {"category", category}})) {
+      // The item was queued; the sink's worker delivers it.
+      continue;
+    }
+
     if (Registry::get().exists("logger", logger, true)) {
       auto plugin = Registry::get().plugin("logger", logger);
       auto logger_plugin = std::dynamic_pointer_cast<LoggerPlugin>(plugin);
@@ -619,7 +775,7 @@ Status logQueryLogItem(const QueryLogItem& results,
   } else {
     std::string json;
     status = serializeQueryLogItemJSON(results, json);
-    json_items.emplace_back(json);
+    json_items.emplace_back(std::move(json));
   }
   if (!status.ok()) {
     return status;
@@ -631,11 +787,8 @@ Status logQueryLogItem(const QueryLogItem& results,
   return status;
 }
 
-Status logSnapshotQuery(const QueryLogItem& item) {
-  if (FLAGS_disable_logging) {
-    return Status(0, "Logging disabled");
-  }
-
+/// Serialize and forward a single snapshot item to the snapshot sinks.
+static Status logSnapshotItem(const QueryLogItem& item) {
   std::vector<std::string> json_items;
   Status status;
   if (FLAGS_logger_snapshot_event_type) {
@@ -643,7 +796,7 @@ Status logSnapshotQuery(const QueryLogItem& item) {
   } else {
     std::string json;
     status = serializeQueryLogItemJSON(item, json);
-    json_items.emplace_back(json);
+    json_items.emplace_back(std::move(json));
   }
   if (!status.ok()) {
     return status;
@@ -657,6 +810,11 @@ Status logSnapshotQuery(const QueryLogItem& item) {
         continue;
       }
 
+      if (enqueueLogItem(logger, {{"snapshot", json}})) {
+        // The item was queued; the sink's worker delivers it.
+        continue;
+      }
+
       if (Registry::get().exists("logger", logger, true)) {
         auto plugin = Registry::get().plugin("logger", logger);
         auto logger_plugin = std::dynamic_pointer_cast<LoggerPlugin>(plugin);
@@ -670,6 +828,102 @@ Status logSnapshotQuery(const QueryLogItem& item) {
   return status;
 }
 
+/// Content hashes of the last logged snapshot per query name.
+static std::map<std::string, uint64_t> kSnapshotHashes;
+
+/// Lock around the snapshot content hashes.
+static Mutex kSnapshotHashesMutex;
+
+/// Order-sensitive content hash over a materialized snapshot result.
+static uint64_t snapshotResultsHash(const QueryData& rows) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (const auto& row : rows) {
+    for (const auto& column : row) {
+      for (const char byte : column.first) {
+        hash ^= static_cast<uint64_t>(static_cast<unsigned char>(byte));
+        hash *= 0x100000001b3ULL;
+      }
+      hash ^= 0x1fULL;
+      hash *= 0x100000001b3ULL;
+      for (const char byte : column.second) {
+        hash ^= static_cast<uint64_t>(static_cast<unsigned char>(byte));
+        hash *= 0x100000001b3ULL;
+      }
+      hash ^= 0x1fULL;
+      hash *= 0x100000001b3ULL;
+    }
+    hash ^= 0x1eULL;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+Status logSnapshotQuery(const QueryLogItem& item) {
+  if (FLAGS_disable_logging) {
+    return Status(0, "Logging disabled");
+  }
+
+  if (FLAGS_logger_snapshot_dedup && !item.name.empty() &&
+      !item.snapshot_results.empty()) {
+    // Inventory-style snapshots repeat their full result most intervals.
+    // Hash the rows before any serialization and short-circuit a repeat
+    // into a compact marker item the endpoint can count as a heartbeat.
+    auto hash = snapshotResultsHash(item.snapshot_results);
+    auto repeated = false;
+    {
+      WriteLock lock(kSnapshotHashesMutex);
+      auto it = kSnapshotHashes.find(item.name);
+      repeated = (it != kSnapshotHashes.end() && it->second == hash);
+      kSnapshotHashes[item.name] = hash;
+    }
+    if (repeated) {
+      VLOG(1) << "Snapshot results for " << item.name
+              << " unchanged, emitting marker item";
+      QueryLogItem marker;
+      marker.name = item.name;
+      marker.identifier = item.identifier;
+      marker.time = item.time;
+      marker.calendar_time = item.calendar_time;
+      marker.epoch = item.epoch;
+      marker.counter = item.counter;
+      marker.decorations = item.decorations;
+      marker.unchanged = true;
+      return logSnapshotItem(marker);
+    }
+  }
+
+  auto batch = static_cast<size_t>(FLAGS_logger_snapshot_batch);
+  if (batch == 0 || item.snapshot_results.size() <= batch) {
+    return logSnapshotItem(item);
+  }
+
+  // Emit the snapshot as bounded row batches so serialization peaks at
+  // O(batch) instead of the full result set, and remote loggers receive
+  // multi-part payloads they can forward incrementally.
+  QueryLogItem chunk;
+  chunk.name = item.name;
+  chunk.identifier = item.identifier;
+  chunk.time = item.time;
+  chunk.epoch = item.epoch;
+  chunk.counter = item.counter;
+  chunk.calendar_time = item.calendar_time;
+  chunk.decorations = item.decorations;
+  chunk.columns = item.columns;
+
+  Status status;
+  for (size_t offset = 0; offset < item.snapshot_results.size();
+       offset += batch) {
+    auto end = std::min(offset + batch, item.snapshot_results.size());
+    chunk.snapshot_results.assign(item.snapshot_results.begin() + offset,
+                                  item.snapshot_results.begin() + end);
+    auto chunk_status = logSnapshotItem(chunk);
+    if (!chunk_status.ok()) {
+      status = chunk_status;
+    }
+  }
+  return status;
+}
+
 size_t queuedStatuses() {
   ReadLock lock(kBufferedLogSinkLogs);
   return BufferedLogSink::get().dump().size();
@@ -698,27 +952,38 @@ void relayStatusLogs(bool async) {
   auto sender = ([]() {
     auto identifier = getHostIdentifier();
 
-    // Construct a status log plugin request.
-    PluginRequest request = {{"status", "true"}};
+    // Swap the buffered lines out as one batch, leaving a reserved buffer
+    // behind so concurrent sends do not reallocate under the lock.
+    std::vector<StatusLogLine> status_logs;
+    status_logs.reserve(kStatusLogBufferReserve);
     {
       WriteLock lock(kBufferedLogSinkLogs);
-      auto& status_logs = BufferedLogSink::get().dump();
-      for (auto& log : status_logs) {
-        // Copy the host identifier into each status log.
-        log.identifier = identifier;
-      }
-
-      serializeIntermediateLog(status_logs, request);
+      status_logs.swap(BufferedLogSink::get().dump());
+    }
 
-      // Flush the buffered status logs.
-      status_logs.clear();
+    for (auto& log : status_logs) {
+      // Copy the host identifier into each status log.
+      log.identifier = identifier;
     }
 
-    auto logger_plugin = RegistryFactory::get().getActive("logger");
-    for (const auto& logger : osquery::split(logger_plugin, ",")) {
-      auto& enabled = BufferedLogSink::get().enabledPlugins();
-      if (std::find(enabled.begin(), enabled.end(), logger) != enabled.end()) {
-        // Skip the registry's logic, and send directly to the core's logger.
+    // The string-map request is only needed for loggers within extensions.
+    // It is built lazily when the first external logger is encountered.
+    PluginRequest request;
+
+    // The sink tracks the plugins that accepted status forwarding at init,
+    // so the active logger string does not need to be consulted per relay.
+    for (const auto& logger : BufferedLogSink::get().enabledPlugins()) {
+      if (Registry::get().exists("logger", logger, true)) {
+        // In-process loggers receive the status lines directly, skipping
+        // the serialize/deserialize round trip through the registry.
+        auto plugin = Registry::get().plugin("logger", logger);
+        auto logger_plugin = std::dynamic_pointer_cast<LoggerPlugin>(plugin);
+        logger_plugin->logStatus(status_logs);
+      } else {
+        if (request.empty()) {
+          request = {{"status", "true"}};
+          serializeIntermediateLog(status_logs, request);
+        }
         PluginResponse response;
         Registry::call("logger", logger, request, response);
       }
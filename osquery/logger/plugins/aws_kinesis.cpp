@@ -96,9 +96,11 @@ void KinesisLogForwarder::initializeRecord(
   std::string record_partition_key;
   if (FLAGS_aws_kinesis_random_partition_key) {
     // Generate a random partition key for each record, ensuring that
-    // records are spread evenly across shards.
-    boost::uuids::uuid uuid = boost::uuids::random_generator()();
-    record_partition_key = boost::uuids::to_string(uuid);
+    // records are spread evenly across shards. The generator seeds from
+    // the system entropy source, so construct it once per thread rather
+    // than once per record.
+    static thread_local boost::uuids::random_generator generate_uuid;
+    record_partition_key = boost::uuids::to_string(generate_uuid());
   } else {
     record_partition_key = partition_key_;
   }
@@ -10,12 +10,16 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <memory>
+#include <sstream>
+#include <thread>
 #include <vector>
 
 #include <osquery/core.h>
 #include <osquery/dispatcher.h>
+#include <osquery/flags.h>
 #include <osquery/logger.h>
 
 #include "osquery/logger/plugins/buffered.h"
@@ -30,6 +34,9 @@
 #endif
 
 namespace osquery {
+
+DECLARE_uint64(aws_log_forwarder_parallel);
+
 template <typename RecordType,
           typename ClientType,
           typename OutcomeType,
@@ -275,23 +282,67 @@ class AwsLogForwarder : public BufferedLogForwarder {
     dumpDiscardedRecordsToErrorLog(discarded_records);
     discarded_records.clear();
 
-    // Send each batch
-    size_t error_count = 0;
-    std::stringstream status_output;
-
-    for (auto batch_it = batch_list.begin(); batch_it != batch_list.end();) {
-      auto& batch = *batch_it;
-      if (!sendBatch(batch, status_output)) {
-        // We couldn't write some of the records; log them locally so that the
-        // administrator will at least be able to inspect them
-        dumpBatchToErrorLog(batch);
-        error_count++;
-      }
+    if (batch_list.empty()) {
+      return Status(0, "OK");
+    }
+
+    // Send the batches over a bounded set of workers so several calls are
+    // in flight at once; the service client is thread-safe and shared.
+    // Each worker owns the batches it claims, retrying only their failed
+    // records, so per-call latency no longer serializes the whole flush.
+    auto worker_count = static_cast<size_t>(FLAGS_aws_log_forwarder_parallel);
+    if (worker_count < 1) {
+      worker_count = 1;
+    }
+    if (worker_count > batch_list.size()) {
+      worker_count = batch_list.size();
+    }
+
+    std::atomic<size_t> error_count{0};
+    std::atomic<size_t> cursor{0};
+    std::vector<std::stringstream> worker_status(worker_count);
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < worker_count; i++) {
+      workers.emplace_back(
+          [this, &batch_list, &error_count, &cursor, &worker_status, i]() {
+            while (true) {
+              auto index = cursor.fetch_add(1);
+              if (index >= batch_list.size()) {
+                break;
+              }
+
+              auto& batch = batch_list[index];
+              if (!sendBatch(batch, worker_status[i])) {
+                // We couldn't write some of the records; log them locally so
+                // that the administrator will at least be able to inspect them
+                dumpBatchToErrorLog(batch);
+                error_count++;
+              }
+
+              batch.clear();
+            }
+          });
+    }
 
-      batch_it = batch_list.erase(batch_it);
+    for (auto& worker : workers) {
+      worker.join();
     }
 
+    batch_list.clear();
+
     if (error_count != 0) {
+      std::stringstream status_output;
+      for (const auto& output : worker_status) {
+        if (output.str().empty()) {
+          continue;
+        }
+        if (!status_output.str().empty()) {
+          status_output << "\n";
+        }
+        status_output << output.str();
+      }
+
       return Status(1, status_output.str());
     }
 
@@ -33,44 +33,74 @@ FLAG(uint64,
      1000000,
      "Maximum number of logs in buffered output plugins (0 = unlimited)");
 
+FLAG(bool,
+     buffered_log_adaptive,
+     false,
+     "Grow the forwarder batch size while a backlog drains and shrink it "
+     "when sends fail");
+
 const std::chrono::seconds BufferedLogForwarder::kLogPeriod{
     std::chrono::seconds(4)};
 const size_t BufferedLogForwarder::kMaxLogLines{1024};
 
+/// Largest adaptive batch, as a multiple of the configured batch size.
+const size_t kAdaptiveBatchGrowthLimit{8};
+
+/// Smallest adaptive batch, as a divisor of the configured batch size.
+const size_t kAdaptiveBatchShrinkLimit{8};
+
 Status BufferedLogForwarder::setUp() {
-  // initialize buffer_count_ by scanning the DB
-  std::vector<std::string> indexes;
-  auto status = scanDatabaseKeys(kLogs, indexes, index_name_, 0);
+  // Initialize buffer_count_ by counting keys in bounded chunks; a
+  // backlogged buffer may hold hundreds of thousands of entries.
+  size_t count = 0;
+  auto status = scanDatabaseKeysChunked(
+      kLogs,
+      ([&count](const std::vector<std::string>& keys) {
+        count += keys.size();
+        return true;
+      }),
+      index_name_);
 
   if (!status.ok()) {
     return Status(1, "Error scanning for buffered log count");
   }
 
+  batch_size_ = max_log_lines_;
+
   RecursiveLock lock(count_mutex_);
-  buffer_count_ = indexes.size();
+  buffer_count_ = count;
   return Status(0);
 }
 
-void BufferedLogForwarder::check() {
-  // Get a list of all the buffered log items, with a max of 1024 lines.
-  std::vector<std::string> indexes;
-  auto status = scanDatabaseKeys(kLogs, indexes, index_name_, max_log_lines_);
-
-  // For each index, accumulate the log line into the result or status set.
-  std::vector<std::string> results, statuses;
-  iterate(indexes, ([&results, &statuses, this](std::string& index) {
-            std::string value;
-            auto& target = isResultIndex(index) ? results : statuses;
-            if (getDatabaseValue(kLogs, index, value)) {
-              target.emplace_back(std::move(value));
-            }
-          }));
+bool BufferedLogForwarder::check() {
+  auto batch_max =
+      (FLAGS_buffered_log_adaptive && batch_size_ > 0) ? batch_size_
+                                                       : max_log_lines_;
+
+  // Read the buffered log items (index and line) in one range scan instead
+  // of a key scan followed by a point lookup per key.
+  DatabaseStringValueList items;
+  auto status = scanDatabaseValues(kLogs, items, index_name_, batch_max);
+  bool full_batch = (items.size() >= batch_max);
+
+  // Accumulate each log line into the result or status set.
+  std::vector<std::string> indexes, results, statuses;
+  for (auto& item : items) {
+    auto& target = isResultIndex(item.first) ? results : statuses;
+    target.emplace_back(std::move(item.second));
+    indexes.push_back(std::move(item.first));
+  }
+  DatabaseStringValueList().swap(items);
 
   // If any results/statuses were found in the flushed buffer, send.
+  bool sent = (results.size() + statuses.size() > 0);
+  bool failed = false;
   if (results.size() > 0) {
     status = send(results, "result");
     if (!status.ok()) {
       VLOG(1) << "Error sending results to logger: " << status.getMessage();
+      sent = false;
+      failed = true;
     } else {
       // Clear the results logs once they were sent.
       iterate(indexes, ([this](std::string& index) {
@@ -86,6 +116,8 @@ void BufferedLogForwarder::check() {
     status = send(statuses, "status");
     if (!status.ok()) {
       VLOG(1) << "Error sending status to logger: " << status.getMessage();
+      sent = false;
+      failed = true;
     } else {
       // Clear the status logs once they were sent.
       iterate(indexes, ([this](std::string& index) {
@@ -101,6 +133,22 @@ void BufferedLogForwarder::check() {
   if (FLAGS_buffered_log_max > 0) {
     purge();
   }
+
+  // Adapt the next batch size: grow while a backlog drains so fewer round
+  // trips move more lines, back off when the endpoint rejects a batch.
+  if (FLAGS_buffered_log_adaptive) {
+    if (failed) {
+      batch_size_ = std::max(batch_size_ / 2,
+                             std::max<size_t>(
+                                 max_log_lines_ / kAdaptiveBatchShrinkLimit, 1));
+    } else if (full_batch && sent) {
+      batch_size_ =
+          std::min(batch_size_ * 2, max_log_lines_ * kAdaptiveBatchGrowthLimit);
+    }
+  }
+
+  // A fully-acknowledged full batch implies a backlog remains.
+  return full_batch && sent;
 }
 
 void BufferedLogForwarder::purge() {
@@ -167,7 +215,11 @@ void BufferedLogForwarder::purge() {
 
 void BufferedLogForwarder::start() {
   while (!interrupted()) {
-    check();
+    // Drain the backlog: every check sends and acknowledges one batch, so
+    // keep sending while full batches succeed. Forwarding throughput is then
+    // bounded by the transport round trip, not by the log period.
+    while (check() && !interrupted()) {
+    }
 
     // Cool off and time wait the configured period.
     pauseMilli(log_period_);
@@ -134,11 +134,18 @@ class BufferedLogForwarder : public InternalRunnable {
   /**
    * @brief Check for new logs and send.
    *
-   * Scan the logs domain for up to max_log_lines_ log lines.
+   * Range-read up to max_log_lines_ log lines (or the adaptive batch_size_
+   * when buffered_log_adaptive is set) from the logs domain.
    * Sort those lines into status and request types then forward (send) each
    * set. On success, clear the data and indexes. Calls purge upon completion.
+   *
+   * Each send acknowledges exactly one batch: only the indexes of a batch
+   * that was accepted are deleted, a failed batch stays buffered for retry.
+   *
+   * @return True if a full batch was sent and acknowledged, meaning a backlog
+   * likely remains and another check should run before the next log period.
    */
-  void check();
+  bool check();
 
   /**
    * @brief Purge the oldest logs, if the max is exceeded
@@ -194,6 +201,14 @@ class BufferedLogForwarder : public InternalRunnable {
   /// Max number of logs to flush per check
   size_t max_log_lines_;
 
+  /**
+   * @brief The current batch size when adaptive sizing is enabled.
+   *
+   * Starts at max_log_lines_, grows while full batches are acknowledged (a
+   * backlog is draining) and shrinks when a send fails. See check().
+   */
+  size_t batch_size_{0};
+
   /**
    * @brief Name to use in index
    *
@@ -8,13 +8,18 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <chrono>
 #include <exception>
+#include <map>
+#include <memory>
 
 #include <osquery/filesystem.h>
 #include <osquery/flags.h>
 #include <osquery/logger.h>
 #include <osquery/registry_factory.h>
 
+#include "osquery/filesystem/fileops.h"
+
 namespace fs = boost::filesystem;
 
 /**
@@ -34,9 +39,45 @@ FLAG_ALIAS(std::string, osquery_log_dir, logger_path);
 
 FLAG(int32, logger_mode, 0640, "Decimal mode for log files (default '0640')");
 
+FLAG(uint64,
+     logger_buffer_size,
+     0,
+     "Buffer result/snapshot log lines up to this many bytes before "
+     "appending to disk (0 writes through immediately)");
+
+FLAG(uint64,
+     logger_flush_latency,
+     5000,
+     "Milliseconds buffered log lines may wait before being flushed");
+
+FLAG(uint64,
+     logger_rotate_size,
+     0,
+     "Rotate result/snapshot logs after they grow beyond this many bytes "
+     "(0 disables rotation)");
+
+FLAG(uint64,
+     logger_rotate_max_files,
+     4,
+     "Number of rotated result/snapshot log files to keep");
+
+FLAG(bool,
+     logger_rotate_compress,
+     true,
+     "Compress rotated result/snapshot log files with zstd");
+
 const std::string kFilesystemLoggerFilename = "osqueryd.results.log";
 const std::string kFilesystemLoggerSnapshots = "osqueryd.snapshots.log";
 
+namespace {
+/// Monotonic milliseconds used for the buffered flush policy.
+size_t loggerMilliseconds() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+} // namespace
+
 class FilesystemLoggerPlugin : public LoggerPlugin {
  public:
   Status setUp() override;
@@ -60,16 +101,46 @@ class FilesystemLoggerPlugin : public LoggerPlugin {
   /// Write a status to Glog.
   Status logStatus(const std::vector<StatusLogLine>& log) override;
 
+  /// Flush any buffered log lines before the plugin is released.
+  void tearDown() override;
+
  private:
+  /// One open append-mode log target with its user-space buffer.
+  struct LogWriter {
+    /// Persistent append-mode handle; appends are atomic (O_APPEND).
+    std::unique_ptr<PlatformFile> file;
+
+    /// Lines collected since the last flush.
+    std::string buffer;
+
+    /// Size of the active log file, including unflushed lines.
+    size_t written{0};
+
+    /// Monotonic milliseconds of the last flush.
+    size_t last_flush{0};
+  };
+
   /// The plugin-internal filesystem writer method.
   Status logStringToFile(const std::string& s,
                          const std::string& filename,
                          bool empty = false);
 
+  /// Open (or reopen) the append-mode handle for a log target.
+  Status openWriter(LogWriter& writer, const std::string& filename);
+
+  /// Append the buffered lines with a single write.
+  Status flushWriter(LogWriter& writer);
+
+  /// Shift the rotation chain and reopen the active log file.
+  Status rotateWriter(LogWriter& writer, const std::string& filename);
+
  private:
   /// The folder where Glog and the result/snapshot files are written.
   fs::path log_path_;
 
+  /// Open log targets, keyed by filename.
+  std::map<std::string, LogWriter> writers_;
+
   /// Filesystem writer mutex.
   Mutex mutex_;
 
@@ -80,14 +151,27 @@ class FilesystemLoggerPlugin : public LoggerPlugin {
 REGISTER(FilesystemLoggerPlugin, "logger", "filesystem");
 
 Status FilesystemLoggerPlugin::setUp() {
+  WriteLock lock(mutex_);
   log_path_ = fs::path(FLAGS_logger_path);
 
+  // The logger path may have changed since a previous setup; drop any open
+  // handles (flushing their buffers) so targets reopen lazily.
+  for (auto& writer : writers_) {
+    flushWriter(writer.second);
+  }
+  writers_.clear();
+
   // Ensure that the Glog status logs use the same mode as our results log.
   // Glog 0.3.4 does not support a logfile mode.
   // FLAGS_logfile_mode = FLAGS_logger_mode;
 
   // Ensure that we create the results log here.
-  return logStringToFile("", kFilesystemLoggerFilename, true);
+  auto& writer = writers_[kFilesystemLoggerFilename];
+  auto status = openWriter(writer, kFilesystemLoggerFilename);
+  if (!status.ok()) {
+    writers_.erase(kFilesystemLoggerFilename);
+  }
+  return status;
 }
 
 Status FilesystemLoggerPlugin::logString(const std::string& s) {
@@ -98,16 +182,118 @@ Status FilesystemLoggerPlugin::logStringToFile(const std::string& s,
                                                const std::string& filename,
                                                bool empty) {
   WriteLock lock(mutex_);
-  Status status;
-  try {
-    status = writeTextFile((log_path_ / filename).string(),
-                           (empty) ? "" : s + '\n',
-                           FLAGS_logger_mode,
-                           true);
-  } catch (const std::exception& e) {
-    return Status(1, e.what());
+
+  auto& writer = writers_[filename];
+  if (writer.file == nullptr) {
+    auto status = openWriter(writer, filename);
+    if (!status.ok()) {
+      writers_.erase(filename);
+      return status;
+    }
   }
-  return status;
+
+  if (empty) {
+    return Status(0, "OK");
+  }
+
+  writer.buffer.append(s);
+  writer.buffer.push_back('\n');
+  writer.written += s.size() + 1;
+
+  // Honor the buffered flush policy: write through by default, otherwise
+  // collect lines until the buffer fills or the oldest line waits too long.
+  auto now = loggerMilliseconds();
+  if (writer.buffer.size() < FLAGS_logger_buffer_size &&
+      now - writer.last_flush < FLAGS_logger_flush_latency) {
+    return Status(0, "OK");
+  }
+
+  auto status = flushWriter(writer);
+  if (!status.ok()) {
+    return status;
+  }
+
+  if (FLAGS_logger_rotate_size > 0 &&
+      writer.written >= FLAGS_logger_rotate_size) {
+    return rotateWriter(writer, filename);
+  }
+  return Status(0, "OK");
+}
+
+Status FilesystemLoggerPlugin::openWriter(LogWriter& writer,
+                                          const std::string& filename) {
+  auto path = (log_path_ / filename).string();
+  writer.file.reset(new PlatformFile(
+      path, PF_OPEN_ALWAYS | PF_WRITE | PF_APPEND, FLAGS_logger_mode));
+  if (!writer.file->isValid()) {
+    writer.file.reset();
+    return Status(1, "Could not open log file: " + path);
+  }
+
+  writer.written = writer.file->size();
+  writer.last_flush = loggerMilliseconds();
+  return Status(0, "OK");
+}
+
+Status FilesystemLoggerPlugin::flushWriter(LogWriter& writer) {
+  writer.last_flush = loggerMilliseconds();
+  if (writer.buffer.empty() || writer.file == nullptr) {
+    return Status(0, "OK");
+  }
+
+  // A single O_APPEND write keeps concurrent writers (log shippers, other
+  // processes) from interleaving within a line.
+  auto rc = writer.file->write(writer.buffer.data(), writer.buffer.size());
+  if (rc < 0 || static_cast<size_t>(rc) != writer.buffer.size()) {
+    return Status(1, "Could not append to log file");
+  }
+
+  writer.buffer.clear();
+  return Status(0, "OK");
+}
+
+Status FilesystemLoggerPlugin::rotateWriter(LogWriter& writer,
+                                            const std::string& filename) {
+  writer.file.reset();
+
+  auto base = (log_path_ / filename).string();
+  auto max_files =
+      (FLAGS_logger_rotate_max_files > 0) ? FLAGS_logger_rotate_max_files : 1;
+
+  // Drop the oldest rotated file, then shift the rest of the chain up.
+  for (const std::string& suffix : {".zst", ""}) {
+    auto oldest = base + "." + std::to_string(max_files) + suffix;
+    if (pathExists(oldest).ok()) {
+      removePath(oldest);
+    }
+  }
+
+  for (auto i = max_files - 1; i > 0; i--) {
+    for (const std::string& suffix : {".zst", ""}) {
+      auto from = base + "." + std::to_string(i) + suffix;
+      if (pathExists(from).ok()) {
+        movePath(from, base + "." + std::to_string(i + 1) + suffix);
+      }
+    }
+  }
+
+  auto status = movePath(base, base + ".1");
+  if (status.ok() && FLAGS_logger_rotate_compress) {
+    // Compression failures keep the uncompressed rotated file.
+    if (compress(base + ".1", base + ".1.zst").ok()) {
+      removePath(base + ".1");
+    }
+  }
+
+  return openWriter(writer, filename);
+}
+
+void FilesystemLoggerPlugin::tearDown() {
+  WriteLock lock(mutex_);
+  for (auto& writer : writers_) {
+    flushWriter(writer.second);
+  }
+  writers_.clear();
 }
 
 Status FilesystemLoggerPlugin::logStatus(
@@ -11,6 +11,8 @@
 
 #include <unistd.h>
 
+#include <cstdint>
+
 #include <boost/algorithm/string/find.hpp>
 
 #include <osquery/config.h>
@@ -44,15 +46,36 @@ FLAG(string,
      "all",
      "The number of acknowledgments the leader has to receive (0, 1, 'all')");
 
-FLAG(
-    string,
-    logger_kafka_compression,
-    "none",
-    "Compression codec to use for compressing message sets ('none' or 'gzip')");
+FLAG(string,
+     logger_kafka_compression,
+     "none",
+     "Compression codec to use for compressing message sets ('none', 'gzip', "
+     "'snappy', 'lz4' or 'zstd')");
+
+FLAG(uint64,
+     logger_kafka_batch_messages,
+     0,
+     "Maximum number of messages batched into one Kafka request, 0 uses the "
+     "librdkafka default");
+
+FLAG(uint64,
+     logger_kafka_linger_ms,
+     0,
+     "Milliseconds to wait for batch accumulation before sending to Kafka, 0 "
+     "uses the librdkafka default");
+
+FLAG(uint64,
+     logger_kafka_retries,
+     2,
+     "Number of times to re-publish a message whose delivery failed before "
+     "dropping it");
 
 /// How often to poll Kafka broker for publish results.
 const std::chrono::seconds kKafkaPollDuration = std::chrono::seconds(5);
 
+/// Maximum number of failed messages buffered for re-publish.
+const size_t kKafkaMaxDeadLetters{10000};
+
 /// Default Kafka topic to publish to if payload name is not found.
 const std::string kKafkaBaseTopic("base_topic");
 
@@ -122,16 +145,30 @@ inline std::string getMsgName(const std::string& payload) {
 /**
  * @brief callback for status of message delivery
  *
- * Logs an error message for failed deliveries; does nothing if successful.
- * Callback is invoked by rd_kafka_poll.
+ * Queues failed deliveries for a bounded number of re-publish attempts, then
+ * logs an error; does nothing if successful. Callback is invoked by
+ * rd_kafka_poll.
  */
 void onMsgDelivery(rd_kafka_t* rk,
                    const rd_kafka_message_t* rkmessage,
                    void* opaque) {
-  if (rkmessage->err != RD_KAFKA_RESP_ERR_NO_ERROR) {
-    LOG(ERROR) << "Kafka message delivery failed: "
-               << rd_kafka_err2str(rkmessage->err);
+  if (rkmessage->err == RD_KAFKA_RESP_ERR_NO_ERROR) {
+    return;
+  }
+
+  // The message opaque carries the number of delivery attempts made.
+  auto attempts = reinterpret_cast<uintptr_t>(rkmessage->_private);
+  auto plugin = static_cast<KafkaProducerPlugin*>(opaque);
+  if (plugin != nullptr && attempts < FLAGS_logger_kafka_retries) {
+    plugin->queueDeadLetter(
+        rkmessage->rkt,
+        std::string(static_cast<char*>(rkmessage->payload), rkmessage->len),
+        attempts + 1);
+    return;
   }
+
+  LOG(ERROR) << "Kafka message delivery failed: "
+             << rd_kafka_err2str(rkmessage->err);
 }
 
 void KafkaProducerPlugin::flushMessages() {
@@ -144,6 +181,32 @@ void KafkaProducerPlugin::pollKafka() {
   rd_kafka_poll(producer_.get(), 0 /*non-blocking*/);
 }
 
+void KafkaProducerPlugin::queueDeadLetter(rd_kafka_topic_t* topic,
+                                          const std::string& payload,
+                                          size_t attempts) {
+  WriteLock lock(deadLetterMutex_);
+  if (deadLetters_.size() >= kKafkaMaxDeadLetters) {
+    LOG(ERROR) << "Kafka dead-letter buffer is full, dropping message";
+    return;
+  }
+  deadLetters_.push_back({topic, payload, attempts});
+}
+
+void KafkaProducerPlugin::resendFailed() {
+  std::vector<KafkaDeadLetter> retries;
+  {
+    WriteLock lock(deadLetterMutex_);
+    retries.swap(deadLetters_);
+  }
+
+  for (const auto& letter : retries) {
+    auto status = publishMsg(letter.topic, letter.payload, letter.attempts);
+    if (!status.ok()) {
+      LOG(ERROR) << "Could not re-publish message: " << status.getMessage();
+    }
+  }
+}
+
 void KafkaProducerPlugin::start() {
   while (!interrupted() && running_.load()) {
     pauseMilli(kKafkaPollDuration);
@@ -151,6 +214,7 @@ void KafkaProducerPlugin::start() {
       return;
     }
     pollKafka();
+    resendFailed();
   }
 }
 
@@ -158,6 +222,7 @@ void KafkaProducerPlugin::stop() {
   std::call_once(shutdownFlag_, [this]() {
     if (running_.load()) {
       running_.store(false);
+      resendFailed();
       flushMessages();
     }
   });
@@ -191,14 +256,25 @@ void KafkaProducerPlugin::init(const std::string& name,
     }
   }
 
+  // Batch tuning values of 0 select the librdkafka defaults, setConf skips
+  // empty values.
+  auto batch_messages = (FLAGS_logger_kafka_batch_messages > 0)
+                            ? std::to_string(FLAGS_logger_kafka_batch_messages)
+                            : std::string();
+  auto linger_ms = (FLAGS_logger_kafka_linger_ms > 0)
+                       ? std::to_string(FLAGS_logger_kafka_linger_ms)
+                       : std::string();
   if (!setConf(conf, "client.id", hostname) ||
       !setConf(conf, "bootstrap.servers", FLAGS_logger_kafka_brokers) ||
-      !setConf(conf, "compression.codec", FLAGS_logger_kafka_compression)) {
+      !setConf(conf, "compression.codec", FLAGS_logger_kafka_compression) ||
+      !setConf(conf, "batch.num.messages", batch_messages) ||
+      !setConf(conf, "queue.buffering.max.ms", linger_ms)) {
     return;
   }
 
-  // Register send callback.
+  // Register send callback, the delivery reports re-queue failed messages.
   rd_kafka_conf_set_dr_msg_cb(conf, onMsgDelivery);
+  rd_kafka_conf_set_opaque(conf, this);
 
   // Create producer handle.
   char errstr[512] = {0};
@@ -256,14 +332,14 @@ Status KafkaProducerPlugin::logString(const std::string& payload) {
     LOG(ERROR) << "Could not publish message: " << status.getMessage();
   }
 
-  // Poll after every produce attempt.
-  pollKafka();
-
+  // Delivery reports are collected by the background poll loop, polling per
+  // produced message would serialize the logger hot path.
   return status;
 }
 
 Status KafkaProducerPlugin::publishMsg(rd_kafka_topic_t* topic,
-                                       const std::string& payload) {
+                                       const std::string& payload,
+                                       size_t attempts) {
   if (rd_kafka_produce(topic,
                        RD_KAFKA_PARTITION_UA,
                        RD_KAFKA_MSG_F_COPY,
@@ -271,7 +347,8 @@ Status KafkaProducerPlugin::publishMsg(rd_kafka_topic_t* topic,
                        payload.length(),
                        msgKey_.c_str(), // Optional key
                        msgKey_.length(), // key length
-                       nullptr) == -1) {
+                       reinterpret_cast<void*>(
+                           static_cast<uintptr_t>(attempts))) == -1) {
     return Status(1,
                   "Failed to produce on Kafka topic " +
                       std::string(rd_kafka_topic_name(topic)) + " : " +
@@ -28,13 +28,27 @@ extern const std::string kKafkaBaseTopic;
 /// Retrieves log payload field "name".
 std::string getMsgName(const std::string& payload);
 
+/// A message whose asynchronous delivery failed, queued for re-publish.
+struct KafkaDeadLetter {
+  /// Kafka topic the message was originally produced on.
+  rd_kafka_topic_t* topic;
+
+  /// The log line payload.
+  std::string payload;
+
+  /// Number of delivery attempts made so far.
+  size_t attempts;
+};
+
 class KafkaProducerPlugin : public LoggerPlugin, public InternalRunnable {
  public:
   /*
    * @brief Logs string s as payload to configured Kafka brokers.
    *
-   * Calls rd_kafka_poll regardless of production success.  rd_kafka_poll
-   * invokes callback that actually reports if message sends failed.
+   * Production is asynchronous, librdkafka accumulates messages into batches
+   * (see the logger_kafka_batch_messages and logger_kafka_linger_ms flags).
+   * The background poll loop invokes the delivery report callback, which
+   * re-queues failed messages for retry.
    */
   Status logString(const std::string& s) override;
 
@@ -68,17 +82,38 @@ class KafkaProducerPlugin : public LoggerPlugin, public InternalRunnable {
   KafkaProducerPlugin(KafkaProducerPlugin const&) = delete;
   KafkaProducerPlugin& operator=(KafkaProducerPlugin const&) = delete;
 
+  /**
+   * @brief Buffer a message whose asynchronous delivery failed.
+   *
+   * Invoked by the delivery report callback. The buffer is bounded, when full
+   * the message is dropped with an error log.
+   */
+  void queueDeadLetter(rd_kafka_topic_t* topic,
+                       const std::string& payload,
+                       size_t attempts);
+
  protected:
   /**
    * @brief Publishes message to Kafka topic.
    *
    * @param topic Kafka topic to publish to
-   * @param msg message body
+   * @param payload message body
+   * @param attempts delivery attempts already made, passed through the
+   * message opaque to the delivery report callback for bounded retries
    *
    * @return Status of publish attempt
    */
   virtual Status publishMsg(rd_kafka_topic_t* topic,
-                            const std::string& payload);
+                            const std::string& payload,
+                            size_t attempts = 0);
+
+  /**
+   * @brief Re-publishes buffered dead-letter messages.
+   *
+   * Called from the background poll loop. A message that fails synchronous
+   * re-production is dropped with an error log.
+   */
+  virtual void resendFailed();
 
   /**
    * @brief Flushes all buffered messages to Kafka, waiting for a maximum of 3
@@ -119,6 +154,12 @@ class KafkaProducerPlugin : public LoggerPlugin, public InternalRunnable {
   /// Mutex for managing access to the producer_ pointer.
   Mutex producerMutex_;
 
+  /// Messages awaiting re-publish after a failed delivery.
+  std::vector<KafkaDeadLetter> deadLetters_;
+
+  /// Mutex for managing access to deadLetters_.
+  Mutex deadLetterMutex_;
+
   /// Flag to ensure shutdown method is called only once
   static std::once_flag shutdownFlag_;
 };
@@ -24,6 +24,8 @@ namespace osquery {
 
 DECLARE_string(logger_path);
 DECLARE_bool(disable_logging);
+DECLARE_uint64(logger_rotate_size);
+DECLARE_bool(logger_rotate_compress);
 
 class FilesystemLoggerTests : public testing::Test {
  public:
@@ -168,4 +170,19 @@ TEST_F(FilesystemLoggerTests, test_log_snapshot) {
       "\"unixTime\":0,\"epoch\":0,\"counter\":0}\n";
   EXPECT_EQ(content, expected);
 }
+
+TEST_F(FilesystemLoggerTests, test_log_rotation) {
+  auto rotate_size = FLAGS_logger_rotate_size;
+  auto rotate_compress = FLAGS_logger_rotate_compress;
+
+  // Any write will push the results log over this rotation threshold.
+  FLAGS_logger_rotate_size = 1;
+  FLAGS_logger_rotate_compress = false;
+
+  EXPECT_TRUE(logString("{\"json\": true}", "event"));
+  EXPECT_TRUE(fs::exists(results_path_ + ".1"));
+
+  FLAGS_logger_rotate_size = rotate_size;
+  FLAGS_logger_rotate_compress = rotate_compress;
+}
 }
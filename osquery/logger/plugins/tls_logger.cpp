@@ -37,7 +37,13 @@ FLAG(uint64,
      1 * 1024 * 1024,
      "Max size in bytes allowed per log line");
 
-FLAG(bool, logger_tls_compress, false, "GZip compress TLS/HTTPS request body");
+FLAG(bool, logger_tls_compress, false, "Compress TLS/HTTPS request body");
+
+FLAG(string,
+     logger_tls_compression,
+     "gzip",
+     "Content-Encoding used when compressing the TLS/HTTPS request body "
+     "('gzip' or 'zstd')");
 
 REGISTER(TLSLoggerPlugin, "logger", "tls");
 
@@ -116,6 +122,9 @@ Status TLSLogForwarder::send(std::vector<std::string>& log_data,
   std::string response;
   if (FLAGS_logger_tls_compress) {
     params.add("_compress", true);
+    if (FLAGS_logger_tls_compression != "gzip") {
+      params.add("_compress_encoding", FLAGS_logger_tls_compression);
+    }
   }
   return TLSRequestHelper::go<JSONSerializer>(uri_, params, response);
 }
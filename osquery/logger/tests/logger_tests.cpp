@@ -27,6 +27,7 @@ DECLARE_bool(logger_secondary_status_only);
 DECLARE_bool(logger_status_sync);
 DECLARE_bool(logger_event_type);
 DECLARE_bool(logger_snapshot_event_type);
+DECLARE_uint64(logger_snapshot_batch);
 DECLARE_bool(disable_logging);
 
 class LoggerTests : public testing::Test {
@@ -288,6 +289,15 @@ TEST_F(LoggerTests, test_logger_snapshots) {
   logSnapshotQuery(item);
   EXPECT_EQ(4U, LoggerTests::snapshot_rows_added);
   FLAGS_logger_snapshot_event_type = false;
+
+  // With a batch bound, a snapshot is emitted as multiple bounded items.
+  item.snapshot_results.push_back({{"test_column", "test_value"}});
+  item.snapshot_results.push_back({{"test_column", "test_value"}});
+  item.snapshot_results.push_back({{"test_column", "test_value"}});
+  FLAGS_logger_snapshot_batch = 2;
+  logSnapshotQuery(item);
+  EXPECT_EQ(6U, LoggerTests::snapshot_rows_added);
+  FLAGS_logger_snapshot_batch = 0;
 }
 
 class SecondTestLoggerPlugin : public LoggerPlugin {
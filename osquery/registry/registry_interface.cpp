@@ -180,7 +180,7 @@ Status RegistryInterface::addAlias(const std::string& item_name,
     return Status(1, "Duplicate alias: " + alias);
   }
   aliases_[alias] = item_name;
-  return Status(0, "OK");
+  return Status::success();
 }
 
 std::string RegistryInterface::getAlias(const std::string& alias) const {
@@ -209,7 +209,7 @@ Status RegistryInterface::addPlugin(const std::string& plugin_name,
     internal_.push_back(plugin_name);
   }
 
-  return Status(0, "OK");
+  return Status::success();
 }
 
 void RegistryInterface::setUp() {
@@ -273,7 +273,7 @@ Status RegistryInterface::addExternal(const RouteUUID& uuid,
     }
   }
 
-  return Status(0, "OK");
+  return Status::success();
 }
 
 /// Remove all the routes for a given uuid.
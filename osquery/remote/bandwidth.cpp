@@ -0,0 +1,115 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include <osquery/flags.h>
+
+#include "osquery/remote/bandwidth.h"
+
+namespace osquery {
+
+FLAG(uint64,
+     tls_upload_bandwidth,
+     0,
+     "Maximum outbound bytes per second shared by carve block and "
+     "distributed result uploads (0 = unshaped)");
+
+/// Monotonic milliseconds for refill bookkeeping.
+static size_t shaperMilliseconds() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+UploadShaper& UploadShaper::instance() {
+  static UploadShaper shaper;
+  return shaper;
+}
+
+void UploadShaper::refill(size_t limit) {
+  auto now = shaperMilliseconds();
+  if (last_refill_ == 0) {
+    // First shaped acquire: start with one second of burst at the ceiling.
+    rate_ = limit;
+    tokens_ = static_cast<double>(limit);
+  } else {
+    // The ceiling may have been lowered through the config options flow.
+    rate_ = std::min(rate_, limit);
+    tokens_ += static_cast<double>(rate_) *
+               static_cast<double>(now - last_refill_) / 1000.0;
+    tokens_ = std::min(tokens_, static_cast<double>(rate_));
+  }
+  last_refill_ = now;
+}
+
+void UploadShaper::acquire(size_t bytes) {
+  auto limit = static_cast<size_t>(FLAGS_tls_upload_bandwidth);
+  if (limit == 0) {
+    return;
+  }
+
+  while (true) {
+    size_t wait_ms = 0;
+    {
+      WriteLock lock(mutex_);
+      refill(limit);
+      if (tokens_ >= 0) {
+        // Send on credit: payloads larger than the burst budget drive the
+        // balance negative and later senders wait out the debt, so one
+        // large part cannot be starved forever.
+        tokens_ -= static_cast<double>(bytes);
+        return;
+      }
+      wait_ms = static_cast<size_t>(-tokens_ * 1000.0 /
+                                    static_cast<double>(rate_)) +
+                1;
+    }
+    // Cap each sleep so a lowered debt (or raised ceiling) is noticed.
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(std::min(wait_ms, size_t{500})));
+  }
+}
+
+void UploadShaper::reportSuccess() {
+  auto limit = static_cast<size_t>(FLAGS_tls_upload_bandwidth);
+  if (limit == 0) {
+    return;
+  }
+
+  WriteLock lock(mutex_);
+  if (rate_ == 0) {
+    return;
+  }
+  // Additive increase: ramp back toward the ceiling in 1/16th steps.
+  rate_ = std::min(limit, rate_ + std::max(limit / 16, size_t{1}));
+}
+
+void UploadShaper::reportFailure() {
+  auto limit = static_cast<size_t>(FLAGS_tls_upload_bandwidth);
+  if (limit == 0) {
+    return;
+  }
+
+  WriteLock lock(mutex_);
+  if (rate_ == 0) {
+    return;
+  }
+  // Multiplicative decrease, floored so uploads always make progress.
+  rate_ = std::max(rate_ / 2, std::max(limit / 8, size_t{1}));
+}
+
+size_t UploadShaper::currentRate() {
+  WriteLock lock(mutex_);
+  return rate_;
+}
+} // namespace osquery
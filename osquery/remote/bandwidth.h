@@ -0,0 +1,70 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+
+#include <osquery/mutex.h>
+
+namespace osquery {
+
+/**
+ * @brief A process-wide token bucket pacing outbound upload payloads.
+ *
+ * Carve block POSTs and large distributed result uploads can otherwise
+ * saturate a constrained uplink. Senders call acquire() with the payload
+ * size before each request; the call blocks until the byte budget allows
+ * the send, bounded by the tls_upload_bandwidth flag (0 = unshaped).
+ *
+ * The effective rate ramps within the operator ceiling: request failures
+ * (throttling, timeouts) halve it down to 1/8th of the ceiling, successes
+ * ramp it back additively, so a congested uplink is probed instead of
+ * hammered. The shaper is shared by every upload path so concurrent
+ * senders divide one ceiling.
+ */
+class UploadShaper : private boost::noncopyable {
+ public:
+  /// Singleton accessor, shared by all upload call sites.
+  static UploadShaper& instance();
+
+  /// Block until the shaped budget covers a payload of the given size.
+  void acquire(size_t bytes);
+
+  /// Report a completed request, additively raising the effective rate.
+  void reportSuccess();
+
+  /// Report a failed request, halving the effective rate.
+  void reportFailure();
+
+  /// The current effective rate in bytes per second (0 = unshaped).
+  size_t currentRate();
+
+ private:
+  UploadShaper() = default;
+
+  /// Add budget for the time elapsed since the last refill, capped at one
+  /// second of burst. The caller must hold mutex_.
+  void refill(size_t limit);
+
+  /// Guards the token and rate state below.
+  Mutex mutex_;
+
+  /// Byte budget; negative after a large payload was sent on credit.
+  double tokens_{0};
+
+  /// Monotonic milliseconds of the last budget refill.
+  size_t last_refill_{0};
+
+  /// Effective bytes per second after congestion ramping, within the flag
+  /// ceiling (0 until the first shaped acquire).
+  size_t rate_{0};
+};
+} // namespace osquery
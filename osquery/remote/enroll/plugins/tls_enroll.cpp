@@ -8,6 +8,11 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+#include <osquery/database.h>
 #include <osquery/enroll.h>
 #include <osquery/flags.h>
 #include <osquery/logger.h>
@@ -15,6 +20,7 @@
 #include <osquery/sql.h>
 #include <osquery/system.h>
 
+#include "osquery/core/conversions.h"
 #include "osquery/remote/requests.h"
 #include "osquery/remote/serializers/json.h"
 #include "osquery/remote/transports/tls.h"
@@ -48,6 +54,34 @@ HIDDEN_FLAG(string,
 
 REGISTER(TLSEnrollPlugin, "enroll", "tls");
 
+/// Smallest delay in seconds between failed enrollment attempts.
+const size_t kEnrollBackoffBase = 2;
+
+/// Largest delay in seconds between failed enrollment attempts.
+const size_t kEnrollBackoffCap = 300;
+
+/// Persistent-settings key holding the most recent backoff delay.
+const std::string kEnrollBackoffKey = "enrollRetryDelay";
+
+/**
+ * @brief Sample the next enrollment retry delay in seconds.
+ *
+ * This uses decorrelated jitter: each delay is drawn uniformly between the
+ * base and three times the previous delay (capped). Unlike fixed exponential
+ * schedules, retries from a fleet restarted at the same moment spread out
+ * instead of arriving at the endpoint in synchronized waves.
+ */
+static size_t enrollRetryDelay(size_t previous) {
+  auto ceiling =
+      std::min(kEnrollBackoffCap, std::max(kEnrollBackoffBase, previous * 3));
+  std::default_random_engine generator;
+  generator.seed(static_cast<unsigned int>(
+      std::chrono::high_resolution_clock::now().time_since_epoch().count()));
+  std::uniform_int_distribution<size_t> distribution(kEnrollBackoffBase,
+                                                     ceiling);
+  return distribution(generator);
+}
+
 std::string TLSEnrollPlugin::enroll() {
   // If no node secret has been negotiated, try a TLS request.
   auto uri = "https://" + FLAGS_tls_hostname + FLAGS_enroll_tls_endpoint;
@@ -56,24 +90,49 @@ std::string TLSEnrollPlugin::enroll() {
            FLAGS_tls_enroll_override + "=" + getEnrollSecret();
   }
 
+  // Resume any persisted backoff state so a respawned or restarted agent
+  // continues its schedule instead of restarting from the smallest delay.
+  size_t delay = 0;
+  {
+    std::string persisted;
+    unsigned long parsed = 0;
+    getDatabaseValue(kPersistentSettings, kEnrollBackoffKey, persisted);
+    if (!persisted.empty() && safeStrtoul(persisted, 10, parsed).ok()) {
+      delay = static_cast<size_t>(parsed);
+    }
+  }
+
   std::string node_key;
   VLOG(1) << "TLSEnrollPlugin requesting a node enroll key from: " << uri;
   for (size_t i = 1; i <= FLAGS_config_tls_max_attempts; i++) {
-    auto status = requestKey(uri, node_key);
-    if (status.ok() || i == FLAGS_config_tls_max_attempts) {
+    size_t retry_after = 0;
+    auto status = requestKey(uri, node_key, retry_after);
+    if (status.ok()) {
+      deleteDatabaseValue(kPersistentSettings, kEnrollBackoffKey);
+      break;
+    } else if (i == FLAGS_config_tls_max_attempts) {
       break;
     }
 
+    delay = enrollRetryDelay(delay);
+    if (retry_after > 0) {
+      // The server stated the earliest time it can absorb another attempt.
+      delay = std::max(delay, std::min(retry_after, kEnrollBackoffCap));
+    }
+    setDatabaseValue(
+        kPersistentSettings, kEnrollBackoffKey, std::to_string(delay));
+
     LOG(WARNING) << "Failed enrollment request to " << uri << " ("
-                 << status.what() << ") retrying...";
-    sleepFor(i * i * 1000);
+                 << status.what() << ") retrying in " << delay << "s...";
+    sleepFor(delay * 1000);
   }
 
   return node_key;
 }
 
 Status TLSEnrollPlugin::requestKey(const std::string& uri,
-                                   std::string& node_key) {
+                                   std::string& node_key,
+                                   size_t& retry_after) {
   // Read the optional enrollment secret data (sent with an enrollment request).
   JSON params;
   params.add(FLAGS_tls_enroll_override, getEnrollSecret());
@@ -90,6 +149,16 @@ Status TLSEnrollPlugin::requestKey(const std::string& uri,
   Request<TLSTransport, JSONSerializer> request(uri);
   request.setOption("hostname", FLAGS_tls_hostname);
   auto status = request.call(params);
+
+  // A rate-limited endpoint advises the client with a delay-seconds
+  // Retry-After header (HTTP-date forms are ignored as non-numeric).
+  const auto& retry_header = request.getResponseHeader("Retry-After");
+  unsigned long delay_seconds = 0;
+  if (!retry_header.empty() &&
+      safeStrtoul(retry_header, 10, delay_seconds).ok()) {
+    retry_after = static_cast<size_t>(delay_seconds);
+  }
+
   if (!status.ok()) {
     return status;
   }
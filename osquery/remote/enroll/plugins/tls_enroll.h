@@ -21,7 +21,11 @@ class TLSEnrollPlugin : public EnrollPlugin {
 
  private:
   /// Request an enrollment key response from the TLS endpoint.
-  Status requestKey(const std::string& uri, std::string& node_key);
+  /// If the server rate limited the request with a delay-seconds Retry-After
+  /// header, the advised delay is returned through retry_after.
+  Status requestKey(const std::string& uri,
+                    std::string& node_key,
+                    size_t& retry_after);
 
  private:
   friend class TLSEnrollTests;
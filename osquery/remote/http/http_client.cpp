@@ -8,17 +8,81 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <map>
+#include <vector>
+
+#include <osquery/database.h>
+#include <osquery/flags.h>
 #include <osquery/logger.h>
+#include <osquery/mutex.h>
+#include <osquery/system.h>
 
+#include "osquery/core/conversions.h"
 #include "osquery/remote/http_client.h"
 
 namespace osquery {
+
+FLAG(uint64,
+     dns_cache_ttl,
+     300,
+     "Seconds resolved remote endpoint addresses are reused before a new "
+     "lookup (0 disables the resolution cache)");
+
 namespace http {
 
 const std::string kHTTPSDefaultPort{"443"};
 const std::string kHTTPDefaultPort{"80"};
 const std::string kProxyDefaultPort{"3128"};
 
+/// Backing store key prefix for last-known-good endpoint addresses.
+const std::string kDNSFallbackPrefix{"dns_fallback."};
+
+/// A positive resolution cache entry.
+struct ResolvedHost {
+  /// Addresses in resolver-preference order.
+  std::vector<std::string> addresses;
+
+  /// UNIX time after which the entry must be refreshed.
+  size_t expiry{0};
+};
+
+/// Process-wide resolution cache shared by every client instance.
+static Mutex kDNSCacheMutex;
+static std::map<std::string, ResolvedHost> kDNSCache;
+
+static bool getCachedEndpoints(const std::string& host,
+                               std::vector<std::string>& addresses) {
+  if (FLAGS_dns_cache_ttl == 0) {
+    return false;
+  }
+
+  WriteLock lock(kDNSCacheMutex);
+  auto it = kDNSCache.find(host);
+  if (it == kDNSCache.end() || getUnixTime() >= it->second.expiry) {
+    return false;
+  }
+  addresses = it->second.addresses;
+  return true;
+}
+
+static void cacheEndpoints(const std::string& host,
+                           const std::vector<std::string>& addresses,
+                           size_t ttl) {
+  if (FLAGS_dns_cache_ttl == 0 || addresses.empty()) {
+    return;
+  }
+
+  WriteLock lock(kDNSCacheMutex);
+  auto& entry = kDNSCache[host];
+  entry.addresses = addresses;
+  entry.expiry = getUnixTime() + ttl;
+}
+
+static void dropCachedEndpoints(const std::string& host) {
+  WriteLock lock(kDNSCacheMutex);
+  kDNSCache.erase(host);
+}
+
 const long kSSLShortReadError{0x140000dbL};
 
 /** This class is used to convert boost::system_exception
@@ -71,6 +135,80 @@ void Client::timeoutHandler(boost_system::error_code const& ec) {
   }
 }
 
+std::vector<std::string> Client::resolveEndpoints(const std::string& host,
+                                                  const std::string& port) {
+  boost_system::error_code rc;
+  if (client_options_.timeout_) {
+    // Bound the lookup with the request deadline so a degraded resolver
+    // cannot stall the transport longer than the configured timeout.
+    timer_.async_wait([&](boost_system::error_code const& ec) {
+      if (!ec) {
+        r_.cancel();
+        rc = boost_system::errc::make_error_code(boost_system::errc::timed_out);
+      }
+    });
+  }
+
+  boost_asio::ip::tcp::resolver::iterator results;
+  r_.async_resolve(boost_asio::ip::tcp::resolver::query{host, port},
+                   [&](boost_system::error_code const& ec,
+                       boost_asio::ip::tcp::resolver::iterator it) {
+                     if (client_options_.timeout_) {
+                       timer_.cancel();
+                     }
+                     if (ec) {
+                       if (!rc) {
+                         rc = ec;
+                       }
+                     } else {
+                       results = it;
+                     }
+                   });
+
+  {
+    boost_system::error_code run_rc;
+    ios_.run(run_rc);
+    ios_.reset();
+  }
+
+  std::vector<std::string> addresses;
+  if (rc) {
+    VLOG(1) << "Cannot resolve " << host << ": " << rc.message();
+    return addresses;
+  }
+
+  for (boost_asio::ip::tcp::resolver::iterator end; results != end;
+       results++) {
+    addresses.push_back(results->endpoint().address().to_string());
+  }
+  return addresses;
+}
+
+bool Client::connectToEndpoints(const std::vector<std::string>& addresses,
+                                const std::string& port) {
+  long port_num = 0;
+  if (!safeStrtol(port, 10, port_num).ok()) {
+    return false;
+  }
+
+  for (const auto& address : addresses) {
+    boost_system::error_code rc;
+    auto addr = boost_asio::ip::address::from_string(address, rc);
+    if (rc) {
+      continue;
+    }
+
+    sock_.connect(
+        boost_asio::ip::tcp::endpoint(addr, static_cast<uint16_t>(port_num)),
+        rc);
+    if (!rc) {
+      return true;
+    }
+    closeSocket();
+  }
+  return false;
+}
+
 void Client::createConnection() {
   std::string port = (client_options_.proxy_hostname_)
                          ? kProxyDefaultPort
@@ -86,19 +224,53 @@ void Client::createConnection() {
     connect_host = connect_host.substr(0, pos);
   }
 
-  boost_system::error_code rc;
-  connect(sock_,
-          r_.resolve(boost_asio::ip::tcp::resolver::query{connect_host, port}),
-          rc);
+  // Serve addresses from the resolution cache when possible; a fresh
+  // (deadline-bounded) lookup refreshes the cache and the persisted
+  // last-known-good list.
+  bool connected = false;
+  std::vector<std::string> addresses;
+  if (getCachedEndpoints(connect_host, addresses)) {
+    connected = connectToEndpoints(addresses, port);
+    if (!connected) {
+      // The cached addresses went stale, fall through to a new lookup.
+      dropCachedEndpoints(connect_host);
+    }
+  }
 
-  if (rc) {
+  if (!connected) {
+    addresses = resolveEndpoints(connect_host, port);
+    if (!addresses.empty()) {
+      cacheEndpoints(connect_host, addresses, FLAGS_dns_cache_ttl);
+      setDatabaseValue(kPersistentSettings,
+                       kDNSFallbackPrefix + connect_host,
+                       osquery::join(addresses, ","));
+      connected = connectToEndpoints(addresses, port);
+    } else {
+      // Resolution failed or timed out: fall back to the last-known-good
+      // addresses persisted by a previous successful lookup.
+      std::string fallback;
+      getDatabaseValue(
+          kPersistentSettings, kDNSFallbackPrefix + connect_host, fallback);
+      if (!fallback.empty()) {
+        VLOG(1) << "Using last-known-good addresses for " << connect_host;
+        connected = connectToEndpoints(osquery::split(fallback, ","), port);
+        if (connected) {
+          // Avoid repeating the failed lookup on every request while the
+          // resolver is degraded.
+          cacheEndpoints(connect_host, osquery::split(fallback, ","), 60);
+        }
+      }
+    }
+  }
+
+  if (!connected) {
     std::string error("Failed to connect to ");
     if (client_options_.proxy_hostname_) {
       error += "proxy host ";
     }
     error += connect_host + ":" + port;
     throw std::system_error(
-        std::error_code(rc.value(), std::generic_category()), error);
+        std::make_error_code(std::errc::host_unreachable), error);
   }
 
   if (client_options_.keep_alive_) {
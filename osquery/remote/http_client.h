@@ -241,6 +241,14 @@ class Client {
   /// Create Connection to server, if proxy option is set, connect to proxy.
   void createConnection();
 
+  /// Resolve a hostname, bounded by the request deadline when one is set.
+  std::vector<std::string> resolveEndpoints(const std::string& host,
+                                            const std::string& port);
+
+  /// Attempt to connect to each resolved address in order.
+  bool connectToEndpoints(const std::vector<std::string>& addresses,
+                          const std::string& port);
+
   /// Convert plain socket to TLS socket.
   void encryptConnection();
 
@@ -12,6 +12,7 @@
 #include <string>
 
 #include <zlib.h>
+#include <zstd.h>
 
 namespace osquery {
 
@@ -57,4 +58,18 @@ std::string compressString(const std::string& data) {
 
   return output;
 }
+
+std::string compressZstdString(const std::string& data) {
+  std::string output;
+  output.resize(ZSTD_compressBound(data.size()));
+
+  auto size = ZSTD_compress(
+      &output[0], output.size(), data.data(), data.size(), /* level */ 1);
+  if (ZSTD_isError(size)) {
+    return std::string();
+  }
+
+  output.resize(size);
+  return output;
+}
 }
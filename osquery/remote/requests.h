@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <map>
 #include <memory>
 #include <utility>
 #include <string>
@@ -32,6 +33,16 @@ class Serializer;
  */
 std::string compressString(const std::string& data);
 
+/**
+ * @brief Compress data using zstd.
+ *
+ * Selected when a transport negotiates the "zstd" Content-Encoding, see
+ * compressString for where the compression step occurs.
+ *
+ * @param data The input/output mutable container.
+ */
+std::string compressZstdString(const std::string& data);
+
 /**
  * @brief Abstract base class for remote transport implementations
  *
@@ -96,6 +107,28 @@ class Transport {
     return response_params_;
   }
 
+  /**
+   * @brief Get the HTTP-like response code
+   *
+   * @return The code, or 0 when the transport does not track response codes
+   */
+  size_t getResponseCode() const {
+    return response_code_;
+  }
+
+  /**
+   * @brief Get a response header captured by the transport
+   *
+   * @param name The header name to look up
+   *
+   * @return The header value, or an empty string when not present
+   */
+  const std::string& getResponseHeader(const std::string& name) const {
+    static const std::string empty;
+    auto it = response_headers_.find(name);
+    return (it == response_headers_.end()) ? empty : it->second;
+  }
+
   template <typename T>
   void setOption(const std::string& name, const T& value) {
     options_.add(name, value);
@@ -119,6 +152,12 @@ class Transport {
   /// storage for response parameters
   JSON response_params_;
 
+  /// storage for an HTTP-like response code, 0 when untracked
+  size_t response_code_{0};
+
+  /// storage for response headers captured by the transport
+  std::map<std::string, std::string> response_headers_;
+
   /// options from request call (use defined by specific transport)
   JSON options_;
 };
@@ -248,6 +287,16 @@ class Request {
     return transport_->getResponseStatus();
   }
 
+  /// Get the HTTP-like response code captured by the transport.
+  size_t getResponseCode() const {
+    return transport_->getResponseCode();
+  }
+
+  /// Get a response header captured by the transport.
+  const std::string& getResponseHeader(const std::string& name) const {
+    return transport_->getResponseHeader(name);
+  }
+
   template <typename T>
   void setOption(const std::string& name, const T& value) {
     options_.add(name, value);
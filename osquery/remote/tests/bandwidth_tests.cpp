@@ -0,0 +1,67 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <gtest/gtest.h>
+
+#include <osquery/flags.h>
+
+#include "osquery/remote/bandwidth.h"
+
+namespace osquery {
+
+DECLARE_uint64(tls_upload_bandwidth);
+
+class BandwidthTests : public testing::Test {
+ public:
+  void SetUp() override {
+    limit_ = FLAGS_tls_upload_bandwidth;
+  }
+
+  void TearDown() override {
+    FLAGS_tls_upload_bandwidth = limit_;
+  }
+
+ private:
+  decltype(FLAGS_tls_upload_bandwidth) limit_;
+};
+
+TEST_F(BandwidthTests, test_unshaped_default) {
+  // With no ceiling the shaper is a pass-through and tracks no rate.
+  FLAGS_tls_upload_bandwidth = 0;
+  auto& shaper = UploadShaper::instance();
+  shaper.acquire(1024 * 1024);
+  shaper.reportFailure();
+  EXPECT_EQ(shaper.currentRate(), 0U);
+}
+
+TEST_F(BandwidthTests, test_congestion_ramp) {
+  // A high ceiling so the burst budget covers every acquire immediately.
+  FLAGS_tls_upload_bandwidth = 1024 * 1024;
+  auto& shaper = UploadShaper::instance();
+
+  // The first shaped acquire starts at the operator ceiling.
+  shaper.acquire(1024);
+  EXPECT_EQ(shaper.currentRate(), 1024U * 1024U);
+
+  // Failures decrease multiplicatively, floored at 1/8th of the ceiling.
+  shaper.reportFailure();
+  EXPECT_EQ(shaper.currentRate(), 512U * 1024U);
+  for (size_t i = 0; i < 10; i++) {
+    shaper.reportFailure();
+  }
+  EXPECT_EQ(shaper.currentRate(), 128U * 1024U);
+
+  // Successes ramp back additively and saturate at the ceiling.
+  for (size_t i = 0; i < 32; i++) {
+    shaper.reportSuccess();
+  }
+  EXPECT_EQ(shaper.currentRate(), 1024U * 1024U);
+}
+} // namespace osquery
@@ -11,13 +11,15 @@
 // clang-format off
 // This must be here to prevent a WinSock.h exists error
 #include "osquery/remote/transports/tls.h"
-#include "osquery/dispatcher/io_service.h"
 // clang-format on
 
+#include <map>
+
 #include <boost/filesystem.hpp>
 
 #include <osquery/core.h>
 #include <osquery/filesystem.h>
+#include <osquery/system.h>
 
 namespace fs = boost::filesystem;
 
@@ -90,6 +92,32 @@ void TLSTransport::decorateRequest(http::Request& r) {
   r << http::Request::Header("Content-Type", serializer_->getContentType());
   r << http::Request::Header("Accept", serializer_->getContentType());
   r << http::Request::Header("User-Agent", kTLSUserAgentBase + kVersion);
+
+  // A caller-provided validator makes this a conditional request: servers
+  // supporting it answer unchanged content with a bodyless 304.
+  auto it = options_.doc().FindMember("if_none_match");
+  if (it != options_.doc().MemberEnd() && it->value.IsString() &&
+      it->value.GetStringLength() > 0) {
+    r << http::Request::Header("If-None-Match", it->value.GetString());
+  }
+}
+
+bool TLSTransport::recordResponseMetadata() {
+  response_code_ = response_.status();
+
+  response_headers_.clear();
+  auto etag = response_.headers()["ETag"];
+  if (!etag.empty()) {
+    response_headers_["ETag"] = etag;
+  }
+
+  // An overloaded endpoint may rate limit with a delay-seconds Retry-After.
+  auto retry_after = response_.headers()["Retry-After"];
+  if (!retry_after.empty()) {
+    response_headers_["Retry-After"] = retry_after;
+  }
+
+  return (response_code_ == 304);
 }
 
 http::Client::Options TLSTransport::getOptions() {
@@ -164,31 +192,98 @@ inline bool tlsFailure(const std::string& what) {
   return true;
 }
 
-static auto getClient() {
-  std::shared_ptr<http::Client> client = nullptr;
-  if (FLAGS_tls_session_reuse) {
-    thread_local std::shared_ptr<http::Client> tl_client;
-    client = tl_client;
+/// Maximum number of idle keep-alive clients retained per endpoint.
+const size_t kTLSMaxPooledClients{4};
 
-    if (client.get() == nullptr) {
-      tl_client = client = std::make_shared<http::Client>();
+/// Derive the connection identity (host and optional port) from a URI.
+static std::string endpointKey(const std::string& destination) {
+  auto start = destination.find("://");
+  start = (start == std::string::npos) ? 0 : start + 3;
+  auto end = destination.find('/', start);
+  return destination.substr(
+      start, (end == std::string::npos) ? end : end - start);
+}
 
-      if (FLAGS_tls_session_timeout > 0) {
-        thread_local boost::asio::deadline_timer tl_timer(IOService::get());
+/**
+ * @brief A process-wide pool of keep-alive HTTP clients, keyed by endpoint.
+ *
+ * Each client owns one TCP+TLS connection. Requests check a client out of the
+ * pool exclusively and return it after a successful exchange, so the config,
+ * logger, distributed, and enroll plugins reuse established connections
+ * instead of re-doing the handshakes per Request. Idle clients expire after
+ * the tls_session_timeout, and a client whose request failed is dropped
+ * rather than pooled.
+ */
+class TLSClientPool : private boost::noncopyable {
+ public:
+  static TLSClientPool& get() {
+    static TLSClientPool pool;
+    return pool;
+  }
 
-        tl_timer.expires_from_now(
-            boost::posix_time::seconds(FLAGS_tls_session_timeout));
-        auto this_client = &tl_client;
-        tl_timer.async_wait([this_client](boost_system::error_code const&) {
-          (*this_client).reset();
-        });
+  /// Take an idle client for this endpoint, or construct a fresh one.
+  std::shared_ptr<http::Client> acquire(const std::string& destination) {
+    if (FLAGS_tls_session_reuse) {
+      WriteLock lock(pool_mutex_);
+      expire();
+
+      auto it = clients_.find(endpointKey(destination));
+      if (it != clients_.end()) {
+        auto client = std::move(it->second.client);
+        clients_.erase(it);
+        return client;
       }
     }
-  } else {
-    client = std::make_shared<http::Client>();
+    return std::make_shared<http::Client>();
   }
-  return client;
-}
+
+  /// Return a client whose request succeeded to the pool.
+  void release(const std::string& destination,
+               std::shared_ptr<http::Client> client) {
+    if (!FLAGS_tls_session_reuse) {
+      return;
+    }
+
+    auto key = endpointKey(destination);
+    WriteLock lock(pool_mutex_);
+    expire();
+    if (clients_.count(key) >= kTLSMaxPooledClients) {
+      return;
+    }
+    clients_.emplace(std::move(key),
+                     PooledClient{std::move(client), getUnixTime()});
+  }
+
+ private:
+  /// An idle client and the time it was returned to the pool.
+  struct PooledClient {
+    std::shared_ptr<http::Client> client;
+    size_t released_at{0};
+  };
+
+  /// Drop clients idle beyond the session timeout (caller holds the lock).
+  void expire() {
+    if (FLAGS_tls_session_timeout == 0) {
+      return;
+    }
+
+    auto now = getUnixTime();
+    for (auto it = clients_.begin(); it != clients_.end();) {
+      if (it->second.released_at + FLAGS_tls_session_timeout < now) {
+        it = clients_.erase(it);
+      } else {
+        it++;
+      }
+    }
+  }
+
+ private:
+  /// Idle clients, keyed by endpoint host and port.
+  std::multimap<std::string, PooledClient> clients_;
+
+  /// Protects access to the pooled clients.
+  Mutex pool_mutex_;
+};
 
 Status TLSTransport::sendRequest() {
   if (destination_.find("https://") == std::string::npos) {
@@ -200,10 +295,17 @@ Status TLSTransport::sendRequest() {
 
   VLOG(1) << "TLS/HTTPS GET request to URI: " << destination_;
   try {
-    std::shared_ptr<http::Client> client = getClient();
+    auto client = TLSClientPool::get().acquire(destination_);
 
     client->setOptions(getOptions());
     response_ = client->get(r);
+    TLSClientPool::get().release(destination_, std::move(client));
+
+    if (recordResponseMetadata()) {
+      // Not Modified: the content matches the caller's validator.
+      response_status_ = Status::success();
+      return response_status_;
+    }
 
     const auto& response_body = response_.body();
     if (FLAGS_verbose && FLAGS_tls_dump) {
@@ -223,11 +325,26 @@ Status TLSTransport::sendRequest(const std::string& params, bool compress) {
     return Status(1, "Cannot create TLS request for non-HTTPS protocol URI");
   }
 
+  // The compression codec is negotiated through the Content-Encoding header,
+  // gzip unless the caller requested another encoding.
+  std::string encoding = "gzip";
+  {
+    auto it = options_.doc().FindMember("compress_encoding");
+    if (it != options_.doc().MemberEnd() && it->value.IsString()) {
+      encoding = it->value.GetString();
+    }
+  }
+
+  std::string compressed;
+  if (compress) {
+    compressed = (encoding == "zstd") ? compressZstdString(params)
+                                      : compressString(params);
+  }
+
   http::Request r(destination_);
   decorateRequest(r);
   if (compress) {
-    // Later, when posting/putting, the data will be optionally compressed.
-    r << http::Request::Header("Content-Encoding", "gzip");
+    r << http::Request::Header("Content-Encoding", encoding);
   }
 
   // Allow request calls to override the default HTTP POST verb.
@@ -245,13 +362,20 @@ Status TLSTransport::sendRequest(const std::string& params, bool compress) {
   }
 
   try {
-    std::shared_ptr<http::Client> client = getClient();
+    auto client = TLSClientPool::get().acquire(destination_);
     client->setOptions(getOptions());
 
     if (verb == HTTP_POST) {
-      response_ = client->post(r, (compress) ? compressString(params) : params);
+      response_ = client->post(r, (compress) ? compressed : params);
     } else {
-      response_ = client->put(r, (compress) ? compressString(params) : params);
+      response_ = client->put(r, (compress) ? compressed : params);
+    }
+    TLSClientPool::get().release(destination_, std::move(client));
+
+    if (recordResponseMetadata()) {
+      // Not Modified: the content matches the caller's validator.
+      response_status_ = Status::success();
+      return response_status_;
     }
 
     const auto& response_body = response_.body();
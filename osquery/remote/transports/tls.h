@@ -113,6 +113,14 @@ class TLSTransport : public Transport {
    */
   void decorateRequest(http::Request& r);
 
+  /**
+   * @brief Record response metadata and detect a 304 Not Modified reply.
+   *
+   * @return True if the response answered a conditional request with a
+   * bodyless 304, in which case there is nothing to deserialize.
+   */
+  bool recordResponseMetadata();
+
  protected:
   /// Storage for the HTTP response object
   http::Response response_;
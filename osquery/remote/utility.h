@@ -101,6 +101,25 @@ class TLSRequestHelper : private boost::noncopyable {
       params_doc.RemoveMember("_compress");
     }
 
+    // An optional Content-Encoding override for compressed bodies.
+    std::string compress_encoding;
+    it = params_doc.FindMember("_compress_encoding");
+    if (it != params_doc.MemberEnd() && it->value.IsString()) {
+      compress_encoding = it->value.GetString();
+      request.setOption("compress_encoding", compress_encoding);
+      params_doc.RemoveMember("_compress_encoding");
+    }
+
+    // A content validator from a previous response makes this conditional:
+    // unchanged content is answered with a bodyless 304.
+    std::string if_none_match;
+    it = params_doc.FindMember("_if_none_match");
+    if (it != params_doc.MemberEnd() && it->value.IsString()) {
+      if_none_match = it->value.GetString();
+      request.setOption("if_none_match", if_none_match);
+      params_doc.RemoveMember("_if_none_match");
+    }
+
     // The caller-supplied parameters may force a POST request.
     bool force_post = false;
     it = params_doc.FindMember("_verb");
@@ -129,10 +148,30 @@ class TLSRequestHelper : private boost::noncopyable {
       params.add("_compress", true);
     }
 
+    if (!compress_encoding.empty()) {
+      params.add("_compress_encoding", compress_encoding);
+    }
+
+    if (!if_none_match.empty()) {
+      params.add("_if_none_match", if_none_match);
+    }
+
     if (!status.ok()) {
       return status;
     }
 
+    // Surface the response validator so the caller may send it next time.
+    const auto& etag = request.getResponseHeader("ETag");
+    if (!etag.empty()) {
+      params.add("_etag", etag);
+    }
+
+    if (request.getResponseCode() == 304) {
+      // Not Modified: there is no body to inspect.
+      params.add("_not_modified", true);
+      return Status::success();
+    }
+
     // The call succeeded, store the enrolled key.
     status = request.getResponse(output);
     if (!status.ok()) {
@@ -0,0 +1,228 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <string>
+#include <unordered_map>
+
+#include "osquery/core/json.h"
+
+#include <sqlite3.h>
+
+namespace osquery {
+
+/**
+ * @brief Parsed documents cached by cell content.
+ *
+ * A query extracting several fields runs the extraction function once per
+ * field for the same JSON cell, and predicates re-evaluate the same cell
+ * again. Documents are cached by their source string so each distinct cell
+ * is parsed once per query, not once per extraction call. SQLite runs a
+ * statement on a single thread, so a thread-local cache needs no locking.
+ */
+using JSONDocumentCache = std::unordered_map<std::string, rapidjson::Document>;
+
+/// Bound the cached documents; cells rarely repeat beyond a statement.
+const size_t kJSONCacheLimit{256};
+
+static const rapidjson::Document* parseDocumentCached(const char* input) {
+  thread_local JSONDocumentCache cache;
+
+  auto cached = cache.find(input);
+  if (cached != cache.end()) {
+    return &cached->second;
+  }
+
+  rapidjson::Document doc;
+  if (doc.Parse(input).HasParseError()) {
+    return nullptr;
+  }
+
+  if (cache.size() >= kJSONCacheLimit) {
+    cache.clear();
+  }
+  auto result = cache.emplace(input, std::move(doc));
+  return &result.first->second;
+}
+
+/**
+ * @brief Resolve a '$.key.child[0]'-style path within a document.
+ *
+ * Supports object member access with '.name' and array element access with
+ * '[index]'. Returns nullptr if any step of the path does not exist.
+ */
+static const rapidjson::Value* resolveJSONPath(const rapidjson::Value& root,
+                                               const std::string& path) {
+  if (path.empty() || path[0] != '$') {
+    return nullptr;
+  }
+
+  const auto* node = &root;
+  size_t pos = 1;
+  while (pos < path.size()) {
+    if (path[pos] == '.') {
+      auto end = path.find_first_of(".[", pos + 1);
+      auto name = path.substr(pos + 1, end - pos - 1);
+      if (name.empty() || !node->IsObject()) {
+        return nullptr;
+      }
+      auto member = node->FindMember(name.c_str());
+      if (member == node->MemberEnd()) {
+        return nullptr;
+      }
+      node = &member->value;
+      pos = (end == std::string::npos) ? path.size() : end;
+    } else if (path[pos] == '[') {
+      auto end = path.find(']', pos + 1);
+      if (end == std::string::npos || !node->IsArray()) {
+        return nullptr;
+      }
+      size_t index = 0;
+      for (auto i = pos + 1; i < end; i++) {
+        if (path[i] < '0' || path[i] > '9') {
+          return nullptr;
+        }
+        index = index * 10 + (path[i] - '0');
+      }
+      if (index >= node->Size()) {
+        return nullptr;
+      }
+      node = &(*node)[index];
+      pos = end + 1;
+    } else {
+      return nullptr;
+    }
+  }
+  return node;
+}
+
+static void resultFromJSONValue(sqlite3_context* ctx,
+                                const rapidjson::Value& value) {
+  if (value.IsNull()) {
+    sqlite3_result_null(ctx);
+  } else if (value.IsBool()) {
+    sqlite3_result_int(ctx, value.GetBool() ? 1 : 0);
+  } else if (value.IsInt64() || value.IsUint64()) {
+    sqlite3_result_int64(ctx, value.GetInt64());
+  } else if (value.IsDouble()) {
+    sqlite3_result_double(ctx, value.GetDouble());
+  } else if (value.IsString()) {
+    sqlite3_result_text(ctx,
+                        value.GetString(),
+                        static_cast<int>(value.GetStringLength()),
+                        SQLITE_TRANSIENT);
+  } else {
+    // Objects and arrays are returned re-serialized.
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    value.Accept(writer);
+    sqlite3_result_text(ctx,
+                        buffer.GetString(),
+                        static_cast<int>(buffer.GetSize()),
+                        SQLITE_TRANSIENT);
+  }
+}
+
+static void sqliteJSONExtractFunc(sqlite3_context* ctx,
+                                  int argc,
+                                  sqlite3_value** argv) {
+  if (argc != 2 || SQLITE_NULL == sqlite3_value_type(argv[0]) ||
+      SQLITE_NULL == sqlite3_value_type(argv[1])) {
+    sqlite3_result_null(ctx);
+    return;
+  }
+
+  const auto* input =
+      reinterpret_cast<const char*>(sqlite3_value_text(argv[0]));
+  const auto* path = reinterpret_cast<const char*>(sqlite3_value_text(argv[1]));
+
+  const auto* doc = parseDocumentCached(input);
+  if (doc == nullptr) {
+    sqlite3_result_null(ctx);
+    return;
+  }
+
+  const auto* value = resolveJSONPath(*doc, path);
+  if (value == nullptr) {
+    sqlite3_result_null(ctx);
+    return;
+  }
+  resultFromJSONValue(ctx, *value);
+}
+
+static void sqliteJSONArrayLengthFunc(sqlite3_context* ctx,
+                                      int argc,
+                                      sqlite3_value** argv) {
+  if (argc == 0 || SQLITE_NULL == sqlite3_value_type(argv[0])) {
+    sqlite3_result_null(ctx);
+    return;
+  }
+
+  const auto* input =
+      reinterpret_cast<const char*>(sqlite3_value_text(argv[0]));
+  const auto* doc = parseDocumentCached(input);
+  if (doc == nullptr) {
+    sqlite3_result_null(ctx);
+    return;
+  }
+
+  const rapidjson::Value* value = doc;
+  if (argc > 1 && SQLITE_NULL != sqlite3_value_type(argv[1])) {
+    const auto* path =
+        reinterpret_cast<const char*>(sqlite3_value_text(argv[1]));
+    value = resolveJSONPath(*doc, path);
+  }
+
+  if (value == nullptr || !value->IsArray()) {
+    sqlite3_result_null(ctx);
+    return;
+  }
+  sqlite3_result_int64(ctx, static_cast<sqlite3_int64>(value->Size()));
+}
+
+static void sqliteJSONValidFunc(sqlite3_context* ctx,
+                                int argc,
+                                sqlite3_value** argv) {
+  if (argc == 0 || SQLITE_NULL == sqlite3_value_type(argv[0])) {
+    sqlite3_result_null(ctx);
+    return;
+  }
+
+  const auto* input =
+      reinterpret_cast<const char*>(sqlite3_value_text(argv[0]));
+  sqlite3_result_int(ctx, (parseDocumentCached(input) != nullptr) ? 1 : 0);
+}
+
+void registerJSONExtensions(sqlite3* db) {
+  sqlite3_create_function(db,
+                          "json_extract",
+                          2,
+                          SQLITE_UTF8 | SQLITE_DETERMINISTIC,
+                          nullptr,
+                          sqliteJSONExtractFunc,
+                          nullptr,
+                          nullptr);
+  sqlite3_create_function(db,
+                          "json_array_length",
+                          -1,
+                          SQLITE_UTF8 | SQLITE_DETERMINISTIC,
+                          nullptr,
+                          sqliteJSONArrayLengthFunc,
+                          nullptr,
+                          nullptr);
+  sqlite3_create_function(db,
+                          "json_valid",
+                          1,
+                          SQLITE_UTF8 | SQLITE_DETERMINISTIC,
+                          nullptr,
+                          sqliteJSONValidFunc,
+                          nullptr,
+                          nullptr);
+}
+} // namespace osquery
@@ -16,7 +16,7 @@
 #include <arpa/inet.h>
 #endif
 
-#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -30,8 +30,6 @@
 namespace osquery {
 
 using SplitResult = std::vector<std::string>;
-using StringSplitFunction = std::function<SplitResult(
-    const std::string& input, const std::string& tokens)>;
 
 /**
  * @brief A simple SQLite column string split implementation.
@@ -53,75 +51,119 @@ static SplitResult tokenSplit(const std::string& input,
   return osquery::split(input, tokens);
 }
 
-/**
- * @brief A regex SQLite column string split implementation.
- *
- * Split a column value using a single or multi-character token and select an
- * expected index. The token input is considered a regex.
- *
- * Example:
- *   1. SELECT ip_address from addresses;
- *      192.168.0.1
- *   2. SELECT SPLIT(ip_address, "\.", 1) from addresses;
- *      168
- *   3. SELECT SPLIT(ip_address, "\.0", 0) from addresses;
- *      192.168
- */
-static SplitResult regexSplit(const std::string& input,
-                              const std::string& token) {
-  // Split using the token as a regex to support multi-character tokens.
-  std::vector<std::string> result;
-  boost::algorithm::split_regex(result, input, boost::regex(token));
-  return result;
+/// Yield the selected split index, or null when out of bounds.
+static void yieldSplitIndex(sqlite3_context* context,
+                            const SplitResult& result,
+                            size_t index) {
+  if (index >= result.size()) {
+    // Could emit a warning about a selected index that is out of bounds.
+    sqlite3_result_null(context);
+    return;
+  }
+
+  // Yield the selected index.
+  const auto& selected = result[index];
+  sqlite3_result_text(context,
+                      selected.c_str(),
+                      static_cast<int>(selected.size()),
+                      SQLITE_TRANSIENT);
 }
 
-static void callStringSplitFunc(sqlite3_context* context,
+/// Verify no split argument is null; the functions then yield null.
+static bool validSplitArguments(sqlite3_context* context,
                                 int argc,
-                                sqlite3_value** argv,
-                                StringSplitFunction f) {
+                                sqlite3_value** argv) {
   assert(argc == 3);
   if (SQLITE_NULL == sqlite3_value_type(argv[0]) ||
       SQLITE_NULL == sqlite3_value_type(argv[1]) ||
       SQLITE_NULL == sqlite3_value_type(argv[2])) {
     sqlite3_result_null(context);
+    return false;
+  }
+  return true;
+}
+
+static void tokenStringSplitFunc(sqlite3_context* context,
+                                 int argc,
+                                 sqlite3_value** argv) {
+  if (!validSplitArguments(context, argc, argv)) {
     return;
   }
 
   // Parse and verify the split input parameters.
   std::string input((char*)sqlite3_value_text(argv[0]));
   std::string token((char*)sqlite3_value_text(argv[1]));
-  auto index = static_cast<size_t>(sqlite3_value_int(argv[2]));
   if (token.empty()) {
     // Allow the input string to be empty.
     sqlite3_result_error(context, "Invalid input to split function", -1);
     return;
   }
 
-  auto result = f(input, token);
-  if (index >= result.size()) {
-    // Could emit a warning about a selected index that is out of bounds.
-    sqlite3_result_null(context);
-    return;
-  }
-
-  // Yield the selected index.
-  const auto& selected = result[index];
-  sqlite3_result_text(context,
-                      selected.c_str(),
-                      static_cast<int>(selected.size()),
-                      SQLITE_TRANSIENT);
+  yieldSplitIndex(context,
+                  tokenSplit(input, token),
+                  static_cast<size_t>(sqlite3_value_int(argv[2])));
 }
 
-static void tokenStringSplitFunc(sqlite3_context* context,
-                                 int argc,
-                                 sqlite3_value** argv) {
-  callStringSplitFunc(context, argc, argv, tokenSplit);
+/// Auxiliary-data destructor for a cached compiled regex.
+static void releaseRegex(void* compiled) {
+  delete static_cast<boost::regex*>(compiled);
 }
 
+/**
+ * @brief A regex SQLite column string split implementation.
+ *
+ * Split a column value using a single or multi-character token and select an
+ * expected index. The token input is considered a regex.
+ *
+ * Example:
+ *   1. SELECT ip_address from addresses;
+ *      192.168.0.1
+ *   2. SELECT SPLIT(ip_address, "\.", 1) from addresses;
+ *      168
+ *   3. SELECT SPLIT(ip_address, "\.0", 0) from addresses;
+ *      192.168
+ */
 static void regexStringSplitFunc(sqlite3_context* context,
                                  int argc,
                                  sqlite3_value** argv) {
-  callStringSplitFunc(context, argc, argv, regexSplit);
+  if (!validSplitArguments(context, argc, argv)) {
+    return;
+  }
+
+  const auto* pattern = (char*)sqlite3_value_text(argv[1]);
+  if (pattern == nullptr || *pattern == '\0') {
+    sqlite3_result_error(context, "Invalid input to split function", -1);
+    return;
+  }
+
+  /*
+   * The compiled pattern is cached as auxiliary data bound to the pattern
+   * argument: SQLite retains it across row invocations while the pattern
+   * expression stays constant, so the regex compiles once per statement
+   * rather than once per row. The fresh object is only handed to SQLite
+   * after use since auxiliary data may be discarded at any time.
+   */
+  auto* compiled = static_cast<boost::regex*>(sqlite3_get_auxdata(context, 1));
+  std::unique_ptr<boost::regex> fresh;
+  if (compiled == nullptr) {
+    try {
+      fresh.reset(new boost::regex(pattern));
+    } catch (const boost::regex_error& /* e */) {
+      sqlite3_result_error(context, "Invalid regex input to split function", -1);
+      return;
+    }
+    compiled = fresh.get();
+  }
+
+  std::string input((char*)sqlite3_value_text(argv[0]));
+  SplitResult result;
+  boost::algorithm::split_regex(result, input, *compiled);
+  yieldSplitIndex(
+      context, result, static_cast<size_t>(sqlite3_value_int(argv[2])));
+
+  if (fresh != nullptr) {
+    sqlite3_set_auxdata(context, 1, fresh.release(), releaseRegex);
+  }
 }
 
 /**
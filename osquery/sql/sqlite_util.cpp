@@ -8,6 +8,11 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <thread>
+
 #include <osquery/core.h>
 #include <osquery/flags.h>
 #include <osquery/logger.h>
@@ -26,6 +31,16 @@ FLAG(string,
 
 FLAG(string, nullvalue, "", "Set string for NULL values, default ''");
 
+FLAG(bool,
+     table_prefetch,
+     true,
+     "Generate independent joined tables in parallel before execution");
+
+FLAG(uint64,
+     query_max_bytes,
+     0,
+     "Bytes of table results a single query may materialize (0 disables)");
+
 using OpReg = QueryPlanner::Opcode::Register;
 
 using SQLiteDBInstanceRef = std::shared_ptr<SQLiteDBInstance>;
@@ -53,8 +68,19 @@ const std::map<int, std::string> kSQLiteReturnCodes = {
 const std::map<std::string, std::string> kMemoryDBSettings = {
     {"synchronous", "OFF"},      {"count_changes", "OFF"},
     {"default_temp_store", "0"}, {"auto_vacuum", "FULL"},
-    {"journal_mode", "OFF"},     {"cache_size", "0"},
-    {"page_count", "0"},
+    {"journal_mode", "OFF"},     {"page_count", "0"},
+};
+
+// Long-lived connections (shell, scheduler primary) repeat queries, so they
+// keep a small page cache; sorts and temp structures stay in memory.
+const std::map<std::string, std::string> kPersistentConnectionSettings = {
+    {"cache_size", "-2000"}, {"temp_store", "2"},
+};
+
+// Transient connections (distributed, pooled) materialize results once,
+// so they skip the page cache entirely.
+const std::map<std::string, std::string> kTransientConnectionSettings = {
+    {"cache_size", "0"}, {"temp_store", "2"},
 };
 // clang-format on
 
@@ -169,9 +195,89 @@ Status SQLiteSQLPlugin::getQueryTables(const std::string& query,
   return Status(0);
 }
 
+/**
+ * @brief Generate the full-scanned tables of a join in parallel.
+ *
+ * A query joining several virtual tables generates each table serially
+ * under the single query thread while SQLite walks the join. The planner
+ * names the base tables that will be fully scanned, so when more than one
+ * eagerly-generating table is involved those are generated concurrently
+ * here, and the row sets are handed to the scan through the instance. The
+ * wall time of a multi-table query then approaches that of its most
+ * expensive table rather than the sum of all of them.
+ */
+static void prefetchQueryTables(const std::string& q,
+                                const SQLiteDBInstanceRef& instance) {
+  QueryPlanner planner(q, instance);
+
+  std::vector<std::string> names;
+  std::vector<std::shared_ptr<TablePlugin>> tables;
+  for (const auto& name : planner.tables()) {
+    if (std::find(names.begin(), names.end(), name) != names.end() ||
+        !Registry::get().exists("table", name, true)) {
+      continue;
+    }
+
+    auto plugin = Registry::get().plugin("table", name);
+    auto table = std::dynamic_pointer_cast<TablePlugin>(plugin);
+    if (table == nullptr || table->usesGenerator()) {
+      // Generator tables yield lazily into a coroutine bound to the scan.
+      continue;
+    }
+
+    // A table with a required column cannot generate without constraints.
+    bool required = false;
+    for (const auto& column : table->columns()) {
+      if (std::get<2>(column) & ColumnOptions::REQUIRED) {
+        required = true;
+        break;
+      }
+    }
+    if (required) {
+      continue;
+    }
+
+    names.push_back(name);
+    tables.push_back(table);
+  }
+
+  if (names.size() < 2) {
+    // A single table generates under the query thread as usual.
+    return;
+  }
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < names.size(); i++) {
+    threads.push_back(std::thread([i, &names, &tables, &instance]() {
+      QueryContext context;
+      auto wall_start = std::chrono::steady_clock::now();
+      auto cpu_start = std::clock();
+      auto rows = tables[i]->generate(context);
+      auto wall_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::steady_clock::now() - wall_start)
+                           .count();
+      auto cpu_time = (std::clock() - cpu_start) * 1000000 /
+                      static_cast<long>(CLOCKS_PER_SEC);
+      recordTableGenerateStats(names[i],
+                               static_cast<uint64_t>(wall_time),
+                               static_cast<uint64_t>(std::max(cpu_time, 0L)),
+                               rows.size(),
+                               queryDataBytes(rows));
+      instance->setPrefetchedResults(names[i], std::move(rows));
+    }));
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
 SQLInternal::SQLInternal(const std::string& query, bool use_cache) {
   auto dbc = SQLiteDBManager::get();
   dbc->useCache(use_cache);
+  if (FLAGS_table_prefetch) {
+    prefetchQueryTables(query, dbc);
+  }
   status_ = queryInternal(query, results_, dbc);
 
   // One of the advantages of using SQLInternal (aside from the Registry-bypass)
@@ -214,19 +320,24 @@ SQLiteDBInstance::SQLiteDBInstance(sqlite3*& db, Mutex& mtx)
   if (lock_.owns_lock()) {
     primary_ = true;
   } else {
+    // Contention on the primary database, the manager will substitute a
+    // pooled transient connection for this unusable instance.
     db_ = nullptr;
-    VLOG(1) << "DBManager contention: opening transient SQLite database";
-    init();
   }
 }
 
-static inline void openOptimized(sqlite3*& db) {
+static inline void openOptimized(sqlite3*& db, bool transient = true) {
   sqlite3_open(":memory:", &db);
 
   std::string settings;
   for (const auto& setting : kMemoryDBSettings) {
     settings += "PRAGMA " + setting.first + "=" + setting.second + "; ";
   }
+  const auto& profile =
+      transient ? kTransientConnectionSettings : kPersistentConnectionSettings;
+  for (const auto& setting : profile) {
+    settings += "PRAGMA " + setting.first + "=" + setting.second + "; ";
+  }
   sqlite3_exec(db, settings.c_str(), nullptr, nullptr, nullptr);
 
   // Register function extensions.
@@ -240,6 +351,7 @@ static inline void openOptimized(sqlite3*& db) {
   registerFilesystemExtensions(db);
   registerHashingExtensions(db);
   registerEncodingExtensions(db);
+  registerJSONExtensions(db);
 }
 
 void SQLiteDBInstance::init() {
@@ -255,6 +367,74 @@ bool SQLiteDBInstance::useCache() const {
   return use_cache_;
 }
 
+/// Bound the number of cached statements; ad-hoc (shell) queries never repeat.
+const size_t kStatementCacheLimit{512};
+
+sqlite3_stmt* SQLiteDBInstance::getCachedStatement(const std::string& query,
+                                                   bool& multi_statement) {
+  if (isPrimary() && !managed_) {
+    // Cache on the manager's long-lived connection so compiled statements
+    // outlive this temporary primary instance.
+    return SQLiteDBManager::getConnection(true)->getCachedStatement(
+        query, multi_statement);
+  }
+
+  multi_statement = false;
+  auto cached = statement_cache_.find(query);
+  if (cached != statement_cache_.end()) {
+    return cached->second;
+  }
+
+  const char* tail = nullptr;
+  sqlite3_stmt* stmt = nullptr;
+  auto rc = sqlite3_prepare_v2(db_,
+                               query.c_str(),
+                               static_cast<int>(query.length() + 1),
+                               &stmt,
+                               &tail);
+  if (rc != SQLITE_OK || stmt == nullptr) {
+    if (stmt != nullptr) {
+      sqlite3_finalize(stmt);
+    }
+    return nullptr;
+  }
+
+  // A single handle cannot represent multiple statements.
+  while (tail != nullptr && (*tail == ' ' || *tail == '\n' || *tail == '\t' ||
+                             *tail == '\r' || *tail == ';')) {
+    tail++;
+  }
+  if (tail != nullptr && *tail != '\0') {
+    multi_statement = true;
+    sqlite3_finalize(stmt);
+    return nullptr;
+  }
+
+  if (statement_cache_.size() >= kStatementCacheLimit) {
+    // Nested SQL issued from table code can hit this limit while an outer
+    // cached statement is mid-step; finalizing a busy handle would leave
+    // the outer execution resuming a freed statement. Evict idle entries
+    // only, busy ones age out on a later pass.
+    for (auto it = statement_cache_.begin(); it != statement_cache_.end();) {
+      if (sqlite3_stmt_busy(it->second) == 0) {
+        sqlite3_finalize(it->second);
+        it = statement_cache_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  statement_cache_[query] = stmt;
+  return stmt;
+}
+
+void SQLiteDBInstance::clearStatementCache() {
+  for (auto& cached : statement_cache_) {
+    sqlite3_finalize(cached.second);
+  }
+  statement_cache_.clear();
+}
+
 RecursiveLock SQLiteDBInstance::attachLock() const {
   if (isPrimary()) {
     return RecursiveLock(kPrimaryAttachMutex);
@@ -271,6 +451,15 @@ bool SQLiteDBInstance::tableCalled(VirtualTableContent* table) {
   return (affected_tables_.count(table->name) > 0);
 }
 
+bool SQLiteDBInstance::claimTableBytes(size_t bytes) {
+  if (FLAGS_query_max_bytes == 0) {
+    return true;
+  }
+
+  auto total = query_bytes_.fetch_add(bytes) + bytes;
+  return (total <= FLAGS_query_max_bytes);
+}
+
 TableAttributes SQLiteDBInstance::getAttributes() const {
   const SQLiteDBInstance* rdbc = this;
   if (isPrimary() && !managed_) {
@@ -297,14 +486,56 @@ void SQLiteDBInstance::clearAffectedTables() {
     table.second->constraints.clear();
     table.second->cache.clear();
     table.second->colsUsed.clear();
+    table.second->orderTerms.clear();
   }
   // Since the affected tables are cleared, there are no more affected tables.
   // There is no concept of compounding tables between queries.
   affected_tables_.clear();
   use_cache_ = false;
+  query_bytes_ = 0;
+
+  {
+    // Drop any prefetched rows not consumed by the execution.
+    WriteLock lock(prefetch_mutex_);
+    prefetched_results_.clear();
+  }
+}
+
+void SQLiteDBInstance::setPrefetchedResults(const std::string& table,
+                                            QueryData results) {
+  if (isPrimary() && !managed_) {
+    // As with clearAffectedTables, attached virtual tables reference the
+    // manager's 'connection' instance, so prefetched rows must live there.
+    SQLiteDBManager::getConnection(true)->setPrefetchedResults(
+        table, std::move(results));
+    return;
+  }
+
+  WriteLock lock(prefetch_mutex_);
+  prefetched_results_[table] = std::move(results);
+}
+
+bool SQLiteDBInstance::getPrefetchedResults(const std::string& table,
+                                            QueryData& results) {
+  if (isPrimary() && !managed_) {
+    return SQLiteDBManager::getConnection(true)->getPrefetchedResults(table,
+                                                                      results);
+  }
+
+  WriteLock lock(prefetch_mutex_);
+  auto entry = prefetched_results_.find(table);
+  if (entry == prefetched_results_.end()) {
+    return false;
+  }
+
+  results = std::move(entry->second);
+  prefetched_results_.erase(entry);
+  return true;
 }
 
 SQLiteDBInstance::~SQLiteDBInstance() {
+  // Compiled statements must be finalized before the database may close.
+  clearStatementCache();
   if (!isPrimary() && db_ != nullptr) {
     sqlite3_close(db_);
   } else {
@@ -328,6 +559,13 @@ void SQLiteDBManager::resetPrimary() {
   WriteLock connection_lock(self.mutex_);
   self.connection_.reset();
 
+  {
+    // Drop the idle transient connections along with the primary so their
+    // arenas are reclaimed too; checked-out connections are unaffected.
+    WriteLock pool_lock(self.pool_mutex_);
+    self.pool_.clear();
+  }
+
   {
     WriteLock create_lock(self.create_mutex_);
     sqlite3_close(self.db_);
@@ -347,13 +585,47 @@ SQLiteDBInstanceRef SQLiteDBManager::getUnique() {
   return instance;
 }
 
+/// Maximum number of idle transient connections retained for reuse.
+const size_t kSQLitePoolLimit{4};
+
+SQLiteDBInstanceRef SQLiteDBManager::getPooledConnection() {
+  auto& self = instance();
+
+  SQLiteDBInstanceRef db;
+  {
+    WriteLock lock(self.pool_mutex_);
+    if (!self.pool_.empty()) {
+      db = std::move(self.pool_.back());
+      self.pool_.pop_back();
+    }
+  }
+
+  if (db == nullptr) {
+    db = std::make_shared<SQLiteDBInstance>();
+    attachVirtualTables(db);
+  }
+
+  // Hand out an aliased reference: when the caller releases the connection
+  // it returns to the pool with its attached tables and warm statement cache,
+  // instead of being torn down.
+  return SQLiteDBInstanceRef(db.get(), [db](SQLiteDBInstance*) mutable {
+    db->clearAffectedTables();
+
+    auto& manager = SQLiteDBManager::instance();
+    WriteLock lock(manager.pool_mutex_);
+    if (manager.pool_.size() < kSQLitePoolLimit) {
+      manager.pool_.push_back(std::move(db));
+    }
+  });
+}
+
 SQLiteDBInstanceRef SQLiteDBManager::getConnection(bool primary) {
   auto& self = instance();
   WriteLock lock(self.create_mutex_);
 
   if (self.db_ == nullptr) {
     // Create primary SQLite DB instance.
-    openOptimized(self.db_);
+    openOptimized(self.db_, false);
     self.connection_ = SQLiteDBInstanceRef(new SQLiteDBInstance(self.db_));
     attachVirtualTables(self.connection_);
   }
@@ -365,10 +637,15 @@ SQLiteDBInstanceRef SQLiteDBManager::getConnection(bool primary) {
 
   // Create a 'database connection' for the managed database instance.
   auto instance = std::make_shared<SQLiteDBInstance>(self.db_, self.mutex_);
-  if (!instance->isPrimary()) {
-    attachVirtualTables(instance);
+  if (instance->isPrimary()) {
+    return instance;
   }
-  return instance;
+
+  // The primary is in use elsewhere. Concurrent queries (scheduler workers,
+  // the distributed runner, extensions) execute on pooled transient
+  // connections rather than convoying on the primary lock.
+  VLOG(1) << "DBManager contention: using pooled SQLite database";
+  return getPooledConnection();
 }
 
 SQLiteDBManager::~SQLiteDBManager() {
@@ -479,16 +756,60 @@ int queryDataCallback(void* argument, int argc, char* argv[], char* column[]) {
 Status queryInternal(const std::string& q,
                      QueryData& results,
                      const SQLiteDBInstanceRef& instance) {
-  char* err = nullptr;
   auto lock = instance->attachLock();
-  sqlite3_exec(instance->db(), q.c_str(), queryDataCallback, &results, &err);
+
+  bool multi_statement = false;
+  auto* stmt = instance->getCachedStatement(q, multi_statement);
+  if (stmt == nullptr && multi_statement) {
+    // Multi-statement text cannot be cached, use one-shot execution.
+    char* err = nullptr;
+    sqlite3_exec(instance->db(), q.c_str(), queryDataCallback, &results, &err);
+    sqlite3_db_release_memory(instance->db());
+    if (err != nullptr) {
+      auto error_string = std::string(err);
+      sqlite3_free(err);
+      return Status(1, "Error running query: " + error_string);
+    }
+    return Status::success();
+  }
+
+  if (stmt == nullptr) {
+    return Status(
+        1,
+        "Error running query: " + std::string(sqlite3_errmsg(instance->db())));
+  }
+
+  auto num_columns = sqlite3_column_count(stmt);
+  int rc = SQLITE_ROW;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    Row r;
+    for (int i = 0; i < num_columns; i++) {
+      auto column_name = sqlite3_column_name(stmt, i);
+      if (column_name == nullptr) {
+        continue;
+      }
+      if (r.count(column_name)) {
+        // Found a column name collision in the result.
+        VLOG(1) << "Detected overloaded column name " << column_name
+                << " in query result consider using aliases";
+      }
+      auto value = sqlite3_column_text(stmt, i);
+      r[column_name] = (value != nullptr)
+                           ? reinterpret_cast<const char*>(value)
+                           : FLAGS_nullvalue;
+    }
+    results.push_back(std::move(r));
+  }
+
+  // Reset instead of finalize, the compiled statement will be reused.
+  sqlite3_reset(stmt);
   sqlite3_db_release_memory(instance->db());
-  if (err != nullptr) {
-    auto error_string = std::string(err);
-    sqlite3_free(err);
-    return Status(1, "Error running query: " + error_string);
+  if (rc != SQLITE_DONE) {
+    return Status(
+        1,
+        "Error running query: " + std::string(sqlite3_errmsg(instance->db())));
   }
-  return Status(0, "OK");
+  return Status::success();
 }
 
 Status getQueryColumnsInternal(const std::string& q,
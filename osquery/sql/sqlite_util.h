@@ -14,6 +14,7 @@
 #include <map>
 #include <mutex>
 #include <unordered_set>
+#include <vector>
 
 #include <sqlite3.h>
 
@@ -37,7 +38,8 @@ class SQLiteDBManager;
  *
  * If there is resource contention (multiple threads want access to the SQLite
  * abstraction layer), then the SQLiteDBManager will provide a transient
- * SQLiteDBInstance.
+ * SQLiteDBInstance, checked out of a pool of attached connections so the
+ * scheduler, distributed runner, and extension queries run concurrently.
  */
 class SQLiteDBInstance : private boost::noncopyable {
  public:
@@ -72,15 +74,49 @@ class SQLiteDBInstance : private boost::noncopyable {
   /// Check if a virtual table had been called already.
   bool tableCalled(VirtualTableContent* table);
 
+  /**
+   * @brief Account bytes materialized by table scans of the current query.
+   *
+   * The running total is compared against --query_max_bytes and is reset
+   * with the rest of the per-query state in clearAffectedTables. Returns
+   * false once the limit is exceeded; the scan should then fail the query.
+   */
+  bool claimTableBytes(size_t bytes);
+
   /// Request that virtual tables use a warm cache for their results.
   void useCache(bool use_cache);
 
   /// Check if the query requested use of the warm query cache.
   bool useCache() const;
 
+  /**
+   * @brief Get, or prepare and cache, the compiled statement for a query.
+   *
+   * Scheduled queries repeat forever, so the compiled sqlite3_stmt is kept
+   * keyed by the query text and reused across executions, skipping the
+   * parse/plan work on every tick. Statements are prepared with
+   * sqlite3_prepare_v2 and therefore re-prepare themselves transparently
+   * when the schema changes. Callers must hold the attachLock.
+   *
+   * A nullptr is returned if the query cannot be compiled. If the text
+   * contains more than one statement it cannot be represented by a single
+   * handle: nullptr is returned and multi_statement is set.
+   */
+  sqlite3_stmt* getCachedStatement(const std::string& query,
+                                   bool& multi_statement);
+
+  /// Finalize and drop every cached prepared statement.
+  void clearStatementCache();
+
   /// Lock the database for attaching virtual tables.
   RecursiveLock attachLock() const;
 
+  /// Stash rows generated ahead of execution for a table's full scan.
+  void setPrefetchedResults(const std::string& table, QueryData results);
+
+  /// Consume prefetched rows for a table, returns true on a prefetch hit.
+  bool getPrefetchedResults(const std::string& table, QueryData& results);
+
  private:
   /// Handle the primary/forwarding requests for table attribute accesses.
   TableAttributes getAttributes() const;
@@ -126,6 +162,18 @@ class SQLiteDBInstance : private boost::noncopyable {
   /// Vector of tables that need their constraints cleared after execution.
   std::map<std::string, VirtualTableContent*> affected_tables_;
 
+  /// Compiled statements for repeated queries, keyed by the query text.
+  std::map<std::string, sqlite3_stmt*> statement_cache_;
+
+  /// Table rows generated ahead of execution, consumed by the first scan.
+  std::map<std::string, QueryData> prefetched_results_;
+
+  /// Protects the prefetched results from concurrent generator threads.
+  Mutex prefetch_mutex_;
+
+  /// Bytes of table results materialized by the current query.
+  std::atomic<size_t> query_bytes_{0};
+
  private:
   friend class SQLiteDBManager;
   friend class SQLInternal;
@@ -224,6 +272,22 @@ class SQLiteDBManager : private boost::noncopyable {
   /// Request a connection, optionally request the primary connection.
   static SQLiteDBInstanceRef getConnection(bool primary = false);
 
+  /**
+   * @brief Check out a transient connection when the primary is contended.
+   *
+   * Pooled connections keep their attached virtual tables and compiled
+   * statement caches between checkouts, so a contended query does not pay a
+   * full database open and table attach. Releasing the returned reference
+   * returns the connection to the pool.
+   */
+  static SQLiteDBInstanceRef getPooledConnection();
+
+  /// Idle transient connections, attached and ready for reuse.
+  std::vector<SQLiteDBInstanceRef> pool_;
+
+  /// Protects the transient connection pool.
+  Mutex pool_mutex_;
+
  private:
   friend class SQLiteDBInstance;
   friend class SQLiteSQLPlugin;
@@ -411,6 +475,11 @@ void registerEncodingExtensions(sqlite3* db);
  */
 void registerFilesystemExtensions(sqlite3* db);
 
+/**
+ * @brief Register JSON path extraction 'custom' functions.
+ */
+void registerJSONExtensions(sqlite3* db);
+
 /**
  * @brief Generate the data for auto-constructed sqlite tables
  *
@@ -133,6 +133,36 @@ TEST_F(SQLTests, test_sql_base64_conditional_encode) {
   EXPECT_EQ(d2[0]["test"], "5oKq5Zug5oKq5p6c");
 }
 
+TEST_F(SQLTests, test_sql_json_extract) {
+  QueryData d;
+  query("select json_extract('{\"a\": {\"b\": [1, \"two\"]}}', '$.a.b[1]') "
+        "as test;",
+        d);
+  EXPECT_EQ(d.size(), 1U);
+  EXPECT_EQ(d[0]["test"], "two");
+
+  QueryData d2;
+  query("select json_extract('{\"a\": 2}', '$.missing') as test;", d2);
+  EXPECT_EQ(d2.size(), 1U);
+  EXPECT_EQ(d2[0]["test"], "");
+}
+
+TEST_F(SQLTests, test_sql_json_array_length) {
+  QueryData d;
+  query("select json_array_length('[1, 2, 3]') as test;", d);
+  EXPECT_EQ(d.size(), 1U);
+  EXPECT_EQ(d[0]["test"], "3");
+}
+
+TEST_F(SQLTests, test_sql_json_valid) {
+  QueryData d;
+  query("select json_valid('{\"a\": 1}') as yes, json_valid('nope') as no;",
+        d);
+  EXPECT_EQ(d.size(), 1U);
+  EXPECT_EQ(d[0]["yes"], "1");
+  EXPECT_EQ(d[0]["no"], "0");
+}
+
 TEST_F(SQLTests, test_sql_md5) {
   QueryData d;
   query("select md5('test') as test;", d);
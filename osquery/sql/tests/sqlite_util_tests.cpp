@@ -20,6 +20,8 @@
 
 namespace osquery {
 
+DECLARE_uint64(query_max_bytes);
+
 class SQLiteUtilTests : public testing::Test {};
 
 std::shared_ptr<SQLiteDBInstance> getTestDBC() {
@@ -64,6 +66,38 @@ TEST_F(SQLiteUtilTests, test_sqlite_instance) {
   EXPECT_EQ(internal_db, SQLiteDBManager::get()->db());
 }
 
+TEST_F(SQLiteUtilTests, test_transient_connection_pool) {
+  // Hold the primary connection so the next request is contended.
+  auto primary = SQLiteDBManager::get();
+  auto transient = SQLiteDBManager::get();
+  EXPECT_NE(primary->db(), transient->db());
+
+  // Releasing a transient connection returns it to the pool; the next
+  // contended request reuses the same underlying database.
+  auto* db = transient->db();
+  transient = nullptr;
+  auto reused = SQLiteDBManager::get();
+  EXPECT_EQ(reused->db(), db);
+}
+
+TEST_F(SQLiteUtilTests, test_prefetched_results) {
+  auto dbc = SQLiteDBManager::getUnique();
+  QueryData rows = {Row{{"i", "1"}}};
+  dbc->setPrefetchedResults("prefetch_test", rows);
+
+  QueryData consumed;
+  EXPECT_TRUE(dbc->getPrefetchedResults("prefetch_test", consumed));
+  EXPECT_EQ(consumed, rows);
+
+  // Prefetched rows are consumed by the first scan only.
+  EXPECT_FALSE(dbc->getPrefetchedResults("prefetch_test", consumed));
+
+  // Unconsumed prefetches are dropped with the rest of the per-query state.
+  dbc->setPrefetchedResults("prefetch_test", rows);
+  dbc->clearAffectedTables();
+  EXPECT_FALSE(dbc->getPrefetchedResults("prefetch_test", consumed));
+}
+
 TEST_F(SQLiteUtilTests, test_reset) {
   auto internal_db = SQLiteDBManager::get()->db();
   ASSERT_NE(nullptr, internal_db);
@@ -139,6 +173,24 @@ TEST_F(SQLiteUtilTests, test_affected_tables) {
   EXPECT_EQ(dbc->affected_tables_.size(), 0U);
 }
 
+TEST_F(SQLiteUtilTests, test_query_byte_accounting) {
+  auto dbc = getTestDBC();
+
+  // Accounting is disabled by default, any size may be claimed.
+  EXPECT_TRUE(dbc->claimTableBytes(1ULL << 40));
+
+  FLAGS_query_max_bytes = 100;
+  EXPECT_TRUE(dbc->claimTableBytes(60));
+  EXPECT_TRUE(dbc->claimTableBytes(40));
+  // The next claim exceeds the limit.
+  EXPECT_FALSE(dbc->claimTableBytes(1));
+
+  // The running total resets with the per-query state.
+  dbc->clearAffectedTables();
+  EXPECT_TRUE(dbc->claimTableBytes(100));
+  FLAGS_query_max_bytes = 0;
+}
+
 TEST_F(SQLiteUtilTests, test_table_attributes_event_based) {
   {
     SQLInternal sql_internal("select * from process_events");
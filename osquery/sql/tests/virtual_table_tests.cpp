@@ -35,6 +35,8 @@ class sampleTablePlugin : public TablePlugin {
 TEST_F(VirtualTableTests, test_tableplugin_columndefinition) {
   auto table = std::make_shared<sampleTablePlugin>();
   EXPECT_EQ("(`foo` INTEGER, `bar` TEXT)", table->columnDefinition());
+  // The definition is memoized, repeated requests return the same content.
+  EXPECT_EQ("(`foo` INTEGER, `bar` TEXT)", table->columnDefinition());
 }
 
 class optionsTablePlugin : public TablePlugin {
@@ -464,7 +466,7 @@ class tableCacheTablePlugin : public TablePlugin {
 
   QueryData generate(QueryContext& ctx) override {
     if (isCached(60, ctx)) {
-      return getCache();
+      return getCache(ctx);
     }
 
     generates_++;
@@ -575,6 +577,58 @@ TEST_F(VirtualTableTests, test_yield_generator) {
   EXPECT_EQ(results[0]["index"], "10");
 }
 
+class orderHintTablePlugin : public TablePlugin {
+ private:
+  TableColumns columns() const override {
+    return {
+        std::make_tuple("i", INTEGER_TYPE, ColumnOptions::DEFAULT),
+    };
+  }
+
+ public:
+  QueryData generate(QueryContext& context) override {
+    order_terms_ = context.orderTerms;
+
+    QueryData results;
+    // Emit rows out of order to prove SQLite still applies the sort.
+    for (const auto& value : {"2", "0", "1"}) {
+      Row r;
+      r["i"] = value;
+      results.push_back(r);
+    }
+    return results;
+  }
+
+  OrderTerms order_terms_;
+};
+
+TEST_F(VirtualTableTests, test_order_hints) {
+  auto table = std::make_shared<orderHintTablePlugin>();
+  auto table_registry = RegistryFactory::get().registry("table");
+  table_registry->add("order_hints", table);
+
+  auto dbc = SQLiteDBManager::getUnique();
+  attachTableInternal("order_hints", table->columnDefinition(), dbc);
+
+  // Without an ORDER BY no hints are passed.
+  QueryData results;
+  queryInternal("SELECT * FROM order_hints", results, dbc);
+  dbc->clearAffectedTables();
+  EXPECT_EQ(table->order_terms_.size(), 0U);
+
+  // The requested ordering is surfaced as an advisory hint, and SQLite
+  // still sorts the (unsorted) generated rows itself.
+  results.clear();
+  queryInternal("SELECT * FROM order_hints ORDER BY i DESC", results, dbc);
+  dbc->clearAffectedTables();
+  ASSERT_EQ(table->order_terms_.size(), 1U);
+  EXPECT_EQ(table->order_terms_[0].first, "i");
+  EXPECT_TRUE(table->order_terms_[0].second);
+  ASSERT_EQ(results.size(), 3U);
+  EXPECT_EQ(results[0]["i"], "2");
+  EXPECT_EQ(results[2]["i"], "0");
+}
+
 class likeTablePlugin : public TablePlugin {
  private:
   TableColumns columns() const override {
@@ -8,17 +8,41 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <cstring>
+
+#include <boost/filesystem/operations.hpp>
+
 #include <osquery/core.h>
 #include <osquery/filesystem.h>
+#include <osquery/flags.h>
 #include <osquery/logger.h>
 #include <osquery/sql.h>
 
+#include "osquery/core/hashing.h"
+#include "osquery/filesystem/fileops.h"
 #include "osquery/sql/sqlite_util.h"
 
 namespace fs = boost::filesystem;
 
 namespace osquery {
 
+FLAG(bool,
+     atc_source_cache,
+     true,
+     "Cache read-only connections, prepared statements, and results for "
+     "auto-constructed table source databases until the source file changes");
+
+FLAG(bool,
+     atc_shadow_copy,
+     false,
+     "Query a cached shadow copy when a locked auto-constructed table "
+     "source database cannot be read in place, refreshing only changed "
+     "pages of the copy (duplicates the source database into a "
+     "daemon-private directory)");
+
+/// Bytes of each cached ATC source mapped with PRAGMA mmap_size.
+#define ATC_SOURCE_MMAP_SIZE "268435456"
+
 const char* getSystemVFS(bool respect_locking) {
   if (respect_locking) {
     return nullptr;
@@ -31,6 +55,27 @@ const char* getSystemVFS(bool respect_locking) {
   return nullptr;
 }
 
+/// Open a source database read-only with the shared ATC open flags.
+static Status openSqliteSource(const fs::path& sqlite_db,
+                               bool respect_locking,
+                               sqlite3** db) {
+  auto rc = sqlite3_open_v2(
+      sqlite_db.string().c_str(),
+      db,
+      (SQLITE_OPEN_READONLY | SQLITE_OPEN_PRIVATECACHE | SQLITE_OPEN_NOMUTEX),
+      getSystemVFS(respect_locking));
+  if (rc != SQLITE_OK || *db == nullptr) {
+    VLOG(1) << "Cannot open specified database: "
+            << getStringForSQLiteReturnCode(rc);
+    if (*db != nullptr) {
+      sqlite3_close(*db);
+      *db = nullptr;
+    }
+    return Status(1, "Could not open database");
+  }
+  return Status();
+}
+
 Status genSqliteQueryRow(sqlite3_stmt* stmt,
                          QueryData& qd,
                          const fs::path& sqlite_db) {
@@ -63,35 +108,294 @@ Status genSqliteQueryRow(sqlite3_stmt* stmt,
   } else {
     r["path"] = sqlite_db.string();
   }
-  qd.push_back(r);
+  qd.push_back(std::move(r));
   return Status();
 }
 
-Status genQueryDataForSqliteTable(const fs::path& sqlite_db,
-                                  const std::string& sqlite_query,
-                                  QueryData& results,
-                                  bool respect_locking) {
-  sqlite3* db = nullptr;
-  if (!pathExists(sqlite_db).ok()) {
-    return Status(1, "Database path does not exist");
+namespace {
+
+/// Cached read-only connection and results for one ATC source database.
+struct SqliteSourceEntry {
+  /// Long-lived read-only handle into the source file.
+  sqlite3* db{nullptr};
+
+  /// Prepared statements for this source, keyed by query text.
+  std::map<std::string, sqlite3_stmt*> statements;
+
+  /// Source file identity when the connection was opened.
+  std::time_t mtime{0};
+  uintmax_t size{0};
+
+  /// Results keyed by query text, valid while the file identity holds.
+  std::map<std::string, QueryData> results;
+};
+
+/**
+ * @brief A cache of read-only ATC source database connections.
+ *
+ * Auto-constructed tables query user databases (browser history, TCC)
+ * that change rarely relative to the query schedule. The cache keeps one
+ * read-only mmap'd connection and the prepared statement per source, and
+ * reuses the previous results while the source file's mtime and size are
+ * unchanged. Any change to the file identity closes and reopens the
+ * connection, so a page cache can never outlive the file it mapped.
+ */
+class SqliteSourceCache : private boost::noncopyable {
+ public:
+  static SqliteSourceCache& instance() {
+    static SqliteSourceCache cache;
+    return cache;
   }
 
-  auto rc = sqlite3_open_v2(
-      sqlite_db.string().c_str(),
-      &db,
-      (SQLITE_OPEN_READONLY | SQLITE_OPEN_PRIVATECACHE | SQLITE_OPEN_NOMUTEX),
-      getSystemVFS(respect_locking));
-  if (rc != SQLITE_OK || db == nullptr) {
-    VLOG(1) << "Cannot open specified database: "
-            << getStringForSQLiteReturnCode(rc);
-    if (db != nullptr) {
-      sqlite3_close(db);
+  /// Run (or recall) a query against a cached source connection.
+  Status query(const fs::path& sqlite_db,
+               const std::string& sqlite_query,
+               QueryData& results,
+               bool respect_locking);
+
+ private:
+  SqliteSourceCache() = default;
+
+  /// Finalize statements and close the connection for one source.
+  void closeEntry(SqliteSourceEntry& entry);
+
+ private:
+  /// Cached source entries, keyed by source path.
+  std::map<std::string, SqliteSourceEntry> sources_;
+
+  /// Serialize access to the cached connections.
+  Mutex mutex_;
+};
+
+void SqliteSourceCache::closeEntry(SqliteSourceEntry& entry) {
+  for (auto& stmt : entry.statements) {
+    sqlite3_finalize(stmt.second);
+  }
+  entry.statements.clear();
+  entry.results.clear();
+  if (entry.db != nullptr) {
+    sqlite3_close(entry.db);
+    entry.db = nullptr;
+  }
+}
+
+Status SqliteSourceCache::query(const fs::path& sqlite_db,
+                                const std::string& sqlite_query,
+                                QueryData& results,
+                                bool respect_locking) {
+  boost::system::error_code ec;
+  auto mtime = fs::last_write_time(sqlite_db, ec);
+  auto size = fs::file_size(sqlite_db, ec);
+
+  WriteLock lock(mutex_);
+  auto& entry = sources_[sqlite_db.string()];
+  if (entry.db != nullptr && (entry.mtime != mtime || entry.size != size)) {
+    // The source file changed: drop the connection so no mapped or cached
+    // page can survive the file it was read from.
+    closeEntry(entry);
+  }
+
+  if (entry.db == nullptr) {
+    auto status = openSqliteSource(sqlite_db, respect_locking, &entry.db);
+    if (!status.ok()) {
+      sources_.erase(sqlite_db.string());
+      return status;
     }
-    return Status(1, "Could not open database");
+    entry.mtime = mtime;
+    entry.size = size;
+
+    // Read the source through a memory map instead of read() calls.
+    sqlite3_exec(entry.db,
+                 "PRAGMA mmap_size=" ATC_SOURCE_MMAP_SIZE ";",
+                 nullptr,
+                 nullptr,
+                 nullptr);
+  }
+
+  auto cached = entry.results.find(sqlite_query);
+  if (cached != entry.results.end()) {
+    results.insert(
+        results.end(), cached->second.begin(), cached->second.end());
+    return Status();
+  }
+
+  sqlite3_stmt* stmt = nullptr;
+  auto stmt_it = entry.statements.find(sqlite_query);
+  if (stmt_it != entry.statements.end()) {
+    stmt = stmt_it->second;
+    sqlite3_reset(stmt);
+  } else {
+    auto rc =
+        sqlite3_prepare_v2(entry.db, sqlite_query.c_str(), -1, &stmt, nullptr);
+    if (rc != SQLITE_OK) {
+      VLOG(1) << "Could not prepare database at path: " << sqlite_db;
+      return Status(rc, "Could not prepare database");
+    }
+    entry.statements[sqlite_query] = stmt;
+  }
+
+  QueryData rows;
+  while ((sqlite3_step(stmt)) == SQLITE_ROW) {
+    auto s = genSqliteQueryRow(stmt, rows, sqlite_db);
+    if (!s.ok()) {
+      break;
+    }
+  }
+  sqlite3_reset(stmt);
+
+  results.insert(results.end(), rows.begin(), rows.end());
+  entry.results[sqlite_query] = std::move(rows);
+  return Status();
+}
+
+/// Refresh block size, a multiple of every SQLite page size.
+const size_t kShadowBlockSize = 64 * 1024;
+
+/// Source (and WAL companion) identity when a shadow was last refreshed.
+struct ShadowEntry {
+  std::time_t mtime{0};
+  uintmax_t size{0};
+  std::time_t wal_mtime{0};
+  uintmax_t wal_size{0};
+};
+
+/// Shadow refresh state, keyed by source path.
+std::map<std::string, ShadowEntry> kShadowEntries;
+
+/// Serialize shadow refreshes.
+Mutex kShadowMutex;
+
+/**
+ * @brief Rewrite only the blocks of a shadow file that differ.
+ *
+ * Both files are read sequentially and compared block-wise, so a mostly
+ * unchanged source costs reads but almost no writes. Writing every byte
+ * of a large History database on each refresh is what this avoids; reads
+ * of the unchanged shadow come from the page cache.
+ */
+Status refreshShadowFile(const fs::path& source, const fs::path& shadow) {
+  PlatformFile src(source, PF_OPEN_EXISTING | PF_READ);
+  if (!src.isValid()) {
+    return Status(1, "Cannot read source database");
+  }
+
+  // There is no truncate primitive in fileops; a source that shrunk (a
+  // vacuum, or WAL checkpoint) recreates its shadow from scratch.
+  auto recreate = !pathExists(shadow).ok();
+  if (!recreate) {
+    PlatformFile probe(shadow, PF_OPEN_EXISTING | PF_READ);
+    recreate = (!probe.isValid() || probe.size() > src.size());
+  }
+
+  // The shadow duplicates data only the daemon could open; never let the
+  // default (umask-derived) mode make it world-readable.
+  PlatformFile dst(shadow,
+                   (recreate ? PF_CREATE_ALWAYS : PF_OPEN_EXISTING) | PF_READ |
+                       PF_WRITE,
+                   (S_IRUSR | S_IWUSR));
+  if (!dst.isValid()) {
+    return Status(1, "Cannot write shadow copy");
+  }
+
+  std::vector<char> src_block(kShadowBlockSize);
+  std::vector<char> dst_block(kShadowBlockSize);
+  size_t offset = 0;
+  auto src_size = static_cast<size_t>(src.size());
+  while (offset < src_size) {
+    auto r = src.read(src_block.data(), kShadowBlockSize);
+    if (r <= 0) {
+      return Status(1, "Failed to read source database");
+    }
+    auto d = dst.read(dst_block.data(), r);
+    if (d != r || std::memcmp(src_block.data(), dst_block.data(), r) != 0) {
+      dst.seek(static_cast<off_t>(offset), PF_SEEK_BEGIN);
+      if (dst.write(src_block.data(), r) != r) {
+        return Status(1, "Failed to write shadow copy");
+      }
+    }
+    offset += static_cast<size_t>(r);
+  }
+  return Status();
+}
+
+/**
+ * @brief Maintain an incrementally refreshed shadow of a source database.
+ *
+ * The shadow lives in the temporary directory, named by a hash of the
+ * source path. While the source's mtime/size identity (including its WAL
+ * companion, which grows without touching the main file) is unchanged the
+ * existing shadow is reused without any copying; otherwise only changed
+ * blocks are rewritten.
+ */
+Status refreshShadowCopy(const fs::path& source, fs::path& shadow) {
+  boost::system::error_code ec;
+  ShadowEntry identity;
+  identity.mtime = fs::last_write_time(source, ec);
+  identity.size = fs::file_size(source, ec);
+
+  auto wal = fs::path(source.string() + "-wal");
+  auto have_wal = pathExists(wal).ok();
+  if (have_wal) {
+    identity.wal_mtime = fs::last_write_time(wal, ec);
+    identity.wal_size = fs::file_size(wal, ec);
+  }
+
+  auto shadow_dir = fs::temp_directory_path(ec) / "osquery-atc-shadow";
+  fs::create_directories(shadow_dir, ec);
+  // Keep the shadow tree private to the daemon owner, including a tree
+  // created by an earlier version with the default mode.
+  platformChmod(shadow_dir.string(), S_IRWXU);
+  auto source_string = source.string();
+  shadow = shadow_dir /
+           (hashFromBuffer(HashType::HASH_TYPE_SHA256,
+                           source_string.c_str(),
+                           source_string.size()) +
+            ".db");
+
+  WriteLock lock(kShadowMutex);
+  auto& entry = kShadowEntries[source_string];
+  if (entry.mtime == identity.mtime && entry.size == identity.size &&
+      entry.wal_mtime == identity.wal_mtime &&
+      entry.wal_size == identity.wal_size && pathExists(shadow).ok()) {
+    return Status();
+  }
+
+  auto status = refreshShadowFile(source, shadow);
+  if (!status.ok()) {
+    return status;
+  }
+
+  // The WAL companion carries transactions not yet checkpointed into the
+  // main file; shadow it alongside so SQLite recovers them on open.
+  auto shadow_wal = fs::path(shadow.string() + "-wal");
+  if (have_wal) {
+    status = refreshShadowFile(wal, shadow_wal);
+    if (!status.ok()) {
+      return status;
+    }
+  } else {
+    fs::remove(shadow_wal, ec);
+  }
+
+  entry = identity;
+  return Status();
+}
+
+/// Open, prepare, and step one query against a source database file,
+/// reporting rows under the display path.
+Status querySqliteSource(const fs::path& sqlite_db,
+                         const fs::path& display_path,
+                         const std::string& sqlite_query,
+                         QueryData& results,
+                         bool respect_locking) {
+  sqlite3* db = nullptr;
+  auto status = openSqliteSource(sqlite_db, respect_locking, &db);
+  if (!status.ok()) {
+    return status;
   }
 
   sqlite3_stmt* stmt = nullptr;
-  rc = sqlite3_prepare_v2(db, sqlite_query.c_str(), -1, &stmt, nullptr);
+  auto rc = sqlite3_prepare_v2(db, sqlite_query.c_str(), -1, &stmt, nullptr);
   if (rc != SQLITE_OK) {
     sqlite3_close(db);
     VLOG(1) << "Could not prepare database at path: " << sqlite_db;
@@ -99,7 +403,7 @@ Status genQueryDataForSqliteTable(const fs::path& sqlite_db,
   }
 
   while ((sqlite3_step(stmt)) == SQLITE_ROW) {
-    auto s = genSqliteQueryRow(stmt, results, sqlite_db);
+    auto s = genSqliteQueryRow(stmt, results, display_path);
     if (!s.ok()) {
       break;
     }
@@ -111,4 +415,36 @@ Status genQueryDataForSqliteTable(const fs::path& sqlite_db,
 
   return Status{};
 }
+} // namespace
+
+Status genQueryDataForSqliteTable(const fs::path& sqlite_db,
+                                  const std::string& sqlite_query,
+                                  QueryData& results,
+                                  bool respect_locking) {
+  if (!pathExists(sqlite_db).ok()) {
+    return Status(1, "Database path does not exist");
+  }
+
+  Status status;
+  if (FLAGS_atc_source_cache) {
+    status = SqliteSourceCache::instance().query(
+        sqlite_db, sqlite_query, results, respect_locking);
+  } else {
+    status = querySqliteSource(
+        sqlite_db, sqlite_db, sqlite_query, results, respect_locking);
+  }
+
+  if (!status.ok() && respect_locking && FLAGS_atc_shadow_copy) {
+    // The live application holds the source locked. Query an incrementally
+    // refreshed shadow instead of failing (or copying the whole file).
+    fs::path shadow;
+    auto refresh = refreshShadowCopy(sqlite_db, shadow);
+    if (refresh.ok()) {
+      VLOG(1) << "Querying shadow copy of locked database: " << sqlite_db;
+      status =
+          querySqliteSource(shadow, sqlite_db, sqlite_query, results, true);
+    }
+  }
+  return status;
+}
 } // namespace osquery
@@ -8,14 +8,21 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <set>
 
 #include <osquery/core.h>
+#include <osquery/database.h>
 #include <osquery/flags.h>
 #include <osquery/logger.h>
 #include <osquery/registry_factory.h>
 #include <osquery/system.h>
 
+#include "osquery/core/conversions.h"
 #include "osquery/core/process.h"
 #include "osquery/sql/virtual_table.h"
 
@@ -28,6 +35,16 @@ FLAG(uint64,
      0,
      "Add an optional microsecond delay between table scans");
 
+FLAG(uint64,
+     table_timeout,
+     0,
+     "Milliseconds a table scan may run before cancellation (0 disables)");
+
+FLAG(bool,
+     table_row_estimates,
+     true,
+     "Feed observed table row counts back into query planning");
+
 SHELL_FLAG(bool, planner, false, "Enable osquery runtime planner output");
 
 DECLARE_bool(disable_events);
@@ -114,6 +131,7 @@ int xEof(sqlite3_vtab_cursor* cur) {
       return false;
     }
     pCur->generator = nullptr;
+    pCur->current = nullptr;
     return true;
   }
 
@@ -135,11 +153,37 @@ int xDestroy(sqlite3_vtab* p) {
 int xNext(sqlite3_vtab_cursor* cur) {
   BaseCursor* pCur = (BaseCursor*)cur;
   if (pCur->uses_generator) {
+    if (std::chrono::steady_clock::now() >= pCur->deadline) {
+      // The scan deadline passed, unwind the generator instead of resuming.
+      pCur->generator = nullptr;
+      pCur->current = nullptr;
+      pCur->uses_generator = false;
+      auto* pVtab = (VirtualTable*)cur->pVtab;
+      LOG(WARNING) << "Table " << pVtab->content->name
+                   << " scan exceeded --table_timeout, cancelling";
+      return SQLITE_INTERRUPT;
+    }
     pCur->generator->operator()();
     if (*pCur->generator) {
-      pCur->current = pCur->generator->get();
+      // Reference the yielded row in-place, it remains valid until the next
+      // resume of the generator within xNext (or the cursor close).
+      pCur->current = &pCur->generator->get();
+
+      auto* pVtab = (VirtualTable*)cur->pVtab;
+      if (!pVtab->instance->claimTableBytes(rowBytes(*pCur->current))) {
+        pCur->generator = nullptr;
+        pCur->current = nullptr;
+        pCur->uses_generator = false;
+        LOG(WARNING) << "Table " << pVtab->content->name
+                     << " scan exceeded --query_max_bytes, failing query";
+        return SQLITE_NOMEM;
+      }
     }
   }
+  // Rows must stay owned by the cursor until xClose. xColumn binds cell
+  // values with SQLITE_STATIC, so SQLite may retain shallow pointers into
+  // any previously-visited row (aggregates, sorters) for the remainder of
+  // the scan; the --query_max_bytes accounting bounds the retained memory.
   pCur->row++;
   return SQLITE_OK;
 }
@@ -150,53 +194,74 @@ int xRowid(sqlite3_vtab_cursor* cur, sqlite_int64* pRowid) {
   return SQLITE_OK;
 }
 
-int xCreate(sqlite3* db,
-            void* pAux,
-            int argc,
-            const char* const* argv,
-            sqlite3_vtab** ppVtab,
-            char** pzErr) {
-  auto* pVtab = new VirtualTable;
-  if (!pVtab || argc == 0 || argv[0] == nullptr) {
-    delete pVtab;
-    return SQLITE_NOMEM;
-  }
+/**
+ * @brief Precompiled per-table schema objects, shared across connections.
+ *
+ * Building a table's schema needs a registry (or extension) call and
+ * column-definition generation per create. The schema is identical for
+ * every connection, so the first create compiles this prototype and later
+ * transient instances clone the in-memory objects, making instance setup
+ * copies of prepared structures instead of repeated registry round trips
+ * and definition parsing.
+ */
+struct TableSchemaPrototype {
+  /// The CREATE TABLE statement passed to sqlite3_declare_vtab.
+  std::string declaration;
 
-  memset(pVtab, 0, sizeof(VirtualTable));
-  pVtab->content = new VirtualTableContent;
-  pVtab->instance = (SQLiteDBInstance*)pAux;
+  /// Table column structure cloned into each VirtualTableContent.
+  TableColumns columns;
+
+  /// Hidden-column alias index mapping.
+  std::map<std::string, size_t> aliases;
+
+  /// Alias-resolved column metadata by SQLite column index.
+  std::vector<std::pair<std::string, ColumnType>> resolved_columns;
+
+  /// Table attributes surfaced to the SQL layer.
+  TableAttributes attributes{TableAttributes::NONE};
+
+  /// Views created for requested table name aliases.
+  std::set<std::string> views;
+};
+
+static Mutex kTablePrototypesMutex;
+static std::map<std::string, std::shared_ptr<TableSchemaPrototype>>
+    kTablePrototypes;
+
+void forgetTablePrototype(const std::string& name) {
+  WriteLock lock(kTablePrototypesMutex);
+  kTablePrototypes.erase(name);
+}
+
+/// Compile (or serve) the shared schema prototype for a table name.
+static std::shared_ptr<TableSchemaPrototype> getTablePrototype(
+    const std::string& name) {
+  {
+    WriteLock lock(kTablePrototypesMutex);
+    auto it = kTablePrototypes.find(name);
+    if (it != kTablePrototypes.end()) {
+      return it->second;
+    }
+  }
 
   // Create a TablePlugin Registry call, expect column details as the response.
+  // Extension tables broadcast their schema at registration; the cached copy
+  // avoids a round trip back to the extension.
   PluginResponse response;
-  pVtab->content->name = std::string(argv[0]);
-  const auto& name = pVtab->content->name;
-  // Get the table column information.
-  auto status =
-      Registry::call("table", name, {{"action", "columns"}}, response);
+  Status status;
+  if (!TablePlugin::getExternalRouteInfo(name, response)) {
+    status = Registry::call("table", name, {{"action", "columns"}}, response);
+  }
   if (!status.ok() || response.size() == 0) {
-    delete pVtab->content;
-    delete pVtab;
-    return SQLITE_ERROR;
+    return nullptr;
   }
 
+  auto prototype = std::make_shared<TableSchemaPrototype>();
   // Generate an SQL create table statement from the retrieved column details.
   // This call to columnDefinition requests column aliases (as HIDDEN columns).
-  auto statement = "CREATE TABLE " + name + columnDefinition(response, true);
-  int rc = sqlite3_declare_vtab(db, statement.c_str());
-  if (rc != SQLITE_OK || !status.ok() || response.size() == 0) {
-    LOG(ERROR) << "Error creating virtual table: " << name << " (" << rc
-               << "): " << getStringForSQLiteReturnCode(rc);
-    VLOG(1) << "Cannot create virtual table using: " << statement;
-    delete pVtab->content;
-    delete pVtab;
-    return (rc != SQLITE_OK) ? rc : SQLITE_ERROR;
-  }
-
-  // Tables may request aliases as views.
-  std::set<std::string> views;
+  prototype->declaration =
+      "CREATE TABLE " + name + columnDefinition(response, true);
 
-  // Keep a local copy of the column details in the VirtualTableContent struct.
-  // This allows introspection into the column type without additional calls.
   for (const auto& column : response) {
     if (column.count("id") == 0) {
       // This does not define a column type.
@@ -207,42 +272,110 @@ int xCreate(sqlite3* db,
         column.count("type")) {
       // This is a malformed column definition.
       // Populate the virtual table specific persistent column information.
-      pVtab->content->columns.push_back(std::make_tuple(
+      prototype->columns.push_back(std::make_tuple(
           column.at("name"),
           columnTypeName(column.at("type")),
           (ColumnOptions)AS_LITERAL(INTEGER_LITERAL, column.at("op"))));
     } else if (column.at("id") == "alias" && column.count("alias")) {
       // Create associated views for table aliases.
-      views.insert(column.at("alias"));
+      prototype->views.insert(column.at("alias"));
     } else if (column.at("id") == "columnAlias" && column.count("name") &&
                column.count("target")) {
       // Record the column in the set of columns.
       // This is required because SQLITE uses indexes to identify columns.
       // Use an UNKNOWN_TYPE as a pseudo-mask, since the type does not matter.
-      pVtab->content->columns.push_back(std::make_tuple(
+      prototype->columns.push_back(std::make_tuple(
           column.at("name"), UNKNOWN_TYPE, ColumnOptions::HIDDEN));
       // Record a mapping of the requested column alias name.
       size_t target_index = 0;
-      for (size_t i = 0; i < pVtab->content->columns.size(); i++) {
-        const auto& target_column = pVtab->content->columns[i];
+      for (size_t i = 0; i < prototype->columns.size(); i++) {
+        const auto& target_column = prototype->columns[i];
         if (std::get<0>(target_column) == column.at("target")) {
           target_index = i;
           break;
         }
       }
-      pVtab->content->aliases[column.at("name")] = target_index;
+      prototype->aliases[column.at("name")] = target_index;
     } else if (column.at("id") == "attributes") {
       // Store the attributes locally so they may be passed to the SQL object.
-      pVtab->content->attributes =
+      prototype->attributes =
           (TableAttributes)AS_LITERAL(INTEGER_LITERAL, column.at("attributes"));
     }
   }
 
+  // Resolve column aliases once; xColumn consults this cache per cell
+  // instead of repeating the alias and metadata lookups on every access.
+  for (const auto& column : prototype->columns) {
+    auto column_name = std::get<0>(column);
+    auto column_type = std::get<1>(column);
+    auto alias = prototype->aliases.find(column_name);
+    if (alias != prototype->aliases.end()) {
+      const auto& target = prototype->columns[alias->second];
+      column_name = std::get<0>(target);
+      column_type = std::get<1>(target);
+    }
+    prototype->resolved_columns.push_back(
+        std::make_pair(std::move(column_name), column_type));
+  }
+
+  WriteLock lock(kTablePrototypesMutex);
+  auto it = kTablePrototypes.find(name);
+  if (it != kTablePrototypes.end()) {
+    // A concurrent create compiled the prototype first; serve that copy.
+    return it->second;
+  }
+  kTablePrototypes[name] = prototype;
+  return prototype;
+}
+
+int xCreate(sqlite3* db,
+            void* pAux,
+            int argc,
+            const char* const* argv,
+            sqlite3_vtab** ppVtab,
+            char** pzErr) {
+  auto* pVtab = new VirtualTable;
+  if (!pVtab || argc == 0 || argv[0] == nullptr) {
+    delete pVtab;
+    return SQLITE_NOMEM;
+  }
+
+  memset(pVtab, 0, sizeof(VirtualTable));
+  pVtab->content = new VirtualTableContent;
+  pVtab->instance = (SQLiteDBInstance*)pAux;
+
+  pVtab->content->name = std::string(argv[0]);
+  const auto& name = pVtab->content->name;
+
+  auto prototype = getTablePrototype(name);
+  if (prototype == nullptr) {
+    delete pVtab->content;
+    delete pVtab;
+    return SQLITE_ERROR;
+  }
+
+  int rc = sqlite3_declare_vtab(db, prototype->declaration.c_str());
+  if (rc != SQLITE_OK) {
+    LOG(ERROR) << "Error creating virtual table: " << name << " (" << rc
+               << "): " << getStringForSQLiteReturnCode(rc);
+    VLOG(1) << "Cannot create virtual table using: " << prototype->declaration;
+    delete pVtab->content;
+    delete pVtab;
+    return rc;
+  }
+
+  // Instance setup clones the shared in-memory schema objects.
+  pVtab->content->columns = prototype->columns;
+  pVtab->content->aliases = prototype->aliases;
+  pVtab->content->resolved_columns = prototype->resolved_columns;
+  pVtab->content->attributes = prototype->attributes;
+
   // Create the requested 'aliases'.
-  for (const auto& view : views) {
-    statement = "CREATE VIEW " + view + " AS SELECT * FROM " + name;
+  for (const auto& view : prototype->views) {
+    auto statement = "CREATE VIEW " + view + " AS SELECT * FROM " + name;
     sqlite3_exec(db, statement.c_str(), nullptr, nullptr, nullptr);
   }
+
   *ppVtab = (sqlite3_vtab*)pVtab;
   return rc;
 }
@@ -254,35 +387,39 @@ int xColumn(sqlite3_vtab_cursor* cur, sqlite3_context* ctx, int col) {
     // Requested column index greater than column set size.
     return SQLITE_ERROR;
   }
+  if (pCur->uses_generator && pCur->current == nullptr) {
+    // The generator has no yielded row to inspect.
+    return SQLITE_ERROR;
+  }
   if (!pCur->uses_generator && pCur->row >= pCur->data.size()) {
     // Request row index greater than row set size.
     return SQLITE_ERROR;
   }
 
-  auto& column_name = std::get<0>(pVtab->content->columns[col]);
-  auto& type = std::get<1>(pVtab->content->columns[col]);
-  if (pVtab->content->aliases.count(column_name)) {
-    // Overwrite the aliased column with the type and name of the new column.
-    type = std::get<1>(
-        pVtab->content->columns[pVtab->content->aliases.at(column_name)]);
-    column_name = std::get<0>(
-        pVtab->content->columns[pVtab->content->aliases.at(column_name)]);
-  }
+  // Aliases were resolved into the per-index cache at table create time.
+  const auto& resolved = pVtab->content->resolved_columns[col];
+  const auto& column_name = resolved.first;
+  const auto& type = resolved.second;
 
   Row* row = nullptr;
   if (pCur->uses_generator) {
-    row = &pCur->current;
+    row = pCur->current;
   } else {
     row = &pCur->data[pCur->row];
   }
 
   // Attempt to cast each xFilter-populated row/column to the SQLite type.
-  const auto& value = (*row)[column_name];
-  if (row->count(column_name) == 0) {
+  // Find without inserting: a missing cell must not allocate into the row.
+  auto cell = row->find(column_name);
+  if (cell == row->end()) {
     // Missing content.
     VLOG(1) << "Error " << column_name << " is empty";
     sqlite3_result_null(ctx);
-  } else if (type == TEXT_TYPE) {
+    return SQLITE_OK;
+  }
+
+  const auto& value = cell->second;
+  if (type == TEXT_TYPE) {
     sqlite3_result_text(
         ctx, value.c_str(), static_cast<int>(value.size()), SQLITE_STATIC);
   } else if (type == INTEGER_TYPE) {
@@ -331,6 +468,85 @@ static inline bool sensibleComparison(ColumnType type, unsigned char op) {
   return true;
 }
 
+/// Database key prefix for persisted row-count observations.
+const std::string kTableEstimatePrefix{"table_estimate."};
+
+/// Protects the cached row-count observations.
+static Mutex kRowEstimatesMutex;
+
+/**
+ * @brief Observed row counts per table and constraint shape.
+ *
+ * xFilter records how many rows each generation produced, keyed by the table
+ * name and the shape (columns and operators, not values) of the constraint
+ * set. xBestIndex replays the smoothed observation as the row estimate for
+ * matching plans, so frequently-run queries converge on efficient join
+ * orders. Observations are persisted and reloaded across restarts.
+ */
+static std::map<std::string, sqlite3_int64> kRowEstimates;
+
+/// Build a value-independent key for a table's constraint set.
+static std::string constraintShapeKey(const std::string& name,
+                                      const ConstraintSet& constraints) {
+  // The shape is order-insensitive; SQLite may permute constraint terms.
+  std::multiset<std::string> shape;
+  for (const auto& constraint : constraints) {
+    shape.insert(constraint.first + ':' +
+                 std::to_string(constraint.second.op));
+  }
+
+  auto key = name;
+  for (const auto& term : shape) {
+    key += '#' + term;
+  }
+  return key;
+}
+
+/// Return the observed row count for a shape, 0 when never observed.
+static sqlite3_int64 getRowEstimate(const std::string& key) {
+  {
+    ReadLock lock(kRowEstimatesMutex);
+    auto it = kRowEstimates.find(key);
+    if (it != kRowEstimates.end()) {
+      return it->second;
+    }
+  }
+
+  // Not cached: restore an observation persisted by a previous run.
+  long long estimate = 0;
+  std::string value;
+  if (getDatabaseValue(kPersistentSettings, kTableEstimatePrefix + key, value)
+          .ok() &&
+      !value.empty()) {
+    safeStrtoll(value, 10, estimate);
+  }
+
+  WriteLock lock(kRowEstimatesMutex);
+  kRowEstimates[key] = static_cast<sqlite3_int64>(estimate);
+  return static_cast<sqlite3_int64>(estimate);
+}
+
+/// Fold a scan's produced row count into the estimate for its shape.
+static void recordRowEstimate(const std::string& key, size_t rows) {
+  auto updated = static_cast<sqlite3_int64>(rows);
+  {
+    WriteLock lock(kRowEstimatesMutex);
+    auto it = kRowEstimates.find(key);
+    if (it != kRowEstimates.end() && it->second > 0) {
+      // Smooth toward the new observation.
+      updated = (it->second + updated) / 2;
+    }
+    if (it != kRowEstimates.end() && it->second == updated) {
+      // Unchanged, skip the database write.
+      return;
+    }
+    kRowEstimates[key] = updated;
+  }
+
+  setDatabaseValue(
+      kPersistentSettings, kTableEstimatePrefix + key, std::to_string(updated));
+}
+
 static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
   auto* pVtab = (VirtualTable*)tab;
   const auto& columns = pVtab->content->columns;
@@ -345,6 +561,7 @@ static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
   // Tables may have requirements or use indexes.
   bool required_satisfied = false;
   bool index_used = false;
+  bool equality_used = false;
 
   // Expressions operating on the same virtual table are loosely identified by
   // the consecutive sets of terms each of the constraint sets are applied onto.
@@ -390,6 +607,13 @@ static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
         index_used = true;
       }
 
+      if ((options & (ColumnOptions::REQUIRED | ColumnOptions::INDEX |
+                      ColumnOptions::ADDITIONAL)) &&
+          constraint_info.op == SQLITE_INDEX_CONSTRAINT_EQ) {
+        // Equality against an indexed column selects few rows cheaply.
+        equality_used = true;
+      }
+
       // Save a pair of the name and the constraint operator.
       // Use this constraint during xFilter by performing a scan and column
       // name lookup through out all cursor constraint lists.
@@ -419,6 +643,27 @@ static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
     cost += 200;
   }
 
+  // Scale the plan estimates using the table's declared attributes. An
+  // EXPENSIVE table generated without any indexed constraint should sit on
+  // the outer side of a join, probed by the cheaper table's rows.
+  sqlite3_int64 rows = 1000;
+  if ((pVtab->content->attributes & TableAttributes::EXPENSIVE) > 0 &&
+      !index_used) {
+    cost += 1e6;
+    rows = 100000;
+  } else if (equality_used) {
+    rows = 10;
+  }
+
+  // Prefer an observed row count for this constraint shape over heuristics.
+  if (FLAGS_table_row_estimates) {
+    auto estimate =
+        getRowEstimate(constraintShapeKey(pVtab->content->name, constraints));
+    if (estimate > 0) {
+      rows = estimate;
+    }
+  }
+
   UsedColumns colsUsed;
   if (pIdxInfo->colUsed > 0) {
     for (size_t i = 0; i < columns.size(); i++) {
@@ -437,6 +682,29 @@ static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
     }
   }
 
+  OrderTerms order_terms;
+  for (int i = 0; i < pIdxInfo->nOrderBy; ++i) {
+    const auto& term = pIdxInfo->aOrderBy[i];
+    if (term.iColumn < 0 ||
+        static_cast<size_t>(term.iColumn) >= columns.size()) {
+      continue;
+    }
+    order_terms.push_back(
+        std::make_pair(std::get<0>(columns[term.iColumn]), term.desc != 0));
+  }
+  // The sort is never claimed (orderByConsumed) so these remain advisory.
+
+  // Summarize the decision in the index string. SQLite appends this to
+  // EXPLAIN QUERY PLAN output, so plan inspection (including the
+  // --check_packs report) can tell a pushed-down predicate from a full
+  // table generation: "full" means no constraint reaches the generator,
+  // "scan" means constraints exist but none hit an indexed column.
+  pIdxInfo->idxStr = sqlite3_mprintf(
+      "%s(%d)",
+      constraints.empty() ? "full" : (index_used ? "index" : "scan"),
+      static_cast<int>(constraints.size()));
+  pIdxInfo->needToFreeIdxStr = 1;
+
   pIdxInfo->idxNum = static_cast<int>(kConstraintIndexID++);
 #if defined(DEBUG)
   plan("Recording constraint set for table: " + pVtab->content->name +
@@ -447,7 +715,9 @@ static int xBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo) {
   // Add the constraint set to the table's tracked constraints.
   pVtab->content->constraints[pIdxInfo->idxNum] = std::move(constraints);
   pVtab->content->colsUsed[pIdxInfo->idxNum] = std::move(colsUsed);
+  pVtab->content->orderTerms[pIdxInfo->idxNum] = std::move(order_terms);
   pIdxInfo->estimatedCost = cost;
+  pIdxInfo->estimatedRows = rows;
   return SQLITE_OK;
 }
 
@@ -472,6 +742,14 @@ static int xFilter(sqlite3_vtab_cursor* pVtabCursor,
   // The SQLite instance communicates to the TablePlugin via the context.
   context.useCache(pVtab->instance->useCache());
 
+  if (FLAGS_table_timeout > 0) {
+    // Cooperative cancellation: tables and the generator stepper check this
+    // deadline and stop producing rows once it has passed.
+    context.setDeadline(
+        std::chrono::steady_clock::now() +
+        std::chrono::milliseconds(static_cast<long>(FLAGS_table_timeout)));
+  }
+
   // Track required columns, this is different than the requirements check
   // that occurs within BestIndex because this scan includes a cursor.
   // For each cursor used, if a requirement exists, we need to scan the
@@ -554,6 +832,10 @@ static int xFilter(sqlite3_vtab_cursor* pVtabCursor,
     context.colsUsed = content->colsUsed[idxNum];
   }
 
+  if (content->orderTerms.size() > 0) {
+    context.orderTerms = content->orderTerms[idxNum];
+  }
+
   if (!user_based_satisfied) {
     LOG(WARNING) << "The " << pVtab->content->name
                  << " table returns data based on the current user by default, "
@@ -580,28 +862,79 @@ static int xFilter(sqlite3_vtab_cursor* pVtabCursor,
 
   // Generate the row data set.
   plan("Scanning rows for cursor (" + std::to_string(pCur->id) + ")");
+  auto wall_start = std::chrono::steady_clock::now();
+  auto cpu_start = std::clock();
   if (Registry::get().exists("table", pVtab->content->name, true)) {
     auto plugin = Registry::get().plugin("table", pVtab->content->name);
     auto table = std::dynamic_pointer_cast<TablePlugin>(plugin);
     if (table->usesGenerator()) {
+      // Generator tables yield rows lazily and are not instrumented.
       pCur->uses_generator = true;
+      pCur->deadline = context.getDeadline();
       pCur->generator = std::make_unique<RowGenerator::pull_type>(
           std::bind(&TablePlugin::generator,
                     table,
                     std::placeholders::_1,
                     std::move(context)));
       if (*pCur->generator) {
-        pCur->current = pCur->generator->get();
+        pCur->current = &pCur->generator->get();
+      }
+      return SQLITE_OK;
+    }
+    // An unconstrained scan may have been generated ahead of execution, in
+    // parallel with the other tables of a join; its statistics were recorded
+    // by the prefetching thread.
+    if (content->constraints[idxNum].empty() &&
+        pVtab->instance->getPrefetchedResults(content->name, pCur->data)) {
+      if (!pVtab->instance->claimTableBytes(queryDataBytes(pCur->data))) {
+        pCur->data.clear();
+        LOG(WARNING) << "Table " << content->name
+                     << " scan exceeded --query_max_bytes, failing query";
+        return SQLITE_NOMEM;
       }
+      pCur->n = pCur->data.size();
       return SQLITE_OK;
     }
     pCur->data = table->generate(context);
+    if (context.isCancelled()) {
+      pCur->data.clear();
+      LOG(WARNING) << "Table " << content->name
+                   << " scan exceeded --table_timeout, cancelling";
+      return SQLITE_INTERRUPT;
+    }
   } else {
     PluginRequest request = {{"action", "generate"}};
     TablePlugin::setRequestFromContext(context, request);
     Registry::call("table", pVtab->content->name, request, pCur->data);
   }
 
+  // Fold this scan into the per-table statistics (osquery_table_stats).
+  auto wall_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - wall_start)
+                       .count();
+  auto cpu_time =
+      (std::clock() - cpu_start) * 1000000 / static_cast<long>(CLOCKS_PER_SEC);
+  auto bytes = queryDataBytes(pCur->data);
+  recordTableGenerateStats(content->name,
+                           static_cast<uint64_t>(wall_time),
+                           static_cast<uint64_t>(std::max(cpu_time, 0L)),
+                           pCur->data.size(),
+                           bytes);
+
+  // Feed the produced row count back into planning for this shape.
+  if (FLAGS_table_row_estimates) {
+    recordRowEstimate(
+        constraintShapeKey(content->name, content->constraints[idxNum]),
+        pCur->data.size());
+  }
+
+  if (!pVtab->instance->claimTableBytes(bytes)) {
+    pCur->data.clear();
+    LOG(WARNING) << "Table " << content->name
+                 << " scan exceeded --query_max_bytes, failing query";
+    return SQLITE_NOMEM;
+  }
+
   // Set the number of rows.
   pCur->n = pCur->data.size();
   return SQLITE_OK;
@@ -609,6 +942,18 @@ static int xFilter(sqlite3_vtab_cursor* pVtabCursor,
 }
 }
 
+/**
+ * @brief A shared cache of virtual table schema statements.
+ *
+ * Computing a table's CREATE statement needs a registry (or extension) round
+ * trip for the column metadata. The schema is identical across connections,
+ * so the statement computed for the first attach is cached by table name and
+ * cloned into every later transient instance. Entries are dropped when a
+ * table detaches (extension removal).
+ */
+static Mutex kSchemaStatementsMutex;
+static std::map<std::string, std::string> kSchemaStatements;
+
 Status attachTableInternal(const std::string& name,
                            const std::string& statement,
                            const SQLiteDBInstanceRef& instance) {
@@ -617,6 +962,12 @@ Status attachTableInternal(const std::string& name,
     return Status(0, getStringForSQLiteReturnCode(0));
   }
 
+  {
+    // Seed the shared schema cache for future connections.
+    WriteLock lock(kSchemaStatementsMutex);
+    kSchemaStatements[name] = statement;
+  }
+
   // A static module structure does not need specific logic per-table.
   // clang-format off
   static sqlite3_module module = {
@@ -664,6 +1015,15 @@ Status attachTableInternal(const std::string& name,
 
 Status detachTableInternal(const std::string& name,
                            const SQLiteDBInstanceRef& instance) {
+  {
+    // The schema may belong to a removed extension, forget it.
+    WriteLock lock(kSchemaStatementsMutex);
+    kSchemaStatements.erase(name);
+  }
+
+  // Drop the compiled schema prototype along with the statement.
+  tables::sqlite::forgetTablePrototype(name);
+
   auto lock(instance->attachLock());
   auto format = "DROP TABLE IF EXISTS temp." + name;
   int rc = sqlite3_exec(instance->db(), format.c_str(), nullptr, nullptr, 0);
@@ -702,15 +1062,37 @@ void attachVirtualTables(const SQLiteDBInstanceRef& instance) {
 #endif
   }
 
-  PluginResponse response;
+  auto start = std::chrono::steady_clock::now();
   for (const auto& name : RegistryFactory::get().names("table")) {
-    // Column information is nice for virtual table create call.
-    auto status =
-        Registry::call("table", name, {{"action", "columns"}}, response);
-    if (status.ok()) {
-      auto statement = columnDefinition(response, true);
-      attachTableInternal(name, statement, instance);
+    std::string statement;
+    {
+      // Clone the schema statement computed by an earlier connection.
+      WriteLock lock(kSchemaStatementsMutex);
+      auto cached = kSchemaStatements.find(name);
+      if (cached != kSchemaStatements.end()) {
+        statement = cached->second;
+      }
     }
+
+    if (statement.empty()) {
+      // Column information is nice for virtual table create call.
+      PluginResponse response;
+      if (!TablePlugin::getExternalRouteInfo(name, response)) {
+        auto status =
+            Registry::call("table", name, {{"action", "columns"}}, response);
+        if (!status.ok()) {
+          continue;
+        }
+      }
+      statement = columnDefinition(response, true);
+    }
+    attachTableInternal(name, statement, instance);
   }
+
+  auto attach_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+  VLOG(1) << "Attached virtual tables to new SQLite instance in "
+          << attach_time << " us";
 }
 }
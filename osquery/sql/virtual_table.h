@@ -48,12 +48,16 @@ struct BaseCursor : private boost::noncopyable {
   /// Callable generator.
   std::unique_ptr<RowGenerator::pull_type> generator{nullptr};
 
-  /// Results of current call.
-  Row current;
+  /// The generator's current yielded row, valid until the next resume.
+  Row* current{nullptr};
 
   /// Does the backing local table use a generator type.
   bool uses_generator{false};
 
+  /// Deadline copied from the query context before it moves to the generator.
+  std::chrono::steady_clock::time_point deadline{
+      std::chrono::steady_clock::time_point::max()};
+
   /// Current cursor position.
   size_t row{0};
 
@@ -8,6 +8,7 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
@@ -16,6 +17,7 @@
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/split.hpp>
+#include <boost/noncopyable.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
 #include <boost/asio.hpp>
@@ -27,6 +29,7 @@
 
 #include <osquery/flags.h>
 #include <osquery/logger.h>
+#include <osquery/mutex.h>
 #include <osquery/tables.h>
 
 #include "osquery/core/conversions.h"
@@ -54,17 +57,83 @@ FLAG(string,
      "/var/run/docker.sock",
      "Docker UNIX domain socket path");
 
+FLAG(uint64,
+     docker_api_cache_ttl,
+     5,
+     "Seconds a docker API response may be served from cache, 0 disables");
+
 namespace tables {
 
 /**
- * @brief Makes API calls to the docker UNIX socket.
+ * @brief A short-TTL cache of docker API responses, keyed by endpoint.
+ *
+ * Several docker tables fetch the same endpoints per query -- a dashboard
+ * query touching five tables requests /containers/json five times. Parsed
+ * responses are shared between those scans for a few seconds so a single
+ * round trip to the daemon serves the whole query.
+ */
+class DockerApiCache : private boost::noncopyable {
+ public:
+  static DockerApiCache& get() {
+    static DockerApiCache instance;
+    return instance;
+  }
+
+  /// Copy out a response younger than the TTL, true on a cache hit.
+  bool getResponse(const std::string& uri, pt::ptree& tree) {
+    if (FLAGS_docker_api_cache_ttl == 0) {
+      return false;
+    }
+
+    WriteLock lock(mutex_);
+    auto entry = entries_.find(uri);
+    if (entry == entries_.end()) {
+      return false;
+    }
+
+    auto age = std::chrono::steady_clock::now() - entry->second.cached_at;
+    if (age > std::chrono::seconds(FLAGS_docker_api_cache_ttl)) {
+      entries_.erase(entry);
+      return false;
+    }
+
+    tree = entry->second.tree;
+    return true;
+  }
+
+  /// Store a parsed response for subsequent scans.
+  void setResponse(const std::string& uri, const pt::ptree& tree) {
+    if (FLAGS_docker_api_cache_ttl == 0) {
+      return;
+    }
+
+    WriteLock lock(mutex_);
+    entries_[uri] = {tree, std::chrono::steady_clock::now()};
+  }
+
+ private:
+  /// A parsed response and the time it was fetched.
+  struct Entry {
+    pt::ptree tree;
+    std::chrono::steady_clock::time_point cached_at;
+  };
+
+  /// Protect concurrent access from parallel table scans.
+  Mutex mutex_;
+
+  /// Cached responses, keyed by the request URI.
+  std::map<std::string, Entry> entries_;
+};
+
+/**
+ * @brief Makes one GET request to the docker UNIX socket.
  *
  * @param uri Relative URI to invoke GET HTTP method.
  * @param tree Property tree where JSON result is stored.
  * @return Status with 0 code on success. Non-negative status with error
  *         message.
  */
-Status dockerApi(const std::string& uri, pt::ptree& tree) {
+static Status dockerApiRequest(const std::string& uri, pt::ptree& tree) {
   static const std::regex httpOkRegex("HTTP/1\\.(0|1) 200 OK\\\r");
 
   try {
@@ -115,6 +184,27 @@ Status dockerApi(const std::string& uri, pt::ptree& tree) {
   return Status(0);
 }
 
+/**
+ * @brief Makes API calls to the docker UNIX socket, serving repeats from a
+ * short-TTL response cache so tables queried together share round trips.
+ *
+ * @param uri Relative URI to invoke GET HTTP method.
+ * @param tree Property tree where JSON result is stored.
+ * @return Status with 0 code on success. Non-negative status with error
+ *         message.
+ */
+Status dockerApi(const std::string& uri, pt::ptree& tree) {
+  if (DockerApiCache::get().getResponse(uri, tree)) {
+    return Status(0);
+  }
+
+  auto s = dockerApiRequest(uri, tree);
+  if (s.ok()) {
+    DockerApiCache::get().setResponse(uri, tree);
+  }
+  return s;
+}
+
 /**
  * @brief Entry point for docker_version table.
  */
@@ -382,7 +472,33 @@ QueryData genContainers(QueryContext& context) {
     return results;
   }
 
+  // The per-container inspect API call is expensive; only issue it when the
+  // query selects a column populated from the inspect data.
+  bool inspect_used = context.isAnyColumnUsed({"pid",
+                                               "started_at",
+                                               "finished_at",
+                                               "privileged",
+                                               "readonly_rootfs",
+                                               "path",
+                                               "config_entrypoint",
+                                               "security_options",
+                                               "env_variables"});
+#ifdef __linux__
+  inspect_used = inspect_used || context.isAnyColumnUsed({"cgroup_namespace",
+                                                          "ipc_namespace",
+                                                          "mnt_namespace",
+                                                          "net_namespace",
+                                                          "pid_namespace",
+                                                          "user_namespace",
+                                                          "uts_namespace"});
+#endif
+
   for (const auto& entry : containers) {
+    if (context.isCancelled()) {
+      // The scan deadline passed, skip the remaining inspect API calls.
+      break;
+    }
+
     const pt::ptree& container = entry.second;
     Row r;
     r["id"] = getValue(container, ids, "Id");
@@ -403,6 +519,11 @@ QueryData genContainers(QueryContext& context) {
     r["state"] = container.get<std::string>("State", "");
     r["status"] = container.get<std::string>("Status", "");
 
+    if (!inspect_used) {
+      results.push_back(r);
+      continue;
+    }
+
     pt::ptree container_details;
     s = dockerApi("/containers/" + r["id"] + "/json?stream=false",
                   container_details);
@@ -603,6 +724,10 @@ QueryData genContainerProcesses(QueryContext& context) {
   std::string ps_args;
 
   for (const auto& id : context.constraints["id"].getAll(EQUALS)) {
+    if (context.isCancelled()) {
+      break;
+    }
+
     if (!checkConstraintValue(id)) {
       continue;
     }
@@ -785,6 +910,10 @@ std::string getNetworkBytes(const pt::ptree& tree, const std::string& key) {
 QueryData genContainerStats(QueryContext& context) {
   QueryData results;
   for (const auto& id : context.constraints["id"].getAll(EQUALS)) {
+    if (context.isCancelled()) {
+      break;
+    }
+
     if (!checkConstraintValue(id)) {
       continue;
     }
@@ -0,0 +1,67 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <osquery/core.h>
+#include <osquery/query.h>
+#include <osquery/registry.h>
+#include <osquery/tables.h>
+
+namespace osquery {
+
+/**
+ * @brief Tables of scheduling interest, benchmarked when registered.
+ *
+ * The list spans the hot tables most schedules poll. Entries missing on
+ * the current platform (or disabled at build time) are skipped, so the
+ * same harness runs on every OS and reports only the tables it has.
+ */
+static const std::vector<std::string> kBenchmarkTableNames = {
+    "processes",
+    "process_open_sockets",
+    "process_memory_map",
+    "listening_ports",
+    "users",
+    "groups",
+    "routes",
+    "interface_addresses",
+    "uptime",
+    "osquery_info",
+};
+
+static void TABLES_generate(benchmark::State& state) {
+  const auto& name = kBenchmarkTableNames[state.range(0)];
+  auto tables = RegistryFactory::get().registry("table");
+  if (!tables->exists(name)) {
+    state.SkipWithError(("Table not registered: " + name).c_str());
+    return;
+  }
+
+  size_t rows = 0;
+  size_t bytes = 0;
+  while (state.KeepRunning()) {
+    PluginResponse response;
+    Registry::call("table", name, {{"action", "generate"}}, response);
+    rows += response.size();
+    for (const auto& r : response) {
+      bytes += rowBytes(r);
+    }
+  }
+
+  // Rows/sec falls out of the iteration timing; the label names the table
+  // since benchmark arguments are positional.
+  state.SetLabel(name);
+  state.SetItemsProcessed(rows);
+  state.SetBytesProcessed(bytes);
+}
+
+BENCHMARK(TABLES_generate)->DenseRange(0, 9);
+}
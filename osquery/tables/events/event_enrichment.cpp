@@ -0,0 +1,170 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <list>
+#include <unordered_map>
+
+#include <osquery/flags.h>
+#include <osquery/mutex.h>
+#include <osquery/sql.h>
+
+#include "osquery/tables/events/event_enrichment.h"
+
+namespace osquery {
+
+FLAG(uint64,
+     events_enrichment_cache,
+     1024,
+     "Maximum file hashes and user names cached for event enrichment "
+     "(0 disables the cache)");
+
+namespace {
+
+/// The set of hashes decorated onto file-backed events.
+const int kEventHashTypes = HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256;
+
+/**
+ * @brief A small thread-safe LRU shared by the enrichment helpers.
+ *
+ * Lookups refresh recency, insertions evict the least-recently used entry
+ * once the configured limit is reached.
+ */
+template <typename Value>
+class EnrichmentCache {
+ public:
+  bool get(const std::string& key, Value& value) {
+    WriteLock lock(mutex_);
+    auto it = items_.find(key);
+    if (it == items_.end()) {
+      return false;
+    }
+    order_.splice(order_.begin(), order_, it->second.second);
+    value = it->second.first;
+    return true;
+  }
+
+  void put(const std::string& key, const Value& value, size_t limit) {
+    WriteLock lock(mutex_);
+    auto it = items_.find(key);
+    if (it != items_.end()) {
+      it->second.first = value;
+      order_.splice(order_.begin(), order_, it->second.second);
+      return;
+    }
+
+    while (items_.size() >= limit && !order_.empty()) {
+      items_.erase(order_.back());
+      order_.pop_back();
+    }
+    order_.push_front(key);
+    items_.emplace(key, std::make_pair(value, order_.begin()));
+  }
+
+  void remove(const std::string& key) {
+    WriteLock lock(mutex_);
+    auto it = items_.find(key);
+    if (it != items_.end()) {
+      order_.erase(it->second.second);
+      items_.erase(it);
+    }
+  }
+
+ private:
+  /// Keys in most-recently used order.
+  std::list<std::string> order_;
+
+  /// Cached values with their position in the recency list.
+  std::unordered_map<std::string,
+                     std::pair<Value, std::list<std::string>::iterator>>
+      items_;
+
+  /// Lock around the cache content and recency list.
+  Mutex mutex_;
+};
+
+/// A cached set of file digests and the metadata token guarding reuse.
+struct FileHashEntry {
+  std::string validity;
+  MultiHashes hashes;
+};
+
+EnrichmentCache<FileHashEntry>& fileHashCache() {
+  static EnrichmentCache<FileHashEntry> cache;
+  return cache;
+}
+
+EnrichmentCache<std::string>& usernameCache() {
+  static EnrichmentCache<std::string> cache;
+  return cache;
+}
+
+EnrichmentCache<std::string>& fileStateCache() {
+  static EnrichmentCache<std::string> cache;
+  return cache;
+}
+} // namespace
+
+MultiHashes hashFileEventCached(const std::string& path,
+                                const std::string& validity) {
+  if (FLAGS_events_enrichment_cache == 0 || validity.empty()) {
+    return hashMultiFromFileCached(kEventHashTypes, path);
+  }
+
+  FileHashEntry entry;
+  if (fileHashCache().get(path, entry) && entry.validity == validity) {
+    return entry.hashes;
+  }
+
+  entry.validity = validity;
+  // A miss here may still hit the process-wide file-state cache when another
+  // subsystem (the hash table, a file walk) already digested this content.
+  entry.hashes = hashMultiFromFileCached(kEventHashTypes, path);
+  if (!entry.hashes.md5.empty()) {
+    fileHashCache().put(path, entry, FLAGS_events_enrichment_cache);
+  }
+  return entry.hashes;
+}
+
+std::string usernameFromUid(const std::string& uid) {
+  std::string username;
+  if (FLAGS_events_enrichment_cache > 0 && usernameCache().get(uid, username)) {
+    return username;
+  }
+
+  auto results = SQL::selectAllFrom("users", "uid", EQUALS, uid);
+  if (!results.empty() && results.at(0).count("username") > 0) {
+    username = results.at(0).at("username");
+  }
+
+  if (FLAGS_events_enrichment_cache > 0 && !username.empty()) {
+    usernameCache().put(uid, username, FLAGS_events_enrichment_cache);
+  }
+  return username;
+}
+
+bool fileEventStateChanged(const std::string& path, const std::string& state) {
+  if (FLAGS_events_enrichment_cache == 0 || state.empty()) {
+    return true;
+  }
+
+  std::string previous;
+  if (fileStateCache().get(path, previous) && previous == state) {
+    return false;
+  }
+
+  fileStateCache().put(path, state, FLAGS_events_enrichment_cache);
+  return true;
+}
+
+void invalidateFileEnrichment(const std::string& path) {
+  fileHashCache().remove(path);
+  fileStateCache().remove(path);
+}
+}
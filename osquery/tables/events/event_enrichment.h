@@ -0,0 +1,67 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "osquery/core/hashing.h"
+
+namespace osquery {
+
+/**
+ * @brief Hash a file for event enrichment, reusing cached digests.
+ *
+ * Event subscribers repeatedly hash the same content: the binary behind a
+ * burst of process events or a watched file touched many times produces the
+ * same digests until it changes on disk. Results are memoized in a small
+ * shared LRU keyed by path, validated against a caller-provided token built
+ * from the file metadata (inode, mtime, size). When the token differs the
+ * file is re-read and the entry replaced, so FIM-visible changes naturally
+ * invalidate the cache.
+ *
+ * @param path The target path to read and hash.
+ * @param validity A metadata token guarding reuse, empty bypasses the cache.
+ *
+ * @return The set of md5, sha1, sha256 hashes.
+ */
+MultiHashes hashFileEventCached(const std::string& path,
+                                const std::string& validity);
+
+/**
+ * @brief Resolve a UID to a username through the users table, memoized.
+ *
+ * A handful of UIDs own most events, so the resolved names are kept in the
+ * shared enrichment LRU instead of querying the users table per event.
+ *
+ * @param uid The stringified UID from an event row.
+ *
+ * @return The username, or an empty string if the UID is unknown.
+ */
+std::string usernameFromUid(const std::string& uid);
+
+/**
+ * @brief Record a path's observed state, reporting whether it changed.
+ *
+ * File events often fire for writes that leave the reported state (stat
+ * metadata and digests) identical. The previous state token is memoized per
+ * path; a matching token means the triggering event changed nothing osquery
+ * reports and the caller may drop it before row construction.
+ *
+ * @param path The target path from the file event.
+ * @param state The observed state token, empty always reports a change.
+ *
+ * @return False if the path's state matches the previously recorded token.
+ */
+bool fileEventStateChanged(const std::string& path, const std::string& state);
+
+/// Drop any cached enrichment for a path, e.g. when an event removes it.
+void invalidateFileEnrichment(const std::string& path);
+}
@@ -9,18 +9,27 @@
  */
 
 #include <osquery/events.h>
+#include <osquery/flags.h>
 #include <osquery/sql.h>
 
 #include "osquery/core/hashing.h"
+#include "osquery/tables/events/event_enrichment.h"
 #include "osquery/tables/events/event_utils.h"
 
 namespace osquery {
 
+FLAG(bool,
+     file_events_suppress_unchanged,
+     false,
+     "Drop modify/attribute file events whose stat metadata and digests "
+     "match the previously recorded event for the path");
+
 const std::set<std::string> kCommonFileColumns = {
     "inode", "uid", "gid", "mode", "size", "atime", "mtime", "ctime",
 };
 
-void decorateFileEvent(const std::string& path, bool hash, Row& r) {
+bool decorateFileEvent(const std::string& path, bool hash, Row& r) {
+  std::string validity;
   auto results = SQL::selectAllFrom("file", "path", EQUALS, path);
   if (results.size() == 1) {
     auto& row = results.at(0);
@@ -29,11 +38,15 @@ void decorateFileEvent(const std::string& path, bool hash, Row& r) {
         r[key] = row.at(key);
       }
     }
+    // The stat metadata doubles as the hash-cache validity token.
+    if (row.count("inode") > 0 && row.count("mtime") > 0 &&
+        row.count("size") > 0) {
+      validity = row.at("inode") + ':' + row.at("mtime") + ':' + row.at("size");
+    }
   }
 
   if (hash) {
-    auto hashes = hashMultiFromFile(
-        HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256, path);
+    auto hashes = hashFileEventCached(path, validity);
     r["md5"] = std::move(hashes.md5);
     r["sha1"] = std::move(hashes.sha1);
     r["sha256"] = std::move(hashes.sha256);
@@ -43,5 +56,22 @@ void decorateFileEvent(const std::string& path, bool hash, Row& r) {
     // Alternatively if hashing wasn't needed hashed is a 0.
     r["hashed"] = "0";
   }
+
+  if (!FLAGS_file_events_suppress_unchanged) {
+    return true;
+  }
+
+  // The memo token covers the ownership and permission columns beyond the
+  // hash-cache validity, so a chmod/chown is never considered a no-change.
+  auto state = validity;
+  for (const auto& key : {"mode", "uid", "gid"}) {
+    if (r.count(key) > 0) {
+      state += ':' + r.at(key);
+    }
+  }
+  if (hash && r.count("sha256") > 0) {
+    state += ':' + r.at("sha256");
+  }
+  return fileEventStateChanged(path, state);
 }
 }
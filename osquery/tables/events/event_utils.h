@@ -29,6 +29,10 @@ extern const std::set<std::string> kCommonFileColumns;
  * @param path The target path from the file event.
  * @param hash Should the target path be read and hashed.
  * @param r The output parameter row structure.
+ *
+ * @return False when --file_events_suppress_unchanged is set and the path's
+ * stat metadata and digests match the previously decorated event, meaning
+ * the triggering write changed nothing the subscriber reports.
  */
-void decorateFileEvent(const std::string& path, bool hash, Row& r);
+bool decorateFileEvent(const std::string& path, bool hash, Row& r);
 }
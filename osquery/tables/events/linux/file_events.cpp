@@ -18,6 +18,7 @@
 #include <osquery/tables.h>
 
 #include "osquery/events/linux/inotify.h"
+#include "osquery/tables/events/event_enrichment.h"
 #include "osquery/tables/events/event_utils.h"
 
 namespace osquery {
@@ -95,13 +96,27 @@ Status FileEventSubscriber::Callback(const ECRef& ec, const SCRef& sc) {
   r["category"] = sc->category;
   r["transaction_id"] = INTEGER(ec->event->cookie);
 
+  if (ec->action == "DELETED" || ec->action == "MOVED_FROM") {
+    // The path is gone, drop any cached enrichment for it.
+    invalidateFileEnrichment(ec->path);
+  }
+
+  bool changed = true;
   if ((sc->mask & kFileAccessMasks) != kFileAccessMasks) {
     // Add hashing and 'join' against the file table for stat-information.
-    decorateFileEvent(
+    changed = decorateFileEvent(
         ec->path, (ec->action == "CREATED" || ec->action == "UPDATED"), r);
   } else {
     // The access event on Linux would generate additional events if hashed.
-    decorateFileEvent(ec->path, false, r);
+    changed = decorateFileEvent(ec->path, false, r);
+  }
+
+  if (!changed &&
+      (ec->action == "UPDATED" || ec->action == "ATTRIBUTES_MODIFIED")) {
+    // A modify/attrib burst that left the reported state identical; drop the
+    // event before the database write. Lifecycle actions (create, delete,
+    // move, access) are always recorded.
+    return Status(0, "OK");
   }
 
   // A callback is somewhat useless unless it changes the EventSubscriber
@@ -48,9 +48,7 @@ Status AuditProcessEventSubscriber::Callback(const ECRef& ec, const SCRef& sc) {
     return status;
   }
 
-  for (auto& row : emitted_row_list) {
-    add(row);
-  }
+  addBatch(emitted_row_list);
 
   return Status(0, "Ok");
 }
@@ -245,12 +245,6 @@ bool EmitRowFromSyscallContext(
     Row& row,
     const AuditdFimContext& fim_context,
     const AuditdFimSyscallContext& syscall_context) noexcept {
-  auto L_IsPathIncluded = [&fim_context](const std::string& path) -> bool {
-    return (std::find(fim_context.included_path_list.begin(),
-                      fim_context.included_path_list.end(),
-                      path) != fim_context.included_path_list.end());
-  };
-
   row.clear();
   bool is_write_operation = false;
 
@@ -258,10 +252,21 @@ bool EmitRowFromSyscallContext(
     return false;
   }
 
+  // Filter on the affected path(s) first; most syscall records target files
+  // outside the monitored categories and are dropped here before any row
+  // field is constructed.
   switch (syscall_context.type) {
   case AuditdFimSyscallContext::Type::Symlink:
   case AuditdFimSyscallContext::Type::Rename:
   case AuditdFimSyscallContext::Type::Link: {
+    const auto& data =
+        boost::get<AuditdFimSrcDestData>(syscall_context.syscall_data);
+
+    if (!fim_context.included_paths.find(data.source) &&
+        !fim_context.included_paths.find(data.destination)) {
+      return false;
+    }
+
     if (syscall_context.type == AuditdFimSyscallContext::Type::Symlink) {
       row["operation"] = "symlink";
     } else if (syscall_context.type == AuditdFimSyscallContext::Type::Rename) {
@@ -270,9 +275,6 @@ bool EmitRowFromSyscallContext(
       row["operation"] = "link";
     }
 
-    const auto& data =
-        boost::get<AuditdFimSrcDestData>(syscall_context.syscall_data);
-
     row["path"] = data.source;
     row["dest_path"] = data.destination;
 
@@ -295,6 +297,10 @@ bool EmitRowFromSyscallContext(
       return false;
     }
 
+    if (!fim_context.included_paths.find(data.target)) {
+      return false;
+    }
+
     if (data.type == AuditdFimIOData::Type::Open) {
       row["operation"] = "open";
 
@@ -328,16 +334,6 @@ bool EmitRowFromSyscallContext(
   }
   }
 
-  // Filter the events
-  bool include_event = L_IsPathIncluded(row["path"]);
-  if (!include_event && row.find("dest_path") != row.end()) {
-    include_event = L_IsPathIncluded(row["dest_path"]);
-  }
-
-  if (!include_event) {
-    return false;
-  }
-
   if (!FLAGS_audit_fim_show_accesses && !is_write_operation) {
     return false;
   }
@@ -1147,21 +1143,14 @@ Status ProcessFileEventSubscriber::init() {
 }
 
 void ProcessFileEventSubscriber::configure() {
-  auto parser = Config::getParser("file_paths");
+  // Insert the configured patterns directly; the PathSet matches pattern
+  // components at event time, so the paths do not need to be resolved (and
+  // files created after this configuration load still match).
+  context_.included_paths.clear();
   Config::get().files([this](const std::string& category,
                              const std::vector<std::string>& files) {
-    for (auto file : files) {
-      replaceGlobWildcards(file);
-
-      StringList solved_path_list = {};
-      resolveFilePattern(file, solved_path_list);
-
-      context_.included_path_list.reserve(context_.included_path_list.size() +
-                                          solved_path_list.size());
-
-      context_.included_path_list.insert(context_.included_path_list.end(),
-                                         solved_path_list.begin(),
-                                         solved_path_list.end());
+    for (const auto& file : files) {
+      context_.included_paths.insert(file);
     }
   });
 }
@@ -1171,9 +1160,7 @@ Status ProcessFileEventSubscriber::Callback(const ECRef& event_context,
   std::vector<Row> emitted_row_list;
   auto exit_status =
       ProcessEvents(emitted_row_list, context_, event_context->audit_events);
-  for (Row& row : emitted_row_list) {
-    add(row);
-  }
+  addBatch(emitted_row_list);
 
   return exit_status;
 }
@@ -20,6 +20,7 @@
 #include <boost/variant.hpp>
 
 #include "osquery/events/linux/auditeventpublisher.h"
+#include "osquery/events/pathset.h"
 
 namespace osquery {
 /// An inode descriptor, containing the file (or folder) path
@@ -155,8 +156,15 @@ using StringList = std::vector<std::string>;
 
 /// The fim context contains configuration and process state
 struct AuditdFimContext final {
-  /// The paths included in the audit fim events
-  StringList included_path_list;
+  /**
+   * @brief The paths included in the audit fim events.
+   *
+   * Configured patterns are matched directly (including '%' and '%%'
+   * components), so files created after the configuration load are still
+   * tracked, and the per-event inclusion test is a set lookup instead of
+   * a scan over every resolved file.
+   */
+  PathSet<patternedPath> included_paths;
 
   /// The process map, containing an fd map for each process
   AuditdFimProcessMap process_map;
@@ -18,9 +18,12 @@
 #include <osquery/sql.h>
 
 #include "osquery/core/json.h"
+#include "osquery/tables/events/event_enrichment.h"
 #include "osquery/tables/events/event_utils.h"
 #include "osquery/tests/test_util.h"
 
+#include <osquery/filesystem.h>
+
 namespace osquery {
 
 DECLARE_bool(registry_exceptions);
@@ -65,6 +68,50 @@ TEST_F(FileEventsTableTests, test_subscriber_exists) {
 }
 #endif
 
+TEST_F(FileEventsTableTests, test_enrichment_cache) {
+  auto path = kTestWorkingDirectory + "enrichment-cache";
+  ASSERT_TRUE(writeTextFile(path, "first-contents").ok());
+  auto first = hashFileEventCached(path, "validity-1");
+  EXPECT_FALSE(first.sha256.empty());
+
+  // A rewrite with an unchanged validity token returns the cached digests.
+  ASSERT_TRUE(writeTextFile(path, "second-contents").ok());
+  auto cached = hashFileEventCached(path, "validity-1");
+  EXPECT_EQ(first.sha256, cached.sha256);
+
+  // A changed validity token forces a rehash and replaces the entry.
+  auto rehashed = hashFileEventCached(path, "validity-2");
+  EXPECT_NE(first.sha256, rehashed.sha256);
+
+  // Invalidation drops the entry, the next request rereads the file.
+  ASSERT_TRUE(writeTextFile(path, "third-contents").ok());
+  invalidateFileEnrichment(path);
+  auto reread = hashFileEventCached(path, "validity-2");
+  EXPECT_NE(rehashed.sha256, reread.sha256);
+
+  removePath(path);
+}
+
+TEST_F(FileEventsTableTests, test_no_change_suppression) {
+  auto path = kTestWorkingDirectory + "fim-suppress";
+
+  // A first observation of a state token always reports a change.
+  EXPECT_TRUE(fileEventStateChanged(path, "inode:1:100"));
+  // Repeating the same token is a no-change event.
+  EXPECT_FALSE(fileEventStateChanged(path, "inode:1:100"));
+  // Any component changing reports again.
+  EXPECT_TRUE(fileEventStateChanged(path, "inode:2:100"));
+
+  // Invalidation (delete, move) forgets the recorded state.
+  invalidateFileEnrichment(path);
+  EXPECT_TRUE(fileEventStateChanged(path, "inode:2:100"));
+
+  // An empty token (a failed stat) never suppresses.
+  EXPECT_TRUE(fileEventStateChanged(path, ""));
+  EXPECT_TRUE(fileEventStateChanged(path, ""));
+  invalidateFileEnrichment(path);
+}
+
 TEST_F(FileEventsTableTests, test_table_empty) {
   // Attach/create the publishers.
   attachEvents();
@@ -8,10 +8,13 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <atomic>
 #include <chrono>
+#include <thread>
 
 #include <boost/numeric/conversion/cast.hpp>
 
+#include <osquery/flags.h>
 #include <osquery/logger.h>
 #include <osquery/status.h>
 #include <osquery/tables.h>
@@ -19,13 +22,18 @@
 #include "osquery/remote/http_client.h"
 
 namespace osquery {
+
+FLAG(uint64,
+     curl_max_parallel,
+     6,
+     "Maximum concurrent fetches performed by the curl table");
+
 namespace tables {
 
 const std::string kOsqueryUserAgent{"osquery"};
 
-Status processRequest(Row& r) {
+Status processRequest(osquery::http::Client& client, Row& r) {
   try {
-    osquery::http::Client client_;
     osquery::http::Response response_;
     osquery::http::Request request_(r["url"]);
 
@@ -35,7 +43,7 @@ Status processRequest(Row& r) {
     // Measure the rtt using the system clock
     std::chrono::time_point<std::chrono::system_clock> start =
         std::chrono::system_clock::now();
-    response_ = client_.get(request_);
+    response_ = client.get(request_);
     std::chrono::time_point<std::chrono::system_clock> end =
         std::chrono::system_clock::now();
 
@@ -74,13 +82,45 @@ QueryData genCurl(QueryContext& context) {
     r["method"] = "GET";
     r["user_agent"] =
         user_agents.empty() ? kOsqueryUserAgent : *(user_agents.begin());
+    results.push_back(std::move(r));
+  }
 
-    auto status = processRequest(r);
-    if (!status.ok()) {
-      LOG(WARNING) << status.getMessage();
-    }
+  if (results.empty()) {
+    return results;
+  }
 
-    results.push_back(r);
+  // Fan the fetches out over a bounded set of workers so N constraints cost
+  // one overlapped wave of round trips instead of N sequential handshakes.
+  // Each worker keeps one client with keep-alive, reusing its connection
+  // across consecutive URLs to the same endpoint.
+  auto worker_count = static_cast<size_t>(FLAGS_curl_max_parallel);
+  if (worker_count < 1) {
+    worker_count = 1;
+  }
+  if (worker_count > results.size()) {
+    worker_count = results.size();
+  }
+
+  std::atomic<size_t> cursor{0};
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < worker_count; i++) {
+    workers.emplace_back([&results, &cursor]() {
+      osquery::http::Client client(
+          osquery::http::Client::Options().keep_alive(true));
+      while (true) {
+        auto index = cursor.fetch_add(1);
+        if (index >= results.size()) {
+          break;
+        }
+        auto status = processRequest(client, results[index]);
+        if (!status.ok()) {
+          LOG(WARNING) << status.getMessage();
+        }
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
   }
 
   return results;
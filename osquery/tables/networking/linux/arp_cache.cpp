@@ -17,6 +17,8 @@
 #include <osquery/filesystem.h>
 #include <osquery/logger.h>
 
+#include "osquery/tables/networking/linux/netlink_cache.h"
+
 namespace osquery {
 namespace tables {
 
@@ -25,6 +27,12 @@ const std::string kLinuxArpTable = "/proc/net/arp";
 QueryData genArpCache(QueryContext& context) {
   QueryData results;
 
+  // Neighbor state transitions are published over rtnetlink, so the previous
+  // parse can be served while no change notifications arrive.
+  if (serveNetlinkCache("arp_cache", results)) {
+    return results;
+  }
+
   boost::filesystem::path arp_path = kLinuxArpTable;
   if (!osquery::isReadable(arp_path).ok()) {
     VLOG(1) << "Cannot read arp table";
@@ -73,6 +81,7 @@ QueryData genArpCache(QueryContext& context) {
     results.push_back(r);
   }
 
+  storeNetlinkCache("arp_cache", results);
   return results;
 }
 }
@@ -0,0 +1,134 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#include <map>
+
+#include <osquery/logger.h>
+#include <osquery/mutex.h>
+
+#include "osquery/tables/networking/linux/netlink_cache.h"
+
+namespace osquery {
+namespace tables {
+
+/// Per-table cached rows, keyed by the change generation they were built at.
+struct NetlinkCacheEntry {
+  /// The value of kNetlinkGeneration when the rows were stored.
+  size_t generation{0};
+
+  /// The rows served while no change notifications arrive.
+  QueryData rows;
+};
+
+/// Serializes monitor socket access and cache reads/writes.
+static Mutex kNetlinkCacheMutex;
+
+/// Cached rows for each subscribed table.
+static std::map<std::string, NetlinkCacheEntry> kNetlinkCache;
+
+/// Incremented whenever a change notification (or overflow) is drained.
+static size_t kNetlinkGeneration{1};
+
+/// The lazily opened rtnetlink multicast monitor socket.
+static int kNetlinkMonitorFd{-1};
+
+/// Set if the monitor could not be created, disabling the cache.
+static bool kNetlinkMonitorFailed{false};
+
+/// Open (once) and drain the rtnetlink change monitor, callers hold the lock.
+static void drainNetlinkEvents() {
+  if (kNetlinkMonitorFailed) {
+    return;
+  }
+
+  if (kNetlinkMonitorFd < 0) {
+    int fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK, NETLINK_ROUTE);
+    if (fd < 0) {
+      VLOG(1) << "Cannot open NETLINK monitor socket";
+      kNetlinkMonitorFailed = true;
+      return;
+    }
+
+    struct sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK | RTMGRP_NEIGH | RTMGRP_IPV4_IFADDR |
+                     RTMGRP_IPV6_IFADDR | RTMGRP_IPV4_ROUTE |
+                     RTMGRP_IPV6_ROUTE;
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+      VLOG(1) << "Cannot subscribe to NETLINK multicast groups";
+      close(fd);
+      kNetlinkMonitorFailed = true;
+      return;
+    }
+    kNetlinkMonitorFd = fd;
+    // The first open cannot vouch for prior state, entries start invalid.
+    return;
+  }
+
+  // The notification content does not matter, any message (or an overflowed
+  // receive queue) means the cached models may be stale.
+  bool changed = false;
+  char buffer[4096];
+  while (true) {
+    auto bytes = recv(kNetlinkMonitorFd, buffer, sizeof(buffer), MSG_DONTWAIT);
+    if (bytes > 0 || (bytes < 0 && errno == ENOBUFS)) {
+      changed = true;
+      continue;
+    }
+    break;
+  }
+
+  if (changed) {
+    kNetlinkGeneration++;
+  }
+}
+
+bool serveNetlinkCache(const std::string& table, QueryData& results) {
+  WriteLock lock(kNetlinkCacheMutex);
+
+  drainNetlinkEvents();
+  if (kNetlinkMonitorFd < 0) {
+    return false;
+  }
+
+  auto it = kNetlinkCache.find(table);
+  if (it == kNetlinkCache.end() ||
+      it->second.generation != kNetlinkGeneration) {
+    return false;
+  }
+
+  results = it->second.rows;
+  return true;
+}
+
+void storeNetlinkCache(const std::string& table, const QueryData& results) {
+  WriteLock lock(kNetlinkCacheMutex);
+
+  if (kNetlinkMonitorFd < 0) {
+    return;
+  }
+
+  // A notification racing the rebuild is still queued on the monitor, so the
+  // next serve attempt will observe a new generation and rebuild again.
+  auto& entry = kNetlinkCache[table];
+  entry.generation = kNetlinkGeneration;
+  entry.rows = results;
+}
+}
+}
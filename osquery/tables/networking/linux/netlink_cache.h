@@ -0,0 +1,46 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#pragma once
+
+#include <string>
+
+#include <osquery/tables.h>
+
+namespace osquery {
+namespace tables {
+
+/**
+ * @brief Serve a networking table's cached rows if nothing changed.
+ *
+ * A single process-wide NETLINK_ROUTE socket subscribes to the rtnetlink
+ * link, address, neighbor, and route multicast groups. Each call drains any
+ * pending change notifications; if none arrived since the named table last
+ * rebuilt, the cached rows are copied into the output and the table can skip
+ * its kernel dump or /proc parse entirely.
+ *
+ * If the monitor socket cannot be opened (or its receive queue overflows)
+ * the cache is considered invalid and tables fall back to a full rebuild.
+ *
+ * @param table A unique cache key, usually the table name.
+ * @param results The output rows, only filled when true is returned.
+ * @return True if cached rows were served.
+ */
+bool serveNetlinkCache(const std::string& table, QueryData& results);
+
+/**
+ * @brief Store a table's freshly generated rows against the change monitor.
+ *
+ * Only call after a complete, successful rebuild; partial results from error
+ * paths must not be cached.
+ */
+void storeNetlinkCache(const std::string& table, const QueryData& results);
+}
+}
@@ -35,13 +35,16 @@ QueryData genOpenSockets(QueryContext& context) {
   bool pid_filter = !(pids.empty() ||
                       std::find(pids.begin(), pids.end(), "-1") != pids.end());
 
-  if (!pid_filter) {
-    pids.clear();
+  pids.clear();
+  if (pid_filter) {
+    // Only the constrained pids are checked against procfs and inspected.
+    status = osquery::procProcesses(context, pids);
+  } else {
     status = osquery::procProcesses(pids);
-    if (!status.ok()) {
-      VLOG(1) << "Failed to acquire pid list: " << status.what();
-      return results;
-    }
+  }
+  if (!status.ok()) {
+    VLOG(1) << "Failed to acquire pid list: " << status.what();
+    return results;
   }
 
   /* Data for this table is fetched from 3 different sources and correlated.
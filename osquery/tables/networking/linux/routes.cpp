@@ -19,6 +19,7 @@
 #include <osquery/logger.h>
 #include <osquery/tables.h>
 
+#include "osquery/tables/networking/linux/netlink_cache.h"
 #include "osquery/tables/networking/utils.h"
 
 namespace osquery {
@@ -168,6 +169,11 @@ void genNetlinkRoutes(const struct nlmsghdr* netlink_msg, QueryData& results) {
 QueryData genRoutes(QueryContext& context) {
   QueryData results;
 
+  // Serve the previous dump if no route/link/address changes were published.
+  if (serveNetlinkCache("routes", results)) {
+    return results;
+  }
+
   int socket_fd = socket(PF_NETLINK, SOCK_DGRAM, NETLINK_ROUTE);
   if (socket_fd < 0) {
     VLOG(1) << "Cannot open NETLINK socket";
@@ -214,6 +220,8 @@ QueryData genRoutes(QueryContext& context) {
 
   close(socket_fd);
   free(netlink_buffer);
+
+  storeNetlinkCache("routes", results);
   return results;
 }
 }
@@ -28,6 +28,14 @@ namespace fs = boost::filesystem;
 namespace osquery {
 namespace tables {
 
+/**
+ * @brief The chunk size used when reading file content for hashing.
+ *
+ * Each read is a sequential pass over the image; large chunks amortize the
+ * per-call overhead of libtsk block resolution and device reads.
+ */
+const ssize_t kHashChunkSize{1024 * 1024};
+
 const std::map<TSK_FS_META_TYPE_ENUM, std::string> kTSKTypeNames{
     {TSK_FS_META_TYPE_REG, "regular"},
     {TSK_FS_META_TYPE_DIR, "directory"},
@@ -258,7 +266,7 @@ void DeviceHelper::generateFiles(const std::string& partition,
 
   // If we are recursing.
   for (const auto& d : additional) {
-    if (std::find(loops_.begin(), loops_.end(), d.second) == loops_.end()) {
+    if (loops_.count(d.second) == 0) {
       generateFiles(partition, fs, d.second, results, d.first);
       loops_.insert(d.second);
     }
@@ -276,7 +284,7 @@ MultiHashes hashInode(TskFsFile* file) {
     return MultiHashes();
   }
 
-  // Set a maximum 'chunk' or block size to 1 page or the file size.
+  // Set a maximum 'chunk' size to the read-ahead size or the file size.
   TSK_OFF_T size = meta->getSize();
   if (size == 0) {
     delete meta;
@@ -284,7 +292,7 @@ MultiHashes hashInode(TskFsFile* file) {
   }
 
   // Allocate some heap memory and iterate over reading a chunk and updating.
-  auto buffer_size = (size < 4096) ? size : 4096;
+  auto buffer_size = (size < kHashChunkSize) ? size : kHashChunkSize;
   auto* buffer = (char*)malloc(buffer_size * sizeof(char));
   if (buffer != nullptr) {
     ssize_t chunk_size = 0;
@@ -109,25 +109,38 @@ struct proc_cred {
   } real, effective, saved;
 };
 
+static void copyProcCred(const struct proc_bsdinfo& bsdinfo, proc_cred& cred) {
+  cred.parent = bsdinfo.pbi_ppid;
+  cred.group = bsdinfo.pbi_pgid;
+  cred.status = bsdinfo.pbi_status;
+  cred.nice = bsdinfo.pbi_nice;
+  cred.real.uid = bsdinfo.pbi_ruid;
+  cred.real.gid = bsdinfo.pbi_rgid;
+  cred.effective.uid = bsdinfo.pbi_uid;
+  cred.effective.gid = bsdinfo.pbi_gid;
+  cred.saved.uid = bsdinfo.pbi_svuid;
+  cred.saved.gid = bsdinfo.pbi_svgid;
+}
+
 inline bool genProcCred(QueryContext& context,
                         int pid,
                         proc_cred& cred,
                         Row& r) {
+  struct proc_taskallinfo all_info;
   struct proc_bsdinfo bsdinfo;
   struct proc_bsdshortinfo bsdinfo_short;
 
-  if (proc_pidinfo(pid, PROC_PIDTBSDINFO, 1, &bsdinfo, PROC_PIDTBSDINFO_SIZE) ==
-      PROC_PIDTBSDINFO_SIZE) {
-    cred.parent = bsdinfo.pbi_ppid;
-    cred.group = bsdinfo.pbi_pgid;
-    cred.status = bsdinfo.pbi_status;
-    cred.nice = bsdinfo.pbi_nice;
-    cred.real.uid = bsdinfo.pbi_ruid;
-    cred.real.gid = bsdinfo.pbi_rgid;
-    cred.effective.uid = bsdinfo.pbi_uid;
-    cred.effective.gid = bsdinfo.pbi_gid;
-    cred.saved.uid = bsdinfo.pbi_svuid;
-    cred.saved.gid = bsdinfo.pbi_svgid;
+  if (context.isColumnUsed("threads") &&
+      proc_pidinfo(pid, PROC_PIDTASKALLINFO, 0, &all_info, sizeof(all_info)) ==
+          static_cast<int>(sizeof(all_info))) {
+    // One batched call covers both the BSD info and the task (thread) info,
+    // halving the proc_pidinfo count when the threads column is projected.
+    copyProcCred(all_info.pbsd, cred);
+    r["threads"] = INTEGER(all_info.ptinfo.pti_threadnum);
+  } else if (proc_pidinfo(
+                 pid, PROC_PIDTBSDINFO, 1, &bsdinfo, PROC_PIDTBSDINFO_SIZE) ==
+             PROC_PIDTBSDINFO_SIZE) {
+    copyProcCred(bsdinfo, cred);
   } else if (proc_pidinfo(pid,
                           PROC_PIDT_SHORTBSDINFO,
                           1,
@@ -252,7 +265,8 @@ void genProcNamePathAndOnDisk(const QueryContext& context,
 }
 
 void genProcNumThreads(QueryContext& context, int pid, Row& r) {
-  if (!context.isColumnUsed("threads")) {
+  if (!context.isColumnUsed("threads") || r.count("threads") > 0) {
+    // The batched task-all-info call may have filled the column already.
     return;
   }
 
@@ -271,10 +285,14 @@ struct proc_args {
   std::map<std::string, std::string> env;
 };
 
-proc_args getProcRawArgs(int pid, size_t argmax) {
+proc_args getProcRawArgs(int pid, size_t argmax, std::vector<char>& procbuf) {
   proc_args args;
-  std::unique_ptr<char[]> pprocargs{new char[argmax]};
-  char* procargs = pprocargs.get();
+  // The KERN_PROCARGS2 buffer is argmax (often 256K) bytes; the caller owns
+  // it so a table scan reuses one allocation across every pid.
+  if (procbuf.size() < argmax) {
+    procbuf.resize(argmax);
+  }
+  char* procargs = procbuf.data();
   int mib[3] = {CTL_KERN, KERN_PROCARGS2, pid};
   if (sysctl(mib, 3, procargs, &argmax, nullptr, 0) == -1 || argmax == 0) {
     return args;
@@ -314,14 +332,17 @@ proc_args getProcRawArgs(int pid, size_t argmax) {
   return args;
 }
 
-void genProcCmdline(const QueryContext& context, int pid, Row& r) {
+void genProcCmdline(const QueryContext& context,
+                    int pid,
+                    std::vector<char>& procbuf,
+                    Row& r) {
   if (!context.isColumnUsed("cmdline")) {
     return;
   }
 
   int argmax = genMaxArgs();
   // The command line invocation including arguments.
-  auto args = getProcRawArgs(pid, argmax);
+  auto args = getProcRawArgs(pid, argmax, procbuf);
   std::string cmdline = boost::algorithm::join(args.args, " ");
   r["cmdline"] = cmdline;
 }
@@ -420,11 +441,12 @@ QueryData genProcesses(QueryContext& context) {
   QueryData results;
 
   auto pidlist = getProcList(context);
+  std::vector<char> procbuf;
   for (const auto& pid : pidlist) {
     Row r;
     context.setIntegerColumnIfUsed(r, "pid", pid);
 
-    genProcCmdline(context, pid, r);
+    genProcCmdline(context, pid, procbuf, r);
 
     // The process relative root and current working directory.
     genProcRootAndCWD(context, pid, r);
@@ -452,8 +474,9 @@ QueryData genProcessEnvs(QueryContext& context) {
 
   auto pidlist = getProcList(context);
   int argmax = genMaxArgs();
+  std::vector<char> procbuf;
   for (const auto& pid : pidlist) {
-    auto args = getProcRawArgs(pid, argmax);
+    auto args = getProcRawArgs(pid, argmax, procbuf);
     for (const auto& env : args.env) {
       Row r;
       r["pid"] = INTEGER(pid);
@@ -117,7 +117,8 @@ QueryData genMemoryDevices(QueryContext& context) {
     return results;
   }
 
-  parser.tables([&results](size_t index,
+  parser.tables(kSMBIOSTypeMemoryDevice,
+                [&results](size_t index,
                            const SMBStructHeader* hdr,
                            uint8_t* address,
                            uint8_t* textAddrs,
@@ -136,7 +137,8 @@ QueryData genMemoryArrays(QueryContext& context) {
     return results;
   }
 
-  parser.tables([&results](size_t index,
+  parser.tables(kSMBIOSTypeMemoryArray,
+                [&results](size_t index,
                            const SMBStructHeader* hdr,
                            uint8_t* address,
                            uint8_t* textAddrs,
@@ -155,7 +157,8 @@ QueryData genMemoryArrayMappedAddresses(QueryContext& context) {
     return results;
   }
 
-  parser.tables([&results](size_t index,
+  parser.tables(kSMBIOSTypeMemoryArrayMappedAddress,
+                [&results](size_t index,
                            const SMBStructHeader* hdr,
                            uint8_t* address,
                            uint8_t* textAddrs,
@@ -174,7 +177,8 @@ QueryData genMemoryErrorInfo(QueryContext& context) {
     return results;
   }
 
-  parser.tables([&results](size_t index,
+  parser.tables(kSMBIOSTypeMemoryErrorInformation,
+                [&results](size_t index,
                            const SMBStructHeader* hdr,
                            uint8_t* address,
                            uint8_t* textAddrs,
@@ -193,7 +197,8 @@ QueryData genMemoryDeviceMappedAddresses(QueryContext& context) {
     return results;
   }
 
-  parser.tables([&results](size_t index,
+  parser.tables(kSMBIOSTypeMemoryDeviceMappedAddress,
+                [&results](size_t index,
                            const SMBStructHeader* hdr,
                            uint8_t* address,
                            uint8_t* textAddrs,
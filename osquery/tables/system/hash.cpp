@@ -8,17 +8,10 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
-// clang-format off
-#include <sys/types.h>
-#include <sys/stat.h>
-// clang-format on
-
-#ifndef WIN32
-#include <unistd.h>
-#endif
-
 #include <set>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #include <boost/filesystem.hpp>
 
@@ -31,12 +24,8 @@
 
 namespace osquery {
 
-FLAG(bool,
-     disable_hash_cache,
-     false,
-     "Cache calculated file hashes, re-calculate only if inode times change");
-
-FLAG(uint32, hash_cache_max, 500, "Size of LRU file hash cache");
+DECLARE_bool(disable_hash_cache);
+DECLARE_uint32(file_walk_threads);
 
 HIDDEN_FLAG(uint32,
             hash_delay,
@@ -45,160 +34,34 @@ HIDDEN_FLAG(uint32,
 
 namespace tables {
 
-/// Clear this amount of rows every time cache eviction is triggered.
-const size_t kHashCacheEvictSize{5};
-
-/**
- * @brief Implements persistent in-memory caching of files' hashes.
- *
- * This cache has LRU eviction policy. The hash is recalculated
- * every time the mtime or size of the file changes.
- */
-struct FileHashCache {
-  /// The file's modification time, changes with a touch.
-  time_t file_mtime;
-
-  /// The file's serial or information number (inode).
-  ino_t file_inode;
-
-  /// The file's size.
-  off_t file_size;
-
-  /// For eviction, the last time this cache item was used.
-  time_t cache_access_time;
-
-  /// Cache content, the hashes.
-  MultiHashes hashes;
-
-  /// Cache index, the file path.
-  std::string path;
-
-  /// Comparison function for organizing the LRU heap.
-  static bool greater(const FileHashCache* l, const FileHashCache* r) {
-    return l->cache_access_time > r->cache_access_time;
-  }
-
-  /**
-   * @brief Do-it-all access function.
-   *
-   * Maintains the cache of hash sums, stats file at path, if it has changed or
-   * it is not present in cache calculates the hashes and caches the result.
-   *
-   * @param path the path of file to hash.
-   * @param out stores the calculated hashes.
-   *
-   * @return true if succeeded, false if something went wrong.
-   */
-  static bool load(const std::string& path, MultiHashes& out);
-};
-
-#if defined(WIN32)
-
-#define stat _stat
-#define strerror_r(e, buf, sz) strerror_s((buf), (sz), (e))
-
-#endif
-
-/**
- * @brief Checks the current stat output against the cached view.
- *
- * If the modified/altered time or the file's inode has changed then the hash
- * should be recalculated.
- */
-static inline bool statInvalid(const struct stat& st, const FileHashCache& fh) {
-  if (st.st_ino != fh.file_inode || st.st_mtime != fh.file_mtime) {
-    // Most plausible case for modification detection.
-    return true;
-  }
-
-  if (st.st_size != fh.file_size) {
-    // Just in case there's tomfoolery.
-    return true;
-  }
-  return false;
-}
-
-bool FileHashCache::load(const std::string& path, MultiHashes& out) {
-  // synchronize the access to cache
-  static Mutex mx;
-  // path => cache entry
-  static std::unordered_map<std::string, FileHashCache> cache;
-  // minheap on cache_access_time
-  static std::vector<FileHashCache*> lru;
-
-  WriteLock guard(mx);
-
-  struct stat st;
-  if (stat(path.c_str(), &st) != 0) {
-    char buf[0x200] = {0};
-    strerror_r(errno, buf, sizeof(buf));
-    LOG(WARNING) << "Cannot stat file: " << path << ": " << buf;
-    return false;
-  }
-
-  auto entry = cache.find(path);
-  if (entry == cache.end()) { // none, load
-    if (cache.size() >= FLAGS_hash_cache_max) {
-      // too large, evict
-      for (size_t i = 0; i < kHashCacheEvictSize; ++i) {
-        if (lru.empty()) {
-          continue;
-        }
-        std::string key = lru[0]->path;
-        std::pop_heap(lru.begin(), lru.end(), FileHashCache::greater);
-        lru.pop_back();
-        if (cache.find(key) != cache.end()) {
-          cache.erase(key);
-        }
-      }
-    }
-
-    auto hashes = hashMultiFromFile(
-        HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256, path);
-    FileHashCache rec = {st.st_mtime, // .file_mtime
-                         st.st_ino, // .file_inode
-                         st.st_size, // .file_size
-                         time(nullptr), // .cache_access_time
-                         std::move(hashes), // .hashes
-                         path}; // .path
-    cache[path] = std::move(rec);
-    lru.push_back(&cache[path]);
-    std::push_heap(lru.begin(), lru.end(), FileHashCache::greater);
-    out = cache[path].hashes;
-  } else if (statInvalid(st, entry->second)) { // changed, update
-    auto hashes = hashMultiFromFile(
-        HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256, path);
-    entry->second.cache_access_time = time(nullptr);
-    entry->second.file_mtime = st.st_mtime;
-    entry->second.file_size = st.st_size;
-    entry->second.hashes = std::move(hashes);
-    std::make_heap(lru.begin(), lru.end(), FileHashCache::greater);
-    out = entry->second.hashes;
-  } else { // ok, got it
-    out = entry->second.hashes;
-    entry->second.cache_access_time = time(nullptr);
-    std::make_heap(lru.begin(), lru.end(), FileHashCache::greater);
-  }
-  return true;
-}
+/// Guards the inner-query row cache shared between walker threads.
+static Mutex innerCacheMutex;
 
 void genHashForFile(const std::string& path,
                     const std::string& dir,
                     QueryContext& context,
-                    QueryData& results) {
+                    Row& r) {
   // Must provide the path, filename, directory separate from boost path->string
   // helpers to match any explicit (query-parsed) predicate constraints.
-  Row r;
-
   MultiHashes hashes;
   if (!FLAGS_disable_hash_cache) {
-    FileHashCache::load(path, hashes);
+    // The process-wide cache also coalesces concurrent walkers hashing the
+    // same file into one read+digest pass.
+    hashes = hashMultiFromFileCached(
+        HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256, path);
   } else {
-    if (context.isCached(path)) {
-      // Use the inner-query cache if the global hash cache is disabled.
-      // This protects against hashing the same content twice in the same query.
-      r = context.getCache(path);
-    } else {
+    auto cached = false;
+    {
+      WriteLock guard(innerCacheMutex);
+      if (context.isCached(path)) {
+        // Use the inner-query cache if the global hash cache is disabled.
+        // This protects against hashing the same content twice in the same
+        // query.
+        r = context.getCache(path);
+        cached = true;
+      }
+    }
+    if (!cached) {
       hashes = hashMultiFromFile(
           HASH_TYPE_MD5 | HASH_TYPE_SHA1 | HASH_TYPE_SHA256, path);
       std::this_thread::sleep_for(std::chrono::milliseconds(FLAGS_hash_delay));
@@ -211,14 +74,12 @@ void genHashForFile(const std::string& path,
   r["sha1"] = std::move(hashes.sha1);
   r["sha256"] = std::move(hashes.sha256);
   if (FLAGS_disable_hash_cache) {
+    WriteLock guard(innerCacheMutex);
     context.setCache(path, r);
   }
-
-  results.push_back(r);
 }
 
 QueryData genHash(QueryContext& context) {
-  QueryData results;
   boost::system::error_code ec;
 
   // The query must provide a predicate with constraints including path or
@@ -241,14 +102,16 @@ QueryData genHash(QueryContext& context) {
         return status;
       }));
 
-  // Iterate through the file paths, adding the hash results
+  // Collect the (path, directory) work units, hashed later in parallel.
+  std::vector<std::pair<std::string, std::string>> targets;
   for (const auto& path_string : paths) {
     boost::filesystem::path path = path_string;
     if (!boost::filesystem::is_regular_file(path, ec)) {
       continue;
     }
 
-    genHashForFile(path_string, path.parent_path().string(), context, results);
+    targets.push_back(
+        std::make_pair(path_string, path.parent_path().string()));
   }
 
   // Now loop through constraints using the directory column constraint.
@@ -271,22 +134,43 @@ QueryData genHash(QueryContext& context) {
 
   // Iterate over the directory paths
   for (const auto& directory_string : directories) {
+    if (context.isCancelled()) {
+      break;
+    }
+
     boost::filesystem::path directory = directory_string;
     if (!boost::filesystem::is_directory(directory, ec)) {
       continue;
     }
 
-    // Iterate over the directory files and generate a hash for each regular
-    // file.
+    // Iterate over the directory files and queue each regular file.
     boost::filesystem::directory_iterator begin(directory), end;
     for (; begin != end; ++begin) {
       if (boost::filesystem::is_regular_file(begin->path(), ec)) {
-        genHashForFile(
-            begin->path().string(), directory_string, context, results);
+        targets.push_back(
+            std::make_pair(begin->path().string(), directory_string));
       }
     }
   }
 
+  // Hash the targets on the bounded walker pool. Each unit owns one
+  // preallocated row slot, so emission needs no synchronization and the
+  // completion order does not matter.
+  // Before digesting a unit, each worker prefetches one a window ahead,
+  // keeping a bounded set of kernel reads in flight under the hashing.
+  size_t lookahead = FLAGS_file_walk_threads * 2;
+  QueryData results(targets.size());
+  parallelFileWalk(targets.size(), [&](size_t i) {
+    if (context.isCancelled()) {
+      // The scan deadline passed, skip the remaining hash targets.
+      return;
+    }
+    if (lookahead > 0 && i + lookahead < targets.size()) {
+      prefetchFile(targets[i + lookahead].first);
+    }
+    genHashForFile(targets[i].first, targets[i].second, context, results[i]);
+  });
+
   return results;
 }
 } // namespace tables
@@ -18,10 +18,13 @@ extern "C" {
 #include <dpkg/parsedump.h>
 }
 
+#include <sys/stat.h>
+
 #include <boost/algorithm/string.hpp>
 
 #include <osquery/filesystem.h>
 #include <osquery/logger.h>
+#include <osquery/mutex.h>
 #include <osquery/system.h>
 #include <osquery/tables.h>
 
@@ -30,6 +33,32 @@ namespace tables {
 
 static const std::string kDPKGPath{"/var/lib/dpkg"};
 
+namespace {
+/// Rows from the last full parse, valid while the status database identity
+/// token is unchanged.
+QueryData debSnapshot;
+
+/// Identity token of the status database behind debSnapshot.
+std::string debSnapshotToken;
+
+/// Guards debSnapshot and debSnapshotToken.
+Mutex debSnapshotMutex;
+} // namespace
+
+/**
+ * @brief Identity token for the dpkg status database.
+ *
+ * The status file is rewritten by every package operation, so its mtime and
+ * size key a snapshot of generated rows. An empty token disables caching.
+ */
+static std::string getDpkgDbToken() {
+  struct stat st;
+  if (stat((kDPKGPath + "/status").c_str(), &st) != 0) {
+    return "";
+  }
+  return std::to_string(st.st_mtime) + ':' + std::to_string(st.st_size);
+}
+
 /// A comparator used to sort the packages array.
 int pkg_sorter(const void *a, const void *b) {
   const struct pkginfo *pa = *(const struct pkginfo **)a;
@@ -162,6 +191,15 @@ QueryData genDebPackages(QueryContext &context) {
     return results;
   }
 
+  auto token = getDpkgDbToken();
+  if (!token.empty()) {
+    WriteLock lock(debSnapshotMutex);
+    if (token == debSnapshotToken) {
+      // The database has not changed since the last full parse.
+      return debSnapshot;
+    }
+  }
+
   auto dropper = DropPrivileges::get();
   dropper->dropTo("nobody");
 
@@ -181,6 +219,12 @@ QueryData genDebPackages(QueryContext &context) {
   }
 
   dpkg_teardown(&packages);
+
+  if (!token.empty()) {
+    WriteLock lock(debSnapshotMutex);
+    debSnapshot = results;
+    debSnapshotToken = token;
+  }
   return results;
 }
 }
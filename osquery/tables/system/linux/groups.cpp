@@ -16,6 +16,8 @@
 #include <osquery/core.h>
 #include <osquery/tables.h>
 
+#include "osquery/tables/system/posix/user_group_cache.h"
+
 namespace osquery {
 namespace tables {
 
@@ -29,11 +31,13 @@ QueryData genGroups(QueryContext& context) {
     auto gids = context.constraints["gid"].getAll<long long>(EQUALS);
     for (const auto& gid : gids) {
       Row r;
-      grp = getgrgid(gid);
       r["gid"] = BIGINT(gid);
-      if (grp != nullptr) {
-        r["gid_signed"] = INTEGER((int32_t)grp->gr_gid);
-        r["groupname"] = TEXT(grp->gr_name);
+      // Resolve through the process-wide cache instead of a getgrgid round
+      // trip per constraint.
+      std::string groupname;
+      if (getCachedGroupname(gid, groupname)) {
+        r["gid_signed"] = INTEGER((int32_t)gid);
+        r["groupname"] = TEXT(groupname);
       }
       results.push_back(r);
     }
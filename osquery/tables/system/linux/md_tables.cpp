@@ -28,6 +28,8 @@
 #include <osquery/core/conversions.h>
 #include <osquery/filesystem.h>
 #include <osquery/logger.h>
+#include <osquery/mutex.h>
+#include <osquery/system.h>
 
 #include "osquery/events/linux/udev.h"
 #include "osquery/tables/system/linux/md_tables.h"
@@ -53,16 +55,17 @@ static inline void trimStrs(std::vector<std::string>& strs) {
  * @brief reads mdstat file and parses as vector of lines
  *
  * @param lines reference to vector of strings to store lines in
+ * @param content reference to store the raw file content in
  *
  * Trims all white space in lines and ignores empty lines (i.e. only spaces,
  * tabs, etc.)
  */
-static inline void getLines(std::vector<std::string>& lines) {
+static inline void getLines(std::vector<std::string>& lines,
+                            std::string& content) {
   if (!pathExists(kMDStatPath).ok()) {
     return;
   }
 
-  std::string content;
   if (!readFile(kMDStatPath, content).ok()) {
     return;
   }
@@ -71,6 +74,52 @@ static inline void getLines(std::vector<std::string>& lines) {
   trimStrs(lines);
 }
 
+/// Seconds a cached md table result may serve before a forced rebuild.
+const size_t kMDCacheTTL = 60;
+
+/**
+ * @brief Cached rows for one md table, keyed by the raw mdstat content.
+ *
+ * Walking the sysfs block hierarchy and issuing the per-array ioctls costs
+ * hundreds of milliseconds on wide arrays. The mdstat content doubles as a
+ * cheap change token: array state transitions, failed or removed drives,
+ * and recovery/resync/reshape progress all rewrite it, so identical content
+ * means the expensive model is still current. The TTL bounds staleness for
+ * superblock-only changes that do not surface in mdstat.
+ */
+struct MDTableCache {
+  std::string token;
+  size_t refreshed{0};
+  QueryData rows;
+};
+
+static Mutex kMDCacheMutex;
+static MDTableCache kMDDrivesCache;
+static MDTableCache kMDDevicesCache;
+
+/// Serve a table's cached rows when the mdstat token is still current.
+static bool serveMDCache(MDTableCache& cache,
+                         const std::string& content,
+                         QueryData& results) {
+  WriteLock lock(kMDCacheMutex);
+  if (cache.refreshed > 0 && cache.token == content &&
+      getUnixTime() < cache.refreshed + kMDCacheTTL) {
+    results = cache.rows;
+    return true;
+  }
+  return false;
+}
+
+/// Replace a table's cached rows after a full rebuild.
+static void storeMDCache(MDTableCache& cache,
+                         const std::string& content,
+                         const QueryData& results) {
+  WriteLock lock(kMDCacheMutex);
+  cache.token = content;
+  cache.refreshed = getUnixTime();
+  cache.rows = results;
+}
+
 /**
  * @brief function for walking thru a udev subsystem and working on devices
  *
@@ -676,28 +725,38 @@ void getDrivesForArray(const std::string& arrayName,
 
 QueryData genMDDrives(QueryContext& context) {
   QueryData results;
-  MDStat mds;
-  MD md;
   std::vector<std::string> lines;
-  getLines(lines);
+  std::string content;
+  getLines(lines, content);
+
+  if (serveMDCache(kMDDrivesCache, content, results)) {
+    return results;
+  }
 
+  MDStat mds;
+  MD md;
   md.parseMDStat(lines, mds);
 
   for (const auto& device : mds.devices) {
     getDrivesForArray(device.name, md, results);
   }
 
+  storeMDCache(kMDDrivesCache, content, results);
   return results;
 }
 
 QueryData genMDDevices(QueryContext& context) {
   QueryData results;
-  MDStat mds;
-  MD md;
   std::vector<std::string> lines;
+  std::string content;
+  getLines(lines, content);
 
-  getLines(lines);
+  if (serveMDCache(kMDDevicesCache, content, results)) {
+    return results;
+  }
 
+  MDStat mds;
+  MD md;
   md.parseMDStat(lines, mds);
   for (const auto& device : mds.devices) {
     std::string path(md.getPathByDevName(device.name));
@@ -764,6 +823,7 @@ QueryData genMDDevices(QueryContext& context) {
     results.push_back(r);
   }
 
+  storeMDCache(kMDDevicesCache, content, results);
   return results;
 }
 
@@ -771,9 +831,10 @@ QueryData genMDPersonalities(QueryContext& context) {
   QueryData results;
   MDStat mds;
   std::vector<std::string> lines;
+  std::string content;
   MD md;
 
-  getLines(lines);
+  getLines(lines, content);
 
   md.parseMDStat(lines, mds);
 
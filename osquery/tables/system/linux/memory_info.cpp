@@ -10,13 +10,11 @@
 
 #include <string>
 
-#include <boost/algorithm/string.hpp>
-
 #include <osquery/core.h>
 #include <osquery/tables.h>
 #include <osquery/filesystem.h>
 
-#include "osquery/core/conversions.h"
+#include <osquery/filesystem/linux/proc.h>
 
 namespace osquery {
 namespace tables {
@@ -41,24 +39,25 @@ QueryData getMemoryInfo(QueryContext& context) {
 
   std::string meminfo_content;
   if (forensicReadFile(kMemInfoPath, meminfo_content).ok()) {
-    // Able to read meminfo file, now grab info we want
-    for (const auto& line : split(meminfo_content, "\n")) {
-      std::vector<std::string> tokens;
-      boost::split(
-          tokens, line, boost::is_any_of("\t "), boost::token_compress_on);
+    // Tokenize each line as views over the single read buffer; only the
+    // matched values are converted, without per-field string copies.
+    ProcView buffer(meminfo_content);
+    while (!buffer.empty()) {
+      auto line = procNextLine(buffer);
+      auto key = procNextToken(line);
       // Look for mapping
       for (const auto& singleMap : kMemInfoMap) {
-        if (line.find(singleMap.second) == 0) {
-          long value = 0;
-          if (safeStrtol(tokens[1], 10, value)) {
-            r[singleMap.first] = BIGINT(value * 1024l);
+        if (key == ProcView(singleMap.second)) {
+          long long value = 0;
+          if (procParseNumber(procNextToken(line), value)) {
+            r[singleMap.first] = BIGINT(value * 1024ll);
           }
           break;
         }
       }
     }
   }
-  results.push_back(r);
+  results.push_back(std::move(r));
   return results;
 }
 }
@@ -40,12 +40,9 @@ void genDescriptors(const std::string& process,
 QueryData genOpenFiles(QueryContext& context) {
   QueryData results;
 
+  // Honor pid constraints so joins only touch the named procfs entries.
   std::set<std::string> pids;
-  if (context.constraints["pid"].exists(EQUALS)) {
-    pids = context.constraints["pid"].getAll(EQUALS);
-  } else {
-    osquery::procProcesses(pids);
-  }
+  osquery::procProcesses(context, pids);
 
   for (const auto& process : pids) {
     std::map<std::string, std::string> descriptors;
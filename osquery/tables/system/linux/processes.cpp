@@ -23,6 +23,7 @@
 #include <osquery/core.h>
 #include <osquery/filesystem.h>
 #include <osquery/filesystem/linux/proc.h>
+#include <osquery/flags.h>
 #include <osquery/logger.h>
 #include <osquery/tables.h>
 
@@ -30,6 +31,20 @@
 #include "osquery/core/utils.h"
 
 namespace osquery {
+
+/**
+ * @brief Opt-in incremental scanning for the processes table.
+ *
+ * When enabled, the exec-scoped fields of each process (exe link, on-disk
+ * check, cmdline) are cached keyed by pid and validated against the process
+ * start time and name, so repeated scans only re-read those procfs files
+ * for new or changed pids. The dynamic stat/status fields are always fresh.
+ */
+FLAG(bool,
+     processes_incremental,
+     false,
+     "Cache exec-scoped process fields between scans of the processes table");
+
 namespace tables {
 
 inline std::string getProcAttr(const std::string& attr,
@@ -119,17 +134,7 @@ Status deletedMatchesInode(const std::string& path, const std::string& pid) {
 
 std::set<std::string> getProcList(const QueryContext& context) {
   std::set<std::string> pidlist;
-  if (context.constraints.count("pid") > 0 &&
-      context.constraints.at("pid").exists(EQUALS)) {
-    for (const auto& pid : context.constraints.at("pid").getAll(EQUALS)) {
-      if (isDirectory("/proc/" + pid)) {
-        pidlist.insert(pid);
-      }
-    }
-  } else {
-    osquery::procProcesses(pidlist);
-  }
-
+  osquery::procProcesses(context, pidlist);
   return pidlist;
 }
 
@@ -242,23 +247,50 @@ SimpleProcStat::SimpleProcStat(const std::string& pid) {
       return;
     }
 
-    auto details = osquery::split(content.substr(start + 2), " ");
-    if (details.size() <= 19) {
-      status = Status(1, "Invalid /proc/stat content");
-      return;
+    // Tokenize the remainder as views over the read buffer; only the
+    // reported fields are materialized as strings.
+    ProcView details(content);
+    details.remove_prefix(start + 2);
+
+    size_t index = 0;
+    for (auto token = procNextToken(details); !token.empty();
+         token = procNextToken(details), index++) {
+      switch (index) {
+      case 0:
+        this->state = token.to_string();
+        break;
+      case 1:
+        this->parent = token.to_string();
+        break;
+      case 2:
+        this->group = token.to_string();
+        break;
+      case 11:
+        this->user_time = token.to_string();
+        break;
+      case 12:
+        this->system_time = token.to_string();
+        break;
+      case 16:
+        this->nice = token.to_string();
+        break;
+      case 17:
+        this->threads = token.to_string();
+        break;
+      case 19: {
+        long long start_time = 0;
+        this->start_time =
+            (procParseNumber(token, start_time)) ? TEXT(start_time / 100) : "-1";
+        break;
+      }
+      default:
+        break;
+      }
     }
 
-    this->state = details.at(0);
-    this->parent = details.at(1);
-    this->group = details.at(2);
-    this->user_time = details.at(11);
-    this->system_time = details.at(12);
-    this->nice = details.at(16);
-    this->threads = details.at(17);
-    try {
-      this->start_time = TEXT(AS_LITERAL(BIGINT_LITERAL, details.at(19)) / 100);
-    } catch (const boost::bad_lexical_cast& e) {
-      this->start_time = "-1";
+    if (index <= 19) {
+      status = Status(1, "Invalid /proc/stat content");
+      return;
     }
   }
 
@@ -268,38 +300,56 @@ SimpleProcStat::SimpleProcStat(const std::string& pid) {
     return;
   }
 
-  for (const auto& line : osquery::split(content, "\n")) {
+  ProcView buffer(content);
+  while (!buffer.empty()) {
     // Status lines are formatted: Key: Value....\n.
-    auto detail = osquery::split(line, ':', 1);
-    if (detail.size() != 2) {
+    auto line = procNextLine(buffer);
+    auto separator = line.find(':');
+    if (separator == ProcView::npos) {
       continue;
     }
 
+    auto key = line.substr(0, separator);
+    auto value = line.substr(separator + 1);
+    auto content_start = value.find_first_not_of("\t ");
+    if (content_start == ProcView::npos) {
+      continue;
+    }
+    value.remove_prefix(content_start);
+
     // There are specific fields from each detail.
-    if (detail.at(0) == "Name") {
-      this->name = detail.at(1);
-    } else if (detail.at(0) == "VmRSS") {
-      detail[1].erase(detail.at(1).end() - 3, detail.at(1).end());
-      // Memory is reported in kB.
-      this->resident_size = detail.at(1) + "000";
-    } else if (detail.at(0) == "VmSize") {
-      detail[1].erase(detail.at(1).end() - 3, detail.at(1).end());
-      // Memory is reported in kB.
-      this->total_size = detail.at(1) + "000";
-    } else if (detail.at(0) == "Gid") {
-      // Format is: R E - -
-      auto gid_detail = osquery::split(detail.at(1), "\t");
-      if (gid_detail.size() == 4) {
-        this->real_gid = gid_detail.at(0);
-        this->effective_gid = gid_detail.at(1);
-        this->saved_gid = gid_detail.at(2);
+    if (key == "Name") {
+      this->name = value.to_string();
+    } else if (key == "VmRSS") {
+      // Memory is reported in kB, as "<size> kB".
+      if (value.size() > 3) {
+        value.remove_suffix(3);
+        this->resident_size = value.to_string() + "000";
+      }
+    } else if (key == "VmSize") {
+      // Memory is reported in kB, as "<size> kB".
+      if (value.size() > 3) {
+        value.remove_suffix(3);
+        this->total_size = value.to_string() + "000";
       }
-    } else if (detail.at(0) == "Uid") {
-      auto uid_detail = osquery::split(detail.at(1), "\t");
-      if (uid_detail.size() == 4) {
-        this->real_uid = uid_detail.at(0);
-        this->effective_uid = uid_detail.at(1);
-        this->saved_uid = uid_detail.at(2);
+    } else if (key == "Gid") {
+      // Format is: R E S F
+      auto real = procNextToken(value);
+      auto effective = procNextToken(value);
+      auto saved = procNextToken(value);
+      if (!procNextToken(value).empty()) {
+        this->real_gid = real.to_string();
+        this->effective_gid = effective.to_string();
+        this->saved_gid = saved.to_string();
+      }
+    } else if (key == "Uid") {
+      auto real = procNextToken(value);
+      auto effective = procNextToken(value);
+      auto saved = procNextToken(value);
+      if (!procNextToken(value).empty()) {
+        this->real_uid = real.to_string();
+        this->effective_uid = effective.to_string();
+        this->saved_uid = saved.to_string();
       }
     }
   }
@@ -328,20 +378,26 @@ SimpleProcIo::SimpleProcIo(const std::string& pid) {
     return;
   }
 
-  for (const auto& line : osquery::split(content, "\n")) {
+  ProcView buffer(content);
+  while (!buffer.empty()) {
     // IO lines are formatted: Key: Value....\n.
-    auto detail = osquery::split(line, ':', 1);
-    if (detail.size() != 2) {
+    auto line = procNextLine(buffer);
+    auto separator = line.find(':');
+    if (separator == ProcView::npos) {
       continue;
     }
 
+    auto key = line.substr(0, separator);
+    auto rest = line.substr(separator + 1);
+    auto value = procNextToken(rest);
+
     // There are specific fields from each detail
-    if (detail.at(0) == "read_bytes") {
-      this->read_bytes = detail.at(1);
-    } else if (detail.at(0) == "write_bytes") {
-      this->write_bytes = detail.at(1);
-    } else if (detail.at(0) == "cancelled_write_bytes") {
-      this->cancelled_write_bytes = detail.at(1);
+    if (key == "read_bytes") {
+      this->read_bytes = value.to_string();
+    } else if (key == "write_bytes") {
+      this->write_bytes = value.to_string();
+    } else if (key == "cancelled_write_bytes") {
+      this->cancelled_write_bytes = value.to_string();
     }
   }
 }
@@ -398,11 +454,33 @@ int getOnDisk(const std::string& pid, std::string& path) {
   }
 }
 
-void genProcess(const std::string& pid, QueryData& results) {
+/**
+ * @brief Cached exec-scoped fields for one process.
+ *
+ * The exe link, on-disk check, and cmdline are fixed once a process execs,
+ * so the incremental mode re-reads them only for new or changed pids. The
+ * start time catches pid reuse and the comm name catches an exec performed
+ * by the same pid.
+ */
+struct ProcessCacheEntry {
+  std::string start_time;
+  std::string name;
+  std::string path;
+  std::string on_disk;
+  std::string cmdline;
+};
+
+/// Exec-scoped process fields keyed by pid, see --processes_incremental.
+std::map<std::string, ProcessCacheEntry> kProcessCache;
+
+/// Protects the process cache from concurrent table scans.
+Mutex kProcessCacheMutex;
+
+void genProcess(const std::string& pid,
+                const QueryContext& context,
+                QueryData& results) {
   // Parse the process stat and status.
   SimpleProcStat proc_stat(pid);
-  // Parse the process io
-  SimpleProcIo proc_io(pid);
 
   if (!proc_stat.status.ok()) {
     VLOG(1) << proc_stat.status.getMessage() << " for pid " << pid;
@@ -412,16 +490,11 @@ void genProcess(const std::string& pid, QueryData& results) {
   Row r;
   r["pid"] = pid;
   r["parent"] = proc_stat.parent;
-  r["path"] = readProcLink("exe", pid);
   r["name"] = proc_stat.name;
   r["pgroup"] = proc_stat.group;
   r["state"] = proc_stat.state;
   r["nice"] = proc_stat.nice;
   r["threads"] = proc_stat.threads;
-  // Read/parse cmdline arguments.
-  r["cmdline"] = readProcCMDLine(pid);
-  r["cwd"] = readProcLink("cwd", pid);
-  r["root"] = readProcLink("root", pid);
   r["uid"] = proc_stat.real_uid;
   r["euid"] = proc_stat.effective_uid;
   r["suid"] = proc_stat.saved_uid;
@@ -429,7 +502,48 @@ void genProcess(const std::string& pid, QueryData& results) {
   r["egid"] = proc_stat.effective_gid;
   r["sgid"] = proc_stat.saved_gid;
 
-  r["on_disk"] = INTEGER(getOnDisk(pid, r["path"]));
+  // Each of the remaining columns costs additional /proc reads or syscalls,
+  // so only resolve those the query selected.
+  if (FLAGS_processes_incremental &&
+      context.isAnyColumnUsed({"path", "on_disk", "cmdline"})) {
+    WriteLock lock(kProcessCacheMutex);
+    auto& entry = kProcessCache[pid];
+    if (entry.start_time != proc_stat.start_time ||
+        entry.name != proc_stat.name) {
+      // A new pid, a reused pid, or an exec performed by the same pid.
+      entry.start_time = proc_stat.start_time;
+      entry.name = proc_stat.name;
+      entry.path = readProcLink("exe", pid);
+      entry.on_disk = INTEGER(getOnDisk(pid, entry.path));
+      entry.cmdline = readProcCMDLine(pid);
+    }
+
+    if (context.isAnyColumnUsed({"path", "on_disk"})) {
+      r["path"] = entry.path;
+      r["on_disk"] = entry.on_disk;
+    }
+    if (context.isColumnUsed("cmdline")) {
+      r["cmdline"] = entry.cmdline;
+    }
+  } else {
+    if (context.isAnyColumnUsed({"path", "on_disk"})) {
+      r["path"] = readProcLink("exe", pid);
+      r["on_disk"] = INTEGER(getOnDisk(pid, r["path"]));
+    }
+
+    if (context.isColumnUsed("cmdline")) {
+      // Read/parse cmdline arguments.
+      r["cmdline"] = readProcCMDLine(pid);
+    }
+  }
+
+  if (context.isColumnUsed("cwd")) {
+    r["cwd"] = readProcLink("cwd", pid);
+  }
+
+  if (context.isColumnUsed("root")) {
+    r["root"] = readProcLink("root", pid);
+  }
 
   // size/memory information
   r["wired_size"] = "0"; // No support for unpagable counters in linux.
@@ -441,20 +555,24 @@ void genProcess(const std::string& pid, QueryData& results) {
   r["system_time"] = proc_stat.system_time;
   r["start_time"] = proc_stat.start_time;
 
-  if (!proc_io.status.ok()) {
-    // /proc/<pid>/io can require root to access, so don't fail if we can't
-    VLOG(1) << proc_io.status.getMessage();
-  } else {
-    r["disk_bytes_read"] = proc_io.read_bytes;
-    long long write_bytes = 0;
-    long long cancelled_write_bytes = 0;
-
-    osquery::safeStrtoll(proc_io.write_bytes, 10, write_bytes);
-    osquery::safeStrtoll(
-        proc_io.cancelled_write_bytes, 10, cancelled_write_bytes);
-
-    r["disk_bytes_written"] =
-        std::to_string(write_bytes - cancelled_write_bytes);
+  if (context.isAnyColumnUsed({"disk_bytes_read", "disk_bytes_written"})) {
+    // Parse the process io
+    SimpleProcIo proc_io(pid);
+    if (!proc_io.status.ok()) {
+      // /proc/<pid>/io can require root to access, so don't fail if we can't
+      VLOG(1) << proc_io.status.getMessage();
+    } else {
+      r["disk_bytes_read"] = proc_io.read_bytes;
+      long long write_bytes = 0;
+      long long cancelled_write_bytes = 0;
+
+      osquery::safeStrtoll(proc_io.write_bytes, 10, write_bytes);
+      osquery::safeStrtoll(
+          proc_io.cancelled_write_bytes, 10, cancelled_write_bytes);
+
+      r["disk_bytes_written"] =
+          std::to_string(write_bytes - cancelled_write_bytes);
+    }
   }
 
   results.push_back(r);
@@ -483,7 +601,21 @@ QueryData genProcesses(QueryContext& context) {
 
   auto pidlist = getProcList(context);
   for (const auto& pid : pidlist) {
-    genProcess(pid, results);
+    genProcess(pid, context, results);
+  }
+
+  if (FLAGS_processes_incremental &&
+      !(context.constraints.count("pid") > 0 &&
+        context.constraints.at("pid").exists(EQUALS))) {
+    // A full scan observed every live pid: drop entries for the dead ones.
+    WriteLock lock(kProcessCacheMutex);
+    for (auto entry = kProcessCache.begin(); entry != kProcessCache.end();) {
+      if (pidlist.count(entry->first) == 0) {
+        entry = kProcessCache.erase(entry);
+      } else {
+        ++entry;
+      }
+    }
   }
 
   return results;
@@ -16,10 +16,13 @@
 #include <rpm/rpmpgp.h>
 #include <rpm/rpmts.h>
 
+#include <sys/stat.h>
+
 #include <boost/noncopyable.hpp>
 
 #include <osquery/filesystem.h>
 #include <osquery/logger.h>
+#include <osquery/mutex.h>
 #include <osquery/system.h>
 #include <osquery/tables.h>
 
@@ -31,6 +34,33 @@ namespace tables {
 // Maximum number of files per RPM.
 #define MAX_RPM_FILES (64 * 1024)
 
+namespace {
+/// Rows from the last full iteration, valid while the RPM database identity
+/// token is unchanged.
+QueryData rpmSnapshot;
+
+/// Identity token of the RPM database behind rpmSnapshot.
+std::string rpmSnapshotToken;
+
+/// Guards rpmSnapshot and rpmSnapshotToken.
+Mutex rpmSnapshotMutex;
+} // namespace
+
+/**
+ * @brief Identity token for the RPM package database.
+ *
+ * The Packages file is rewritten by every package operation, so its mtime
+ * and size key a snapshot of generated rows. An empty token (such as on
+ * hosts with a non-default database backend) disables caching.
+ */
+static std::string getRpmDbToken() {
+  struct stat st;
+  if (stat("/var/lib/rpm/Packages", &st) != 0) {
+    return "";
+  }
+  return std::to_string(st.st_mtime) + ':' + std::to_string(st.st_size);
+}
+
 /**
  * @brief Return a string representation of the RPM tag type.
  *
@@ -114,6 +144,20 @@ class RpmEnvironmentManager : public boost::noncopyable {
 QueryData genRpmPackages(QueryContext& context) {
   QueryData results;
 
+  // Only unconstrained iterations are cached; name-constrained queries walk
+  // a database subset and are already cheap.
+  std::string token;
+  if (!context.constraints["name"].exists(EQUALS)) {
+    token = getRpmDbToken();
+  }
+  if (!token.empty()) {
+    WriteLock lock(rpmSnapshotMutex);
+    if (token == rpmSnapshotToken) {
+      // The database has not changed since the last full iteration.
+      return rpmSnapshot;
+    }
+  }
+
   auto dropper = DropPrivileges::get();
   if (!dropper->dropTo("nobody") && isUserAdmin()) {
     LOG(WARNING) << "Cannot drop privileges for rpm_packages";
@@ -160,6 +204,11 @@ QueryData genRpmPackages(QueryContext& context) {
   rpmFreeCrypto();
   rpmFreeRpmrc();
 
+  if (!token.empty()) {
+    WriteLock lock(rpmSnapshotMutex);
+    rpmSnapshot = results;
+    rpmSnapshotToken = token;
+  }
   return results;
 }
 
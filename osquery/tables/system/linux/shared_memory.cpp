@@ -9,13 +9,14 @@
  */
 
 #include <sys/shm.h>
-#include <pwd.h>
 
 #include <osquery/core.h>
 #include <osquery/filesystem.h>
 #include <osquery/logger.h>
 #include <osquery/tables.h>
 
+#include "osquery/tables/system/posix/user_group_cache.h"
+
 namespace osquery {
 namespace tables {
 
@@ -53,14 +54,15 @@ QueryData genSharedMemory(QueryContext &context) {
     Row r;
     r["shmid"] = INTEGER(shmid);
 
-    struct passwd *pw = getpwuid(shmseg.shm_perm.uid);
-    if (pw != nullptr) {
-      r["owner_uid"] = BIGINT(pw->pw_uid);
+    // Validate the ids through the process-wide resolution cache instead
+    // of a getpwuid round trip per segment.
+    std::string username;
+    if (getCachedUsername(shmseg.shm_perm.uid, username)) {
+      r["owner_uid"] = BIGINT(shmseg.shm_perm.uid);
     }
 
-    pw = getpwuid(shmseg.shm_perm.cuid);
-    if (pw != nullptr) {
-      r["creator_uid"] = BIGINT(pw->pw_uid);
+    if (getCachedUsername(shmseg.shm_perm.cuid, username)) {
+      r["creator_uid"] = BIGINT(shmseg.shm_perm.cuid);
     }
 
     // Accessor, creator pids.
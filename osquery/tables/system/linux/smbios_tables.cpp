@@ -14,6 +14,7 @@
 #include <osquery/core.h>
 #include <osquery/filesystem.h>
 #include <osquery/logger.h>
+#include <osquery/mutex.h>
 #include <osquery/tables.h>
 
 #include "osquery/core/conversions.h"
@@ -28,6 +29,15 @@ namespace tables {
 const std::string kLinuxEFISystabPath = "/sys/firmware/efi/systab";
 const std::string kLinuxDMISysfsPath = "/sys/firmware/dmi/tables/DMI";
 
+namespace {
+/// Firmware tables are immutable for the lifetime of a boot, so the blob is
+/// read once and shared between the tables built on the parser.
+std::shared_ptr<std::vector<uint8_t>> smbiosSnapshot;
+
+/// Guards smbiosSnapshot.
+Mutex smbiosSnapshotMutex;
+} // namespace
+
 void LinuxSMBIOSParser::readFromAddress(size_t address, size_t length) {
   auto status = osquery::readRawMem(address, length, (void**)&data_);
   if (!status.ok() || data_ == nullptr) {
@@ -98,6 +108,16 @@ bool LinuxSMBIOSParser::discoverTables(size_t address, size_t length) {
 }
 
 bool LinuxSMBIOSParser::discover() {
+  {
+    WriteLock lock(smbiosSnapshotMutex);
+    if (smbiosSnapshot != nullptr) {
+      shared_table_ = smbiosSnapshot;
+      table_data_ = shared_table_->data();
+      table_size_ = shared_table_->size();
+      return valid();
+    }
+  }
+
   if (osquery::isReadable(kLinuxDMISysfsPath)) {
     VLOG(1) << "Reading SMBIOS from sysfs DMI node";
     readFromSysfs(kLinuxDMISysfsPath);
@@ -107,6 +127,14 @@ bool LinuxSMBIOSParser::discover() {
   } else {
     readFromAddress(kLinuxSMBIOSRawAddress_, kLinuxSMBIOSRawLength_);
   }
+
+  if (valid()) {
+    WriteLock lock(smbiosSnapshotMutex);
+    if (smbiosSnapshot == nullptr) {
+      smbiosSnapshot = std::make_shared<std::vector<uint8_t>>(
+          table_data_, table_data_ + table_size_);
+    }
+  }
   return valid();
 }
 
@@ -137,7 +165,8 @@ QueryData genMemoryDevices(QueryContext& context) {
     return results;
   }
 
-  parser.tables([&results](size_t index,
+  parser.tables(kSMBIOSTypeMemoryDevice,
+                [&results](size_t index,
                            const SMBStructHeader* hdr,
                            uint8_t* address,
                            uint8_t* textAddrs,
@@ -156,7 +185,8 @@ QueryData genMemoryArrays(QueryContext& context) {
     return results;
   }
 
-  parser.tables([&results](size_t index,
+  parser.tables(kSMBIOSTypeMemoryArray,
+                [&results](size_t index,
                            const SMBStructHeader* hdr,
                            uint8_t* address,
                            uint8_t* textAddrs,
@@ -175,7 +205,8 @@ QueryData genMemoryArrayMappedAddresses(QueryContext& context) {
     return results;
   }
 
-  parser.tables([&results](size_t index,
+  parser.tables(kSMBIOSTypeMemoryArrayMappedAddress,
+                [&results](size_t index,
                            const SMBStructHeader* hdr,
                            uint8_t* address,
                            uint8_t* textAddrs,
@@ -194,7 +225,8 @@ QueryData genMemoryErrorInfo(QueryContext& context) {
     return results;
   }
 
-  parser.tables([&results](size_t index,
+  parser.tables(kSMBIOSTypeMemoryErrorInformation,
+                [&results](size_t index,
                            const SMBStructHeader* hdr,
                            uint8_t* address,
                            uint8_t* textAddrs,
@@ -213,7 +245,8 @@ QueryData genMemoryDeviceMappedAddresses(QueryContext& context) {
     return results;
   }
 
-  parser.tables([&results](size_t index,
+  parser.tables(kSMBIOSTypeMemoryDeviceMappedAddress,
+                [&results](size_t index,
                            const SMBStructHeader* hdr,
                            uint8_t* address,
                            uint8_t* textAddrs,
@@ -232,12 +265,13 @@ QueryData genPlatformInfo(QueryContext& context) {
   }
 
   QueryData results;
-  parser.tables(([&results](size_t index,
+  parser.tables(kSMBIOSTypeBIOS,
+                ([&results](size_t index,
                             const SMBStructHeader* hdr,
                             uint8_t* address,
                             uint8_t* textAddrs,
                             size_t size) {
-    if (hdr->type != kSMBIOSTypeBIOS || size < 0x12) {
+    if (size < 0x12) {
       return;
     }
 
@@ -11,6 +11,9 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "osquery/tables/system/smbios_utils.h"
 
 namespace osquery {
@@ -51,10 +54,10 @@ class LinuxSMBIOSParser : public SMBIOSParser {
       free(data_);
       data_ = nullptr;
     }
-    if (table_data_ != nullptr) {
+    if (table_data_ != nullptr && shared_table_ == nullptr) {
       free(table_data_);
-      table_data_ = nullptr;
     }
+    table_data_ = nullptr;
   }
 
  private:
@@ -62,6 +65,10 @@ class LinuxSMBIOSParser : public SMBIOSParser {
 
   /// Hold the raw SMBIOS memory read.
   uint8_t* data_{nullptr};
+
+  /// When discovery is served from the per-boot snapshot, table_data_ points
+  /// into this shared immutable buffer instead of an owned allocation.
+  std::shared_ptr<std::vector<uint8_t>> shared_table_;
 };
 
 } // namespace tables
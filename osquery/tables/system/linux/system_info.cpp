@@ -98,12 +98,13 @@ QueryData genSystemInfo(QueryContext& context) {
     if (!parser.discover()) {
       r["hardware_model"] = "";
     } else {
-      parser.tables(([&r](size_t index,
+      parser.tables(kSMBIOSTypeSystem,
+                    ([&r](size_t index,
                           const SMBStructHeader* hdr,
                           uint8_t* address,
                           uint8_t* textAddrs,
                           size_t size) {
-        if (hdr->type != kSMBIOSTypeSystem || size < 0x12) {
+        if (size < 0x12) {
           return;
         }
 
@@ -251,12 +251,8 @@ static inline std::string dmiWordToHexStr(uint8_t* address, uint8_t offset) {
   return toHexStr(word);
 }
 
-void SMBIOSParser::tables(std::function<void(size_t index,
-                                             const SMBStructHeader* hdr,
-                                             uint8_t* address,
-                                             uint8_t* textAddrs,
-                                             size_t size)> predicate) {
-  if (table_data_ == nullptr) {
+void SMBIOSParser::buildStructureIndex() {
+  if (!structures_.empty() || table_data_ == nullptr) {
     return;
   }
 
@@ -265,7 +261,6 @@ void SMBIOSParser::tables(std::function<void(size_t index,
   auto table = table_data_;
 
   // Iterate through table structures within SMBIOS data range.
-  size_t index = 0;
   while (table + sizeof(SMBStructHeader) <= tables_end) {
     auto header = (const SMBStructHeader*)table;
     if (table + header->length > tables_end) {
@@ -288,12 +283,49 @@ void SMBIOSParser::tables(std::function<void(size_t index,
       }
     }
 
-    auto table_length = next_table - table;
-    predicate(index++, header, table, table + header->length, table_length);
+    structures_.push_back({header->type,
+                           static_cast<size_t>(table - table_data_),
+                           static_cast<size_t>(next_table - table)});
     table = next_table;
   }
 }
 
+void SMBIOSParser::tables(std::function<void(size_t index,
+                                             const SMBStructHeader* hdr,
+                                             uint8_t* address,
+                                             uint8_t* textAddrs,
+                                             size_t size)> predicate) {
+  buildStructureIndex();
+
+  size_t index = 0;
+  for (const auto& ref : structures_) {
+    auto table = table_data_ + ref.offset;
+    auto header = (const SMBStructHeader*)table;
+    predicate(index++, header, table, table + header->length, ref.length);
+  }
+}
+
+void SMBIOSParser::tables(uint8_t type,
+                          std::function<void(size_t index,
+                                             const SMBStructHeader* hdr,
+                                             uint8_t* address,
+                                             uint8_t* textAddrs,
+                                             size_t size)> predicate) {
+  buildStructureIndex();
+
+  size_t index = 0;
+  for (const auto& ref : structures_) {
+    if (ref.type != type) {
+      index++;
+      continue;
+    }
+
+    auto table = table_data_ + ref.offset;
+    auto header = (const SMBStructHeader*)table;
+    predicate(index++, header, table, table + header->length, ref.length);
+  }
+}
+
 void genSMBIOSTable(size_t index,
                     const SMBStructHeader* hdr,
                     uint8_t* address,
@@ -8,8 +8,6 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
-#include <pwd.h>
-#include <grp.h>
 #include <sys/stat.h>
 
 #include <boost/filesystem.hpp>
@@ -18,6 +16,8 @@
 #include <osquery/logger.h>
 #include <osquery/tables.h>
 
+#include "osquery/tables/system/posix/user_group_cache.h"
+
 namespace fs = boost::filesystem;
 
 namespace osquery {
@@ -38,21 +38,15 @@ Status genBin(const fs::path& path, int perms, QueryData& results) {
   // store path
   Row r;
   r["path"] = path.string();
-  struct passwd* pw = getpwuid(info.st_uid);
-  struct group* gr = getgrgid(info.st_gid);
 
-  // get user name + group
+  // get user name + group, through the process-wide resolution cache.
   std::string user;
-  if (pw != nullptr) {
-    user = std::string(pw->pw_name);
-  } else {
+  if (!getCachedUsername(info.st_uid, user)) {
     user = boost::lexical_cast<std::string>(info.st_uid);
   }
 
   std::string group;
-  if (gr != nullptr) {
-    group = std::string(gr->gr_name);
-  } else {
+  if (!getCachedGroupname(info.st_gid, group)) {
     group = boost::lexical_cast<std::string>(info.st_gid);
   }
 
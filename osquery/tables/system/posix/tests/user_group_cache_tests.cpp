@@ -0,0 +1,43 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <gtest/gtest.h>
+
+#include "osquery/tables/system/posix/user_group_cache.h"
+
+namespace osquery {
+namespace tables {
+
+class UserGroupCacheTests : public testing::Test {};
+
+TEST_F(UserGroupCacheTests, test_resolve_root) {
+  std::string name;
+  EXPECT_TRUE(getCachedUsername(0, name));
+  EXPECT_EQ("root", name);
+
+  // gid 0 is "root" on Linux and "wheel" on Darwin.
+  name.clear();
+  EXPECT_TRUE(getCachedGroupname(0, name));
+  EXPECT_FALSE(name.empty());
+}
+
+TEST_F(UserGroupCacheTests, test_negative_lookup) {
+  // An id this large should not exist; the miss is cached as a negative
+  // entry and repeated lookups stay local.
+  std::string name;
+  EXPECT_FALSE(getCachedUsername(0xCAFEBABE, name));
+  EXPECT_TRUE(name.empty());
+  EXPECT_FALSE(getCachedUsername(0xCAFEBABE, name));
+
+  EXPECT_FALSE(getCachedGroupname(0xCAFEBABE, name));
+  EXPECT_TRUE(name.empty());
+}
+}
+}
@@ -0,0 +1,266 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <atomic>
+#include <map>
+#include <vector>
+
+#include <grp.h>
+#include <pwd.h>
+#include <unistd.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <osquery/flags.h>
+#include <osquery/mutex.h>
+#include <osquery/system.h>
+
+#include "osquery/tables/system/posix/user_group_cache.h"
+
+namespace osquery {
+
+FLAG(bool,
+     user_group_cache,
+     true,
+     "Cache uid/gid to name resolutions process-wide instead of calling "
+     "getpwuid/getgrgid per row");
+
+FLAG(uint64,
+     user_group_cache_ttl,
+     300,
+     "Seconds cached uid/gid name resolutions remain fresh");
+
+namespace tables {
+
+namespace {
+
+/// One cached resolution; an unnamed entry records a lookup miss.
+struct CachedName {
+  std::string name;
+  bool found{false};
+};
+
+/// Resolve a single uid with the reentrant lookup.
+CachedName resolveUid(uid_t uid) {
+  CachedName entry;
+
+  auto buffer_size = sysconf(_SC_GETPW_R_SIZE_MAX);
+  if (buffer_size <= 0) {
+    buffer_size = 16384;
+  }
+  std::vector<char> buffer(static_cast<size_t>(buffer_size));
+
+  struct passwd pwd;
+  struct passwd* result = nullptr;
+  if (getpwuid_r(uid, &pwd, buffer.data(), buffer.size(), &result) == 0 &&
+      result != nullptr) {
+    entry.name = result->pw_name;
+    entry.found = true;
+  }
+  return entry;
+}
+
+/// Resolve a single gid with the reentrant lookup.
+CachedName resolveGid(gid_t gid) {
+  CachedName entry;
+
+  auto buffer_size = sysconf(_SC_GETGR_R_SIZE_MAX);
+  if (buffer_size <= 0) {
+    buffer_size = 16384;
+  }
+  std::vector<char> buffer(static_cast<size_t>(buffer_size));
+
+  struct group grp;
+  struct group* result = nullptr;
+  if (getgrgid_r(gid, &grp, buffer.data(), buffer.size(), &result) == 0 &&
+      result != nullptr) {
+    entry.name = result->gr_name;
+    entry.found = true;
+  }
+  return entry;
+}
+
+/// Enumerate the whole user database in one pass.
+std::map<uid_t, CachedName> enumerateUsers() {
+  std::map<uid_t, CachedName> users;
+  struct passwd* pwd = nullptr;
+  setpwent();
+  while ((pwd = getpwent()) != nullptr) {
+    auto& entry = users[pwd->pw_uid];
+    if (!entry.found) {
+      entry.name = pwd->pw_name;
+      entry.found = true;
+    }
+  }
+  endpwent();
+  return users;
+}
+
+/// Enumerate the whole group database in one pass.
+std::map<gid_t, CachedName> enumerateGroups() {
+  std::map<gid_t, CachedName> groups;
+  struct group* grp = nullptr;
+  setgrent();
+  while ((grp = getgrent()) != nullptr) {
+    auto& entry = groups[grp->gr_gid];
+    if (!entry.found) {
+      entry.name = grp->gr_name;
+      entry.found = true;
+    }
+  }
+  endgrent();
+  return groups;
+}
+
+/**
+ * @brief The process-wide uid/gid to name resolution cache.
+ *
+ * The first lookup after the TTL expires claims a refresh and prefetches
+ * the whole database with one enumeration pass; concurrent lookups keep
+ * serving the previous (stale) entries without blocking. Single misses,
+ * possible when enumeration is disabled (SSSD enumerate=false), resolve
+ * once and are remembered, negative answers included, until the next
+ * refresh, so a directory outage costs one round trip per id per TTL
+ * instead of one per row.
+ */
+class UserGroupCache : private boost::noncopyable {
+ public:
+  static UserGroupCache& instance() {
+    static UserGroupCache cache;
+    return cache;
+  }
+
+  bool username(uid_t uid, std::string& name);
+  bool groupname(gid_t gid, std::string& name);
+
+ private:
+  UserGroupCache() = default;
+
+ private:
+  /// Cached user entries, keyed by uid.
+  std::map<uid_t, CachedName> users_;
+
+  /// Cached group entries, keyed by gid.
+  std::map<gid_t, CachedName> groups_;
+
+  /// Unix time when each prefetched set goes stale.
+  size_t users_expire_{0};
+  size_t groups_expire_{0};
+
+  /// Set while one thread refreshes; others serve stale entries.
+  std::atomic<bool> users_refreshing_{false};
+  std::atomic<bool> groups_refreshing_{false};
+
+  /// Serialize access to the cached entries.
+  Mutex mutex_;
+};
+
+bool UserGroupCache::username(uid_t uid, std::string& name) {
+  auto now = getUnixTime();
+
+  bool refresh = false;
+  {
+    WriteLock lock(mutex_);
+    if (now >= users_expire_ && !users_refreshing_.exchange(true)) {
+      refresh = true;
+    } else {
+      auto it = users_.find(uid);
+      if (it != users_.end()) {
+        // Serve the entry even when stale: a slow directory never blocks
+        // row generation behind another thread's refresh.
+        name = it->second.name;
+        return it->second.found;
+      }
+    }
+  }
+
+  if (refresh) {
+    auto users = enumerateUsers();
+
+    WriteLock lock(mutex_);
+    users_ = std::move(users);
+    users_expire_ = now + FLAGS_user_group_cache_ttl;
+    users_refreshing_ = false;
+
+    auto it = users_.find(uid);
+    if (it != users_.end()) {
+      name = it->second.name;
+      return it->second.found;
+    }
+  }
+
+  auto entry = resolveUid(uid);
+
+  WriteLock lock(mutex_);
+  users_[uid] = entry;
+  name = entry.name;
+  return entry.found;
+}
+
+bool UserGroupCache::groupname(gid_t gid, std::string& name) {
+  auto now = getUnixTime();
+
+  bool refresh = false;
+  {
+    WriteLock lock(mutex_);
+    if (now >= groups_expire_ && !groups_refreshing_.exchange(true)) {
+      refresh = true;
+    } else {
+      auto it = groups_.find(gid);
+      if (it != groups_.end()) {
+        name = it->second.name;
+        return it->second.found;
+      }
+    }
+  }
+
+  if (refresh) {
+    auto groups = enumerateGroups();
+
+    WriteLock lock(mutex_);
+    groups_ = std::move(groups);
+    groups_expire_ = now + FLAGS_user_group_cache_ttl;
+    groups_refreshing_ = false;
+
+    auto it = groups_.find(gid);
+    if (it != groups_.end()) {
+      name = it->second.name;
+      return it->second.found;
+    }
+  }
+
+  auto entry = resolveGid(gid);
+
+  WriteLock lock(mutex_);
+  groups_[gid] = entry;
+  name = entry.name;
+  return entry.found;
+}
+} // namespace
+
+bool getCachedUsername(uid_t uid, std::string& name) {
+  if (!FLAGS_user_group_cache) {
+    auto entry = resolveUid(uid);
+    name = entry.name;
+    return entry.found;
+  }
+  return UserGroupCache::instance().username(uid, name);
+}
+
+bool getCachedGroupname(gid_t gid, std::string& name) {
+  if (!FLAGS_user_group_cache) {
+    auto entry = resolveGid(gid);
+    name = entry.name;
+    return entry.found;
+  }
+  return UserGroupCache::instance().groupname(gid, name);
+}
+} // namespace tables
+} // namespace osquery
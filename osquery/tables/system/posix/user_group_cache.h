@@ -0,0 +1,46 @@
+/**
+ *  Copyright (c) 2014-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under both the Apache 2.0 license (found in the
+ *  LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ *  in the COPYING file in the root directory of this source tree).
+ *  You may select, at your option, one of the above-listed licenses.
+ */
+
+#pragma once
+
+#include <string>
+
+#include <sys/types.h>
+
+namespace osquery {
+namespace tables {
+
+/**
+ * @brief Resolve a uid to a username through the process-wide cache.
+ *
+ * The cache bulk-prefetches the user database with one enumeration pass
+ * and keeps entries, negative entries included, for user_group_cache_ttl
+ * seconds. Stale entries are served without blocking while a single
+ * thread refreshes, so a slow or unreachable directory (LDAP/SSSD) never
+ * stalls row generation behind name lookups.
+ *
+ * @param uid The user id to resolve.
+ * @param name The output parameter, set to the username when found.
+ * @return true when the uid resolved to a username.
+ */
+bool getCachedUsername(uid_t uid, std::string& name);
+
+/**
+ * @brief Resolve a gid to a groupname through the process-wide cache.
+ *
+ * See getCachedUsername; this is the group database equivalent.
+ *
+ * @param gid The group id to resolve.
+ * @param name The output parameter, set to the groupname when found.
+ * @return true when the gid resolved to a groupname.
+ */
+bool getCachedGroupname(gid_t gid, std::string& name);
+} // namespace tables
+} // namespace osquery
@@ -73,15 +73,50 @@ class SMBIOSParser : private boost::noncopyable {
                                          uint8_t* textAddrs,
                                          size_t size)> predicate);
 
+  /**
+   * @brief Walk only the structures of a requested type.
+   *
+   * The first walk records a type/offset index over the immutable table
+   * buffer, so single-type tables seek directly to their structures instead
+   * of re-scanning every structure and its trailing strings. The index
+   * passed to the predicate still counts all structures, preserving table
+   * order numbering.
+   */
+  void tables(uint8_t type,
+              std::function<void(size_t index,
+                                 const SMBStructHeader* hdr,
+                                 uint8_t* address,
+                                 uint8_t* textAddrs,
+                                 size_t size)> predicate);
+
  public:
   virtual ~SMBIOSParser() {}
 
+ protected:
+  /// An indexed structure within the table buffer.
+  struct SMBIOSStructureRef {
+    /// The structure type, see kSMBIOSTypeDescriptions.
+    uint8_t type;
+
+    /// Offset of the structure header from the table buffer start.
+    size_t offset;
+
+    /// Total structure length, including trailing unformatted strings.
+    size_t length;
+  };
+
+  /// Scan the table buffer once and record the structure boundaries.
+  void buildStructureIndex();
+
  protected:
   /// This protected data member is used during table parsing and must be set.
   uint8_t* table_data_{nullptr};
 
   /// Table size discovered from SMBIOS.
   size_t table_size_{0};
+
+  /// Lazily-built structure index over table_data_, in table order.
+  std::vector<SMBIOSStructureRef> structures_;
 };
 
 /// Helper, cross platform, table row generator.
@@ -10,6 +10,7 @@
 
 #include <codecvt>
 #include <map>
+#include <set>
 #include <string>
 
 // clang-format off
@@ -25,16 +26,40 @@
 #include <iomanip>
 // clang-format on
 
+#include <boost/filesystem.hpp>
+
+#include <osquery/database.h>
 #include <osquery/filesystem.h>
+#include <osquery/flags.h>
 #include <osquery/logger.h>
+#include <osquery/query.h>
 #include <osquery/sql.h>
 #include <osquery/tables.h>
 
 #include "osquery/core.h"
 #include "osquery/core/conversions.h"
+#include "osquery/core/hashing.h"
 #include "osquery/core/windows/wmi.h"
 
 namespace osquery {
+
+FLAG(bool,
+     disable_authenticode_cache,
+     false,
+     "Disable the persistent Authenticode verification cache");
+
+/// Prefix for Authenticode verification results in the backing store.
+const std::string kAuthenticodeCachePrefix = "authenticode.";
+
+/// Reset the persistent cache when it accumulates this many entries.
+const size_t kAuthenticodeCacheMaxEntries = 16384;
+
+/// Cached-row column binding the result to the file identity that produced it.
+const std::string kAuthenticodeCacheValidityColumn = "cache_validity";
+
+/// Cached-row column carrying a negative verification result.
+const std::string kAuthenticodeCacheErrorColumn = "cache_error";
+
 template <typename T, typename DeleterType, DeleterType deleter>
 struct CustomUniquePtr final {
   using pointer = T;
@@ -446,6 +471,85 @@ Status querySignatureInformation(SignatureInformation& signature_info,
   return Status(0, "Ok");
 }
 
+/**
+ * @brief Compute the identity token used to validate cached verifications.
+ *
+ * The token combines the file size, the modification time and a digest of the
+ * leading 8KB, so an in-place rewrite that preserves size and mtime still
+ * invalidates the cached result. An empty token disables caching for the path.
+ */
+std::string getAuthenticodeValidityToken(const std::string& path) {
+  boost::system::error_code ec;
+  auto size = boost::filesystem::file_size(path, ec);
+  if (ec) {
+    return "";
+  }
+
+  auto mtime = boost::filesystem::last_write_time(path, ec);
+  if (ec) {
+    return "";
+  }
+
+  std::string header;
+  if (!readFile(path, header, 8192).ok()) {
+    return "";
+  }
+
+  return std::to_string(size) + ':' + std::to_string(mtime) + ':' +
+         hashFromBuffer(HASH_TYPE_SHA256, header.data(), header.size());
+}
+
+/**
+ * @brief Restore a verification result from its cached serialization.
+ *
+ * Negative results are cached too, so a hit may restore the original failure
+ * instead of populating the row. Returns code 0 for a positive hit, code 1
+ * for a cached failure and code 2 when the entry is stale or unreadable and
+ * the file must be reverified.
+ */
+Status getCachedAuthenticodeRow(const std::string& value,
+                                const std::string& validity,
+                                Row& r) {
+  auto status = deserializeRowJSON(value, r);
+  if (!status.ok()) {
+    r.clear();
+    return Status(2, status.getMessage());
+  }
+
+  if (r[kAuthenticodeCacheValidityColumn] != validity) {
+    r.clear();
+    return Status(2, "The cached verification is stale");
+  }
+  r.erase(kAuthenticodeCacheValidityColumn);
+
+  auto error = r.find(kAuthenticodeCacheErrorColumn);
+  if (error != r.end()) {
+    auto message = error->second;
+    r.clear();
+    return Status(1, message);
+  }
+
+  return Status(0, "Ok");
+}
+
+/// Persist a verification outcome, including failures, for future queries.
+void cacheAuthenticodeRow(const std::string& path,
+                          const std::string& validity,
+                          const Row& r,
+                          const Status& result) {
+  Row cached = result.ok() ? r : Row();
+  cached[kAuthenticodeCacheValidityColumn] = validity;
+  if (!result.ok()) {
+    cached[kAuthenticodeCacheErrorColumn] = result.getMessage();
+  }
+
+  std::string value;
+  if (serializeRowJSON(cached, value).ok()) {
+    setDatabaseValue(
+        kPersistentSettings, kAuthenticodeCachePrefix + path, value);
+  }
+}
+
 namespace tables {
 Status generateRow(Row& r, const std::string& path) {
   r = {};
@@ -486,6 +590,24 @@ QueryData genAuthenticode(QueryContext& context) {
         return status;
       }));
 
+  // Prefetch the cached verifications in one scan so per-path lookups never
+  // touch the backing store, even when every path misses.
+  std::map<std::string, std::string> cache;
+  if (!FLAGS_disable_authenticode_cache) {
+    DatabaseStringValueList values;
+    if (scanDatabaseValues(
+            kPersistentSettings, values, kAuthenticodeCachePrefix)
+            .ok()) {
+      if (values.size() >= kAuthenticodeCacheMaxEntries) {
+        for (const auto& item : values) {
+          deleteDatabaseValue(kPersistentSettings, item.first);
+        }
+      } else {
+        cache.insert(values.begin(), values.end());
+      }
+    }
+  }
+
   QueryData results;
   for (const auto& path_string : paths) {
     if (path_string.empty()) {
@@ -493,8 +615,25 @@ QueryData genAuthenticode(QueryContext& context) {
       continue;
     }
 
+    auto validity = FLAGS_disable_authenticode_cache
+                        ? ""
+                        : getAuthenticodeValidityToken(path_string);
+
     Row r;
-    auto status = generateRow(r, path_string);
+    Status status(2);
+    auto cached = cache.find(kAuthenticodeCachePrefix + path_string);
+    if (!validity.empty() && cached != cache.end()) {
+      status = getCachedAuthenticodeRow(cached->second, validity, r);
+    }
+
+    if (status.getCode() == 2) {
+      // A stale entry or cache miss, run the full verification chain.
+      status = generateRow(r, path_string);
+      if (!validity.empty()) {
+        cacheAuthenticodeRow(path_string, validity, r, status);
+      }
+    }
+
     if (status.ok()) {
       results.push_back(r);
     } else {
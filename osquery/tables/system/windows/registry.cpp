@@ -30,8 +30,11 @@
 
 #include <osquery/core.h>
 #include <osquery/filesystem.h>
+#include <osquery/flags.h>
 #include <osquery/logger.h>
+#include <osquery/mutex.h>
 #include <osquery/sql.h>
+#include <osquery/system.h>
 #include <osquery/tables.h>
 
 #include "osquery/core/conversions.h"
@@ -234,7 +237,9 @@ inline void explodeRegistryPath(const std::string& path,
 }
 
 /// Microsoft helper function for getting the contents of a registry key
-Status queryKey(const std::string& keyPath, QueryData& results) {
+static Status queryKeyUncached(const std::string& keyPath,
+                               QueryData& results,
+                               bool resolve_data) {
   std::string hive;
   std::string key;
   explodeRegistryPath(keyPath, hive, key);
@@ -310,19 +315,25 @@ Status queryKey(const std::string& keyPath, QueryData& results) {
 
   DWORD cchValue = maxKeyLength;
   auto achValue = std::make_unique<TCHAR[]>(maxValueName);
-  auto bpDataBuff = std::make_unique<BYTE[]>(cbMaxValueData);
+
+  // Only pay for the value data buffer and reads when requested.
+  std::unique_ptr<BYTE[]> bpDataBuff;
+  if (resolve_data) {
+    bpDataBuff = std::make_unique<BYTE[]>(cbMaxValueData);
+  }
 
   // Process registry values
   for (size_t i = 0; i < cValues; i++) {
     cchValue = maxValueName;
     achValue[0] = '\0';
+    DWORD lpType;
 
     retCode = RegEnumValue(hRegistryHandle.get(),
                            static_cast<DWORD>(i),
                            achValue.get(),
                            &cchValue,
                            nullptr,
-                           nullptr,
+                           &lpType,
                            nullptr,
                            nullptr);
     if (retCode != ERROR_SUCCESS) {
@@ -330,23 +341,24 @@ Status queryKey(const std::string& keyPath, QueryData& results) {
     }
 
     DWORD lpData = cbMaxValueData;
-    DWORD lpType;
 
-    retCode = RegQueryValueEx(hRegistryHandle.get(),
-                              achValue.get(),
-                              nullptr,
-                              &lpType,
-                              bpDataBuff.get(),
-                              &lpData);
-    if (retCode != ERROR_SUCCESS) {
-      return Status(GetLastError(), "Failed to query registry value");
-    }
+    if (resolve_data) {
+      retCode = RegQueryValueEx(hRegistryHandle.get(),
+                                achValue.get(),
+                                nullptr,
+                                &lpType,
+                                bpDataBuff.get(),
+                                &lpData);
+      if (retCode != ERROR_SUCCESS) {
+        return Status(GetLastError(), "Failed to query registry value");
+      }
 
-    // It's possible for registry entries to have been inserted incorrectly
-    // resulting in non-null-terminated strings
-    if (bpDataBuff != nullptr && lpData != 0 &&
-        kRegistryStringTypes.find(lpType) != kRegistryStringTypes.end()) {
-      bpDataBuff[lpData - 1] = 0x00;
+      // It's possible for registry entries to have been inserted incorrectly
+      // resulting in non-null-terminated strings
+      if (bpDataBuff != nullptr && lpData != 0 &&
+          kRegistryStringTypes.find(lpType) != kRegistryStringTypes.end()) {
+        bpDataBuff[lpData - 1] = 0x00;
+      }
     }
 
     Row r;
@@ -429,6 +441,131 @@ Status queryKey(const std::string& keyPath, QueryData& results) {
   return Status();
 }
 
+FLAG(uint32,
+     registry_cache_ttl,
+     15,
+     "Seconds a registry key snapshot may be served before re-reading "
+     "(0 disables the cache)");
+
+namespace {
+/// A cached registry key read, invalidated by change notification or TTL.
+struct RegistryKeySnapshot {
+  /// Rows produced by the uncached read.
+  QueryData rows;
+
+  /// The snapshot includes resolved value data.
+  bool resolved{false};
+
+  /// Unix time after which the snapshot is discarded regardless.
+  size_t expiry{0};
+
+  /// Open key handle keeping the change notification registered.
+  HKEY hkey{nullptr};
+
+  /// Signaled by the system when anything under the key changes.
+  HANDLE change_event{nullptr};
+
+  ~RegistryKeySnapshot() {
+    if (hkey != nullptr) {
+      RegCloseKey(hkey);
+    }
+    if (change_event != nullptr) {
+      CloseHandle(change_event);
+    }
+  }
+};
+
+/// Upper bound on cached snapshots before the cache is reset.
+const size_t kRegistryCacheMaxEntries = 4096;
+
+Mutex registryCacheMutex;
+std::map<std::string, std::shared_ptr<RegistryKeySnapshot>> registryCache;
+
+bool snapshotValid(const RegistryKeySnapshot& snapshot, bool resolve_data) {
+  if (resolve_data && !snapshot.resolved) {
+    return false;
+  }
+  if (snapshot.expiry <= getUnixTime()) {
+    return false;
+  }
+  // The change event was registered for the whole subtree.
+  if (snapshot.change_event != nullptr &&
+      WaitForSingleObject(snapshot.change_event, 0) != WAIT_TIMEOUT) {
+    return false;
+  }
+  return true;
+}
+} // namespace
+
+Status queryKey(const std::string& keyPath,
+                QueryData& results,
+                bool resolve_data) {
+  if (FLAGS_registry_cache_ttl == 0) {
+    return queryKeyUncached(keyPath, results, resolve_data);
+  }
+
+  {
+    WriteLock lock(registryCacheMutex);
+    auto it = registryCache.find(keyPath);
+    if (it != registryCache.end()) {
+      if (snapshotValid(*it->second, resolve_data)) {
+        results.insert(results.end(),
+                       it->second->rows.begin(),
+                       it->second->rows.end());
+        return Status();
+      }
+      registryCache.erase(it);
+    }
+  }
+
+  auto snapshot = std::make_shared<RegistryKeySnapshot>();
+  auto status = queryKeyUncached(keyPath, snapshot->rows, resolve_data);
+  if (!status.ok()) {
+    return status;
+  }
+  results.insert(
+      results.end(), snapshot->rows.begin(), snapshot->rows.end());
+
+  snapshot->resolved = resolve_data;
+  snapshot->expiry = getUnixTime() + FLAGS_registry_cache_ttl;
+
+  // Register a subtree change notification so repeated reads within the TTL
+  // never serve a modified key. A registration failure leaves only the TTL.
+  std::string hive;
+  std::string key;
+  explodeRegistryPath(keyPath, hive, key);
+  if (kRegistryHives.count(hive) == 1) {
+    HKEY hkey;
+    if (RegOpenKeyEx(kRegistryHives.at(hive),
+                     TEXT(key.c_str()),
+                     0,
+                     KEY_NOTIFY,
+                     &hkey) == ERROR_SUCCESS) {
+      snapshot->hkey = hkey;
+      snapshot->change_event = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+      if (snapshot->change_event != nullptr &&
+          RegNotifyChangeKeyValue(hkey,
+                                  TRUE,
+                                  REG_NOTIFY_CHANGE_NAME |
+                                      REG_NOTIFY_CHANGE_ATTRIBUTES |
+                                      REG_NOTIFY_CHANGE_LAST_SET |
+                                      REG_NOTIFY_CHANGE_SECURITY,
+                                  snapshot->change_event,
+                                  TRUE) != ERROR_SUCCESS) {
+        CloseHandle(snapshot->change_event);
+        snapshot->change_event = nullptr;
+      }
+    }
+  }
+
+  WriteLock lock(registryCacheMutex);
+  if (registryCache.size() >= kRegistryCacheMaxEntries) {
+    registryCache.clear();
+  }
+  registryCache[keyPath] = std::move(snapshot);
+  return Status();
+}
+
 static inline void populateDefaultKeys(std::set<std::string>& rKeys) {
   boost::copy(kRegistryHives | boost::adaptors::map_keys,
               std::inserter(rKeys, rKeys.end()));
@@ -443,7 +580,8 @@ static inline Status populateSubkeys(std::set<std::string>& rKeys,
 
   for (const auto& key : rKeys) {
     QueryData regResults;
-    auto ret = queryKey(key, regResults);
+    // Only the subkey names are needed here, not the value data.
+    auto ret = queryKey(key, regResults, false);
     if (!ret.ok()) {
       return ret;
     }
@@ -587,8 +725,10 @@ QueryData genRegistry(QueryContext& context) {
 
   maybeWarnLocalUsers(keys);
 
+  // Skip reading value data entirely when the query did not select it.
+  auto resolve_data = context.isColumnUsed("data");
   for (const auto& key : keys) {
-    queryKey(key, results);
+    queryKey(key, results, resolve_data);
   }
   return results;
 }
@@ -24,8 +24,12 @@ const std::string kDefaultRegName = "(Default)";
 // Maximum recursive depth with searching the registry
 const size_t kRegMaxRecursiveDepth = 32;
 
-// Microsoft helper function for getting the contents of a registry key
-Status queryKey(const std::string& keyPath, QueryData& results);
+// Microsoft helper function for getting the contents of a registry key.
+// When resolve_data is false the value data is not read, which is much
+// cheaper for callers that only need key/value names and types.
+Status queryKey(const std::string& keyPath,
+                QueryData& results,
+                bool resolve_data = true);
 
 /*
  * @brief Helper function to query multiple registry keys
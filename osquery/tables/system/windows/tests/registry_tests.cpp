@@ -34,6 +34,18 @@ TEST_F(RegistryTablesTest, test_registry_existing_key) {
   EXPECT_TRUE(results.size() > 0);
 }
 
+TEST_F(RegistryTablesTest, test_registry_snapshot_cache) {
+  QueryData first;
+  auto ret = queryKey(kTestKey, first);
+  EXPECT_TRUE(ret.ok());
+
+  // A repeated read within the TTL is served from the snapshot cache.
+  QueryData second;
+  ret = queryKey(kTestKey, second);
+  EXPECT_TRUE(ret.ok());
+  EXPECT_EQ(first.size(), second.size());
+}
+
 TEST_F(RegistryTablesTest, test_registry_non_existing_key) {
   QueryData results;
   auto ret = queryKey(kInvalidTestKey, results);
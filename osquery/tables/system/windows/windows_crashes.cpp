@@ -544,12 +544,19 @@ void debugEngineCleanup(IDebugClient5* client,
   return;
 }
 
-void processDebugEngine(const std::string& fileName, Row& r) {
+void processDebugEngine(const std::string& fileName,
+                        const QueryContext& context,
+                        Row& r) {
   const unsigned long kSymbolOptions =
       SYMOPT_CASE_INSENSITIVE & SYMOPT_UNDNAME & SYMOPT_LOAD_LINES &
       SYMOPT_OMAP_FIND_NEAREST & SYMOPT_LOAD_ANYTHING &
       SYMOPT_FAIL_CRITICAL_ERRORS & SYMOPT_AUTO_PUBLICS;
 
+  // Stack and symbol columns dominate the per-dump cost; only configure and
+  // pay for symbolization when the query projects one of these columns.
+  auto needs_symbols =
+      context.isAnyColumnUsed({"stack_trace", "module", "path", "version"});
+
   IDebugClient5* client = nullptr;
   IDebugControl5* control = nullptr;
   IDebugSymbols3* symbols = nullptr;
@@ -581,9 +588,10 @@ void processDebugEngine(const std::string& fileName, Row& r) {
         client, control, symbols, system, data, registers, advanced);
   }
 
-  // Initialize debug engine
-  if ((symbols->SetSymbolPath(kSymbolPath.c_str()) != S_OK) ||
-      (symbols->SetSymbolOptions(kSymbolOptions) != S_OK) ||
+  // Initialize debug engine, skipping symbol resolution entirely when no
+  // symbolized column was requested.
+  if ((needs_symbols && symbols->SetSymbolPath(kSymbolPath.c_str()) != S_OK) ||
+      (needs_symbols && symbols->SetSymbolOptions(kSymbolOptions) != S_OK) ||
       (client->OpenDumpFile(fileName.c_str()) != S_OK) ||
       (control->WaitForEvent(DEBUG_WAIT_DEFAULT, INFINITE) != S_OK)) {
     LOG(ERROR) << "Failed during initialization while debugging crash dump: "
@@ -592,19 +600,46 @@ void processDebugEngine(const std::string& fileName, Row& r) {
         client, control, symbols, system, data, registers, advanced);
   }
 
-  // Extract information from the minidump
+  // Extract information from the minidump. Cheap metadata columns come from
+  // the dump headers; each expensive column is materialized only when the
+  // query projection references it.
   r["crash_path"] = fileName;
-  logDumpType(control, r);
-  logDumpTime(control, r);
-  logProcessUptime(system, r);
-  logPIDAndTID(system, r);
-  logOSVersion(control, r);
-  logExceptionInfo(control, r);
-  logStackTrace(control, symbols, r);
-  logPEPathAndVersion(symbols, r);
-  logModulePath(symbols, r);
-  logRegisters(client, control, registers, advanced, r);
-  logPEBInfo(client, control, symbols, system, data, r);
+  if (context.isColumnUsed("type")) {
+    logDumpType(control, r);
+  }
+  if (context.isColumnUsed("datetime")) {
+    logDumpTime(control, r);
+  }
+  if (context.isColumnUsed("process_uptime")) {
+    logProcessUptime(system, r);
+  }
+  if (context.isAnyColumnUsed({"pid", "tid"})) {
+    logPIDAndTID(system, r);
+  }
+  if (context.isAnyColumnUsed(
+          {"major_version", "minor_version", "build_number"})) {
+    logOSVersion(control, r);
+  }
+  if (context.isAnyColumnUsed(
+          {"exception_code", "exception_message", "exception_address"})) {
+    logExceptionInfo(control, r);
+  }
+  if (context.isColumnUsed("stack_trace")) {
+    logStackTrace(control, symbols, r);
+  }
+  if (context.isAnyColumnUsed({"path", "version"})) {
+    logPEPathAndVersion(symbols, r);
+  }
+  if (context.isColumnUsed("module")) {
+    logModulePath(symbols, r);
+  }
+  if (context.isColumnUsed("registers")) {
+    logRegisters(client, control, registers, advanced, r);
+  }
+  if (context.isAnyColumnUsed(
+          {"command_line", "current_directory", "username", "machine_name"})) {
+    logPEBInfo(client, control, symbols, system, data, r);
+  }
 
   // Cleanup
   return debugEngineCleanup(
@@ -639,7 +674,7 @@ QueryData genCrashLogs(QueryContext& context) {
     for (const auto& lf : files) {
       if (alg::iends_with(lf, kDumpFileExtension) && fs::is_regular_file(lf)) {
         Row r;
-        processDebugEngine(lf, r);
+        processDebugEngine(lf, context, r);
         if (!r.empty()) {
           results.push_back(r);
         }
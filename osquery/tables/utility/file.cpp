@@ -10,6 +10,9 @@
 
 #include <sys/stat.h>
 
+#include <utility>
+#include <vector>
+
 #include <boost/filesystem.hpp>
 
 #include <osquery/filesystem.h>
@@ -33,14 +36,13 @@ const std::map<fs::file_type, std::string> kTypeNames{
     {fs::status_error, "error"},
 };
 
-void genFileInfo(const fs::path& path,
+bool genFileInfo(const fs::path& path,
                  const fs::path& parent,
                  const std::string& pattern,
-                 QueryData& results) {
+                 Row& r) {
   // Must provide the path, filename, directory separate from boost path->string
   // helpers to match any explicit (query-parsed) predicate constraints.
 
-  Row r;
   r["path"] = path.string();
   r["filename"] = path.filename().string();
   r["directory"] = parent.string();
@@ -52,7 +54,7 @@ void genFileInfo(const fs::path& path,
   struct stat link_stat;
   if (lstat(path.string().c_str(), &link_stat) < 0) {
     // Path was not real, had too may links, or could not be accessed.
-    return;
+    return false;
   }
   if (S_ISLNK(link_stat.st_mode)) {
     r["symlink"] = "1";
@@ -63,7 +65,7 @@ void genFileInfo(const fs::path& path,
 #if !defined(WIN32)
     file_stat = link_stat;
 #else
-    return;
+    return false;
 #endif
   }
 
@@ -99,12 +101,10 @@ void genFileInfo(const fs::path& path,
     r["type"] = "unknown";
   }
 
-  results.push_back(r);
+  return true;
 }
 
-QueryData genFile(QueryContext& context) {
-  QueryData results;
-
+void genFile(RowYield& yield, QueryContext& context) {
   // Resolve file paths for EQUALS and LIKE operations.
   auto paths = context.constraints["path"].getAll(EQUALS);
   context.expandConstraints(
@@ -123,10 +123,11 @@ QueryData genFile(QueryContext& context) {
         return status;
       }));
 
-  // Iterate through each of the resolved/supplied paths.
+  // Collect the (path, parent) work units, stat'd later in parallel.
+  std::vector<std::pair<fs::path, fs::path>> targets;
   for (const auto& path_string : paths) {
     fs::path path = path_string;
-    genFileInfo(path, path.parent_path(), "", results);
+    targets.push_back(std::make_pair(path, path.parent_path()));
   }
 
   // Resolve directories for EQUALS and LIKE operations.
@@ -154,17 +155,35 @@ QueryData genFile(QueryContext& context) {
     }
 
     try {
-      // Iterate over the directory and generate info for each regular file.
+      // Iterate over the directory and queue each entry.
       fs::directory_iterator begin(directory_string), end;
       for (; begin != end; ++begin) {
-        genFileInfo(begin->path(), directory_string, "", results);
+        targets.push_back(std::make_pair(begin->path(), directory_string));
       }
     } catch (const fs::filesystem_error& /* e */) {
       continue;
     }
   }
 
-  return results;
+  // Stat the targets on the bounded walker pool. Each unit owns one
+  // preallocated row slot; rows are yielded from this thread since the row
+  // generator is not reentrant, and emission order does not matter.
+  std::vector<Row> rows(targets.size());
+  std::vector<char> generated(targets.size(), 0);
+  parallelFileWalk(targets.size(), [&](size_t i) {
+    if (context.isCancelled()) {
+      // The scan deadline passed, skip the remaining stat targets.
+      return;
+    }
+    generated[i] =
+        genFileInfo(targets[i].first, targets[i].second, "", rows[i]) ? 1 : 0;
+  });
+
+  for (size_t i = 0; i < rows.size(); i++) {
+    if (generated[i] != 0) {
+      yield(rows[i]);
+    }
+  }
 }
 }
 }
@@ -21,6 +21,8 @@
 #include <osquery/system.h>
 #include <osquery/tables.h>
 
+#include "osquery/core/alloc_tracking.h"
+#include "osquery/core/metrics.h"
 #include "osquery/core/process.h"
 
 namespace osquery {
@@ -96,6 +98,8 @@ QueryData genOsqueryPacks(QueryContext& context) {
     auto stats = pack.getStats();
     r["discovery_cache_hits"] = INTEGER(stats.hits);
     r["discovery_executions"] = INTEGER(stats.misses);
+    r["discovery_wall_time"] = INTEGER(stats.discovery_wall_time_ms);
+    r["last_discovery_time"] = INTEGER(stats.last_discovery_time);
     results.push_back(r);
   });
 
@@ -175,6 +179,20 @@ QueryData genOsqueryRegistry(QueryContext& context) {
   return results;
 }
 
+QueryData genOsqueryStartupTrace(QueryContext& context) {
+  QueryData results;
+
+  for (const auto& phase : getStartupPhases()) {
+    Row r;
+    r["phase"] = phase.name;
+    r["start"] = BIGINT(phase.start);
+    r["duration"] = BIGINT(phase.duration);
+    results.push_back(r);
+  }
+
+  return results;
+}
+
 QueryData genOsqueryExtensions(QueryContext& context) {
   QueryData results;
 
@@ -188,6 +206,12 @@ QueryData genOsqueryExtensions(QueryContext& context) {
       r["sdk_version"] = extension.second.sdk_version;
       r["path"] = getExtensionSocket(extension.first);
       r["type"] = (extension.first == 0) ? "core" : "extension";
+
+      size_t calls = 0;
+      size_t latency = 0;
+      getExtensionStats(r["path"], calls, latency);
+      r["calls"] = BIGINT(calls);
+      r["avg_latency"] = BIGINT((calls > 0) ? latency / calls : 0);
       results.push_back(r);
     }
   }
@@ -227,6 +251,53 @@ QueryData genOsqueryInfo(QueryContext& context) {
   return results;
 }
 
+QueryData genOsqueryTableStats(QueryContext& context) {
+  QueryData results;
+
+  for (const auto& table : getTableGenerateStats()) {
+    Row r;
+    r["name"] = table.first;
+    r["calls"] = BIGINT(table.second.calls);
+    r["wall_time"] = BIGINT(table.second.wall_time);
+    r["cpu_time"] = BIGINT(table.second.cpu_time);
+    r["rows_produced"] = BIGINT(table.second.rows);
+    r["peak_bytes"] = BIGINT(table.second.peak_bytes);
+    results.push_back(r);
+  }
+
+  return results;
+}
+
+QueryData genOsqueryAllocStats(QueryContext& context) {
+  QueryData results;
+
+  // Empty unless the build enabled allocation tracking.
+  for (const auto& site : getAllocationStats()) {
+    Row r;
+    r["site"] = site.first;
+    r["allocations"] = BIGINT(site.second.allocations);
+    r["bytes"] = BIGINT(site.second.bytes);
+    r["size_p50"] = BIGINT(site.second.sizes.percentile(50));
+    r["size_p99"] = BIGINT(site.second.sizes.percentile(99));
+    results.push_back(r);
+  }
+
+  return results;
+}
+
+QueryData genOsqueryMetrics(QueryContext& context) {
+  QueryData results;
+
+  for (const auto& metric : getMetricsSnapshot()) {
+    Row r;
+    r["name"] = metric.first;
+    r["value"] = BIGINT(metric.second);
+    results.push_back(r);
+  }
+
+  return results;
+}
+
 QueryData genOsquerySchedule(QueryContext& context) {
   QueryData results;
 
@@ -245,6 +316,12 @@ QueryData genOsquerySchedule(QueryContext& context) {
         r["system_time"] = "0";
         r["average_memory"] = "0";
         r["last_executed"] = "0";
+        r["wall_time_p50"] = "0";
+        r["wall_time_p95"] = "0";
+        r["wall_time_p99"] = "0";
+        r["memory_p50"] = "0";
+        r["memory_p95"] = "0";
+        r["memory_p99"] = "0";
 
         // Report optional performance information.
         Config::get().getPerformanceStats(
@@ -256,6 +333,12 @@ QueryData genOsquerySchedule(QueryContext& context) {
               r["user_time"] = BIGINT(perf.user_time);
               r["system_time"] = BIGINT(perf.system_time);
               r["average_memory"] = BIGINT(perf.average_memory);
+              r["wall_time_p50"] = BIGINT(perf.wall_time_hist.percentile(50));
+              r["wall_time_p95"] = BIGINT(perf.wall_time_hist.percentile(95));
+              r["wall_time_p99"] = BIGINT(perf.wall_time_hist.percentile(99));
+              r["memory_p50"] = BIGINT(perf.memory_hist.percentile(50));
+              r["memory_p95"] = BIGINT(perf.memory_hist.percentile(95));
+              r["memory_p99"] = BIGINT(perf.memory_hist.percentile(99));
             });
 
         results.push_back(r);
@@ -8,9 +8,13 @@
  *  You may select, at your option, one of the above-listed licenses.
  */
 
+#include <atomic>
+#include <thread>
+
 #include <boost/filesystem.hpp>
 
 #include <osquery/filesystem.h>
+#include <osquery/flags.h>
 #include <osquery/logger.h>
 #include <osquery/status.h>
 #include <osquery/tables.h>
@@ -23,6 +27,12 @@
 #include <yara.h>
 
 namespace osquery {
+
+FLAG(uint64,
+     yara_max_parallel,
+     4,
+     "Maximum concurrent file scans performed by the yara table");
+
 namespace tables {
 
 void doYARAScan(YR_RULES* rules,
@@ -111,7 +121,7 @@ QueryData genYara(QueryContext& context) {
       path += file;
 
       YR_RULES* tmp_rules = nullptr;
-      auto status = compileSingleFile(path, &tmp_rules);
+      auto status = compileFileCached(path, &tmp_rules);
       if (!status.ok()) {
         VLOG(1) << "YARA compile error: " << status.toString();
         continue;
@@ -125,16 +135,61 @@ QueryData genYara(QueryContext& context) {
     groups.insert(file);
   }
 
-  // Scan every path pair.
+  // Collect every path/group pair with compiled rules to scan.
+  std::vector<std::pair<std::string, std::string>> scans;
   for (const auto& path : paths) {
-    // Scan using the signature groups.
     for (const auto& group : groups) {
       if (rules.count(group) > 0) {
-        doYARAScan(rules[group], path.c_str(), results, group, group);
+        scans.push_back(std::make_pair(path, group));
       }
     }
   }
 
+  if (scans.empty()) {
+    return results;
+  }
+
+  // Fan the scans out over a bounded set of workers so many targets cost
+  // one overlapped wave of scans instead of a serial pass. Compiled rules
+  // are safe to scan from concurrent threads, and each worker collects
+  // into its own row set to avoid sharing the results vector.
+  auto worker_count = static_cast<size_t>(FLAGS_yara_max_parallel);
+  if (worker_count < 1) {
+    worker_count = 1;
+  }
+  if (worker_count > scans.size()) {
+    worker_count = scans.size();
+  }
+
+  std::atomic<size_t> cursor{0};
+  std::vector<QueryData> partial_results(worker_count);
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < worker_count; i++) {
+    workers.emplace_back([&rules, &scans, &cursor, &partial_results, i]() {
+      while (true) {
+        auto index = cursor.fetch_add(1);
+        if (index >= scans.size()) {
+          break;
+        }
+        const auto& scan = scans[index];
+        doYARAScan(rules.at(scan.second),
+                   scan.first,
+                   partial_results[i],
+                   scan.second,
+                   scan.second);
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  for (auto& partial : partial_results) {
+    for (auto& r : partial) {
+      results.push_back(std::move(r));
+    }
+  }
+
   return results;
 }
 }
@@ -163,7 +163,8 @@ Status YARAEventSubscriber::Callback(const FileEventContextRef& ec,
     return Status(1, "Yara parser unknown.");
   }
 
-  auto rules = yaraParser->rules();
+  // Take a reference: copying the group map per file event is wasted work.
+  auto& rules = yaraParser->rules();
 
   // Use the category as a lookup into the yara file_paths. The value will be
   // a list of signature groups to scan with.
@@ -12,13 +12,24 @@
 #include <string>
 
 #include <osquery/config.h>
+#include <osquery/filesystem.h>
+#include <osquery/flags.h>
 #include <osquery/logger.h>
 #include <osquery/registry_factory.h>
 
+#include "osquery/core/hashing.h"
 #include "osquery/tables/yara/yara_utils.h"
 
 namespace osquery {
 
+DECLARE_string(database_path);
+
+FLAG(bool,
+     yara_rule_cache,
+     true,
+     "Save compiled YARA rules beside the database and reload them instead "
+     "of recompiling while the rule source files are unchanged");
+
 /**
  * The callback used when there are compilation problems in the rules.
  */
@@ -103,6 +114,44 @@ Status compileSingleFile(const std::string& file, YR_RULES** rules) {
   return Status(0, "OK");
 }
 
+/**
+ * Compile a single rule file, reusing a saved compiled copy when possible.
+ *
+ * The compiled rules are keyed by the hash of the source file and written
+ * with yr_rules_save beside the backing store database. While the source is
+ * unchanged later calls become a yr_rules_load instead of a recompile.
+ */
+Status compileFileCached(const std::string& file, YR_RULES** rules) {
+  if (!FLAGS_yara_rule_cache) {
+    return compileSingleFile(file, rules);
+  }
+
+  auto hash = hashFromFile(HASH_TYPE_SHA256, file);
+  if (hash.empty()) {
+    return compileSingleFile(file, rules);
+  }
+
+  auto cache_path = FLAGS_database_path + ".yara." + hash;
+  if (pathExists(cache_path).ok()) {
+    YR_RULES* tmp_rules = nullptr;
+    if (yr_rules_load(cache_path.c_str(), &tmp_rules) == ERROR_SUCCESS) {
+      *rules = tmp_rules;
+      return Status(0, "OK");
+    }
+    // A corrupt or version-mismatched cache falls through to a compile.
+  }
+
+  auto status = compileSingleFile(file, rules);
+  if (!status.ok()) {
+    return status;
+  }
+
+  if (yr_rules_save(*rules, cache_path.c_str()) != ERROR_SUCCESS) {
+    VLOG(1) << "Could not save compiled YARA rules to: " << cache_path;
+  }
+  return status;
+}
+
 /**
  * Given a vector of strings, attempt to compile them and store the result
  * in the map under the given category.
@@ -110,6 +159,49 @@ Status compileSingleFile(const std::string& file, YR_RULES** rules) {
 Status handleRuleFiles(const std::string& category,
                        const rapidjson::Value& rule_files,
                        std::map<std::string, YR_RULES*>& rules) {
+  // While every source file of the category hashes the same, the category
+  // compiles to the same rules, so a copy saved beside the database is
+  // loaded instead of recompiled.
+  std::string cache_path;
+  if (FLAGS_yara_rule_cache) {
+    std::string combined;
+    for (const auto& item : rule_files.GetArray()) {
+      if (!item.IsString()) {
+        continue;
+      }
+
+      std::string rule = item.GetString();
+      if (rule[0] != '/') {
+        rule = kYARAHome + rule;
+      }
+
+      auto hash = hashFromFile(HASH_TYPE_SHA256, rule);
+      if (hash.empty()) {
+        combined.clear();
+        break;
+      }
+      combined += hash;
+    }
+
+    if (!combined.empty()) {
+      cache_path = FLAGS_database_path + ".yara." +
+                   hashFromBuffer(
+                       HASH_TYPE_SHA256, combined.data(), combined.size());
+
+      YR_RULES* cached_rules = nullptr;
+      if (pathExists(cache_path).ok() &&
+          yr_rules_load(cache_path.c_str(), &cached_rules) == ERROR_SUCCESS) {
+        // If there are already rules there, destroy them and put new ones in.
+        if (rules.count(category) > 0) {
+          yr_rules_destroy(rules[category]);
+        }
+
+        rules[category] = cached_rules;
+        return Status(0, "OK");
+      }
+    }
+  }
+
   YR_COMPILER* compiler = nullptr;
   int result = yr_compiler_create(&compiler);
   if (result != ERROR_SUCCESS) {
@@ -189,6 +281,11 @@ Status handleRuleFiles(const std::string& category,
       yr_compiler_destroy(compiler);
       return Status(1, "Insufficient memory to get YARA rules");
     }
+
+    if (!cache_path.empty() &&
+        yr_rules_save(rules[category], cache_path.c_str()) != ERROR_SUCCESS) {
+      VLOG(1) << "Could not save compiled YARA rules to: " << cache_path;
+    }
   }
 
   if (compiler != nullptr) {
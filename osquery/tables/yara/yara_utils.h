@@ -30,6 +30,15 @@ void YARACompilerCallback(int error_level,
 
 Status compileSingleFile(const std::string& file, YR_RULES** rule);
 
+/**
+ * @brief Compile a rule file through the persistent compiled-rule cache.
+ *
+ * The source file is hashed and the compiled rules are saved with
+ * yr_rules_save beside the backing store database. While the source hash
+ * is unchanged later compiles become a yr_rules_load of the saved blob.
+ */
+Status compileFileCached(const std::string& file, YR_RULES** rule);
+
 Status handleRuleFiles(const std::string& category,
                        const pt::ptree& rule_files,
                        std::map<std::string, YR_RULES*>& rules);
@@ -58,6 +58,11 @@ FLAG(uint64,
      3600,
      "AWS STS assume role credential validity in seconds (default 3600)");
 
+FLAG(uint64,
+     aws_log_forwarder_parallel,
+     4,
+     "Maximum concurrent record batches sent by AWS logger plugins");
+
 /// Map of AWS region name to AWS::Region enum.
 static const std::set<std::string> kAwsRegions = {"us-east-1",
                                                   "us-west-1",
@@ -88,6 +88,7 @@ TABLE_ATTRIBUTES = {
     "cacheable": "CACHEABLE",
     "utility": "UTILITY",
     "kernel_required": "KERNEL_REQUIRED",
+    "expensive": "EXPENSIVE",
 }
 
 
@@ -242,6 +243,15 @@ class TableState(Singleton):
                 print(lightred(
                     "Table cannot use a generator and be marked cacheable: %s" % (path)))
                 exit(1)
+        if "cache_ttl" in self.attributes:
+            if "cacheable" not in self.attributes:
+                print(lightred(
+                    "Table must be marked cacheable to declare a cache_ttl: %s" % (path)))
+                exit(1)
+            if not isinstance(self.attributes["cache_ttl"], int):
+                print(lightred(
+                    "Table cache_ttl must be an integer of seconds: %s" % (path)))
+                exit(1)
         if self.table_name == "" or self.function == "":
             print(lightred("Invalid table spec: %s" % (path)))
             exit(1)